@@ -0,0 +1,1107 @@
+/**
+ * @file bench.c
+ * @brief Shelter Management System - Database Benchmarks
+ *
+ * Times the resident, food batch and user database functions on datasets of several sizes
+ * (1k, 100k and 1M rows by default). Every operation runs many times and is reported as
+ * p50/p95/p99 latency, throughput and the process peak RSS, to stdout as it goes and to a
+ * CSV file. The results can be compared with a stored baseline: any operation whose p50
+ * got slower than the threshold allows is reported and the exit code is 1.
+ *
+ * Rows come from the seeded data generator (datagen.h), so every run works on the same data.
+ *
+ * Last on each dataset, the count is run again on every core at once, each core reading
+ * through its own connection of a pool (db_pool_open()).
+ *
+ * The server run starts a database server (db_server.h) and times resident inserts and reads
+ * through its clients, first one, then --clients at once, each on its own connection: the
+ * results use the client count as their row count, and the writes per group commit are
+ * printed. Linux only.
+ *
+ * The kdf run times password hashing instead: it calibrates the PBKDF2 cost for this machine,
+ * then hashes at PASSWORD_KDF_DEFAULT_ITERATIONS on one thread and on every core at once and
+ * reports hashes/s per core, which tells how many logins the machine verifies concurrently.
+ *
+ * Built from the db layer only, like dbtool (no raylib). Run it through `make bench`,
+ * which builds with the release flags.
+ *
+ * @note Datasets are written to files in --dir and removed when done
+ */
+
+#define _POSIX_C_SOURCE 200809L // For clock_gettime and getrusage
+
+#include <external/sqlite3/sqlite3.h>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+#include "db/datagen.h"
+#include "db/db_client.h"
+#include "db/db_manager.h"
+#include "db/db_server.h"
+#include "db/foodbatch_db.h"
+#include "db/resident_db.h"
+#include "db/user_db.h"
+#include "utils/utils_hash.h"
+
+#define BENCH_DEFAULT_SIZES "1000,100000,1000000"     ///< Dataset sizes when --sizes is not given
+#define BENCH_DEFAULT_ITERATIONS 1000                 ///< Timed calls per operation
+#define BENCH_DEFAULT_THRESHOLD 10.0                  ///< Slowdown of p50 allowed over the baseline, in percent
+#define BENCH_MAX_SIZES 8                             ///< Dataset sizes per run
+#define BENCH_MAX_RESULTS 256                         ///< Results per run
+#define BENCH_BATCH_ROWS 1000                         ///< Rows per transaction when filling a dataset
+#define BENCH_FORMAT_BUDGET_NS 2000000000ULL          ///< Time spent calling each get_all_format variant
+#define BENCH_FORMAT_OLD_MAX_ROWS 20000               ///< Largest dataset the *_get_all_format_old variants run on
+#define BENCH_FORMAT_MAX_BYTES (1024UL * 1024 * 1024) ///< Largest get_all_format buffer, bigger ones are skipped
+#define BENCH_PATH_MAX 1024                           ///< Longest dataset path
+#define BENCH_SEED 20250101                           ///< Seed of the generated rows
+#define BENCH_KDF_CALLS 32                            ///< Hashes timed on one thread
+#define BENCH_KDF_PARALLEL_NS 2000000000ULL           ///< Time every core spends hashing
+#define BENCH_KDF_MAX_THREADS 256                     ///< Cores used at most
+#define BENCH_KDF_MAX_SAMPLES 4096                    ///< Hashes timed per core
+#define BENCH_POOL_BUDGET_NS 2000000000ULL            ///< Time every pooled reader spends counting
+#define BENCH_DEFAULT_CLIENTS 16                      ///< Server clients at once when --clients is not given
+
+/**
+ * @struct bench_table
+ * @brief Operations of one table, keyed by an integer so every table is driven the same way
+ *
+ * The operations return SQLITE_OK (or true for exists) on success.
+ */
+struct bench_table {
+    const char *name;                                       ///< Name on the command line and in the results
+    int (*create_table)(database *db);                      ///< Schema of the dataset
+    int (*insert)(database *db, int key);                   ///< Inserts the row of a key
+    int (*get)(database *db, int key);                      ///< Reads a row by its key
+    bool (*exists)(database *db, int key);                  ///< Checks that a key exists
+    int (*update)(database *db, int key);                   ///< Changes a row
+    int (*remove)(database *db, int key);                   ///< Deletes a row
+    int (*count)(database *db);                             ///< Counts the rows
+    int (*format)(database *db, char *buffer, size_t size); ///< *_get_all_format
+    char *(*format_old)(database *db);                      ///< *_get_all_format_old
+    size_t format_header;                                   ///< Buffer bytes for the header, as the UI allocates
+    size_t format_row;                                      ///< Buffer bytes per row, as the UI allocates
+};
+
+/**
+ * @struct bench_result
+ * @brief Timings of one operation on one dataset
+ */
+struct bench_result {
+    char table[16];     ///< Table name
+    char op[32];        ///< Operation name
+    int rows;           ///< Dataset size
+    int iterations;     ///< Timed calls
+    double p50_us;      ///< Median latency in microseconds
+    double p95_us;      ///< 95th percentile latency in microseconds
+    double p99_us;      ///< 99th percentile latency in microseconds
+    double ops_per_sec; ///< Calls per second over all calls
+    long peak_rss_kb;   ///< Process peak resident set size when the operation finished
+};
+
+/**
+ * @struct bench_options
+ * @brief Command line options
+ */
+struct bench_options {
+    int sizes[BENCH_MAX_SIZES]; ///< Dataset sizes
+    int size_count;             ///< Entries used in sizes
+    int iterations;             ///< Timed calls per operation
+    const char *tables;         ///< Comma separated tables to run, NULL for all
+    const char *out;            ///< Results file
+    const char *baseline;       ///< Baseline file, NULL to skip the comparison
+    double threshold;           ///< Slowdown of p50 allowed, in percent
+    const char *dir;            ///< Directory for the dataset files
+    int clients;                ///< Server clients at once
+};
+
+static struct bench_result bench_results[BENCH_MAX_RESULTS];
+static int bench_result_count = 0;
+
+/* ======================= TABLES ======================= */
+
+// Rows come from the data generator, one fixed seed so runs compare
+static struct datagen bench_gen;
+
+static int bench_resident_insert(database *db, int key) {
+    struct resident r;
+    datagen_resident(&bench_gen, key, &r);
+    return resident_db_insert(db, r.cpf, r.name, r.age, r.health_status, r.needs, r.medical_assistance, r.gender);
+}
+
+static int bench_resident_get(database *db, int key) {
+    char cpf[MAX_CPF_LENGTH];
+    struct resident resident;
+    datagen_resident_cpf(&bench_gen, key, cpf);
+    return resident_db_get_by_cpf(db, cpf, &resident);
+}
+
+static bool bench_resident_exists(database *db, int key) {
+    char cpf[MAX_CPF_LENGTH];
+    datagen_resident_cpf(&bench_gen, key, cpf);
+    return resident_db_check_cpf_exists(db, cpf);
+}
+
+static int bench_resident_update(database *db, int key) {
+    char cpf[MAX_CPF_LENGTH];
+    datagen_resident_cpf(&bench_gen, key, cpf);
+    return resident_db_update(db, cpf, "", 30 + key % 40, "Under observation", "", -1, -1);
+}
+
+static int bench_resident_remove(database *db, int key) {
+    char cpf[MAX_CPF_LENGTH];
+    datagen_resident_cpf(&bench_gen, key, cpf);
+    return resident_db_delete_by_cpf(db, cpf);
+}
+
+static int bench_food_insert(database *db, int key) {
+    struct foodbatch f;
+    datagen_foodbatch(&bench_gen, key, &f);
+    return foodbatch_db_insert(
+        db,
+        f.batch_id,
+        f.name,
+        f.quantity,
+        f.is_perishable,
+        f.expiration_date,
+        f.daily_consumption_rate
+    );
+}
+
+static int bench_food_get(database *db, int key) {
+    struct foodbatch foodbatch;
+    return foodbatch_db_get_by_batchid(db, key, &foodbatch);
+}
+
+static bool bench_food_exists(database *db, int key) {
+    return foodbatch_db_check_batchid_exists(db, key);
+}
+
+static int bench_food_update(database *db, int key) {
+    return foodbatch_db_update(db, key, "", 1 + key % 300, -1, "", -1.0f);
+}
+
+static int bench_food_remove(database *db, int key) {
+    return foodbatch_db_delete_by_id(db, key);
+}
+
+static int bench_user_insert(database *db, int key) {
+    struct user u;
+    datagen_user(&bench_gen, key, &u);
+    return user_db_create_user(db, u.username, u.cpf, u.phone_number, u.is_admin);
+}
+
+static int bench_user_get(database *db, int key) {
+    char username[MAX_INPUT];
+    struct user user;
+    datagen_user_username(&bench_gen, key, username);
+    return user_db_get_by_username(db, username, &user);
+}
+
+static bool bench_user_exists(database *db, int key) {
+    char username[MAX_INPUT];
+    datagen_user_username(&bench_gen, key, username);
+    return user_db_check_exists(db, username);
+}
+
+static int bench_user_update(database *db, int key) {
+    char username[MAX_INPUT];
+    char phone[16];
+    datagen_user_username(&bench_gen, key, username);
+    snprintf(phone, sizeof(phone), "51%09d", key);
+    return user_db_update_phone_number(db, username, phone);
+}
+
+static int bench_user_remove(database *db, int key) {
+    char username[MAX_INPUT];
+    datagen_user_username(&bench_gen, key, username);
+    return user_db_delete(db, username);
+}
+
+static const struct bench_table bench_tables[] = {
+    { "resident",
+      resident_db_create_table,
+      bench_resident_insert,
+      bench_resident_get,
+      bench_resident_exists,
+      bench_resident_update,
+      bench_resident_remove,
+      resident_db_get_count,
+      resident_db_get_all_format,
+      resident_db_get_all_format_old,
+      1024,
+      2048 },
+    { "food",
+      foodbatch_db_create_table,
+      bench_food_insert,
+      bench_food_get,
+      bench_food_exists,
+      bench_food_update,
+      bench_food_remove,
+      foodbatch_db_get_count,
+      foodbatch_db_get_all_format,
+      foodbatch_db_get_all_format_old,
+      512,
+      512 },
+    { "user",
+      user_db_create_table,
+      bench_user_insert,
+      bench_user_get,
+      bench_user_exists,
+      bench_user_update,
+      bench_user_remove,
+      user_db_get_count,
+      user_db_get_all_format,
+      user_db_get_all_format_old,
+      512,
+      512 },
+};
+
+#define BENCH_TABLE_COUNT ((int)(sizeof(bench_tables) / sizeof(bench_tables[0])))
+
+/* ======================= MEASUREMENT ======================= */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss; // Kilobytes on Linux
+    }
+#endif
+    return 0;
+}
+
+static int online_cores(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) {
+        return cores < BENCH_KDF_MAX_THREADS ? (int)cores : BENCH_KDF_MAX_THREADS;
+    }
+#endif
+    return 1;
+}
+
+// xorshift64, the same sequence on every run so runs compare
+static uint64_t bench_rng = 88172645463325252u;
+
+static int random_key(int rows) {
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 7;
+    bench_rng ^= bench_rng << 17;
+    return 1 + (int)(bench_rng % (uint64_t)rows);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted samples, in microseconds
+static double percentile_us(const uint64_t *sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    return (double)sorted[rank - 1] / 1000.0;
+}
+
+/**
+ * @brief Records the timings of an operation and prints them
+ *
+ * @param samples Latency of each call in nanoseconds (sorted in place)
+ * @param count Calls
+ * @param total_ns Wall time of all calls, the throughput is computed from it
+ */
+static void add_result(const char *table, const char *op, int rows, uint64_t *samples, int count, uint64_t total_ns) {
+    if (count == 0 || bench_result_count == BENCH_MAX_RESULTS) {
+        return;
+    }
+
+    qsort(samples, (size_t)count, sizeof(*samples), compare_u64);
+
+    struct bench_result *result = &bench_results[bench_result_count++];
+    snprintf(result->table, sizeof(result->table), "%s", table);
+    snprintf(result->op, sizeof(result->op), "%s", op);
+    result->rows = rows;
+    result->iterations = count;
+    result->p50_us = percentile_us(samples, count, 50);
+    result->p95_us = percentile_us(samples, count, 95);
+    result->p99_us = percentile_us(samples, count, 99);
+    result->ops_per_sec = total_ns ? (double)count * 1e9 / (double)total_ns : 0;
+    result->peak_rss_kb = peak_rss_kb();
+
+    printf(
+        "%-9s %-19s %8d rows %8d calls  p50 %10.2f us  p95 %10.2f us  p99 %10.2f us  %12.0f ops/s  %8ld KB\n",
+        result->table,
+        result->op,
+        result->rows,
+        result->iterations,
+        result->p50_us,
+        result->p95_us,
+        result->p99_us,
+        result->ops_per_sec,
+        result->peak_rss_kb
+    );
+    fflush(stdout);
+}
+
+/* ======================= RUN ======================= */
+
+/**
+ * @brief Calls an operation once per key and records it
+ *
+ * @return false if a call failed (the result is not recorded)
+ */
+static bool time_keys(
+    database *db,
+    const struct bench_table *table,
+    const char *op,
+    int rows,
+    int (*fn)(database *db, int key),
+    const int *keys,
+    int count,
+    uint64_t *samples
+) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < count; i++) {
+        uint64_t t0 = now_ns();
+        int rc = fn(db, keys[i]);
+        samples[i] = now_ns() - t0;
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "%s %s failed on key %d: %d\n", table->name, op, keys[i], rc);
+            return false;
+        }
+    }
+    add_result(table->name, op, rows, samples, count, now_ns() - start);
+    return true;
+}
+
+/**
+ * @brief Fills the dataset in transactions of BENCH_BATCH_ROWS, timing every insert
+ */
+static bool fill_dataset(database *db, const struct bench_table *table, int rows, uint64_t *samples) {
+    uint64_t start = now_ns();
+    for (int key = 1; key <= rows; key++) {
+        if ((key - 1) % BENCH_BATCH_ROWS == 0 && sqlite3_exec(db->db, "BEGIN;", 0, 0, 0) != SQLITE_OK) {
+            fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+            return false;
+        }
+
+        uint64_t t0 = now_ns();
+        int rc = table->insert(db, key);
+        samples[key - 1] = now_ns() - t0;
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "%s batch_insert failed on key %d: %d\n", table->name, key, rc);
+            sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+            return false;
+        }
+
+        if ((key % BENCH_BATCH_ROWS == 0 || key == rows) && sqlite3_exec(db->db, "COMMIT;", 0, 0, 0) != SQLITE_OK) {
+            fprintf(stderr, "Failed to commit: %s\n", sqlite3_errmsg(db->db));
+            return false;
+        }
+    }
+    add_result(table->name, "batch_insert", rows, samples, rows, now_ns() - start);
+    return true;
+}
+
+struct bench_pool_worker {
+    pthread_t thread;
+    database *db;
+    const struct bench_table *table;
+    uint64_t deadline_ns; ///< Stop counting after this time
+    uint64_t *samples;    ///< Latency of each count
+    int capacity;         ///< Samples allocated
+    int count;            ///< Counts done
+    bool failed;          ///< A count failed
+};
+
+static void *bench_pool_count_until(void *arg) {
+    struct bench_pool_worker *worker = arg;
+
+    database reader;
+    if (db_pool_acquire(worker->db, &reader) != SQLITE_OK) {
+        worker->failed = true;
+        return NULL;
+    }
+    while (!worker->failed && worker->count < worker->capacity
+           && (worker->count == 0 || now_ns() < worker->deadline_ns)) {
+        uint64_t t0 = now_ns();
+        worker->failed = worker->table->count(&reader) < 0;
+        worker->samples[worker->count++] = now_ns() - t0;
+    }
+    db_pool_release(worker->db, &reader);
+    return NULL;
+}
+
+/**
+ * @brief Counts the rows on every core at once, each thread on its own pooled reader
+ *
+ * Compared with the count result, tells how reports scale over the cores. Runs last on the
+ * dataset: the pool switches the file to WAL, which would change the timings after it.
+ */
+static bool bench_pool_run(database *db, const struct bench_table *table, int rows, int iterations) {
+    int threads = online_cores() < DB_POOL_MAX_READERS ? online_cores() : DB_POOL_MAX_READERS;
+    if (db_pool_open(db, threads) != SQLITE_OK) {
+        return false;
+    }
+
+    uint64_t *samples = malloc((size_t)threads * (size_t)iterations * sizeof(*samples));
+    if (!samples) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return false;
+    }
+
+    struct bench_pool_worker workers[DB_POOL_MAX_READERS] = { 0 };
+    uint64_t start = now_ns();
+    int started = 0;
+    for (; started < threads; started++) {
+        struct bench_pool_worker *worker = &workers[started];
+        worker->db = db;
+        worker->table = table;
+        worker->deadline_ns = start + BENCH_POOL_BUDGET_NS;
+        worker->samples = samples + (size_t)started * (size_t)iterations;
+        worker->capacity = iterations;
+        if (pthread_create(&worker->thread, NULL, bench_pool_count_until, worker) != 0) {
+            fprintf(stderr, "Failed to start a reader thread.\n");
+            break;
+        }
+    }
+
+    // Samples of every thread back to back
+    int count = 0;
+    bool ok = started == threads;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ok = ok && !workers[i].failed;
+        memmove(samples + count, workers[i].samples, (size_t)workers[i].count * sizeof(*samples));
+        count += workers[i].count;
+    }
+    uint64_t total_ns = now_ns() - start;
+
+    if (ok) {
+        char op[32];
+        snprintf(op, sizeof(op), "count_pool_%dt", threads);
+        add_result(table->name, op, rows, samples, count, total_ns);
+    } else {
+        fprintf(stderr, "%s count_pool failed.\n", table->name);
+    }
+    free(samples);
+    return ok;
+}
+
+/**
+ * @brief Runs every operation of a table on a fresh dataset
+ */
+static bool bench_table_run(const struct bench_table *table, int rows, const struct bench_options *options) {
+    char path[BENCH_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/bench_%s_%d.db", options->dir, table->name, rows);
+    remove(path);
+
+    database db = { 0 };
+    if (db_init_with_tbl(&db, path, table->create_table) != SQLITE_OK) {
+        return false;
+    }
+
+    int iterations = options->iterations < rows ? options->iterations : rows;
+    int sample_count = rows > iterations ? rows : iterations;
+    uint64_t *samples = malloc((size_t)sample_count * sizeof(*samples));
+    int *keys = calloc((size_t)sample_count, sizeof(*keys));
+    bool ok = samples && keys;
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed.\n");
+    }
+
+    ok = ok && fill_dataset(&db, table, rows, samples);
+
+    // Fresh keys after the dataset, each insert commits on its own
+    for (int i = 0; ok && i < iterations; i++) {
+        keys[i] = rows + 1 + i;
+    }
+    ok = ok && time_keys(&db, table, "insert", rows, table->insert, keys, iterations, samples);
+
+    for (int i = 0; ok && i < iterations; i++) {
+        keys[i] = random_key(rows);
+    }
+    ok = ok && time_keys(&db, table, "get_by_key", rows, table->get, keys, iterations, samples);
+
+    if (ok) {
+        uint64_t start = now_ns();
+        for (int i = 0; ok && i < iterations; i++) {
+            uint64_t t0 = now_ns();
+            ok = table->exists(&db, keys[i]);
+            samples[i] = now_ns() - t0;
+        }
+        if (ok) {
+            add_result(table->name, "check_exists", rows, samples, iterations, now_ns() - start);
+        } else {
+            fprintf(stderr, "%s check_exists failed.\n", table->name);
+        }
+    }
+
+    ok = ok && time_keys(&db, table, "update", rows, table->update, keys, iterations, samples);
+
+    if (ok) {
+        uint64_t start = now_ns();
+        for (int i = 0; ok && i < iterations; i++) {
+            uint64_t t0 = now_ns();
+            ok = table->count(&db) >= rows;
+            samples[i] = now_ns() - t0;
+        }
+        if (ok) {
+            add_result(table->name, "count", rows, samples, iterations, now_ns() - start);
+        } else {
+            fprintf(stderr, "%s count failed.\n", table->name);
+        }
+    }
+
+    // The whole table per call: as many calls as the time budget allows, at least one
+    size_t format_size = table->format_header + table->format_row * (size_t)(rows + iterations);
+    if (ok && format_size > BENCH_FORMAT_MAX_BYTES) {
+        printf("%-9s get_all_format      %8d rows skipped, needs a %zu MB buffer\n", table->name, rows, format_size >> 20);
+    } else if (ok) {
+        char *buffer = malloc(format_size);
+        uint64_t start = now_ns();
+        int calls = 0;
+        while (ok && calls < iterations && (calls == 0 || now_ns() - start < BENCH_FORMAT_BUDGET_NS)) {
+            uint64_t t0 = now_ns();
+            ok = buffer && table->format(&db, buffer, format_size) > 0;
+            samples[calls++] = now_ns() - t0;
+        }
+        free(buffer);
+        if (ok) {
+            add_result(table->name, "get_all_format", rows, samples, calls, now_ns() - start);
+        } else {
+            fprintf(stderr, "%s get_all_format failed.\n", table->name);
+        }
+    }
+
+    // The old variants grow their string with strlen and realloc on every row (quadratic)
+    if (ok && rows > BENCH_FORMAT_OLD_MAX_ROWS) {
+        printf("%-9s get_all_format_old  %8d rows skipped, quadratic over %d rows\n", table->name, rows, BENCH_FORMAT_OLD_MAX_ROWS);
+    } else if (ok) {
+        uint64_t start = now_ns();
+        int calls = 0;
+        while (ok && calls < iterations && (calls == 0 || now_ns() - start < BENCH_FORMAT_BUDGET_NS)) {
+            uint64_t t0 = now_ns();
+            char *text = table->format_old(&db);
+            samples[calls++] = now_ns() - t0;
+            ok = text != NULL;
+            free(text);
+        }
+        if (ok) {
+            add_result(table->name, "get_all_format_old", rows, samples, calls, now_ns() - start);
+        } else {
+            fprintf(stderr, "%s get_all_format_old failed.\n", table->name);
+        }
+    }
+
+    // Distinct keys in random order (partial Fisher-Yates)
+    for (int i = 0; ok && i < rows; i++) {
+        keys[i] = i + 1;
+    }
+    for (int i = 0; ok && i < iterations; i++) {
+        int j = i + random_key(rows - i) - 1;
+        int key = keys[i];
+        keys[i] = keys[j];
+        keys[j] = key;
+    }
+    ok = ok && time_keys(&db, table, "delete", rows, table->remove, keys, iterations, samples);
+    ok = ok && bench_pool_run(&db, table, rows, iterations);
+
+    free(samples);
+    free(keys);
+    db_deinit(&db);
+    remove(path);
+    return ok;
+}
+
+/* ======================= SERVER ======================= */
+
+struct bench_server_client {
+    pthread_t thread;
+    database db;       ///< Resident database attached to the client's connection
+    bool write;        ///< Inserts the keys, else reads them
+    int first_key;     ///< First resident key of this client
+    int count;         ///< Keys of this client
+    uint64_t *samples; ///< Latency of each call
+    bool failed;       ///< A call failed
+};
+
+static void *bench_server_work(void *arg) {
+    struct bench_server_client *client = arg;
+    for (int i = 0; i < client->count && !client->failed; i++) {
+        uint64_t t0 = now_ns();
+        int key = client->first_key + i;
+        int rc = client->write ? bench_resident_insert(&client->db, key) : bench_resident_get(&client->db, key);
+        client->samples[i] = now_ns() - t0;
+        client->failed = rc != SQLITE_OK;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs the keys of every client at once and records the calls
+ */
+static bool bench_server_phase(struct bench_server_client *clients, int count, bool write, uint64_t *samples) {
+    uint64_t start = now_ns();
+    int started = 0;
+    for (; started < count; started++) {
+        clients[started].write = write;
+        if (pthread_create(&clients[started].thread, NULL, bench_server_work, &clients[started]) != 0) {
+            fprintf(stderr, "Failed to start a client thread.\n");
+            break;
+        }
+    }
+
+    bool ok = started == count;
+    int total = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(clients[i].thread, NULL);
+        ok = ok && !clients[i].failed;
+        memmove(samples + total, clients[i].samples, (size_t)clients[i].count * sizeof(*samples));
+        total += clients[i].count;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    if (!ok) {
+        fprintf(stderr, "server %s failed with %d clients\n", write ? "insert" : "get_by_key", count);
+        return false;
+    }
+    add_result("server", write ? "insert" : "get_by_key", count, samples, total, elapsed);
+    return true;
+}
+
+/**
+ * @brief Connects the clients, inserts then reads their keys and prints the writes per commit
+ *
+ * @param first_key First key of the run, the runs before inserted the keys below it
+ */
+static bool bench_server_clients(
+    struct db_server *server,
+    const char *socket_path,
+    int count,
+    int first_key,
+    int iterations,
+    uint64_t *samples
+) {
+    struct bench_server_client *clients = calloc((size_t)count, sizeof(*clients));
+    uint64_t *client_samples = malloc((size_t)count * (size_t)iterations * sizeof(*client_samples));
+    bool ok = clients && client_samples;
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed.\n");
+    }
+
+    int connected = 0;
+    for (; ok && connected < count; connected++) {
+        struct db_client *client = db_client_connect(socket_path);
+        if (!client) {
+            ok = false;
+            break;
+        }
+        db_client_attach(client, &clients[connected].db);
+        clients[connected].first_key = first_key + connected * iterations;
+        clients[connected].count = iterations;
+        clients[connected].samples = client_samples + (size_t)connected * iterations;
+    }
+
+    struct db_server_stats before, after;
+    db_server_get_stats(server, &before);
+    ok = ok && bench_server_phase(clients, count, true, samples);
+    db_server_get_stats(server, &after);
+    ok = ok && bench_server_phase(clients, count, false, samples);
+
+    if (ok) {
+        uint64_t commits = after.commits - before.commits;
+        printf(
+            "server    %d clients: %.1f writes per commit\n",
+            count,
+            commits ? (double)(after.writes - before.writes) / (double)commits : 0.0
+        );
+    }
+
+    for (int i = 0; i < connected; i++) {
+        struct db_client *client = clients[i].db.remote;
+        db_deinit(&clients[i].db);
+        db_client_close(client);
+    }
+    free(clients);
+    free(client_samples);
+    return ok;
+}
+
+/**
+ * @brief Times the resident functions through a server, one client then options->clients
+ */
+static bool bench_server_run(const struct bench_options *options) {
+#ifdef _WIN32
+    (void)options;
+    printf("server    skipped, Unix domain sockets are not available on this platform\n");
+    return true;
+#else
+    const char *names[3] = { "resident", "food", "user" };
+    int (*create_tables[3])(database *db) = {
+        resident_db_create_table,
+        foodbatch_db_create_table,
+        user_db_create_table,
+    };
+    char paths[3][BENCH_PATH_MAX];
+    database dbs[3] = { 0 };
+    char socket_path[BENCH_PATH_MAX];
+    snprintf(socket_path, sizeof(socket_path), "%s/bench_server.sock", options->dir);
+
+    bool ok = true;
+    int opened = 0;
+    for (; ok && opened < 3; opened++) {
+        snprintf(paths[opened], sizeof(paths[opened]), "%s/bench_server_%s.db", options->dir, names[opened]);
+        remove(paths[opened]);
+        if (db_init_with_tbl(&dbs[opened], paths[opened], create_tables[opened]) != SQLITE_OK) {
+            ok = false;
+            break;
+        }
+    }
+
+    struct db_server *server = ok ? db_server_start(socket_path, &dbs[0], &dbs[1], &dbs[2], NULL) : NULL;
+    uint64_t *samples = malloc((size_t)options->clients * (size_t)options->iterations * sizeof(*samples));
+    ok = server && samples;
+
+    // One client pays a commit per write, several share them
+    ok = ok && bench_server_clients(server, socket_path, 1, 1, options->iterations, samples);
+    if (options->clients > 1) {
+        int first_key = 1 + options->iterations;
+        ok = ok && bench_server_clients(server, socket_path, options->clients, first_key, options->iterations, samples);
+    }
+
+    db_server_stop(server);
+    free(samples);
+    for (int i = 0; i < opened; i++) {
+        db_deinit(&dbs[i]);
+        remove(paths[i]);
+    }
+    return ok;
+#endif
+}
+
+/* ======================= KDF ======================= */
+
+struct bench_kdf_worker {
+    pthread_t thread;
+    uint64_t deadline_ns; ///< Stop hashing after this time
+    uint64_t *samples;    ///< Latency of each hash
+    int count;            ///< Hashes done
+};
+
+static uint64_t time_hash(const char *password) {
+    char hash[PASSWORD_HASH_LEN + 1];
+    struct password_kdf_params params = { PASSWORD_KDF_PBKDF2_SHA256, PASSWORD_KDF_DEFAULT_ITERATIONS };
+    uint64_t start = now_ns();
+    hash_password_kdf(password, "bench salt", params, hash);
+    return now_ns() - start;
+}
+
+static void *bench_kdf_hash_until(void *arg) {
+    struct bench_kdf_worker *worker = arg;
+    while (worker->count < BENCH_KDF_MAX_SAMPLES && now_ns() < worker->deadline_ns) {
+        worker->samples[worker->count++] = time_hash("bench password");
+    }
+    return NULL;
+}
+
+/**
+ * @brief Times PBKDF2 at the default cost, on one thread then on every core
+ *
+ * The results use the iteration count as their row count, fixed so runs compare whatever the
+ * calibration picked.
+ *
+ * @return false if a worker could not be started or memory ran out
+ */
+static bool bench_kdf_run(void) {
+    printf(
+        "kdf       calibrated to %d iterations for %.0f ms on this machine\n",
+        password_kdf_calibrate(PASSWORD_KDF_TARGET_MS),
+        PASSWORD_KDF_TARGET_MS
+    );
+
+    int cores = online_cores();
+    struct bench_kdf_worker *workers = calloc((size_t)cores, sizeof(*workers));
+    uint64_t *samples = malloc((size_t)cores * BENCH_KDF_MAX_SAMPLES * sizeof(*samples));
+    if (!workers || !samples) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(workers);
+        free(samples);
+        return false;
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_KDF_CALLS; i++) {
+        samples[i] = time_hash("bench password");
+    }
+    add_result("kdf", "pbkdf2", PASSWORD_KDF_DEFAULT_ITERATIONS, samples, BENCH_KDF_CALLS, now_ns() - start);
+
+    // Every core busy, like a burst of logins
+    bool ok = true;
+    int started = 0;
+    start = now_ns();
+    for (; started < cores; started++) {
+        workers[started].deadline_ns = start + BENCH_KDF_PARALLEL_NS;
+        workers[started].samples = samples + (size_t)started * BENCH_KDF_MAX_SAMPLES;
+        if (pthread_create(&workers[started].thread, NULL, bench_kdf_hash_until, &workers[started]) != 0) {
+            fprintf(stderr, "Failed to start a hashing thread.\n");
+            ok = false;
+            break;
+        }
+    }
+
+    int total = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        // Packed behind the samples of the workers before
+        memmove(samples + total, workers[i].samples, (size_t)workers[i].count * sizeof(*samples));
+        total += workers[i].count;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    if (ok) {
+        add_result("kdf", "pbkdf2_all_cores", PASSWORD_KDF_DEFAULT_ITERATIONS, samples, total, elapsed);
+        printf(
+            "kdf       %d cores: %.1f hashes/s, %.1f hashes/s per core\n",
+            cores,
+            (double)total * 1e9 / (double)elapsed,
+            (double)total * 1e9 / (double)elapsed / cores
+        );
+    }
+
+    free(workers);
+    free(samples);
+    return ok;
+}
+
+/* ======================= RESULTS ======================= */
+
+static bool write_results(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return false;
+    }
+
+    fprintf(out, "table,op,rows,iterations,p50_us,p95_us,p99_us,ops_per_sec,peak_rss_kb\n");
+    for (int i = 0; i < bench_result_count; i++) {
+        const struct bench_result *r = &bench_results[i];
+        fprintf(
+            out,
+            "%s,%s,%d,%d,%.3f,%.3f,%.3f,%.1f,%ld\n",
+            r->table,
+            r->op,
+            r->rows,
+            r->iterations,
+            r->p50_us,
+            r->p95_us,
+            r->p99_us,
+            r->ops_per_sec,
+            r->peak_rss_kb
+        );
+    }
+
+    bool ok = fclose(out) == 0;
+    if (!ok) {
+        perror(path);
+    }
+    return ok;
+}
+
+/**
+ * @brief Compares the results with a baseline written by an earlier run
+ *
+ * @return Number of regressions, or -1 if the baseline can't be read
+ */
+static int compare_baseline(const char *path, double threshold) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        printf("No baseline at %s, results not compared (copy the results there to set one).\n", path);
+        return -1;
+    }
+
+    int regressions = 0;
+    int compared = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        struct bench_result base;
+        if (sscanf(line, "%15[^,],%31[^,],%d,%d,%lf", base.table, base.op, &base.rows, &base.iterations, &base.p50_us)
+            != 5) {
+            continue; // Header
+        }
+
+        for (int i = 0; i < bench_result_count; i++) {
+            const struct bench_result *r = &bench_results[i];
+            if (r->rows != base.rows || strcmp(r->table, base.table) != 0 || strcmp(r->op, base.op) != 0) {
+                continue;
+            }
+
+            compared++;
+            double change = base.p50_us > 0 ? (r->p50_us - base.p50_us) * 100.0 / base.p50_us : 0;
+            if (change > threshold) {
+                printf(
+                    "REGRESSION %s %s at %d rows: p50 %.2f us -> %.2f us (+%.1f%%)\n",
+                    r->table,
+                    r->op,
+                    r->rows,
+                    base.p50_us,
+                    r->p50_us,
+                    change
+                );
+                regressions++;
+            }
+            break;
+        }
+    }
+    fclose(in);
+
+    printf("Compared %d results with %s: %d regressions over %.1f%%.\n", compared, path, regressions, threshold);
+    return regressions;
+}
+
+/* ======================= ENTRY ======================= */
+
+static bool parse_sizes(const char *text, struct bench_options *options) {
+    options->size_count = 0;
+    while (*text) {
+        char *end;
+        long size = strtol(text, &end, 10);
+        if (end == text || size <= 0 || size > DATAGEN_MAX_ROWS / 2 || options->size_count == BENCH_MAX_SIZES) {
+            return false;
+        }
+        options->sizes[options->size_count++] = (int)size;
+        text = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return false;
+        }
+    }
+    return options->size_count > 0;
+}
+
+static bool table_selected(const char *tables, const char *name) {
+    if (!tables) {
+        return true;
+    }
+
+    size_t len = strlen(name);
+    for (const char *t = tables; (t = strstr(t, name)) != NULL; t += len) {
+        if ((t == tables || t[-1] == ',') && (t[len] == ',' || t[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_usage(const char *program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "  --sizes N,N,...      dataset sizes (default " BENCH_DEFAULT_SIZES ")\n"
+        "  --iterations N       timed calls per operation (default %d)\n"
+        "  --tables a,b         tables to run: resident, food, user, server, kdf (default all)\n"
+        "  --clients N          server clients at once (default %d)\n"
+        "  --out FILE           results CSV (default bench_results.csv)\n"
+        "  --baseline FILE      compare with a results CSV of an earlier run\n"
+        "  --threshold PCT      p50 slowdown reported as a regression (default %.0f)\n"
+        "  --dir DIR            directory for the dataset files (default .)\n",
+        program,
+        BENCH_DEFAULT_ITERATIONS,
+        BENCH_DEFAULT_CLIENTS,
+        BENCH_DEFAULT_THRESHOLD
+    );
+}
+
+/**
+ * @brief Benchmark entry point
+ *
+ * @return int EXIT_SUCCESS, 1 if an operation failed or regressed, 2 on bad arguments
+ */
+int main(int argc, char **argv) {
+    struct bench_options options = {
+        .iterations = BENCH_DEFAULT_ITERATIONS,
+        .tables = NULL,
+        .out = "bench_results.csv",
+        .baseline = NULL,
+        .threshold = BENCH_DEFAULT_THRESHOLD,
+        .dir = ".",
+        .clients = BENCH_DEFAULT_CLIENTS,
+    };
+    parse_sizes(BENCH_DEFAULT_SIZES, &options);
+    datagen_init(&bench_gen, BENCH_SEED);
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+        if (strcmp(argv[i], "--sizes") == 0) {
+            ok = ok && parse_sizes(value, &options);
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            ok = ok && (options.iterations = atoi(value)) > 0 && options.iterations <= DATAGEN_MAX_ROWS / 2;
+        } else if (strcmp(argv[i], "--tables") == 0) {
+            options.tables = value;
+        } else if (strcmp(argv[i], "--out") == 0) {
+            options.out = value;
+        } else if (strcmp(argv[i], "--baseline") == 0) {
+            options.baseline = value;
+        } else if (strcmp(argv[i], "--threshold") == 0) {
+            ok = ok && (options.threshold = atof(value)) >= 0;
+        } else if (strcmp(argv[i], "--dir") == 0) {
+            options.dir = value;
+        } else if (strcmp(argv[i], "--clients") == 0) {
+            ok = ok && (options.clients = atoi(value)) > 0 && options.clients <= DB_SERVER_MAX_CLIENTS;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    int failed = 0;
+    for (int s = 0; s < options.size_count; s++) {
+        for (int t = 0; t < BENCH_TABLE_COUNT; t++) {
+            if (table_selected(options.tables, bench_tables[t].name)
+                && !bench_table_run(&bench_tables[t], options.sizes[s], &options)) {
+                failed++;
+            }
+        }
+    }
+
+    if (table_selected(options.tables, "server") && !bench_server_run(&options)) {
+        failed++;
+    }
+
+    if (table_selected(options.tables, "kdf") && !bench_kdf_run()) {
+        failed++;
+    }
+
+    if (!write_results(options.out)) {
+        return EXIT_FAILURE;
+    }
+    printf("Results written to %s.\n", options.out);
+
+    int regressions = options.baseline ? compare_baseline(options.baseline, options.threshold) : 0;
+    return failed == 0 && regressions <= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,12 +4,28 @@
  *
  * This header defines operations for managing clothes records in an SQLite database,
  * including creation, insertion, updating, deletion, and querying of clothes information.
+ *
+ * Each row is one SKU: a type/size/gender/color/condition combination and how many items of it
+ * are in stock. Matching SKUs by attribute is done in memory by clothes_index.h.
  */
 
 #ifndef CLOTHES_DB_H
 #define CLOTHES_DB_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "db_manager.h"
+#include "entities/clothes.h"
+
+/**
+ * @brief Callback for queries returning clothes records
+ *
+ * @param ctx User context passed to the query
+ * @param clothes Record (only valid during the call)
+ * @return 0 to continue, non-zero to stop
+ */
+typedef int (*clothes_callback)(void *ctx, const struct clothes *clothes);
 
 /**
  * @brief Creates the Clothes table in the database
@@ -23,4 +39,116 @@
  */
 int clothes_db_create_table(database *db);
 
-#endif // CLOTHES_DB_H
\ No newline at end of file
+/**
+ * @brief Inserts a new clothes record
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] type Type (required)
+ * @param[in] size Size
+ * @param[in] gender Gender
+ * @param[in] color Color
+ * @param[in] quantity Items in stock
+ * @param[in] condition Condition
+ * @param[in] notes General notes
+ * @param[out] id Receives the id of the new record (may be NULL)
+ * @return SQLITE_OK on success, SQLITE_CONSTRAINT if the same type, size, gender, color and
+ *         condition exists, SQLite error code on failure
+ */
+int clothes_db_insert(
+    database *db,
+    const char *type,
+    const char *size,
+    const char *gender,
+    const char *color,
+    int quantity,
+    const char *condition,
+    const char *notes,
+    int *id
+);
+
+/**
+ * @brief Updates an existing clothes record
+ *
+ * Empty strings or negative quantity will preserve the existing values.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to update
+ * @param[in] type New type (empty string preserves current)
+ * @param[in] size New size (empty string preserves current)
+ * @param[in] gender New gender (empty string preserves current)
+ * @param[in] color New color (empty string preserves current)
+ * @param[in] quantity New quantity (< 0 preserves current)
+ * @param[in] condition New condition (empty string preserves current)
+ * @param[in] notes New notes (empty string preserves current)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the record doesn't exist,
+ *         SQLITE_CONSTRAINT if it would duplicate another SKU, SQLite error code on failure
+ */
+int clothes_db_update(
+    database *db,
+    int id,
+    const char *type,
+    const char *size,
+    const char *gender,
+    const char *color,
+    int quantity,
+    const char *condition,
+    const char *notes
+);
+
+/**
+ * @brief Deletes a clothes record
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to delete
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the record doesn't exist, SQLite error code on failure
+ */
+int clothes_db_delete_by_id(database *db, int id);
+
+/**
+ * @brief Checks if a clothes ID exists
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID to check
+ * @return true if the ID exists, false otherwise or on error
+ */
+bool clothes_db_check_id_exists(database *db, int id);
+
+/**
+ * @brief Retrieves a clothes record by ID
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to retrieve
+ * @param[out] clothes Pointer to clothes struct to populate
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if not found, SQLite error code on failure
+ */
+int clothes_db_get_by_id(database *db, int id, struct clothes *clothes);
+
+/**
+ * @brief Gets the number of clothes records
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @return Number of records, or -1 on error
+ */
+int clothes_db_get_count(database *db);
+
+/**
+ * @brief Formats every clothes record as a table into a buffer
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[out] buffer Output buffer
+ * @param[in] buffer_size Size of buffer, 512 for the header plus 512 per record always fits
+ * @return Number of bytes written, or -1 on error or truncation
+ */
+int clothes_db_get_all_format(database *db, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Visits every clothes record in ID order
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] callback Function called for each record
+ * @param[in] ctx User context passed to callback
+ * @return Number of records visited, or -1 on error
+ */
+int clothes_db_for_each(database *db, clothes_callback callback, void *ctx);
+
+#endif // CLOTHES_DB_H
@@ -0,0 +1,176 @@
+/**
+ * @file clothes_index.h
+ * @brief Clothes Attribute Matching
+ *
+ * Keeps the clothes in stock as a bitmap index: every distinct value of an attribute (size "M",
+ * gender "male", ...) has one bitset with a bit per SKU. A query like "size M, male or other,
+ * condition new or good" is the OR of the bitsets of the values allowed for each attribute,
+ * ANDed across attributes, 64 SKUs per operation, so matching stays instant while the filter
+ * is edited even with tens of thousands of SKUs.
+ *
+ * Values are compared with name_hash() (utils_name.h), so "M" and "m" are the same size.
+ * Only SKUs with a positive quantity are kept.
+ */
+
+#ifndef CLOTHES_INDEX_H
+#define CLOTHES_INDEX_H
+
+#include <stdbool.h>
+
+#include "db/db_manager.h"
+#include "entities/clothes.h"
+
+/**
+ * @def CLOTHES_QUERY_MAX_VALUES
+ * @brief Maximum number of values allowed for one attribute in a query
+ */
+#define CLOTHES_QUERY_MAX_VALUES 16
+
+/**
+ * @enum clothes_attribute
+ * @brief Attributes that can be matched
+ */
+enum clothes_attribute {
+    CLOTHES_ATTR_TYPE = 0,  ///< clothes.type
+    CLOTHES_ATTR_SIZE,      ///< clothes.size
+    CLOTHES_ATTR_GENDER,    ///< clothes.gender
+    CLOTHES_ATTR_COLOR,     ///< clothes.color
+    CLOTHES_ATTR_CONDITION, ///< clothes.condition
+    CLOTHES_ATTR_COUNT      ///< Number of attributes
+};
+
+/**
+ * @struct clothes_query
+ * @brief Values allowed per attribute, an attribute without restriction matches anything
+ *
+ * Build it with clothes_query_init() and clothes_query_allow().
+ */
+struct clothes_query {
+    int values[CLOTHES_ATTR_COUNT][CLOTHES_QUERY_MAX_VALUES]; ///< Value indexes allowed per attribute
+    int value_count[CLOTHES_ATTR_COUNT];                      ///< Entries used in values
+    bool restricted[CLOTHES_ATTR_COUNT];                      ///< Whether the attribute is filtered at all
+};
+
+/**
+ * @struct clothes_match
+ * @brief Totals of a match
+ */
+struct clothes_match {
+    int rows;           ///< SKUs matched
+    int total_quantity; ///< Items in stock over every SKU matched
+};
+
+/**
+ * @struct clothes_index
+ * @brief Opaque index state
+ */
+struct clothes_index;
+
+/**
+ * @brief Loads every clothes record with a positive quantity
+ *
+ * @param clothes_db Pointer to initialized clothes database
+ * @return New index, or NULL on failure
+ * @warning Must be released with clothes_index_free()
+ */
+struct clothes_index *clothes_index_load(database *clothes_db);
+
+/**
+ * @brief Adds or replaces a SKU (call after inserting or updating it in the database)
+ *
+ * A quantity of 0 or less removes the SKU from the index. Notes are not kept.
+ *
+ * @param ci Index
+ * @param clothes Record as stored in the database
+ * @return true on success, false on allocation failure (the index is left unchanged)
+ */
+bool clothes_index_set(struct clothes_index *ci, const struct clothes *clothes);
+
+/**
+ * @brief Removes a SKU (call after deleting it from the database)
+ *
+ * @param ci Index
+ * @param id Clothes id, unknown ids are ignored
+ */
+void clothes_index_remove(struct clothes_index *ci, int id);
+
+/**
+ * @brief Resets a query to match everything
+ *
+ * @param q Query
+ */
+void clothes_query_init(struct clothes_query *q);
+
+/**
+ * @brief Allows a value for an attribute, the attribute becomes restricted
+ *
+ * Values allowed for the same attribute are ORed. A value no SKU has ever had still restricts
+ * the attribute, so a query allowing only unknown values matches nothing.
+ *
+ * @param q Query
+ * @param ci Index the query will run on
+ * @param attribute Attribute to restrict
+ * @param value Value as typed
+ * @return true on success, false if CLOTHES_QUERY_MAX_VALUES values are already allowed
+ */
+bool clothes_query_allow(
+    struct clothes_query *q,
+    const struct clothes_index *ci,
+    enum clothes_attribute attribute,
+    const char *value
+);
+
+/**
+ * @brief Finds the SKUs matching a query
+ *
+ * @param ci Index
+ * @param q Query
+ * @param[out] ids Ids of the SKUs matched (may be NULL if max is 0)
+ * @param max Capacity of ids
+ * @param[out] match Totals over every SKU matched, not only those written (may be NULL)
+ * @return Number of ids written, or -1 on allocation failure
+ */
+int clothes_index_match(
+    struct clothes_index *ci,
+    const struct clothes_query *q,
+    int *ids,
+    int max,
+    struct clothes_match *match
+);
+
+/**
+ * @brief Reads a SKU back from the index
+ *
+ * Values are spelled as first seen by the index ("m" reads back as "M" if "M" came first).
+ *
+ * @param ci Index
+ * @param id Clothes id
+ * @param[out] clothes Record (notes are empty)
+ * @return true if the SKU is in the index
+ */
+bool clothes_index_row(const struct clothes_index *ci, int id, struct clothes *clothes);
+
+/**
+ * @brief Number of SKUs kept
+ *
+ * @param ci Index
+ * @return SKU count
+ */
+int clothes_index_count(const struct clothes_index *ci);
+
+/**
+ * @brief Change counter, incremented whenever a SKU is set or removed
+ *
+ * @param ci Index
+ * @return Current version
+ */
+unsigned clothes_index_version(const struct clothes_index *ci);
+
+/**
+ * @brief Releases the index
+ *
+ * @param ci Index (NULL is a no-op)
+ */
+void clothes_index_free(struct clothes_index *ci);
+
+#endif // CLOTHES_INDEX_H
@@ -0,0 +1,202 @@
+/**
+ * @file datagen.h
+ * @brief Deterministic Synthetic Data
+ *
+ * Generates plausible rows for every table of the application, for load tests and benchmarks:
+ *
+ * - residents have CPFs with valid check digits and Portuguese names, frequent names and
+ *   surnames ("Maria", "Silva") coming up more often than rare ones;
+ * - food batches have shelf lives and per-resident consumption rates that depend on the food,
+ *   a few of them already expired and non-perishables like salt without an expiration date;
+ * - users, medications, clothes and supplies never repeat a UNIQUE key.
+ *
+ * Rows are numbered from 1 and every row is a pure function of the seed and its number, so
+ * identical seeds give identical databases whatever the batch size, and a table can be filled
+ * in several calls. The fill functions write straight into the tables created by
+ * resident_db_create_table(), foodbatch_db_create_table() and friends, one prepared statement
+ * reused over transactions of batch_rows rows, which makes millions of rows practical.
+ *
+ * Dates are relative to datagen.base_day instead of today so the output does not change with
+ * the calendar.
+ */
+
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "entities/clothes.h"
+#include "entities/foodbatch.h"
+#include "entities/medication.h"
+#include "entities/resident.h"
+#include "entities/supplies.h"
+#include "entities/user.h"
+#include "global/CONSTANTS.h"
+
+/**
+ * @def DATAGEN_BATCH_ROWS
+ * @brief Rows per transaction used when datagen.batch_rows is not set
+ */
+#define DATAGEN_BATCH_ROWS 10000
+
+/**
+ * @def DATAGEN_MAX_ROWS
+ * @brief Highest row number of residents and users (their CPFs are unique up to it)
+ */
+#define DATAGEN_MAX_ROWS 100000000
+
+/**
+ * @brief Progress callback of the fill functions, called after every committed transaction
+ *
+ * @param ctx User context
+ * @param done Rows written so far by this call
+ * @param total Rows this call writes
+ */
+typedef void (*datagen_progress_callback)(void *ctx, int done, int total);
+
+/**
+ * @struct datagen
+ * @brief Generator settings, set up with datagen_init()
+ */
+struct datagen {
+    uint64_t seed;                      ///< Seed, identical seeds give identical rows
+    int32_t base_day;                   ///< Day the data is generated around (days since 1970-01-01)
+    int batch_rows;                     ///< Rows per transaction (<= 0 for DATAGEN_BATCH_ROWS)
+    datagen_progress_callback progress; ///< Called after each transaction (may be NULL)
+    void *progress_ctx;                 ///< User context passed to progress
+};
+
+/**
+ * @brief Sets up a generator with the default base day (2025-01-01) and batch size
+ *
+ * @param[out] gen Generator to set up
+ * @param[in] seed Seed
+ */
+void datagen_init(struct datagen *gen, uint64_t seed);
+
+/**
+ * @brief CPF of a generated resident, without generating the rest of the row
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number (1 to DATAGEN_MAX_ROWS)
+ * @param[out] cpf Receives the zero-padded CPF
+ */
+void datagen_resident_cpf(const struct datagen *gen, int row, char cpf[MAX_CPF_LENGTH]);
+
+/**
+ * @brief Username of a generated user, without generating the rest of the row
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number (1 to DATAGEN_MAX_ROWS)
+ * @param[out] username Receives the username, e.g. "joao.silva17"
+ */
+void datagen_user_username(const struct datagen *gen, int row, char username[MAX_INPUT]);
+
+/**
+ * @brief Generates one resident
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number (1 to DATAGEN_MAX_ROWS)
+ * @param[out] resident Resident to populate (entry date within the year before base_day)
+ */
+void datagen_resident(const struct datagen *gen, int row, struct resident *resident);
+
+/**
+ * @brief Generates one food batch
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number, also the batch id
+ * @param[out] foodbatch Food batch to populate
+ */
+void datagen_foodbatch(const struct datagen *gen, int row, struct foodbatch *foodbatch);
+
+/**
+ * @brief Generates one user, without password (reset_password is set)
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number (1 to DATAGEN_MAX_ROWS)
+ * @param[out] user User to populate
+ */
+void datagen_user(const struct datagen *gen, int row, struct user *user);
+
+/**
+ * @brief Generates one medication
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number, also the id
+ * @param[out] medication Medication to populate
+ */
+void datagen_medication(const struct datagen *gen, int row, struct medication *medication);
+
+/**
+ * @brief Generates one clothes record
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number, also the id
+ * @param[out] clothes Clothes to populate
+ */
+void datagen_clothes(const struct datagen *gen, int row, struct clothes *clothes);
+
+/**
+ * @brief Generates one supplies record
+ *
+ * @param[in] gen Generator
+ * @param[in] row Row number, also the id
+ * @param[out] supplies Supplies to populate
+ */
+void datagen_supplies(const struct datagen *gen, int row, struct supplies *supplies);
+
+/**
+ * @brief Writes residents first to first + count - 1 into the Resident table
+ *
+ * Every transaction is all or nothing, the ones committed before a failure stay. The
+ * ResidentSearch index is not updated row by row but rebuilt once at the end, which is
+ * several times faster for large fills and costs a full reindex for small ones.
+ *
+ * @param[in] db Pointer to initialized database structure (Resident table created)
+ * @param[in] gen Generator
+ * @param[in] first First row number (>= 1)
+ * @param[in] count Number of rows
+ * @return SQLITE_OK on success, SQLITE_RANGE if the rows are out of range,
+ *         SQLITE_CONSTRAINT if a row already exists, SQLite error code on failure
+ */
+int datagen_fill_residents(database *db, const struct datagen *gen, int first, int count);
+
+/**
+ * @brief Writes food batches first to first + count - 1 into the FoodBatch table
+ *
+ * @see datagen_fill_residents() for the parameters and return values
+ */
+int datagen_fill_foodbatches(database *db, const struct datagen *gen, int first, int count);
+
+/**
+ * @brief Writes users first to first + count - 1 into the Users table
+ *
+ * @see datagen_fill_residents() for the parameters and return values
+ */
+int datagen_fill_users(database *db, const struct datagen *gen, int first, int count);
+
+/**
+ * @brief Writes medications first to first + count - 1 into the Medications table
+ *
+ * @see datagen_fill_residents() for the parameters and return values
+ */
+int datagen_fill_medications(database *db, const struct datagen *gen, int first, int count);
+
+/**
+ * @brief Writes clothes first to first + count - 1 into the Clothes table
+ *
+ * @see datagen_fill_residents() for the parameters and return values
+ */
+int datagen_fill_clothes(database *db, const struct datagen *gen, int first, int count);
+
+/**
+ * @brief Writes supplies first to first + count - 1 into the Supplies table
+ *
+ * @see datagen_fill_residents() for the parameters and return values
+ */
+int datagen_fill_supplies(database *db, const struct datagen *gen, int first, int count);
+
+#endif // DATAGEN_H
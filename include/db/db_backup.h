@@ -0,0 +1,217 @@
+/**
+ * @file db_backup.h
+ * @brief Online Database Backups
+ *
+ * Copies the open databases to a backup directory while the app keeps running, on a background
+ * thread, with SQLite's online backup API instead of copying the .db files (a copy taken while
+ * a write is half done is torn).
+ *
+ * - Each database is copied DB_BACKUP_PAGES_PER_STEP pages at a time through the app's own
+ *   connection. The connection is locked only for the length of one step, so a screen waits at
+ *   most that long for it, and writes the app makes between steps go into the copy as well
+ *   instead of making it start over.
+ *
+ * - The copy is written next to its final name as a .partial file, gzip-compressed if asked,
+ *   then renamed into place: a backup in the directory is always complete.
+ *
+ * - Backups are named <database>-YYYYMMDD-HHMMSS.db (.db.gz compressed). Once one is written
+ *   the oldest of that database beyond the configured generations are deleted.
+ *
+ * db_backup_tick(), called every frame, starts a backup when the interval since the last one
+ * has passed; db_backup_start() starts one at once. db_backup_get_status() tells how far the
+ * current one is, for the settings screen.
+ */
+
+#ifndef DB_BACKUP_H
+#define DB_BACKUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "db/db_manager.h"
+
+/**
+ * @def DB_BACKUP_DIR
+ * @brief Directory the app backs up to, next to the databases
+ */
+#define DB_BACKUP_DIR "backups"
+
+/**
+ * @def DB_BACKUP_GENERATIONS
+ * @brief Backups the app keeps per database
+ */
+#define DB_BACKUP_GENERATIONS 7
+
+/**
+ * @def DB_BACKUP_INTERVAL
+ * @brief Seconds between the app's scheduled backups
+ */
+#define DB_BACKUP_INTERVAL (24 * 60 * 60)
+
+/**
+ * @def DB_BACKUP_MAX_DATABASES
+ * @brief Most databases a backup manager copies
+ */
+#define DB_BACKUP_MAX_DATABASES 8
+
+/**
+ * @def DB_BACKUP_PAGES_PER_STEP
+ * @brief Pages copied while holding the source connection
+ */
+#define DB_BACKUP_PAGES_PER_STEP 64
+
+/**
+ * @def DB_BACKUP_STEP_PAUSE_MS
+ * @brief Pause between two steps, leaves the connection to the screens
+ */
+#define DB_BACKUP_STEP_PAUSE_MS 1
+
+/**
+ * @def DB_BACKUP_BUSY_PAUSE_MS
+ * @brief Pause before retrying a step that found the database locked
+ */
+#define DB_BACKUP_BUSY_PAUSE_MS 50
+
+/**
+ * @def DB_BACKUP_RETRY_SECONDS
+ * @brief Delay before a scheduled backup that failed is tried again
+ */
+#define DB_BACKUP_RETRY_SECONDS (10 * 60)
+
+/**
+ * @def DB_BACKUP_NAME_LEN
+ * @brief Size of the buffers holding a database name (file name without directory and extension)
+ */
+#define DB_BACKUP_NAME_LEN 64
+
+/**
+ * @def DB_BACKUP_PATH_LEN
+ * @brief Size of the buffers holding a backup path
+ */
+#define DB_BACKUP_PATH_LEN 512
+
+/**
+ * @enum db_backup_state
+ * @brief What the backup thread is doing
+ */
+enum db_backup_state {
+    DB_BACKUP_IDLE = 0,    ///< No backup ran yet
+    DB_BACKUP_COPYING,     ///< Copying the pages of a database
+    DB_BACKUP_COMPRESSING, ///< Compressing the copy of a database
+    DB_BACKUP_DONE,        ///< Last backup completed
+    DB_BACKUP_FAILED,      ///< Last backup failed or was canceled, see message
+};
+
+/**
+ * @struct db_backup_config
+ * @brief Where and how often to back up
+ */
+struct db_backup_config {
+    const char *dir;  ///< Backup directory, created if missing
+    int generations;  ///< Backups kept per database, 0 keeps all
+    int64_t interval; ///< Seconds between scheduled backups, 0 for manual backups only
+    bool compress;    ///< Write gzip-compressed backups
+};
+
+/**
+ * @struct db_backup_status
+ * @brief Snapshot of the progress, for display
+ */
+struct db_backup_status {
+    enum db_backup_state state;       ///< Current state
+    int database;                     ///< Index of the database being copied
+    int databases;                    ///< Databases registered
+    char name[DB_BACKUP_NAME_LEN];    ///< Name of the database being copied
+    int pages_done;                   ///< Pages of it copied so far
+    int pages_total;                  ///< Pages it has
+    int64_t bytes_done;               ///< Bytes of its copy compressed so far
+    int64_t bytes_total;              ///< Bytes of its copy
+    float progress;                   ///< Whole backup done, 0 to 1
+    time_t last_success;              ///< End of the last complete backup, 0 if none
+    time_t next_due;                  ///< Next scheduled backup, 0 if not scheduled
+    char message[DB_BACKUP_PATH_LEN]; ///< Error of the last failed backup
+};
+
+/**
+ * @struct db_backup
+ * @brief Opaque backup manager
+ */
+struct db_backup;
+
+/**
+ * @brief Creates a backup manager
+ *
+ * The first scheduled backup is due one interval after the backups already in the directory
+ * (see db_backup_add()), at once if there are none.
+ *
+ * @param[in] config Directory and schedule (dir is copied)
+ * @return Manager, NULL on failure (directory not creatable, allocation)
+ */
+struct db_backup *db_backup_create(const struct db_backup_config *config);
+
+/**
+ * @brief Registers a database to back up
+ *
+ * The database must stay open until db_backup_free(). Its name is its file name without
+ * directory and extension. The oldest of the newest backups of the registered databases counts
+ * as the last complete backup.
+ *
+ * @param[in,out] backup Manager, no backup running
+ * @param[in] db Pointer to initialized database, on a file
+ * @return SQLITE_OK on success, SQLITE_MISUSE if it has no file, SQLITE_FULL if
+ *         DB_BACKUP_MAX_DATABASES are registered, SQLITE_BUSY if a backup is running
+ */
+int db_backup_add(struct db_backup *backup, database *db);
+
+/**
+ * @brief Starts a backup of every registered database on the background thread
+ *
+ * @param[in,out] backup Manager
+ * @return true if started, false if one is already running or the thread could not start
+ */
+bool db_backup_start(struct db_backup *backup);
+
+/**
+ * @brief Starts a scheduled backup when due and reaps a finished one, call it every frame
+ *
+ * @param[in,out] backup Manager, may be NULL
+ * @param[in] now Current time
+ */
+void db_backup_tick(struct db_backup *backup, time_t now);
+
+/**
+ * @brief Whether a backup is running
+ *
+ * @param[in] backup Manager
+ * @return true while the background thread copies or compresses
+ */
+bool db_backup_running(struct db_backup *backup);
+
+/**
+ * @brief Reads the progress
+ *
+ * @param[in] backup Manager
+ * @param[out] status Snapshot of the progress
+ */
+void db_backup_get_status(struct db_backup *backup, struct db_backup_status *status);
+
+/**
+ * @brief Waits for the running backup, if any, to finish
+ *
+ * @param[in,out] backup Manager
+ * @return SQLITE_OK if the last backup completed, its error otherwise
+ */
+int db_backup_wait(struct db_backup *backup);
+
+/**
+ * @brief Cancels the running backup, waits for the thread and frees the manager
+ *
+ * Call it before closing the registered databases. The partial files of a canceled backup are
+ * deleted.
+ *
+ * @param[in] backup Manager, may be NULL
+ */
+void db_backup_free(struct db_backup *backup);
+
+#endif // DB_BACKUP_H
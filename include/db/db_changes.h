@@ -0,0 +1,258 @@
+/**
+ * @file db_changes.h
+ * @brief In-Process Change Notifications
+ *
+ * Tells the screens which rows changed, so they patch what they show instead of reloading
+ * whole tables or showing stale data.
+ *
+ * db_init() installs an update, a commit and a rollback hook on every connection it opens:
+ *
+ * - the update hook stages each (table, operation, rowid) the connection writes, on the
+ *   thread that writes it;
+ *
+ * - the commit hook publishes the staged changes, the rollback hook drops them: a screen only
+ *   ever hears about committed rows;
+ *
+ * - db_changes_dispatch(), called every frame on the main thread, delivers the published
+ *   changes to the subscribers of their table.
+ *
+ * A row changed several times between two dispatches is delivered once, with its last
+ * operation. A table with more than DB_CHANGES_MAX_ROWS changed rows (a bulk import, a
+ * generated data set) is delivered as a single DB_CHANGE_RESET: reloading it is cheaper than
+ * patching that many rows. Changes to tables nobody subscribed to are not kept.
+ *
+ * SQLite does not call the update hook for WITHOUT ROWID tables: db_changes_track() adds
+ * temporary triggers on the connection publishing their changes by key instead. Writes sent to
+ * a database server are published by the client with db_changes_publish().
+ *
+ * Other processes sharing the files (a second terminal) do not run these hooks. The tables
+ * given to db_changes_stamp() carry a modification stamp instead: the writes of resident_db and
+ * foodbatch_db set Changed to one past the highest stamp of the table (DB_CHANGES_STAMP()), and
+ * a trigger leaves a tombstone in DeletedRow for each deleted row.
+ *
+ * db_changes_poll() checks PRAGMA data_version on the connections of the tables given to
+ * db_changes_watch(): it only moves when another connection committed to the file, so a poll
+ * finding nothing is a single cached statement per connection. When it moved, the rows and
+ * tombstones stamped past the watermark of each watched table are published as inserts, updates
+ * and deletes, and the watermark moves up. A table is only reset when its watermark cannot be
+ * trusted: the stamps went below it (the file was replaced), it is more than DB_CHANGES_MAX_ROWS
+ * stamps behind (the tombstones are pruned past that), or rows were written without a stamp.
+ */
+
+#ifndef DB_CHANGES_H
+#define DB_CHANGES_H
+
+#include <stdint.h>
+
+#include <external/sqlite3/sqlite3.h>
+
+#include "db/db_manager.h"
+
+/**
+ * @def DB_CHANGES_MAX_ROWS
+ * @brief Changed rows kept per table between two dispatches, beyond them the table is reset
+ */
+#define DB_CHANGES_MAX_ROWS 1024
+
+/**
+ * @def DB_CHANGES_MAX_SUBSCRIBERS
+ * @brief Most subscriptions at once
+ */
+#define DB_CHANGES_MAX_SUBSCRIBERS 32
+
+/**
+ * @def DB_CHANGES_TABLE_LEN
+ * @brief Size of the buffers holding a table name, longer names are not tracked
+ */
+#define DB_CHANGES_TABLE_LEN 64
+
+/**
+ * @def DB_CHANGES_MAX_WATCHED
+ * @brief Most tables db_changes_poll() watches
+ */
+#define DB_CHANGES_MAX_WATCHED 8
+
+/**
+ * @def DB_CHANGES_STAMP
+ * @brief SQL expression of the stamp of a write to a table of db_changes_stamp()
+ *
+ * One past the highest stamp of its rows and tombstones, the same for every row of a statement.
+ * Inserts set Changed to it. Updates set Changed to it with DB_CHANGES_RESTAMP(), which first
+ * keeps the stamp of the insert in Created: a row with Created NULL was never updated.
+ */
+#define DB_CHANGES_STAMP(table)                                                                 \
+    "(SELECT ifnull(max(Changed), 0) + 1 FROM (SELECT max(Changed) AS Changed FROM " table     \
+    " UNION ALL SELECT max(Changed) FROM DeletedRow WHERE TableName = '" table "'))"
+
+/**
+ * @def DB_CHANGES_RESTAMP
+ * @brief SET clause stamping the rows an UPDATE of a table of db_changes_stamp() changes
+ */
+#define DB_CHANGES_RESTAMP(table) "Created = ifnull(Created, Changed), Changed = " DB_CHANGES_STAMP(table)
+
+/**
+ * @def DB_CHANGES_POLL_NS
+ * @brief Least time between two polls of the watched connections
+ */
+#define DB_CHANGES_POLL_NS (100 * 1000000LL)
+
+/**
+ * @enum db_change_op
+ * @brief What happened to a row
+ */
+enum db_change_op {
+    DB_CHANGE_RESET = 0,              ///< Too many rows changed, anything of the table may be stale
+    DB_CHANGE_INSERT = SQLITE_INSERT, ///< Row added
+    DB_CHANGE_UPDATE = SQLITE_UPDATE, ///< Row modified
+    DB_CHANGE_DELETE = SQLITE_DELETE, ///< Row removed
+};
+
+/**
+ * @struct db_change
+ * @brief One committed change, as delivered to subscribers
+ */
+struct db_change {
+    sqlite3 *db;          ///< Connection that wrote it, only to compare (it may be closed by now)
+    const char *table;    ///< Table name, as the connection spelled it
+    enum db_change_op op; ///< Operation
+    int64_t rowid;        ///< Row changed (its INTEGER PRIMARY KEY, or key of db_changes_track()), 0 on reset
+};
+
+/**
+ * @brief Receives the changes of a subscribed table
+ *
+ * Called from db_changes_dispatch() on the main thread. It may read the databases but
+ * should only note what to refresh, the caller renders afterwards.
+ *
+ * @param[in] change Change, valid for the duration of the call
+ * @param[in] ctx Pointer given to db_changes_subscribe()
+ */
+typedef void (*db_change_fn)(const struct db_change *change, void *ctx);
+
+/**
+ * @struct db_change_log
+ * @brief Opaque changes staged by a connection and not committed yet
+ */
+struct db_change_log;
+
+/**
+ * @brief Subscribes to the changes of a table, main thread only
+ *
+ * @param[in] table Table name, compared case-insensitively
+ * @param[in] fn Callback
+ * @param[in] ctx Passed to fn
+ * @return Subscription id (> 0) for db_changes_unsubscribe(), 0 if DB_CHANGES_MAX_SUBSCRIBERS
+ *         are taken or the name is too long
+ */
+int db_changes_subscribe(const char *table, db_change_fn fn, void *ctx);
+
+/**
+ * @brief Ends a subscription, main thread only
+ *
+ * Nothing is delivered to it afterwards, even changes already published.
+ *
+ * @param[in] id Id returned by db_changes_subscribe(), 0 is ignored
+ */
+void db_changes_unsubscribe(int id);
+
+/**
+ * @brief Delivers the changes committed since the last call, call it every frame
+ *
+ * Main thread only. Changes committed while it runs are delivered by the next call.
+ *
+ * @return Number of changes delivered
+ */
+int db_changes_dispatch(void);
+
+/**
+ * @brief Publishes a committed change the hooks did not see, from any thread
+ *
+ * For writes a database server committed on behalf of this process (db_client.h), delivered
+ * by the next db_changes_dispatch() like a local commit.
+ *
+ * @param[in] table Table name
+ * @param[in] op Operation, DB_CHANGE_RESET when anything of the table may have changed
+ * @param[in] rowid Row changed, ignored on reset
+ */
+void db_changes_publish(const char *table, enum db_change_op op, int64_t rowid);
+
+/**
+ * @brief Publishes the changes of a WITHOUT ROWID table keyed by an integer column
+ *
+ * Creates temporary AFTER INSERT, UPDATE and DELETE triggers on the connection, they
+ * disappear with it (or when the table is dropped, call it after the migrations). An update
+ * changing the key is published as the delete of the old key and the insert of the new one.
+ *
+ * @param[in] db Pointer to initialized database
+ * @param[in] table Table name
+ * @param[in] key Integer column identifying the rows, published as the rowid
+ * @return SQLITE_OK on success, SQLite error code on failure
+ */
+int db_changes_track(database *db, const char *table, const char *key);
+
+/**
+ * @brief Adds the modification stamp to a table, so other processes see which rows changed
+ *
+ * Adds the Created and Changed columns (existing rows get stamp 0) and the index on Changed,
+ * creates DeletedRow and the trigger keeping a tombstone of each deleted row. Tombstones more
+ * than DB_CHANGES_MAX_ROWS stamps old are pruned. Call it after the migrations rebuilding the
+ * table, the writes must then stamp their rows (DB_CHANGES_STAMP(), DB_CHANGES_RESTAMP()).
+ *
+ * @param[in] db Pointer to initialized database
+ * @param[in] table Table name
+ * @param[in] key Integer column identifying the rows, published as the rowid
+ * @return SQLITE_OK on success, SQLite error code on failure
+ */
+int db_changes_stamp(database *db, const char *table, const char *key);
+
+/**
+ * @brief Publishes the rows other connections change in a table, main thread only
+ *
+ * Adds the table to the ones db_changes_poll() watches, its watermark starts at the highest
+ * stamp: commits made before the call are not published.
+ *
+ * @param[in] db Pointer to initialized database holding the table
+ * @param[in] table Table name given to db_changes_stamp(), as the subscribers spell it
+ * @param[in] key Key column given to db_changes_stamp()
+ * @return SQLITE_OK on success, SQLITE_MISUSE if the changes of db are not published or the name
+ *         is too long, SQLITE_FULL if DB_CHANGES_MAX_WATCHED tables are watched, SQLite error
+ *         code on failure (a table without the stamp)
+ */
+int db_changes_watch(database *db, const char *table, const char *key);
+
+/**
+ * @brief Publishes the rows of the watched tables other connections committed, call it every
+ *        frame before db_changes_dispatch()
+ *
+ * Main thread only. Does nothing until DB_CHANGES_POLL_NS passed since the last poll, and skips
+ * the connections another thread is using. Rows this process wrote since the last poll that
+ * found a commit of another connection may be published again, which only refreshes them twice.
+ *
+ * @param[in] now_ns Monotonic time (perf_now_ns())
+ * @return Number of subscribed tables with changes published
+ */
+int db_changes_poll(int64_t now_ns);
+
+/**
+ * @brief Installs the hooks publishing the changes of a connection
+ *
+ * Called by db_init().
+ *
+ * @param[in] db SQLite connection
+ * @return Staging area of the connection for db_changes_detach(), NULL on allocation failure
+ *         (the connection works, its changes are not published)
+ */
+struct db_change_log *db_changes_attach(sqlite3 *db);
+
+/**
+ * @brief Removes the hooks of a connection and frees its staging area
+ *
+ * Called by db_deinit() before closing the connection, also stops watching it. Changes it
+ * already published are still delivered.
+ *
+ * @param[in] db SQLite connection
+ * @param[in] log Staging area returned by db_changes_attach(), may be NULL
+ */
+void db_changes_detach(sqlite3 *db, struct db_change_log *log);
+
+#endif // DB_CHANGES_H
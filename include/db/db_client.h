@@ -0,0 +1,215 @@
+/**
+ * @file db_client.h
+ * @brief Client Backend of the Database Server
+ *
+ * Lets the application use a database server (db_server.h) instead of opening the files
+ * itself. A database attached to a client has no connection: resident_db_*, foodbatch_db_*
+ * and user_db_* check db_is_remote() first and call the function of the same name below,
+ * which sends the call to the server and decodes what it returned. The screens do not change.
+ *
+ * A client is one socket with one call in flight, shared by every attached database and safe
+ * to use from several threads (the calls queue on a mutex). When the server goes away the
+ * calls fail with SQLITE_IOERR (false, -1 or AUTH_FAILURE for the functions returning those),
+ * and the next call tries to connect again.
+ *
+ * The range queries (*_between) and the batches in stock arrive in pages, their callbacks run
+ * between two pages with the connection free, so they may call the server too.
+ *
+ * Resident and food batch writes the server committed are published to the change subscribers
+ * of this process (db_changes_publish()), writes of other clients are not.
+ *
+ * Searches run on the server and come back in one reply. A distribution plan is built here from
+ * the batches in stock and applied by the server in one transaction. What only runs on a local
+ * connection (the trigram duplicate index, backups) is not available through a client. Linux only.
+ */
+
+#ifndef DB_CLIENT_H
+#define DB_CLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "db/food_distribution.h"
+#include "db/foodbatch_db.h"
+#include "db/resident_db.h"
+#include "db/user_db.h"
+#include "entities/foodbatch.h"
+#include "entities/resident.h"
+#include "entities/user.h"
+
+/**
+ * @def DB_CLIENT_PRINT_BYTES
+ * @brief Largest table the *_get_all() printers ask the server for
+ */
+#define DB_CLIENT_PRINT_BYTES (1024 * 1024)
+
+/**
+ * @struct db_client
+ * @brief Opaque connection to a database server
+ */
+struct db_client;
+
+/**
+ * @brief Connects to a server and checks it speaks DB_PROTOCOL_VERSION
+ *
+ * @param[in] socket_path Path of the server's Unix domain socket
+ * @return Client, NULL if the server is not there, speaks another version or on allocation
+ *         failure (printed on stderr)
+ */
+struct db_client *db_client_connect(const char *socket_path);
+
+/**
+ * @brief Forwards the calls on a database to the server
+ *
+ * The database must not be open, db_deinit() detaches it again.
+ *
+ * @param[in] client Client, must outlive the database
+ * @param[out] db Database structure, cleared and attached
+ */
+void db_client_attach(struct db_client *client, database *db);
+
+/**
+ * @brief Whether the last call reached the server
+ *
+ * @param[in] client Client
+ * @return false after the connection broke, until a call connects again
+ */
+bool db_client_connected(struct db_client *client);
+
+/**
+ * @brief Closes the connection and frees the client
+ *
+ * Detach (db_deinit()) the databases attached to it first.
+ *
+ * @param[in] client Client, may be NULL
+ */
+void db_client_close(struct db_client *client);
+
+/* Forwarded calls, same arguments and results as the functions they are named after */
+
+int db_client_resident_insert(
+    struct db_client *client,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender
+);
+int db_client_resident_find_duplicates(
+    struct db_client *client,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+);
+int db_client_resident_insert_checked(
+    struct db_client *client,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender,
+    float threshold,
+    struct resident_duplicate *duplicates,
+    int max,
+    int *duplicate_count
+);
+int db_client_resident_update(
+    struct db_client *client,
+    const char *cpf,
+    const char *name_input,
+    int age_input,
+    const char *health_status_input,
+    const char *needs_input,
+    int medical_assistance_input,
+    int gender_input
+);
+int db_client_resident_delete_by_cpf(struct db_client *client, const char *cpf);
+bool db_client_resident_check_cpf_exists(struct db_client *client, const char *cpf);
+int db_client_resident_get_by_cpf(struct db_client *client, const char *cpf, struct resident *resident);
+int db_client_resident_get_count(struct db_client *client);
+int db_client_resident_entered_between(
+    struct db_client *client,
+    int32_t from_day,
+    int32_t to_day,
+    resident_callback callback,
+    void *ctx
+);
+int db_client_resident_search(
+    struct db_client *client,
+    const char *query,
+    int limit,
+    resident_callback callback,
+    void *ctx
+);
+int db_client_resident_get_all_format(struct db_client *client, char *buffer, size_t buffer_size);
+int db_client_resident_get_format_by_cpf(struct db_client *client, const char *cpf, char *buffer, size_t buffer_size);
+int db_client_resident_get_all(struct db_client *client);
+
+int db_client_foodbatch_insert(
+    struct db_client *client,
+    int batch_id,
+    const char *name,
+    int quantity,
+    bool is_perishable,
+    const char *expiration_date,
+    float daily_consumption_rate
+);
+int db_client_foodbatch_update(
+    struct db_client *client,
+    int batch_id,
+    const char *name_input,
+    int quantity_input,
+    bool is_perishable_input,
+    const char *expiration_date_input,
+    float daily_consumption_rate_input
+);
+int db_client_foodbatch_take_quantity(struct db_client *client, int batch_id, int amount);
+int db_client_foodbatch_delete_by_id(struct db_client *client, int batch_id);
+bool db_client_foodbatch_check_batchid_exists(struct db_client *client, int batch_id);
+int db_client_foodbatch_get_by_batchid(struct db_client *client, int batch_id, struct foodbatch *foodbatch);
+int db_client_foodbatch_get_count(struct db_client *client);
+int db_client_foodbatch_expiring_between(
+    struct db_client *client,
+    int32_t from_day,
+    int32_t to_day,
+    foodbatch_callback callback,
+    void *ctx
+);
+int db_client_foodbatch_in_stock(struct db_client *client, foodbatch_callback callback, void *ctx);
+int db_client_foodbatch_get_all_format(struct db_client *client, char *buffer, size_t buffer_size);
+int db_client_foodbatch_get_format_by_batchid(struct db_client *client, int batch_id, char *buffer, size_t buffer_size);
+int db_client_foodbatch_get_all(struct db_client *client);
+int db_client_food_plan_apply(struct db_client *client, const struct food_plan *plan);
+
+int db_client_user_create_user(
+    struct db_client *client,
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    bool is_admin
+);
+int db_client_user_delete(struct db_client *client, const char *username);
+int db_client_user_update_phone_number(struct db_client *client, const char *username, const char *phone_number);
+int db_client_user_update_cpf(struct db_client *client, const char *username, const char *cpf);
+int db_client_user_update_password(struct db_client *client, const char *username, const char *new_password);
+int db_client_user_update_admin_status(struct db_client *client, const char *username, bool is_admin);
+int db_client_user_update_username(struct db_client *client, const char *old_username, const char *new_username);
+int db_client_user_set_reset_password(struct db_client *client, const char *username);
+bool db_client_user_check_cpf_exists(struct db_client *client, const char *cpf);
+bool db_client_user_check_exists(struct db_client *client, const char *username);
+bool db_client_user_check_admin_status(struct db_client *client, const char *username);
+int db_client_user_get_by_username(struct db_client *client, const char *username, struct user *user_out);
+int db_client_user_get_count(struct db_client *client);
+int db_client_user_get_all_format(struct db_client *client, char *buffer, size_t buffer_size);
+int db_client_user_get_all(struct db_client *client);
+enum auth_result db_client_user_authenticate(struct db_client *client, const char *username, const char *password);
+
+#endif // DB_CLIENT_H
@@ -0,0 +1,184 @@
+/**
+ * @file db_maintenance.h
+ * @brief Idle-Time Database Maintenance
+ *
+ * Keeps the database files compact and the query plans fresh by doing the upkeep nothing else
+ * does, while nobody is using the app. Once the user has been idle for a while a background
+ * thread goes through every registered database:
+ *
+ * - optimize: PRAGMA optimize in debug mode lists the tables whose statistics are missing or
+ *   stale, each is then analyzed on its own with PRAGMA analysis_limit bounding the rows read;
+ *
+ * - incremental vacuum: PRAGMA incremental_vacuum gives the free pages back to the file system
+ *   a few at a time, on databases created with auto_vacuum = INCREMENTAL (db_init_with_tbl()
+ *   sets it on new files). A file created without it is converted once with a VACUUM, the
+ *   only way the setting changes on a file that has tables (`dbtool maintain` does the same);
+ *
+ * - checkpoint: a passive WAL checkpoint, on databases in WAL mode.
+ *
+ * Each statement is a short slice of work. The first input the main loop reports makes a
+ * progress handler abort the running one, and the pass resumes from the task it stopped at the
+ * next time the user is idle. Every task is logged on stdout with its time and the pages it
+ * reclaimed.
+ */
+
+#ifndef DB_MAINTENANCE_H
+#define DB_MAINTENANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+
+/**
+ * @def DB_MAINTENANCE_MAX_DATABASES
+ * @brief Most databases a scheduler maintains
+ */
+#define DB_MAINTENANCE_MAX_DATABASES 8
+
+/**
+ * @def DB_MAINTENANCE_IDLE_NS
+ * @brief Time without input before maintenance starts, when db_maintenance_config.idle_ns is not set
+ */
+#define DB_MAINTENANCE_IDLE_NS (60 * 1000000000LL)
+
+/**
+ * @def DB_MAINTENANCE_INTERVAL_NS
+ * @brief Time between two complete passes, when db_maintenance_config.interval_ns is not set
+ */
+#define DB_MAINTENANCE_INTERVAL_NS (60 * 60 * 1000000000LL)
+
+/**
+ * @def DB_MAINTENANCE_VACUUM_PAGES
+ * @brief Pages freed per incremental vacuum slice, when db_maintenance_config.vacuum_pages is not set
+ */
+#define DB_MAINTENANCE_VACUUM_PAGES 256
+
+/**
+ * @def DB_MAINTENANCE_ANALYSIS_LIMIT
+ * @brief Rows ANALYZE reads per index, when db_maintenance_config.analysis_limit is not set
+ */
+#define DB_MAINTENANCE_ANALYSIS_LIMIT 1000
+
+/**
+ * @def DB_MAINTENANCE_PROGRESS_OPS
+ * @brief Virtual machine instructions between two checks for an abort
+ */
+#define DB_MAINTENANCE_PROGRESS_OPS 1000
+
+/**
+ * @def DB_MAINTENANCE_NAME_LEN
+ * @brief Size of the buffer holding a database name
+ */
+#define DB_MAINTENANCE_NAME_LEN 64
+
+/**
+ * @enum db_maintenance_task
+ * @brief Tasks of a pass, in the order they run on each database
+ */
+enum db_maintenance_task {
+    DB_MAINTENANCE_OPTIMIZE = 0, ///< Analyze the tables with stale statistics
+    DB_MAINTENANCE_VACUUM,       ///< Give free pages back to the file system
+    DB_MAINTENANCE_CHECKPOINT,   ///< Copy the WAL back into the database
+    DB_MAINTENANCE_TASKS,        ///< Number of tasks
+};
+
+/**
+ * @struct db_maintenance_config
+ * @brief When and how much to do, zero-initialize for the defaults
+ */
+struct db_maintenance_config {
+    int64_t idle_ns;     ///< Time without input before starting, 0 for DB_MAINTENANCE_IDLE_NS
+    int64_t interval_ns; ///< Time between complete passes, 0 for DB_MAINTENANCE_INTERVAL_NS
+    int vacuum_pages;    ///< Pages per vacuum slice, 0 for DB_MAINTENANCE_VACUUM_PAGES
+    int analysis_limit;  ///< ANALYZE rows per index, 0 for DB_MAINTENANCE_ANALYSIS_LIMIT
+};
+
+/**
+ * @struct db_maintenance_stats
+ * @brief Totals since the scheduler was created
+ */
+struct db_maintenance_stats {
+    uint64_t passes;                        ///< Complete passes over every database
+    uint64_t aborts;                        ///< Tasks aborted by input
+    uint64_t tables_analyzed;               ///< Tables analyzed
+    int64_t pages_reclaimed;                ///< Pages the incremental vacuum gave back
+    uint64_t databases_converted;           ///< Databases turned over to incremental auto_vacuum
+    int64_t frames_checkpointed;            ///< WAL frames copied back
+    uint64_t task_ns[DB_MAINTENANCE_TASKS]; ///< Time spent in each task, all databases
+};
+
+/**
+ * @struct db_maintenance
+ * @brief Opaque maintenance scheduler
+ */
+struct db_maintenance;
+
+/**
+ * @brief Creates a scheduler, the first pass is due as soon as the user is idle
+ *
+ * @param[in] config Timing and slice sizes, NULL for the defaults
+ * @return Scheduler, NULL on allocation failure
+ */
+struct db_maintenance *db_maintenance_create(const struct db_maintenance_config *config);
+
+/**
+ * @brief Registers a database to maintain
+ *
+ * The database must stay open until db_maintenance_free().
+ *
+ * @param[in,out] maintenance Scheduler, not running
+ * @param[in] db Pointer to initialized database
+ * @param[in] name Name used in the log
+ * @return SQLITE_OK on success, SQLITE_MISUSE if db is not initialized, SQLITE_FULL if
+ *         DB_MAINTENANCE_MAX_DATABASES are registered, SQLITE_BUSY if a pass is running
+ */
+int db_maintenance_add(struct db_maintenance *maintenance, database *db, const char *name);
+
+/**
+ * @brief Aborts on input, starts or resumes a pass once idle, call it every frame
+ *
+ * Call it before the screens use the databases: when it returns after an input, the
+ * maintenance thread has stopped.
+ *
+ * @param[in,out] maintenance Scheduler, may be NULL
+ * @param[in] input Whether the user did anything this frame
+ * @param[in] now_ns Monotonic time (perf_now_ns())
+ */
+void db_maintenance_tick(struct db_maintenance *maintenance, bool input, int64_t now_ns);
+
+/**
+ * @brief Whether the maintenance thread is working
+ *
+ * @param[in] maintenance Scheduler
+ * @return true while a pass runs
+ */
+bool db_maintenance_running(struct db_maintenance *maintenance);
+
+/**
+ * @brief Waits for the running pass, if any, to finish
+ *
+ * @param[in,out] maintenance Scheduler
+ * @return SQLITE_OK if the last pass completed, SQLITE_INTERRUPT if it was aborted, SQLite error
+ *         code of the first failed task otherwise
+ */
+int db_maintenance_wait(struct db_maintenance *maintenance);
+
+/**
+ * @brief Reads the totals
+ *
+ * @param[in] maintenance Scheduler
+ * @param[out] stats Totals since creation
+ */
+void db_maintenance_get_stats(struct db_maintenance *maintenance, struct db_maintenance_stats *stats);
+
+/**
+ * @brief Aborts the running pass, waits for the thread and frees the scheduler
+ *
+ * Call it before closing the registered databases.
+ *
+ * @param[in] maintenance Scheduler, may be NULL
+ */
+void db_maintenance_free(struct db_maintenance *maintenance);
+
+#endif // DB_MAINTENANCE_H
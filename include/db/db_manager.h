@@ -10,22 +10,66 @@
 #define DB_MANAGER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <external/sqlite3/sqlite3.h>
 
+/**
+ * @struct db_pool
+ * @brief Opaque set of read-only connections to the file of a database (see db_pool_open())
+ */
+struct db_pool;
+
+/**
+ * @struct db_change_log
+ * @brief Opaque changes a connection staged and did not commit yet (see db_changes.h)
+ */
+struct db_change_log;
+
+/**
+ * @struct db_client
+ * @brief Opaque connection to a database server (see db_client.h)
+ */
+struct db_client;
+
 /**
  * @struct database
  * @brief Represents a SQLite3 database connection.
+ *
+ * db is the writer: every function taking a database uses it, from any thread (SQLite
+ * serializes the calls). Once db_pool_open() was called, the resident, food batch and user
+ * reads check out a pooled reader instead: they run on other cores alongside the writer and
+ * see the last commit, not the writes of a transaction open on the writer (see db_writer()).
+ *
+ * A database attached to a server with db_client_attach() has no connection of its own: the
+ * resident, food batch and user functions forward their calls to the server instead.
  */
 typedef struct database {
-    sqlite3 *db; ///< Internal SQLite3 database handle.
+    sqlite3 *db;                   ///< Internal SQLite3 database handle.
+    struct db_pool *pool;          ///< Read-only connections, NULL until db_pool_open()
+    struct db_change_log *changes; ///< Writes staged for the change notifications (db_changes.h)
+    struct db_client *remote;      ///< Server the calls are forwarded to, NULL for a local file
 } database;
 
+/**
+ * @def DB_POOL_MAX_READERS
+ * @brief Most read-only connections a pool holds
+ */
+#define DB_POOL_MAX_READERS 16
+
+/**
+ * @def DB_POOL_BUSY_TIMEOUT_MS
+ * @brief How long a pooled reader waits on a lock (a checkpoint, a schema change) before failing
+ */
+#define DB_POOL_BUSY_TIMEOUT_MS 1000
+
 /**
  * @brief Initializes a database connection.
  *
  * Opens an SQLite3 database file. If the file doesn't exist, it will be created.
- * On failure, prints an error message to `stderr`.
+ * On failure, prints an error message to `stderr`. The connection is profiled when
+ * db_profile_enable() or db_profile_track_time() was called before (see db_profile.h), and
+ * the rows it commits are published to the change subscribers (see db_changes.h).
  *
  * @param[out] db Pointer to the database structure to initialize.
  * @param[in] filename Path to the SQLite3 database file.
@@ -59,14 +103,151 @@ int db_init_with_tbl(database *db, const char *filename, int (*create_table)(dat
  */
 bool db_is_init(database *db);
 
+/**
+ * @brief Checks if the calls on a database are forwarded to a server.
+ *
+ * @param[in] db Pointer to the database structure, may be NULL.
+ * @return `true` if `db->remote` is non-NULL (see db_client_attach()), `false` otherwise.
+ */
+bool db_is_remote(database *db);
+
 /**
  * @brief Closes the database connection and resets the handle.
  *
- * Safely deinitializes the database. If `db->db` is NULL, this is a no-op.
+ * Safely deinitializes the database. If `db->db` is NULL, this is a no-op. The readers
+ * of its pool are closed first (none may be checked out). A database attached to a server is
+ * only detached from it, the client stays open (see db_client_close()).
  *
  * @param[in] db Pointer to the database structure.
  * @warning After calling this, `db->db` will be NULL and must be reinitialized.
  */
 void db_deinit(database *db);
 
+/**
+ * @brief Opens read-only connections next to the writer
+ *
+ * Switches the file to WAL journaling, where readers see the last commit without waiting
+ * for the writer and the writer does not wait for them. Then opens the readers with
+ * SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX: each is used by one thread at a time, checked
+ * out with db_pool_acquire(), so SQLite's own locking is not needed. The pool is closed by
+ * db_deinit().
+ *
+ * @param[in,out] db Pointer to the database structure, opened on a file.
+ * @param[in] readers Read-only connections to open (1 to DB_POOL_MAX_READERS).
+ * @return SQLITE_OK on success, SQLite error code on failure (db is left without a pool).
+ * @note WAL mode stays on the file, with its -wal and -shm companions while it is open.
+ */
+int db_pool_open(database *db, int readers);
+
+/**
+ * @brief Checks out a read-only connection for the calling thread
+ *
+ * Blocks while every reader is checked out. A thread gets back the reader it used last
+ * when it is free, whose page cache already holds what that thread reads. Without a pool,
+ * and instead of waiting when the thread holds a reader already (a read called from the
+ * callback of another would wait on itself), the reader is the writer connection, so code
+ * reading through the pool works either way.
+ *
+ * @param[in] db Pointer to the database structure.
+ * @param[out] reader Connection to pass to the usual database functions, read-only when
+ *                    it comes from the pool. Give it back with db_pool_release().
+ * @return SQLITE_OK on success, SQLITE_ERROR if db is not initialized.
+ * @warning Only run reads on reader, and only from the thread that checked it out.
+ */
+int db_pool_acquire(database *db, database *reader);
+
+/**
+ * @brief Gives back a connection from db_pool_acquire()
+ *
+ * @param[in] db Pointer to the database structure the reader was checked out from.
+ * @param[in,out] reader Connection to give back, cleared.
+ * @warning Finalize the statements prepared on reader before giving it back.
+ */
+void db_pool_release(database *db, database *reader);
+
+/**
+ * @brief The writer of a database, without its pool
+ *
+ * The resident, food batch and user reads called on it run on the writer connection, so they
+ * see the writes of the transaction open on it. Writes checking the rows they change and
+ * imports checking the rows of their own batch read through it.
+ *
+ * @param[in] db Pointer to the database structure.
+ * @return Copy of db with no pool, use it while db is open.
+ */
+database db_writer(database *db);
+
+/**
+ * @brief Number of read-only connections of a database
+ *
+ * @param[in] db Pointer to the database structure.
+ * @return Readers in the pool, 0 without a pool.
+ */
+int db_pool_readers(database *db);
+
+/**
+ * @brief Checks if a table has a column, optionally of a given declared type
+ *
+ * Used by the create_table functions to detect schemas from older versions of the app.
+ *
+ * @param[in] db Pointer to the database structure.
+ * @param[in] table Table name.
+ * @param[in] column Column name.
+ * @param[in] type Declared type to match exactly (e.g. "TEXT"), or NULL to match any type.
+ * @return `true` if the column exists (with that type), `false` otherwise or on error.
+ */
+bool db_table_has_column(database *db, const char *table, const char *column, const char *type);
+
+/**
+ * @brief Rebuilds a table with a new schema, copying its rows in one transaction
+ *
+ * Renames the table, runs create_sql to create the new one under the original name, copies
+ * the rows with `INSERT INTO table (columns) SELECT select_list`, then drops the old table.
+ * Use it for changes ALTER TABLE cannot do (column types, primary key, WITHOUT ROWID).
+ *
+ * @param[in] db Pointer to the database structure.
+ * @param[in] table Name of the table to rebuild.
+ * @param[in] create_sql Statement(s) creating the new table, terminated with ';'.
+ * @param[in] columns Comma separated destination columns.
+ * @param[in] select_list Comma separated expressions over the old columns, one per destination column.
+ * @return SQLITE_OK on success, SQLite error code on failure (the transaction is rolled back).
+ * @warning Indexes and triggers of the old table are dropped, recreate them afterwards.
+ */
+int db_rebuild_table(
+    database *db,
+    const char *table,
+    const char *create_sql,
+    const char *columns,
+    const char *select_list
+);
+
+/**
+ * @brief Reads a day number column (days since 1970-01-01)
+ *
+ * @param[in] stmt Statement positioned on a row.
+ * @param[in] col Column index.
+ * @return The day number, or DATE_INVALID if the column is NULL.
+ */
+int32_t db_column_day(sqlite3_stmt *stmt, int col);
+
+/**
+ * @brief Binds a day number parameter (days since 1970-01-01)
+ *
+ * @param[in] stmt Prepared statement.
+ * @param[in] index Parameter index (1 based).
+ * @param[in] day Day number, DATE_INVALID binds NULL.
+ * @return Result of the sqlite3_bind_* call.
+ */
+int db_bind_day(sqlite3_stmt *stmt, int index, int32_t day);
+
+/**
+ * @def DB_TEXT_DATE_TO_DAYS(column)
+ * @brief SQL expression converting a "YYYY-MM-DD" text column to a day number, for migrations
+ *
+ * Values that are already integers are kept, invalid text becomes NULL.
+ */
+#define DB_TEXT_DATE_TO_DAYS(column)                                                                   \
+    "CASE WHEN typeof(" column ") = 'text' THEN CAST(julianday(" column ") - 2440587.5 AS INTEGER) " \
+    "ELSE " column " END"
+
 #endif // DB_MANAGER_H
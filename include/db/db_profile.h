@@ -0,0 +1,167 @@
+/**
+ * @file db_profile.h
+ * @brief Per-Statement SQL Latency Profiling
+ *
+ * When enabled, every connection opened through db_init() (and the resident search
+ * connection) gets a sqlite3_trace_v2() callback timing each statement run with the monotonic
+ * clock, from its first step to its completion (SQLite's own profile time only counts whole
+ * milliseconds). Each run is added to the entry of its normalized SQL, literals replaced by '?'
+ * so "... WHERE Id = 4" and "... WHERE Id = 5" count as the same statement: call count, total
+ * and worst time, and a latency histogram with four buckets per power of two.
+ *
+ * The entries live in a fixed table claimed and updated with atomics only, so connections on
+ * other threads record without taking a lock. When profiling and time tracking are both
+ * disabled no callback is installed and statements cost nothing extra.
+ *
+ * Time tracking is the cheap half of it, used by the performance overlay: each thread adds up
+ * the time its statements took (db_profile_thread_ns()), nothing is recorded per statement.
+ *
+ * Set the DB_PROFILE environment variable to a file name and call
+ * db_profile_enable_from_env() at startup to profile a whole run, the report is written to
+ * that file on exit.
+ */
+
+#ifndef DB_PROFILE_H
+#define DB_PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <external/sqlite3/sqlite3.h>
+
+/**
+ * @def DB_PROFILE_SQL_LEN
+ * @brief Normalized SQL kept per entry (including null terminator), longer text is cut
+ */
+#define DB_PROFILE_SQL_LEN 256
+
+/**
+ * @def DB_PROFILE_MAX_STATEMENTS
+ * @brief Distinct normalized statements tracked, the rest are counted as dropped
+ */
+#define DB_PROFILE_MAX_STATEMENTS 512
+
+/**
+ * @def DB_PROFILE_BUCKETS
+ * @brief Histogram buckets, four per power of two of nanoseconds, the last one open ended
+ */
+#define DB_PROFILE_BUCKETS 128
+
+/**
+ * @struct db_profile_stat
+ * @brief Figures of one normalized statement
+ */
+struct db_profile_stat {
+    char sql[DB_PROFILE_SQL_LEN];            ///< Normalized SQL
+    uint64_t calls;                          ///< Times the statement ran
+    uint64_t total_ns;                       ///< Time spent in all runs
+    uint64_t max_ns;                         ///< Slowest run
+    uint64_t p50_ns;                         ///< Median, upper bound of its histogram bucket
+    uint64_t p95_ns;                         ///< 95th percentile, upper bound of its histogram bucket
+    uint64_t p99_ns;                         ///< 99th percentile, upper bound of its histogram bucket
+    uint64_t histogram[DB_PROFILE_BUCKETS];  ///< Runs per bucket, see db_profile_bucket_upper_ns()
+};
+
+/**
+ * @brief Turns profiling on or off
+ *
+ * Only connections opened while profiling or time tracking is on have the callback, the
+ * others are never profiled.
+ *
+ * @param[in] enabled Whether statements are profiled
+ */
+void db_profile_enable(bool enabled);
+
+/**
+ * @brief Enables profiling if the DB_PROFILE environment variable names a file
+ *
+ * The report is written to that file when the program exits.
+ *
+ * @return true if profiling was enabled, false otherwise
+ */
+bool db_profile_enable_from_env(void);
+
+/**
+ * @brief Whether new connections are profiled
+ *
+ * @return true if profiling is enabled
+ */
+bool db_profile_is_enabled(void);
+
+/**
+ * @brief Turns time tracking on or off for connections opened from now on
+ *
+ * @param[in] enabled Whether new connections track the time spent in statements
+ */
+void db_profile_track_time(bool enabled);
+
+/**
+ * @brief Time the calling thread spent running statements
+ *
+ * Only counts connections opened while profiling or time tracking was on. Take the difference
+ * of two calls to know the time spent in between, e.g. during a frame.
+ *
+ * @return Nanoseconds, since the thread started
+ */
+uint64_t db_profile_thread_ns(void);
+
+/**
+ * @brief Installs the profiling callback on a connection if profiling or time tracking is on
+ *
+ * @param[in] db SQLite connection
+ */
+void db_profile_attach(sqlite3 *db);
+
+/**
+ * @brief Normalizes a statement the way entries are keyed
+ *
+ * Collapses whitespace and replaces number and string literals by '?'.
+ *
+ * @param[in] sql SQL text
+ * @param[out] out Buffer for the normalized text (may be NULL to only hash)
+ * @param[in] out_size Size of out
+ * @return 64-bit hash of the whole normalized text (never 0), even if out was too small
+ */
+uint64_t db_profile_normalize(const char *sql, char *out, size_t out_size);
+
+/**
+ * @brief Copies the figures of every statement seen, slowest total first
+ *
+ * @param[out] stats Array receiving the figures
+ * @param[in] max Capacity of stats (DB_PROFILE_MAX_STATEMENTS always fits)
+ * @return Number of entries written
+ */
+int db_profile_snapshot(struct db_profile_stat *stats, int max);
+
+/**
+ * @brief Number of statement runs not recorded because the table was full
+ *
+ * @return Dropped runs
+ */
+uint64_t db_profile_dropped(void);
+
+/**
+ * @brief Upper bound of a histogram bucket
+ *
+ * @param[in] bucket Bucket index (0 to DB_PROFILE_BUCKETS - 1)
+ * @return Largest latency counted in the bucket, in nanoseconds (UINT64_MAX for the last one)
+ */
+uint64_t db_profile_bucket_upper_ns(int bucket);
+
+/**
+ * @brief Clears the figures of every statement
+ *
+ * Statements running on other threads during the reset may be partially counted.
+ */
+void db_profile_reset(void);
+
+/**
+ * @brief Writes a report of every statement, slowest total first
+ *
+ * @param[in] path File to write
+ * @return 0 on success, -1 if the file can't be written
+ */
+int db_profile_dump(const char *path);
+
+#endif // DB_PROFILE_H
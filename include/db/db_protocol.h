@@ -0,0 +1,247 @@
+/**
+ * @file db_protocol.h
+ * @brief Binary Protocol Between the Database Server and its Clients
+ *
+ * Messages exchanged over the local socket of db_server.h, written and read by db_client.h.
+ * Every message is a frame: a 32-bit length followed by that many bytes.
+ *
+ * - request: request id (u32), operation (u8, enum db_op), arguments;
+ * - response: request id (u32), result (i32), values.
+ *
+ * The result is what the forwarded function returned (an SQLite code, a count, a bool or an
+ * enum auth_result), values are its output parameters. Integers are little-endian, floats are
+ * sent as IEEE 754 doubles, strings as their length (u32) and bytes without terminator, a NULL
+ * string as length DB_WIRE_NULL. A client sends DB_OP_HELLO first, the server closes the
+ * connection on any frame it cannot decode.
+ *
+ * Paged operations take the first and last day and the rows already received (u32), their
+ * result is the number of rows in the reply, followed by "more pages" (u8).
+ */
+
+#ifndef DB_PROTOCOL_H
+#define DB_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def DB_PROTOCOL_VERSION
+ * @brief Sent with DB_OP_HELLO, bumped whenever a message changes
+ */
+#define DB_PROTOCOL_VERSION 5
+
+/**
+ * @def DB_PROTOCOL_MAX_FRAME
+ * @brief Largest frame accepted, bounds the formatted tables a client can ask for
+ */
+#define DB_PROTOCOL_MAX_FRAME (16 * 1024 * 1024)
+
+/**
+ * @def DB_SOCKET_PATH_LEN
+ * @brief Size of the buffers holding a socket path (sun_path on Linux)
+ */
+#define DB_SOCKET_PATH_LEN 108
+
+/**
+ * @def DB_WIRE_NULL
+ * @brief String length standing for NULL
+ */
+#define DB_WIRE_NULL UINT32_MAX
+
+/**
+ * @enum db_op
+ * @brief Operations a client can ask for, each forwards the function of the same name
+ *
+ * The values are part of the protocol, never renumber them.
+ */
+enum db_op {
+    DB_OP_HELLO = 1, ///< u32 DB_PROTOCOL_VERSION, result SQLITE_OK if the server speaks it
+
+    DB_OP_RESIDENT_INSERT = 0x10,          ///< resident_db_insert()
+    DB_OP_RESIDENT_UPDATE = 0x11,          ///< resident_db_update()
+    DB_OP_RESIDENT_DELETE = 0x12,          ///< resident_db_delete_by_cpf()
+    DB_OP_RESIDENT_EXISTS = 0x13,          ///< resident_db_check_cpf_exists()
+    DB_OP_RESIDENT_GET = 0x14,             ///< resident_db_get_by_cpf()
+    DB_OP_RESIDENT_COUNT = 0x15,           ///< resident_db_get_count()
+    DB_OP_RESIDENT_FORMAT_ALL = 0x16,      ///< resident_db_get_all_format()
+    DB_OP_RESIDENT_FORMAT_ONE = 0x17,      ///< resident_db_get_format_by_cpf()
+    DB_OP_RESIDENT_INSERT_CHECKED = 0x18,  ///< resident_db_insert_checked()
+    DB_OP_RESIDENT_DUPLICATES = 0x19,      ///< resident_db_find_duplicates()
+    DB_OP_RESIDENT_ENTERED_BETWEEN = 0x1A, ///< resident_db_entered_between(), paged
+    DB_OP_RESIDENT_SEARCH = 0x1B,          ///< resident_db_search(), the results in one reply
+
+    DB_OP_FOODBATCH_INSERT = 0x20,           ///< foodbatch_db_insert()
+    DB_OP_FOODBATCH_UPDATE = 0x21,           ///< foodbatch_db_update()
+    DB_OP_FOODBATCH_TAKE = 0x22,             ///< foodbatch_db_take_quantity()
+    DB_OP_FOODBATCH_DELETE = 0x23,           ///< foodbatch_db_delete_by_id()
+    DB_OP_FOODBATCH_EXISTS = 0x24,           ///< foodbatch_db_check_batchid_exists()
+    DB_OP_FOODBATCH_GET = 0x25,              ///< foodbatch_db_get_by_batchid()
+    DB_OP_FOODBATCH_COUNT = 0x26,            ///< foodbatch_db_get_count()
+    DB_OP_FOODBATCH_FORMAT_ALL = 0x27,       ///< foodbatch_db_get_all_format()
+    DB_OP_FOODBATCH_FORMAT_ONE = 0x28,       ///< foodbatch_db_get_format_by_batchid()
+    DB_OP_FOODBATCH_EXPIRING_BETWEEN = 0x29, ///< foodbatch_db_expiring_between(), paged
+    DB_OP_FOODBATCH_IN_STOCK = 0x2A,         ///< foodbatch_db_in_stock(), paged, the range is unused
+    DB_OP_FOODBATCH_APPLY_PLAN = 0x2B,       ///< food_plan_apply(), u32 picks then batch id and quantity of each
+
+    DB_OP_USER_CREATE = 0x30,         ///< user_db_create_user()
+    DB_OP_USER_DELETE = 0x31,         ///< user_db_delete()
+    DB_OP_USER_SET_PHONE = 0x32,      ///< user_db_update_phone_number()
+    DB_OP_USER_SET_CPF = 0x33,        ///< user_db_update_cpf()
+    DB_OP_USER_SET_PASSWORD = 0x34,   ///< user_db_update_password()
+    DB_OP_USER_SET_ADMIN = 0x35,      ///< user_db_update_admin_status()
+    DB_OP_USER_SET_USERNAME = 0x36,   ///< user_db_update_username()
+    DB_OP_USER_RESET_PASSWORD = 0x37, ///< user_db_set_reset_password()
+    DB_OP_USER_CPF_EXISTS = 0x38,     ///< user_db_check_cpf_exists()
+    DB_OP_USER_EXISTS = 0x39,         ///< user_db_check_exists()
+    DB_OP_USER_IS_ADMIN = 0x3A,       ///< user_db_check_admin_status()
+    DB_OP_USER_GET = 0x3B,            ///< user_db_get_by_username(), without the password hash
+    DB_OP_USER_COUNT = 0x3C,          ///< user_db_get_count()
+    DB_OP_USER_FORMAT_ALL = 0x3D,     ///< user_db_get_all_format()
+    DB_OP_USER_AUTHENTICATE = 0x3E,   ///< user_db_authenticate()
+};
+
+/**
+ * @struct db_wire
+ * @brief Frame being written, grows as values are added
+ *
+ * Zero-initialize it. A failed allocation marks it failed, the values after it are dropped.
+ */
+struct db_wire {
+    uint8_t *data;   ///< Bytes, starting with the length
+    size_t len;      ///< Bytes written
+    size_t capacity; ///< Bytes allocated
+    bool failed;     ///< An allocation failed or the frame outgrew DB_PROTOCOL_MAX_FRAME
+};
+
+/**
+ * @struct db_wire_reader
+ * @brief Frame being read, after its length
+ *
+ * Reading past the end marks it failed and yields zeros and empty strings.
+ */
+struct db_wire_reader {
+    const uint8_t *data; ///< Bytes after the length
+    size_t len;          ///< Bytes in the frame
+    size_t pos;          ///< Bytes read
+    bool failed;         ///< A value was missing
+};
+
+/**
+ * @brief Starts a frame, reserving its length
+ *
+ * @param[in,out] wire Frame, its buffer is kept
+ */
+void db_wire_begin(struct db_wire *wire);
+
+/**
+ * @brief Writes the length of a frame
+ *
+ * @param[in,out] wire Frame started with db_wire_begin()
+ * @return false if the frame failed
+ */
+bool db_wire_end(struct db_wire *wire);
+
+/**
+ * @brief Frees the buffer of a frame
+ *
+ * @param[in,out] wire Frame, zeroed
+ */
+void db_wire_free(struct db_wire *wire);
+
+/** @brief Adds an 8-bit unsigned integer (a bool, an op) */
+void db_wire_put_u8(struct db_wire *wire, uint8_t value);
+
+/** @brief Adds a 32-bit unsigned integer */
+void db_wire_put_u32(struct db_wire *wire, uint32_t value);
+
+/** @brief Adds a 32-bit signed integer */
+void db_wire_put_i32(struct db_wire *wire, int32_t value);
+
+/** @brief Adds a 64-bit signed integer */
+void db_wire_put_i64(struct db_wire *wire, int64_t value);
+
+/** @brief Adds a double */
+void db_wire_put_f64(struct db_wire *wire, double value);
+
+/**
+ * @brief Overwrites a 32-bit signed integer added before (a result known after its values)
+ *
+ * @param[in,out] wire Frame
+ * @param[in] at Offset of the integer, wire->len before it was added
+ * @param[in] value New value
+ */
+void db_wire_set_i32(struct db_wire *wire, size_t at, int32_t value);
+
+/**
+ * @brief Adds a string
+ *
+ * @param[in,out] wire Frame
+ * @param[in] value String, may be NULL
+ */
+void db_wire_put_str(struct db_wire *wire, const char *value);
+
+/**
+ * @brief Adds the first bytes of a string, as a string
+ *
+ * @param[in,out] wire Frame
+ * @param[in] value Bytes
+ * @param[in] len Bytes to add
+ */
+void db_wire_put_bytes(struct db_wire *wire, const char *value, size_t len);
+
+/** @brief Reads an 8-bit unsigned integer */
+uint8_t db_wire_get_u8(struct db_wire_reader *reader);
+
+/** @brief Reads a 32-bit unsigned integer */
+uint32_t db_wire_get_u32(struct db_wire_reader *reader);
+
+/** @brief Reads a 32-bit signed integer */
+int32_t db_wire_get_i32(struct db_wire_reader *reader);
+
+/** @brief Reads a 64-bit signed integer */
+int64_t db_wire_get_i64(struct db_wire_reader *reader);
+
+/** @brief Reads a double */
+double db_wire_get_f64(struct db_wire_reader *reader);
+
+/**
+ * @brief Reads a string into a buffer, truncating it to fit
+ *
+ * @param[in,out] reader Frame
+ * @param[out] buffer Destination, always terminated
+ * @param[in] size Size of buffer
+ * @return false if the string was NULL (buffer is then empty)
+ */
+bool db_wire_get_str(struct db_wire_reader *reader, char *buffer, size_t size);
+
+/**
+ * @brief Reads a string in place
+ *
+ * @param[in,out] reader Frame
+ * @param[out] len Length of the string
+ * @return Its bytes, not terminated and valid as long as the frame, NULL if it was NULL
+ */
+const char *db_wire_get_bytes(struct db_wire_reader *reader, size_t *len);
+
+/**
+ * @brief Sends a finished frame, retrying short writes
+ *
+ * @param[in] fd Connected socket
+ * @param[in] wire Frame ended with db_wire_end()
+ * @return true if every byte was sent
+ */
+bool db_wire_send(int fd, const struct db_wire *wire);
+
+/**
+ * @brief Receives a frame
+ *
+ * @param[in] fd Connected socket
+ * @param[in,out] buffer Receive buffer, grown with realloc() as needed
+ * @param[in,out] capacity Size of buffer
+ * @param[out] reader Frame, pointing into buffer
+ * @return true if a whole frame arrived, false on end of stream, error or oversized frame
+ */
+bool db_wire_recv(int fd, uint8_t **buffer, size_t *capacity, struct db_wire_reader *reader);
+
+#endif // DB_PROTOCOL_H
@@ -0,0 +1,124 @@
+/**
+ * @file db_server.h
+ * @brief Local Database Server
+ *
+ * Lets several terminals of the shelter use the same databases at once. One process (`dbtool
+ * serve`) owns the resident, food batch and user databases and listens on a Unix domain
+ * socket, the apps started with DB_SERVER=<socket> forward their calls to it (db_client.h)
+ * with the protocol of db_protocol.h.
+ *
+ * Each client gets a thread, which runs:
+ *
+ * - reads on a connection checked out of the database pool (opened here if needed), so they
+ *   run alongside the writes and each other;
+ *
+ * - writes (resident and food batch insert, update, take and delete) by queueing them for the
+ *   writer thread, which takes everything queued (up to max_batch) and runs it in one
+ *   transaction per database: the clients writing at the same time share one commit, and its
+ *   fsync, instead of paying one each. Each write runs in its own savepoint, so a failing one
+ *   (a duplicate CPF) is rolled back alone and the others still commit. The client gets its
+ *   result once the commit is done, never before;
+ *
+ * - user functions directly, one at a time (the last login queue of user_db.h belongs to a
+ *   single connection). Authentications hash outside that lock.
+ *
+ * Linux only.
+ */
+
+#ifndef DB_SERVER_H
+#define DB_SERVER_H
+
+#include <stdint.h>
+
+#include "db/db_manager.h"
+
+/**
+ * @def DB_SERVER_MAX_CLIENTS
+ * @brief Clients connected at once, when db_server_config.max_clients is not set
+ */
+#define DB_SERVER_MAX_CLIENTS 64
+
+/**
+ * @def DB_SERVER_MAX_BATCH
+ * @brief Writes committed together, when db_server_config.max_batch is not set
+ */
+#define DB_SERVER_MAX_BATCH 256
+
+/**
+ * @def DB_SERVER_READERS
+ * @brief Read-only connections opened on a database without a pool
+ */
+#define DB_SERVER_READERS 4
+
+/**
+ * @def DB_SERVER_FLUSH_NS
+ * @brief Time between two checks of the queued last logins while no write comes
+ */
+#define DB_SERVER_FLUSH_NS (1000 * 1000000LL)
+
+/**
+ * @struct db_server_config
+ * @brief Limits of a server, zero-initialize for the defaults
+ */
+struct db_server_config {
+    int max_clients; ///< Clients connected at once, 0 for DB_SERVER_MAX_CLIENTS
+    int max_batch;   ///< Writes per group commit, 0 for DB_SERVER_MAX_BATCH (1 commits each alone)
+};
+
+/**
+ * @struct db_server_stats
+ * @brief Totals since the server started
+ */
+struct db_server_stats {
+    uint64_t clients;       ///< Connections accepted
+    uint64_t requests;      ///< Requests answered
+    uint64_t writes;        ///< Writes run by the writer thread
+    uint64_t commits;       ///< Transactions they were committed in (writes / commits per commit)
+    uint64_t largest_batch; ///< Most writes committed together
+};
+
+/**
+ * @struct db_server
+ * @brief Opaque running server
+ */
+struct db_server;
+
+/**
+ * @brief Starts serving the databases on a socket
+ *
+ * The databases must stay open, and not be used by the calling process, until
+ * db_server_stop(). A leftover socket file is replaced, unless a server still answers on it.
+ *
+ * @param[in] socket_path Path of the Unix domain socket to create
+ * @param[in,out] resident_db Initialized resident database
+ * @param[in,out] foodbatch_db Initialized food batch database
+ * @param[in,out] user_db Initialized user database
+ * @param[in] config Limits, NULL for the defaults
+ * @return Server, NULL on failure (printed on stderr)
+ */
+struct db_server *db_server_start(
+    const char *socket_path,
+    database *resident_db,
+    database *foodbatch_db,
+    database *user_db,
+    const struct db_server_config *config
+);
+
+/**
+ * @brief Reads the totals
+ *
+ * @param[in] server Server
+ * @param[out] stats Totals since the start
+ */
+void db_server_get_stats(struct db_server *server, struct db_server_stats *stats);
+
+/**
+ * @brief Disconnects the clients, waits for the writes in flight and frees the server
+ *
+ * The queued last logins are written and the socket file removed.
+ *
+ * @param[in] server Server, may be NULL
+ */
+void db_server_stop(struct db_server *server);
+
+#endif // DB_SERVER_H
@@ -0,0 +1,150 @@
+/**
+ * @file dose_schedule.h
+ * @brief Dose Reminders
+ *
+ * Keeps every recurring dose schedule of the DoseSchedule table in a timing wheel
+ * (utils_timerwheel.h) ticking in minutes, so checking for doses coming due costs O(1) per
+ * frame no matter how many schedules there are.
+ *
+ * When a dose comes due it becomes a reminder; a schedule has at most one reminder, a dose that
+ * comes due before the previous one is acknowledged just moves the reminder to the newer time.
+ * Only doses after the last one acknowledged (medication_schedule.given_minute) are reminded,
+ * so reloading the schedules does not bring back doses already given.
+ */
+
+#ifndef DOSE_SCHEDULE_H
+#define DOSE_SCHEDULE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "entities/medication.h"
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct dose_reminder
+ * @brief Dose due and not acknowledged yet
+ */
+struct dose_reminder {
+    int schedule_id;          ///< Schedule the dose belongs to
+    char cpf[MAX_CPF_LENGTH]; ///< Resident who takes the dose
+    int medication_id;        ///< Medication to give
+    int quantity;             ///< Units per dose
+    int64_t due_minute;       ///< When the dose was due (minutes since 1970-01-01 00:00 UTC)
+};
+
+/**
+ * @struct dose_schedule
+ * @brief Opaque reminder state
+ */
+struct dose_schedule;
+
+/**
+ * @brief Current time in the unit of the schedules
+ *
+ * @return Minutes since 1970-01-01 00:00 UTC
+ */
+int64_t dose_schedule_now(void);
+
+/**
+ * @brief Loads every dose schedule, doses due at now_minute become reminders right away
+ *
+ * @param medication_db Pointer to initialized medication database
+ * @param now_minute Current minute (usually dose_schedule_now())
+ * @return New reminder state, or NULL on failure
+ * @warning Must be released with dose_schedule_free()
+ */
+struct dose_schedule *dose_schedule_load(database *medication_db, int64_t now_minute);
+
+/**
+ * @brief Adds a schedule (call after medication_db_schedule_insert(), with the schedule as stored)
+ *
+ * A schedule whose first dose is at or before the last minute advanced to is due at once.
+ *
+ * @param ds Reminder state
+ * @param schedule Schedule as stored in the database
+ * @return true on success, false on allocation failure or if the id is already kept
+ */
+bool dose_schedule_add(struct dose_schedule *ds, const struct medication_schedule *schedule);
+
+/**
+ * @brief Removes a schedule and its reminder (call after medication_db_schedule_delete())
+ *
+ * @param ds Reminder state
+ * @param schedule_id Schedule id, unknown ids are ignored
+ */
+void dose_schedule_remove(struct dose_schedule *ds, int schedule_id);
+
+/**
+ * @brief Removes every schedule of a medication (call after medication_db_delete_by_id())
+ *
+ * @param ds Reminder state
+ * @param medication_id Medication id
+ */
+void dose_schedule_remove_medication(struct dose_schedule *ds, int medication_id);
+
+/**
+ * @brief Moves the clock forward, doses coming due become reminders
+ *
+ * Returns immediately when the minute did not change, so it can be called every frame.
+ *
+ * @param ds Reminder state
+ * @param now_minute Current minute
+ * @return Number of schedules that came due
+ */
+int dose_schedule_advance(struct dose_schedule *ds, int64_t now_minute);
+
+/**
+ * @brief Number of reminders pending
+ *
+ * @param ds Reminder state
+ * @return Reminder count
+ */
+int dose_schedule_due_count(const struct dose_schedule *ds);
+
+/**
+ * @brief Reminders pending, the longest overdue first
+ *
+ * @param ds Reminder state
+ * @param[out] out Reminders sorted by due minute
+ * @param max Capacity of out
+ * @return Number of reminders written (at most max, the oldest ones)
+ */
+int dose_schedule_due(const struct dose_schedule *ds, struct dose_reminder *out, int max);
+
+/**
+ * @brief Acknowledges the reminder of a schedule (the dose was given or skipped)
+ *
+ * The caller persists the returned minute with medication_db_schedule_set_given().
+ *
+ * @param ds Reminder state
+ * @param schedule_id Schedule id
+ * @return Due minute of the reminder acknowledged, or -1 if the schedule had none
+ */
+int64_t dose_schedule_acknowledge(struct dose_schedule *ds, int schedule_id);
+
+/**
+ * @brief Number of schedules kept
+ *
+ * @param ds Reminder state
+ * @return Schedule count
+ */
+int dose_schedule_count(const struct dose_schedule *ds);
+
+/**
+ * @brief Change counter, incremented whenever schedules or reminders change
+ *
+ * @param ds Reminder state
+ * @return Current version
+ */
+unsigned dose_schedule_version(const struct dose_schedule *ds);
+
+/**
+ * @brief Releases the reminder state
+ *
+ * @param ds Reminder state (NULL is a no-op)
+ */
+void dose_schedule_free(struct dose_schedule *ds);
+
+#endif // DOSE_SCHEDULE_H
@@ -0,0 +1,177 @@
+/**
+ * @file expiration_alerts.h
+ * @brief Expiration Alerts for Food and Medication
+ *
+ * Keeps every dated item (perishable food batches in stock and medications in stock) in an
+ * in-memory min-heap ordered by expiration day, so the next item to expire is always at the top.
+ *
+ * - The heap is loaded once from the ExpirationDate indexes. Afterwards it follows the committed
+ *   FoodBatch changes (db_changes.h): a changed batch is read again and moved, in O(log n), and
+ *   a reset reloads the batches. The medication screen reports its changes through
+ *   expiration_alerts_sync_medication() / expiration_alerts_remove().
+ * - expiration_alerts_next() is O(1), and expiration_alerts_count_due() only visits the items
+ *   that are due, so the main menu badge is cheap to refresh every frame.
+ */
+
+#ifndef EXPIRATION_ALERTS_H
+#define EXPIRATION_ALERTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "entities/foodbatch.h"
+#include "entities/medication.h"
+
+/**
+ * @def EXPIRATION_ALERT_WINDOW_DAYS
+ * @brief Items expiring within this many days from today (or already expired) are due
+ */
+#define EXPIRATION_ALERT_WINDOW_DAYS 7
+
+/**
+ * @enum expiration_source
+ * @brief Table an alert comes from
+ */
+enum expiration_source {
+    EXPIRATION_FOOD = 0,   ///< FoodBatch row, id is the BatchId
+    EXPIRATION_MEDICATION, ///< Medications row, id is the ID
+};
+
+/**
+ * @struct expiration_alert
+ * @brief An item with an expiration date
+ */
+struct expiration_alert {
+    enum expiration_source source; ///< Table the item comes from
+    int id;                        ///< Key of the item in its table
+    int32_t day;                   ///< Expiration day (days since 1970-01-01)
+    char name[MAX_INPUT];          ///< Name of the item
+};
+
+/**
+ * @struct expiration_alerts
+ * @brief Opaque min-heap of items by expiration day
+ */
+struct expiration_alerts;
+
+/**
+ * @brief Loads every dated item in stock from the food and medication databases
+ *
+ * Food batches are loaded when perishable with quantity > 0, medications when stock > 0. Food
+ * is read through foodbatch_db_expiring_between(), so it also loads from a database served by
+ * another process (db_client.h). Main thread only, the set subscribes to the FoodBatch changes
+ * until expiration_alerts_free().
+ *
+ * @param foodbatch_db Pointer to initialized foodbatch database, kept to read changed batches
+ *                     (may be NULL to skip food)
+ * @param medication_db Pointer to initialized medication database (may be NULL to skip medications)
+ * @return New alert set, or NULL on failure
+ * @warning Must be released with expiration_alerts_free()
+ */
+struct expiration_alerts *expiration_alerts_load(database *foodbatch_db, database *medication_db);
+
+/**
+ * @brief Adds an item or moves it to a new expiration day
+ *
+ * @param ea Alert set
+ * @param source Table of the item
+ * @param id Key of the item
+ * @param name Name of the item (copied)
+ * @param day Expiration day, DATE_INVALID removes the item
+ * @return true on success, false on allocation failure
+ */
+bool expiration_alerts_set(
+    struct expiration_alerts *ea,
+    enum expiration_source source,
+    int id,
+    const char *name,
+    int32_t day
+);
+
+/**
+ * @brief Adds, updates or removes a food batch following the load rules (perishable and in stock)
+ *
+ * Applied to every FoodBatch change the set is notified of, with the batch as stored in the
+ * database.
+ *
+ * @param ea Alert set
+ * @param foodbatch Batch as stored in the database
+ * @return true on success, false on allocation failure
+ */
+bool expiration_alerts_sync_foodbatch(struct expiration_alerts *ea, const struct foodbatch *foodbatch);
+
+/**
+ * @brief Adds, updates or removes a medication following the load rules (dated and in stock)
+ *
+ * Call after a medication is inserted, updated or dispensed, with the record as stored in the database.
+ *
+ * @param ea Alert set
+ * @param medication Medication as stored in the database
+ * @return true on success, false on allocation failure
+ */
+bool expiration_alerts_sync_medication(struct expiration_alerts *ea, const struct medication *medication);
+
+/**
+ * @brief Removes an item (call after it is deleted)
+ *
+ * @param ea Alert set
+ * @param source Table of the item
+ * @param id Key of the item, unknown items are ignored
+ */
+void expiration_alerts_remove(struct expiration_alerts *ea, enum expiration_source source, int id);
+
+/**
+ * @brief Item that expires first
+ *
+ * @param ea Alert set
+ * @return The item with the smallest expiration day, or NULL if there is none
+ * @warning The pointer is invalidated by any change to the set
+ */
+const struct expiration_alert *expiration_alerts_next(const struct expiration_alerts *ea);
+
+/**
+ * @brief Counts items expiring on or before a day
+ *
+ * Only visits the due items (the heap is pruned below them), so it stays cheap while few are due.
+ *
+ * @param ea Alert set
+ * @param until_day Last day included
+ * @return Number of due items
+ */
+int expiration_alerts_count_due(const struct expiration_alerts *ea, int32_t until_day);
+
+/**
+ * @brief Copies the items expiring on or before a day, soonest first
+ *
+ * @param ea Alert set
+ * @param until_day Last day included
+ * @param[out] out Due items sorted by expiration day
+ * @param max Capacity of out
+ * @return Number of items written (at most max, the soonest ones)
+ */
+int expiration_alerts_due(
+    const struct expiration_alerts *ea,
+    int32_t until_day,
+    struct expiration_alert *out,
+    int max
+);
+
+/**
+ * @brief Change counter, incremented by every change to the set
+ *
+ * Lets a screen cache what it derived from the set (badge count, list) until it changes.
+ *
+ * @param ea Alert set
+ * @return Current version
+ */
+unsigned expiration_alerts_version(const struct expiration_alerts *ea);
+
+/**
+ * @brief Releases the alert set and ends its FoodBatch subscription
+ *
+ * @param ea Alert set (NULL is a no-op)
+ */
+void expiration_alerts_free(struct expiration_alerts *ea);
+
+#endif // EXPIRATION_ALERTS_H
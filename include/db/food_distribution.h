@@ -0,0 +1,112 @@
+/**
+ * @file food_distribution.h
+ * @brief First-Expire-First-Out (FEFO) Distribution Planner
+ *
+ * Given a quantity requested per food name, allocates it from the batches in stock in
+ * expiration order and produces a pick list:
+ *
+ * - batches are grouped by name (ignoring case and accents) into one min-heap per requested
+ *   name, keyed by expiration date, so each pick is O(log n) and names not requested are skipped;
+ * - perishable batches already past their expiration date are never picked;
+ * - non-perishable batches (and perishable ones without a date) go after every dated batch.
+ *
+ * Planning does not change the database. Applying the plan takes every pick out of its batch
+ * quantity in one transaction, and fails without changes if the stock moved in between. A
+ * database served by another process (db_client.h) is planned from its batches in stock and the
+ * plan applied by the server, in one transaction as well.
+ */
+
+#ifndef FOOD_DISTRIBUTION_H
+#define FOOD_DISTRIBUTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct food_request
+ * @brief Quantity requested of one food name
+ */
+struct food_request {
+    char name[MAX_INPUT]; ///< Food name (matched ignoring case and accents)
+    int quantity;         ///< Quantity requested (<= 0 requests nothing)
+};
+
+/**
+ * @struct food_pick
+ * @brief One line of the pick list: take quantity out of a batch
+ */
+struct food_pick {
+    int batch_id;           ///< Batch to take from
+    int request;            ///< Index of the request this pick serves
+    int32_t expiration_day; ///< Expiration of the batch, DATE_INVALID if it does not expire
+    int quantity;           ///< Quantity to take
+    int remaining;          ///< Quantity left in the batch after this pick
+};
+
+/**
+ * @struct food_plan
+ * @brief Pick list for a set of requests
+ *
+ * @note Zero-initialize before the first food_plan_build(), release with food_plan_free()
+ */
+struct food_plan {
+    struct food_pick *picks; ///< Picks, grouped by request in request order, FEFO within a request
+    int pick_count;          ///< Number of picks
+    int *allocated;          ///< Quantity covered by the picks of each request
+    int request_count;       ///< Number of entries in allocated
+    long requested_total;    ///< Sum of the requested quantities
+    long allocated_total;    ///< Sum of the quantities picked (less than requested if stock is short)
+};
+
+/**
+ * @brief Plans a distribution from the batches in stock
+ *
+ * Requests with the same name are served in order from the same queue.
+ *
+ * @param[in] db Pointer to initialized foodbatch database
+ * @param[in] requests Quantities requested
+ * @param[in] request_count Number of requests
+ * @param[in] today Batches expiring before this day are skipped (DATE_INVALID to keep all)
+ * @param[in,out] plan Plan to fill (its previous contents are released)
+ * @return SQLITE_OK on success, SQLITE_NOMEM on allocation failure, or other SQLite error code
+ */
+int food_plan_build(
+    database *db,
+    const struct food_request *requests,
+    int request_count,
+    int32_t today,
+    struct food_plan *plan
+);
+
+/**
+ * @brief Takes every pick out of its batch in one transaction
+ *
+ * @param[in] db Pointer to initialized foodbatch database (the one the plan was built from)
+ * @param[in] plan Plan to apply
+ * @return SQLITE_OK on success; SQLITE_CONSTRAINT or SQLITE_NOTFOUND if a batch no longer holds
+ *         its pick (nothing is applied, build the plan again), or other SQLite error code
+ */
+int food_plan_apply(database *db, const struct food_plan *plan);
+
+/**
+ * @brief Formats the pick list as a table followed by the requests that could not be covered
+ *
+ * @param[in] plan Plan to format
+ * @param[in] requests Requests the plan was built from
+ * @param[out] buffer Output buffer
+ * @param[in] buffer_size Size of buffer, 512 + 512 per pick and per request always fits
+ * @return Number of bytes written, or -1 on error or truncation
+ */
+int food_plan_format(const struct food_plan *plan, const struct food_request *requests, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Releases the plan memory and leaves it empty
+ *
+ * @param[in,out] plan Plan to release
+ */
+void food_plan_free(struct food_plan *plan);
+
+#endif // FOOD_DISTRIBUTION_H
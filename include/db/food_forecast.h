@@ -0,0 +1,160 @@
+/**
+ * @file food_forecast.h
+ * @brief Food Run-Out Forecasting
+ *
+ * Combines FoodBatch.Quantity, FoodBatch.DailyConsumptionRate (per resident) and the number of
+ * residents into days of supply:
+ *
+ * - per batch: quantity / (rate * residents), as if that batch alone fed everyone;
+ * - per food name: the quantity of all batches of that name over their quantity-weighted rate;
+ * - for the pantry: the food name that runs out first. Summing every quantity over every rate
+ *   would let a pile of rice hide that the beans are gone in a week.
+ *
+ * The forecast is loaded once and then follows the FoodBatch and Resident changes (db_changes.h),
+ * each batch change is O(1). It reads through the foodbatch and resident functions, so it also
+ * works on databases served by another process. Batches are stored as packed quantity/rate
+ * arrays so the per-batch figures are a single vectorizable loop.
+ */
+
+#ifndef FOOD_FORECAST_H
+#define FOOD_FORECAST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "db/db_manager.h"
+#include "entities/foodbatch.h"
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct food_forecast_name
+ * @brief Supply of one food name (batches grouped by name, ignoring case and accents)
+ */
+struct food_forecast_name {
+    char name[MAX_INPUT]; ///< Name as typed on the first batch seen
+    double quantity;      ///< Quantity of all batches of the name
+    double daily_rate;    ///< Consumption per resident per day, weighted by batch quantity
+    float days;           ///< Days of supply at the current resident count (INFINITY if not consumed)
+    int batches;          ///< Number of batches in stock
+};
+
+/**
+ * @struct food_forecast_summary
+ * @brief Pantry-wide figures for the dashboard
+ */
+struct food_forecast_summary {
+    int residents;                     ///< Resident count used for the forecast
+    int batches;                       ///< Batches in stock
+    int names;                         ///< Food names in stock
+    double total_quantity;             ///< Quantity of every batch in stock
+    double daily_consumption;          ///< Quantity consumed per day by all residents
+    float first_runout_days;           ///< Days of supply of the name running out first (INFINITY if none)
+    int32_t first_runout_day;          ///< Day that name runs out from the given today, DATE_INVALID if never
+    char first_runout_name[MAX_INPUT]; ///< Name running out first, empty if no name is consumed
+    float shortest_batch_days;         ///< Days of supply of the batch that runs out first (INFINITY if none)
+};
+
+/**
+ * @struct food_forecast
+ * @brief Opaque forecast state
+ */
+struct food_forecast;
+
+/**
+ * @brief Loads the forecast from every batch in stock and the resident count
+ *
+ * Subscribes to the FoodBatch and Resident changes: food_forecast_set_batch() and
+ * food_forecast_remove_batch() follow every committed batch, and the resident count is taken
+ * again by food_forecast_refresh() once residents were added or removed. Both databases must
+ * outlive the forecast.
+ *
+ * @param foodbatch_db Pointer to initialized foodbatch database, local or served
+ * @param resident_db Pointer to initialized resident database (may be NULL, the count starts at 0)
+ * @return New forecast, or NULL on failure
+ * @warning Must be released with food_forecast_free()
+ */
+struct food_forecast *food_forecast_load(database *foodbatch_db, database *resident_db);
+
+/**
+ * @brief Adds or updates a batch, with the batch as stored (the FoodBatch subscription calls it)
+ *
+ * Batches with quantity <= 0 are removed from the forecast.
+ *
+ * @param ff Forecast
+ * @param foodbatch Batch as stored in the database
+ * @return true on success, false on allocation failure
+ */
+bool food_forecast_set_batch(struct food_forecast *ff, const struct foodbatch *foodbatch);
+
+/**
+ * @brief Removes a batch (the FoodBatch subscription calls it for deleted batches)
+ *
+ * @param ff Forecast
+ * @param batch_id Batch id, unknown ids are ignored
+ */
+void food_forecast_remove_batch(struct food_forecast *ff, int batch_id);
+
+/**
+ * @brief Counts the residents again if any were added or removed since the last count
+ *
+ * Call before reading the figures. The count is one query, so a bulk import costs a single
+ * recount instead of one per resident.
+ *
+ * @param ff Forecast
+ */
+void food_forecast_refresh(struct food_forecast *ff);
+
+/**
+ * @brief Sets the resident count (a forecast loaded without resident_db keeps it)
+ *
+ * @param ff Forecast
+ * @param residents Number of residents (negative values are taken as 0)
+ */
+void food_forecast_set_residents(struct food_forecast *ff, int residents);
+
+/**
+ * @brief Computes the pantry-wide figures
+ *
+ * @param ff Forecast
+ * @param today Day the run-out date is projected from (usually date_today())
+ * @param[out] summary Figures
+ */
+void food_forecast_summary(const struct food_forecast *ff, int32_t today, struct food_forecast_summary *summary);
+
+/**
+ * @brief Days of supply of every batch
+ *
+ * @param ff Forecast
+ * @param[out] batch_ids Batch id of each entry (may be NULL)
+ * @param[out] days Days of supply of each entry (INFINITY if the batch is not consumed)
+ * @param max Capacity of the output arrays
+ * @return Number of entries written
+ */
+int food_forecast_batch_days(const struct food_forecast *ff, int *batch_ids, float *days, int max);
+
+/**
+ * @brief Food names in stock, the ones running out first first
+ *
+ * @param ff Forecast
+ * @param[out] out Names sorted by days of supply
+ * @param max Capacity of out
+ * @return Number of names written (at most max, the shortest supplies)
+ */
+int food_forecast_names(const struct food_forecast *ff, struct food_forecast_name *out, int max);
+
+/**
+ * @brief Change counter, incremented by every change to batches or residents
+ *
+ * @param ff Forecast
+ * @return Current version
+ */
+unsigned food_forecast_version(const struct food_forecast *ff);
+
+/**
+ * @brief Releases the forecast
+ *
+ * @param ff Forecast (NULL is a no-op)
+ */
+void food_forecast_free(struct food_forecast *ff);
+
+#endif // FOOD_FORECAST_H
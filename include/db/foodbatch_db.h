@@ -38,9 +38,10 @@ int foodbatch_db_create_table(database *db);
  * @param[in] name Name/description of the food batch
  * @param[in] quantity Quantity of items in the batch
  * @param[in] isPerishable Whether the batch is perishable (true/false)
- * @param[in] expirationDate Expiration date string (YYYY-MM-DD format)
+ * @param[in] expirationDate Expiration date string (YYYY-MM-DD format), empty if the batch does not expire
  * @param[in] dailyConsumptionRate Expected daily consumption rate
- * @return SQLITE_OK on success, SQLite error code on failure
+ * @return SQLITE_OK on success, SQLITE_MISMATCH if the date is not valid, SQLite error code on failure
+ * @note The date is stored as a day number (see utils_date.h), it is only text at the API boundary
  */
 int foodbatch_db_insert(
     database *db,
@@ -65,7 +66,7 @@ int foodbatch_db_insert(
  * @param[in] is_perishable_input New perishable status (-1 preserves current)
  * @param[in] expiration_date_input New expiration date (empty string preserves current)
  * @param[in] daily_consumption_rate_input New consumption rate (< 0 preserves current)
- * @return SQLITE_OK on success, SQLite error code on failure
+ * @return SQLITE_OK on success, SQLITE_MISMATCH if the date is not valid, SQLite error code on failure
  */
 int foodbatch_db_update(
     database *db,
@@ -77,6 +78,22 @@ int foodbatch_db_update(
     float daily_consumption_rate_input
 );
 
+/**
+ * @brief Takes an amount out of a batch's quantity
+ *
+ * Decrements the same Quantity field foodbatch_db_update() sets, in one conditional UPDATE,
+ * so the amount is checked against the stock at the time of the write. Can be called inside
+ * a transaction to take from several batches atomically.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] batch_id ID of the batch
+ * @param[in] amount Amount to take (must be > 0)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the batch doesn't exist,
+ *         SQLITE_CONSTRAINT if the batch holds less than amount (nothing is taken),
+ *         SQLITE_MISUSE if amount <= 0, or other SQLite error code
+ */
+int foodbatch_db_take_quantity(database *db, int batch_id, int amount);
+
 /**
  * @brief Deletes a food batch record by ID
  *
@@ -119,6 +136,46 @@ bool foodbatch_db_check_batchid_exists(database *db, int batch_id);
  */
 int foodbatch_db_get_count(database *db);
 
+/**
+ * @brief Callback invoked once per food batch found by foodbatch_db_expiring_between() and foodbatch_db_in_stock()
+ *
+ * @param ctx User pointer passed through the query function
+ * @param foodbatch Matched batch, only valid for the duration of the call (copy it if needed)
+ * @return 0 to keep receiving results, non-zero to stop early
+ */
+typedef int (*foodbatch_callback)(void *ctx, const struct foodbatch *foodbatch);
+
+/**
+ * @brief Lists food batches expiring between two dates
+ *
+ * Dates are day numbers (see date_to_days() and date_parse()), compared on the
+ * FoodBatch_ExpirationDate index. Batches without an expiration date are never listed.
+ *
+ * @param db Pointer to initialized database structure
+ * @param from_day First day of the range (inclusive)
+ * @param to_day Last day of the range (inclusive)
+ * @param callback Function called for each batch, soonest expiration first
+ * @param ctx User pointer forwarded to the callback (may be NULL)
+ * @return Number of batches passed to the callback, or -1 on failure
+ */
+int foodbatch_db_expiring_between(
+    database *db,
+    int32_t from_day,
+    int32_t to_day,
+    foodbatch_callback callback,
+    void *ctx
+);
+
+/**
+ * @brief Lists the food batches in stock (quantity > 0), dated or not
+ *
+ * @param db Pointer to initialized database structure
+ * @param callback Function called for each batch, by batch id
+ * @param ctx User pointer forwarded to the callback (may be NULL)
+ * @return Number of batches passed to the callback, or -1 on failure
+ */
+int foodbatch_db_in_stock(database *db, foodbatch_callback callback, void *ctx);
+
 /**
  * @brief Writes all foodbatch records as a formatted string into provided buffer
  *
@@ -154,6 +211,20 @@ int foodbatch_db_get_count(database *db);
  */
 int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size);
 
+/**
+ * @brief Formats one batch as the row and separator line foodbatch_db_get_all_format() writes
+ *
+ * Used to patch a formatted table when a single batch changed (see table_text_patch()).
+ *
+ * @param db Pointer to initialized database connection
+ * @param batch_id ID of the batch
+ * @param buffer Caller-allocated buffer, 455 bytes always fit
+ * @param buffer_size Size of the provided buffer
+ * @return Number of bytes written (excluding null terminator), 0 if no batch has that ID,
+ *         -1 on failure or if the buffer is too small
+ */
+int foodbatch_db_get_format_by_batchid(database *db, int batch_id, char *buffer, size_t buffer_size);
+
 /**
  * @brief Retrieves all foodbatch records as a formatted string
  *
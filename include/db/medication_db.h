@@ -4,18 +4,46 @@
  *
  * This header defines operations for managing medication records in an SQLite database,
  * including creation, insertion, updating, deletion, and querying of medication information.
+ *
+ * The same database holds the dispensing log (DispenseLog, one row per dose handed to a
+ * resident, keyed by the resident CPF stored as an integer like in the Resident table) and
+ * the recurring dose schedules (DoseSchedule) that feed dose_schedule.h.
  */
 
 #ifndef MEDICATION_DB_H
 #define MEDICATION_DB_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "db_manager.h"
+#include "entities/medication.h"
+
+/**
+ * @brief Callback for queries returning dispensing log entries
+ *
+ * @param ctx User context passed to the query
+ * @param dispense Log entry (only valid during the call)
+ * @return 0 to continue, non-zero to stop
+ */
+typedef int (*medication_dispense_callback)(void *ctx, const struct medication_dispense *dispense);
+
+/**
+ * @brief Callback for queries returning dose schedules
+ *
+ * @param ctx User context passed to the query
+ * @param schedule Schedule (only valid during the call)
+ * @return 0 to continue, non-zero to stop
+ */
+typedef int (*medication_schedule_callback)(void *ctx, const struct medication_schedule *schedule);
 
 /**
  * @brief Creates the Medication table in the database
  *
  * Creates a new Medication table if it doesn't already exist. The table includes fields for
  * ID, Name, GenericaName, Form, Strength, Unit, Stock, Notes.
+ * Also creates the DispenseLog and DoseSchedule tables.
  *
  * @param[in] db Pointer to initialized database structure
  * @return SQLITE_OK on success, SQLite error code on failure
@@ -23,4 +51,191 @@
  */
 int medication_db_create_table(database *db);
 
-#endif // MEDICATION_DB_H
\ No newline at end of file
+/**
+ * @brief Inserts a new medication record
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] name Commercial name (required)
+ * @param[in] generic_name Generic name
+ * @param[in] form Form (tablet, syrup...)
+ * @param[in] strength Strength (500mg...)
+ * @param[in] unit Unit the stock is counted in
+ * @param[in] stock Units in inventory
+ * @param[in] expiration_date Expiration date in YYYY-MM-DD format (empty string for none)
+ * @param[in] notes General notes
+ * @param[out] id Receives the id of the new record (may be NULL)
+ * @return SQLITE_OK on success, SQLITE_MISMATCH if the date is not valid,
+ *         SQLITE_CONSTRAINT if the same name, form and strength exists, SQLite error code on failure
+ */
+int medication_db_insert(
+    database *db,
+    const char *name,
+    const char *generic_name,
+    const char *form,
+    const char *strength,
+    const char *unit,
+    int stock,
+    const char *expiration_date,
+    const char *notes,
+    int *id
+);
+
+/**
+ * @brief Updates an existing medication record
+ *
+ * Empty strings or negative stock will preserve the existing values.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the medication to update
+ * @param[in] name New name (empty string preserves current)
+ * @param[in] generic_name New generic name (empty string preserves current)
+ * @param[in] form New form (empty string preserves current)
+ * @param[in] strength New strength (empty string preserves current)
+ * @param[in] unit New unit (empty string preserves current)
+ * @param[in] stock New stock (< 0 preserves current)
+ * @param[in] expiration_date New expiration date (empty string preserves current)
+ * @param[in] notes New notes (empty string preserves current)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the medication doesn't exist,
+ *         SQLITE_MISMATCH if the date is not valid, SQLite error code on failure
+ */
+int medication_db_update(
+    database *db,
+    int id,
+    const char *name,
+    const char *generic_name,
+    const char *form,
+    const char *strength,
+    const char *unit,
+    int stock,
+    const char *expiration_date,
+    const char *notes
+);
+
+/**
+ * @brief Deletes a medication record and its dose schedules
+ *
+ * The dispensing log keeps its entries, they show an empty medication name afterwards.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the medication to delete
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the medication doesn't exist, SQLite error code on failure
+ */
+int medication_db_delete_by_id(database *db, int id);
+
+/**
+ * @brief Checks if a medication ID exists
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID to check
+ * @return true if the ID exists, false otherwise or on error
+ */
+bool medication_db_check_id_exists(database *db, int id);
+
+/**
+ * @brief Retrieves a medication record by ID
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the medication to retrieve
+ * @param[out] medication Pointer to medication struct to populate
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if not found, SQLite error code on failure
+ */
+int medication_db_get_by_id(database *db, int id, struct medication *medication);
+
+/**
+ * @brief Gets the number of medication records
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @return Number of records, or -1 on error
+ */
+int medication_db_get_count(database *db);
+
+/**
+ * @brief Formats every medication record as a table into a buffer
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[out] buffer Output buffer
+ * @param[in] buffer_size Size of buffer, 512 for the header plus 512 per record always fits
+ * @return Number of bytes written, or -1 on error or truncation
+ */
+int medication_db_get_all_format(database *db, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Dispenses a medication to a resident
+ *
+ * Takes quantity out of the stock and adds the dispensing log entry in one transaction.
+ * The stock is decremented with a single conditional UPDATE, so two dispenses racing for
+ * the last units cannot both succeed.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the medication
+ * @param[in] cpf CPF of the resident receiving it
+ * @param[in] quantity Units to dispense (must be > 0)
+ * @param[in] dispensed_at When it was dispensed (Unix time, seconds)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the medication doesn't exist,
+ *         SQLITE_CONSTRAINT if the stock is lower than quantity, SQLITE_MISMATCH if cpf is not
+ *         a digit string, SQLITE_MISUSE if quantity <= 0, SQLite error code on failure
+ *         (nothing is changed on failure)
+ */
+int medication_db_dispense(database *db, int id, const char *cpf, int quantity, int64_t dispensed_at);
+
+/**
+ * @brief Dispensing log of a resident, most recent first
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] cpf CPF of the resident
+ * @param[in] limit Maximum number of entries (<= 0 for all)
+ * @param[in] callback Function called for each entry
+ * @param[in] ctx User context passed to callback
+ * @return Number of entries visited, or -1 on error
+ */
+int medication_db_dispensed_to(
+    database *db,
+    const char *cpf,
+    int limit,
+    medication_dispense_callback callback,
+    void *ctx
+);
+
+/**
+ * @brief Adds a recurring dose schedule
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in,out] schedule Schedule to add (id is ignored and receives the new id)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the medication doesn't exist,
+ *         SQLITE_MISMATCH if the CPF is not a digit string, SQLITE_MISUSE if quantity <= 0
+ *         or interval < 0, SQLite error code on failure
+ */
+int medication_db_schedule_insert(database *db, struct medication_schedule *schedule);
+
+/**
+ * @brief Records the last dose of a schedule that was given
+ *
+ * Reloaded schedules only remind of doses after this one.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the schedule
+ * @param[in] given_minute Dose time acknowledged (minutes since 1970-01-01 00:00 UTC)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the schedule doesn't exist, SQLite error code on failure
+ */
+int medication_db_schedule_set_given(database *db, int id, int64_t given_minute);
+
+/**
+ * @brief Deletes a dose schedule
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the schedule
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the schedule doesn't exist, SQLite error code on failure
+ */
+int medication_db_schedule_delete(database *db, int id);
+
+/**
+ * @brief Visits every dose schedule
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] callback Function called for each schedule
+ * @param[in] ctx User context passed to callback
+ * @return Number of schedules visited, or -1 on error
+ */
+int medication_db_schedules(database *db, medication_schedule_callback callback, void *ctx);
+
+#endif // MEDICATION_DB_H
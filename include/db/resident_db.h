@@ -10,6 +10,7 @@
 #define RESIDENT_DB_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "db_manager.h"
 #include "entities/resident.h"
@@ -17,8 +18,14 @@
 /**
  * @brief Creates the Resident table in the database
  *
- * Creates a new Resident table if it doesn't already exist. The table includes fields for
- * CPF, name, age, health status, needs, medical assistance requirement, gender, and entry date.
+ * Creates a new Resident table if it doesn't already exist. The table is a WITHOUT ROWID table keyed
+ * by the CPF stored as an integer (see resident_db_cpf_pack()). It includes fields for
+ * CPF, name, age, health status, needs, medical assistance requirement, gender, entry date
+ * and the phonetic key of the name (NameKey, indexed, see name_phonetic_key()).
+ * Also creates the ResidentSearch full-text index and the triggers that keep it in sync.
+ * Databases created before NameKey existed get the column added and filled, and tables keyed by
+ * TEXT CPF are rebuilt with the integer key. Changes to it are published by CPF on this
+ * connection (see db_changes_track()).
  *
  * @param[in] db Pointer to initialized database structure
  * @return SQLITE_OK on success, SQLite error code on failure
@@ -26,6 +33,44 @@
  */
 int resident_db_create_table(database *db);
 
+/**
+ * @brief Converts a CPF string to the integer key stored in the database
+ *
+ * All resident_db_* functions take the CPF as a string and convert it with this function,
+ * 11 digits always fit in 64 bits.
+ *
+ * @param[in] cpf CPF with 1 to 11 digits and nothing else
+ * @return The CPF as an integer, or -1 if cpf is not a valid digit string
+ */
+int64_t resident_db_cpf_pack(const char *cpf);
+
+/**
+ * @brief Checks the two check digits of a CPF
+ *
+ * The resident screen and imports refuse a CPF failing it. resident_db_insert() and
+ * resident_db_cpf_pack() only check the format, so rows stored before can still be found.
+ *
+ * @param[in] cpf CPF with 11 digits and nothing else
+ * @return true if the check digits match and the digits are not all the same, false otherwise
+ */
+bool resident_db_cpf_valid(const char *cpf);
+
+/**
+ * @brief Fills in the two check digits of a CPF
+ *
+ * @param[in,out] cpf Buffer of MAX_CPF_LENGTH bytes starting with 9 digits, receives the
+ *                    check digits and the terminator
+ */
+void resident_db_cpf_complete(char cpf[MAX_CPF_LENGTH]);
+
+/**
+ * @brief Converts an integer CPF key back to its 11 digit string form
+ *
+ * @param[in] packed CPF as returned by resident_db_cpf_pack()
+ * @param[out] cpf Buffer of MAX_CPF_LENGTH bytes, receives the zero-padded CPF ("01234567890")
+ */
+void resident_db_cpf_unpack(int64_t packed, char cpf[MAX_CPF_LENGTH]);
+
 /**
  * @brief Inserts a new resident record into the database
  *
@@ -40,8 +85,9 @@ int resident_db_create_table(database *db);
  * @param[in] needs Special needs or requirements
  * @param[in] medical_assistance Whether medical assistance is required
  * @param[in] gender Gender (0=Other, 1=Male, 2=Female)
- * @return SQLITE_OK on success, SQLite error code on failure
- * @note The entry date is automatically set to the current date
+ * @return SQLITE_OK on success, SQLITE_MISMATCH if cpf is not a digit string, SQLite error code on failure
+ * @note The entry date is automatically set to the current date, NameKey is computed from the name
+ * @see resident_db_insert_checked() to also get the residents it may duplicate
  */
 int resident_db_insert(
     database *db,
@@ -54,6 +100,76 @@ int resident_db_insert(
     int gender
 );
 
+/**
+ * @struct resident_duplicate
+ * @brief A resident that may be the same person as the one being compared
+ */
+struct resident_duplicate {
+    char cpf[MAX_CPF_LENGTH]; ///< CPF of the existing resident
+    char name[MAX_INPUT];     ///< Name of the existing resident
+    float similarity;         ///< Score from 0.0 to 1.0, higher is more alike
+};
+
+/**
+ * @brief Finds the residents whose name sounds like name and is spelled alike
+ *
+ * Reads the residents with the same phonetic key through the NameKey index and scores them
+ * as resident_dedupe_report() does, so it needs no in-memory index and costs one index
+ * lookup. Names spelled alike but sounding different are only found by resident_dedupe_find().
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] name Name being registered
+ * @param[in] exclude_cpf CPF to leave out of the results (the resident itself), may be NULL
+ * @param[in] threshold Minimum score, usually RESIDENT_DEDUPE_THRESHOLD
+ * @param[out] out Candidates sorted by score, best first
+ * @param[in] max Capacity of out
+ * @return Number of candidates written, or -1 on failure
+ */
+int resident_db_find_duplicates(
+    database *db,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+);
+
+/**
+ * @brief Inserts a new resident and returns the residents it may duplicate
+ *
+ * Same as resident_db_insert(), preceded by resident_db_find_duplicates() on the name. The
+ * resident is inserted whatever the candidates, the caller decides what to do with them (warn,
+ * report, delete it again). For the paths without a confirmation step: import, tools, clients.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] cpf Resident's CPF
+ * @param[in] name Resident's full name
+ * @param[in] age Resident's age
+ * @param[in] health_status Description of health status
+ * @param[in] needs Special needs or requirements
+ * @param[in] medical_assistance Whether medical assistance is required
+ * @param[in] gender Gender (0=Other, 1=Male, 2=Female)
+ * @param[in] threshold Minimum score, usually RESIDENT_DEDUPE_THRESHOLD
+ * @param[out] duplicates Candidates sorted by score, best first
+ * @param[in] max Capacity of duplicates
+ * @param[out] duplicate_count Candidates written, 0 unless the insert succeeded
+ * @return Same as resident_db_insert()
+ */
+int resident_db_insert_checked(
+    database *db,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender,
+    float threshold,
+    struct resident_duplicate *duplicates,
+    int max,
+    int *duplicate_count
+);
+
 /**
  * @brief Updates an existing resident record
  *
@@ -123,6 +239,63 @@ int resident_db_get_by_cpf(database *db, const char *cpf, struct resident *resid
  */
 int resident_db_get_count(database *db);
 
+/**
+ * @brief Callback invoked once per resident found by resident_db_search() or resident_db_entered_between()
+ *
+ * @param ctx User pointer passed through the query function
+ * @param resident Matched resident, only valid for the duration of the call (copy it if needed)
+ * @return 0 to keep receiving results, non-zero to stop the search early
+ */
+typedef int (*resident_callback)(void *ctx, const struct resident *resident);
+
+/**
+ * @brief Full-text search over resident name, health status and needs
+ *
+ * Runs a ranked prefix search on the ResidentSearch FTS5 index. Each word typed is matched as a
+ * prefix and all words must match, so "mar sil" finds "Maria da Silva". Matches in the name rank
+ * above matches in health status or needs. Accents are ignored ("joao" finds "João").
+ * Every match is ranked, so the cost grows with the number of matches: a broad prefix ("ma")
+ * on a very large table takes a few hundred milliseconds, run it off the UI thread
+ * (resident_search.h).
+ *
+ * @param db Pointer to initialized database structure
+ * @param query Free text typed by the user, punctuation is ignored
+ * @param limit Maximum number of results to return (must be > 0)
+ * @param callback Function called for each result, best match first
+ * @param ctx User pointer forwarded to the callback (may be NULL)
+ * @return Number of results passed to the callback, or -1 on failure
+ *
+ * @note The index is kept in sync by triggers, no extra call is needed after insert/update/delete
+ */
+int resident_db_search(
+    database *db,
+    const char *query,
+    int limit,
+    resident_callback callback,
+    void *ctx
+);
+
+/**
+ * @brief Lists residents that entered the shelter between two dates
+ *
+ * Dates are day numbers (see date_to_days() and date_parse()), compared on the
+ * Resident_EntryDate index, so the cost depends on the number of matches, not on the table size.
+ *
+ * @param db Pointer to initialized database structure
+ * @param from_day First day of the range (inclusive)
+ * @param to_day Last day of the range (inclusive)
+ * @param callback Function called for each resident, oldest entry first
+ * @param ctx User pointer forwarded to the callback (may be NULL)
+ * @return Number of residents passed to the callback, or -1 on failure
+ */
+int resident_db_entered_between(
+    database *db,
+    int32_t from_day,
+    int32_t to_day,
+    resident_callback callback,
+    void *ctx
+);
+
 /**
  * @brief Writes all resident records as a formatted string into provided buffer
  *
@@ -158,6 +331,20 @@ int resident_db_get_count(database *db);
  */
 int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size);
 
+/**
+ * @brief Formats one resident as the row and separator line resident_db_get_all_format() writes
+ *
+ * Used to patch a formatted table when a single resident changed (see table_text_patch()).
+ *
+ * @param db Pointer to initialized database connection
+ * @param cpf CPF of the resident
+ * @param buffer Caller-allocated buffer, 1040 bytes always fit
+ * @param buffer_size Size of the provided buffer
+ * @return Number of bytes written (excluding null terminator), 0 if no resident has that CPF,
+ *         -1 on failure or if the buffer is too small
+ */
+int resident_db_get_format_by_cpf(database *db, const char *cpf, char *buffer, size_t buffer_size);
+
 /**
  * @brief Retrieves all resident records as a formatted string
  *
@@ -0,0 +1,129 @@
+/**
+ * @file resident_dedupe.h
+ * @brief Duplicate Resident Detection
+ *
+ * Residents often arrive without documents and get registered twice under slightly
+ * different spellings. This module finds likely duplicates by name:
+ *
+ * - An in-memory trigram index over all resident names answers "who looks like this name?"
+ *   at intake in a few milliseconds, without touching the database.
+ * - resident_dedupe_report() scans the whole table grouped by the indexed phonetic key
+ *   (Resident.NameKey), comparing names only inside each group instead of all pairs.
+ *
+ * Scores come from name_similarity() semantics: trigram similarity, boosted when the
+ * phonetic keys are equal.
+ */
+
+#ifndef RESIDENT_DEDUPE_H
+#define RESIDENT_DEDUPE_H
+
+#include "db/db_manager.h"
+#include "db/resident_db.h"
+#include "global/CONSTANTS.h"
+
+/**
+ * @def RESIDENT_DEDUPE_THRESHOLD
+ * @brief Default minimum score for two names to be reported as possible duplicates
+ *
+ * Names with the same phonetic key pass with 20% of trigrams in common, names that sound
+ * different need 60%.
+ */
+#define RESIDENT_DEDUPE_THRESHOLD 0.6f
+
+/**
+ * @def RESIDENT_DEDUPE_MAX_CANDIDATES
+ * @brief Maximum number of candidates shown at intake
+ */
+#define RESIDENT_DEDUPE_MAX_CANDIDATES 5
+
+/**
+ * @struct resident_dedupe
+ * @brief Opaque in-memory trigram index over resident names
+ */
+struct resident_dedupe;
+
+/**
+ * @brief Builds the trigram index from every resident in the database
+ *
+ * @param db Pointer to initialized resident database
+ * @return New index, or NULL on failure
+ * @warning Must be released with resident_dedupe_free()
+ */
+struct resident_dedupe *resident_dedupe_load(database *db);
+
+/**
+ * @brief Adds a resident to the index (call after a successful insert)
+ *
+ * @param rd Index handle
+ * @param cpf CPF of the new resident
+ * @param name Name of the new resident
+ * @return true on success, false if cpf is not a digit string or on allocation failure
+ */
+bool resident_dedupe_add(struct resident_dedupe *rd, const char *cpf, const char *name);
+
+/**
+ * @brief Removes a resident from the index (call after delete, or before re-adding on rename)
+ *
+ * @param rd Index handle
+ * @param cpf CPF of the resident to remove, unknown CPFs are ignored
+ */
+void resident_dedupe_remove(struct resident_dedupe *rd, const char *cpf);
+
+/**
+ * @brief Finds residents whose name is similar to name
+ *
+ * @param rd Index handle
+ * @param name Name being registered
+ * @param exclude_cpf CPF to leave out of the results (the resident itself on update), may be NULL
+ * @param threshold Minimum score, usually RESIDENT_DEDUPE_THRESHOLD
+ * @param[out] out Candidates sorted by score, best first
+ * @param max Capacity of out
+ * @return Number of candidates written
+ */
+int resident_dedupe_find(
+    struct resident_dedupe *rd,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+);
+
+/**
+ * @brief Releases the index
+ *
+ * @param rd Index handle (NULL is a no-op)
+ */
+void resident_dedupe_free(struct resident_dedupe *rd);
+
+/**
+ * @brief Callback invoked once per pair found by resident_dedupe_report()
+ *
+ * @param ctx User pointer passed through resident_dedupe_report()
+ * @param a First resident of the pair
+ * @param b Second resident of the pair, b->similarity holds the pair score
+ * @return 0 to continue, non-zero to stop the report
+ */
+typedef int (*resident_dedupe_callback)(
+    void *ctx,
+    const struct resident_duplicate *a,
+    const struct resident_duplicate *b
+);
+
+/**
+ * @brief Reports every pair of residents that may be duplicates
+ *
+ * Reads residents ordered by the NameKey index and compares names only within the same
+ * phonetic key, so the cost grows with the size of each group, not with the square of the table.
+ * Pairs spelled alike but sounding different (different keys) are only found at intake
+ * through resident_dedupe_find().
+ *
+ * @param db Pointer to initialized resident database
+ * @param threshold Minimum score, usually RESIDENT_DEDUPE_THRESHOLD
+ * @param callback Function called for each pair
+ * @param ctx User pointer forwarded to the callback (may be NULL)
+ * @return Number of pairs reported, or -1 on failure
+ */
+int resident_dedupe_report(database *db, float threshold, resident_dedupe_callback callback, void *ctx);
+
+#endif // RESIDENT_DEDUPE_H
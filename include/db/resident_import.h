@@ -0,0 +1,146 @@
+/**
+ * @file resident_import.h
+ * @brief Parallel Resident Import
+ *
+ * Loads a partner's resident list (another shelter, a city registry) into the Resident table
+ * with every core busy instead of one. The work is split in three stages connected by bounded
+ * lock-free queues (utils_queue.h):
+ *
+ *     reader --spsc--> parser 1 --\
+ *            --spsc--> parser 2 ---+--mpsc--> writer
+ *            --spsc--> parser N --/
+ *
+ * - the reader thread reads the file in chunks of whole lines and deals them round-robin to
+ *   the parsers, skipping a parser whose queue is full;
+ *
+ * - each parser splits its chunks into rows and validates them as the resident screen does:
+ *   CPF check digits, field lengths under MAX_INPUT, age range, entry date through
+ *   validate_date(). Valid rows, with their phonetic name key already computed, go to the
+ *   writer in batches;
+ *
+ * - the writer, on the calling thread since it owns the connection, inserts the batches with
+ *   one prepared statement in transactions of commit_rows rows.
+ *
+ * A stage that finds the next queue full waits for it, so memory stays bounded by the queue
+ * depths whatever the file size and a slow writer throttles the reader. Throughput grows with
+ * the parsers until the writer is busy all the time; the counters of resident_import_stats
+ * tell which stage waits on which.
+ *
+ * A file has one resident per line, fields separated by commas:
+ *
+ *     cpf,name,age,health_status,needs,medical_assistance,gender[,entry_date]
+ *
+ * Fields may be quoted ("Silva, Maria") with "" for a quote but cannot span lines.
+ * medical_assistance is 1/yes/true or 0/no/false (empty is no), gender is 0/other, 1/male or
+ * 2/female, entry_date is YYYY-MM-DD (empty or missing is today). Blank lines, lines starting
+ * with '#' and a "cpf,..." header on the first line are skipped.
+ *
+ * Invalid rows and CPFs already registered are reported on stderr with their line number and
+ * skipped, the other rows are imported. With resident_import_options.check_duplicates, a row
+ * whose name sounds and is spelled like a registered resident's (resident_db_find_duplicates(),
+ * the rows of the file before it included) is imported and reported as a possible duplicate. It
+ * rereads the residents of the same phonetic key for every row, off by default: common names
+ * make it the slowest stage by far.
+ */
+
+#ifndef RESIDENT_IMPORT_H
+#define RESIDENT_IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "db/db_manager.h"
+
+/**
+ * @def RESIDENT_IMPORT_CHUNK_SIZE
+ * @brief Bytes the reader reads at once when resident_import_options.chunk_size is not set
+ */
+#define RESIDENT_IMPORT_CHUNK_SIZE (64 * 1024)
+
+/**
+ * @def RESIDENT_IMPORT_COMMIT_ROWS
+ * @brief Rows per write transaction when resident_import_options.commit_rows is not set
+ */
+#define RESIDENT_IMPORT_COMMIT_ROWS 10000
+
+/**
+ * @def RESIDENT_IMPORT_BATCH_ROWS
+ * @brief Most rows a parser hands to the writer at once
+ */
+#define RESIDENT_IMPORT_BATCH_ROWS 256
+
+/**
+ * @def RESIDENT_IMPORT_MAX_WORKERS
+ * @brief Most parser threads started
+ */
+#define RESIDENT_IMPORT_MAX_WORKERS 64
+
+/**
+ * @def RESIDENT_IMPORT_MAX_AGE
+ * @brief Oldest age accepted, the bound of the resident screen's age box
+ */
+#define RESIDENT_IMPORT_MAX_AGE 120
+
+/**
+ * @struct resident_import_options
+ * @brief Tuning of the pipeline, zero-initialize for the defaults
+ */
+struct resident_import_options {
+    int workers;           ///< Parser threads, 0 for one per online core
+    size_t chunk_size;     ///< Bytes per read, 0 for RESIDENT_IMPORT_CHUNK_SIZE
+    int commit_rows;       ///< Rows per transaction, 0 for RESIDENT_IMPORT_COMMIT_ROWS
+    bool check_duplicates; ///< Report the rows that may be registered residents under another CPF
+};
+
+/**
+ * @struct resident_import_stats
+ * @brief Counters of each stage, for tuning
+ *
+ * Waits count the times a stage found a queue full (stall) or empty (idle) and yielded. A
+ * writer that is never idle is the bottleneck; parsers stalling on it confirm it. A reader
+ * stalling while the writer idles wants more parsers.
+ */
+struct resident_import_stats {
+    int workers;                      ///< Parser threads used
+    uint64_t bytes;                   ///< Bytes read
+    uint64_t chunks;                  ///< Chunks handed to the parsers
+    uint64_t lines;                   ///< Lines read, blank and comment lines included
+    uint64_t rows_valid;              ///< Rows that passed validation
+    uint64_t rows_invalid;            ///< Rows rejected by validation
+    uint64_t rows_inserted;           ///< Rows inserted
+    uint64_t rows_duplicate;          ///< Rows whose CPF was already registered
+    uint64_t rows_possible_duplicate; ///< Rows inserted whose name matches another resident's
+    uint64_t batches;                 ///< Batches handed to the writer
+    uint64_t commits;                 ///< Transactions committed
+    uint64_t reader_stalls;           ///< Reader waits on full parser queues
+    uint64_t parser_idles;            ///< Parser waits on empty chunk queues, all parsers
+    uint64_t parser_stalls;           ///< Parser waits on the full writer queue, all parsers
+    uint64_t writer_idles;            ///< Writer waits on the empty queue
+    uint64_t reader_ns;               ///< Time the reader spent reading and splitting
+    uint64_t parser_ns;               ///< Time spent parsing, all parsers
+    uint64_t writer_ns;               ///< Time the writer spent inserting and committing
+    uint64_t elapsed_ns;              ///< Wall time of the whole import
+};
+
+/**
+ * @brief Imports the residents of a file (format in the file description)
+ *
+ * Transactions committed before a failure stay, the failing one is rolled back.
+ *
+ * @param[in] db Pointer to initialized resident database
+ * @param[in] in File to import
+ * @param[in] options Tuning, NULL for the defaults
+ * @param[out] stats Stage counters, may be NULL
+ * @return SQLITE_OK on success (even if rows were skipped), SQLITE_IOERR if the file could not
+ *         be read, SQLITE_NOMEM on allocation failure, SQLite error code on failure
+ */
+int resident_import(
+    database *db,
+    FILE *in,
+    const struct resident_import_options *options,
+    struct resident_import_stats *stats
+);
+
+#endif // RESIDENT_IMPORT_H
@@ -0,0 +1,90 @@
+/**
+ * @file resident_search.h
+ * @brief Background Search-As-You-Type for Residents
+ *
+ * Runs resident_db_search() on a worker thread with a read-only connection (a reader of
+ * the database's pool when it has one, see db_pool_open(), else its own), so typing in a
+ * search box never blocks the UI frame. Queries are debounced:
+ * only the last query submitted within RESIDENT_SEARCH_DEBOUNCE_MS is executed.
+ *
+ * Typical use from a screen (called every frame):
+ * @code{.c}
+ * if (strcmp(tb_search.input, last_query) != 0) {
+ *     resident_search_submit(search, tb_search.input);
+ *     strcpy(last_query, tb_search.input);
+ * }
+ * resident_search_poll(search, results, &count, &generation);
+ * @endcode
+ */
+
+#ifndef RESIDENT_SEARCH_H
+#define RESIDENT_SEARCH_H
+
+#include <stdbool.h>
+
+#include "db/db_manager.h"
+#include "entities/resident.h"
+
+/**
+ * @def RESIDENT_SEARCH_MAX_RESULTS
+ * @brief Maximum number of results kept for a single search
+ */
+#define RESIDENT_SEARCH_MAX_RESULTS 20
+
+/**
+ * @def RESIDENT_SEARCH_DEBOUNCE_MS
+ * @brief Quiet time after the last keystroke before the query runs
+ */
+#define RESIDENT_SEARCH_DEBOUNCE_MS 150
+
+/**
+ * @struct resident_search
+ * @brief Opaque handle to a background search worker
+ */
+struct resident_search;
+
+/**
+ * @brief Starts a search worker for the database file behind db
+ *
+ * When db has a pool, every query checks a reader out of it. A database served by another
+ * process (db_is_remote()) sends every query to its server. Otherwise opens a second,
+ * read-only connection to the same file, owned by the worker thread.
+ *
+ * @param db Pointer to an initialized, file backed or served resident database, kept until
+ *           resident_search_stop()
+ * @return New worker handle, or NULL on failure (in-memory database, thread or open failure)
+ * @warning Must be released with resident_search_stop()
+ */
+struct resident_search *resident_search_start(database *db);
+
+/**
+ * @brief Queues a new query, replacing any query not yet executed
+ *
+ * Returns immediately. The query runs once no newer query arrives for RESIDENT_SEARCH_DEBOUNCE_MS.
+ *
+ * @param rs Worker handle
+ * @param query Text to search, an empty string clears the results
+ */
+void resident_search_submit(struct resident_search *rs, const char *query);
+
+/**
+ * @brief Copies the newest results if they changed since the last poll
+ *
+ * Cheap enough to call every frame: without new results it only takes a lock and compares a counter.
+ *
+ * @param rs Worker handle
+ * @param[out] results Array of at least RESIDENT_SEARCH_MAX_RESULTS residents
+ * @param[out] count Number of results written
+ * @param[in,out] generation Generation last seen by the caller, updated on new results (start with 0)
+ * @return true if results and count were updated, false if nothing changed
+ */
+bool resident_search_poll(struct resident_search *rs, struct resident *results, int *count, unsigned *generation);
+
+/**
+ * @brief Stops the worker, closes its connection and frees the handle
+ *
+ * @param rs Worker handle (NULL is a no-op)
+ */
+void resident_search_stop(struct resident_search *rs);
+
+#endif // RESIDENT_SEARCH_H
@@ -4,18 +4,36 @@
  *
  * This header defines operations for managing supplies records in an SQLite database,
  * including creation, insertion, updating, deletion, and querying of supplies information.
+ *
+ * The SuppliesCategoryTotals table keeps the item count and units in stock of every category,
+ * maintained by triggers on Supplies, so category totals are read without scanning Supplies.
  */
 
 #ifndef SUPPLIES_DB_H
 #define SUPPLIES_DB_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "db_manager.h"
+#include "entities/supplies.h"
+
+/**
+ * @brief Callback for queries returning category totals
+ *
+ * @param ctx User context passed to the query
+ * @param total Category total (only valid during the call)
+ * @return 0 to continue, non-zero to stop
+ */
+typedef int (*supplies_category_callback)(void *ctx, const struct supplies_category_total *total);
 
 /**
  * @brief Creates the Supplies table in the database
  *
  * Creates a new Supplies table if it doesn't already exist. The table includes fields for
  * ID, Name, Category, Size, Unit, Quantity, Notes.
+ * Also creates the SuppliesCategoryTotals table and the triggers keeping it in sync, the totals
+ * are computed once if the table is created on a database that already has supplies.
  *
  * @param[in] db Pointer to initialized database structure
  * @return SQLITE_OK on success, SQLite error code on failure
@@ -23,4 +41,137 @@
  */
 int supplies_db_create_table(database *db);
 
-#endif // SUPPLIES_DB_H
\ No newline at end of file
+/**
+ * @brief Inserts a new supplies record
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] name Name (required)
+ * @param[in] category Category
+ * @param[in] size Size
+ * @param[in] unit Unit the quantity is counted in
+ * @param[in] quantity Units in stock
+ * @param[in] notes General notes
+ * @param[out] id Receives the id of the new record (may be NULL)
+ * @return SQLITE_OK on success, SQLITE_CONSTRAINT if the same name, category and size exists,
+ *         SQLite error code on failure
+ */
+int supplies_db_insert(
+    database *db,
+    const char *name,
+    const char *category,
+    const char *size,
+    const char *unit,
+    int quantity,
+    const char *notes,
+    int *id
+);
+
+/**
+ * @brief Updates an existing supplies record
+ *
+ * Empty strings or negative quantity will preserve the existing values.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to update
+ * @param[in] name New name (empty string preserves current)
+ * @param[in] category New category (empty string preserves current)
+ * @param[in] size New size (empty string preserves current)
+ * @param[in] unit New unit (empty string preserves current)
+ * @param[in] quantity New quantity (< 0 preserves current)
+ * @param[in] notes New notes (empty string preserves current)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the record doesn't exist,
+ *         SQLITE_CONSTRAINT if it would duplicate another item, SQLite error code on failure
+ */
+int supplies_db_update(
+    database *db,
+    int id,
+    const char *name,
+    const char *category,
+    const char *size,
+    const char *unit,
+    int quantity,
+    const char *notes
+);
+
+/**
+ * @brief Deletes a supplies record
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to delete
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the record doesn't exist, SQLite error code on failure
+ */
+int supplies_db_delete_by_id(database *db, int id);
+
+/**
+ * @brief Checks if a supplies ID exists
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID to check
+ * @return true if the ID exists, false otherwise or on error
+ */
+bool supplies_db_check_id_exists(database *db, int id);
+
+/**
+ * @brief Retrieves a supplies record by ID
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] id ID of the record to retrieve
+ * @param[out] supplies Pointer to supplies struct to populate
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if not found, SQLite error code on failure
+ */
+int supplies_db_get_by_id(database *db, int id, struct supplies *supplies);
+
+/**
+ * @brief Gets the number of supplies records
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @return Number of records, or -1 on error
+ */
+int supplies_db_get_count(database *db);
+
+/**
+ * @brief Formats every supplies record as a table into a buffer
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[out] buffer Output buffer
+ * @param[in] buffer_size Size of buffer, 512 for the header plus 512 per record always fits
+ * @return Number of bytes written, or -1 on error or truncation
+ */
+int supplies_db_get_all_format(database *db, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Adds the units of every line of a shipment to the stock, all or nothing
+ *
+ * All lines are applied in one transaction with one prepared statement, so a shipment of
+ * hundreds of lines costs a single commit. Lines for the same item add up.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] lines Shipment lines
+ * @param[in] count Number of lines
+ * @param[out] failed_line Receives the index of the line that failed, -1 if none (may be NULL)
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if an item doesn't exist, SQLITE_MISUSE if a
+ *         quantity is not positive, SQLite error code on failure (nothing is applied on error)
+ */
+int supplies_db_receive_shipment(database *db, const struct supplies_line *lines, int count, int *failed_line);
+
+/**
+ * @brief Retrieves the totals of one category
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] category Category ("" for items without one)
+ * @param[out] total Category total to populate
+ * @return SQLITE_OK on success, SQLITE_NOTFOUND if the category has no items, SQLite error code on failure
+ */
+int supplies_db_get_category_total(database *db, const char *category, struct supplies_category_total *total);
+
+/**
+ * @brief Visits the totals of every category in category order
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] callback Function called for each category
+ * @param[in] ctx User context passed to callback
+ * @return Number of categories visited, or -1 on error
+ */
+int supplies_db_category_totals(database *db, supplies_category_callback callback, void *ctx);
+
+#endif // SUPPLIES_DB_H
@@ -65,20 +65,107 @@ int user_db_create_user(database *db, const char *username, const char *cpf, con
  */
 int user_db_create_admin(database *db);
 
+/**
+ * @struct user_auth
+ * @brief Opaque handle to a password verification running on a worker thread
+ */
+struct user_auth;
+
 /**
  * @brief Authenticates a user
  *
- * Verifies user credentials and returns authentication status. Updates last login
- * time on successful authentication.
+ * Verifies user credentials and returns authentication status. Queues the last login
+ * time on successful authentication (see user_db_flush_last_login()), and replaces the
+ * stored hash by one made with password_kdf_current() when it is weaker (see
+ * password_kdf_needs_upgrade()).
  *
  * @param[in] db Pointer to initialized database structure
  * @param[in] username Username to authenticate
  * @param[in] password Password to verify
  * @return AUTH_SUCCESS on success, AUTH_NEED_PASSWORD_RESET if password reset required,
  *         or AUTH_FAILURE on failure
+ *
+ * @warning Takes as long as the KDF cost of the user (hundreds of milliseconds), use
+ *          user_db_authenticate_start() from the UI
  */
 enum auth_result user_db_authenticate(database *db, const char *username, const char *password);
 
+/**
+ * @brief Starts authenticating a user, the password is checked on a worker thread
+ *
+ * The stored hash is read right away on the calling thread, with a query selecting only
+ * what the check needs. Unknown users and users who must
+ * reset their password are settled without starting the worker. The worker only hashes,
+ * it never uses the connection.
+ * On a database attached to a server (db_client.h) the worker sends the password to the server
+ * and waits for its answer instead.
+ *
+ * @param[in] db Pointer to initialized database structure
+ * @param[in] username Username to authenticate
+ * @param[in] password Password to verify (copied, and wiped when the handle is freed)
+ * @return Handle to poll with user_db_authenticate_poll(), or NULL on allocation failure
+ */
+struct user_auth *user_db_authenticate_start(database *db, const char *username, const char *password);
+
+/**
+ * @brief Finishes an authentication if its worker is done
+ *
+ * Cheap enough to call every frame. Once done, the upgraded hash is written and the last
+ * login time queued on the calling thread, and the handle is freed.
+ *
+ * @param[in] auth Handle from user_db_authenticate_start()
+ * @param[in] db Same database given to user_db_authenticate_start()
+ * @param[out] result Same result user_db_authenticate() would give, set when done
+ * @return true if done (auth is freed), false if the worker is still hashing
+ */
+bool user_db_authenticate_poll(struct user_auth *auth, database *db, enum auth_result *result);
+
+/**
+ * @brief Drops an authentication, waits for its worker and frees the handle without writing
+ *
+ * @param[in] auth Handle from user_db_authenticate_start() (NULL is a no-op)
+ */
+void user_db_authenticate_cancel(struct user_auth *auth);
+
+/**
+ * @def USER_DB_LAST_LOGIN_BATCH
+ * @brief Logins queued before their LastLogin times are written without waiting for a pause
+ */
+#define USER_DB_LAST_LOGIN_BATCH 32
+
+/**
+ * @def USER_DB_LAST_LOGIN_IDLE_SECONDS
+ * @brief Seconds without a login after which user_db_flush_last_login() writes the queue
+ */
+#define USER_DB_LAST_LOGIN_IDLE_SECONDS 2.0
+
+/**
+ * @brief Writes the queued LastLogin times in one transaction
+ *
+ * Successful logins only queue their time, so a burst of logins (shift change on a shared
+ * terminal) costs one write transaction per USER_DB_LAST_LOGIN_BATCH users instead of one
+ * per login. The queue is written when it is full, when this is called with force or after
+ * USER_DB_LAST_LOGIN_IDLE_SECONDS without a login, and before the functions reading
+ * LastLogin or renaming and deleting users run.
+ *
+ * @param[in] db Pointer to initialized database structure, the one the logins were made on
+ * @param[in] force Write now, even if logins are still coming
+ * @return SQLITE_OK on success (or nothing to write), SQLite error code on failure (the
+ *         times stay queued)
+ *
+ * @note Call every frame, and with force before closing the database: times still queued
+ *       when the connection is closed are lost
+ */
+int user_db_flush_last_login(database *db, bool force);
+
+/**
+ * @brief Number of logins whose LastLogin time is queued
+ *
+ * @param[in] db Pointer to database structure
+ * @return Queued logins for this connection
+ */
+int user_db_last_login_pending(database *db);
+
 /**
  * @brief Deletes a user account
  *
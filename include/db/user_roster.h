@@ -0,0 +1,177 @@
+/**
+ * @file user_roster.h
+ * @brief Bulk User Provisioning
+ *
+ * Creates the accounts of a whole roster (the volunteers of a new shelter, say) in one go
+ * instead of one user_db_create_user() call per person:
+ *
+ * - every row is validated as the create user screen does (username, 11 digit CPF, empty or
+ *   13 digit phone number);
+ *
+ * - usernames and CPFs are checked against sets loaded from the Users table with one query
+ *   each, and against the rows before them, instead of two lookups per row;
+ *
+ * - salts and password hashes (password_kdf_current(), which is slow on purpose) are computed
+ *   on a pool of threads, one per core by default;
+ *
+ * - the new users are inserted with one prepared statement in a single transaction, flagged
+ *   with ResetPassword so their first login makes them choose a password.
+ *
+ * Rows without a temporary password get a random one, for the caller to hand out.
+ *
+ * A roster file has one user per line, fields separated by commas:
+ *
+ *     username,cpf[,phone_number[,admin[,password]]]
+ *
+ * admin is 1/yes/true or 0/no/false (empty is no). Blank lines, lines starting with '#' and a
+ * "username,cpf,..." header before the first row are skipped.
+ */
+
+#ifndef USER_ROSTER_H
+#define USER_ROSTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "db/db_manager.h"
+#include "entities/user.h"
+
+/**
+ * @def ROSTER_PASSWORD_LEN
+ * @brief Length of the temporary passwords generated for rows without one
+ */
+#define ROSTER_PASSWORD_LEN 12
+
+/**
+ * @enum roster_status
+ * @brief What became of a roster row
+ */
+enum roster_status {
+    ROSTER_PENDING,         ///< Valid, not created yet
+    ROSTER_CREATED,         ///< User created
+    ROSTER_INVALID,         ///< Missing or malformed field
+    ROSTER_USERNAME_EXISTS, ///< Username taken, by an existing user or an earlier row
+    ROSTER_CPF_EXISTS,      ///< CPF taken, by an existing user or an earlier row
+};
+
+/**
+ * @struct roster_entry
+ * @brief One row of a roster and the password hash computed for it
+ */
+struct roster_entry {
+    char username[MAX_INPUT];                  ///< Username
+    char cpf[MAX_CPF_LENGTH];                  ///< CPF, 11 digits
+    char phone_number[MAX_PHONE_NUMBER_LEN];   ///< Phone number, empty or 13 digits
+    bool is_admin;                             ///< Administrator flag
+    char password[MAX_INPUT];                  ///< Temporary password, wiped by user_roster_free()
+    bool generated_password;                   ///< Whether password was generated by the provisioning
+    char salt[SALT_LEN + 1];                   ///< Salt, set by the provisioning
+    char password_hash[PASSWORD_HASH_LEN + 1]; ///< Hash of password with roster.kdf, set by the provisioning
+    long line;                                 ///< Line in the roster file, 0 if added with user_roster_add()
+    enum roster_status status;                 ///< Outcome of the row
+};
+
+/**
+ * @struct user_roster
+ * @brief Rows to provision
+ *
+ * @note Zero-initialize before use, free with user_roster_free().
+ */
+struct user_roster {
+    struct roster_entry *entries;   ///< Rows, in file order
+    size_t count;                   ///< Rows held
+    size_t capacity;                ///< Rows allocated
+    struct password_kdf_params kdf; ///< Function the hashes were made with
+};
+
+/**
+ * @struct roster_report
+ * @brief Row counts by outcome after user_roster_provision()
+ */
+struct roster_report {
+    int created;         ///< Users created
+    int invalid;         ///< Rows with a missing or malformed field
+    int username_exists; ///< Rows whose username was taken
+    int cpf_exists;      ///< Rows whose CPF was taken
+};
+
+/**
+ * @brief Appends a row, validating its fields
+ *
+ * A row failing validation is kept with ROSTER_INVALID so it shows in the report.
+ *
+ * @param[in,out] roster Roster
+ * @param[in] username Username
+ * @param[in] cpf CPF
+ * @param[in] phone_number Phone number, may be NULL or empty
+ * @param[in] is_admin Administrator flag
+ * @param[in] password Temporary password, NULL or empty to generate one
+ * @return Status of the new row (ROSTER_PENDING or ROSTER_INVALID), -1 on allocation failure
+ */
+int user_roster_add(
+    struct user_roster *roster,
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    bool is_admin,
+    const char *password
+);
+
+/**
+ * @brief Appends the rows of a roster file (format in the file description)
+ *
+ * Malformed rows are reported on stderr with their line number and kept as ROSTER_INVALID.
+ *
+ * @param[in,out] roster Roster
+ * @param[in] in Roster file
+ * @return Number of rows read, -1 on allocation or read failure
+ */
+int user_roster_read(struct user_roster *roster, FILE *in);
+
+/**
+ * @brief Marks the rows whose username or CPF is already taken
+ *
+ * Loads the usernames and CPFs of the Users table into memory once, then checks every
+ * pending row against them and against the rows before it.
+ *
+ * @param[in] db Pointer to initialized user database
+ * @param[in,out] roster Roster
+ * @return SQLITE_OK on success, SQLite error code on failure
+ */
+int user_roster_check_unique(database *db, struct user_roster *roster);
+
+/**
+ * @brief Generates the missing passwords, the salts and the hashes of the pending rows
+ *
+ * @param[in,out] roster Roster
+ * @param[in] threads Worker threads, 0 for one per online core
+ * @return Number of threads used
+ */
+int user_roster_hash_passwords(struct user_roster *roster, int threads);
+
+/**
+ * @brief Creates the users of a roster
+ *
+ * Runs user_roster_check_unique() and user_roster_hash_passwords(), then inserts every
+ * pending row in one transaction. Nothing is created if the transaction fails.
+ *
+ * @param[in] db Pointer to initialized user database
+ * @param[in,out] roster Roster, statuses updated
+ * @param[in] threads Hashing threads, 0 for one per online core
+ * @param[out] report Row counts by outcome, may be NULL
+ * @return SQLITE_OK on success (even if rows were skipped), SQLite error code on failure
+ *
+ * @note Hashing takes password_kdf_current()'s cost per row, divided among the threads,
+ *       and runs before the write transaction starts
+ */
+int user_roster_provision(database *db, struct user_roster *roster, int threads, struct roster_report *report);
+
+/**
+ * @brief Wipes the passwords and frees the rows
+ *
+ * @param[in,out] roster Roster, empty afterwards
+ */
+void user_roster_free(struct user_roster *roster);
+
+#endif // USER_ROSTER_H
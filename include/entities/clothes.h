@@ -0,0 +1,25 @@
+/**
+ * @file clothes.h
+ * @brief Clothes definitions for use in database operations/code
+ */
+#ifndef CLOTHES_H
+#define CLOTHES_H
+
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct clothes
+ * @brief Represents a clothes record (one SKU) in the database
+ */
+struct clothes {
+    int id;                    ///< Unique identifier (assigned on insert)
+    char type[MAX_INPUT];      ///< Type, e.g. "t-shirt", "pants", "coat"
+    char size[MAX_INPUT];      ///< Size, e.g. "M", "XL", "42", "kids"
+    char gender[MAX_INPUT];    ///< "other", "male" or "female"
+    char color[MAX_INPUT];     ///< Color, e.g. "blue", "black"
+    int quantity;              ///< Items in stock
+    char condition[MAX_INPUT]; ///< "new", "good", "worn" or "needs repair"
+    char notes[MAX_INPUT];     ///< Arbitrary tracking (donor, special handling...)
+};
+
+#endif // CLOTHES_H
@@ -6,6 +6,7 @@
 #define FOODBATCH_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "global/CONSTANTS.h"
 
@@ -18,6 +19,7 @@ struct foodbatch {
     char name[MAX_INPUT];         ///< Name/description of the food batch
     int quantity;                 ///< Quantity of items in the batch
     bool is_perishable;           ///< Whether the batch is perishable
+    int32_t expiration_day;       ///< Expiration date as stored in the database (days since 1970-01-01)
     char expiration_date[11];     ///< ISO 8601 formatted date (YYYY-MM-DD + null)
     float daily_consumption_rate; ///< Expected daily consumption rate
 };
@@ -0,0 +1,56 @@
+/**
+ * @file medication.h
+ * @brief Medication, dispensing and dose schedule definitions for use in database operations/code
+ */
+#ifndef MEDICATION_H
+#define MEDICATION_H
+
+#include <stdint.h>
+
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct medication
+ * @brief Represents a medication record in the database
+ */
+struct medication {
+    int id;                       ///< Unique identifier (assigned on insert)
+    char name[MAX_INPUT];         ///< Commercial name, e.g. "Tylenol"
+    char generic_name[MAX_INPUT]; ///< Generic name, e.g. "Paracetamol"
+    char form[MAX_INPUT];         ///< Form, e.g. "Tablet", "Syrup"
+    char strength[MAX_INPUT];     ///< Strength, e.g. "500mg", "5mg/ml"
+    char unit[MAX_INPUT];         ///< Unit the stock is counted in, e.g. "Tablet", "ml"
+    int stock;                    ///< Units in inventory
+    int32_t expiration_day;       ///< Soonest expiration as stored in the database (days since 1970-01-01)
+    char expiration_date[11];     ///< ISO 8601 formatted date (YYYY-MM-DD + null), empty if none
+    char notes[MAX_INPUT];        ///< General notes
+};
+
+/**
+ * @struct medication_dispense
+ * @brief One entry of the dispensing log
+ */
+struct medication_dispense {
+    int64_t id;                      ///< Log entry id
+    int medication_id;               ///< Medication dispensed
+    char medication_name[MAX_INPUT]; ///< Name of the medication (empty if it was deleted since)
+    char cpf[MAX_CPF_LENGTH];        ///< Resident who received it
+    int quantity;                    ///< Units dispensed
+    int64_t dispensed_at;            ///< When it was dispensed (Unix time, seconds)
+};
+
+/**
+ * @struct medication_schedule
+ * @brief Recurring dose of a medication for a resident
+ */
+struct medication_schedule {
+    int id;                   ///< Unique identifier (assigned on insert)
+    char cpf[MAX_CPF_LENGTH]; ///< Resident who takes the dose
+    int medication_id;        ///< Medication to give
+    int quantity;             ///< Units per dose
+    int64_t first_minute;     ///< First dose (minutes since 1970-01-01 00:00 UTC)
+    int interval_minutes;     ///< Time between doses (0 for a single dose)
+    int64_t given_minute;     ///< Last dose acknowledged as given, -1 if none yet
+};
+
+#endif // MEDICATION_H
@@ -6,6 +6,7 @@
 #define RESIDENT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "global/CONSTANTS.h"
 
@@ -27,12 +28,14 @@ enum gender {
  */
 struct resident {
     char cpf[MAX_CPF_LENGTH];      ///< Resident's CPF (Brazilian ID number)
+    int64_t cpf_packed;            ///< CPF as stored in the database (integer key, leading zeros dropped)
     char name[MAX_INPUT];          ///< Resident's full name
     int age;                       ///< Resident's age
     char health_status[MAX_INPUT]; ///< Description of health status
     char needs[MAX_INPUT];         ///< Special needs or requirements
     bool medical_assistance;       ///< Whether medical assistance is required
     enum gender gender;            ///< Gender (0=Other, 1=Male, 2=Female)
+    int32_t entry_day;             ///< Entry date as stored in the database (days since 1970-01-01)
     char entry_date[11];           ///< ISO 8601 formatted date (YYYY-MM-DD + null)
 };
 
@@ -0,0 +1,45 @@
+/**
+ * @file supplies.h
+ * @brief Supplies definitions for use in database operations/code
+ */
+#ifndef SUPPLIES_H
+#define SUPPLIES_H
+
+#include <stdint.h>
+
+#include "global/CONSTANTS.h"
+
+/**
+ * @struct supplies
+ * @brief Represents a supplies record (one item) in the database
+ */
+struct supplies {
+    int id;                   ///< Unique identifier (assigned on insert)
+    char name[MAX_INPUT];     ///< Name, e.g. "diaper", "soap"
+    char category[MAX_INPUT]; ///< Category, e.g. "hygiene", "cleaning"
+    char size[MAX_INPUT];     ///< Size, e.g. "adult", "small", "XXL"
+    char unit[MAX_INPUT];     ///< Unit the quantity is counted in, e.g. "piece", "pack"
+    int quantity;             ///< Units in stock
+    char notes[MAX_INPUT];    ///< Arbitrary tracking
+};
+
+/**
+ * @struct supplies_line
+ * @brief One line of a shipment: units of an item received
+ */
+struct supplies_line {
+    int id;       ///< Supplies ID
+    int quantity; ///< Units received (> 0)
+};
+
+/**
+ * @struct supplies_category_total
+ * @brief Rollup of every item of a category
+ */
+struct supplies_category_total {
+    char category[MAX_INPUT]; ///< Category ("" for items without one)
+    int items;                ///< Number of items in the category
+    int64_t quantity;         ///< Units in stock over every item of the category
+};
+
+#endif // SUPPLIES_H
@@ -9,6 +9,7 @@
 #include <time.h>
 
 #include "global/CONSTANTS.h"
+#include "utils/utils_hash.h"
 
 /** Length constants for password hashing */
 #define PASSWORD_HASH_LEN 64 ///< Length of SHA-256 hex string (2 chars per byte)
@@ -22,6 +23,7 @@ struct user {
     char username[MAX_INPUT];                  ///< Unique username identifier
     char password_hash[PASSWORD_HASH_LEN + 1]; ///< Hashed password
     char salt[SALT_LEN + 1];                   ///< Password salt
+    struct password_kdf_params kdf;            ///< Function and cost password_hash was derived with
     char cpf[MAX_CPF_LENGTH];                  ///< CPF (must be unique per user)
     char phone_number[MAX_PHONE_NUMBER_LEN];   ///< Contact data
     bool is_admin;                             ///< Administrator flag
@@ -0,0 +1,93 @@
+/**
+ * @file perf_overlay.h
+ * @brief On-Screen Performance Overlay
+ *
+ * Panel drawn over any screen, toggled with PERF_OVERLAY_KEY, to diagnose slowdowns on site
+ * without attaching a profiler. It shows:
+ *
+ * - a graph of the last PERF_RING_SIZE frames: frame time, time in the screen's render and
+ *   time in database statements, against the 60 FPS budget;
+ *
+ * - SQLite memory in use and its high-water mark (sqlite3_status64());
+ *
+ * - page cache hit ratio of the connections given, since the previous sample;
+ *
+ * - resident memory of the process.
+ *
+ * Per-frame values come from the probes in ui_base_render() and db_profile_thread_ns() and are
+ * recorded every frame, so the graph is already filled when the overlay is opened. Memory and
+ * cache figures are only sampled while it is visible, twice a second.
+ */
+
+#ifndef PERF_OVERLAY_H
+#define PERF_OVERLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <external/raylib/raylib.h>
+
+#include "db/db_manager.h"
+#include "utils/utils_perf.h"
+
+/**
+ * @def PERF_OVERLAY_KEY
+ * @brief Key showing and hiding the overlay
+ */
+#define PERF_OVERLAY_KEY KEY_F3
+
+/**
+ * @struct perf_overlay
+ * @brief Overlay state, samples and last figures read
+ */
+struct perf_overlay {
+    bool visible;                ///< Whether the overlay is drawn
+    struct perf_ring frame_ms;   ///< Frame times
+    struct perf_ring render_ms;  ///< Time in the screen's render per frame
+    struct perf_ring db_ms;      ///< Time in database statements per frame
+    int64_t sqlite_memory;       ///< Bytes allocated by SQLite
+    int64_t sqlite_memory_high;  ///< Most bytes SQLite had allocated at once
+    double cache_hit_ratio;      ///< Page cache hits over lookups since the previous sample, < 0 if none
+    size_t rss;                  ///< Resident memory of the process, 0 if unknown
+    double next_sample;          ///< Time (GetTime()) of the next memory and cache sample
+};
+
+/**
+ * @brief Initializes a hidden overlay with no samples
+ *
+ * @return Overlay instance
+ */
+struct perf_overlay perf_overlay_init(void);
+
+/**
+ * @brief Records the figures of the frame that just ran
+ *
+ * Call once per frame, before perf_overlay_draw().
+ *
+ * @param po Pointer to initialized overlay
+ * @param frame_ms Duration of the frame, in milliseconds
+ * @param render_ns Time spent rendering the screen (from ui_base_render())
+ * @param db_ns Time spent in database statements (difference of db_profile_thread_ns())
+ * @param dbs Connections whose page cache is reported
+ * @param db_count Number of connections in dbs
+ */
+void perf_overlay_record(
+    struct perf_overlay *po,
+    float frame_ms,
+    uint64_t render_ns,
+    uint64_t db_ns,
+    database *const *dbs,
+    int db_count
+);
+
+/**
+ * @brief Toggles the overlay on PERF_OVERLAY_KEY and draws it when visible
+ *
+ * @param po Pointer to initialized overlay
+ *
+ * @note Call every frame, after the screen is drawn so the overlay stays on top
+ */
+void perf_overlay_draw(struct perf_overlay *po);
+
+#endif // PERF_OVERLAY_H
@@ -12,6 +12,8 @@
 #ifndef UI_BASE_H
 #define UI_BASE_H
 
+#include <stdint.h>
+
 #include "global/app_state.h"
 #include "db/db_manager.h"
 #include "global/error_handling.h"
@@ -170,4 +172,17 @@ struct ui_base {
  */
 void ui_base_init_defaults(struct ui_base *base, const char *type_name);
 
+/**
+ * @brief Renders a screen and measures how long it took
+ * 
+ * Calls base->render, this is the probe the performance overlay gets its render time from.
+ * 
+ * @param base  Screen to render
+ * @param state Application state (may be modified)
+ * @param error Error tracking (may be modified)
+ * @param db    Database connection for UI operations
+ * @return Nanoseconds spent in base->render
+ */
+uint64_t ui_base_render(struct ui_base *base, enum app_state *state, enum error_code *error, database *db);
+
 #endif // UI_BASE_H
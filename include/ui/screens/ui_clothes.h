@@ -3,12 +3,30 @@
  * @brief Clothes Screen Management
  *
  * Handles the presentation and interaction of the application's
- * clothes management interface.
+ * clothes management interface:
+ * - Adding, updating, retrieving and deleting clothes (one record per SKU)
+ * - Matching the clothes in stock by size, gender, condition, type and color, the results
+ *   follow the filter as it is edited (see clothes_index.h)
  */
 
 #ifndef UI_CLOTHES_H
 #define UI_CLOTHES_H
 
+#include "db/clothes_index.h"
+#include "entities/clothes.h"
+#include "ui/screens/ui_base.h"
+#include "ui/components/button.h"
+#include "ui/components/checkbox.h"
+#include "ui/components/dropdownbox.h"
+#include "ui/components/intbox.h"
+#include "ui/components/scrollpanel.h"
+#include "ui/components/textbox.h"
+
+#define CLOTHES_SIZE_OPTIONS 7      ///< Sizes with a checkbox on the filter (XS to XXL and Kids)
+#define CLOTHES_GENDER_OPTIONS 3    ///< Other, male and female
+#define CLOTHES_CONDITION_OPTIONS 4 ///< New, good, worn and needs repair
+#define CLOTHES_MATCH_LIST_MAX 500  ///< Matches listed on the table view (totals count all of them)
+
 /**
  * @enum clothes_screen_flags
  * @brief State flags for the clothes screen
@@ -17,11 +35,13 @@
  */
 enum clothes_screen_flags {
     FLAG_CLOTHES_OPERATION_DONE = 1 << 0, ///< Operation done
+    FLAG_CONFIRM_CLOTHES_DELETE = 1 << 1, ///< Pending delete confirmation
+    FLAG_CLOTHES_ID_EXISTS = 1 << 2,      ///< Clothes ID already in database
+    FLAG_CLOTHES_ID_NOT_FOUND = 1 << 3,   ///< Specified clothes ID not found
+    FLAG_CLOTHES_TYPE_EMPTY = 1 << 4,     ///< Type is required on insert
+    FLAG_CLOTHES_DUPLICATE = 1 << 5       ///< Same type, size, gender, color and condition already exists
 };
 
-#include "ui/screens/ui_base.h"
-#include "ui/components/button.h"
-
 /**
  * @struct ui_clothes
  * @brief Clothes screen UI components
@@ -31,7 +51,41 @@ enum clothes_screen_flags {
 struct ui_clothes {
     struct ui_base base; ///< Base ui methods/functionality
 
-    struct button butn_back; ///< Button to got back to main menu
+    struct intbox ib_id;              ///< Clothes ID (0 inserts a new one)
+    struct textbox tb_type;           ///< Type
+    struct textbox tb_size;           ///< Size
+    struct textbox tb_color;          ///< Color
+    struct intbox ib_quantity;        ///< Items in stock
+    struct dropdownbox ddb_gender;    ///< Gender
+    struct dropdownbox ddb_condition; ///< Condition
+    struct textbox tb_notes;          ///< General notes
+
+    struct button butn_back;         ///< Button to got back to main menu
+    struct button butn_submit;       ///< Insert or update button
+    struct button butn_retrieve;     ///< Record retrieval button
+    struct button butn_delete;       ///< Record deletion button
+    struct button butn_retrieve_all; ///< Full inventory view button
+
+    Rectangle panel_bounds;           ///< Information display panel
+    struct clothes clothes_retrieved; ///< Currently displayed record
+
+    Rectangle match_bounds;                                         ///< Match filter panel
+    struct checkbox cb_match_sizes[CLOTHES_SIZE_OPTIONS];           ///< Sizes allowed
+    struct textbox tb_match_size;                                   ///< Other sizes allowed, comma-separated
+    struct checkbox cb_match_genders[CLOTHES_GENDER_OPTIONS];       ///< Genders allowed
+    struct checkbox cb_match_conditions[CLOTHES_CONDITION_OPTIONS]; ///< Conditions allowed
+    struct textbox tb_match_type;                                   ///< Types allowed, comma-separated
+    struct textbox tb_match_color;                                  ///< Colors allowed, comma-separated
+
+    struct scrollpanel sp_table_view; ///< A scrollpanel to view the clothes database or the matches
+    char *str_table_content;          ///< The content shown on the table view (MUST BE FREED IF ALLOCATED)
+
+    struct clothes_index *index;       ///< Shared index kept in sync on every change (may be NULL, no matching)
+    unsigned match_version;            ///< Index version the matches were listed at
+    unsigned match_checked;            ///< Checkboxes set when the matches were listed, one bit each
+    char match_text[3][MAX_INPUT];     ///< Size, type and color filters when the matches were listed
+    bool showing_matches;              ///< Whether the table view shows the matches
+    struct clothes_match match_totals; ///< Totals of the last match
 
     enum clothes_screen_flags flag; ///< Flags for the struct
 };
@@ -42,7 +96,8 @@ struct ui_clothes {
  * Sets up all elements with default positions and labels.
  *
  * @param ui Pointer to ui_clothes struct to initialize
+ * @param index Clothes index to update and match against (may be NULL, the filter is hidden)
  */
-void ui_clothes_init(struct ui_clothes *ui);
+void ui_clothes_init(struct ui_clothes *ui, struct clothes_index *index);
 
 #endif // UI_CLOTHES_H
@@ -6,11 +6,15 @@
  * - Adding new food batches
  * - Updating existing entries
  * - Viewing inventory details
+ * - Forecasting when the stock runs out
+ * - Planning the daily distribution first-expire-first-out
  */
 
 #ifndef UI_FOOD_H
 #define UI_FOOD_H
 
+#include "db/food_distribution.h"
+#include "db/food_forecast.h"
 #include "entities/foodbatch.h"
 #include "ui/screens/ui_base.h"
 #include "ui/components/button.h"
@@ -20,6 +24,9 @@
 #include "ui/components/scrollpanel.h"
 #include "ui/components/textbox.h"
 
+#define FOOD_FORECAST_PANEL_NAMES 5 ///< Food names listed on the forecast panel
+#define UI_FOOD_CHANGED_ROWS 64     ///< Changed batches noted between two renders, more reload the view
+
 /**
  * @enum food_screen_flags
  * @brief State flags for food management operations
@@ -31,7 +38,9 @@ enum food_screen_flags {
     FLAG_CONFIRM_FOOD_DELETE = 1 << 1, ///< Pending delete confirmation
     FLAG_BATCHID_EXISTS = 1 << 2,      ///< Batch ID already in database
     FLAG_INVALID_FOOD_DATE = 1 << 3,   ///< Invalid expiration date entered
-    FLAG_BATCHID_NOT_FOUND = 1 << 4    ///< Specified batch ID not found
+    FLAG_BATCHID_NOT_FOUND = 1 << 4,   ///< Specified batch ID not found
+    FLAG_CONFIRM_FOOD_PLAN = 1 << 5,   ///< Pending distribution plan confirmation
+    FLAG_NOTHING_TO_PLAN = 1 << 6      ///< No daily need or no stock to plan a distribution
 };
 
 /**
@@ -61,12 +70,30 @@ struct ui_food {
     struct button butn_retrieve;     ///< Record retrieval button
     struct button butn_delete;       ///< Record deletion button
     struct button butn_retrieve_all; ///< Full inventory view button
+    struct button butn_plan_rations; ///< Daily distribution planning button
 
     Rectangle panel_bounds;               ///< Information display panel
     struct foodbatch foodbatch_retrieved; ///< Currently displayed record
 
     struct scrollpanel sp_table_view; ///< A scrollpanel to view the resident's database
     char *str_table_content;          ///< The content of the resident's database (MUST BE FREED IF ALLOCATED)
+    bool table_shows_batches;         ///< str_table_content is the batch table, not a pick list
+
+    int changes_subscription;                  ///< FoodBatch change subscription (db_changes.h), 0 if none
+    int changed_batches[UI_FOOD_CHANGED_ROWS]; ///< Batch IDs committed since the last render
+    int changed_count;                         ///< Entries used in changed_batches
+    bool changed_all;                          ///< Too many changes to patch, reload what is shown
+
+    struct food_forecast *forecast;                                      ///< Shared forecast shown (may be NULL)
+    Rectangle forecast_panel_bounds;                                     ///< Forecast panel, below the info panel
+    unsigned forecast_version;                                           ///< Forecast version the panel was computed at
+    int32_t forecast_today;                                              ///< Day the panel was computed for
+    struct food_forecast_summary forecast_summary;                       ///< Cached pantry figures
+    struct food_forecast_name forecast_names[FOOD_FORECAST_PANEL_NAMES]; ///< Cached names running out first
+    int forecast_name_count;                                             ///< Entries used in forecast_names
+
+    struct food_request *plan_requests; ///< Daily need per food name of the pending plan (MUST BE FREED IF ALLOCATED)
+    struct food_plan plan;              ///< Pending distribution plan, shown on the table view until confirmed
 
     enum food_screen_flags flag; ///< Current operation flags
 };
@@ -75,9 +102,12 @@ struct ui_food {
  * @brief Initializes food management screen
  *
  * Sets up base interface overrides and all UI elements with default positions and values.
+ * Subscribes to the FoodBatch changes so the retrieved batch and the database view follow
+ * every commit, the cleanup unsubscribes.
  *
  * @param ui Pointer to ui_food struct to initialize
+ * @param forecast Food forecast to show, it follows the changes itself (may be NULL, the panel is hidden)
  */
-void ui_food_init(struct ui_food *ui);
+void ui_food_init(struct ui_food *ui, struct food_forecast *forecast);
 
 #endif // UI_FOOD_H
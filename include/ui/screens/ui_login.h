@@ -12,6 +12,7 @@
 #ifndef UI_LOGIN_H
 #define UI_LOGIN_H
 
+#include "db/user_db.h"
 #include "ui/screens/ui_base.h"
 #include "ui/components/button.h"
 #include "ui/components/textbox.h"
@@ -47,6 +48,7 @@ struct ui_login {
     struct textboxsecret tbs_password; ///< Secure password input field
     struct button butn_login;          ///< Authentication submission button
     enum login_screen_flags flag;      ///< Current authentication state flags
+    struct user_auth *auth;            ///< Password check running on a worker, NULL when idle
 };
 
 /**
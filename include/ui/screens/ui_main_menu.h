@@ -19,10 +19,17 @@ enum main_menu_screen_flags {
     FLAG_MAIN_MENU_WARN_NOT_ADMIN = 1 << 0, ///< Flag for warning current user is not admin
 };
 
+#include "db/expiration_alerts.h"
 #include "ui/screens/ui_base.h"
 #include "ui/components/button.h"
 #include "entities/user.h"
 
+/**
+ * @def MAIN_MENU_ALERTS_MAX
+ * @brief Maximum number of due items listed in the alerts panel (soonest first)
+ */
+#define MAIN_MENU_ALERTS_MAX 32
+
 /**
  * @struct ui_main_menu
  * @brief Main menu screen UI components
@@ -40,9 +47,21 @@ struct ui_main_menu {
     struct button create_user_butn;  ///< Button for the create user screen
     struct button settings_butn;     ///< Button for the settings screen
     struct button logout_butn;       ///< Button to logout the current user
+    struct button alerts_butn;       ///< Button showing/hiding the expiration alerts panel
 
     struct user *current_user; ///< Pointer to the current user for checking admin
 
+    struct expiration_alerts *alerts; ///< Shared alert set (owned by main, may be NULL)
+    bool show_alerts;                 ///< Whether the alerts panel is open
+    unsigned alerts_version;          ///< Alert set version the cached badge/list were built from
+    int32_t alerts_today;             ///< Day the cached badge/list were built for
+    int alerts_due_count;             ///< Number of due items, shown on the badge
+    int alerts_list_count;            ///< Number of items in alerts_labels
+    char alerts_labels[MAIN_MENU_ALERTS_MAX][128];        ///< Text of each listed item
+    const char *alerts_label_ptrs[MAIN_MENU_ALERTS_MAX];  ///< Pointers into alerts_labels for the list view
+    int alerts_scroll_index;                              ///< Scroll position of the alerts list
+    Rectangle alerts_panel_bounds;                        ///< Bounds of the alerts list
+
     enum main_menu_screen_flags flag; ///< Flags for the struct
 };
 
@@ -54,7 +73,8 @@ struct ui_main_menu {
  *
  * @param ui Pointer to ui_main_menu struct to initialize
  * @param current_user Pointer to the current user to set the context up
+ * @param alerts Expiration alert set shown on the badge and panel (may be NULL to hide them)
  */
-void ui_main_menu_init(struct ui_main_menu *ui, struct user *current_user);
+void ui_main_menu_init(struct ui_main_menu *ui, struct user *current_user, struct expiration_alerts *alerts);
 
 #endif // UI_MAIN_MENU_H
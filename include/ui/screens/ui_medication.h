@@ -3,12 +3,31 @@
  * @brief Medication Screen Management
  *
  * Handles the presentation and interaction of the application's
- * medication management interface.
+ * medication management interface:
+ * - Adding, updating, retrieving and deleting medications
+ * - Dispensing to a resident (taken out of stock and logged)
+ * - Recurring dose schedules per resident and the list of doses due
+ * - Viewing the dispensing history of a resident
  */
 
 #ifndef UI_MEDICATION_H
 #define UI_MEDICATION_H
 
+#include "db/db_manager.h"
+#include "db/dose_schedule.h"
+#include "db/expiration_alerts.h"
+#include "entities/medication.h"
+#include "ui/screens/ui_base.h"
+#include "ui/components/button.h"
+#include "ui/components/intbox.h"
+#include "ui/components/scrollpanel.h"
+#include "ui/components/textbox.h"
+#include "ui/components/textboxint.h"
+
+#define MEDICATION_DOSE_LIST_MAX 32    ///< Doses due shown on the list (the longest overdue)
+#define MEDICATION_HISTORY_MAX 200     ///< Dispensing log entries shown for a resident
+#define MEDICATION_DOSE_LINE_LENGTH 96 ///< Length of one line of the doses due list
+
 /**
  * @enum medication_screen_flags
  * @brief State flags for the medication screen
@@ -16,12 +35,19 @@
  * Tracks various states and validation results for the medication screen.
  */
 enum medication_screen_flags {
-    FLAG_MEDICATION_OPERATION_DONE = 1 << 0, ///< Operation done
+    FLAG_MEDICATION_OPERATION_DONE = 1 << 0,     ///< Operation done
+    FLAG_CONFIRM_MEDICATION_DELETE = 1 << 1,     ///< Pending delete confirmation
+    FLAG_MEDICATION_ID_EXISTS = 1 << 2,          ///< Medication ID already in database
+    FLAG_MEDICATION_ID_NOT_FOUND = 1 << 3,       ///< Specified medication ID not found
+    FLAG_INVALID_MEDICATION_DATE = 1 << 4,       ///< Invalid expiration date entered
+    FLAG_MEDICATION_NAME_EMPTY = 1 << 5,         ///< Name is required on insert
+    FLAG_MEDICATION_DUPLICATE = 1 << 6,          ///< Same name, form and strength already exists
+    FLAG_MEDICATION_RESIDENT_NOT_FOUND = 1 << 7, ///< CPF not valid or not registered
+    FLAG_MEDICATION_NO_STOCK = 1 << 8,           ///< Stock lower than the quantity to dispense
+    FLAG_MEDICATION_INVALID_DOSE = 1 << 9,       ///< Dose quantity not set
+    FLAG_NO_DOSE_SELECTED = 1 << 10              ///< Give/skip pressed without a dose selected
 };
 
-#include "ui/screens/ui_base.h"
-#include "ui/components/button.h"
-
 /**
  * @struct ui_medication
  * @brief Medication screen UI components
@@ -31,7 +57,53 @@ enum medication_screen_flags {
 struct ui_medication {
     struct ui_base base; ///< Base ui methods/functionality
 
-    struct button butn_back; ///< Button to got back to main menu
+    struct intbox ib_id;          ///< Medication ID (0 inserts a new one)
+    struct textbox tb_name;       ///< Commercial name
+    struct textbox tb_generic;    ///< Generic name
+    struct textbox tb_form;       ///< Form
+    struct textbox tb_strength;   ///< Strength
+    struct textbox tb_unit;       ///< Unit the stock is counted in
+    struct intbox ib_stock;       ///< Units in stock
+    Rectangle expirationDateText; ///< Expiration date label bounds
+    struct intbox ib_year;        ///< Expiration year input
+    struct intbox ib_month;       ///< Expiration month input
+    struct intbox ib_day;         ///< Expiration day input
+    struct textbox tb_notes;      ///< General notes
+
+    struct textboxint tbi_cpf;       ///< Resident to dispense or schedule for
+    struct intbox ib_dose_quantity;  ///< Units per dispense or dose
+    struct intbox ib_interval_hours; ///< Hours between scheduled doses (0 for a single dose)
+
+    struct button butn_back;         ///< Button to got back to main menu
+    struct button butn_submit;       ///< Insert or update button
+    struct button butn_retrieve;     ///< Record retrieval button
+    struct button butn_delete;       ///< Record deletion button
+    struct button butn_retrieve_all; ///< Full inventory view button
+    struct button butn_dispense;     ///< Dispense to the resident button
+    struct button butn_schedule;     ///< Schedule doses for the resident button
+    struct button butn_history;      ///< Dispensing history of the resident button
+    struct button butn_give;         ///< Dispense the selected dose due button
+    struct button butn_skip;         ///< Dismiss the selected dose due button
+
+    Rectangle panel_bounds;                 ///< Information display panel
+    struct medication medication_retrieved; ///< Currently displayed record
+
+    struct scrollpanel sp_table_view; ///< A scrollpanel to view the medication database or a dispensing history
+    char *str_table_content;          ///< The content shown on the table view (MUST BE FREED IF ALLOCATED)
+
+    database *resident_db;            ///< Resident database to check CPFs against
+    struct expiration_alerts *alerts; ///< Shared alert set kept in sync on every change (may be NULL)
+    struct dose_schedule *doses;      ///< Shared dose reminders kept in sync (may be NULL, the list is hidden)
+
+    Rectangle dose_list_bounds;                                             ///< Doses due list
+    unsigned dose_version;                                                  ///< Dose reminder version the list was built at
+    struct dose_reminder dose_due[MEDICATION_DOSE_LIST_MAX];                ///< Cached doses due, oldest first
+    char dose_lines[MEDICATION_DOSE_LIST_MAX][MEDICATION_DOSE_LINE_LENGTH]; ///< Text of each line
+    const char *dose_line_ptrs[MEDICATION_DOSE_LIST_MAX];                   ///< Lines for GuiListViewEx
+    int dose_count;                                                         ///< Entries used in dose_due
+    int dose_scroll;                                                        ///< List scroll index
+    int dose_active;                                                        ///< Selected line, -1 if none
+    int dose_focus;                                                         ///< Focused line, -1 if none
 
     enum medication_screen_flags flag; ///< Flags for the struct
 };
@@ -42,7 +114,15 @@ struct ui_medication {
  * Sets up all elements with default positions and labels.
  *
  * @param ui Pointer to ui_medication struct to initialize
+ * @param resident_db Resident database to check CPFs against
+ * @param alerts Expiration alert set to update when medications change (may be NULL)
+ * @param doses Dose reminders to update and show (may be NULL, the list is hidden)
  */
-void ui_medication_init(struct ui_medication *ui);
+void ui_medication_init(
+    struct ui_medication *ui,
+    database *resident_db,
+    struct expiration_alerts *alerts,
+    struct dose_schedule *doses
+);
 
 #endif // UI_MEDICATION_H
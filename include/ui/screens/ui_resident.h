@@ -9,6 +9,8 @@
 #ifndef UI_RESIDENT_H
 #define UI_RESIDENT_H
 
+#include "db/resident_dedupe.h"
+#include "db/resident_search.h"
 #include "entities/resident.h"
 #include "ui/screens/ui_base.h"
 #include "ui/components/button.h"
@@ -19,6 +21,8 @@
 #include "ui/components/textbox.h"
 #include "ui/components/textboxint.h"
 
+#define UI_RESIDENT_CHANGED_ROWS 64 ///< Changed residents noted between two renders, more reload the view
+
 /**
  * @enum resident_screen_flags
  * @brief State flags for resident screen operations
@@ -32,9 +36,10 @@ enum resident_screen_flags {
     FLAG_CPF_EXISTS = 1 << 2,              ///< CPF already exists in database
     FLAG_CPF_NOT_FOUND = 1 << 3,           ///< CPF not found in database
     FLAG_INPUT_CPF_EMPTY = 1 << 4,         ///< CPF input field is empty
-    FLAG_CPF_NOT_VALID = 1 << 5,           ///< CPF input is invalid (not 11 digits)
+    FLAG_CPF_NOT_VALID = 1 << 5,           ///< CPF input is invalid (not 11 digits, or wrong check digits)
     FLAG_SHOW_HEALTH = 1 << 6,             ///< Show full health status popup
-    FLAG_SHOW_NEEDS = 1 << 7               ///< Show full needs description popup
+    FLAG_SHOW_NEEDS = 1 << 7,              ///< Show full needs description popup
+    FLAG_POSSIBLE_DUPLICATE = 1 << 8       ///< Name is similar to existing residents, insert needs confirmation
 };
 
 /**
@@ -67,6 +72,29 @@ struct ui_resident {
     struct scrollpanel sp_table_view; ///< A scrollpanel to view the resident's database
     char *str_table_content;          ///< The content of the resident's database (MUST BE FREED IF ALLOCATED)
 
+    struct textbox tb_search;                                    ///< Search-as-you-type input (name, health status, needs)
+    char search_submitted[MAX_INPUT];                            ///< Last query handed to the search worker
+    struct resident_search *search;                              ///< Background search worker (started lazily, MUST BE STOPPED)
+    bool search_failed;                                          ///< Worker failed to start, not retried before leaving
+    Rectangle search_results_bounds;                             ///< Bounds of the search results list
+    struct resident search_results[RESIDENT_SEARCH_MAX_RESULTS]; ///< Latest search results
+    char search_labels[RESIDENT_SEARCH_MAX_RESULTS][64];         ///< "Name (CPF)" text for each result
+    const char *search_label_ptrs[RESIDENT_SEARCH_MAX_RESULTS];  ///< Pointers into search_labels for the list view
+    int search_result_count;                                     ///< Number of valid entries in search_results
+    unsigned search_generation;                                  ///< Result generation last copied from the worker
+    int search_scroll_index;                                     ///< Scroll position of the results list
+    int search_active;                                           ///< Selected result in the list (-1 for none)
+
+    struct resident_dedupe *dedupe;                                       ///< Name trigram index (loaded lazily, MUST BE FREED)
+    struct resident_duplicate duplicates[RESIDENT_DEDUPE_MAX_CANDIDATES]; ///< Candidates found for the name being inserted
+    int duplicate_count;                                                  ///< Number of valid entries in duplicates
+    char duplicate_msg[512];                                              ///< Confirmation message listing the candidates
+
+    int changes_subscription;                       ///< Resident change subscription (db_changes.h), 0 if none
+    int64_t changed_cpfs[UI_RESIDENT_CHANGED_ROWS]; ///< CPF keys committed since the last render
+    int changed_count;                              ///< Entries used in changed_cpfs
+    bool changed_all;                               ///< Too many changes to patch, reload what is shown
+
     enum resident_screen_flags flag; ///< Current screen state flags
 };
 
@@ -74,6 +102,8 @@ struct ui_resident {
  * @brief Initializes the resident registration screen
  *
  * Sets up base interface overrides and all UI elements with default positions and values.
+ * Subscribes to the Resident changes so the retrieved resident and the database view follow
+ * every commit, the cleanup unsubscribes.
  *
  * @param ui Pointer to ui_resident struct to initialize
  */
@@ -15,6 +15,7 @@
 #include "ui/components/dropdownbox.h"
 #include "ui/components/textbox.h"
 #include "ui/components/textboxint.h"
+#include "db/db_backup.h"
 #include "entities/user.h"
 
 /**
@@ -53,10 +54,13 @@ struct ui_settings {
     struct button butn_back;           ///< Return to previous screen
     struct button butn_submit;         ///< Submit updated info to the database
     struct button butn_reset_password; ///< Reset logged-in user password
+    struct button butn_backup;         ///< Start a backup of the databases now
 
-    Rectangle panel_bounds; ///< Panel bounds to display current user info
+    Rectangle panel_bounds;        ///< Panel bounds to display current user info
+    Rectangle backup_panel_bounds; ///< Panel bounds to display the backup progress
 
     struct user *current_user; ///< Pointer to the currently logged in user
+    struct db_backup *backup;  ///< Backup manager, NULL if backups are unavailable
 
     enum settings_screen_flags flag; ///< Current screen state flags
 };
@@ -67,7 +71,9 @@ struct ui_settings {
  * Sets up base interface overrides and all UI elements with default positions and values.
  *
  * @param ui Pointer to ui_settings struct to initialize
+ * @param current_user Pointer to the currently logged in user
+ * @param backup Backup manager whose progress is shown, may be NULL
  */
-void ui_settings_init(struct ui_settings *ui, struct user *current_user);
+void ui_settings_init(struct ui_settings *ui, struct user *current_user, struct db_backup *backup);
 
 #endif // UI_SETTINGS_H
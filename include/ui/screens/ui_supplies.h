@@ -3,12 +3,26 @@
  * @brief Supplies Screen Management
  *
  * Handles the presentation and interaction of the application's
- * supplies management interface.
+ * supplies management interface:
+ * - Adding, updating, retrieving and deleting supplies
+ * - Building a shipment line by line and receiving it in a single transaction
+ * - Showing the units in stock per category (kept by the database, see supplies_db.h)
  */
 
 #ifndef UI_SUPPLIES_H
 #define UI_SUPPLIES_H
 
+#include "entities/supplies.h"
+#include "ui/screens/ui_base.h"
+#include "ui/components/button.h"
+#include "ui/components/intbox.h"
+#include "ui/components/scrollpanel.h"
+#include "ui/components/textbox.h"
+
+#define SUPPLIES_SHIPMENT_MAX 500     ///< Lines of a shipment
+#define SUPPLIES_CATEGORY_LIST_MAX 64 ///< Categories shown on the totals list
+#define SUPPLIES_LIST_LINE_LENGTH 64  ///< Length of one line of the shipment or totals list
+
 /**
  * @enum supplies_screen_flags
  * @brief State flags for the supplies screen
@@ -17,11 +31,17 @@
  */
 enum supplies_screen_flags {
     FLAG_SUPPLIES_OPERATION_DONE = 1 << 0, ///< Operation done
+    FLAG_CONFIRM_SUPPLIES_DELETE = 1 << 1, ///< Pending delete confirmation
+    FLAG_SUPPLIES_ID_EXISTS = 1 << 2,      ///< Supplies ID already in database
+    FLAG_SUPPLIES_ID_NOT_FOUND = 1 << 3,   ///< Specified supplies ID not found
+    FLAG_SUPPLIES_NAME_EMPTY = 1 << 4,     ///< Name is required on insert
+    FLAG_SUPPLIES_DUPLICATE = 1 << 5,      ///< Same name, category and size already exists
+    FLAG_SHIPMENT_INVALID_LINE = 1 << 6,   ///< Shipment line without an existing item or units
+    FLAG_SHIPMENT_FULL = 1 << 7,           ///< SUPPLIES_SHIPMENT_MAX lines already added
+    FLAG_SHIPMENT_EMPTY = 1 << 8,          ///< Receive pressed without lines
+    FLAG_SHIPMENT_RECEIVED = 1 << 9        ///< Shipment received, show how much
 };
 
-#include "ui/screens/ui_base.h"
-#include "ui/components/button.h"
-
 /**
  * @struct ui_supplies
  * @brief Supplies screen UI components
@@ -31,7 +51,50 @@ enum supplies_screen_flags {
 struct ui_supplies {
     struct ui_base base; ///< Base ui methods/functionality
 
-    struct button butn_back; ///< Button to got back to main menu
+    struct intbox ib_id;        ///< Supplies ID (0 inserts a new one)
+    struct textbox tb_name;     ///< Name
+    struct textbox tb_category; ///< Category
+    struct textbox tb_size;     ///< Size
+    struct textbox tb_unit;     ///< Unit the quantity is counted in
+    struct intbox ib_quantity;  ///< Units in stock
+    struct textbox tb_notes;    ///< General notes
+
+    struct button butn_back;         ///< Button to got back to main menu
+    struct button butn_submit;       ///< Insert or update button
+    struct button butn_retrieve;     ///< Record retrieval button
+    struct button butn_delete;       ///< Record deletion button
+    struct button butn_retrieve_all; ///< Full inventory view button
+
+    Rectangle panel_bounds;             ///< Information display panel
+    struct supplies supplies_retrieved; ///< Currently displayed record
+
+    struct intbox ib_line_id;          ///< Item of the next shipment line
+    struct intbox ib_line_quantity;    ///< Units of the next shipment line
+    struct button butn_add_line;       ///< Add the line to the shipment button
+    struct button butn_clear_shipment; ///< Drop every line of the shipment button
+    struct button butn_receive;        ///< Receive the shipment button
+
+    Rectangle shipment_bounds;                                             ///< Shipment lines list
+    struct supplies_line shipment[SUPPLIES_SHIPMENT_MAX];                  ///< Lines, one per item
+    char shipment_lines[SUPPLIES_SHIPMENT_MAX][SUPPLIES_LIST_LINE_LENGTH]; ///< Text of each line
+    const char *shipment_line_ptrs[SUPPLIES_SHIPMENT_MAX];                 ///< Lines for GuiListViewEx
+    int shipment_count;                                                    ///< Entries used in shipment
+    int shipment_scroll;                                                   ///< List scroll index
+    int shipment_active;                                                   ///< Selected line, -1 if none
+    int shipment_focus;                                                    ///< Focused line, -1 if none
+    int received_lines;                                                    ///< Lines of the last shipment received
+    long long received_units;                                              ///< Units of the last shipment received
+
+    Rectangle totals_bounds;                                                 ///< Category totals list
+    char total_lines[SUPPLIES_CATEGORY_LIST_MAX][SUPPLIES_LIST_LINE_LENGTH]; ///< Text of each category
+    const char *total_line_ptrs[SUPPLIES_CATEGORY_LIST_MAX];                 ///< Lines for GuiListViewEx
+    int total_count;                                                         ///< Entries used in total_lines
+    int total_scroll;                                                        ///< List scroll index
+    int total_active;                                                        ///< Selected category, -1 if none
+    bool totals_stale;                                                       ///< Read the totals again on the next frame
+
+    struct scrollpanel sp_table_view; ///< A scrollpanel to view the supplies database
+    char *str_table_content;          ///< The content shown on the table view (MUST BE FREED IF ALLOCATED)
 
     enum supplies_screen_flags flag; ///< Flags for the struct
 };
@@ -0,0 +1,87 @@
+/**
+ * @file utils_date.h
+ * @brief Calendar Date Utilities
+ *
+ * Dates are stored in the database as day numbers (days since 1970-01-01), which makes
+ * range queries plain integer comparisons on an index. These helpers convert between
+ * day numbers, calendar components and the "YYYY-MM-DD" text shown to the user.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_DATE_H
+#define UTILS_DATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def DATE_INVALID
+ * @brief Day number returned for invalid or missing dates
+ */
+#define DATE_INVALID INT32_MIN
+
+/**
+ * @def DATE_STR_LEN
+ * @brief Buffer size for a "YYYY-MM-DD" date (including null terminator)
+ */
+#define DATE_STR_LEN 11
+
+/**
+ * @brief Validates a date's components
+ *
+ * Checks if the provided year, month, and day form a valid calendar date,
+ * including leap year handling for February.
+ *
+ * @param[in] year The year component (1-9999)
+ * @param[in] month The month component (1-12)
+ * @param[in] day The day component (1-31, depending on month)
+ * @return true if the date is valid, false otherwise
+ * @note Uses Gregorian calendar rules for leap years
+ */
+bool validate_date(int year, int month, int day);
+
+/**
+ * @brief Converts a calendar date to a day number
+ *
+ * @param[in] year The year component (1-9999)
+ * @param[in] month The month component (1-12)
+ * @param[in] day The day component
+ * @return Days since 1970-01-01 (negative before it), or DATE_INVALID if the date is not valid
+ */
+int32_t date_to_days(int year, int month, int day);
+
+/**
+ * @brief Converts a day number back to calendar components
+ *
+ * @param[in] days Day number as returned by date_to_days()
+ * @param[out] year Year component
+ * @param[out] month Month component (1-12)
+ * @param[out] day Day component (1-31)
+ */
+void date_from_days(int32_t days, int *year, int *month, int *day);
+
+/**
+ * @brief Parses a "YYYY-MM-DD" date
+ *
+ * @param[in] text Date text, exactly 10 characters
+ * @return Day number, or DATE_INVALID if text is NULL, malformed or not a valid date
+ */
+int32_t date_parse(const char *text);
+
+/**
+ * @brief Formats a day number as "YYYY-MM-DD"
+ *
+ * @param[in] days Day number, DATE_INVALID gives an empty string
+ * @param[out] out Buffer of at least DATE_STR_LEN bytes
+ */
+void date_format(int32_t days, char out[DATE_STR_LEN]);
+
+/**
+ * @brief Day number of the current local date
+ *
+ * @return Days since 1970-01-01 of today in the local time zone
+ */
+int32_t date_today(void);
+
+#endif // UTILS_DATE_H
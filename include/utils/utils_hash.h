@@ -4,13 +4,70 @@
  * 
  * Provides cryptographic functions for secure password handling including
  * salt generation and password hashing using OpenSSL's SHA-256.
+ *
+ * Passwords are derived through a small KDF layer: each stored hash records the function
+ * (enum password_kdf) and cost it was made with, so the cost can be raised over time and old
+ * hashes keep verifying until they are replaced. New hashes use PBKDF2-HMAC-SHA256 with the
+ * iteration count set by password_kdf_set_iterations(), usually the result of
+ * password_kdf_calibrate() at startup. The single SHA-256 of hash_password() is kept to
+ * verify accounts created before the KDF existed.
  */
 
 #ifndef UTILS_HASH_H
 #define UTILS_HASH_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * @def PASSWORD_KDF_MIN_ITERATIONS
+ * @brief Lowest PBKDF2 iteration count accepted for new hashes
+ */
+#define PASSWORD_KDF_MIN_ITERATIONS 10000
+
+/**
+ * @def PASSWORD_KDF_MAX_ITERATIONS
+ * @brief Highest PBKDF2 iteration count, calibration on a fast machine stops here
+ */
+#define PASSWORD_KDF_MAX_ITERATIONS 10000000
+
+/**
+ * @def PASSWORD_KDF_DEFAULT_ITERATIONS
+ * @brief Iteration count of new hashes until password_kdf_set_iterations() is called
+ */
+#define PASSWORD_KDF_DEFAULT_ITERATIONS 200000
+
+/**
+ * @def PASSWORD_KDF_TARGET_MS
+ * @brief Verify time password_kdf_calibrate() aims for at startup
+ */
+#define PASSWORD_KDF_TARGET_MS 250.0
+
+/**
+ * @def PASSWORD_KDF_UPGRADE_PERCENT
+ * @brief A stored hash is rehashed once its iteration count is below this percentage of the current one
+ */
+#define PASSWORD_KDF_UPGRADE_PERCENT 75
+
+/**
+ * @enum password_kdf
+ * @brief Function a stored password hash was derived with (stored as an integer, never renumber)
+ */
+enum password_kdf {
+    PASSWORD_KDF_SHA256 = 0,        ///< Legacy single SHA-256 of password || salt, see hash_password()
+    PASSWORD_KDF_PBKDF2_SHA256 = 1, ///< PBKDF2-HMAC-SHA256, 32-byte key
+    PASSWORD_KDF_COUNT              ///< Number of functions, not a function
+};
+
+/**
+ * @struct password_kdf_params
+ * @brief How a password hash is derived
+ */
+struct password_kdf_params {
+    enum password_kdf kdf; ///< Function
+    int iterations;        ///< Cost (ignored by PASSWORD_KDF_SHA256)
+};
+
 /**
  * @brief Generates a cryptographically secure random salt
  * 
@@ -21,6 +78,8 @@
  * @param[in] len Length of salt to generate (typically SALT_LEN)
  * @warning Uses OpenSSL's RAND_bytes() which must be properly seeded
  * @note Always null-terminates the salt string
+ * @note The salt is made of letters, digits, '.' and '/' (6 bits per character), so it never
+ *       holds a null byte and survives being stored as TEXT
  */
 void generate_salt(char *salt, size_t len);
 
@@ -47,4 +106,71 @@ void generate_salt(char *salt, size_t len);
  */
 void hash_password(const char *password, const char *salt, char *hash_out);
 
+/**
+ * @brief Hashes a password with a given salt and KDF
+ *
+ * @param[in] password Plaintext password to hash
+ * @param[in] salt Salt value (null terminated)
+ * @param[in] params Function and cost
+ * @param[out] hash_out Buffer to store hex-encoded hash (must be at least 65 bytes)
+ * @return true on success, false if the function is unknown or the cost is not positive
+ */
+bool hash_password_kdf(const char *password, const char *salt, struct password_kdf_params params, char *hash_out);
+
+/**
+ * @brief Checks a password against a stored hash
+ *
+ * @param[in] password Plaintext password to check
+ * @param[in] salt Salt stored with the hash
+ * @param[in] params Function and cost stored with the hash
+ * @param[in] expected_hash Stored hex-encoded hash
+ * @return true if the password matches, false otherwise (compared in constant time)
+ */
+bool verify_password(
+    const char *password,
+    const char *salt,
+    struct password_kdf_params params,
+    const char *expected_hash
+);
+
+/**
+ * @brief Function and cost new hashes are made with
+ *
+ * @return PBKDF2-HMAC-SHA256 with the current iteration count
+ */
+struct password_kdf_params password_kdf_current(void);
+
+/**
+ * @brief Sets the iteration count of new hashes
+ *
+ * Safe to call while other threads hash.
+ *
+ * @param[in] iterations Iteration count, clamped to PASSWORD_KDF_MIN_ITERATIONS..PASSWORD_KDF_MAX_ITERATIONS
+ */
+void password_kdf_set_iterations(int iterations);
+
+/**
+ * @brief Whether a stored hash is weaker than what new hashes get
+ *
+ * @param[in] stored Function and cost of the stored hash
+ * A count just below the current one is kept: the calibration moves a little from one start to
+ * the next, rehashing on every such move would buy nothing.
+ *
+ * @return true if it uses another function or fewer than PASSWORD_KDF_UPGRADE_PERCENT of the
+ *         iterations of password_kdf_current()
+ */
+bool password_kdf_needs_upgrade(struct password_kdf_params stored);
+
+/**
+ * @brief Measures this machine and picks the PBKDF2 iteration count that takes target_ms
+ *
+ * Runs PBKDF2 with a growing count until a run takes at least 1/8 of the target (well under
+ * target_ms in total), then scales it and rounds it down to a power of two, so timing noise
+ * gives the same count from one start to the next. Does not change the current count.
+ *
+ * @param[in] target_ms Wanted time of one verification, in milliseconds
+ * @return Iteration count, a power of two or PASSWORD_KDF_MIN_ITERATIONS, at most PASSWORD_KDF_MAX_ITERATIONS
+ */
+int password_kdf_calibrate(double target_ms);
+
 #endif // UTILS_HASH_H
@@ -0,0 +1,77 @@
+/**
+ * @file utils_intmap.h
+ * @brief Integer Hash Map
+ *
+ * Small open addressing hash map from a 64-bit key to a non-negative int, used by the
+ * in-memory indexes to find the slot of a row by its key (BatchId, ID, ...) in O(1).
+ * Deletion shifts entries back instead of leaving tombstones, so lookups stay short
+ * under constant insert/delete traffic.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_INTMAP_H
+#define UTILS_INTMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct intmap
+ * @brief Hash map from int64_t keys to non-negative int values
+ *
+ * @note Zero-initialize, or call intmap_init() to size it up front.
+ */
+struct intmap {
+    int64_t *keys;   ///< Key of each bucket
+    int *values;     ///< Value of each bucket, -1 when the bucket is empty
+    size_t capacity; ///< Number of buckets (power of two, 0 before the first insert)
+    size_t count;    ///< Number of keys stored
+};
+
+/**
+ * @brief Initializes a map with room for at least expected keys without growing
+ *
+ * @param[out] map Map to initialize
+ * @param[in] expected Expected number of keys (0 allocates on the first insert)
+ * @return true on success, false on allocation failure
+ */
+bool intmap_init(struct intmap *map, size_t expected);
+
+/**
+ * @brief Releases the map memory and leaves it empty (it can be reused)
+ *
+ * @param[in,out] map Map to release
+ */
+void intmap_free(struct intmap *map);
+
+/**
+ * @brief Inserts a key or replaces its value
+ *
+ * @param[in,out] map Map
+ * @param[in] key Key
+ * @param[in] value Value, must be >= 0
+ * @return true on success, false on allocation failure or negative value
+ */
+bool intmap_put(struct intmap *map, int64_t key, int value);
+
+/**
+ * @brief Looks up a key
+ *
+ * @param[in] map Map
+ * @param[in] key Key
+ * @return The value, or -1 if the key is not in the map
+ */
+int intmap_get(const struct intmap *map, int64_t key);
+
+/**
+ * @brief Removes a key
+ *
+ * @param[in,out] map Map
+ * @param[in] key Key, unknown keys are ignored
+ * @return The value the key had, or -1 if it was not in the map
+ */
+int intmap_remove(struct intmap *map, int64_t key);
+
+#endif // UTILS_INTMAP_H
@@ -0,0 +1,119 @@
+/**
+ * @file utils_name.h
+ * @brief Person Name Matching Utilities
+ *
+ * Helpers to compare person names typed by different people at intake, where the same
+ * resident may be registered as "Luiz Souza" one day and "Luis Sousa" the next.
+ *
+ * - name_normalize() folds case and accents and drops punctuation.
+ * - name_hash() hashes the normalized name, to group records typed with different case or accents.
+ * - name_phonetic_key() encodes how a name sounds in Portuguese, used as an indexed column
+ *   to find candidates quickly and to block the dedupe report.
+ * - name_trigrams() / name_trigram_similarity() give a spelling distance that survives typos.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_NAME_H
+#define UTILS_NAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def NAME_KEY_LEN
+ * @brief Buffer size for a phonetic key (including null terminator)
+ */
+#define NAME_KEY_LEN 32
+
+/**
+ * @def NAME_MAX_TRIGRAMS
+ * @brief Maximum number of distinct trigrams kept for one name
+ */
+#define NAME_MAX_TRIGRAMS 96
+
+/**
+ * @def NAME_TRIGRAM_SPACE
+ * @brief Number of distinct trigram codes (37 symbols: space, a-z and 0-9)
+ */
+#define NAME_TRIGRAM_SPACE (37 * 37 * 37)
+
+/**
+ * @brief Normalizes a name for comparison
+ *
+ * Lowercases ASCII, folds Latin-1 accented letters encoded in UTF-8 to their base letter
+ * ("João" -> "joao", "Conceição" -> "conceicao"), turns any other character into a separator
+ * and collapses separators into single spaces without leading or trailing ones.
+ *
+ * @param[in] name Name as typed (UTF-8)
+ * @param[out] out Buffer for the normalized name
+ * @param[in] out_size Size of out
+ * @return Length of the normalized name (0 if the name has no letters or digits)
+ */
+size_t name_normalize(const char *name, char *out, size_t out_size);
+
+/**
+ * @brief Hashes the normalized name (64-bit FNV-1a)
+ *
+ * Names that normalize to the same string ("Feijão", "feijao") have the same hash, which
+ * is used as an integer key to group records by name.
+ *
+ * @param[in] name Name as typed (UTF-8)
+ * @return Hash of name_normalize(name)
+ */
+uint64_t name_hash(const char *name);
+
+/**
+ * @brief Computes the Portuguese phonetic key of a name
+ *
+ * The key is the phonetic code of the first and last significant words of the name, so
+ * middle names and particles (da, de, do, das, dos, e) do not change it.
+ * Each word is encoded with rules for Brazilian Portuguese spelling: silent h, ch/sh/x,
+ * lh, nh, ph/f, qu/k, c and g before e/i, s between vowels, final z, y/i and w/v. Only
+ * the first vowel of each word is kept and repeated sounds collapse.
+ *
+ * Examples: "Luiz Souza" and "Luis Sousa" -> "LS SZ", "Thiago" and "Tiago" -> "TG".
+ *
+ * @param[in] name Name as typed (UTF-8)
+ * @param[out] key Buffer of at least NAME_KEY_LEN bytes
+ * @return Length of the key (0 if the name has no letters)
+ */
+size_t name_phonetic_key(const char *name, char key[NAME_KEY_LEN]);
+
+/**
+ * @brief Extracts the distinct trigrams of a name
+ *
+ * Every significant word is padded with one space on each side ("ana" -> " an", "ana", "na ")
+ * and each trigram is encoded as an integer below NAME_TRIGRAM_SPACE. The result is sorted,
+ * which makes set intersection a linear merge.
+ *
+ * @param[in] name Name as typed (UTF-8)
+ * @param[out] trigrams Array of at least NAME_MAX_TRIGRAMS entries
+ * @return Number of distinct trigrams written
+ */
+int name_trigrams(const char *name, uint16_t trigrams[NAME_MAX_TRIGRAMS]);
+
+/**
+ * @brief Jaccard similarity of two sorted trigram sets
+ *
+ * @param[in] a First set, as returned by name_trigrams()
+ * @param[in] a_count Size of a
+ * @param[in] b Second set, as returned by name_trigrams()
+ * @param[in] b_count Size of b
+ * @return Shared trigrams divided by distinct trigrams, 0.0 to 1.0
+ */
+float name_trigram_similarity(const uint16_t *a, int a_count, const uint16_t *b, int b_count);
+
+/**
+ * @brief Similarity score of two names, combining spelling and sound
+ *
+ * Returns the trigram similarity, raised to 0.5 + similarity / 2 when both names have the
+ * same phonetic key, so names that sound alike but are spelled differently still score high.
+ *
+ * @param[in] a First name (UTF-8)
+ * @param[in] b Second name (UTF-8)
+ * @return Score between 0.0 (nothing in common) and 1.0 (same name)
+ */
+float name_similarity(const char *a, const char *b);
+
+#endif // UTILS_NAME_H
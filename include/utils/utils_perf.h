@@ -0,0 +1,83 @@
+/**
+ * @file utils_perf.h
+ * @brief Performance Probes
+ *
+ * Building blocks of the performance overlay: a monotonic clock for timing probes, the
+ * resident memory of the process, and a fixed ring of samples keeping the last
+ * PERF_RING_SIZE values (one per frame) for graphs and averages.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_PERF_H
+#define UTILS_PERF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def PERF_RING_SIZE
+ * @brief Samples kept by a perf_ring, four seconds of frames at 60 FPS
+ */
+#define PERF_RING_SIZE 240
+
+/**
+ * @struct perf_ring
+ * @brief The last PERF_RING_SIZE samples, the oldest overwritten first
+ *
+ * @note Zero-initialize before use.
+ */
+struct perf_ring {
+    float samples[PERF_RING_SIZE]; ///< Samples, samples[head] is the next one overwritten
+    int head;                      ///< Index of the next sample written
+    int count;                     ///< Samples held (at most PERF_RING_SIZE)
+};
+
+/**
+ * @brief Monotonic time for measuring durations
+ *
+ * @return Nanoseconds since an arbitrary point in the past
+ */
+uint64_t perf_now_ns(void);
+
+/**
+ * @brief Resident set size of the process
+ *
+ * @return Bytes of the process in physical memory, 0 where it can't be read
+ */
+size_t perf_rss_bytes(void);
+
+/**
+ * @brief Adds a sample, dropping the oldest one if the ring is full
+ *
+ * @param[in,out] ring Ring
+ * @param[in] sample Sample
+ */
+void perf_ring_push(struct perf_ring *ring, float sample);
+
+/**
+ * @brief Sample by age
+ *
+ * @param[in] ring Ring
+ * @param[in] age 0 for the latest sample, 1 for the one before, ... (below ring->count)
+ * @return The sample, 0 if age is out of range
+ */
+float perf_ring_get(const struct perf_ring *ring, int age);
+
+/**
+ * @brief Largest sample held
+ *
+ * @param[in] ring Ring
+ * @return Largest sample, 0 if the ring is empty
+ */
+float perf_ring_max(const struct perf_ring *ring);
+
+/**
+ * @brief Average of the samples held
+ *
+ * @param[in] ring Ring
+ * @return Average, 0 if the ring is empty
+ */
+float perf_ring_avg(const struct perf_ring *ring);
+
+#endif // UTILS_PERF_H
@@ -0,0 +1,140 @@
+/**
+ * @file utils_queue.h
+ * @brief Bounded Lock-Free Queues
+ *
+ * Fixed-size queues of pointers that hand work from thread to thread without a mutex:
+ *
+ * - spsc_queue, one producer and one consumer. Each side keeps its own index and a cached
+ *   copy of the other's, so a push or pop touches the other thread's cache line only when
+ *   the queue looks full or empty;
+ *
+ * - mpsc_queue, any number of producers and one consumer. Producers claim a slot with a
+ *   compare-and-swap on the tail and publish it through the slot's sequence number, so a
+ *   slow producer never blocks the others.
+ *
+ * Push fails when the queue is full and pop returns NULL when it is empty, the caller decides
+ * whether to retry, yield or drop. That is what gives a pipeline its backpressure: a full
+ * queue stalls the stage before it instead of growing without bound.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_QUEUE_H
+#define UTILS_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def QUEUE_CACHE_LINE
+ * @brief Bytes kept between the indexes written by different threads
+ */
+#define QUEUE_CACHE_LINE 64
+
+/**
+ * @struct spsc_queue
+ * @brief Single producer, single consumer queue
+ */
+struct spsc_queue {
+    void **slots;                                     ///< Items, indexed by position & mask
+    size_t mask;                                      ///< Capacity - 1 (capacity is a power of two)
+    char pad0[QUEUE_CACHE_LINE];                      ///< Keeps head off the line of the fields above
+    atomic_size_t head;                               ///< Next position to pop, written by the consumer
+    size_t cached_tail;                               ///< Consumer's last read of tail
+    char pad1[QUEUE_CACHE_LINE - 2 * sizeof(size_t)]; ///< Keeps the producer's fields off the consumer's line
+    atomic_size_t tail;                               ///< Next position to push, written by the producer
+    size_t cached_head;                               ///< Producer's last read of head
+    char pad2[QUEUE_CACHE_LINE - 2 * sizeof(size_t)]; ///< Keeps whatever follows off the producer's line
+};
+
+/**
+ * @brief Allocates an empty queue
+ *
+ * @param[out] queue Queue to initialize
+ * @param[in] capacity Items it holds, rounded up to a power of two
+ * @return true on success, false on allocation failure
+ */
+bool spsc_queue_init(struct spsc_queue *queue, size_t capacity);
+
+/**
+ * @brief Frees the slots (not the items still queued)
+ *
+ * @param[in,out] queue Queue
+ */
+void spsc_queue_free(struct spsc_queue *queue);
+
+/**
+ * @brief Appends an item, from the producer thread only
+ *
+ * @param[in,out] queue Queue
+ * @param[in] item Item, not NULL
+ * @return true if queued, false if the queue is full
+ */
+bool spsc_queue_push(struct spsc_queue *queue, void *item);
+
+/**
+ * @brief Takes the oldest item, from the consumer thread only
+ *
+ * @param[in,out] queue Queue
+ * @return Item, NULL if the queue is empty
+ */
+void *spsc_queue_pop(struct spsc_queue *queue);
+
+/**
+ * @internal
+ * @brief Slot of an mpsc_queue
+ */
+struct mpsc_slot {
+    atomic_size_t sequence; ///< Position the slot is ready to be pushed at, position + 1 once filled
+    void *item;             ///< Item, valid once sequence says so
+};
+
+/**
+ * @struct mpsc_queue
+ * @brief Multiple producers, single consumer queue
+ */
+struct mpsc_queue {
+    struct mpsc_slot *slots;                      ///< Slots, indexed by position & mask
+    size_t mask;                                  ///< Capacity - 1 (capacity is a power of two)
+    char pad0[QUEUE_CACHE_LINE];                  ///< Keeps tail off the line of the fields above
+    atomic_size_t tail;                           ///< Next position to claim, shared by the producers
+    char pad1[QUEUE_CACHE_LINE - sizeof(size_t)]; ///< Keeps head off the producers' line
+    size_t head;                                  ///< Next position to pop, owned by the consumer
+    char pad2[QUEUE_CACHE_LINE - sizeof(size_t)]; ///< Keeps whatever follows off the consumer's line
+};
+
+/**
+ * @brief Allocates an empty queue
+ *
+ * @param[out] queue Queue to initialize
+ * @param[in] capacity Items it holds, rounded up to a power of two (at least 2)
+ * @return true on success, false on allocation failure
+ */
+bool mpsc_queue_init(struct mpsc_queue *queue, size_t capacity);
+
+/**
+ * @brief Frees the slots (not the items still queued)
+ *
+ * @param[in,out] queue Queue
+ */
+void mpsc_queue_free(struct mpsc_queue *queue);
+
+/**
+ * @brief Appends an item, from any thread
+ *
+ * @param[in,out] queue Queue
+ * @param[in] item Item, not NULL
+ * @return true if queued, false if the queue is full
+ */
+bool mpsc_queue_push(struct mpsc_queue *queue, void *item);
+
+/**
+ * @brief Takes the oldest published item, from the consumer thread only
+ *
+ * @param[in,out] queue Queue
+ * @return Item, NULL if the queue is empty (or the next slot is claimed but not yet filled)
+ */
+void *mpsc_queue_pop(struct mpsc_queue *queue);
+
+#endif // UTILS_QUEUE_H
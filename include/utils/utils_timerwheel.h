@@ -0,0 +1,118 @@
+/**
+ * @file utils_timerwheel.h
+ * @brief Hierarchical Timing Wheel
+ *
+ * Keeps thousands of timers so that checking which ones are due costs O(1) per tick instead
+ * of a scan over all of them. Time is an integer tick count (the dose schedule uses minutes).
+ *
+ * There are TIMER_WHEEL_LEVELS wheels of TIMER_WHEEL_SLOTS slots. Level 0 holds the timers due
+ * in the next 64 ticks, one slot per tick; each level above covers 64 times the span of the one
+ * below, so 4 levels reach 64^4 ticks (about 31 years in minutes). When a lower wheel wraps
+ * around, the timers of the next slot of the wheel above are moved down (cascaded), each timer
+ * moves at most once per level.
+ *
+ * Timers live in a pool and are addressed by a stable id, slots are intrusive doubly linked
+ * lists of ids, so adding and cancelling are O(1) and nothing is allocated per timer once the
+ * pool has grown.
+ *
+ * None of these depend on raylib or SQLite.
+ */
+
+#ifndef UTILS_TIMERWHEEL_H
+#define UTILS_TIMERWHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_BITS 6                        ///< Bits of the tick per level
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS) ///< Slots per level
+#define TIMER_WHEEL_LEVELS 4                      ///< Number of levels
+
+/**
+ * @brief Called for each timer that fires
+ *
+ * The timer is already released when this runs, so the callback may add timers (to reschedule).
+ *
+ * @param ctx User context passed to timer_wheel_advance()
+ * @param id Id the timer had
+ * @param payload Payload given when the timer was added
+ * @param expires Tick the timer was set to
+ */
+typedef void (*timer_wheel_callback)(void *ctx, int id, int payload, int64_t expires);
+
+/**
+ * @struct timer_wheel_node
+ * @brief Timer in the pool (internal)
+ */
+struct timer_wheel_node {
+    int64_t expires; ///< Tick the timer fires at
+    int payload;     ///< User payload
+    int slot;        ///< level * TIMER_WHEEL_SLOTS + slot, -1 when the node is free
+    int next;        ///< Next node in the slot (or in the free list), -1 at the end
+    int prev;        ///< Previous node in the slot, -1 at the head
+};
+
+/**
+ * @struct timer_wheel
+ * @brief Hierarchical timing wheel
+ *
+ * @note Initialize with timer_wheel_init(), release with timer_wheel_free()
+ */
+struct timer_wheel {
+    int64_t current;                                       ///< Last tick processed
+    int heads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 1]; ///< First node of each slot (last: being fired), -1 if empty
+    struct timer_wheel_node *nodes;                        ///< Timer pool
+    int node_capacity;                                     ///< Nodes allocated
+    int node_used;                                         ///< Nodes handed out at least once
+    int free_head;                                         ///< First released node, -1 if none
+    int count;                                             ///< Timers pending
+};
+
+/**
+ * @brief Initializes an empty wheel
+ *
+ * @param[out] tw Wheel to initialize
+ * @param[in] now Current tick, timers set at or before it fire on the next advance
+ */
+void timer_wheel_init(struct timer_wheel *tw, int64_t now);
+
+/**
+ * @brief Releases the wheel memory (it can be initialized again)
+ *
+ * @param[in,out] tw Wheel to release
+ */
+void timer_wheel_free(struct timer_wheel *tw);
+
+/**
+ * @brief Adds a timer
+ *
+ * @param[in,out] tw Wheel
+ * @param[in] expires Tick the timer fires at (ticks already processed fire on the next advance)
+ * @param[in] payload User payload passed back to the callback
+ * @return Timer id (>= 0), or -1 on allocation failure
+ */
+int timer_wheel_add(struct timer_wheel *tw, int64_t expires, int payload);
+
+/**
+ * @brief Cancels a pending timer
+ *
+ * @param[in,out] tw Wheel
+ * @param[in] id Timer id returned by timer_wheel_add()
+ * @return true if the timer was pending, false if it already fired or was cancelled
+ */
+bool timer_wheel_cancel(struct timer_wheel *tw, int id);
+
+/**
+ * @brief Processes every tick up to now and fires the timers due
+ *
+ * Returns immediately when now was already processed, so it can be called every frame.
+ *
+ * @param[in,out] tw Wheel
+ * @param[in] now Current tick
+ * @param[in] callback Function called for each timer that fires (may be NULL)
+ * @param[in] ctx User context passed to callback
+ * @return Number of timers fired
+ */
+int timer_wheel_advance(struct timer_wheel *tw, int64_t now, timer_wheel_callback callback, void *ctx);
+
+#endif // UTILS_TIMERWHEEL_H
@@ -11,6 +11,8 @@
 
 #include <stdbool.h>
 
+#include "utils/utils_date.h" // validate_date() lives there, kept available to existing includers
+
 /**
  * @def SET_FLAG(flag, flags)
  * @brief Sets specified bits in a flag variable
@@ -90,17 +92,18 @@ void wrap_text(const char *input, char *output, const int wrap_width);
 void filter_integer_input(char *input, const int max_len);
 
 /**
- * @brief Validates a date's components
+ * @brief Replaces, removes or appends one row of a formatted table
  *
- * Checks if the provided year, month, and day form a valid calendar date,
- * including leap year handling for February.
+ * The table is text as the *_get_all_format() functions write it: a header, then each row as a
+ * line "| key | ... |" followed by a separator line. The row whose first cell, spaces trimmed,
+ * is key gets replaced by block, or removed with its separator when block is NULL. When no row
+ * has that key, block is appended at the end.
  *
- * @param[in] year The year component (1-9999)
- * @param[in] month The month component (1-12)
- * @param[in] day The day component (1-31, depending on month)
- * @return true if the date is valid, false otherwise
- * @note Uses Gregorian calendar rules for leap years
+ * @param[in,out] text Table allocated with malloc(), reallocated when it grows
+ * @param[in] key First cell of the row
+ * @param[in] block Row and separator lines, NULL to remove the row
+ * @return 0 on success, -1 on allocation failure (text is unchanged)
  */
-bool validate_date(int year, int month, int day);
+int table_text_patch(char **text, const char *key, const char *block);
 
 #endif //UTILSFN_H
@@ -6,6 +6,12 @@
 #include "db/clothes_db.h"
 
 #include <stdio.h>
+#include <string.h>
+
+// Columns read by clothes_db_read_row, in order
+#define CLOTHES_SELECT "SELECT ID, Type, Size, Gender, Color, Quantity, Condition, Notes FROM Clothes"
+
+static void clothes_db_read_row(sqlite3_stmt *stmt, struct clothes *clothes);
 
 int clothes_db_create_table(database *db) {
     if (!db_is_init(db)) {
@@ -28,7 +34,7 @@ int clothes_db_create_table(database *db) {
 
     char *errMsg = 0;
     int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
-    
+
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL error on init Clothes table: %s\n", errMsg);
         sqlite3_free(errMsg);
@@ -36,4 +42,345 @@ int clothes_db_create_table(database *db) {
     }
 
     return SQLITE_OK;
-}
\ No newline at end of file
+}
+
+int clothes_db_insert(
+    database *db,
+    const char *type,
+    const char *size,
+    const char *gender,
+    const char *color,
+    int quantity,
+    const char *condition,
+    const char *notes,
+    int *id
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql =
+        "INSERT INTO Clothes (Type, Size, Gender, Color, Quantity, Condition, Notes) VALUES (?, ?, ?, ?, ?, ?, ?);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    // Empty strings rather than NULL, so the UNIQUE constraint also holds for unset attributes
+    sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, gender, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, color, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, quantity);
+    sqlite3_bind_text(stmt, 6, condition, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, notes, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (id) {
+        *id = (int)sqlite3_last_insert_rowid(db->db);
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int clothes_db_update(
+    database *db,
+    int id,
+    const char *type,
+    const char *size,
+    const char *gender,
+    const char *color,
+    int quantity,
+    const char *condition,
+    const char *notes
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct clothes current;
+    int rc = clothes_db_get_by_id(db, id, &current);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    const char *sql =
+        "UPDATE Clothes SET Type = ?, Size = ?, Gender = ?, Color = ?, Quantity = ?, Condition = ?, Notes = ? "
+        "WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    // Decide which fields to use for update based on inputs
+    sqlite3_bind_text(stmt, 1, type[0] != '\0' ? type : current.type, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, size[0] != '\0' ? size : current.size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, gender[0] != '\0' ? gender : current.gender, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, color[0] != '\0' ? color : current.color, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, quantity >= 0 ? quantity : current.quantity);
+    sqlite3_bind_text(stmt, 6, condition[0] != '\0' ? condition : current.condition, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, notes[0] != '\0' ? notes : current.notes, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 8, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int clothes_db_delete_by_id(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "DELETE FROM Clothes WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (sqlite3_changes(db->db) == 0) {
+        fprintf(stderr, "Clothes ID not found in the database.\n");
+        rc = SQLITE_NOTFOUND;
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+bool clothes_db_check_id_exists(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return false;
+    }
+
+    const char *sql = "SELECT 1 FROM Clothes WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+int clothes_db_get_by_id(database *db, int id, struct clothes *clothes) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = CLOTHES_SELECT " WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        clothes_db_read_row(stmt, clothes);
+        rc = SQLITE_OK;
+    } else if (rc == SQLITE_DONE) {
+        fprintf(stderr, "No clothes found with ID: %d\n", id);
+        rc = SQLITE_NOTFOUND;
+    } else {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int clothes_db_get_count(database *db) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql = "SELECT COUNT(*) FROM Clothes;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+int clothes_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    const char *sql = CLOTHES_SELECT " ORDER BY ID;";
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    size_t written = 0;
+
+    const char *header =
+        "+------------------------------------------------------------------------------------------+\n"
+        "| ID    | Type                 | Size     | Gender   | Color      | Quantity | Condition    |\n"
+        "+-------+----------------------+----------+----------+------------+----------+--------------+\n";
+
+    size_t header_len = strlen(header);
+    if (header_len >= buffer_size) {
+        sqlite3_finalize(stmt);
+        fprintf(stderr, "Header truncated\n");
+        return -1;
+    }
+    memcpy(buffer, header, header_len + 1);
+    written = header_len;
+
+    struct clothes clothes;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        clothes_db_read_row(stmt, &clothes);
+
+        char row[512];
+        snprintf(
+            row,
+            sizeof(row),
+            "| %5d | %-20.20s | %-8.8s | %-8.8s | %-10.10s | %-8d | %-12.12s |\n"
+            "+-------+----------------------+----------+----------+------------+----------+--------------+\n",
+            clothes.id,
+            clothes.type,
+            clothes.size,
+            clothes.gender,
+            clothes.color,
+            clothes.quantity,
+            clothes.condition
+        );
+
+        size_t row_len = strlen(row);
+        if (written + row_len >= buffer_size) {
+            sqlite3_finalize(stmt);
+            fprintf(stderr, "Buffer too small, output truncated\n");
+            return -1;
+        }
+        memcpy(buffer + written, row, row_len + 1);
+        written += row_len;
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return (int)written;
+}
+
+int clothes_db_for_each(database *db, clothes_callback callback, void *ctx) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql = CLOTHES_SELECT " ORDER BY ID;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+    struct clothes clothes;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        clothes_db_read_row(stmt, &clothes);
+        count++;
+        if (callback && callback(ctx, &clothes) != 0) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        count = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+/**
+ * @internal
+ * @brief Fills a clothes record from a row selected with CLOTHES_SELECT
+ */
+static void clothes_db_read_row(sqlite3_stmt *stmt, struct clothes *clothes) {
+    const char *text;
+    memset(clothes, 0, sizeof(*clothes));
+    clothes->id = sqlite3_column_int(stmt, 0);
+    text = (const char *)sqlite3_column_text(stmt, 1);
+    snprintf(clothes->type, sizeof(clothes->type), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 2);
+    snprintf(clothes->size, sizeof(clothes->size), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 3);
+    snprintf(clothes->gender, sizeof(clothes->gender), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 4);
+    snprintf(clothes->color, sizeof(clothes->color), "%s", text ? text : "");
+    clothes->quantity = sqlite3_column_int(stmt, 5);
+    text = (const char *)sqlite3_column_text(stmt, 6);
+    snprintf(clothes->condition, sizeof(clothes->condition), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 7);
+    snprintf(clothes->notes, sizeof(clothes->notes), "%s", text ? text : "");
+}
@@ -0,0 +1,431 @@
+/**
+ * @file clothes_index.c
+ * @brief Clothes attribute matching implementation
+ */
+#include "db/clothes_index.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/clothes_db.h"
+#include "utils/utils_intmap.h"
+#include "utils/utils_name.h"
+
+struct clothes_value {
+    char name[MAX_INPUT]; // As first seen, shown back by clothes_index_row
+    uint64_t *bits;       // One bit per row position, row_capacity / 64 words
+};
+
+struct clothes_dictionary {
+    struct clothes_value *values; // Never removed, so value indexes in queries stay valid
+    int count;
+    int capacity;
+    struct intmap index; // name_hash -> value index
+};
+
+struct clothes_index {
+    // Rows, removal swaps in the last one (and moves its bits)
+    int *id;
+    int *quantity;
+    int *value_of; // value_of[pos * CLOTHES_ATTR_COUNT + attribute]
+    int row_count;
+    int row_capacity;      // Multiple of 64
+    struct intmap row_pos; // Clothes id -> position in the rows
+
+    struct clothes_dictionary attributes[CLOTHES_ATTR_COUNT];
+
+    uint64_t *scratch; // OR of the values of one attribute while matching
+    uint64_t *result;  // AND over the attributes while matching
+
+    unsigned version;
+};
+
+static const char *clothes_attribute_text(const struct clothes *clothes, int attribute) {
+    switch (attribute) {
+    case CLOTHES_ATTR_TYPE:
+        return clothes->type;
+    case CLOTHES_ATTR_SIZE:
+        return clothes->size;
+    case CLOTHES_ATTR_GENDER:
+        return clothes->gender;
+    case CLOTHES_ATTR_COLOR:
+        return clothes->color;
+    default:
+        return clothes->condition;
+    }
+}
+
+static inline void clothes_bit_set(uint64_t *bits, int pos) {
+    bits[pos >> 6] |= (uint64_t)1 << (pos & 63);
+}
+
+static inline void clothes_bit_clear(uint64_t *bits, int pos) {
+    bits[pos >> 6] &= ~((uint64_t)1 << (pos & 63));
+}
+
+/**
+ * @internal
+ * @brief Index of the lowest bit set in a non-zero word
+ */
+static inline int clothes_lowest_bit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static int clothes_find_value(const struct clothes_dictionary *dict, const char *name) {
+    return intmap_get(&dict->index, (int64_t)name_hash(name));
+}
+
+static int clothes_find_or_add_value(struct clothes_index *ci, int attribute, const char *name) {
+    struct clothes_dictionary *dict = &ci->attributes[attribute];
+    int64_t hash = (int64_t)name_hash(name); // "M" and "m" are the same size
+    int index = intmap_get(&dict->index, hash);
+    if (index >= 0) {
+        return index;
+    }
+
+    if (dict->count == dict->capacity) {
+        int capacity = dict->capacity ? dict->capacity * 2 : 16;
+        struct clothes_value *values = realloc(dict->values, sizeof(*values) * (size_t)capacity);
+        if (!values) {
+            return -1;
+        }
+        dict->values = values;
+        dict->capacity = capacity;
+    }
+
+    uint64_t *bits = NULL;
+    if (ci->row_capacity > 0) {
+        bits = calloc((size_t)ci->row_capacity / 64, sizeof(uint64_t));
+        if (!bits) {
+            return -1;
+        }
+    }
+
+    index = dict->count;
+    if (!intmap_put(&dict->index, hash, index)) {
+        free(bits);
+        return -1;
+    }
+
+    struct clothes_value *value = &dict->values[index];
+    snprintf(value->name, sizeof(value->name), "%s", name);
+    value->bits = bits;
+    dict->count++;
+    return index;
+}
+
+/**
+ * @internal
+ * @brief Grows every row array and bitset so one more row fits
+ *
+ * Bitsets are grown one by one; if one fails, those already grown are only larger than needed,
+ * row_capacity is updated once everything succeeded.
+ */
+static bool clothes_reserve_rows(struct clothes_index *ci) {
+    if (ci->row_count < ci->row_capacity) {
+        return true;
+    }
+
+    int capacity = ci->row_capacity ? ci->row_capacity * 2 : 64;
+    size_t old_words = (size_t)ci->row_capacity / 64;
+    size_t words = (size_t)capacity / 64;
+
+    int *id = realloc(ci->id, sizeof(int) * (size_t)capacity);
+    if (!id) {
+        return false;
+    }
+    ci->id = id;
+
+    int *quantity = realloc(ci->quantity, sizeof(int) * (size_t)capacity);
+    if (!quantity) {
+        return false;
+    }
+    ci->quantity = quantity;
+
+    int *value_of = realloc(ci->value_of, sizeof(int) * CLOTHES_ATTR_COUNT * (size_t)capacity);
+    if (!value_of) {
+        return false;
+    }
+    ci->value_of = value_of;
+
+    uint64_t *scratch = realloc(ci->scratch, sizeof(uint64_t) * words);
+    if (!scratch) {
+        return false;
+    }
+    ci->scratch = scratch;
+
+    uint64_t *result = realloc(ci->result, sizeof(uint64_t) * words);
+    if (!result) {
+        return false;
+    }
+    ci->result = result;
+
+    for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+        struct clothes_dictionary *dict = &ci->attributes[a];
+        for (int v = 0; v < dict->count; v++) {
+            uint64_t *bits = realloc(dict->values[v].bits, sizeof(uint64_t) * words);
+            if (!bits) {
+                return false;
+            }
+            memset(bits + old_words, 0, sizeof(uint64_t) * (words - old_words));
+            dict->values[v].bits = bits;
+        }
+    }
+
+    ci->row_capacity = capacity;
+    return true;
+}
+
+struct clothes_load_ctx {
+    struct clothes_index *ci;
+    bool ok;
+};
+
+static int clothes_index_load_row(void *ctx, const struct clothes *clothes) {
+    struct clothes_load_ctx *load = ctx;
+    load->ok = clothes_index_set(load->ci, clothes);
+    return load->ok ? 0 : 1;
+}
+
+struct clothes_index *clothes_index_load(database *clothes_db) {
+    if (!db_is_init(clothes_db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return NULL;
+    }
+
+    struct clothes_index *ci = calloc(1, sizeof(*ci));
+    if (!ci) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    struct clothes_load_ctx load = { ci, true };
+    if (clothes_db_for_each(clothes_db, clothes_index_load_row, &load) < 0 || !load.ok) {
+        fprintf(stderr, "Failed to load the clothes index.\n");
+        clothes_index_free(ci);
+        return NULL;
+    }
+
+    return ci;
+}
+
+bool clothes_index_set(struct clothes_index *ci, const struct clothes *clothes) {
+    if (clothes->quantity <= 0) {
+        clothes_index_remove(ci, clothes->id);
+        return true;
+    }
+
+    // Resolve every value first, a failure here leaves the rows untouched
+    int values[CLOTHES_ATTR_COUNT];
+    for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+        values[a] = clothes_find_or_add_value(ci, a, clothes_attribute_text(clothes, a));
+        if (values[a] < 0) {
+            return false;
+        }
+    }
+
+    int pos = intmap_get(&ci->row_pos, clothes->id);
+    if (pos < 0) {
+        if (!clothes_reserve_rows(ci) || !intmap_put(&ci->row_pos, clothes->id, ci->row_count)) {
+            return false;
+        }
+        pos = ci->row_count++;
+        ci->id[pos] = clothes->id;
+    } else {
+        for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+            clothes_bit_clear(ci->attributes[a].values[ci->value_of[pos * CLOTHES_ATTR_COUNT + a]].bits, pos);
+        }
+    }
+
+    for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+        ci->value_of[pos * CLOTHES_ATTR_COUNT + a] = values[a];
+        clothes_bit_set(ci->attributes[a].values[values[a]].bits, pos);
+    }
+    ci->quantity[pos] = clothes->quantity;
+    ci->version++;
+    return true;
+}
+
+void clothes_index_remove(struct clothes_index *ci, int id) {
+    int pos = intmap_remove(&ci->row_pos, id);
+    if (pos < 0) {
+        return;
+    }
+
+    int last = --ci->row_count;
+    for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+        struct clothes_value *values = ci->attributes[a].values;
+        clothes_bit_clear(values[ci->value_of[pos * CLOTHES_ATTR_COUNT + a]].bits, pos);
+        if (pos != last) {
+            int moved = ci->value_of[last * CLOTHES_ATTR_COUNT + a];
+            clothes_bit_clear(values[moved].bits, last);
+            clothes_bit_set(values[moved].bits, pos);
+            ci->value_of[pos * CLOTHES_ATTR_COUNT + a] = moved;
+        }
+    }
+
+    if (pos != last) {
+        ci->id[pos] = ci->id[last];
+        ci->quantity[pos] = ci->quantity[last];
+        intmap_put(&ci->row_pos, ci->id[pos], pos); // Existing key, never allocates
+    }
+    ci->version++;
+}
+
+void clothes_query_init(struct clothes_query *q) {
+    memset(q, 0, sizeof(*q));
+}
+
+bool clothes_query_allow(
+    struct clothes_query *q,
+    const struct clothes_index *ci,
+    enum clothes_attribute attribute,
+    const char *value
+) {
+    if (q->value_count[attribute] >= CLOTHES_QUERY_MAX_VALUES) {
+        return false;
+    }
+
+    q->restricted[attribute] = true;
+    int index = clothes_find_value(&ci->attributes[attribute], value);
+    if (index >= 0) {
+        q->values[attribute][q->value_count[attribute]++] = index;
+    }
+    return true;
+}
+
+int clothes_index_match(
+    struct clothes_index *ci,
+    const struct clothes_query *q,
+    int *ids,
+    int max,
+    struct clothes_match *match
+) {
+    size_t words = ((size_t)ci->row_count + 63) / 64;
+    uint64_t *result = ci->result;
+    uint64_t *scratch = ci->scratch;
+
+    if (words > 0) {
+        memset(result, 0xff, sizeof(uint64_t) * words);
+        if (ci->row_count % 64 != 0) {
+            result[words - 1] = ((uint64_t)1 << (ci->row_count % 64)) - 1;
+        }
+    }
+
+    for (int a = 0; a < CLOTHES_ATTR_COUNT && words > 0; a++) {
+        if (!q->restricted[a]) {
+            continue;
+        }
+
+        const struct clothes_dictionary *dict = &ci->attributes[a];
+        if (q->value_count[a] == 0) {
+            words = 0; // Only unknown values allowed, nothing matches
+            break;
+        }
+
+        if (q->value_count[a] == 1) {
+            const uint64_t *bits = dict->values[q->values[a][0]].bits;
+            for (size_t w = 0; w < words; w++) {
+                result[w] &= bits[w];
+            }
+            continue;
+        }
+
+        memcpy(scratch, dict->values[q->values[a][0]].bits, sizeof(uint64_t) * words);
+        for (int v = 1; v < q->value_count[a]; v++) {
+            const uint64_t *bits = dict->values[q->values[a][v]].bits;
+            for (size_t w = 0; w < words; w++) {
+                scratch[w] |= bits[w];
+            }
+        }
+        for (size_t w = 0; w < words; w++) {
+            result[w] &= scratch[w];
+        }
+    }
+
+    int written = 0;
+    struct clothes_match totals = { 0 };
+    for (size_t w = 0; w < words; w++) {
+        uint64_t word = result[w];
+        while (word) {
+            int pos = (int)(w * 64) + clothes_lowest_bit(word);
+            word &= word - 1;
+            totals.rows++;
+            totals.total_quantity += ci->quantity[pos];
+            if (written < max) {
+                ids[written++] = ci->id[pos];
+            }
+        }
+    }
+
+    if (match) {
+        *match = totals;
+    }
+    return written;
+}
+
+bool clothes_index_row(const struct clothes_index *ci, int id, struct clothes *clothes) {
+    int pos = intmap_get(&ci->row_pos, id);
+    if (pos < 0) {
+        return false;
+    }
+
+    memset(clothes, 0, sizeof(*clothes));
+    clothes->id = id;
+    clothes->quantity = ci->quantity[pos];
+
+    const int *value_of = &ci->value_of[pos * CLOTHES_ATTR_COUNT];
+    const struct clothes_dictionary *attributes = ci->attributes;
+    snprintf(clothes->type, sizeof(clothes->type), "%s", attributes[CLOTHES_ATTR_TYPE].values[value_of[0]].name);
+    snprintf(clothes->size, sizeof(clothes->size), "%s", attributes[CLOTHES_ATTR_SIZE].values[value_of[1]].name);
+    snprintf(clothes->gender, sizeof(clothes->gender), "%s", attributes[CLOTHES_ATTR_GENDER].values[value_of[2]].name);
+    snprintf(clothes->color, sizeof(clothes->color), "%s", attributes[CLOTHES_ATTR_COLOR].values[value_of[3]].name);
+    snprintf(
+        clothes->condition,
+        sizeof(clothes->condition),
+        "%s",
+        attributes[CLOTHES_ATTR_CONDITION].values[value_of[4]].name
+    );
+    return true;
+}
+
+int clothes_index_count(const struct clothes_index *ci) {
+    return ci->row_count;
+}
+
+unsigned clothes_index_version(const struct clothes_index *ci) {
+    return ci->version;
+}
+
+void clothes_index_free(struct clothes_index *ci) {
+    if (!ci) {
+        return;
+    }
+
+    for (int a = 0; a < CLOTHES_ATTR_COUNT; a++) {
+        struct clothes_dictionary *dict = &ci->attributes[a];
+        for (int v = 0; v < dict->count; v++) {
+            free(dict->values[v].bits);
+        }
+        free(dict->values);
+        intmap_free(&dict->index);
+    }
+    free(ci->id);
+    free(ci->quantity);
+    free(ci->value_of);
+    intmap_free(&ci->row_pos);
+    free(ci->scratch);
+    free(ci->result);
+    free(ci);
+}
@@ -0,0 +1,858 @@
+/**
+ * @file datagen.c
+ * @brief Deterministic synthetic data implementation
+ */
+#include "db/datagen.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "db/db_changes.h"
+#include "db/resident_db.h"
+#include "utils/utils_date.h"
+#include "utils/utils_name.h"
+
+// Separate streams per table, so adding rows to one table never shifts the rows of another
+enum datagen_stream {
+    STREAM_RESIDENT = 1,
+    STREAM_RESIDENT_CPF,
+    STREAM_FOOD,
+    STREAM_USER,
+    STREAM_USER_CPF,
+    STREAM_MEDICATION,
+    STREAM_MEDICATION_ORDER,
+    STREAM_CLOTHES,
+    STREAM_CLOTHES_ORDER,
+    STREAM_SUPPLIES,
+    STREAM_SUPPLIES_ORDER,
+};
+
+#define CPF_BASE_RANGE 1000000000u // Nine digits before the check digits
+
+/* ======================= RANDOM NUMBERS ======================= */
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+// Generator of one row, seeded from the seed, the stream and the row number only
+static uint64_t row_state(const struct datagen *gen, enum datagen_stream stream, int row) {
+    uint64_t state = gen->seed + (uint64_t)stream * 0xD1B54A32D192ED03u;
+    state += splitmix64(&state) ^ (uint64_t)(uint32_t)row;
+    splitmix64(&state);
+    return state;
+}
+
+// Uniform in [lo, hi]
+static int rng_range(uint64_t *state, int lo, int hi) {
+    return lo + (int)(splitmix64(state) % (uint64_t)(hi - lo + 1));
+}
+
+// Uniform in [0, 1)
+static double rng_unit(uint64_t *state) {
+    return (double)(splitmix64(state) >> 11) / 9007199254740992.0;
+}
+
+static bool rng_chance(uint64_t *state, int percent) {
+    return rng_range(state, 0, 99) < percent;
+}
+
+// Index in [0, n) favouring the start, for lists sorted from the most common entry down
+static int rng_skewed(uint64_t *state, int n) {
+    double u = rng_unit(state);
+    return (int)(u * u * n);
+}
+
+/**
+ * @brief Position of x in a seeded permutation of [0, n)
+ *
+ * A four round Feistel network over the smallest even number of bits holding n is a
+ * permutation of that power of two; stepping again while the result is n or more (cycle
+ * walking) keeps it a permutation of [0, n). Consecutive rows land far apart, so they get
+ * unrelated CPFs and catalog combinations, and no two rows ever get the same one.
+ */
+static uint32_t permute(uint64_t key, uint32_t x, uint32_t n) {
+    int half = 1;
+    while ((1ull << (2 * half)) < n) {
+        half++;
+    }
+    uint32_t mask = (1u << half) - 1;
+
+    do {
+        uint32_t left = x >> half;
+        uint32_t right = x & mask;
+        for (int round = 0; round < 4; round++) {
+            uint64_t state = key + ((uint64_t)round << 32) + right;
+            uint32_t next = left ^ ((uint32_t)splitmix64(&state) & mask);
+            left = right;
+            right = next;
+        }
+        x = (left << half) | right;
+    } while (x >= n);
+
+    return x;
+}
+
+// Key of the permutation of a stream
+static uint64_t stream_key(const struct datagen *gen, enum datagen_stream stream) {
+    uint64_t state = gen->seed ^ ((uint64_t)stream << 56);
+    return splitmix64(&state);
+}
+
+#define COUNT_OF(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+/* ======================= CPF ======================= */
+
+static bool is_repdigit(uint32_t base) {
+    return base % 111111111u == 0;
+}
+
+/**
+ * @brief Unique CPF of a row
+ *
+ * The nine base digits are the row number through a seeded permutation of [0, 10^9),
+ * walking past 000000000, 111111111... which are not valid CPFs. Rows stay below
+ * 111111111, so the walk always starts from a valid base and ends on one.
+ */
+static void make_cpf(const struct datagen *gen, enum datagen_stream stream, int row, char cpf[MAX_CPF_LENGTH]) {
+    uint64_t key = stream_key(gen, stream);
+    uint32_t base = (uint32_t)row;
+    do {
+        base = permute(key, base, CPF_BASE_RANGE);
+    } while (is_repdigit(base));
+
+    for (int i = 8; i >= 0; i--) {
+        cpf[i] = (char)('0' + base % 10);
+        base /= 10;
+    }
+    resident_db_cpf_complete(cpf);
+}
+
+void datagen_resident_cpf(const struct datagen *gen, int row, char cpf[MAX_CPF_LENGTH]) {
+    make_cpf(gen, STREAM_RESIDENT_CPF, row, cpf);
+}
+
+/* ======================= NAMES ======================= */
+
+// Most common first, picked with rng_skewed
+static const char *const male_names[] = {
+    "José", "João", "Antônio", "Francisco", "Carlos", "Paulo", "Pedro", "Lucas", "Luiz", "Marcos", "Luís", "Gabriel",
+    "Rafael", "Daniel", "Marcelo", "Bruno", "Eduardo", "Felipe", "Raimundo", "Rodrigo", "Manoel", "Mateus", "André",
+    "Fernando", "Fábio", "Leonardo", "Gustavo", "Guilherme", "Leandro", "Tiago", "Sebastião", "Miguel",
+};
+
+static const char *const female_names[] = {
+    "Maria", "Ana", "Francisca", "Antônia", "Adriana", "Juliana", "Márcia", "Fernanda", "Patrícia", "Aline", "Sandra",
+    "Camila", "Amanda", "Bruna", "Jéssica", "Letícia", "Júlia", "Luciana", "Vanessa", "Mariana", "Gabriela", "Vera",
+    "Vitória", "Larissa", "Cláudia", "Beatriz", "Luana", "Rita", "Sônia", "Renata", "Raimunda", "Conceição",
+};
+
+static const char *const surnames[] = {
+    "Silva", "Santos", "Oliveira", "Souza", "Rodrigues", "Ferreira", "Alves", "Pereira", "Lima", "Gomes", "Costa",
+    "Ribeiro", "Martins", "Carvalho", "Almeida", "Lopes", "Soares", "Fernandes", "Vieira", "Barbosa", "Rocha", "Dias",
+    "Nascimento", "Andrade", "Moreira", "Nunes", "Marques", "Machado", "Mendes", "Freitas", "Cardoso", "Ramos",
+    "Gonçalves", "Santana", "Teixeira", "Araújo", "Pinto", "Correia", "Cavalcanti", "Monteiro",
+};
+
+// Surnames usually written with their particle
+static const char *const particle_surnames[] = {
+    "da Silva", "dos Santos", "de Oliveira", "de Souza", "da Costa", "de Jesus", "da Conceição", "dos Reis",
+};
+
+static void append_word(char *buffer, size_t size, const char *word) {
+    size_t len = strlen(buffer);
+    snprintf(buffer + len, size - len, "%s%s", len > 0 ? " " : "", word);
+}
+
+static const char *pick_first_name(uint64_t *state, enum gender gender) {
+    if (gender == GENDER_OTHER) {
+        gender = rng_chance(state, 50) ? GENDER_MALE : GENDER_FEMALE;
+    }
+    if (gender == GENDER_MALE) {
+        return male_names[rng_skewed(state, COUNT_OF(male_names))];
+    }
+    return female_names[rng_skewed(state, COUNT_OF(female_names))];
+}
+
+// "First [Middle] [da Costa] Surname [Surname]", the way names are registered in Brazil
+static void make_person_name(uint64_t *state, enum gender gender, char *name, size_t size) {
+    name[0] = '\0';
+    append_word(name, size, pick_first_name(state, gender));
+    if (rng_chance(state, 25)) {
+        append_word(name, size, pick_first_name(state, gender));
+    }
+    if (rng_chance(state, 20)) {
+        append_word(name, size, particle_surnames[rng_skewed(state, COUNT_OF(particle_surnames))]);
+    }
+    append_word(name, size, surnames[rng_skewed(state, COUNT_OF(surnames))]);
+    if (rng_chance(state, 55)) {
+        append_word(name, size, surnames[rng_skewed(state, COUNT_OF(surnames))]);
+    }
+}
+
+/* ======================= RESIDENTS ======================= */
+
+static const char *const health_statuses[] = {
+    "Stable", "Under observation", "Recovering", "Chronic illness", "Needs follow-up", "Critical",
+};
+
+static const char *const resident_needs[] = {
+    "None", "Special diet", "Wheelchair access", "Insulin", "Baby supplies", "Glasses", "Hearing aid",
+    "Psychological support", "Crutches", "Oxygen",
+};
+
+void datagen_init(struct datagen *gen, uint64_t seed) {
+    *gen = (struct datagen) { 0 };
+    gen->seed = seed;
+    gen->base_day = date_to_days(2025, 1, 1);
+    gen->batch_rows = DATAGEN_BATCH_ROWS;
+}
+
+void datagen_resident(const struct datagen *gen, int row, struct resident *resident) {
+    uint64_t state = row_state(gen, STREAM_RESIDENT, row);
+    *resident = (struct resident) { 0 };
+
+    datagen_resident_cpf(gen, row, resident->cpf);
+    resident->cpf_packed = resident_db_cpf_pack(resident->cpf);
+
+    int gender_roll = rng_range(&state, 0, 99);
+    resident->gender = gender_roll < 48 ? GENDER_MALE : gender_roll < 96 ? GENDER_FEMALE : GENDER_OTHER;
+    make_person_name(&state, resident->gender, resident->name, sizeof(resident->name));
+
+    // Shelters take in families, so a fifth are children and some are elderly
+    int age_roll = rng_range(&state, 0, 99);
+    if (age_roll < 20) {
+        resident->age = rng_range(&state, 0, 17);
+    } else if (age_roll < 85) {
+        resident->age = rng_range(&state, 18, 59);
+    } else {
+        resident->age = rng_range(&state, 60, 95);
+    }
+
+    int health = rng_skewed(&state, COUNT_OF(health_statuses));
+    snprintf(resident->health_status, sizeof(resident->health_status), "%s", health_statuses[health]);
+    snprintf(
+        resident->needs,
+        sizeof(resident->needs),
+        "%s",
+        resident_needs[rng_skewed(&state, COUNT_OF(resident_needs))]
+    );
+    resident->medical_assistance = rng_chance(&state, 5 + health * 15 + (resident->age >= 60 ? 20 : 0));
+
+    resident->entry_day = gen->base_day - rng_range(&state, 0, 364);
+    date_format(resident->entry_day, resident->entry_date);
+}
+
+/* ======================= FOOD ======================= */
+
+struct datagen_food {
+    const char *name;
+    bool perishable;
+    int shelf_min;  // Days from arrival to expiration, 0 if it does not expire
+    int shelf_max;
+    float rate_min; // Consumption per resident per day, in the batch's units
+    float rate_max;
+    int quantity_max;
+};
+
+static const struct datagen_food foods[] = {
+    { "Arroz", false, 300, 540, 0.05f, 0.15f, 400 },
+    { "Feijão", false, 180, 360, 0.04f, 0.12f, 400 },
+    { "Macarrão", false, 240, 720, 0.03f, 0.10f, 300 },
+    { "Farinha de mandioca", false, 120, 240, 0.02f, 0.06f, 200 },
+    { "Óleo de soja", false, 300, 540, 0.01f, 0.03f, 150 },
+    { "Açúcar", false, 0, 0, 0.01f, 0.04f, 200 },
+    { "Sal", false, 0, 0, 0.003f, 0.01f, 100 },
+    { "Café", false, 180, 365, 0.01f, 0.03f, 100 },
+    { "Leite em pó", false, 180, 365, 0.02f, 0.06f, 150 },
+    { "Leite UHT", false, 90, 150, 0.2f, 0.5f, 600 },
+    { "Sardinha em lata", false, 540, 1080, 0.02f, 0.08f, 300 },
+    { "Extrato de tomate", false, 360, 720, 0.01f, 0.04f, 200 },
+    { "Biscoito", false, 120, 240, 0.05f, 0.2f, 400 },
+    { "Fubá", false, 120, 180, 0.01f, 0.04f, 150 },
+    { "Pão francês", true, 1, 3, 1.0f, 2.0f, 1000 },
+    { "Banana", true, 3, 10, 0.5f, 1.5f, 600 },
+    { "Maçã", true, 10, 30, 0.3f, 1.0f, 400 },
+    { "Laranja", true, 10, 25, 0.3f, 1.0f, 400 },
+    { "Tomate", true, 4, 12, 0.1f, 0.4f, 200 },
+    { "Alface", true, 2, 6, 0.05f, 0.2f, 80 },
+    { "Batata", true, 15, 45, 0.1f, 0.3f, 300 },
+    { "Cebola", true, 20, 60, 0.05f, 0.15f, 200 },
+    { "Cenoura", true, 10, 30, 0.05f, 0.2f, 200 },
+    { "Ovos", true, 14, 30, 0.5f, 1.5f, 900 },
+    { "Frango congelado", true, 30, 180, 0.1f, 0.3f, 300 },
+    { "Carne moída", true, 2, 5, 0.1f, 0.25f, 150 },
+    { "Iogurte", true, 7, 25, 0.2f, 0.6f, 300 },
+    { "Queijo", true, 15, 40, 0.02f, 0.08f, 80 },
+};
+
+void datagen_foodbatch(const struct datagen *gen, int row, struct foodbatch *foodbatch) {
+    uint64_t state = row_state(gen, STREAM_FOOD, row);
+    *foodbatch = (struct foodbatch) { 0 };
+
+    const struct datagen_food *food = &foods[rng_range(&state, 0, COUNT_OF(foods) - 1)];
+    foodbatch->batch_id = row;
+    snprintf(foodbatch->name, sizeof(foodbatch->name), "%s", food->name);
+    foodbatch->quantity = rng_range(&state, food->quantity_max / 10 + 1, food->quantity_max);
+    foodbatch->is_perishable = food->perishable;
+
+    // Received up to half the longest shelf life ago, so the older batches are already expired
+    foodbatch->expiration_day = DATE_INVALID;
+    if (food->shelf_max > 0) {
+        int shelf = rng_range(&state, food->shelf_min, food->shelf_max);
+        int age = rng_range(&state, 0, food->shelf_max / 2);
+        foodbatch->expiration_day = gen->base_day + shelf - age;
+    }
+    date_format(foodbatch->expiration_day, foodbatch->expiration_date);
+
+    float rate = food->rate_min + (food->rate_max - food->rate_min) * (float)rng_unit(&state);
+    foodbatch->daily_consumption_rate = (float)(int)(rate * 1000.0f + 0.5f) / 1000.0f;
+}
+
+/* ======================= USERS ======================= */
+
+static const int area_codes[] = { 11, 21, 31, 41, 47, 48, 51, 53, 54, 55, 61, 62, 71, 81, 85, 91 };
+
+// First name and surname of a user, also what the username is made of
+static void user_names(const struct datagen *gen, int row, const char **first, const char **last) {
+    uint64_t state = row_state(gen, STREAM_USER, row);
+    *first = pick_first_name(&state, GENDER_OTHER);
+    *last = surnames[rng_skewed(&state, COUNT_OF(surnames))];
+}
+
+void datagen_user_username(const struct datagen *gen, int row, char username[MAX_INPUT]) {
+    const char *first;
+    const char *last;
+    user_names(gen, row, &first, &last);
+
+    char first_ascii[64];
+    char last_ascii[64];
+    name_normalize(first, first_ascii, sizeof(first_ascii));
+    name_normalize(last, last_ascii, sizeof(last_ascii));
+    snprintf(username, MAX_INPUT, "%s.%s%d", first_ascii, last_ascii, row);
+}
+
+void datagen_user(const struct datagen *gen, int row, struct user *user) {
+    // The names take the first draws of the row, the rest continues after them
+    uint64_t state = row_state(gen, STREAM_USER, row) ^ 0x5555555555555555u;
+    *user = (struct user) { 0 };
+
+    datagen_user_username(gen, row, user->username);
+    make_cpf(gen, STREAM_USER_CPF, row, user->cpf);
+    snprintf(
+        user->phone_number,
+        sizeof(user->phone_number),
+        "%d9%08d",
+        area_codes[rng_range(&state, 0, COUNT_OF(area_codes) - 1)],
+        rng_range(&state, 0, 99999999)
+    );
+    user->is_admin = rng_chance(&state, 2);
+    user->reset_password = true;
+
+    time_t base_time = (time_t)gen->base_day * 86400 + 12 * 3600;
+    user->created_at = base_time - (time_t)rng_range(&state, 0, 730 * 86400);
+    if (rng_chance(&state, 75)) {
+        user->last_login = user->created_at + (time_t)(rng_unit(&state) * (double)(base_time - user->created_at));
+    }
+}
+
+/* ======================= INVENTORIES ======================= */
+
+// Combination of a catalog of count combinations taken by a row, each pass over the catalog takes them all
+static int catalog_combination(const struct datagen *gen, enum datagen_stream stream, int row, int count) {
+    return (int)permute(stream_key(gen, stream), (uint32_t)((row - 1) % count), (uint32_t)count);
+}
+
+// Rows past the first pass over a catalog get " 2", " 3"... on a UNIQUE column
+static void add_round(char *buffer, size_t size, int round) {
+    if (round > 0) {
+        size_t len = strlen(buffer);
+        snprintf(buffer + len, size - len, " %d", round + 1);
+    }
+}
+
+struct datagen_medication {
+    const char *generic_name;
+    const char *name;
+    const char *form;
+    const char *strength;
+    const char *unit;
+    const char *notes;
+};
+
+static const struct datagen_medication medications[] = {
+    { "Paracetamol", "Tylenol", "Tablet", "500mg", "Tablet", "" },
+    { "Paracetamol", "Tylenol", "Drops", "200mg/ml", "ml", "" },
+    { "Dipirona", "Novalgina", "Tablet", "500mg", "Tablet", "" },
+    { "Dipirona", "Novalgina", "Drops", "500mg/ml", "ml", "" },
+    { "Ibuprofeno", "Advil", "Tablet", "400mg", "Tablet", "" },
+    { "Ibuprofeno", "Alivium", "Suspension", "100mg/ml", "ml", "" },
+    { "Amoxicilina", "Amoxil", "Capsule", "500mg", "Capsule", "Prescription only" },
+    { "Amoxicilina", "Amoxil", "Suspension", "250mg/5ml", "ml", "Prescription only" },
+    { "Azitromicina", "Zitromax", "Tablet", "500mg", "Tablet", "Prescription only" },
+    { "Losartana", "Cozaar", "Tablet", "50mg", "Tablet", "" },
+    { "Captopril", "Capoten", "Tablet", "25mg", "Tablet", "" },
+    { "Hidroclorotiazida", "Clorana", "Tablet", "25mg", "Tablet", "" },
+    { "Metformina", "Glifage", "Tablet", "850mg", "Tablet", "" },
+    { "Insulina NPH", "Humulin N", "Injection", "100UI/ml", "vial", "Keep refrigerated" },
+    { "Sinvastatina", "Zocor", "Tablet", "20mg", "Tablet", "" },
+    { "Omeprazol", "Losec", "Capsule", "20mg", "Capsule", "" },
+    { "Loratadina", "Claritin", "Tablet", "10mg", "Tablet", "" },
+    { "Salbutamol", "Aerolin", "Inhaler", "100mcg", "dose", "" },
+    { "Fluoxetina", "Prozac", "Capsule", "20mg", "Capsule", "Prescription only" },
+    { "Dexametasona", "Decadron", "Cream", "1mg/g", "tube", "" },
+    { "Cetoconazol", "Nizoral", "Cream", "20mg/g", "tube", "" },
+    { "Sulfato ferroso", "Neutrofer", "Tablet", "40mg", "Tablet", "" },
+    { "Ácido ascórbico", "Redoxon", "Effervescent tablet", "1g", "Tablet", "" },
+    { "Sais de reidratação", "Hidrafix", "Powder", "27.9g", "sachet", "" },
+};
+
+void datagen_medication(const struct datagen *gen, int row, struct medication *medication) {
+    uint64_t state = row_state(gen, STREAM_MEDICATION, row);
+    *medication = (struct medication) { 0 };
+
+    int count = COUNT_OF(medications);
+    const struct datagen_medication *entry =
+        &medications[catalog_combination(gen, STREAM_MEDICATION_ORDER, row, count)];
+
+    medication->id = row;
+    snprintf(medication->name, sizeof(medication->name), "%s", entry->name);
+    add_round(medication->name, sizeof(medication->name), (row - 1) / count);
+    snprintf(medication->generic_name, sizeof(medication->generic_name), "%s", entry->generic_name);
+    snprintf(medication->form, sizeof(medication->form), "%s", entry->form);
+    snprintf(medication->strength, sizeof(medication->strength), "%s", entry->strength);
+    snprintf(medication->unit, sizeof(medication->unit), "%s", entry->unit);
+    snprintf(medication->notes, sizeof(medication->notes), "%s", entry->notes);
+    medication->stock = rng_chance(&state, 10) ? 0 : rng_range(&state, 1, 500);
+    medication->expiration_day = gen->base_day + rng_range(&state, -30, 900);
+    date_format(medication->expiration_day, medication->expiration_date);
+}
+
+static const char *const clothes_types[] = {
+    "t-shirt", "pants", "coat", "sweater", "shorts", "dress", "skirt", "jacket", "socks", "underwear", "shoes",
+    "pajamas",
+};
+static const char *const clothes_sizes[] = { "XS", "S", "M", "L", "XL", "XXL", "kids", "baby" };
+static const char *const clothes_genders[] = { "other", "male", "female" };
+static const char *const clothes_colors[] = {
+    "black", "white", "blue", "gray", "red", "green", "brown", "beige", "pink", "yellow",
+};
+static const char *const clothes_conditions[] = { "new", "good", "worn", "needs repair" };
+static const char *const donation_notes[] = {
+    "", "campaign donation", "church donation", "school donation", "company donation",
+};
+
+void datagen_clothes(const struct datagen *gen, int row, struct clothes *clothes) {
+    uint64_t state = row_state(gen, STREAM_CLOTHES, row);
+    *clothes = (struct clothes) { 0 };
+
+    int count = COUNT_OF(clothes_types) * COUNT_OF(clothes_sizes) * COUNT_OF(clothes_genders)
+              * COUNT_OF(clothes_colors) * COUNT_OF(clothes_conditions);
+    int combination = catalog_combination(gen, STREAM_CLOTHES_ORDER, row, count);
+
+    clothes->id = row;
+    snprintf(clothes->type, sizeof(clothes->type), "%s", clothes_types[combination % COUNT_OF(clothes_types)]);
+    add_round(clothes->type, sizeof(clothes->type), (row - 1) / count);
+    combination /= COUNT_OF(clothes_types);
+    snprintf(clothes->size, sizeof(clothes->size), "%s", clothes_sizes[combination % COUNT_OF(clothes_sizes)]);
+    combination /= COUNT_OF(clothes_sizes);
+    snprintf(clothes->gender, sizeof(clothes->gender), "%s", clothes_genders[combination % COUNT_OF(clothes_genders)]);
+    combination /= COUNT_OF(clothes_genders);
+    snprintf(clothes->color, sizeof(clothes->color), "%s", clothes_colors[combination % COUNT_OF(clothes_colors)]);
+    combination /= COUNT_OF(clothes_colors);
+    int condition = combination % COUNT_OF(clothes_conditions);
+    snprintf(clothes->condition, sizeof(clothes->condition), "%s", clothes_conditions[condition]);
+
+    // Worn pieces come in fewer at a time than new ones
+    clothes->quantity = rng_chance(&state, 15) ? 0 : rng_range(&state, 1, 60 / (condition + 1));
+    const char *notes = donation_notes[rng_skewed(&state, COUNT_OF(donation_notes))];
+    snprintf(clothes->notes, sizeof(clothes->notes), "%s", notes);
+}
+
+struct datagen_supply {
+    const char *name;
+    const char *category;
+    const char *unit;
+};
+
+static const struct datagen_supply supply_items[] = {
+    { "diaper", "hygiene", "pack" },
+    { "soap", "hygiene", "piece" },
+    { "toothpaste", "hygiene", "tube" },
+    { "toothbrush", "hygiene", "piece" },
+    { "shampoo", "hygiene", "bottle" },
+    { "tampon", "hygiene", "box" },
+    { "sanitary pad", "hygiene", "pack" },
+    { "toilet paper", "hygiene", "pack" },
+    { "deodorant", "personal care", "piece" },
+    { "razor", "personal care", "piece" },
+    { "sunscreen", "personal care", "bottle" },
+    { "comb", "personal care", "piece" },
+    { "bleach", "cleaning", "bottle" },
+    { "detergent", "cleaning", "bottle" },
+    { "sponge", "cleaning", "piece" },
+    { "trash bag", "cleaning", "roll" },
+    { "disinfectant", "cleaning", "bottle" },
+    { "blanket", "bedding", "piece" },
+    { "pillow", "bedding", "piece" },
+    { "bed sheet", "bedding", "piece" },
+    { "towel", "bedding", "piece" },
+    { "mask", "medical", "box" },
+    { "gloves", "medical", "box" },
+    { "bandage", "medical", "roll" },
+};
+static const char *const supply_sizes[] = { "", "small", "medium", "large", "adult", "kids" };
+
+void datagen_supplies(const struct datagen *gen, int row, struct supplies *supplies) {
+    uint64_t state = row_state(gen, STREAM_SUPPLIES, row);
+    *supplies = (struct supplies) { 0 };
+
+    int count = COUNT_OF(supply_items) * COUNT_OF(supply_sizes);
+    int combination = catalog_combination(gen, STREAM_SUPPLIES_ORDER, row, count);
+    const struct datagen_supply *item = &supply_items[combination % COUNT_OF(supply_items)];
+
+    supplies->id = row;
+    snprintf(supplies->name, sizeof(supplies->name), "%s", item->name);
+    add_round(supplies->name, sizeof(supplies->name), (row - 1) / count);
+    snprintf(supplies->category, sizeof(supplies->category), "%s", item->category);
+    snprintf(supplies->size, sizeof(supplies->size), "%s", supply_sizes[combination / COUNT_OF(supply_items)]);
+    snprintf(supplies->unit, sizeof(supplies->unit), "%s", item->unit);
+    supplies->quantity = rng_chance(&state, 10) ? 0 : rng_range(&state, 1, 300);
+    const char *notes = donation_notes[rng_skewed(&state, COUNT_OF(donation_notes))];
+    snprintf(supplies->notes, sizeof(supplies->notes), "%s", notes);
+}
+
+/* ======================= WRITERS ======================= */
+
+// Each writer generates its row, binds it and steps the statement
+struct datagen_writer {
+    const char *table;
+    const char *sql;
+    int max_row;
+    int (*write)(sqlite3_stmt *stmt, const struct datagen *gen, int row);
+    const char *search_trigger; // Trigger keeping a full-text index in sync, NULL if none
+    const char *search_table;   // That full-text index
+};
+
+static int step_and_reset(sqlite3_stmt *stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc;
+}
+
+static int write_resident(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct resident resident;
+    datagen_resident(gen, row, &resident);
+
+    char name_key[NAME_KEY_LEN];
+    name_phonetic_key(resident.name, name_key);
+
+    sqlite3_bind_int64(stmt, 1, resident.cpf_packed);
+    sqlite3_bind_text(stmt, 2, resident.name, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, resident.age);
+    sqlite3_bind_text(stmt, 4, resident.health_status, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, resident.needs, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, resident.medical_assistance ? 1 : 0);
+    sqlite3_bind_int(stmt, 7, resident.gender);
+    sqlite3_bind_int(stmt, 8, resident.entry_day);
+    sqlite3_bind_text(stmt, 9, name_key, -1, SQLITE_STATIC);
+    return step_and_reset(stmt);
+}
+
+static int write_foodbatch(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct foodbatch foodbatch;
+    datagen_foodbatch(gen, row, &foodbatch);
+
+    sqlite3_bind_int(stmt, 1, foodbatch.batch_id);
+    sqlite3_bind_text(stmt, 2, foodbatch.name, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, foodbatch.quantity);
+    sqlite3_bind_int(stmt, 4, foodbatch.is_perishable ? 1 : 0);
+    db_bind_day(stmt, 5, foodbatch.expiration_day);
+    sqlite3_bind_double(stmt, 6, foodbatch.daily_consumption_rate);
+    return step_and_reset(stmt);
+}
+
+static int write_user(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct user user;
+    datagen_user(gen, row, &user);
+
+    sqlite3_bind_text(stmt, 1, user.username, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, user.cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, user.phone_number, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, user.is_admin ? 1 : 0);
+    sqlite3_bind_int64(stmt, 5, (sqlite3_int64)user.created_at);
+    if (user.last_login != 0) {
+        sqlite3_bind_int64(stmt, 6, (sqlite3_int64)user.last_login);
+    } else {
+        sqlite3_bind_null(stmt, 6);
+    }
+    return step_and_reset(stmt);
+}
+
+static int write_medication(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct medication medication;
+    datagen_medication(gen, row, &medication);
+
+    sqlite3_bind_int(stmt, 1, medication.id);
+    sqlite3_bind_text(stmt, 2, medication.name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, medication.generic_name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, medication.form, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, medication.strength, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 6, medication.unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 7, medication.stock);
+    db_bind_day(stmt, 8, medication.expiration_day);
+    sqlite3_bind_text(stmt, 9, medication.notes, -1, SQLITE_STATIC);
+    return step_and_reset(stmt);
+}
+
+static int write_clothes(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct clothes clothes;
+    datagen_clothes(gen, row, &clothes);
+
+    sqlite3_bind_int(stmt, 1, clothes.id);
+    sqlite3_bind_text(stmt, 2, clothes.type, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, clothes.size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, clothes.gender, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, clothes.color, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, clothes.quantity);
+    sqlite3_bind_text(stmt, 7, clothes.condition, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 8, clothes.notes, -1, SQLITE_STATIC);
+    return step_and_reset(stmt);
+}
+
+static int write_supplies(sqlite3_stmt *stmt, const struct datagen *gen, int row) {
+    struct supplies supplies;
+    datagen_supplies(gen, row, &supplies);
+
+    sqlite3_bind_int(stmt, 1, supplies.id);
+    sqlite3_bind_text(stmt, 2, supplies.name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, supplies.category, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, supplies.size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, supplies.unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, supplies.quantity);
+    sqlite3_bind_text(stmt, 7, supplies.notes, -1, SQLITE_STATIC);
+    return step_and_reset(stmt);
+}
+
+static const struct datagen_writer resident_writer = {
+    .table = "Resident",
+    .sql =
+        "INSERT INTO Resident "
+        "(CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate, NameKey, Changed) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, " DB_CHANGES_STAMP("Resident") ");",
+    .max_row = DATAGEN_MAX_ROWS,
+    .write = write_resident,
+    .search_trigger = "Resident_ai",
+    .search_table = "ResidentSearch",
+};
+
+static const struct datagen_writer foodbatch_writer = {
+    .table = "FoodBatch",
+    .sql =
+        "INSERT INTO FoodBatch "
+        "(BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate, Changed) "
+        "VALUES (?, ?, ?, ?, ?, ?, " DB_CHANGES_STAMP("FoodBatch") ");",
+    .max_row = INT32_MAX,
+    .write = write_foodbatch,
+};
+
+static const struct datagen_writer user_writer = {
+    .table = "Users",
+    .sql =
+        "INSERT INTO Users "
+        "(Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt, LastLogin) "
+        "VALUES (?, NULL, NULL, ?, ?, ?, 1, ?, ?);",
+    .max_row = DATAGEN_MAX_ROWS,
+    .write = write_user,
+};
+
+static const struct datagen_writer medication_writer = {
+    .table = "Medications",
+    .sql =
+        "INSERT INTO Medications (ID, Name, GenericName, Form, Strength, Unit, Stock, ExpirationDate, Notes) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+    .max_row = INT32_MAX,
+    .write = write_medication,
+};
+
+static const struct datagen_writer clothes_writer = {
+    .table = "Clothes",
+    .sql =
+        "INSERT INTO Clothes (ID, Type, Size, Gender, Color, Quantity, Condition, Notes) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?);",
+    .max_row = INT32_MAX,
+    .write = write_clothes,
+};
+
+static const struct datagen_writer supplies_writer = {
+    .table = "Supplies",
+    .sql = "INSERT INTO Supplies (ID, Name, Category, Size, Unit, Quantity, Notes) VALUES (?, ?, ?, ?, ?, ?, ?);",
+    .max_row = INT32_MAX,
+    .write = write_supplies,
+};
+
+/**
+ * @brief Drops the trigger feeding a full-text index, returning its SQL to create it again
+ *
+ * Updating the index row by row costs several times the insert itself, one rebuild at the
+ * end is far cheaper.
+ *
+ * @return SQL of the trigger (free with sqlite3_free()), NULL if there is no such trigger or on error
+ */
+static char *suspend_search_trigger(database *db, const char *trigger) {
+    sqlite3_stmt *stmt;
+    const char *sql = "SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name = ?;";
+    if (sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return NULL;
+    }
+
+    sqlite3_bind_text(stmt, 1, trigger, -1, SQLITE_STATIC);
+    char *trigger_sql = NULL;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        trigger_sql = sqlite3_mprintf("%s;", (const char *)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    char *drop = sqlite3_mprintf("DROP TRIGGER \"%w\";", trigger);
+    if (trigger_sql && sqlite3_exec(db->db, drop, 0, 0, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to drop trigger %s: %s\n", trigger, sqlite3_errmsg(db->db));
+        sqlite3_free(trigger_sql);
+        trigger_sql = NULL;
+    }
+    sqlite3_free(drop);
+    return trigger_sql;
+}
+
+/**
+ * @brief Creates the trigger dropped by suspend_search_trigger() again and rebuilds the index
+ */
+static int resume_search_trigger(database *db, const char *search_table, char *trigger_sql) {
+    char *rebuild = sqlite3_mprintf("INSERT INTO \"%w\"(\"%w\") VALUES ('rebuild');", search_table, search_table);
+
+    int rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db->db, trigger_sql, 0, 0, 0);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db->db, rebuild, 0, 0, 0);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to rebuild %s: %s\n", search_table, sqlite3_errmsg(db->db));
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        sqlite3_exec(db->db, trigger_sql, 0, 0, 0); // Keep the index in sync from here on at least
+    }
+
+    sqlite3_free(rebuild);
+    sqlite3_free(trigger_sql);
+    return rc;
+}
+
+/**
+ * @brief Writes rows first to first + count - 1 with one statement, batch_rows rows per transaction
+ */
+static int datagen_fill(
+    database *db,
+    const struct datagen *gen,
+    const struct datagen_writer *writer,
+    int first,
+    int count
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (first < 1 || count < 0 || count > writer->max_row - first + 1) {
+        fprintf(stderr, "Rows %d to %d are out of range for %s.\n", first, first + count - 1, writer->table);
+        return SQLITE_RANGE;
+    }
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, writer->sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    char *trigger_sql = NULL;
+    if (writer->search_trigger && count > 0) {
+        trigger_sql = suspend_search_trigger(db, writer->search_trigger);
+    }
+
+    int batch_rows = gen->batch_rows > 0 ? gen->batch_rows : DATAGEN_BATCH_ROWS;
+    int done = 0;
+    while (done < count) {
+        rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+            break;
+        }
+
+        int end = count - done < batch_rows ? count : done + batch_rows;
+        for (int i = done; i < end && rc == SQLITE_OK; i++) {
+            rc = writer->write(stmt, gen, first + i);
+            if (rc != SQLITE_DONE) {
+                fprintf(stderr, "Failed to write %s row %d: %s\n", writer->table, first + i, sqlite3_errmsg(db->db));
+            } else {
+                rc = SQLITE_OK;
+            }
+        }
+
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+            if (rc != SQLITE_OK) {
+                fprintf(stderr, "Failed to commit transaction: %s\n", sqlite3_errmsg(db->db));
+            }
+        }
+        if (rc != SQLITE_OK) {
+            sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+            break;
+        }
+
+        done = end;
+        if (gen->progress) {
+            gen->progress(gen->progress_ctx, done, count);
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    // The batches committed before a failure are indexed too
+    if (trigger_sql) {
+        int index_rc = resume_search_trigger(db, writer->search_table, trigger_sql);
+        rc = rc == SQLITE_OK ? index_rc : rc;
+    }
+
+    return rc;
+}
+
+int datagen_fill_residents(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &resident_writer, first, count);
+}
+
+int datagen_fill_foodbatches(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &foodbatch_writer, first, count);
+}
+
+int datagen_fill_users(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &user_writer, first, count);
+}
+
+int datagen_fill_medications(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &medication_writer, first, count);
+}
+
+int datagen_fill_clothes(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &clothes_writer, first, count);
+}
+
+int datagen_fill_supplies(database *db, const struct datagen *gen, int first, int count) {
+    return datagen_fill(db, gen, &supplies_writer, first, count);
+}
@@ -0,0 +1,633 @@
+/**
+ * @file db_backup.c
+ * @brief Online database backups implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For localtime_r
+
+#include "db/db_backup.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+/**
+ * @internal
+ * @def DB_BACKUP_GZIP_CHUNK
+ * @brief Bytes read from the copy per gzip write
+ */
+#define DB_BACKUP_GZIP_CHUNK (64 * 1024)
+
+/**
+ * @internal
+ * @def DB_BACKUP_STAMP_LEN
+ * @brief Length of the YYYYMMDD-HHMMSS part of a backup name
+ */
+#define DB_BACKUP_STAMP_LEN 15
+
+/**
+ * @internal
+ * @brief A registered database
+ */
+struct backup_source {
+    database *db;                  ///< Connection the pages are read through
+    char name[DB_BACKUP_NAME_LEN]; ///< File name without directory and extension
+};
+
+struct db_backup {
+    char dir[DB_BACKUP_PATH_LEN]; ///< Backup directory
+    int generations;              ///< Backups kept per database, 0 keeps all
+    int64_t interval;             ///< Seconds between scheduled backups, 0 for none
+    bool compress;                ///< Write .db.gz instead of .db
+
+    struct backup_source sources[DB_BACKUP_MAX_DATABASES]; ///< Registered databases
+    int count;                                             ///< Registered databases
+
+    pthread_t thread;    ///< Background thread, valid while joinable
+    bool joinable;       ///< Thread started and not joined yet, main thread only
+    atomic_bool running; ///< Thread still working
+    atomic_bool cancel;  ///< Asks the thread to stop
+
+    pthread_mutex_t lock;           ///< Guards status and rc
+    struct db_backup_status status; ///< Progress, progress field computed on read
+    int rc;                         ///< Result of the last backup
+};
+
+/* ======================= FILES ======================= */
+
+/**
+ * @internal
+ * @brief Creates a directory, fine if it exists
+ */
+static bool backup_mkdir(const char *dir) {
+#ifdef _WIN32
+    int rc = _mkdir(dir);
+#else
+    int rc = mkdir(dir, 0755);
+#endif
+    return rc == 0 || errno == EEXIST;
+}
+
+/**
+ * @internal
+ * @brief Moves a finished file over its final name
+ */
+static bool backup_replace(const char *from, const char *to) {
+#ifdef _WIN32
+    remove(to); // rename() does not replace there
+#endif
+    return rename(from, to) == 0;
+}
+
+/**
+ * @internal
+ * @brief Whether a directory entry is a backup of the named database
+ */
+static bool backup_is_of(const char *entry, const char *name) {
+    size_t len = strlen(name);
+    if (strncmp(entry, name, len) != 0 || entry[len] != '-') {
+        return false;
+    }
+
+    const char *stamp = entry + len + 1;
+    for (int i = 0; i < DB_BACKUP_STAMP_LEN; i++) {
+        bool ok = i == 8 ? stamp[i] == '-' : stamp[i] >= '0' && stamp[i] <= '9';
+        if (!ok) {
+            return false;
+        }
+    }
+
+    const char *ext = stamp + DB_BACKUP_STAMP_LEN;
+    return strcmp(ext, ".db") == 0 || strcmp(ext, ".db.gz") == 0;
+}
+
+static int backup_compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @internal
+ * @brief Lists the backups of a database, oldest first (the stamps sort by time)
+ *
+ * @return Number of names in *names (free each and the array), -1 on failure
+ */
+static int backup_list(const char *dir, const char *name, char ***names) {
+    *names = NULL;
+    DIR *d = opendir(dir);
+    if (!d) {
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    bool failed = false;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (!backup_is_of(entry->d_name, name)) {
+            continue;
+        }
+        if (count == capacity) {
+            int grown = capacity ? capacity * 2 : 16;
+            char **tmp = realloc(*names, sizeof(char *) * grown);
+            if (!tmp) {
+                failed = true;
+                break;
+            }
+            *names = tmp;
+            capacity = grown;
+        }
+        size_t len = strlen(entry->d_name) + 1;
+        (*names)[count] = malloc(len);
+        if (!(*names)[count]) {
+            failed = true;
+            break;
+        }
+        memcpy((*names)[count++], entry->d_name, len);
+    }
+    closedir(d);
+
+    if (failed) {
+        for (int i = 0; i < count; i++) {
+            free((*names)[i]);
+        }
+        free(*names);
+        *names = NULL;
+        return -1;
+    }
+
+    if (count > 1) {
+        qsort(*names, count, sizeof(char *), backup_compare_names);
+    }
+    return count;
+}
+
+static void backup_list_free(char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+/**
+ * @internal
+ * @brief Modification time of the newest backup of a database, 0 if none
+ */
+static time_t backup_newest(const char *dir, const char *name) {
+    char **names;
+    int count = backup_list(dir, name, &names);
+    if (count <= 0) {
+        return 0;
+    }
+
+    time_t newest = 0;
+    char path[DB_BACKUP_PATH_LEN];
+    struct stat st;
+    if (snprintf(path, sizeof(path), "%s/%s", dir, names[count - 1]) < (int)sizeof(path) && stat(path, &st) == 0) {
+        newest = st.st_mtime;
+    }
+    backup_list_free(names, count);
+    return newest;
+}
+
+/**
+ * @internal
+ * @brief Deletes the oldest backups of a database beyond the generations kept
+ */
+static void backup_rotate(struct db_backup *backup, const char *name) {
+    if (backup->generations <= 0) {
+        return;
+    }
+
+    char **names;
+    int count = backup_list(backup->dir, name, &names);
+    if (count < 0) {
+        fprintf(stderr, "Failed to list the backups of %s in %s.\n", name, backup->dir);
+        return;
+    }
+
+    char path[DB_BACKUP_PATH_LEN];
+    for (int i = 0; i < count - backup->generations; i++) {
+        if (snprintf(path, sizeof(path), "%s/%s", backup->dir, names[i]) >= (int)sizeof(path)) {
+            continue;
+        }
+        if (remove(path) != 0) {
+            fprintf(stderr, "Failed to delete old backup %s.\n", path);
+        }
+    }
+    backup_list_free(names, count);
+}
+
+/* ======================= BACKGROUND THREAD ======================= */
+
+/**
+ * @internal
+ * @brief Records why the backup failed, the first reason wins
+ */
+static void backup_set_message(struct db_backup *backup, const char *name, const char *reason) {
+    pthread_mutex_lock(&backup->lock);
+    if (backup->status.message[0] == '\0') {
+        snprintf(backup->status.message, sizeof(backup->status.message), "%s: %s", name, reason);
+    }
+    pthread_mutex_unlock(&backup->lock);
+}
+
+/**
+ * @internal
+ * @brief Compresses a copy into a .gz file, through a .partial file
+ */
+static int backup_compress(struct db_backup *backup, const char *from, const char *to, const char *name) {
+    char partial[DB_BACKUP_PATH_LEN + 8];
+    snprintf(partial, sizeof(partial), "%s.partial", to);
+
+    struct stat st;
+    pthread_mutex_lock(&backup->lock);
+    backup->status.state = DB_BACKUP_COMPRESSING;
+    backup->status.bytes_done = 0;
+    backup->status.bytes_total = stat(from, &st) == 0 ? (int64_t)st.st_size : 0;
+    pthread_mutex_unlock(&backup->lock);
+
+    FILE *in = fopen(from, "rb");
+    gzFile out = gzopen(partial, "wb6");
+    unsigned char *buffer = malloc(DB_BACKUP_GZIP_CHUNK);
+    int rc = in && out ? SQLITE_OK : SQLITE_CANTOPEN;
+    if (rc == SQLITE_OK && !buffer) {
+        rc = SQLITE_NOMEM;
+    }
+
+    int64_t done = 0;
+    while (rc == SQLITE_OK) {
+        if (atomic_load(&backup->cancel)) {
+            rc = SQLITE_INTERRUPT;
+            break;
+        }
+        size_t read = fread(buffer, 1, DB_BACKUP_GZIP_CHUNK, in);
+        if (read == 0) {
+            if (ferror(in)) {
+                rc = SQLITE_IOERR;
+            }
+            break;
+        }
+        if (gzwrite(out, buffer, (unsigned)read) != (int)read) {
+            rc = SQLITE_IOERR;
+            break;
+        }
+        done += (int64_t)read;
+        pthread_mutex_lock(&backup->lock);
+        backup->status.bytes_done = done;
+        pthread_mutex_unlock(&backup->lock);
+    }
+
+    free(buffer);
+    if (in) {
+        fclose(in);
+    }
+    if (out && gzclose(out) != Z_OK && rc == SQLITE_OK) {
+        rc = SQLITE_IOERR;
+    }
+
+    if (rc == SQLITE_OK && !backup_replace(partial, to)) {
+        rc = SQLITE_IOERR;
+    }
+    if (rc != SQLITE_OK) {
+        remove(partial);
+        if (rc != SQLITE_INTERRUPT) {
+            const char *reason = rc == SQLITE_CANTOPEN ? "cannot open the compressed file" : "compression failed";
+            backup_set_message(backup, name, reason);
+        }
+    }
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Copies one database page batch by page batch, then compresses or renames the copy
+ */
+static int backup_copy(struct db_backup *backup, const struct backup_source *source, const char *stamp) {
+    char path[DB_BACKUP_PATH_LEN];
+    char partial[DB_BACKUP_PATH_LEN + 8];
+    if (snprintf(path, sizeof(path), "%s/%s-%s.db", backup->dir, source->name, stamp) >= (int)sizeof(path)) {
+        backup_set_message(backup, source->name, "backup path too long");
+        return SQLITE_CANTOPEN;
+    }
+    snprintf(partial, sizeof(partial), "%s.partial", path);
+    remove(partial); // Left by a crash
+
+    sqlite3 *dest = NULL;
+    int rc = sqlite3_open(partial, &dest);
+    if (rc == SQLITE_OK) {
+        sqlite3_backup *copy = sqlite3_backup_init(dest, "main", source->db->db, "main");
+        if (!copy) {
+            rc = sqlite3_errcode(dest);
+        } else {
+            for (;;) {
+                if (atomic_load(&backup->cancel)) {
+                    rc = SQLITE_INTERRUPT;
+                    break;
+                }
+                rc = sqlite3_backup_step(copy, DB_BACKUP_PAGES_PER_STEP);
+
+                pthread_mutex_lock(&backup->lock);
+                backup->status.pages_total = sqlite3_backup_pagecount(copy);
+                backup->status.pages_done = backup->status.pages_total - sqlite3_backup_remaining(copy);
+                pthread_mutex_unlock(&backup->lock);
+
+                if (rc == SQLITE_DONE) {
+                    break;
+                }
+                if (rc == SQLITE_OK) {
+                    sqlite3_sleep(DB_BACKUP_STEP_PAUSE_MS);
+                } else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                    sqlite3_sleep(DB_BACKUP_BUSY_PAUSE_MS); // A write transaction is open, retry after it
+                } else {
+                    break;
+                }
+            }
+            int finish_rc = sqlite3_backup_finish(copy);
+            rc = rc == SQLITE_DONE ? finish_rc : rc;
+        }
+    }
+    if (rc != SQLITE_OK && rc != SQLITE_INTERRUPT) {
+        backup_set_message(backup, source->name, dest ? sqlite3_errmsg(dest) : sqlite3_errstr(rc));
+    }
+    sqlite3_close(dest);
+
+    if (rc != SQLITE_OK) {
+        remove(partial);
+        return rc;
+    }
+
+    if (backup->compress) {
+        char gz[DB_BACKUP_PATH_LEN];
+        if (snprintf(gz, sizeof(gz), "%s.gz", path) >= (int)sizeof(gz)) {
+            backup_set_message(backup, source->name, "backup path too long");
+            rc = SQLITE_CANTOPEN;
+        } else {
+            rc = backup_compress(backup, partial, gz, source->name);
+        }
+        remove(partial);
+        return rc;
+    }
+
+    if (!backup_replace(partial, path)) {
+        backup_set_message(backup, source->name, "cannot rename the copy");
+        remove(partial);
+        return SQLITE_IOERR;
+    }
+    return SQLITE_OK;
+}
+
+/**
+ * @internal
+ * @brief Backs up every registered database, stops at the first failure
+ */
+static void *backup_thread(void *arg) {
+    struct db_backup *backup = arg;
+
+    time_t started = time(NULL);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &started);
+#else
+    localtime_r(&started, &local);
+#endif
+    char stamp[DB_BACKUP_STAMP_LEN + 1];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+    int rc = SQLITE_OK;
+    for (int i = 0; i < backup->count && rc == SQLITE_OK; i++) {
+        const struct backup_source *source = &backup->sources[i];
+
+        pthread_mutex_lock(&backup->lock);
+        backup->status.state = DB_BACKUP_COPYING;
+        backup->status.database = i;
+        memcpy(backup->status.name, source->name, sizeof(backup->status.name));
+        backup->status.pages_done = 0;
+        backup->status.pages_total = 0;
+        backup->status.bytes_done = 0;
+        backup->status.bytes_total = 0;
+        pthread_mutex_unlock(&backup->lock);
+
+        rc = backup_copy(backup, source, stamp);
+        if (rc == SQLITE_OK) {
+            backup_rotate(backup, source->name);
+        }
+    }
+
+    time_t finished = time(NULL);
+    pthread_mutex_lock(&backup->lock);
+    backup->rc = rc;
+    if (rc == SQLITE_OK) {
+        backup->status.state = DB_BACKUP_DONE;
+        backup->status.last_success = finished;
+        backup->status.next_due = backup->interval > 0 ? finished + backup->interval : 0;
+    } else {
+        backup->status.state = DB_BACKUP_FAILED;
+        if (rc == SQLITE_INTERRUPT) {
+            snprintf(backup->status.message, sizeof(backup->status.message), "Backup canceled.");
+        } else if (backup->status.message[0] == '\0') {
+            snprintf(backup->status.message, sizeof(backup->status.message), "%s", sqlite3_errstr(rc));
+        }
+        backup->status.next_due = backup->interval > 0 ? finished + DB_BACKUP_RETRY_SECONDS : 0;
+    }
+    pthread_mutex_unlock(&backup->lock);
+
+    atomic_store(&backup->running, false);
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Joins a thread that was started, main thread only
+ */
+static void backup_join(struct db_backup *backup) {
+    if (backup->joinable) {
+        pthread_join(backup->thread, NULL);
+        backup->joinable = false;
+    }
+}
+
+/* ======================= PUBLIC FUNCTIONS ======================= */
+
+struct db_backup *db_backup_create(const struct db_backup_config *config) {
+    if (!config->dir || strlen(config->dir) >= DB_BACKUP_PATH_LEN / 2) {
+        fprintf(stderr, "Backup directory name missing or too long.\n");
+        return NULL;
+    }
+    if (!backup_mkdir(config->dir)) {
+        fprintf(stderr, "Failed to create backup directory %s: %s\n", config->dir, strerror(errno));
+        return NULL;
+    }
+
+    struct db_backup *backup = calloc(1, sizeof(*backup));
+    if (!backup) {
+        fprintf(stderr, "Failed to allocate backup manager.\n");
+        return NULL;
+    }
+    if (pthread_mutex_init(&backup->lock, NULL) != 0) {
+        free(backup);
+        return NULL;
+    }
+
+    snprintf(backup->dir, sizeof(backup->dir), "%s", config->dir);
+    backup->generations = config->generations;
+    backup->interval = config->interval;
+    backup->compress = config->compress;
+    atomic_init(&backup->running, false);
+    atomic_init(&backup->cancel, false);
+    backup->rc = SQLITE_OK;
+    backup->status.next_due = config->interval > 0 ? (time_t)config->interval : 0;
+    return backup;
+}
+
+int db_backup_add(struct db_backup *backup, database *db) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_MISUSE;
+    }
+    if (atomic_load(&backup->running)) {
+        return SQLITE_BUSY;
+    }
+    if (backup->count == DB_BACKUP_MAX_DATABASES) {
+        return SQLITE_FULL;
+    }
+
+    const char *filename = sqlite3_db_filename(db->db, "main");
+    if (!filename || filename[0] == '\0') {
+        fprintf(stderr, "Cannot back up a database that has no file.\n");
+        return SQLITE_MISUSE;
+    }
+
+    // File name without directory and extension
+    const char *base = filename;
+    for (const char *c = filename; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            base = c + 1;
+        }
+    }
+    const char *ext = strrchr(base, '.');
+    size_t len = ext && ext != base ? (size_t)(ext - base) : strlen(base);
+    if (len == 0 || len >= DB_BACKUP_NAME_LEN) {
+        fprintf(stderr, "Cannot back up %s: unusable file name.\n", filename);
+        return SQLITE_MISUSE;
+    }
+
+    struct backup_source *source = &backup->sources[backup->count];
+    source->db = db;
+    memcpy(source->name, base, len);
+    source->name[len] = '\0';
+
+    // A run backs up every database, so the oldest newest backup is when the last complete one ended
+    time_t newest = backup_newest(backup->dir, source->name);
+    pthread_mutex_lock(&backup->lock);
+    if (backup->count == 0 || newest < backup->status.last_success) {
+        backup->status.last_success = newest;
+    }
+    if (backup->interval > 0) {
+        backup->status.next_due = backup->status.last_success + backup->interval;
+    }
+    backup->status.databases = ++backup->count;
+    pthread_mutex_unlock(&backup->lock);
+    return SQLITE_OK;
+}
+
+bool db_backup_start(struct db_backup *backup) {
+    if (atomic_load(&backup->running)) {
+        return false;
+    }
+    backup_join(backup);
+
+    pthread_mutex_lock(&backup->lock);
+    backup->status.state = DB_BACKUP_COPYING;
+    backup->status.database = 0;
+    backup->status.name[0] = '\0';
+    backup->status.pages_done = 0;
+    backup->status.pages_total = 0;
+    backup->status.bytes_done = 0;
+    backup->status.bytes_total = 0;
+    backup->status.message[0] = '\0';
+    pthread_mutex_unlock(&backup->lock);
+
+    atomic_store(&backup->cancel, false);
+    atomic_store(&backup->running, true);
+    if (pthread_create(&backup->thread, NULL, backup_thread, backup) != 0) {
+        atomic_store(&backup->running, false);
+        pthread_mutex_lock(&backup->lock);
+        backup->rc = SQLITE_ERROR;
+        backup->status.state = DB_BACKUP_FAILED;
+        snprintf(backup->status.message, sizeof(backup->status.message), "Failed to start the backup thread.");
+        pthread_mutex_unlock(&backup->lock);
+        return false;
+    }
+    backup->joinable = true;
+    return true;
+}
+
+void db_backup_tick(struct db_backup *backup, time_t now) {
+    if (!backup || atomic_load(&backup->running)) {
+        return;
+    }
+    backup_join(backup);
+
+    if (backup->interval <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&backup->lock);
+    bool due = now >= backup->status.next_due;
+    pthread_mutex_unlock(&backup->lock);
+
+    if (due) {
+        db_backup_start(backup);
+    }
+}
+
+bool db_backup_running(struct db_backup *backup) {
+    return atomic_load(&backup->running);
+}
+
+void db_backup_get_status(struct db_backup *backup, struct db_backup_status *status) {
+    pthread_mutex_lock(&backup->lock);
+    *status = backup->status;
+    pthread_mutex_unlock(&backup->lock);
+
+    status->progress = 0.0f;
+    if (status->state == DB_BACKUP_DONE) {
+        status->progress = 1.0f;
+    } else if ((status->state == DB_BACKUP_COPYING || status->state == DB_BACKUP_COMPRESSING) && status->databases > 0) {
+        float part = status->pages_total > 0 ? (float)status->pages_done / (float)status->pages_total : 0.0f;
+        if (backup->compress) {
+            // Copying and compressing take about as long
+            float packed = status->bytes_total > 0 ? (float)status->bytes_done / (float)status->bytes_total : 0.0f;
+            part = (part + packed) / 2.0f;
+        }
+        status->progress = ((float)status->database + part) / (float)status->databases;
+    }
+}
+
+int db_backup_wait(struct db_backup *backup) {
+    backup_join(backup);
+
+    pthread_mutex_lock(&backup->lock);
+    int rc = backup->rc;
+    pthread_mutex_unlock(&backup->lock);
+    return rc;
+}
+
+void db_backup_free(struct db_backup *backup) {
+    if (!backup) {
+        return;
+    }
+    atomic_store(&backup->cancel, true);
+    backup_join(backup);
+    pthread_mutex_destroy(&backup->lock);
+    free(backup);
+}
@@ -0,0 +1,743 @@
+/**
+ * @file db_changes.c
+ * @brief In-process change notifications implementation
+ */
+#include "db/db_changes.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANGES_FIRST_ROWS 16 // Rows allocated for a table the first time it changes
+
+struct change_row {
+    int64_t rowid;
+    enum db_change_op op;
+};
+
+// Rows of one table of one connection
+struct change_table {
+    sqlite3 *db;
+    char name[DB_CHANGES_TABLE_LEN];
+    struct change_row *rows;
+    int count;
+    int capacity;
+    bool reset; // Over DB_CHANGES_MAX_ROWS, rows are no longer kept
+};
+
+// Entries past count are unused but keep their rows buffer, so a set cleared after every
+// commit does not allocate again
+struct change_set {
+    struct change_table *tables;
+    int count;
+    int capacity;
+    bool overflow; // A table could not be added, every subscriber gets a reset
+};
+
+struct db_change_log {
+    sqlite3 *db;
+    struct change_set staged;
+
+    // Set by db_changes_watch(), main thread only
+    bool watched;
+    sqlite3_stmt *version_stmt; // PRAGMA data_version
+    int64_t data_version;
+};
+
+// A table db_changes_poll() reads the stamped rows of when another connection commits to its file
+struct change_watch {
+    struct db_change_log *log;
+    char table[DB_CHANGES_TABLE_LEN];
+    sqlite3_stmt *mark_stmt;    // Highest stamp and rows without one
+    sqlite3_stmt *changed_stmt; // Rows and tombstones stamped past the watermark, by stamp
+    int64_t mark;               // Highest stamp published
+    int64_t unstamped;          // Rows without a stamp at the last poll
+};
+
+struct change_subscriber {
+    int id; // 0 while the slot is free
+    char table[DB_CHANGES_TABLE_LEN];
+    db_change_fn fn;
+    void *ctx;
+};
+
+// Subscribers are written on the main thread under the mutex, and read by commit hooks under it
+static struct change_subscriber changes_subscribers[DB_CHANGES_MAX_SUBSCRIBERS];
+static atomic_int changes_subscriber_count = 0; // Lets the hooks skip everything when nobody listens
+static int changes_next_id = 1;
+static pthread_mutex_t changes_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Committed and not dispatched yet (under the mutex), and being dispatched (main thread only)
+static struct change_set changes_committed;
+static struct change_set changes_delivering;
+
+// Tables of the polled connections and the changes a poll found, main thread only
+static struct change_watch changes_watched[DB_CHANGES_MAX_WATCHED];
+static struct change_set changes_polled;
+static int changes_watched_count = 0;
+static int64_t changes_next_poll_ns = 0;
+
+/* ======================= CHANGE SETS ======================= */
+
+/**
+ * @internal
+ * @brief Finds the entry of a table of a connection, adds it if missing
+ *
+ * @return Entry, NULL if the name is too long or on allocation failure (overflow is set then)
+ */
+static struct change_table *change_set_table(struct change_set *set, sqlite3 *db, const char *name) {
+    for (int i = 0; i < set->count; i++) {
+        if (set->tables[i].db == db && strcmp(set->tables[i].name, name) == 0) {
+            return &set->tables[i];
+        }
+    }
+
+    if (strlen(name) >= DB_CHANGES_TABLE_LEN) {
+        return NULL;
+    }
+
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 4;
+        struct change_table *tables = realloc(set->tables, (size_t)capacity * sizeof(*tables));
+        if (!tables) {
+            set->overflow = true;
+            return NULL;
+        }
+        memset(tables + set->capacity, 0, (size_t)(capacity - set->capacity) * sizeof(*tables));
+        set->tables = tables;
+        set->capacity = capacity;
+    }
+
+    struct change_table *table = &set->tables[set->count];
+    table->db = db;
+    memcpy(table->name, name, strlen(name) + 1);
+    table->count = 0;
+    table->reset = false;
+    set->count++;
+    return table;
+}
+
+/**
+ * @internal
+ * @brief Records a change of a row, keeping one entry per row
+ *
+ * An insert followed by updates stays an insert, otherwise the last operation wins.
+ */
+static void change_table_add(struct change_table *table, int64_t rowid, enum db_change_op op) {
+    if (table->reset) {
+        return;
+    }
+    if (op == DB_CHANGE_RESET) {
+        table->reset = true;
+        table->count = 0;
+        return;
+    }
+
+    // Recent rows are the likeliest to change again
+    for (int i = table->count - 1; i >= 0; i--) {
+        if (table->rows[i].rowid == rowid) {
+            if (!(table->rows[i].op == DB_CHANGE_INSERT && op == DB_CHANGE_UPDATE)) {
+                table->rows[i].op = op;
+            }
+            return;
+        }
+    }
+
+    if (table->count == DB_CHANGES_MAX_ROWS) {
+        table->reset = true;
+        table->count = 0;
+        return;
+    }
+
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : CHANGES_FIRST_ROWS;
+        struct change_row *rows = realloc(table->rows, (size_t)capacity * sizeof(*rows));
+        if (!rows) {
+            table->reset = true;
+            table->count = 0;
+            return;
+        }
+        table->rows = rows;
+        table->capacity = capacity;
+    }
+
+    table->rows[table->count].rowid = rowid;
+    table->rows[table->count].op = op;
+    table->count++;
+}
+
+static void change_set_clear(struct change_set *set) {
+    set->count = 0;
+    set->overflow = false;
+}
+
+static void change_set_free(struct change_set *set) {
+    for (int i = 0; i < set->capacity; i++) {
+        free(set->tables[i].rows);
+    }
+    free(set->tables);
+    memset(set, 0, sizeof(*set));
+}
+
+/**
+ * @internal
+ * @brief Whether a table has a subscriber, with the mutex held
+ */
+static bool is_subscribed(const char *table) {
+    for (int i = 0; i < DB_CHANGES_MAX_SUBSCRIBERS; i++) {
+        if (changes_subscribers[i].id != 0 && sqlite3_stricmp(changes_subscribers[i].table, table) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @internal
+ * @brief Adds the subscribed tables of a staged set to the committed one, with the mutex held
+ */
+static void change_set_merge(struct change_set *dst, const struct change_set *src) {
+    dst->overflow |= src->overflow;
+    for (int i = 0; i < src->count; i++) {
+        const struct change_table *from = &src->tables[i];
+        if (!is_subscribed(from->name)) {
+            continue;
+        }
+
+        struct change_table *to = change_set_table(dst, from->db, from->name);
+        if (!to) {
+            continue;
+        }
+        if (from->reset) {
+            change_table_add(to, 0, DB_CHANGE_RESET);
+            continue;
+        }
+        for (int r = 0; r < from->count; r++) {
+            change_table_add(to, from->rows[r].rowid, from->rows[r].op);
+        }
+    }
+}
+
+/* ======================= HOOKS ======================= */
+
+static void log_stage(struct db_change_log *log, const char *table, enum db_change_op op, int64_t rowid) {
+    if (atomic_load_explicit(&changes_subscriber_count, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    struct change_table *entry = change_set_table(&log->staged, log->db, table);
+    if (entry) {
+        change_table_add(entry, rowid, op);
+    }
+}
+
+static void update_hook(void *arg, int op, const char *database, const char *table, sqlite3_int64 rowid) {
+    (void)database;
+    log_stage(arg, table, (enum db_change_op)op, rowid);
+}
+
+static int commit_hook(void *arg) {
+    struct db_change_log *log = arg;
+    if (log->staged.count > 0 || log->staged.overflow) {
+        // The commit can still fail after this (a busy lock), the screens then refresh rows
+        // that did not change, which is harmless
+        pthread_mutex_lock(&changes_mutex);
+        change_set_merge(&changes_committed, &log->staged);
+        pthread_mutex_unlock(&changes_mutex);
+        change_set_clear(&log->staged);
+    }
+    return 0; // Never turns the commit into a rollback
+}
+
+static void rollback_hook(void *arg) {
+    struct db_change_log *log = arg;
+    change_set_clear(&log->staged);
+}
+
+/**
+ * @internal
+ * @brief db_change_note(table, op, key), called by the triggers of db_changes_track()
+ */
+static void note_function(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    (void)argc;
+    const char *table = (const char *)sqlite3_value_text(argv[0]);
+    if (table && sqlite3_value_type(argv[2]) != SQLITE_NULL) {
+        enum db_change_op op = (enum db_change_op)sqlite3_value_int(argv[1]);
+        log_stage(sqlite3_user_data(ctx), table, op, sqlite3_value_int64(argv[2]));
+    }
+    sqlite3_result_null(ctx);
+}
+
+struct db_change_log *db_changes_attach(sqlite3 *db) {
+    if (!db) {
+        return NULL;
+    }
+
+    struct db_change_log *log = calloc(1, sizeof(*log));
+    if (!log) {
+        fprintf(stderr, "Failed to allocate the change log, changes will not be published.\n");
+        return NULL;
+    }
+    log->db = db;
+
+    sqlite3_create_function(db, "db_change_note", 3, SQLITE_UTF8, log, note_function, NULL, NULL);
+    sqlite3_update_hook(db, update_hook, log);
+    sqlite3_commit_hook(db, commit_hook, log);
+    sqlite3_rollback_hook(db, rollback_hook, log);
+    return log;
+}
+
+void db_changes_detach(sqlite3 *db, struct db_change_log *log) {
+    if (!log) {
+        return;
+    }
+    if (log->watched) {
+        for (int i = changes_watched_count - 1; i >= 0; i--) {
+            if (changes_watched[i].log == log) {
+                sqlite3_finalize(changes_watched[i].mark_stmt);
+                sqlite3_finalize(changes_watched[i].changed_stmt);
+                changes_watched[i] = changes_watched[--changes_watched_count];
+            }
+        }
+        sqlite3_finalize(log->version_stmt);
+    }
+    if (db) {
+        sqlite3_update_hook(db, NULL, NULL);
+        sqlite3_commit_hook(db, NULL, NULL);
+        sqlite3_rollback_hook(db, NULL, NULL);
+        sqlite3_create_function(db, "db_change_note", 3, SQLITE_UTF8, NULL, NULL, NULL, NULL);
+    }
+    change_set_free(&log->staged);
+    free(log);
+}
+
+void db_changes_publish(const char *table, enum db_change_op op, int64_t rowid) {
+    if (!table || atomic_load_explicit(&changes_subscriber_count, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&changes_mutex);
+    if (is_subscribed(table)) {
+        struct change_table *entry = change_set_table(&changes_committed, NULL, table);
+        if (entry) {
+            change_table_add(entry, op == DB_CHANGE_RESET ? 0 : rowid, op);
+        }
+    }
+    pthread_mutex_unlock(&changes_mutex);
+}
+
+int db_changes_track(database *db, const char *table, const char *key) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    char *sql = sqlite3_mprintf(
+        "CREATE TEMP TRIGGER IF NOT EXISTS \"%w_changes_ai\" AFTER INSERT ON main.\"%w\" BEGIN "
+        "SELECT db_change_note(%Q, %d, new.\"%w\"); END;"
+        "CREATE TEMP TRIGGER IF NOT EXISTS \"%w_changes_ad\" AFTER DELETE ON main.\"%w\" BEGIN "
+        "SELECT db_change_note(%Q, %d, old.\"%w\"); END;"
+        "CREATE TEMP TRIGGER IF NOT EXISTS \"%w_changes_au\" AFTER UPDATE ON main.\"%w\" BEGIN "
+        "SELECT db_change_note(%Q, %d, old.\"%w\") WHERE old.\"%w\" IS NOT new.\"%w\";"
+        "SELECT db_change_note(%Q, %d, new.\"%w\") WHERE old.\"%w\" IS NOT new.\"%w\";"
+        "SELECT db_change_note(%Q, %d, new.\"%w\") WHERE old.\"%w\" IS new.\"%w\"; END;",
+        table, table, table, DB_CHANGE_INSERT, key,
+        table, table, table, DB_CHANGE_DELETE, key,
+        table, table, table, DB_CHANGE_DELETE, key, key, key,
+        table, DB_CHANGE_INSERT, key, key, key,
+        table, DB_CHANGE_UPDATE, key, key, key
+    );
+    if (!sql) {
+        return SQLITE_NOMEM;
+    }
+
+    char *errMsg = 0;
+    int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on creating the change triggers of %s: %s\n", table, errMsg);
+        sqlite3_free(errMsg);
+    }
+    return rc;
+}
+
+/* ======================= OTHER PROCESSES ======================= */
+
+int db_changes_stamp(database *db, const char *table, const char *key) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    char *errMsg = 0;
+    int rc = SQLITE_OK;
+    if (!db_table_has_column(db, table, "Changed", NULL)) {
+        char *sql = sqlite3_mprintf(
+            "BEGIN;"
+            "ALTER TABLE \"%w\" ADD COLUMN Created INTEGER;"
+            "ALTER TABLE \"%w\" ADD COLUMN Changed INTEGER;"
+            "UPDATE \"%w\" SET Changed = 0;"
+            "COMMIT;",
+            table, table, table
+        );
+        if (!sql) {
+            return SQLITE_NOMEM;
+        }
+        rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+        sqlite3_free(sql);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error on adding the stamp of %s: %s\n", table, errMsg);
+            sqlite3_free(errMsg);
+            sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+            return rc;
+        }
+    }
+
+    // BEFORE DELETE: the stamp is taken while the row, maybe the highest stamped one, is still there
+    char *sql = sqlite3_mprintf(
+        "CREATE TABLE IF NOT EXISTS DeletedRow ("
+        "TableName TEXT NOT NULL, RowKey INTEGER NOT NULL, Changed INTEGER NOT NULL);"
+        "CREATE INDEX IF NOT EXISTS DeletedRow_Changed ON DeletedRow(TableName, Changed);"
+        "CREATE INDEX IF NOT EXISTS \"%w_Changed\" ON \"%w\"(Changed);"
+        "CREATE TRIGGER IF NOT EXISTS \"%w_deleted\" BEFORE DELETE ON \"%w\" BEGIN "
+        "INSERT INTO DeletedRow (TableName, RowKey, Changed) SELECT %Q, old.\"%w\", ifnull(max(Changed), 0) + 1 "
+        "FROM (SELECT max(Changed) AS Changed FROM \"%w\" UNION ALL "
+        "SELECT max(Changed) FROM DeletedRow WHERE TableName = %Q);"
+        "DELETE FROM DeletedRow WHERE TableName = %Q "
+        "AND Changed < (SELECT max(Changed) FROM DeletedRow WHERE TableName = %Q) - %d; END;",
+        table, table,
+        table, table,
+        table, key,
+        table, table,
+        table, table, DB_CHANGES_MAX_ROWS
+    );
+    if (!sql) {
+        return SQLITE_NOMEM;
+    }
+    rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on creating the tombstones of %s: %s\n", table, errMsg);
+        sqlite3_free(errMsg);
+    }
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Reads PRAGMA data_version of a watched connection
+ */
+static int log_read_version(struct db_change_log *log, int64_t *version) {
+    int rc = sqlite3_step(log->version_stmt);
+    if (rc == SQLITE_ROW) {
+        *version = sqlite3_column_int64(log->version_stmt, 0);
+        rc = SQLITE_OK;
+    }
+    sqlite3_reset(log->version_stmt);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Reads the highest stamp of a watched table and its rows without a stamp
+ */
+static int watch_read_mark(struct change_watch *watch, int64_t *mark, int64_t *unstamped) {
+    int rc = sqlite3_step(watch->mark_stmt);
+    if (rc == SQLITE_ROW) {
+        *mark = sqlite3_column_int64(watch->mark_stmt, 0);
+        *unstamped = sqlite3_column_int64(watch->mark_stmt, 1);
+        rc = SQLITE_OK;
+    }
+    sqlite3_reset(watch->mark_stmt);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Prepares the statements of a watched table and reads its watermark
+ */
+static int watch_prepare(struct change_watch *watch, const char *key) {
+    sqlite3 *db = watch->log->db;
+    const char *table = watch->table;
+
+    char *sql = sqlite3_mprintf(
+        "SELECT (SELECT ifnull(max(Changed), 0) FROM (SELECT max(Changed) AS Changed FROM \"%w\" UNION ALL "
+        "SELECT max(Changed) FROM DeletedRow WHERE TableName = %Q)), "
+        "(SELECT count(*) FROM \"%w\" WHERE Changed IS NULL);",
+        table, table, table
+    );
+    int rc = sql ? sqlite3_prepare_v2(db, sql, -1, &watch->mark_stmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    // One past DB_CHANGES_MAX_ROWS is enough to know the table is reset
+    sql = sqlite3_mprintf(
+        "SELECT \"%w\", CASE WHEN ifnull(Created, Changed) > ?1 THEN %d ELSE %d END, Changed FROM \"%w\" "
+        "WHERE Changed > ?1 UNION ALL "
+        "SELECT RowKey, %d, Changed FROM DeletedRow WHERE TableName = %Q AND Changed > ?1 "
+        "ORDER BY 3 LIMIT %d;",
+        key, DB_CHANGE_INSERT, DB_CHANGE_UPDATE, table,
+        DB_CHANGE_DELETE, table,
+        DB_CHANGES_MAX_ROWS + 1
+    );
+    rc = sql ? sqlite3_prepare_v2(db, sql, -1, &watch->changed_stmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    return watch_read_mark(watch, &watch->mark, &watch->unstamped);
+}
+
+int db_changes_watch(database *db, const char *table, const char *key) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct db_change_log *log = db->changes;
+    if (!log || !table || !key || strlen(table) >= DB_CHANGES_TABLE_LEN) {
+        return SQLITE_MISUSE; // Its changes are not published either
+    }
+    for (int i = 0; i < changes_watched_count; i++) {
+        if (changes_watched[i].log == log && sqlite3_stricmp(changes_watched[i].table, table) == 0) {
+            return SQLITE_OK;
+        }
+    }
+    if (changes_watched_count == DB_CHANGES_MAX_WATCHED) {
+        fprintf(stderr, "Too many watched tables, changes of other processes to %s will not be seen.\n", table);
+        return SQLITE_FULL;
+    }
+
+    if (!log->watched) {
+        int rc = sqlite3_prepare_v2(db->db, "PRAGMA data_version;", -1, &log->version_stmt, 0);
+        if (rc == SQLITE_OK) {
+            rc = log_read_version(log, &log->data_version);
+        }
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Failed to watch the database: %s\n", sqlite3_errmsg(db->db));
+            sqlite3_finalize(log->version_stmt);
+            log->version_stmt = NULL;
+            return rc;
+        }
+        log->watched = true;
+    }
+
+    struct change_watch *watch = &changes_watched[changes_watched_count];
+    memset(watch, 0, sizeof(*watch));
+    watch->log = log;
+    memcpy(watch->table, table, strlen(table) + 1);
+    int rc = watch_prepare(watch, key);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to watch %s: %s\n", table, sqlite3_errmsg(db->db));
+        sqlite3_finalize(watch->mark_stmt);
+        sqlite3_finalize(watch->changed_stmt);
+        return rc;
+    }
+    changes_watched_count++;
+    return SQLITE_OK;
+}
+
+/**
+ * @internal
+ * @brief Adds the rows of a watched table stamped past its watermark to changes_polled, with the
+ *        connection mutex held
+ *
+ * The table is reset instead when the watermark cannot be trusted.
+ */
+static void watch_collect(struct change_watch *watch) {
+    int64_t mark = 0;
+    int64_t unstamped = 0;
+    bool read = watch_read_mark(watch, &mark, &unstamped) == SQLITE_OK;
+    if (read && mark == watch->mark && unstamped == watch->unstamped) {
+        return; // The commit wrote other tables of the file
+    }
+
+    struct change_table *entry = change_set_table(&changes_polled, watch->log->db, watch->table);
+    if (!entry) {
+        return;
+    }
+
+    bool trusted = read && mark >= watch->mark && mark - watch->mark <= DB_CHANGES_MAX_ROWS
+        && unstamped == watch->unstamped;
+    if (trusted) {
+        int rc;
+        sqlite3_bind_int64(watch->changed_stmt, 1, watch->mark);
+        while ((rc = sqlite3_step(watch->changed_stmt)) == SQLITE_ROW) {
+            enum db_change_op op = (enum db_change_op)sqlite3_column_int(watch->changed_stmt, 1);
+            change_table_add(entry, sqlite3_column_int64(watch->changed_stmt, 0), op);
+        }
+        sqlite3_reset(watch->changed_stmt);
+        trusted = rc == SQLITE_DONE;
+    }
+    if (!trusted) {
+        change_table_add(entry, 0, DB_CHANGE_RESET);
+    }
+
+    if (read) {
+        watch->mark = mark;
+        watch->unstamped = unstamped;
+    }
+}
+
+/**
+ * @internal
+ * @brief Collects the changed rows of the watched tables of a connection if another connection
+ *        committed to its file since the last poll
+ */
+static void log_poll(struct db_change_log *log) {
+    // Skipped while another thread uses the connection (the maintenance or backup thread)
+    sqlite3_mutex *mutex = sqlite3_db_mutex(log->db);
+    if (sqlite3_mutex_try(mutex) != SQLITE_OK) {
+        return;
+    }
+
+    // Commits of this connection do not move it, its hooks published them already
+    int64_t version = 0;
+    if (log_read_version(log, &version) == SQLITE_OK && version != log->data_version) {
+        log->data_version = version;
+        for (int i = 0; i < changes_watched_count; i++) {
+            if (changes_watched[i].log == log) {
+                watch_collect(&changes_watched[i]);
+            }
+        }
+    }
+
+    sqlite3_mutex_leave(mutex);
+}
+
+int db_changes_poll(int64_t now_ns) {
+    if (changes_watched_count == 0 || now_ns < changes_next_poll_ns) {
+        return 0;
+    }
+    changes_next_poll_ns = now_ns + DB_CHANGES_POLL_NS;
+
+    // One read per connection, however many of its tables are watched
+    for (int i = 0; i < changes_watched_count; i++) {
+        struct db_change_log *log = changes_watched[i].log;
+        bool first = true;
+        for (int j = 0; j < i && first; j++) {
+            first = changes_watched[j].log != log;
+        }
+        if (first) {
+            log_poll(log);
+        }
+    }
+    if (changes_polled.count == 0 && !changes_polled.overflow) {
+        return 0;
+    }
+
+    int published = 0;
+    pthread_mutex_lock(&changes_mutex);
+    for (int i = 0; i < changes_polled.count; i++) {
+        published += is_subscribed(changes_polled.tables[i].name);
+    }
+    change_set_merge(&changes_committed, &changes_polled);
+    pthread_mutex_unlock(&changes_mutex);
+    change_set_clear(&changes_polled);
+    return published;
+}
+
+/* ======================= SUBSCRIPTIONS ======================= */
+
+int db_changes_subscribe(const char *table, db_change_fn fn, void *ctx) {
+    if (!table || !fn || strlen(table) >= DB_CHANGES_TABLE_LEN) {
+        return 0;
+    }
+
+    int id = 0;
+    pthread_mutex_lock(&changes_mutex);
+    for (int i = 0; i < DB_CHANGES_MAX_SUBSCRIBERS; i++) {
+        struct change_subscriber *sub = &changes_subscribers[i];
+        if (sub->id == 0) {
+            memcpy(sub->table, table, strlen(table) + 1);
+            sub->fn = fn;
+            sub->ctx = ctx;
+            sub->id = id = changes_next_id++;
+            atomic_fetch_add(&changes_subscriber_count, 1);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&changes_mutex);
+
+    if (id == 0) {
+        fprintf(stderr, "Too many change subscribers, %s changes will not be delivered.\n", table);
+    }
+    return id;
+}
+
+void db_changes_unsubscribe(int id) {
+    if (id == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&changes_mutex);
+    for (int i = 0; i < DB_CHANGES_MAX_SUBSCRIBERS; i++) {
+        if (changes_subscribers[i].id == id) {
+            changes_subscribers[i].id = 0;
+            atomic_fetch_sub(&changes_subscriber_count, 1);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&changes_mutex);
+}
+
+/* ======================= DISPATCH ======================= */
+
+int db_changes_dispatch(void) {
+    if (atomic_load_explicit(&changes_subscriber_count, memory_order_relaxed) == 0) {
+        return 0;
+    }
+
+    // Swapping lets the writers publish while the subscribers run
+    pthread_mutex_lock(&changes_mutex);
+    struct change_set set = changes_committed;
+    changes_committed = changes_delivering;
+    pthread_mutex_unlock(&changes_mutex);
+    changes_delivering = set;
+
+    // Subscribers only change on this thread, a callback (un)subscribing is seen at once
+    int delivered = 0;
+    for (int i = 0; i < DB_CHANGES_MAX_SUBSCRIBERS; i++) {
+        struct change_subscriber *sub = &changes_subscribers[i];
+        if (sub->id == 0) {
+            continue;
+        }
+
+        if (set.overflow) {
+            struct db_change change = { NULL, sub->table, DB_CHANGE_RESET, 0 };
+            sub->fn(&change, sub->ctx);
+            delivered++;
+            continue;
+        }
+
+        int id = sub->id;
+        for (int t = 0; t < set.count && sub->id == id; t++) {
+            const struct change_table *table = &set.tables[t];
+            if (sqlite3_stricmp(table->name, sub->table) != 0) {
+                continue;
+            }
+
+            struct db_change change = { table->db, table->name, DB_CHANGE_RESET, 0 };
+            if (table->reset) {
+                sub->fn(&change, sub->ctx);
+                delivered++;
+                continue;
+            }
+            for (int r = 0; r < table->count && sub->id == id; r++) {
+                change.op = table->rows[r].op;
+                change.rowid = table->rows[r].rowid;
+                sub->fn(&change, sub->ctx);
+                delivered++;
+            }
+        }
+    }
+
+    change_set_clear(&changes_delivering);
+    return delivered;
+}
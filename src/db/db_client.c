@@ -0,0 +1,934 @@
+/**
+ * @file db_client.c
+ * @brief Client backend of the database server implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For the socket functions
+
+#include "db/db_client.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "db/db_changes.h"
+#include "db/db_protocol.h"
+
+struct db_client {
+    pthread_mutex_t lock;          ///< One call in flight, guards everything below
+    char path[DB_SOCKET_PATH_LEN]; ///< Socket of the server, to connect again
+    int fd;                        ///< -1 while disconnected
+    uint32_t next_id;              ///< Id of the request being built
+    struct db_wire request;        ///< Request being built, its buffer is reused
+    uint8_t *reply;                ///< Receive buffer, reused
+    size_t reply_capacity;         ///< Size of reply
+    struct db_wire_reader values;  ///< Values of the last reply, after its result
+};
+
+/* ======================= CONNECTION ======================= */
+
+#ifdef _WIN32
+
+static int client_open(const char *path) {
+    (void)path;
+    fprintf(stderr, "The database server needs Unix domain sockets, not available on this platform.\n");
+    return -1;
+}
+
+static void client_close_fd(int fd) {
+    (void)fd;
+}
+
+#else
+
+/**
+ * @internal
+ * @brief Connects and says hello
+ *
+ * @return Connected socket, -1 on failure (printed on stderr)
+ */
+static int client_open(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1); // Length checked by db_client_connect()
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Can't reach the database server at %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // Same version or nothing, every reply would be misread otherwise
+    struct db_wire hello = { 0 };
+    db_wire_begin(&hello);
+    db_wire_put_u32(&hello, 0);
+    db_wire_put_u8(&hello, DB_OP_HELLO);
+    db_wire_put_u32(&hello, DB_PROTOCOL_VERSION);
+
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    struct db_wire_reader reply;
+    bool ok = db_wire_end(&hello) && db_wire_send(fd, &hello) && db_wire_recv(fd, &buffer, &capacity, &reply);
+    if (ok) {
+        db_wire_get_u32(&reply);
+        ok = db_wire_get_i32(&reply) == SQLITE_OK && !reply.failed;
+    }
+    db_wire_free(&hello);
+    free(buffer);
+
+    if (!ok) {
+        fprintf(stderr, "The database server at %s refused the connection (protocol %d).\n", path, DB_PROTOCOL_VERSION);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void client_close_fd(int fd) {
+    close(fd);
+}
+
+#endif
+
+/**
+ * @internal
+ * @brief Drops a broken connection, the next call connects again
+ */
+static void client_disconnect(struct db_client *client, const char *why) {
+    fprintf(stderr, "%s (%s)\n", why, client->path);
+    client_close_fd(client->fd);
+    client->fd = -1;
+}
+
+struct db_client *db_client_connect(const char *socket_path) {
+    if (!socket_path || strlen(socket_path) >= DB_SOCKET_PATH_LEN) {
+        fprintf(stderr, "Invalid database server socket path.\n");
+        return NULL;
+    }
+
+    struct db_client *client = calloc(1, sizeof(*client));
+    if (!client) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+    memcpy(client->path, socket_path, strlen(socket_path) + 1);
+
+    client->fd = client_open(client->path);
+    if (client->fd < 0) {
+        free(client);
+        return NULL;
+    }
+    pthread_mutex_init(&client->lock, NULL);
+    return client;
+}
+
+void db_client_attach(struct db_client *client, database *db) {
+    db->db = NULL;
+    db->pool = NULL;
+    db->changes = NULL;
+    db->remote = client;
+}
+
+bool db_client_connected(struct db_client *client) {
+    pthread_mutex_lock(&client->lock);
+    bool connected = client->fd >= 0;
+    pthread_mutex_unlock(&client->lock);
+    return connected;
+}
+
+void db_client_close(struct db_client *client) {
+    if (!client) {
+        return;
+    }
+    if (client->fd >= 0) {
+        client_close_fd(client->fd);
+    }
+    pthread_mutex_destroy(&client->lock);
+    db_wire_free(&client->request);
+    free(client->reply);
+    free(client);
+}
+
+/* ======================= CALLS ======================= */
+
+/**
+ * @internal
+ * @brief Takes the connection and starts a request, finish with client_end()
+ *
+ * @return Request to add the arguments to
+ */
+static struct db_wire *client_begin(struct db_client *client, enum db_op op) {
+    pthread_mutex_lock(&client->lock);
+    db_wire_begin(&client->request);
+    db_wire_put_u32(&client->request, ++client->next_id);
+    db_wire_put_u8(&client->request, (uint8_t)op);
+    return &client->request;
+}
+
+/**
+ * @internal
+ * @brief Sends the request and waits for the reply, connecting again first if needed
+ *
+ * @param[out] result Result of the call, untouched on failure
+ * @return true if the server replied, its values are in client->values then
+ */
+static bool client_call(struct db_client *client, int32_t *result) {
+    if (!db_wire_end(&client->request)) {
+        fprintf(stderr, "Request too large for the database server.\n");
+        return false;
+    }
+    if (client->fd < 0 && (client->fd = client_open(client->path)) < 0) {
+        return false;
+    }
+
+    struct db_wire_reader reply;
+    if (!db_wire_send(client->fd, &client->request)
+        || !db_wire_recv(client->fd, &client->reply, &client->reply_capacity, &reply)) {
+        client_disconnect(client, "Lost the connection to the database server");
+        return false;
+    }
+
+    uint32_t id = db_wire_get_u32(&reply);
+    int32_t value = db_wire_get_i32(&reply);
+    if (reply.failed || id != client->next_id) {
+        client_disconnect(client, "Unexpected reply from the database server");
+        return false;
+    }
+    client->values = reply;
+    *result = value;
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Checks the values of the reply were all there
+ *
+ * @return result, or fallback if they were not (the connection is dropped then)
+ */
+static int32_t client_check(struct db_client *client, int32_t result, int32_t fallback) {
+    if (client->values.failed) {
+        client_disconnect(client, "Truncated reply from the database server");
+        return fallback;
+    }
+    return result;
+}
+
+static void client_end(struct db_client *client) {
+    pthread_mutex_unlock(&client->lock);
+}
+
+/**
+ * @internal
+ * @brief Calls and ends a request whose result is all the caller needs
+ *
+ * @return Result of the call, fallback if the server could not be reached
+ */
+static int32_t client_finish(struct db_client *client, int32_t fallback) {
+    int32_t result = fallback;
+    client_call(client, &result);
+    client_end(client);
+    return result;
+}
+
+/**
+ * @internal
+ * @brief Publishes a write the server committed, this process has no hooks on its connection
+ *
+ * @return result
+ */
+static int32_t client_published(int32_t result, const char *table, enum db_change_op op, int64_t rowid) {
+    if (result == SQLITE_OK && rowid >= 0) {
+        db_changes_publish(table, op, rowid);
+    }
+    return result;
+}
+
+/**
+ * @internal
+ * @brief Adds the buffer size to a *_FORMAT_* request, calls it and copies the text
+ *
+ * @return Bytes written (excluding the terminator), -1 on failure or if buffer is too small
+ */
+static int client_format(struct db_client *client, char *buffer, size_t buffer_size) {
+    db_wire_put_u32(&client->request, buffer_size > UINT32_MAX ? UINT32_MAX : (uint32_t)buffer_size);
+
+    int32_t result = -1;
+    if (client_call(client, &result) && result >= 0) {
+        size_t len;
+        const char *text = db_wire_get_bytes(&client->values, &len);
+        result = client_check(client, result, -1);
+        if (result >= 0 && text && len < buffer_size) {
+            memcpy(buffer, text, len);
+            buffer[len] = '\0';
+        } else {
+            result = -1;
+        }
+    }
+    client_end(client);
+    return result;
+}
+
+/**
+ * @internal
+ * @brief Prints a whole table, as the local *_get_all() do
+ */
+static int client_print(struct db_client *client, enum db_op op) {
+    char *buffer = malloc(DB_CLIENT_PRINT_BYTES);
+    if (!buffer) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return SQLITE_NOMEM;
+    }
+
+    client_begin(client, op);
+    int len = client_format(client, buffer, DB_CLIENT_PRINT_BYTES);
+    if (len >= 0) {
+        fputs(buffer, stdout);
+    }
+    free(buffer);
+    return len >= 0 ? SQLITE_OK : SQLITE_ERROR;
+}
+
+/* ======================= RESIDENTS ======================= */
+
+int db_client_resident_insert(
+    struct db_client *client,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender
+) {
+    struct db_wire *request = client_begin(client, DB_OP_RESIDENT_INSERT);
+    db_wire_put_str(request, cpf);
+    db_wire_put_str(request, name);
+    db_wire_put_i32(request, age);
+    db_wire_put_str(request, health_status);
+    db_wire_put_str(request, needs);
+    db_wire_put_u8(request, medical_assistance);
+    db_wire_put_i32(request, gender);
+    int32_t result = client_finish(client, SQLITE_IOERR);
+    return client_published(result, "Resident", DB_CHANGE_INSERT, resident_db_cpf_pack(cpf));
+}
+
+/**
+ * @internal
+ * @brief Reads the candidates of a duplicate lookup, keeping the first max
+ *
+ * @return Candidates written to out
+ */
+static int client_get_duplicates(struct db_client *client, struct resident_duplicate *out, int max) {
+    struct db_wire_reader *values = &client->values;
+    uint32_t count = db_wire_get_u32(values);
+    int written = 0;
+    for (uint32_t i = 0; i < count && !values->failed; i++) {
+        struct resident_duplicate candidate;
+        db_wire_get_str(values, candidate.cpf, sizeof(candidate.cpf));
+        db_wire_get_str(values, candidate.name, sizeof(candidate.name));
+        candidate.similarity = (float)db_wire_get_f64(values);
+        if (written < max) {
+            out[written++] = candidate;
+        }
+    }
+    return written;
+}
+
+int db_client_resident_find_duplicates(
+    struct db_client *client,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+) {
+    struct db_wire *request = client_begin(client, DB_OP_RESIDENT_DUPLICATES);
+    db_wire_put_str(request, name);
+    db_wire_put_str(request, exclude_cpf);
+    db_wire_put_f64(request, threshold);
+    db_wire_put_i32(request, max);
+
+    int32_t result = -1;
+    if (client_call(client, &result) && result >= 0) {
+        result = client_check(client, client_get_duplicates(client, out, max), -1);
+    }
+    client_end(client);
+    return result;
+}
+
+int db_client_resident_insert_checked(
+    struct db_client *client,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender,
+    float threshold,
+    struct resident_duplicate *duplicates,
+    int max,
+    int *duplicate_count
+) {
+    struct db_wire *request = client_begin(client, DB_OP_RESIDENT_INSERT_CHECKED);
+    db_wire_put_str(request, cpf);
+    db_wire_put_str(request, name);
+    db_wire_put_i32(request, age);
+    db_wire_put_str(request, health_status);
+    db_wire_put_str(request, needs);
+    db_wire_put_u8(request, medical_assistance);
+    db_wire_put_i32(request, gender);
+    db_wire_put_f64(request, threshold);
+    db_wire_put_i32(request, max);
+
+    int32_t result = SQLITE_IOERR;
+    if (client_call(client, &result) && result == SQLITE_OK) {
+        // The resident is in, a truncated list only loses the candidates
+        *duplicate_count = client_get_duplicates(client, duplicates, max);
+        if (client_check(client, 0, -1) < 0) {
+            *duplicate_count = 0;
+        }
+    }
+    client_end(client);
+    return client_published(result, "Resident", DB_CHANGE_INSERT, resident_db_cpf_pack(cpf));
+}
+
+int db_client_resident_update(
+    struct db_client *client,
+    const char *cpf,
+    const char *name_input,
+    int age_input,
+    const char *health_status_input,
+    const char *needs_input,
+    int medical_assistance_input,
+    int gender_input
+) {
+    struct db_wire *request = client_begin(client, DB_OP_RESIDENT_UPDATE);
+    db_wire_put_str(request, cpf);
+    db_wire_put_str(request, name_input);
+    db_wire_put_i32(request, age_input);
+    db_wire_put_str(request, health_status_input);
+    db_wire_put_str(request, needs_input);
+    db_wire_put_i32(request, medical_assistance_input);
+    db_wire_put_i32(request, gender_input);
+    int32_t result = client_finish(client, SQLITE_IOERR);
+    return client_published(result, "Resident", DB_CHANGE_UPDATE, resident_db_cpf_pack(cpf));
+}
+
+int db_client_resident_delete_by_cpf(struct db_client *client, const char *cpf) {
+    db_wire_put_str(client_begin(client, DB_OP_RESIDENT_DELETE), cpf);
+    int32_t result = client_finish(client, SQLITE_IOERR);
+    return client_published(result, "Resident", DB_CHANGE_DELETE, resident_db_cpf_pack(cpf));
+}
+
+bool db_client_resident_check_cpf_exists(struct db_client *client, const char *cpf) {
+    db_wire_put_str(client_begin(client, DB_OP_RESIDENT_EXISTS), cpf);
+    return client_finish(client, false) != 0;
+}
+
+/**
+ * @internal
+ * @brief Reads a resident, in the order db_server.c adds it
+ */
+static void client_get_resident(struct db_wire_reader *values, void *item) {
+    struct resident *resident = item;
+    db_wire_get_str(values, resident->cpf, sizeof(resident->cpf));
+    resident->cpf_packed = db_wire_get_i64(values);
+    db_wire_get_str(values, resident->name, sizeof(resident->name));
+    resident->age = db_wire_get_i32(values);
+    db_wire_get_str(values, resident->health_status, sizeof(resident->health_status));
+    db_wire_get_str(values, resident->needs, sizeof(resident->needs));
+    resident->medical_assistance = db_wire_get_u8(values) != 0;
+    resident->gender = (enum gender)db_wire_get_i32(values);
+    resident->entry_day = db_wire_get_i32(values);
+    db_wire_get_str(values, resident->entry_date, sizeof(resident->entry_date));
+}
+
+/**
+ * @internal
+ * @brief Reads a food batch, in the order db_server.c adds it
+ */
+static void client_get_foodbatch(struct db_wire_reader *values, void *item) {
+    struct foodbatch *foodbatch = item;
+    foodbatch->batch_id = db_wire_get_i32(values);
+    db_wire_get_str(values, foodbatch->name, sizeof(foodbatch->name));
+    foodbatch->quantity = db_wire_get_i32(values);
+    foodbatch->is_perishable = db_wire_get_u8(values) != 0;
+    foodbatch->expiration_day = db_wire_get_i32(values);
+    db_wire_get_str(values, foodbatch->expiration_date, sizeof(foodbatch->expiration_date));
+    foodbatch->daily_consumption_rate = (float)db_wire_get_f64(values);
+}
+
+/**
+ * @internal
+ * @brief Fetches one page of a paged query (*_BETWEEN, *_IN_STOCK) and copies its rows out of the reply
+ *
+ * The rows are copied so the callbacks run without the connection held, they may call the
+ * server themselves.
+ *
+ * @param[in] skip Rows received in the pages before
+ * @param[out] items Rows of the page (free()), NULL if there were none
+ * @param[out] more Whether another page follows
+ * @return Rows in the page, -1 on failure
+ */
+static int client_page(
+    struct db_client *client,
+    enum db_op op,
+    int32_t from_day,
+    int32_t to_day,
+    uint32_t skip,
+    size_t item_size,
+    void (*get)(struct db_wire_reader *values, void *item),
+    void **items,
+    bool *more
+) {
+    struct db_wire *request = client_begin(client, op);
+    db_wire_put_i32(request, from_day);
+    db_wire_put_i32(request, to_day);
+    db_wire_put_u32(request, skip);
+
+    *items = NULL;
+    *more = false;
+    int32_t result = -1;
+    if (client_call(client, &result) && result > 0) {
+        char *rows = malloc(item_size * (size_t)result);
+        if (rows) {
+            for (int32_t i = 0; i < result; i++) {
+                get(&client->values, rows + item_size * (size_t)i);
+            }
+            *more = db_wire_get_u8(&client->values) != 0;
+            result = client_check(client, result, -1);
+        } else {
+            fprintf(stderr, "Memory allocation failed.\n");
+            result = -1;
+        }
+        if (result < 0) {
+            free(rows);
+            rows = NULL;
+        }
+        *items = rows;
+    }
+    client_end(client);
+    return result;
+}
+
+int db_client_resident_get_by_cpf(struct db_client *client, const char *cpf, struct resident *resident) {
+    db_wire_put_str(client_begin(client, DB_OP_RESIDENT_GET), cpf);
+
+    int32_t result = SQLITE_IOERR;
+    if (client_call(client, &result) && result == SQLITE_OK) {
+        client_get_resident(&client->values, resident);
+        result = client_check(client, result, SQLITE_IOERR);
+    }
+    client_end(client);
+    return result;
+}
+
+int db_client_resident_entered_between(
+    struct db_client *client,
+    int32_t from_day,
+    int32_t to_day,
+    resident_callback callback,
+    void *ctx
+) {
+    if (!callback) {
+        fprintf(stderr, "Invalid callback provided.\n");
+        return -1;
+    }
+
+    int found = 0;
+    for (;;) {
+        void *items;
+        bool more;
+        int count = client_page(
+            client,
+            DB_OP_RESIDENT_ENTERED_BETWEEN,
+            from_day,
+            to_day,
+            (uint32_t)found,
+            sizeof(struct resident),
+            client_get_resident,
+            &items,
+            &more
+        );
+        if (count < 0) {
+            return -1;
+        }
+
+        const struct resident *residents = items;
+        bool stop = false;
+        for (int i = 0; i < count && !stop; i++) {
+            found++;
+            stop = callback(ctx, &residents[i]) != 0;
+        }
+        free(items);
+        if (stop || !more) {
+            return found;
+        }
+    }
+}
+
+int db_client_resident_search(
+    struct db_client *client,
+    const char *query,
+    int limit,
+    resident_callback callback,
+    void *ctx
+) {
+    if (!query || !callback || limit <= 0) {
+        fprintf(stderr, "Invalid search arguments provided.\n");
+        return -1;
+    }
+
+    struct db_wire *request = client_begin(client, DB_OP_RESIDENT_SEARCH);
+    db_wire_put_str(request, query);
+    db_wire_put_i32(request, limit);
+
+    // Copied out like a page, the callbacks run with the connection free
+    struct resident *found = NULL;
+    int32_t result = -1;
+    if (client_call(client, &result) && result > 0) {
+        found = result <= limit ? malloc(sizeof(*found) * (size_t)result) : NULL;
+        if (found) {
+            for (int32_t i = 0; i < result; i++) {
+                client_get_resident(&client->values, &found[i]);
+            }
+            result = client_check(client, result, -1);
+        } else {
+            fprintf(stderr, "Invalid search results from the database server.\n");
+            result = -1;
+        }
+    }
+    client_end(client);
+
+    for (int32_t i = 0; i < result; i++) {
+        if (callback(ctx, &found[i]) != 0) {
+            result = i + 1; // Caller asked to stop early
+            break;
+        }
+    }
+    free(found);
+    return result;
+}
+
+int db_client_resident_get_count(struct db_client *client) {
+    client_begin(client, DB_OP_RESIDENT_COUNT);
+    return client_finish(client, -1);
+}
+
+int db_client_resident_get_all_format(struct db_client *client, char *buffer, size_t buffer_size) {
+    client_begin(client, DB_OP_RESIDENT_FORMAT_ALL);
+    return client_format(client, buffer, buffer_size);
+}
+
+int db_client_resident_get_format_by_cpf(struct db_client *client, const char *cpf, char *buffer, size_t buffer_size) {
+    db_wire_put_str(client_begin(client, DB_OP_RESIDENT_FORMAT_ONE), cpf);
+    return client_format(client, buffer, buffer_size);
+}
+
+int db_client_resident_get_all(struct db_client *client) {
+    return client_print(client, DB_OP_RESIDENT_FORMAT_ALL);
+}
+
+/* ======================= FOOD BATCHES ======================= */
+
+int db_client_foodbatch_insert(
+    struct db_client *client,
+    int batch_id,
+    const char *name,
+    int quantity,
+    bool is_perishable,
+    const char *expiration_date,
+    float daily_consumption_rate
+) {
+    struct db_wire *request = client_begin(client, DB_OP_FOODBATCH_INSERT);
+    db_wire_put_i32(request, batch_id);
+    db_wire_put_str(request, name);
+    db_wire_put_i32(request, quantity);
+    db_wire_put_u8(request, is_perishable);
+    db_wire_put_str(request, expiration_date);
+    db_wire_put_f64(request, daily_consumption_rate);
+    return client_published(client_finish(client, SQLITE_IOERR), "FoodBatch", DB_CHANGE_INSERT, batch_id);
+}
+
+int db_client_foodbatch_update(
+    struct db_client *client,
+    int batch_id,
+    const char *name_input,
+    int quantity_input,
+    bool is_perishable_input,
+    const char *expiration_date_input,
+    float daily_consumption_rate_input
+) {
+    struct db_wire *request = client_begin(client, DB_OP_FOODBATCH_UPDATE);
+    db_wire_put_i32(request, batch_id);
+    db_wire_put_str(request, name_input);
+    db_wire_put_i32(request, quantity_input);
+    db_wire_put_u8(request, is_perishable_input);
+    db_wire_put_str(request, expiration_date_input);
+    db_wire_put_f64(request, daily_consumption_rate_input);
+    return client_published(client_finish(client, SQLITE_IOERR), "FoodBatch", DB_CHANGE_UPDATE, batch_id);
+}
+
+int db_client_foodbatch_take_quantity(struct db_client *client, int batch_id, int amount) {
+    struct db_wire *request = client_begin(client, DB_OP_FOODBATCH_TAKE);
+    db_wire_put_i32(request, batch_id);
+    db_wire_put_i32(request, amount);
+    return client_published(client_finish(client, SQLITE_IOERR), "FoodBatch", DB_CHANGE_UPDATE, batch_id);
+}
+
+int db_client_foodbatch_delete_by_id(struct db_client *client, int batch_id) {
+    db_wire_put_i32(client_begin(client, DB_OP_FOODBATCH_DELETE), batch_id);
+    return client_published(client_finish(client, SQLITE_IOERR), "FoodBatch", DB_CHANGE_DELETE, batch_id);
+}
+
+bool db_client_foodbatch_check_batchid_exists(struct db_client *client, int batch_id) {
+    db_wire_put_i32(client_begin(client, DB_OP_FOODBATCH_EXISTS), batch_id);
+    return client_finish(client, false) != 0;
+}
+
+int db_client_foodbatch_get_by_batchid(struct db_client *client, int batch_id, struct foodbatch *foodbatch) {
+    db_wire_put_i32(client_begin(client, DB_OP_FOODBATCH_GET), batch_id);
+
+    int32_t result = SQLITE_IOERR;
+    if (client_call(client, &result) && result == SQLITE_OK) {
+        client_get_foodbatch(&client->values, foodbatch);
+        result = client_check(client, result, SQLITE_IOERR);
+    }
+    client_end(client);
+    return result;
+}
+
+/**
+ * @internal
+ * @brief Fetches a paged food batch query page after page, passing each batch to the callback
+ *
+ * @return Number of batches passed to the callback, or -1 on failure
+ */
+static int client_foodbatch_pages(
+    struct db_client *client,
+    enum db_op op,
+    int32_t from_day,
+    int32_t to_day,
+    foodbatch_callback callback,
+    void *ctx
+) {
+    if (!callback) {
+        fprintf(stderr, "Invalid callback provided.\n");
+        return -1;
+    }
+
+    int found = 0;
+    for (;;) {
+        void *items;
+        bool more;
+        int count = client_page(
+            client,
+            op,
+            from_day,
+            to_day,
+            (uint32_t)found,
+            sizeof(struct foodbatch),
+            client_get_foodbatch,
+            &items,
+            &more
+        );
+        if (count < 0) {
+            return -1;
+        }
+
+        const struct foodbatch *batches = items;
+        bool stop = false;
+        for (int i = 0; i < count && !stop; i++) {
+            found++;
+            stop = callback(ctx, &batches[i]) != 0;
+        }
+        free(items);
+        if (stop || !more) {
+            return found;
+        }
+    }
+}
+
+int db_client_foodbatch_expiring_between(
+    struct db_client *client,
+    int32_t from_day,
+    int32_t to_day,
+    foodbatch_callback callback,
+    void *ctx
+) {
+    return client_foodbatch_pages(client, DB_OP_FOODBATCH_EXPIRING_BETWEEN, from_day, to_day, callback, ctx);
+}
+
+int db_client_foodbatch_in_stock(struct db_client *client, foodbatch_callback callback, void *ctx) {
+    return client_foodbatch_pages(client, DB_OP_FOODBATCH_IN_STOCK, 0, 0, callback, ctx);
+}
+
+int db_client_foodbatch_get_count(struct db_client *client) {
+    client_begin(client, DB_OP_FOODBATCH_COUNT);
+    return client_finish(client, -1);
+}
+
+int db_client_foodbatch_get_all_format(struct db_client *client, char *buffer, size_t buffer_size) {
+    client_begin(client, DB_OP_FOODBATCH_FORMAT_ALL);
+    return client_format(client, buffer, buffer_size);
+}
+
+int db_client_foodbatch_get_format_by_batchid(struct db_client *client, int batch_id, char *buffer, size_t buffer_size) {
+    db_wire_put_i32(client_begin(client, DB_OP_FOODBATCH_FORMAT_ONE), batch_id);
+    return client_format(client, buffer, buffer_size);
+}
+
+int db_client_foodbatch_get_all(struct db_client *client) {
+    return client_print(client, DB_OP_FOODBATCH_FORMAT_ALL);
+}
+
+int db_client_food_plan_apply(struct db_client *client, const struct food_plan *plan) {
+    struct db_wire *request = client_begin(client, DB_OP_FOODBATCH_APPLY_PLAN);
+    db_wire_put_u32(request, (uint32_t)plan->pick_count);
+    for (int i = 0; i < plan->pick_count; i++) {
+        db_wire_put_i32(request, plan->picks[i].batch_id);
+        db_wire_put_i32(request, plan->picks[i].quantity);
+    }
+
+    int32_t result = client_finish(client, SQLITE_IOERR);
+    for (int i = 0; i < plan->pick_count; i++) {
+        client_published(result, "FoodBatch", DB_CHANGE_UPDATE, plan->picks[i].batch_id);
+    }
+    return result;
+}
+
+/* ======================= USERS ======================= */
+
+int db_client_user_create_user(
+    struct db_client *client,
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    bool is_admin
+) {
+    struct db_wire *request = client_begin(client, DB_OP_USER_CREATE);
+    db_wire_put_str(request, username);
+    db_wire_put_str(request, cpf);
+    db_wire_put_str(request, phone_number);
+    db_wire_put_u8(request, is_admin);
+    return client_finish(client, SQLITE_IOERR);
+}
+
+int db_client_user_delete(struct db_client *client, const char *username) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_DELETE), username);
+    return client_finish(client, SQLITE_IOERR);
+}
+
+/**
+ * @internal
+ * @brief Calls an operation taking two strings
+ */
+static int32_t client_two_strings(
+    struct db_client *client,
+    enum db_op op,
+    const char *a,
+    const char *b,
+    int32_t fallback
+) {
+    struct db_wire *request = client_begin(client, op);
+    db_wire_put_str(request, a);
+    db_wire_put_str(request, b);
+    return client_finish(client, fallback);
+}
+
+int db_client_user_update_phone_number(struct db_client *client, const char *username, const char *phone_number) {
+    return client_two_strings(client, DB_OP_USER_SET_PHONE, username, phone_number, SQLITE_IOERR);
+}
+
+int db_client_user_update_cpf(struct db_client *client, const char *username, const char *cpf) {
+    return client_two_strings(client, DB_OP_USER_SET_CPF, username, cpf, SQLITE_IOERR);
+}
+
+int db_client_user_update_password(struct db_client *client, const char *username, const char *new_password) {
+    return client_two_strings(client, DB_OP_USER_SET_PASSWORD, username, new_password, SQLITE_IOERR);
+}
+
+int db_client_user_update_admin_status(struct db_client *client, const char *username, bool is_admin) {
+    struct db_wire *request = client_begin(client, DB_OP_USER_SET_ADMIN);
+    db_wire_put_str(request, username);
+    db_wire_put_u8(request, is_admin);
+    return client_finish(client, SQLITE_IOERR);
+}
+
+int db_client_user_update_username(struct db_client *client, const char *old_username, const char *new_username) {
+    return client_two_strings(client, DB_OP_USER_SET_USERNAME, old_username, new_username, SQLITE_IOERR);
+}
+
+int db_client_user_set_reset_password(struct db_client *client, const char *username) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_RESET_PASSWORD), username);
+    return client_finish(client, SQLITE_IOERR);
+}
+
+bool db_client_user_check_cpf_exists(struct db_client *client, const char *cpf) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_CPF_EXISTS), cpf);
+    return client_finish(client, false) != 0;
+}
+
+bool db_client_user_check_exists(struct db_client *client, const char *username) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_EXISTS), username);
+    return client_finish(client, false) != 0;
+}
+
+bool db_client_user_check_admin_status(struct db_client *client, const char *username) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_IS_ADMIN), username);
+    return client_finish(client, false) != 0;
+}
+
+int db_client_user_get_by_username(struct db_client *client, const char *username, struct user *user_out) {
+    db_wire_put_str(client_begin(client, DB_OP_USER_GET), username);
+
+    int32_t result = SQLITE_IOERR;
+    if (client_call(client, &result) && result == SQLITE_OK) {
+        // The password hash stays on the server
+        memset(user_out, 0, sizeof(*user_out));
+        struct db_wire_reader *values = &client->values;
+        db_wire_get_str(values, user_out->username, sizeof(user_out->username));
+        db_wire_get_str(values, user_out->cpf, sizeof(user_out->cpf));
+        db_wire_get_str(values, user_out->phone_number, sizeof(user_out->phone_number));
+        user_out->is_admin = db_wire_get_u8(values) != 0;
+        user_out->reset_password = db_wire_get_u8(values) != 0;
+        user_out->created_at = (time_t)db_wire_get_i64(values);
+        user_out->last_login = (time_t)db_wire_get_i64(values);
+        result = client_check(client, result, SQLITE_IOERR);
+    }
+    client_end(client);
+    return result;
+}
+
+int db_client_user_get_count(struct db_client *client) {
+    client_begin(client, DB_OP_USER_COUNT);
+    return client_finish(client, -1);
+}
+
+int db_client_user_get_all_format(struct db_client *client, char *buffer, size_t buffer_size) {
+    client_begin(client, DB_OP_USER_FORMAT_ALL);
+    return client_format(client, buffer, buffer_size);
+}
+
+int db_client_user_get_all(struct db_client *client) {
+    return client_print(client, DB_OP_USER_FORMAT_ALL);
+}
+
+enum auth_result db_client_user_authenticate(struct db_client *client, const char *username, const char *password) {
+    return (enum auth_result)client_two_strings(client, DB_OP_USER_AUTHENTICATE, username, password, AUTH_FAILURE);
+}
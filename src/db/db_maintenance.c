@@ -0,0 +1,510 @@
+/**
+ * @file db_maintenance.c
+ * @brief Idle-time database maintenance implementation
+ */
+#include "db/db_maintenance.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/utils_perf.h"
+
+static const char *const maintenance_task_names[DB_MAINTENANCE_TASKS] = {
+    "optimize",
+    "incremental vacuum",
+    "checkpoint",
+};
+
+/**
+ * @internal
+ * @brief A registered database
+ */
+struct maintenance_source {
+    database *db;                       ///< Connection the tasks run on
+    char name[DB_MAINTENANCE_NAME_LEN]; ///< Name used in the log
+};
+
+struct db_maintenance {
+    struct db_maintenance_config config; ///< Config with the defaults filled in
+
+    struct maintenance_source sources[DB_MAINTENANCE_MAX_DATABASES]; ///< Registered databases
+    int count;                                                       ///< Registered databases
+
+    // Where the pass resumes, written by the thread while it runs, by the main thread otherwise
+    int next_db;         ///< Database of the next task
+    int next_task;       ///< Next task on it
+    bool pass_completed; ///< The thread finished a pass, not yet seen by db_maintenance_tick()
+
+    // Main thread only
+    bool ticked;           ///< db_maintenance_tick() was called before
+    int64_t last_input_ns; ///< Time of the last input
+    bool passed;           ///< A pass completed since creation
+    int64_t last_pass_ns;  ///< Time the last complete pass was seen
+
+    pthread_t thread;    ///< Maintenance thread, valid while joinable
+    bool joinable;       ///< Thread started and not joined yet, main thread only
+    atomic_bool running; ///< Thread still working
+    atomic_bool abort;   ///< Makes the progress handler interrupt the running statement
+
+    pthread_mutex_t lock;              ///< Guards stats
+    struct db_maintenance_stats stats; ///< Totals
+    int rc;                            ///< Result of the last pass, read after the join
+};
+
+/* ======================= TASKS ======================= */
+
+/**
+ * @internal
+ * @brief Progress handler, interrupts the statement once an input asked for it
+ */
+static int maintenance_progress(void *arg) {
+    struct db_maintenance *maintenance = arg;
+    return atomic_load_explicit(&maintenance->abort, memory_order_relaxed) ? 1 : 0;
+}
+
+/**
+ * @internal
+ * @brief Runs a statement that can be aborted, with the progress handler on its connection
+ */
+static int maintenance_exec(struct db_maintenance *maintenance, sqlite3 *db, const char *sql) {
+    sqlite3_progress_handler(db, DB_MAINTENANCE_PROGRESS_OPS, maintenance_progress, maintenance);
+    int rc = sqlite3_exec(db, sql, 0, 0, 0);
+    sqlite3_progress_handler(db, 0, NULL, NULL);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Reads the integer a PRAGMA returns
+ */
+static int maintenance_pragma_int(sqlite3 *db, const char *sql, int64_t *value) {
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *value = sqlite3_column_int64(stmt, 0);
+        rc = SQLITE_OK;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Analyzes, one by one, the tables PRAGMA optimize would analyze
+ */
+static int maintenance_optimize(struct db_maintenance *maintenance, sqlite3 *db, int64_t *tables) {
+    // Debug mode (0x01) lists the ANALYZE statements instead of running them, 0x10000 looks at
+    // every table and not only the ones queried through this connection
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, "PRAGMA optimize(0x10003);", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    char **statements = NULL;
+    int count = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        char **grown = realloc(statements, sizeof(char *) * (count + 1));
+        char *sql = grown ? sqlite3_mprintf("%s;", (const char *)sqlite3_column_text(stmt, 0)) : NULL;
+        if (grown) {
+            statements = grown;
+        }
+        if (!sql) {
+            rc = SQLITE_NOMEM;
+            break;
+        }
+        statements[count++] = sql;
+    }
+    sqlite3_finalize(stmt);
+    rc = rc == SQLITE_DONE ? SQLITE_OK : rc;
+
+    if (rc == SQLITE_OK && count > 0) {
+        char limit[64];
+        snprintf(limit, sizeof(limit), "PRAGMA analysis_limit = %d;", maintenance->config.analysis_limit);
+        rc = sqlite3_exec(db, limit, 0, 0, 0);
+
+        for (int i = 0; i < count && rc == SQLITE_OK; i++) {
+            rc = maintenance_exec(maintenance, db, statements[i]);
+            if (rc == SQLITE_OK) {
+                (*tables)++;
+            }
+        }
+        sqlite3_exec(db, "PRAGMA analysis_limit = 0;", 0, 0, 0);
+    }
+
+    for (int i = 0; i < count; i++) {
+        sqlite3_free(statements[i]);
+    }
+    free(statements);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Turns a database created without auto_vacuum over to incremental with a VACUUM
+ *
+ * The pragma alone does nothing on a file that has tables, the VACUUM rebuilding it applies it.
+ * Done once, an aborted VACUUM rolls back and runs again at the next idle period.
+ *
+ * @param[out] pages Pages the VACUUM gave back
+ */
+static int maintenance_convert(struct db_maintenance *maintenance, sqlite3 *db, int64_t *pages) {
+    int64_t before = 0;
+    int rc = maintenance_pragma_int(db, "PRAGMA page_count;", &before);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db, "PRAGMA auto_vacuum = INCREMENTAL;", 0, 0, 0);
+    }
+    if (rc == SQLITE_OK) {
+        rc = maintenance_exec(maintenance, db, "VACUUM;");
+    }
+
+    int64_t after = before;
+    if (rc == SQLITE_OK && maintenance_pragma_int(db, "PRAGMA page_count;", &after) == SQLITE_OK) {
+        *pages = before > after ? before - after : 0;
+    }
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Frees the free pages a slice at a time, on auto_vacuum = INCREMENTAL databases
+ *
+ * Databases without auto_vacuum (created before it was set) are converted first.
+ *
+ * @param[out] pages Pages given back, -1 if the database is not incremental (auto_vacuum = FULL)
+ * @param[out] converted Whether the database was converted
+ */
+static int maintenance_vacuum(struct db_maintenance *maintenance, sqlite3 *db, int64_t *pages, bool *converted) {
+    int64_t mode = 0;
+    int rc = maintenance_pragma_int(db, "PRAGMA auto_vacuum;", &mode);
+    if (rc == SQLITE_OK && mode == 0) {
+        rc = maintenance_convert(maintenance, db, pages);
+        *converted = rc == SQLITE_OK;
+        return rc;
+    }
+    if (rc != SQLITE_OK || mode != 2) {
+        *pages = -1;
+        return rc;
+    }
+
+    int64_t before = 0;
+    rc = maintenance_pragma_int(db, "PRAGMA freelist_count;", &before);
+
+    char slice[64];
+    snprintf(slice, sizeof(slice), "PRAGMA incremental_vacuum(%d);", maintenance->config.vacuum_pages);
+
+    int64_t free_pages = before;
+    while (rc == SQLITE_OK && free_pages > 0) {
+        if (atomic_load(&maintenance->abort)) {
+            rc = SQLITE_INTERRUPT;
+            break;
+        }
+        int64_t previous = free_pages;
+        rc = maintenance_exec(maintenance, db, slice);
+        if (rc == SQLITE_OK) {
+            rc = maintenance_pragma_int(db, "PRAGMA freelist_count;", &free_pages);
+        }
+        if (free_pages >= previous) {
+            break; // Nothing more it can give back
+        }
+    }
+
+    int64_t after = before;
+    if (maintenance_pragma_int(db, "PRAGMA freelist_count;", &after) == SQLITE_OK) {
+        *pages = before - after;
+    }
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Passive checkpoint of a WAL database, never waits on readers or writers
+ *
+ * @param[out] frames Frames copied back, -1 if the database is not in WAL mode
+ */
+static int maintenance_checkpoint(sqlite3 *db, int64_t *frames) {
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, "PRAGMA journal_mode;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    bool wal = sqlite3_step(stmt) == SQLITE_ROW
+        && sqlite3_stricmp((const char *)sqlite3_column_text(stmt, 0), "wal") == 0;
+    sqlite3_finalize(stmt);
+
+    if (!wal) {
+        *frames = -1;
+        return SQLITE_OK;
+    }
+
+    int log = 0;
+    int checkpointed = 0;
+    rc = sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_PASSIVE, &log, &checkpointed);
+    *frames = checkpointed > 0 ? checkpointed : 0;
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Runs one task, adds it to the totals and logs it
+ */
+static int maintenance_task(struct db_maintenance *maintenance, const struct maintenance_source *source, int task) {
+    sqlite3 *db = source->db->db;
+    int64_t result = 0;
+    bool converted = false;
+    int64_t start = (int64_t)perf_now_ns();
+
+    int rc;
+    switch (task) {
+    case DB_MAINTENANCE_OPTIMIZE:
+        rc = maintenance_optimize(maintenance, db, &result);
+        break;
+    case DB_MAINTENANCE_VACUUM:
+        rc = maintenance_vacuum(maintenance, db, &result, &converted);
+        break;
+    default:
+        rc = maintenance_checkpoint(db, &result);
+        break;
+    }
+
+    int64_t elapsed = (int64_t)perf_now_ns() - start;
+    double ms = (double)elapsed / 1e6;
+
+    pthread_mutex_lock(&maintenance->lock);
+    maintenance->stats.task_ns[task] += (uint64_t)elapsed;
+    if (rc == SQLITE_INTERRUPT) {
+        maintenance->stats.aborts++;
+    }
+    if (task == DB_MAINTENANCE_OPTIMIZE) {
+        maintenance->stats.tables_analyzed += (uint64_t)result;
+    } else if (task == DB_MAINTENANCE_VACUUM && result > 0) {
+        maintenance->stats.pages_reclaimed += result;
+    }
+    if (converted) {
+        maintenance->stats.databases_converted++;
+    } else if (task == DB_MAINTENANCE_CHECKPOINT && result > 0) {
+        maintenance->stats.frames_checkpointed += result;
+    }
+    pthread_mutex_unlock(&maintenance->lock);
+
+    static const char *const units[DB_MAINTENANCE_TASKS] = {
+        "tables analyzed",
+        "pages reclaimed",
+        "frames checkpointed",
+    };
+    const char *what = converted ? "conversion to incremental auto_vacuum" : maintenance_task_names[task];
+    if (rc != SQLITE_OK && rc != SQLITE_INTERRUPT) {
+        fprintf(stderr, "Maintenance %s: %s failed: %s\n", source->name, what, sqlite3_errstr(rc));
+    } else if (result < 0) {
+        printf(
+            "Maintenance %s: %s skipped, %s\n",
+            source->name,
+            what,
+            task == DB_MAINTENANCE_VACUUM ? "auto_vacuum is not incremental" : "not in WAL mode"
+        );
+    } else {
+        printf(
+            "Maintenance %s: %s %s %.1f ms, %s: %lld\n",
+            source->name,
+            what,
+            rc == SQLITE_INTERRUPT ? "aborted by input after" : "took",
+            ms,
+            units[task],
+            (long long)result
+        );
+    }
+    return rc;
+}
+
+/* ======================= BACKGROUND THREAD ======================= */
+
+/**
+ * @internal
+ * @brief Runs the pass from where the last one stopped, until done or aborted
+ */
+static void *maintenance_thread(void *arg) {
+    struct db_maintenance *maintenance = arg;
+
+    int rc = SQLITE_OK;
+    while (maintenance->next_db < maintenance->count) {
+        const struct maintenance_source *source = &maintenance->sources[maintenance->next_db];
+        while (maintenance->next_task < DB_MAINTENANCE_TASKS) {
+            if (atomic_load(&maintenance->abort)) {
+                maintenance->rc = SQLITE_INTERRUPT;
+                atomic_store(&maintenance->running, false);
+                return NULL;
+            }
+
+            int task_rc = maintenance_task(maintenance, source, maintenance->next_task);
+            if (task_rc == SQLITE_INTERRUPT) {
+                // Resumes at this task
+                maintenance->rc = SQLITE_INTERRUPT;
+                atomic_store(&maintenance->running, false);
+                return NULL;
+            }
+            if (task_rc != SQLITE_OK && rc == SQLITE_OK) {
+                rc = task_rc; // Logged, the other tasks still run
+            }
+            maintenance->next_task++;
+        }
+        maintenance->next_task = 0;
+        maintenance->next_db++;
+    }
+
+    maintenance->next_db = 0;
+    maintenance->pass_completed = true;
+    maintenance->rc = rc;
+
+    pthread_mutex_lock(&maintenance->lock);
+    maintenance->stats.passes++;
+    pthread_mutex_unlock(&maintenance->lock);
+
+    atomic_store(&maintenance->running, false);
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Joins a thread that was started, main thread only
+ */
+static void maintenance_join(struct db_maintenance *maintenance) {
+    if (maintenance->joinable) {
+        pthread_join(maintenance->thread, NULL);
+        maintenance->joinable = false;
+    }
+}
+
+/* ======================= PUBLIC FUNCTIONS ======================= */
+
+struct db_maintenance *db_maintenance_create(const struct db_maintenance_config *config) {
+    struct db_maintenance *maintenance = calloc(1, sizeof(*maintenance));
+    if (!maintenance) {
+        fprintf(stderr, "Failed to allocate maintenance scheduler.\n");
+        return NULL;
+    }
+    if (pthread_mutex_init(&maintenance->lock, NULL) != 0) {
+        free(maintenance);
+        return NULL;
+    }
+
+    if (config) {
+        maintenance->config = *config;
+    }
+    if (maintenance->config.idle_ns <= 0) {
+        maintenance->config.idle_ns = DB_MAINTENANCE_IDLE_NS;
+    }
+    if (maintenance->config.interval_ns <= 0) {
+        maintenance->config.interval_ns = DB_MAINTENANCE_INTERVAL_NS;
+    }
+    if (maintenance->config.vacuum_pages <= 0) {
+        maintenance->config.vacuum_pages = DB_MAINTENANCE_VACUUM_PAGES;
+    }
+    if (maintenance->config.analysis_limit <= 0) {
+        maintenance->config.analysis_limit = DB_MAINTENANCE_ANALYSIS_LIMIT;
+    }
+
+    atomic_init(&maintenance->running, false);
+    atomic_init(&maintenance->abort, false);
+    maintenance->rc = SQLITE_OK;
+    return maintenance;
+}
+
+int db_maintenance_add(struct db_maintenance *maintenance, database *db, const char *name) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_MISUSE;
+    }
+    if (atomic_load(&maintenance->running)) {
+        return SQLITE_BUSY;
+    }
+    if (maintenance->count == DB_MAINTENANCE_MAX_DATABASES) {
+        return SQLITE_FULL;
+    }
+
+    struct maintenance_source *source = &maintenance->sources[maintenance->count++];
+    source->db = db;
+    snprintf(source->name, sizeof(source->name), "%s", name);
+    return SQLITE_OK;
+}
+
+void db_maintenance_tick(struct db_maintenance *maintenance, bool input, int64_t now_ns) {
+    if (!maintenance) {
+        return;
+    }
+    if (!maintenance->ticked) {
+        maintenance->ticked = true;
+        maintenance->last_input_ns = now_ns; // Idle from the first frame on
+    }
+
+    if (input) {
+        maintenance->last_input_ns = now_ns;
+        if (maintenance->joinable) {
+            // The progress handler interrupts the statement within DB_MAINTENANCE_PROGRESS_OPS
+            atomic_store(&maintenance->abort, true);
+            maintenance_join(maintenance);
+        }
+    }
+
+    if (atomic_load(&maintenance->running)) {
+        return;
+    }
+    maintenance_join(maintenance);
+
+    if (maintenance->pass_completed) {
+        maintenance->pass_completed = false;
+        maintenance->passed = true;
+        maintenance->last_pass_ns = now_ns;
+    }
+
+    if (input || now_ns - maintenance->last_input_ns < maintenance->config.idle_ns) {
+        return;
+    }
+
+    // An aborted pass resumes as soon as the user is idle again, a complete one waits an interval
+    bool resuming = maintenance->next_db != 0 || maintenance->next_task != 0;
+    if (!resuming && maintenance->passed && now_ns - maintenance->last_pass_ns < maintenance->config.interval_ns) {
+        return;
+    }
+
+    atomic_store(&maintenance->abort, false);
+    atomic_store(&maintenance->running, true);
+    if (pthread_create(&maintenance->thread, NULL, maintenance_thread, maintenance) != 0) {
+        atomic_store(&maintenance->running, false);
+        fprintf(stderr, "Failed to start the maintenance thread.\n");
+        maintenance->last_input_ns = now_ns; // Try again after another idle period
+        return;
+    }
+    maintenance->joinable = true;
+}
+
+bool db_maintenance_running(struct db_maintenance *maintenance) {
+    return atomic_load(&maintenance->running);
+}
+
+int db_maintenance_wait(struct db_maintenance *maintenance) {
+    maintenance_join(maintenance);
+    return maintenance->rc;
+}
+
+void db_maintenance_get_stats(struct db_maintenance *maintenance, struct db_maintenance_stats *stats) {
+    pthread_mutex_lock(&maintenance->lock);
+    *stats = maintenance->stats;
+    pthread_mutex_unlock(&maintenance->lock);
+}
+
+void db_maintenance_free(struct db_maintenance *maintenance) {
+    if (!maintenance) {
+        return;
+    }
+    atomic_store(&maintenance->abort, true);
+    maintenance_join(maintenance);
+    pthread_mutex_destroy(&maintenance->lock);
+    free(maintenance);
+}
@@ -4,19 +4,32 @@
  */
 #include "db/db_manager.h"
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "db/db_changes.h"
+#include "db/db_profile.h"
 #include "global/error_handling.h"
+#include "utils/utils_date.h"
+
+static void db_pool_close(database *db);
 
 int db_init(database *db, const char *filename) {
+    db->pool = NULL;
+    db->changes = NULL;
+    db->remote = NULL;
     int rc = sqlite3_open(filename, &db->db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(db->db));
         return rc;
     }
 
+    db_profile_attach(db->db);
+    db->changes = db_changes_attach(db->db);
+
     return SQLITE_OK;
 }
 
@@ -26,6 +39,12 @@ int db_init_with_tbl(database *db, const char *filename, int (*create_table)(dat
         return ERROR_OPENING_DB;
     }
 
+    // Lets idle-time maintenance give free pages back a few at a time (db_maintenance.h), only
+    // takes effect on a file that has no tables yet, the maintenance converts older files
+    if (sqlite3_exec(db->db, "PRAGMA auto_vacuum = INCREMENTAL;", 0, 0, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to set incremental auto_vacuum on %s.\n", filename);
+    }
+
     if (create_table(db) != SQLITE_OK) {
         fprintf(stderr, "Error creating table in database %s.\n", filename);
         db_deinit(db);
@@ -42,9 +61,287 @@ bool db_is_init(database *db) {
     return true;
 }
 
+bool db_is_remote(database *db) {
+    return db && db->remote;
+}
+
 void db_deinit(database *db) {
+    db->remote = NULL;
+    db_pool_close(db);
     if (db->db) {
+        db_changes_detach(db->db, db->changes);
+        db->changes = NULL;
         sqlite3_close(db->db);
         db->db = NULL; // setting pointer to null to prevent accidental reuse
     }
 }
+
+bool db_table_has_column(database *db, const char *table, const char *column, const char *type) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return false;
+    }
+
+    const char *sql = "SELECT 1 FROM pragma_table_info(?) WHERE name = ? AND (?3 IS NULL OR type = ?3);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+    if (type) {
+        sqlite3_bind_text(stmt, 3, type, -1, SQLITE_STATIC);
+    }
+
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int db_rebuild_table(
+    database *db,
+    const char *table,
+    const char *create_sql,
+    const char *columns,
+    const char *select_list
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    // Indexes and triggers of the old table are dropped with it, create_sql runs on a free name
+    char *sql = sqlite3_mprintf(
+        "BEGIN;"
+        "ALTER TABLE \"%w\" RENAME TO \"%w_rebuild\";"
+        "%s"
+        "INSERT INTO \"%w\" (%s) SELECT %s FROM \"%w_rebuild\";"
+        "DROP TABLE \"%w_rebuild\";"
+        "COMMIT;",
+        table,
+        table,
+        create_sql,
+        table,
+        columns,
+        select_list,
+        table,
+        table
+    );
+    if (!sql) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return SQLITE_NOMEM;
+    }
+
+    char *errMsg = 0;
+    int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    sqlite3_free(sql);
+
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on rebuilding table %s: %s\n", table, errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        return rc;
+    }
+
+    return SQLITE_OK;
+}
+
+int32_t db_column_day(sqlite3_stmt *stmt, int col) {
+    if (sqlite3_column_type(stmt, col) == SQLITE_NULL) {
+        return DATE_INVALID;
+    }
+    return sqlite3_column_int(stmt, col);
+}
+
+int db_bind_day(sqlite3_stmt *stmt, int index, int32_t day) {
+    if (day == DATE_INVALID) {
+        return sqlite3_bind_null(stmt, index);
+    }
+    return sqlite3_bind_int(stmt, index, day);
+}
+
+/* ======================= POOL ======================= */
+
+/**
+ * @internal
+ * @brief One read-only connection and who used it last
+ */
+struct db_pool_reader {
+    sqlite3 *conn;
+    bool in_use;
+    bool has_owner;
+    pthread_t owner; ///< Thread that checked it out last, valid if has_owner
+};
+
+struct db_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t returned; ///< Signaled when a reader is given back
+    int count;
+    struct db_pool_reader readers[DB_POOL_MAX_READERS];
+};
+
+/**
+ * @internal
+ * @brief Closes the readers and frees the pool
+ */
+static void db_pool_close(database *db) {
+    struct db_pool *pool = db->pool;
+    if (!pool) {
+        return;
+    }
+    for (int i = 0; i < pool->count; i++) {
+        sqlite3_close(pool->readers[i].conn);
+    }
+    pthread_cond_destroy(&pool->returned);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+    db->pool = NULL;
+
+    // A writer that never opened the WAL itself leaves it behind on close, checkpointing opens it
+    if (db->db) {
+        sqlite3_wal_checkpoint_v2(db->db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+    }
+}
+
+int db_pool_open(database *db, int readers) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+    if (db->pool || readers < 1 || readers > DB_POOL_MAX_READERS) {
+        fprintf(stderr, "A pool takes 1 to %d readers, once.\n", DB_POOL_MAX_READERS);
+        return SQLITE_MISUSE;
+    }
+
+    const char *filename = sqlite3_db_filename(db->db, "main");
+    if (!filename || filename[0] == '\0') {
+        fprintf(stderr, "Connection pool needs a file backed database.\n");
+        return SQLITE_MISUSE;
+    }
+
+    // Replies with the mode in effect, which stays "delete" when WAL is not possible
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, "PRAGMA journal_mode = WAL;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+    rc = sqlite3_step(stmt);
+    bool wal = rc == SQLITE_ROW && strcmp((const char *)sqlite3_column_text(stmt, 0), "wal") == 0;
+    sqlite3_finalize(stmt);
+    if (!wal) {
+        fprintf(stderr, "Failed to switch %s to WAL: %s\n", filename, sqlite3_errmsg(db->db));
+        return rc == SQLITE_ROW ? SQLITE_ERROR : rc;
+    }
+
+    struct db_pool *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return SQLITE_NOMEM;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->returned, NULL);
+    db->pool = pool;
+
+    for (; pool->count < readers; pool->count++) {
+        sqlite3 **conn = &pool->readers[pool->count].conn;
+        rc = sqlite3_open_v2(filename, conn, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Can't open pooled reader: %s\n", sqlite3_errmsg(*conn));
+            sqlite3_close(*conn);
+            db_pool_close(db);
+            return rc;
+        }
+        sqlite3_busy_timeout(*conn, DB_POOL_BUSY_TIMEOUT_MS);
+        db_profile_attach(*conn);
+    }
+
+    return SQLITE_OK;
+}
+
+int db_pool_acquire(database *db, database *reader) {
+    reader->db = NULL;
+    reader->pool = NULL;
+    reader->changes = NULL;
+    reader->remote = NULL;
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct db_pool *pool = db->pool;
+    if (!pool) {
+        reader->db = db->db;
+        return SQLITE_OK;
+    }
+
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        // The reader this thread used last, else any free one, else wait
+        int pick = -1;
+        bool nested = false;
+        for (int i = 0; i < pool->count; i++) {
+            struct db_pool_reader *r = &pool->readers[i];
+            if (r->in_use) {
+                nested = nested || pthread_equal(r->owner, self);
+                continue;
+            }
+            if (r->has_owner && pthread_equal(r->owner, self)) {
+                pick = i;
+                break;
+            }
+            if (pick < 0) {
+                pick = i;
+            }
+        }
+        if (pick < 0 && nested) {
+            reader->db = db->db; // Waiting would wait on this thread
+            break;
+        }
+        if (pick >= 0) {
+            struct db_pool_reader *r = &pool->readers[pick];
+            r->in_use = true;
+            r->has_owner = true;
+            r->owner = self;
+            reader->db = r->conn;
+            break;
+        }
+        pthread_cond_wait(&pool->returned, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return SQLITE_OK;
+}
+
+void db_pool_release(database *db, database *reader) {
+    struct db_pool *pool = db->pool;
+    if (pool && reader->db && reader->db != db->db) {
+        pthread_mutex_lock(&pool->lock);
+        for (int i = 0; i < pool->count; i++) {
+            if (pool->readers[i].conn == reader->db) {
+                pool->readers[i].in_use = false;
+                pthread_cond_signal(&pool->returned);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    reader->db = NULL;
+    reader->pool = NULL;
+    reader->changes = NULL;
+    reader->remote = NULL;
+}
+
+database db_writer(database *db) {
+    database writer = *db;
+    writer.pool = NULL;
+    return writer;
+}
+
+int db_pool_readers(database *db) {
+    return db->pool ? db->pool->count : 0;
+}
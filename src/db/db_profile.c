@@ -0,0 +1,411 @@
+/**
+ * @file db_profile.c
+ * @brief Per-statement SQL latency profiling implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For clock_gettime
+
+#include "db/db_profile.h"
+
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PROFILE_MAX_PROBES 32 // Slots looked at before a statement is dropped
+#define PROFILE_RUNNING 16    // Statements timed at once per thread, more fall back to SQLite's own time
+
+struct profile_entry {
+    _Atomic uint64_t hash; // Normalized SQL hash, 0 while the slot is free
+    atomic_bool ready;     // sql is written
+    char sql[DB_PROFILE_SQL_LEN];
+    _Atomic uint64_t total_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t histogram[DB_PROFILE_BUCKETS]; // Calls are the sum of the buckets
+};
+
+// Open addressing on the hash, slots are claimed once and never freed
+static struct profile_entry profile_entries[DB_PROFILE_MAX_STATEMENTS];
+
+// Statements started and not finished yet on this thread, timed from SQLITE_TRACE_STMT to
+// SQLITE_TRACE_PROFILE
+struct profile_running {
+    sqlite3_stmt *stmt;
+    uint64_t start_ns;
+};
+static _Thread_local struct profile_running profile_running[PROFILE_RUNNING];
+static _Atomic uint64_t profile_dropped = 0;
+static atomic_bool profile_enabled = false;
+static atomic_bool profile_tracking = false; // Time spent in statements only, see db_profile_track_time()
+static _Thread_local uint64_t profile_thread_ns = 0;
+static char profile_dump_path[1024];
+
+/* ======================= NORMALIZATION ======================= */
+
+struct normalizer {
+    uint64_t hash; // FNV-1a of everything emitted
+    char *out;
+    size_t out_size;
+    size_t len;
+};
+
+static void emit(struct normalizer *n, char c) {
+    n->hash = (n->hash ^ (unsigned char)c) * 1099511628211u;
+    if (n->out && n->len + 1 < n->out_size) {
+        n->out[n->len] = c;
+    }
+    n->len++;
+}
+
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+uint64_t db_profile_normalize(const char *sql, char *out, size_t out_size) {
+    struct normalizer n = { 14695981039346656037u, out, out_size, 0 };
+    bool pending_space = false;
+    char prev = '\0'; // Last character emitted
+
+    for (const char *p = sql ? sql : ""; *p;) {
+        if (isspace((unsigned char)*p)) {
+            pending_space = n.len > 0;
+            p++;
+            continue;
+        }
+        if (pending_space) {
+            emit(&n, ' ');
+            pending_space = false;
+            prev = ' ';
+        }
+
+        if (*p == '\'') {
+            // String literal, '' is an escaped quote inside it
+            p++;
+            while (*p && !(*p == '\'' && p[1] != '\'')) {
+                p += *p == '\'' ? 2 : 1;
+            }
+            p += *p == '\'';
+            emit(&n, '?');
+            prev = '?';
+        } else if (*p == '"') {
+            // Quoted identifier, kept as is
+            do {
+                emit(&n, *p++);
+            } while (*p && *p != '"');
+            if (*p) {
+                emit(&n, *p++);
+            }
+            prev = '"';
+        } else if (isdigit((unsigned char)*p) && !is_word_char(prev) && prev != '?' && prev != ':' && prev != '@') {
+            // Number literal, hex and exponents included
+            while (is_word_char(*p) || *p == '.'
+                   || ((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E'))) {
+                p++;
+            }
+            emit(&n, '?');
+            prev = '?';
+        } else {
+            emit(&n, *p);
+            prev = *p++;
+        }
+    }
+
+    if (out && out_size > 0) {
+        out[n.len < out_size ? n.len : out_size - 1] = '\0';
+    }
+    return n.hash != 0 ? n.hash : 1;
+}
+
+/* ======================= RECORDING ======================= */
+
+static int latency_bucket(uint64_t ns) {
+    if (ns < 4) {
+        return (int)ns;
+    }
+    int log2 = 63;
+    while (!(ns >> log2)) {
+        log2--;
+    }
+    int bucket = log2 * 4 + (int)((ns >> (log2 - 2)) & 3) - 4;
+    return bucket < DB_PROFILE_BUCKETS ? bucket : DB_PROFILE_BUCKETS - 1;
+}
+
+uint64_t db_profile_bucket_upper_ns(int bucket) {
+    if (bucket >= DB_PROFILE_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    if (bucket < 4) {
+        return (uint64_t)bucket;
+    }
+    int log2 = (bucket + 4) / 4;
+    uint64_t sub = (uint64_t)((bucket + 4) % 4);
+    return ((4 + sub + 1) << (log2 - 2)) - 1;
+}
+
+static struct profile_entry *find_entry(uint64_t hash, const char *sql) {
+    size_t slot = hash % DB_PROFILE_MAX_STATEMENTS;
+    for (int probe = 0; probe < PROFILE_MAX_PROBES; probe++) {
+        struct profile_entry *entry = &profile_entries[slot];
+        uint64_t current = atomic_load_explicit(&entry->hash, memory_order_acquire);
+        if (current == hash) {
+            return entry;
+        }
+
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong(&entry->hash, &expected, hash)) {
+                db_profile_normalize(sql, entry->sql, sizeof(entry->sql));
+                atomic_store_explicit(&entry->ready, true, memory_order_release);
+                return entry;
+            }
+            if (expected == hash) {
+                return entry; // Claimed by another thread for the same statement
+            }
+        }
+
+        slot = (slot + 1) % DB_PROFILE_MAX_STATEMENTS;
+    }
+    return NULL;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void run_started(sqlite3_stmt *stmt, const char *sql) {
+    if (sql[0] == '-' && sql[1] == '-') {
+        return; // A trigger of the statement already running
+    }
+
+    struct profile_running *free_slot = NULL;
+    for (int i = 0; i < PROFILE_RUNNING; i++) {
+        if (profile_running[i].stmt == stmt) {
+            free_slot = &profile_running[i];
+            break;
+        }
+        if (!free_slot && !profile_running[i].stmt) {
+            free_slot = &profile_running[i];
+        }
+    }
+    if (free_slot) {
+        free_slot->stmt = stmt;
+        free_slot->start_ns = monotonic_ns();
+    }
+}
+
+static uint64_t run_finished(sqlite3_stmt *stmt, uint64_t sqlite_ns) {
+    for (int i = 0; i < PROFILE_RUNNING; i++) {
+        if (profile_running[i].stmt == stmt) {
+            profile_running[i].stmt = NULL;
+            return monotonic_ns() - profile_running[i].start_ns;
+        }
+    }
+    return sqlite_ns;
+}
+
+static int profile_callback(unsigned type, void *ctx, void *p, void *x) {
+    (void)ctx;
+    if (type == SQLITE_TRACE_STMT) {
+        run_started((sqlite3_stmt *)p, (const char *)x);
+        return 0;
+    }
+
+    uint64_t ns = run_finished((sqlite3_stmt *)p, (uint64_t)*(sqlite3_int64 *)x);
+    profile_thread_ns += ns;
+    if (!atomic_load_explicit(&profile_enabled, memory_order_relaxed)) {
+        return 0;
+    }
+
+    const char *sql = sqlite3_sql((sqlite3_stmt *)p);
+    struct profile_entry *entry = find_entry(db_profile_normalize(sql, NULL, 0), sql);
+    if (!entry) {
+        atomic_fetch_add_explicit(&profile_dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    atomic_fetch_add_explicit(&entry->total_ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->histogram[latency_bucket(ns)], 1, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&entry->max_ns, memory_order_relaxed);
+    while (ns > max) {
+        if (atomic_compare_exchange_weak_explicit(
+                &entry->max_ns, &max, ns, memory_order_relaxed, memory_order_relaxed
+            )) {
+            break;
+        }
+    }
+    return 0;
+}
+
+void db_profile_enable(bool enabled) {
+    atomic_store(&profile_enabled, enabled);
+}
+
+bool db_profile_is_enabled(void) {
+    return atomic_load_explicit(&profile_enabled, memory_order_relaxed);
+}
+
+void db_profile_track_time(bool enabled) {
+    atomic_store(&profile_tracking, enabled);
+}
+
+uint64_t db_profile_thread_ns(void) {
+    return profile_thread_ns;
+}
+
+static void dump_at_exit(void) {
+    if (db_profile_dump(profile_dump_path) == 0) {
+        fprintf(stderr, "SQL profile written to %s.\n", profile_dump_path);
+    }
+}
+
+bool db_profile_enable_from_env(void) {
+    const char *path = getenv("DB_PROFILE");
+    if (!path || path[0] == '\0') {
+        return false;
+    }
+
+    bool registered = profile_dump_path[0] != '\0';
+    snprintf(profile_dump_path, sizeof(profile_dump_path), "%s", path);
+    if (!registered && atexit(dump_at_exit) != 0) {
+        fprintf(stderr, "Failed to register the SQL profile report.\n");
+    }
+    db_profile_enable(true);
+    return true;
+}
+
+void db_profile_attach(sqlite3 *db) {
+    if (db && (db_profile_is_enabled() || atomic_load(&profile_tracking))) {
+        sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, profile_callback, NULL);
+    }
+}
+
+/* ======================= REPORTING ======================= */
+
+uint64_t db_profile_dropped(void) {
+    return atomic_load(&profile_dropped);
+}
+
+// Upper bound of the bucket holding the given share of the calls
+static uint64_t histogram_percentile(const uint64_t *histogram, uint64_t calls, double share) {
+    uint64_t rank = (uint64_t)((double)calls * share);
+    rank = rank < 1 ? 1 : rank;
+    uint64_t seen = 0;
+    for (int b = 0; b < DB_PROFILE_BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen >= rank) {
+            return db_profile_bucket_upper_ns(b);
+        }
+    }
+    return 0;
+}
+
+static int compare_total_desc(const void *a, const void *b) {
+    uint64_t x = ((const struct db_profile_stat *)a)->total_ns;
+    uint64_t y = ((const struct db_profile_stat *)b)->total_ns;
+    return (x < y) - (x > y);
+}
+
+int db_profile_snapshot(struct db_profile_stat *stats, int max) {
+    int count = 0;
+    for (int i = 0; i < DB_PROFILE_MAX_STATEMENTS && count < max; i++) {
+        struct profile_entry *entry = &profile_entries[i];
+        if (!atomic_load_explicit(&entry->ready, memory_order_acquire)) {
+            continue;
+        }
+
+        struct db_profile_stat *stat = &stats[count];
+        memcpy(stat->sql, entry->sql, sizeof(stat->sql));
+        stat->calls = 0;
+        for (int b = 0; b < DB_PROFILE_BUCKETS; b++) {
+            stat->histogram[b] = atomic_load_explicit(&entry->histogram[b], memory_order_relaxed);
+            stat->calls += stat->histogram[b];
+        }
+        if (stat->calls == 0) {
+            continue;
+        }
+
+        stat->total_ns = atomic_load_explicit(&entry->total_ns, memory_order_relaxed);
+        stat->max_ns = atomic_load_explicit(&entry->max_ns, memory_order_relaxed);
+        stat->p50_ns = histogram_percentile(stat->histogram, stat->calls, 0.50);
+        stat->p95_ns = histogram_percentile(stat->histogram, stat->calls, 0.95);
+        stat->p99_ns = histogram_percentile(stat->histogram, stat->calls, 0.99);
+        count++;
+    }
+
+    qsort(stats, (size_t)count, sizeof(*stats), compare_total_desc);
+    return count;
+}
+
+void db_profile_reset(void) {
+    for (int i = 0; i < DB_PROFILE_MAX_STATEMENTS; i++) {
+        struct profile_entry *entry = &profile_entries[i];
+        atomic_store_explicit(&entry->total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&entry->max_ns, 0, memory_order_relaxed);
+        for (int b = 0; b < DB_PROFILE_BUCKETS; b++) {
+            atomic_store_explicit(&entry->histogram[b], 0, memory_order_relaxed);
+        }
+    }
+    atomic_store(&profile_dropped, 0);
+}
+
+int db_profile_dump(const char *path) {
+    struct db_profile_stat *stats = malloc(sizeof(*stats) * DB_PROFILE_MAX_STATEMENTS);
+    if (!stats) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return -1;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Can't write SQL profile %s.\n", path);
+        free(stats);
+        return -1;
+    }
+
+    int count = db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS);
+    fprintf(
+        file,
+        "%10s %12s %10s %10s %10s %10s %10s  %s\n",
+        "calls",
+        "total_ms",
+        "avg_us",
+        "p50_us",
+        "p95_us",
+        "p99_us",
+        "max_us",
+        "sql"
+    );
+    for (int i = 0; i < count; i++) {
+        const struct db_profile_stat *stat = &stats[i];
+        fprintf(
+            file,
+            "%10llu %12.3f %10.2f %10.2f %10.2f %10.2f %10.2f  %s\n",
+            (unsigned long long)stat->calls,
+            (double)stat->total_ns / 1e6,
+            (double)stat->total_ns / (double)stat->calls / 1e3,
+            (double)stat->p50_ns / 1e3,
+            (double)stat->p95_ns / 1e3,
+            (double)stat->p99_ns / 1e3,
+            (double)stat->max_ns / 1e3,
+            stat->sql
+        );
+    }
+
+    uint64_t dropped = db_profile_dropped();
+    if (dropped > 0) {
+        fprintf(
+            file,
+            "%llu runs not recorded, more than %d statements\n",
+            (unsigned long long)dropped,
+            DB_PROFILE_MAX_STATEMENTS
+        );
+    }
+
+    fclose(file);
+    free(stats);
+    return 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file db_protocol.c
+ * @brief Binary protocol between the database server and its clients implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For MSG_NOSIGNAL
+
+#include "db/db_protocol.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/types.h>
+#endif
+
+#define WIRE_FIRST_CAPACITY 256 // Bytes allocated for a frame the first time
+
+/* ======================= WRITING ======================= */
+
+/**
+ * @internal
+ * @brief Makes room for len more bytes
+ *
+ * @return Where to write them, NULL if the frame failed
+ */
+static uint8_t *wire_reserve(struct db_wire *wire, size_t len) {
+    if (wire->failed) {
+        return NULL;
+    }
+    if (wire->len + len > DB_PROTOCOL_MAX_FRAME) {
+        wire->failed = true;
+        return NULL;
+    }
+
+    if (wire->len + len > wire->capacity) {
+        size_t capacity = wire->capacity ? wire->capacity : WIRE_FIRST_CAPACITY;
+        while (capacity < wire->len + len) {
+            capacity *= 2;
+        }
+        uint8_t *data = realloc(wire->data, capacity);
+        if (!data) {
+            wire->failed = true;
+            return NULL;
+        }
+        wire->data = data;
+        wire->capacity = capacity;
+    }
+
+    uint8_t *at = wire->data + wire->len;
+    wire->len += len;
+    return at;
+}
+
+static void put_le(uint8_t *at, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        at[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+void db_wire_begin(struct db_wire *wire) {
+    wire->len = 0;
+    wire->failed = false;
+    wire_reserve(wire, sizeof(uint32_t));
+}
+
+bool db_wire_end(struct db_wire *wire) {
+    if (wire->failed || wire->len < sizeof(uint32_t)) {
+        return false;
+    }
+    put_le(wire->data, wire->len - sizeof(uint32_t), sizeof(uint32_t));
+    return true;
+}
+
+void db_wire_free(struct db_wire *wire) {
+    free(wire->data);
+    memset(wire, 0, sizeof(*wire));
+}
+
+void db_wire_put_u8(struct db_wire *wire, uint8_t value) {
+    uint8_t *at = wire_reserve(wire, 1);
+    if (at) {
+        *at = value;
+    }
+}
+
+void db_wire_put_u32(struct db_wire *wire, uint32_t value) {
+    uint8_t *at = wire_reserve(wire, 4);
+    if (at) {
+        put_le(at, value, 4);
+    }
+}
+
+void db_wire_put_i32(struct db_wire *wire, int32_t value) {
+    db_wire_put_u32(wire, (uint32_t)value);
+}
+
+void db_wire_put_i64(struct db_wire *wire, int64_t value) {
+    uint8_t *at = wire_reserve(wire, 8);
+    if (at) {
+        put_le(at, (uint64_t)value, 8);
+    }
+}
+
+void db_wire_put_f64(struct db_wire *wire, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    db_wire_put_i64(wire, (int64_t)bits);
+}
+
+void db_wire_set_i32(struct db_wire *wire, size_t at, int32_t value) {
+    if (!wire->failed && at + sizeof(int32_t) <= wire->len) {
+        put_le(wire->data + at, (uint32_t)value, sizeof(int32_t));
+    }
+}
+
+void db_wire_put_bytes(struct db_wire *wire, const char *value, size_t len) {
+    if (len >= DB_WIRE_NULL) {
+        wire->failed = true;
+        return;
+    }
+    db_wire_put_u32(wire, (uint32_t)len);
+    uint8_t *at = wire_reserve(wire, len);
+    if (at && len > 0) {
+        memcpy(at, value, len);
+    }
+}
+
+void db_wire_put_str(struct db_wire *wire, const char *value) {
+    if (!value) {
+        db_wire_put_u32(wire, DB_WIRE_NULL);
+        return;
+    }
+    db_wire_put_bytes(wire, value, strlen(value));
+}
+
+/* ======================= READING ======================= */
+
+/**
+ * @internal
+ * @brief Takes the next len bytes
+ *
+ * @return Their address, NULL past the end (the reader is failed then)
+ */
+static const uint8_t *reader_take(struct db_wire_reader *reader, size_t len) {
+    if (reader->failed || reader->len - reader->pos < len) {
+        reader->failed = true;
+        return NULL;
+    }
+    const uint8_t *at = reader->data + reader->pos;
+    reader->pos += len;
+    return at;
+}
+
+static uint64_t get_le(const uint8_t *at, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)at[i] << (8 * i);
+    }
+    return value;
+}
+
+uint8_t db_wire_get_u8(struct db_wire_reader *reader) {
+    const uint8_t *at = reader_take(reader, 1);
+    return at ? *at : 0;
+}
+
+uint32_t db_wire_get_u32(struct db_wire_reader *reader) {
+    const uint8_t *at = reader_take(reader, 4);
+    return at ? (uint32_t)get_le(at, 4) : 0;
+}
+
+int32_t db_wire_get_i32(struct db_wire_reader *reader) {
+    return (int32_t)db_wire_get_u32(reader);
+}
+
+int64_t db_wire_get_i64(struct db_wire_reader *reader) {
+    const uint8_t *at = reader_take(reader, 8);
+    return at ? (int64_t)get_le(at, 8) : 0;
+}
+
+double db_wire_get_f64(struct db_wire_reader *reader) {
+    uint64_t bits = (uint64_t)db_wire_get_i64(reader);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+const char *db_wire_get_bytes(struct db_wire_reader *reader, size_t *len) {
+    uint32_t length = db_wire_get_u32(reader);
+    *len = 0;
+    if (length == DB_WIRE_NULL) {
+        return NULL;
+    }
+    const uint8_t *at = reader_take(reader, length);
+    if (!at) {
+        return NULL;
+    }
+    *len = length;
+    return (const char *)at;
+}
+
+bool db_wire_get_str(struct db_wire_reader *reader, char *buffer, size_t size) {
+    size_t len;
+    const char *bytes = db_wire_get_bytes(reader, &len);
+    if (size == 0) {
+        return bytes != NULL;
+    }
+    if (len >= size) {
+        len = size - 1;
+    }
+    if (bytes) {
+        memcpy(buffer, bytes, len);
+    }
+    buffer[bytes ? len : 0] = '\0';
+    return bytes != NULL;
+}
+
+/* ======================= SOCKETS ======================= */
+
+#ifdef _WIN32
+
+// Unix domain sockets are only used on Linux, see db_server.h
+bool db_wire_send(int fd, const struct db_wire *wire) {
+    (void)fd;
+    (void)wire;
+    return false;
+}
+
+bool db_wire_recv(int fd, uint8_t **buffer, size_t *capacity, struct db_wire_reader *reader) {
+    (void)fd;
+    (void)buffer;
+    (void)capacity;
+    (void)reader;
+    return false;
+}
+
+#else
+
+bool db_wire_send(int fd, const struct db_wire *wire) {
+    size_t sent = 0;
+    while (sent < wire->len) {
+        // MSG_NOSIGNAL: a peer gone away is an error, not a SIGPIPE killing the process
+        ssize_t n = send(fd, wire->data + sent, wire->len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Reads exactly len bytes
+ */
+static bool recv_all(int fd, uint8_t *to, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, to + got, len - got, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        got += (size_t)n;
+    }
+    return true;
+}
+
+bool db_wire_recv(int fd, uint8_t **buffer, size_t *capacity, struct db_wire_reader *reader) {
+    uint8_t header[4];
+    if (!recv_all(fd, header, sizeof(header))) {
+        return false;
+    }
+    size_t len = (size_t)get_le(header, 4);
+    if (len > DB_PROTOCOL_MAX_FRAME) {
+        return false;
+    }
+
+    if (len > *capacity || !*buffer) {
+        size_t grown = len > WIRE_FIRST_CAPACITY ? len : WIRE_FIRST_CAPACITY;
+        uint8_t *data = realloc(*buffer, grown);
+        if (!data) {
+            return false;
+        }
+        *buffer = data;
+        *capacity = grown;
+    }
+    if (!recv_all(fd, *buffer, len)) {
+        return false;
+    }
+
+    reader->data = *buffer;
+    reader->len = len;
+    reader->pos = 0;
+    reader->failed = false;
+    return true;
+}
+
+#endif
@@ -0,0 +1,1178 @@
+/**
+ * @file db_server.c
+ * @brief Local database server implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For the socket functions, clock_gettime and nanosleep
+
+#include "db/db_server.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+
+struct db_server *db_server_start(
+    const char *socket_path,
+    database *resident_db,
+    database *foodbatch_db,
+    database *user_db,
+    const struct db_server_config *config
+) {
+    (void)socket_path;
+    (void)resident_db;
+    (void)foodbatch_db;
+    (void)user_db;
+    (void)config;
+    fprintf(stderr, "The database server needs Unix domain sockets, not available on this platform.\n");
+    return NULL;
+}
+
+void db_server_get_stats(struct db_server *server, struct db_server_stats *stats) {
+    (void)server;
+    *stats = (struct db_server_stats) { 0 };
+}
+
+void db_server_stop(struct db_server *server) {
+    (void)server;
+}
+
+#else
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "db/db_protocol.h"
+#include "db/food_distribution.h"
+#include "db/foodbatch_db.h"
+#include "db/resident_db.h"
+#include "db/user_db.h"
+
+#define SERVER_STRING_LEN 1024             // Longest string argument accepted, above every field limit
+#define SERVER_AUTH_POLL_NS (2 * 1000000L) // Time between two checks of a password being hashed
+#define SERVER_MAX_DUPLICATES 64           // Most duplicate candidates sent back at once
+#define SERVER_MAX_SEARCH_RESULTS 100      // Most search results sent back at once
+#define SERVER_PAGE_BYTES (256 * 1024)     // Rows of a range query sent back at once, a page ends past it
+
+/**
+ * @internal
+ * @struct server_write
+ * @brief Write waiting for the writer thread, lives on the stack of its client thread
+ */
+struct server_write {
+    enum db_op op;               ///< Operation
+    struct db_wire_reader *args; ///< Its arguments, in the receive buffer of the client thread
+    struct db_wire *reply;       ///< Reply of the client thread, for the values of the write
+    int32_t result;              ///< What the forwarded function returned
+    bool done;                   ///< Committed (or failed), result is set
+    struct server_write *next;   ///< Next write in the queue
+};
+
+/**
+ * @internal
+ * @struct server_client
+ * @brief Connected client
+ */
+struct server_client {
+    struct db_server *server;   ///< Server it belongs to
+    int fd;                     ///< Socket, closed after the thread is joined
+    pthread_t thread;           ///< Thread serving it
+    bool finished;              ///< Thread returned, guarded by the server lock
+    struct server_client *next; ///< Next client of the server
+};
+
+struct db_server {
+    char path[DB_SOCKET_PATH_LEN]; ///< Socket file, removed by db_server_stop()
+    database *resident_db;         ///< Served resident database
+    database *foodbatch_db;        ///< Served food batch database
+    database *user_db;             ///< Served user database
+    int max_clients;               ///< Clients connected at once
+    int max_batch;                 ///< Writes per group commit
+    int listen_fd;                 ///< Listening socket
+    pthread_t accept_thread;       ///< Accepts the clients and joins the finished ones
+    pthread_t writer_thread;       ///< Runs the writes in group commits
+    atomic_bool stopping;          ///< db_server_stop() was called
+
+    pthread_mutex_t lock;          ///< Guards everything below
+    pthread_cond_t queued;         ///< A write was queued, or the writer must exit
+    pthread_cond_t done;           ///< A batch was committed
+    struct server_write *head;     ///< Writes waiting for the writer, oldest first
+    struct server_write *tail;     ///< Newest queued write
+    bool writer_exit;              ///< Stop the writer once the queue is empty
+    struct server_client *clients; ///< Connected clients
+    int client_count;              ///< Entries in clients
+    struct db_server_stats stats;  ///< Totals
+
+    pthread_mutex_t user_lock;     ///< One user function at a time, the login queue is not shared
+};
+
+/* ======================= ARGUMENTS ======================= */
+
+/**
+ * @internal
+ * @brief Reads a string argument into buffer (SERVER_STRING_LEN bytes)
+ *
+ * @return buffer, NULL with the reader failed if the string is NULL or too long
+ */
+static const char *server_str(struct db_wire_reader *args, char *buffer) {
+    size_t len;
+    const char *bytes = db_wire_get_bytes(args, &len);
+    if (!bytes || len >= SERVER_STRING_LEN) {
+        args->failed = true;
+        return NULL;
+    }
+    memcpy(buffer, bytes, len);
+    buffer[len] = '\0';
+    return buffer;
+}
+
+/**
+ * @internal
+ * @brief Buffer size a *_FORMAT_* request asks for, bounded so the reply fits a frame
+ */
+static size_t server_format_size(struct db_wire_reader *args) {
+    size_t size = db_wire_get_u32(args);
+    size_t most = DB_PROTOCOL_MAX_FRAME - 64;
+    return size < most ? size : most;
+}
+
+/**
+ * @internal
+ * @brief Runs a *_get_*_format() into a buffer of the requested size and adds the text
+ *
+ * @return Result of the function, -1 if the buffer could not be allocated
+ */
+static int32_t server_format(struct db_wire *reply, char *buffer, int result) {
+    if (result >= 0) {
+        db_wire_put_bytes(reply, buffer, strlen(buffer));
+    }
+    free(buffer);
+    return result;
+}
+
+/**
+ * @internal
+ * @brief Reads the capacity of a duplicate lookup, bounded by SERVER_MAX_DUPLICATES
+ */
+static int server_duplicates_max(struct db_wire_reader *args) {
+    int max = db_wire_get_i32(args);
+    return max < SERVER_MAX_DUPLICATES ? max : SERVER_MAX_DUPLICATES;
+}
+
+/**
+ * @internal
+ * @brief Adds duplicate candidates to a reply, in the order db_client.c reads them
+ */
+static void server_put_duplicates(struct db_wire *reply, const struct resident_duplicate *duplicates, int count) {
+    db_wire_put_u32(reply, count > 0 ? (uint32_t)count : 0);
+    for (int i = 0; i < count; i++) {
+        db_wire_put_str(reply, duplicates[i].cpf);
+        db_wire_put_str(reply, duplicates[i].name);
+        db_wire_put_f64(reply, duplicates[i].similarity);
+    }
+}
+
+/* ======================= WRITES ======================= */
+
+static bool server_is_write(enum db_op op) {
+    switch (op) {
+        case DB_OP_RESIDENT_INSERT:
+        case DB_OP_RESIDENT_INSERT_CHECKED:
+        case DB_OP_RESIDENT_UPDATE:
+        case DB_OP_RESIDENT_DELETE:
+        case DB_OP_FOODBATCH_INSERT:
+        case DB_OP_FOODBATCH_UPDATE:
+        case DB_OP_FOODBATCH_TAKE:
+        case DB_OP_FOODBATCH_DELETE:
+        case DB_OP_FOODBATCH_APPLY_PLAN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @internal
+ * @brief Database a write goes to
+ */
+static database *server_write_db(struct db_server *server, enum db_op op) {
+    return op < DB_OP_FOODBATCH_INSERT ? server->resident_db : server->foodbatch_db;
+}
+
+/**
+ * @internal
+ * @brief Decodes and runs a write, on the writer thread
+ *
+ * @return Result of the forwarded function, unset with the reader failed on a malformed request
+ */
+static int32_t server_run_write(
+    struct db_server *server,
+    enum db_op op,
+    struct db_wire_reader *args,
+    struct db_wire *reply
+) {
+    char a[SERVER_STRING_LEN], b[SERVER_STRING_LEN], c[SERVER_STRING_LEN], d[SERVER_STRING_LEN];
+    database *db = server_write_db(server, op);
+
+    switch (op) {
+        case DB_OP_RESIDENT_INSERT:
+        case DB_OP_RESIDENT_INSERT_CHECKED:
+        case DB_OP_RESIDENT_UPDATE: {
+            const char *cpf = server_str(args, a);
+            const char *name = server_str(args, b);
+            int age = db_wire_get_i32(args);
+            const char *health_status = server_str(args, c);
+            const char *needs = server_str(args, d);
+            int medical_assistance = op == DB_OP_RESIDENT_UPDATE ? db_wire_get_i32(args) : db_wire_get_u8(args);
+            int gender = db_wire_get_i32(args);
+            float threshold = op == DB_OP_RESIDENT_INSERT_CHECKED ? (float)db_wire_get_f64(args) : 0.0f;
+            int max = op == DB_OP_RESIDENT_INSERT_CHECKED ? server_duplicates_max(args) : 0;
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            if (op == DB_OP_RESIDENT_INSERT) {
+                return resident_db_insert(db, cpf, name, age, health_status, needs, medical_assistance != 0, gender);
+            }
+            if (op == DB_OP_RESIDENT_UPDATE) {
+                return resident_db_update(db, cpf, name, age, health_status, needs, medical_assistance, gender);
+            }
+
+            // Looked up inside the group transaction, so the writes before it in the batch count
+            struct resident_duplicate duplicates[SERVER_MAX_DUPLICATES];
+            int count = 0;
+            int rc = resident_db_insert_checked(
+                db,
+                cpf,
+                name,
+                age,
+                health_status,
+                needs,
+                medical_assistance != 0,
+                gender,
+                threshold,
+                duplicates,
+                max,
+                &count
+            );
+            server_put_duplicates(reply, duplicates, count);
+            return rc;
+        }
+        case DB_OP_RESIDENT_DELETE: {
+            const char *cpf = server_str(args, a);
+            return args->failed ? SQLITE_MISUSE : resident_db_delete_by_cpf(db, cpf);
+        }
+        case DB_OP_FOODBATCH_INSERT:
+        case DB_OP_FOODBATCH_UPDATE: {
+            int batch_id = db_wire_get_i32(args);
+            const char *name = server_str(args, a);
+            int quantity = db_wire_get_i32(args);
+            bool is_perishable = db_wire_get_u8(args) != 0;
+            const char *expiration_date = server_str(args, b);
+            float rate = (float)db_wire_get_f64(args);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            if (op == DB_OP_FOODBATCH_INSERT) {
+                return foodbatch_db_insert(db, batch_id, name, quantity, is_perishable, expiration_date, rate);
+            }
+            return foodbatch_db_update(db, batch_id, name, quantity, is_perishable, expiration_date, rate);
+        }
+        case DB_OP_FOODBATCH_TAKE: {
+            int batch_id = db_wire_get_i32(args);
+            int amount = db_wire_get_i32(args);
+            return args->failed ? SQLITE_MISUSE : foodbatch_db_take_quantity(db, batch_id, amount);
+        }
+        case DB_OP_FOODBATCH_DELETE: {
+            int batch_id = db_wire_get_i32(args);
+            return args->failed ? SQLITE_MISUSE : foodbatch_db_delete_by_id(db, batch_id);
+        }
+        case DB_OP_FOODBATCH_APPLY_PLAN: {
+            // 8 bytes per pick, a count the frame cannot hold is malformed
+            uint32_t count = db_wire_get_u32(args);
+            if (args->failed || count > (args->len - args->pos) / 8) {
+                args->failed = true;
+                return SQLITE_MISUSE;
+            }
+            struct food_plan plan = { 0 };
+            plan.picks = malloc(sizeof(*plan.picks) * (count ? count : 1));
+            if (!plan.picks) {
+                return SQLITE_NOMEM;
+            }
+            plan.pick_count = (int)count;
+            for (uint32_t i = 0; i < count; i++) {
+                plan.picks[i].batch_id = db_wire_get_i32(args);
+                plan.picks[i].quantity = db_wire_get_i32(args);
+            }
+            // Inside the group transaction, food_plan_apply() keeps its picks together on a savepoint
+            int rc = food_plan_apply(db, &plan);
+            food_plan_free(&plan);
+            return rc;
+        }
+        default:
+            args->failed = true;
+            return SQLITE_MISUSE;
+    }
+}
+
+/**
+ * @internal
+ * @brief Runs a batch of writes, one transaction per database
+ *
+ * A database whose transaction can't be started (another process writing) gets its writes
+ * committed one by one instead. A failed commit is the result of every write it held.
+ *
+ * @return Transactions committed
+ */
+static int server_commit_batch(struct db_server *server, struct server_write *batch) {
+    database *dbs[2] = { server->resident_db, server->foodbatch_db };
+    bool used[2] = { false, false };
+    bool grouped[2] = { false, false };
+    int commits = 0;
+
+    for (struct server_write *w = batch; w; w = w->next) {
+        int i = server_write_db(server, w->op) == dbs[0] ? 0 : 1;
+        if (!used[i]) {
+            used[i] = true;
+            grouped[i] = sqlite3_exec(dbs[i]->db, "BEGIN IMMEDIATE;", 0, 0, 0) == SQLITE_OK;
+        }
+        if (!grouped[i]) {
+            w->result = server_run_write(server, w->op, w->args, w->reply);
+            commits++;
+            continue;
+        }
+
+        // A failing write may have changed rows before failing, its savepoint drops them alone
+        sqlite3_exec(dbs[i]->db, "SAVEPOINT w;", 0, 0, 0);
+        w->result = server_run_write(server, w->op, w->args, w->reply);
+        if (w->result != SQLITE_OK) {
+            sqlite3_exec(dbs[i]->db, "ROLLBACK TO w;", 0, 0, 0);
+        }
+        sqlite3_exec(dbs[i]->db, "RELEASE w;", 0, 0, 0);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (!grouped[i]) {
+            continue;
+        }
+        int rc = sqlite3_exec(dbs[i]->db, "COMMIT;", 0, 0, 0);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Group commit failed: %s\n", sqlite3_errmsg(dbs[i]->db));
+            sqlite3_exec(dbs[i]->db, "ROLLBACK;", 0, 0, 0);
+            for (struct server_write *w = batch; w; w = w->next) {
+                if (server_write_db(server, w->op) == dbs[i] && w->result == SQLITE_OK) {
+                    w->result = rc;
+                }
+            }
+        } else {
+            commits++;
+        }
+    }
+    return commits;
+}
+
+/**
+ * @internal
+ * @brief Writes the queued last logins under the user lock
+ */
+static void server_flush_logins(struct db_server *server, bool force) {
+    pthread_mutex_lock(&server->user_lock);
+    user_db_flush_last_login(server->user_db, force);
+    pthread_mutex_unlock(&server->user_lock);
+}
+
+/**
+ * @internal
+ * @brief Writer thread, commits whatever queued while the previous batch was committing
+ */
+static void *server_writer(void *arg) {
+    struct db_server *server = arg;
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        if (!server->head && !server->writer_exit) {
+            struct timespec due;
+            clock_gettime(CLOCK_REALTIME, &due);
+            due.tv_sec += DB_SERVER_FLUSH_NS / 1000000000LL;
+            if (pthread_cond_timedwait(&server->queued, &server->lock, &due) == ETIMEDOUT) {
+                // Nothing written for a while, the idle logins can go
+                pthread_mutex_unlock(&server->lock);
+                server_flush_logins(server, false);
+                pthread_mutex_lock(&server->lock);
+            }
+            continue;
+        }
+        if (!server->head) {
+            break;
+        }
+
+        struct server_write *batch = server->head;
+        struct server_write *last = batch;
+        int count = 1;
+        while (last->next && count < server->max_batch) {
+            last = last->next;
+            count++;
+        }
+        server->head = last->next;
+        if (!server->head) {
+            server->tail = NULL;
+        }
+        last->next = NULL;
+        pthread_mutex_unlock(&server->lock);
+
+        int commits = server_commit_batch(server, batch);
+
+        pthread_mutex_lock(&server->lock);
+        for (struct server_write *w = batch; w; w = w->next) {
+            w->done = true;
+        }
+        server->stats.writes += (uint64_t)count;
+        server->stats.commits += (uint64_t)commits;
+        if ((uint64_t)count > server->stats.largest_batch) {
+            server->stats.largest_batch = (uint64_t)count;
+        }
+        pthread_cond_broadcast(&server->done);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Queues a write and waits until it is committed
+ */
+static int32_t server_write(
+    struct db_server *server,
+    enum db_op op,
+    struct db_wire_reader *args,
+    struct db_wire *reply
+) {
+    struct server_write write = { .op = op, .args = args, .reply = reply };
+
+    pthread_mutex_lock(&server->lock);
+    if (server->tail) {
+        server->tail->next = &write;
+    } else {
+        server->head = &write;
+    }
+    server->tail = &write;
+    pthread_cond_signal(&server->queued);
+    while (!write.done) {
+        pthread_cond_wait(&server->done, &server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return write.result;
+}
+
+/* ======================= READS ======================= */
+
+/**
+ * @internal
+ * @brief Adds a resident to a reply, in the order db_client.c reads it
+ */
+static void server_put_resident(struct db_wire *reply, const struct resident *resident) {
+    db_wire_put_str(reply, resident->cpf);
+    db_wire_put_i64(reply, resident->cpf_packed);
+    db_wire_put_str(reply, resident->name);
+    db_wire_put_i32(reply, resident->age);
+    db_wire_put_str(reply, resident->health_status);
+    db_wire_put_str(reply, resident->needs);
+    db_wire_put_u8(reply, resident->medical_assistance);
+    db_wire_put_i32(reply, resident->gender);
+    db_wire_put_i32(reply, resident->entry_day);
+    db_wire_put_str(reply, resident->entry_date);
+}
+
+/**
+ * @internal
+ * @brief Adds a food batch to a reply, in the order db_client.c reads it
+ */
+static void server_put_foodbatch(struct db_wire *reply, const struct foodbatch *foodbatch) {
+    db_wire_put_i32(reply, foodbatch->batch_id);
+    db_wire_put_str(reply, foodbatch->name);
+    db_wire_put_i32(reply, foodbatch->quantity);
+    db_wire_put_u8(reply, foodbatch->is_perishable);
+    db_wire_put_i32(reply, foodbatch->expiration_day);
+    db_wire_put_str(reply, foodbatch->expiration_date);
+    db_wire_put_f64(reply, foodbatch->daily_consumption_rate);
+}
+
+/**
+ * @internal
+ * @struct server_page
+ * @brief Page of a range query being added to a reply
+ */
+struct server_page {
+    struct db_wire *reply; ///< Reply the rows go to
+    uint32_t skip;         ///< Rows the client received in the pages before, left to skip
+    int32_t count;         ///< Rows added
+    bool more;             ///< The page is full and another row is waiting
+};
+
+/**
+ * @internal
+ * @brief Whether a row goes to the page, false for the rows already sent and once the page is full
+ */
+static bool server_page_take(struct server_page *page) {
+    if (page->skip > 0) {
+        page->skip--;
+        return false;
+    }
+    if (page->reply->len >= SERVER_PAGE_BYTES) {
+        page->more = true;
+        return false;
+    }
+    page->count++;
+    return true;
+}
+
+/**
+ * @internal
+ * @brief resident_callback, adds a resident to a page
+ */
+static int server_page_resident(void *ctx, const struct resident *resident) {
+    struct server_page *page = ctx;
+    if (server_page_take(page)) {
+        server_put_resident(page->reply, resident);
+    }
+    return page->more;
+}
+
+/**
+ * @internal
+ * @brief foodbatch_callback, adds a food batch to a page
+ */
+static int server_page_foodbatch(void *ctx, const struct foodbatch *foodbatch) {
+    struct server_page *page = ctx;
+    if (server_page_take(page)) {
+        server_put_foodbatch(page->reply, foodbatch);
+    }
+    return page->more;
+}
+
+/**
+ * @internal
+ * @brief Runs a paged query (*_BETWEEN, *_IN_STOCK) and adds one page of it to the reply
+ *
+ * @return Rows in the page, -1 on failure
+ */
+static int32_t server_run_page(database *reader, enum db_op op, struct db_wire_reader *args, struct db_wire *reply) {
+    int32_t from_day = db_wire_get_i32(args);
+    int32_t to_day = db_wire_get_i32(args);
+    struct server_page page = { .reply = reply, .skip = db_wire_get_u32(args) };
+    if (args->failed) {
+        return -1;
+    }
+
+    size_t start = reply->len;
+    int rc;
+    switch (op) {
+        case DB_OP_RESIDENT_ENTERED_BETWEEN:
+            rc = resident_db_entered_between(reader, from_day, to_day, server_page_resident, &page);
+            break;
+        case DB_OP_FOODBATCH_EXPIRING_BETWEEN:
+            rc = foodbatch_db_expiring_between(reader, from_day, to_day, server_page_foodbatch, &page);
+            break;
+        default: // DB_OP_FOODBATCH_IN_STOCK
+            rc = foodbatch_db_in_stock(reader, server_page_foodbatch, &page);
+            break;
+    }
+    if (rc < 0) {
+        reply->len = start; // Drop the rows of a query that failed halfway
+        return -1;
+    }
+    db_wire_put_u8(reply, page.more);
+    return page.count;
+}
+
+/**
+ * @internal
+ * @brief Runs a resident or food batch read on a pooled connection
+ *
+ * @return Result of the forwarded function, unset with the reader failed on a malformed request
+ */
+static int32_t server_run_read(database *reader, enum db_op op, struct db_wire_reader *args, struct db_wire *reply) {
+    char key[SERVER_STRING_LEN];
+
+    switch (op) {
+        case DB_OP_RESIDENT_EXISTS: {
+            const char *cpf = server_str(args, key);
+            return args->failed ? 0 : resident_db_check_cpf_exists(reader, cpf);
+        }
+        case DB_OP_RESIDENT_GET: {
+            const char *cpf = server_str(args, key);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            struct resident resident = { 0 };
+            int rc = resident_db_get_by_cpf(reader, cpf, &resident);
+            if (rc == SQLITE_OK) {
+                server_put_resident(reply, &resident);
+            }
+            return rc;
+        }
+        case DB_OP_RESIDENT_COUNT:
+            return resident_db_get_count(reader);
+        case DB_OP_RESIDENT_DUPLICATES: {
+            const char *name = server_str(args, key);
+            char exclude[SERVER_STRING_LEN];
+            size_t len;
+            const char *bytes = db_wire_get_bytes(args, &len); // NULL for no CPF to leave out
+            float threshold = (float)db_wire_get_f64(args);
+            int max = server_duplicates_max(args);
+            if (args->failed || (bytes && len >= sizeof(exclude))) {
+                args->failed = true;
+                return -1;
+            }
+            if (bytes) {
+                memcpy(exclude, bytes, len);
+                exclude[len] = '\0';
+            }
+            struct resident_duplicate duplicates[SERVER_MAX_DUPLICATES];
+            int count = resident_db_find_duplicates(reader, name, bytes ? exclude : NULL, threshold, duplicates, max);
+            server_put_duplicates(reply, duplicates, count);
+            return count;
+        }
+        case DB_OP_FOODBATCH_EXISTS: {
+            int batch_id = db_wire_get_i32(args);
+            return args->failed ? 0 : foodbatch_db_check_batchid_exists(reader, batch_id);
+        }
+        case DB_OP_FOODBATCH_GET: {
+            int batch_id = db_wire_get_i32(args);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            struct foodbatch foodbatch = { 0 };
+            int rc = foodbatch_db_get_by_batchid(reader, batch_id, &foodbatch);
+            if (rc == SQLITE_OK) {
+                server_put_foodbatch(reply, &foodbatch);
+            }
+            return rc;
+        }
+        case DB_OP_FOODBATCH_COUNT:
+            return foodbatch_db_get_count(reader);
+        case DB_OP_RESIDENT_SEARCH: {
+            const char *query = server_str(args, key);
+            int limit = db_wire_get_i32(args);
+            if (args->failed) {
+                return -1;
+            }
+            // A single page, SERVER_MAX_SEARCH_RESULTS residents are far below SERVER_PAGE_BYTES
+            struct server_page page = { .reply = reply };
+            size_t start = reply->len;
+            int rc = resident_db_search(
+                reader,
+                query,
+                limit < SERVER_MAX_SEARCH_RESULTS ? limit : SERVER_MAX_SEARCH_RESULTS,
+                server_page_resident,
+                &page
+            );
+            if (rc < 0) {
+                reply->len = start;
+                return -1;
+            }
+            return page.count;
+        }
+        case DB_OP_RESIDENT_ENTERED_BETWEEN:
+        case DB_OP_FOODBATCH_EXPIRING_BETWEEN:
+        case DB_OP_FOODBATCH_IN_STOCK:
+            return server_run_page(reader, op, args, reply);
+        default:
+            break;
+    }
+
+    // The formatted tables, key first when there is one
+    const char *cpf = op == DB_OP_RESIDENT_FORMAT_ONE ? server_str(args, key) : NULL;
+    int batch_id = op == DB_OP_FOODBATCH_FORMAT_ONE ? db_wire_get_i32(args) : 0;
+    size_t size = server_format_size(args);
+    if (args->failed) {
+        return -1;
+    }
+    char *buffer = malloc(size ? size : 1);
+    if (!buffer) {
+        return -1;
+    }
+    buffer[0] = '\0';
+
+    switch (op) {
+        case DB_OP_RESIDENT_FORMAT_ALL:
+            return server_format(reply, buffer, resident_db_get_all_format(reader, buffer, size));
+        case DB_OP_RESIDENT_FORMAT_ONE:
+            return server_format(reply, buffer, resident_db_get_format_by_cpf(reader, cpf, buffer, size));
+        case DB_OP_FOODBATCH_FORMAT_ALL:
+            return server_format(reply, buffer, foodbatch_db_get_all_format(reader, buffer, size));
+        case DB_OP_FOODBATCH_FORMAT_ONE:
+            return server_format(reply, buffer, foodbatch_db_get_format_by_batchid(reader, batch_id, buffer, size));
+        default:
+            free(buffer);
+            args->failed = true;
+            return -1;
+    }
+}
+
+/**
+ * @internal
+ * @brief Checks out a reader of the database the read goes to and runs it
+ */
+static int32_t server_read(struct db_server *server, enum db_op op, struct db_wire_reader *args, struct db_wire *reply) {
+    database *db = op < DB_OP_FOODBATCH_INSERT ? server->resident_db : server->foodbatch_db;
+    database reader;
+    if (db_pool_acquire(db, &reader) != SQLITE_OK) {
+        return SQLITE_ERROR;
+    }
+    int32_t result = server_run_read(&reader, op, args, reply);
+    db_pool_release(db, &reader);
+    return result;
+}
+
+/* ======================= USERS ======================= */
+
+/**
+ * @internal
+ * @brief Checks a password, with the user lock held only while the database is used
+ */
+static int32_t server_authenticate(struct db_server *server, const char *username, const char *password) {
+    pthread_mutex_lock(&server->user_lock);
+    struct user_auth *auth = user_db_authenticate_start(server->user_db, username, password);
+    pthread_mutex_unlock(&server->user_lock);
+    if (!auth) {
+        return AUTH_FAILURE;
+    }
+
+    enum auth_result result = AUTH_FAILURE;
+    for (;;) {
+        pthread_mutex_lock(&server->user_lock);
+        bool done = user_db_authenticate_poll(auth, server->user_db, &result);
+        pthread_mutex_unlock(&server->user_lock);
+        if (done) {
+            return result;
+        }
+        nanosleep(&(struct timespec) { .tv_nsec = SERVER_AUTH_POLL_NS }, NULL);
+    }
+}
+
+/**
+ * @internal
+ * @brief Runs a user function, the caller holds the user lock
+ *
+ * @return Result of the forwarded function, unset with the reader failed on a malformed request
+ */
+static int32_t server_run_user(database *db, enum db_op op, struct db_wire_reader *args, struct db_wire *reply) {
+    char a[SERVER_STRING_LEN], b[SERVER_STRING_LEN], c[SERVER_STRING_LEN];
+
+    switch (op) {
+        case DB_OP_USER_CREATE: {
+            const char *username = server_str(args, a);
+            const char *cpf = server_str(args, b);
+            const char *phone_number = server_str(args, c);
+            bool is_admin = db_wire_get_u8(args) != 0;
+            return args->failed ? SQLITE_MISUSE : user_db_create_user(db, username, cpf, phone_number, is_admin);
+        }
+        case DB_OP_USER_DELETE:
+        case DB_OP_USER_RESET_PASSWORD:
+        case DB_OP_USER_CPF_EXISTS:
+        case DB_OP_USER_EXISTS:
+        case DB_OP_USER_IS_ADMIN: {
+            const char *key = server_str(args, a);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            switch (op) {
+                case DB_OP_USER_DELETE:
+                    return user_db_delete(db, key);
+                case DB_OP_USER_RESET_PASSWORD:
+                    return user_db_set_reset_password(db, key);
+                case DB_OP_USER_CPF_EXISTS:
+                    return user_db_check_cpf_exists(db, key);
+                case DB_OP_USER_EXISTS:
+                    return user_db_check_exists(db, key);
+                default:
+                    return user_db_check_admin_status(db, key);
+            }
+        }
+        case DB_OP_USER_SET_PHONE:
+        case DB_OP_USER_SET_CPF:
+        case DB_OP_USER_SET_PASSWORD:
+        case DB_OP_USER_SET_USERNAME: {
+            const char *username = server_str(args, a);
+            const char *value = server_str(args, b);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            switch (op) {
+                case DB_OP_USER_SET_PHONE:
+                    return user_db_update_phone_number(db, username, value);
+                case DB_OP_USER_SET_CPF:
+                    return user_db_update_cpf(db, username, value);
+                case DB_OP_USER_SET_PASSWORD:
+                    return user_db_update_password(db, username, value);
+                default:
+                    return user_db_update_username(db, username, value);
+            }
+        }
+        case DB_OP_USER_SET_ADMIN: {
+            const char *username = server_str(args, a);
+            bool is_admin = db_wire_get_u8(args) != 0;
+            return args->failed ? SQLITE_MISUSE : user_db_update_admin_status(db, username, is_admin);
+        }
+        case DB_OP_USER_GET: {
+            const char *username = server_str(args, a);
+            if (args->failed) {
+                return SQLITE_MISUSE;
+            }
+            struct user user = { 0 };
+            int rc = user_db_get_by_username(db, username, &user);
+            if (rc == SQLITE_OK) {
+                // Never the password hash and salt, the server checks passwords itself
+                db_wire_put_str(reply, user.username);
+                db_wire_put_str(reply, user.cpf);
+                db_wire_put_str(reply, user.phone_number);
+                db_wire_put_u8(reply, user.is_admin);
+                db_wire_put_u8(reply, user.reset_password);
+                db_wire_put_i64(reply, (int64_t)user.created_at);
+                db_wire_put_i64(reply, (int64_t)user.last_login);
+            }
+            memset(&user, 0, sizeof(user));
+            return rc;
+        }
+        case DB_OP_USER_COUNT:
+            return user_db_get_count(db);
+        case DB_OP_USER_FORMAT_ALL: {
+            size_t size = server_format_size(args);
+            char *buffer = args->failed ? NULL : malloc(size ? size : 1);
+            if (!buffer) {
+                return -1;
+            }
+            buffer[0] = '\0';
+            return server_format(reply, buffer, user_db_get_all_format(db, buffer, size));
+        }
+        default:
+            args->failed = true;
+            return SQLITE_MISUSE;
+    }
+}
+
+/**
+ * @internal
+ * @brief Runs a user function
+ */
+static int32_t server_user(struct db_server *server, enum db_op op, struct db_wire_reader *args, struct db_wire *reply) {
+    if (op == DB_OP_USER_AUTHENTICATE) {
+        char username[SERVER_STRING_LEN], password[SERVER_STRING_LEN];
+        server_str(args, username);
+        server_str(args, password);
+        int32_t result = args->failed ? AUTH_FAILURE : server_authenticate(server, username, password);
+        memset(password, 0, sizeof(password));
+        return result;
+    }
+
+    pthread_mutex_lock(&server->user_lock);
+    int32_t result = server_run_user(server->user_db, op, args, reply);
+    pthread_mutex_unlock(&server->user_lock);
+    return result;
+}
+
+/* ======================= CLIENTS ======================= */
+
+/**
+ * @internal
+ * @brief Client thread, answers requests until the client leaves or sends garbage
+ */
+static void *server_client_thread(void *arg) {
+    struct server_client *client = arg;
+    struct db_server *server = client->server;
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    struct db_wire reply = { 0 };
+    struct db_wire_reader request;
+    bool greeted = false;
+
+    while (db_wire_recv(client->fd, &buffer, &capacity, &request)) {
+        uint32_t id = db_wire_get_u32(&request);
+        enum db_op op = (enum db_op)db_wire_get_u8(&request);
+        if (request.failed || (!greeted && op != DB_OP_HELLO)) {
+            break;
+        }
+
+        db_wire_begin(&reply);
+        db_wire_put_u32(&reply, id);
+        size_t result_at = reply.len;
+        db_wire_put_i32(&reply, 0);
+
+        int32_t result;
+        if (op == DB_OP_HELLO) {
+            greeted = db_wire_get_u32(&request) == DB_PROTOCOL_VERSION;
+            result = greeted ? SQLITE_OK : SQLITE_MISMATCH;
+        } else if (server_is_write(op)) {
+            result = server_write(server, op, &request, &reply);
+        } else if (op >= DB_OP_USER_CREATE) {
+            result = server_user(server, op, &request, &reply);
+        } else {
+            result = server_read(server, op, &request, &reply);
+        }
+        if (request.failed) {
+            break;
+        }
+        db_wire_set_i32(&reply, result_at, result);
+
+        if (!db_wire_end(&reply) || !db_wire_send(client->fd, &reply) || !greeted) {
+            break;
+        }
+        pthread_mutex_lock(&server->lock);
+        server->stats.requests++;
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    free(buffer);
+    db_wire_free(&reply);
+    pthread_mutex_lock(&server->lock);
+    client->finished = true;
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Joins and frees the clients whose thread returned
+ *
+ * @param[in] all Shut down and join every client, for db_server_stop()
+ */
+static void server_reap_clients(struct db_server *server, bool all) {
+    pthread_mutex_lock(&server->lock);
+    struct server_client **link = &server->clients;
+    while (*link) {
+        struct server_client *client = *link;
+        if (all) {
+            shutdown(client->fd, SHUT_RDWR);
+        } else if (!client->finished) {
+            link = &client->next;
+            continue;
+        }
+        *link = client->next;
+        server->client_count--;
+
+        // The thread may wait for the writer, which needs the lock
+        pthread_mutex_unlock(&server->lock);
+        pthread_join(client->thread, NULL);
+        close(client->fd);
+        free(client);
+        pthread_mutex_lock(&server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * @internal
+ * @brief Accept thread, one client thread per connection
+ */
+static void *server_accept(void *arg) {
+    struct db_server *server = arg;
+
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (atomic_load(&server->stopping)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            break;
+        }
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            fprintf(stderr, "Database server stopped accepting clients: %s\n", strerror(errno));
+            break;
+        }
+
+        server_reap_clients(server, false);
+
+        pthread_mutex_lock(&server->lock);
+        bool full = server->client_count >= server->max_clients;
+        pthread_mutex_unlock(&server->lock);
+        struct server_client *client = full ? NULL : calloc(1, sizeof(*client));
+        if (!client) {
+            fprintf(stderr, "Database server refused a client (%s).\n", full ? "too many clients" : "out of memory");
+            close(fd);
+            continue;
+        }
+
+        client->server = server;
+        client->fd = fd;
+        pthread_mutex_lock(&server->lock);
+        if (pthread_create(&client->thread, NULL, server_client_thread, client) != 0) {
+            pthread_mutex_unlock(&server->lock);
+            fprintf(stderr, "Failed to start a database server thread.\n");
+            close(fd);
+            free(client);
+            continue;
+        }
+        client->next = server->clients;
+        server->clients = client;
+        server->client_count++;
+        server->stats.clients++;
+        pthread_mutex_unlock(&server->lock);
+    }
+    return NULL;
+}
+
+/* ======================= SERVER ======================= */
+
+/**
+ * @internal
+ * @brief Creates, binds and listens on the socket, replacing a leftover socket file
+ *
+ * @return Listening socket, -1 on failure (printed on stderr)
+ */
+static int server_listen(const char *path, int backlog) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // A socket file nobody answers on was left by a server that did not stop cleanly
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "A database server is already running on %s.\n", path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+struct db_server *db_server_start(
+    const char *socket_path,
+    database *resident_db,
+    database *foodbatch_db,
+    database *user_db,
+    const struct db_server_config *config
+) {
+    if (!socket_path || strlen(socket_path) >= DB_SOCKET_PATH_LEN) {
+        fprintf(stderr, "Invalid database server socket path.\n");
+        return NULL;
+    }
+    if (!db_is_init(resident_db) || !db_is_init(foodbatch_db) || !db_is_init(user_db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return NULL;
+    }
+
+    // The reads run beside the writer's open transaction, on their own connections
+    database *pooled[2] = { resident_db, foodbatch_db };
+    for (int i = 0; i < 2; i++) {
+        if (db_pool_readers(pooled[i]) == 0 && db_pool_open(pooled[i], DB_SERVER_READERS) != SQLITE_OK) {
+            fprintf(stderr, "Failed to open the readers of the database server.\n");
+            return NULL;
+        }
+    }
+
+    struct db_server *server = calloc(1, sizeof(*server));
+    if (!server) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+    memcpy(server->path, socket_path, strlen(socket_path) + 1);
+    server->resident_db = resident_db;
+    server->foodbatch_db = foodbatch_db;
+    server->user_db = user_db;
+    server->max_clients = config && config->max_clients > 0 ? config->max_clients : DB_SERVER_MAX_CLIENTS;
+    server->max_batch = config && config->max_batch > 0 ? config->max_batch : DB_SERVER_MAX_BATCH;
+    atomic_init(&server->stopping, false);
+
+    server->listen_fd = server_listen(server->path, server->max_clients);
+    if (server->listen_fd < 0) {
+        free(server);
+        return NULL;
+    }
+
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_mutex_init(&server->user_lock, NULL);
+    pthread_cond_init(&server->queued, NULL);
+    pthread_cond_init(&server->done, NULL);
+
+    if (pthread_create(&server->writer_thread, NULL, server_writer, server) != 0) {
+        fprintf(stderr, "Failed to start the database server writer.\n");
+        close(server->listen_fd);
+        unlink(server->path);
+        pthread_mutex_destroy(&server->lock);
+        pthread_mutex_destroy(&server->user_lock);
+        pthread_cond_destroy(&server->queued);
+        pthread_cond_destroy(&server->done);
+        free(server);
+        return NULL;
+    }
+    if (pthread_create(&server->accept_thread, NULL, server_accept, server) != 0) {
+        fprintf(stderr, "Failed to start the database server.\n");
+        pthread_mutex_lock(&server->lock);
+        server->writer_exit = true;
+        pthread_cond_signal(&server->queued);
+        pthread_mutex_unlock(&server->lock);
+        pthread_join(server->writer_thread, NULL);
+        close(server->listen_fd);
+        unlink(server->path);
+        pthread_mutex_destroy(&server->lock);
+        pthread_mutex_destroy(&server->user_lock);
+        pthread_cond_destroy(&server->queued);
+        pthread_cond_destroy(&server->done);
+        free(server);
+        return NULL;
+    }
+    return server;
+}
+
+void db_server_get_stats(struct db_server *server, struct db_server_stats *stats) {
+    pthread_mutex_lock(&server->lock);
+    *stats = server->stats;
+    pthread_mutex_unlock(&server->lock);
+}
+
+void db_server_stop(struct db_server *server) {
+    if (!server) {
+        return;
+    }
+
+    // Shutting the listening socket down wakes accept() up
+    atomic_store(&server->stopping, true);
+    shutdown(server->listen_fd, SHUT_RDWR);
+    pthread_join(server->accept_thread, NULL);
+    close(server->listen_fd);
+    unlink(server->path);
+
+    // The clients waiting for a commit get it before their thread sees the shutdown
+    server_reap_clients(server, true);
+
+    pthread_mutex_lock(&server->lock);
+    server->writer_exit = true;
+    pthread_cond_signal(&server->queued);
+    pthread_mutex_unlock(&server->lock);
+    pthread_join(server->writer_thread, NULL);
+
+    server_flush_logins(server, true);
+
+    pthread_mutex_destroy(&server->lock);
+    pthread_mutex_destroy(&server->user_lock);
+    pthread_cond_destroy(&server->queued);
+    pthread_cond_destroy(&server->done);
+    free(server);
+}
+
+#endif
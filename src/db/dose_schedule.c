@@ -0,0 +1,311 @@
+/**
+ * @file dose_schedule.c
+ * @brief Dose reminders implementation
+ */
+#include "db/dose_schedule.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "db/medication_db.h"
+#include "utils/utils_intmap.h"
+#include "utils/utils_timerwheel.h"
+
+struct dose_entry {
+    struct medication_schedule schedule;
+    int timer; // Timer of the next dose, -1 if there is none
+    int due;   // Index in due, -1 if no reminder
+};
+
+struct dose_schedule {
+    // Schedules, removal swaps in the last one
+    struct dose_entry *entries;
+    int entry_count;
+    int entry_capacity;
+    struct intmap entry_pos; // Schedule id -> position in entries
+
+    struct dose_reminder *due; // Unordered, removal swaps in the last one
+    int due_count;
+    int due_capacity;
+
+    struct timer_wheel wheel; // Payload is the schedule id
+    int64_t now;              // Last minute advanced to
+    unsigned version;
+};
+
+/**
+ * @internal
+ * @brief Last dose of the schedule at or before minute, -1 if none
+ */
+static int64_t dose_latest_at(const struct medication_schedule *schedule, int64_t minute) {
+    if (minute < schedule->first_minute) {
+        return -1;
+    }
+    if (schedule->interval_minutes <= 0) {
+        return schedule->first_minute;
+    }
+    int64_t doses = (minute - schedule->first_minute) / schedule->interval_minutes;
+    return schedule->first_minute + doses * schedule->interval_minutes;
+}
+
+/**
+ * @internal
+ * @brief First dose of the schedule after minute, -1 if none
+ */
+static int64_t dose_next_after(const struct medication_schedule *schedule, int64_t minute) {
+    if (minute < schedule->first_minute) {
+        return schedule->first_minute;
+    }
+    if (schedule->interval_minutes <= 0) {
+        return -1;
+    }
+    int64_t doses = (minute - schedule->first_minute) / schedule->interval_minutes + 1;
+    return schedule->first_minute + doses * schedule->interval_minutes;
+}
+
+static bool dose_set_due(struct dose_schedule *ds, int pos, int64_t due_minute) {
+    struct dose_entry *entry = &ds->entries[pos];
+    if (entry->due < 0) {
+        if (ds->due_count == ds->due_capacity) {
+            int capacity = ds->due_capacity ? ds->due_capacity * 2 : 16;
+            struct dose_reminder *due = realloc(ds->due, sizeof(*due) * (size_t)capacity);
+            if (!due) {
+                return false;
+            }
+            ds->due = due;
+            ds->due_capacity = capacity;
+        }
+        entry->due = ds->due_count++;
+    }
+
+    struct dose_reminder *reminder = &ds->due[entry->due];
+    reminder->schedule_id = entry->schedule.id;
+    memcpy(reminder->cpf, entry->schedule.cpf, sizeof(reminder->cpf));
+    reminder->medication_id = entry->schedule.medication_id;
+    reminder->quantity = entry->schedule.quantity;
+    reminder->due_minute = due_minute;
+    ds->version++;
+    return true;
+}
+
+static void dose_clear_due(struct dose_schedule *ds, int pos) {
+    int index = ds->entries[pos].due;
+    if (index < 0) {
+        return;
+    }
+
+    ds->entries[pos].due = -1;
+    ds->due_count--;
+    if (index != ds->due_count) {
+        ds->due[index] = ds->due[ds->due_count];
+        int moved = intmap_get(&ds->entry_pos, ds->due[index].schedule_id);
+        ds->entries[moved].due = index;
+    }
+    ds->version++;
+}
+
+/**
+ * @internal
+ * @brief Brings the schedule up to ds->now: reminds of the latest dose not given and sets the timer of the next
+ *
+ * Doses missed in between (the app was closed) collapse into the latest one.
+ */
+static bool dose_refresh(struct dose_schedule *ds, int pos) {
+    struct dose_entry *entry = &ds->entries[pos];
+
+    int64_t latest = dose_latest_at(&entry->schedule, ds->now);
+    if (latest >= 0 && latest > entry->schedule.given_minute && !dose_set_due(ds, pos, latest)) {
+        return false;
+    }
+
+    int64_t next = dose_next_after(&entry->schedule, ds->now);
+    entry->timer = next >= 0 ? timer_wheel_add(&ds->wheel, next, entry->schedule.id) : -1;
+    return next < 0 || entry->timer >= 0;
+}
+
+static void dose_on_timer(void *ctx, int id, int payload, int64_t expires) {
+    (void)id;
+    (void)expires;
+    struct dose_schedule *ds = ctx;
+    int pos = intmap_get(&ds->entry_pos, payload);
+    if (pos < 0) {
+        return;
+    }
+
+    ds->entries[pos].timer = -1;
+    if (!dose_refresh(ds, pos)) {
+        fprintf(stderr, "Memory allocation failed, reminder of schedule %d lost.\n", payload);
+    }
+}
+
+int64_t dose_schedule_now(void) {
+    return (int64_t)time(NULL) / 60;
+}
+
+static int dose_load_schedule(void *ctx, const struct medication_schedule *schedule) {
+    return dose_schedule_add(ctx, schedule) ? 0 : 1;
+}
+
+struct dose_schedule *dose_schedule_load(database *medication_db, int64_t now_minute) {
+    if (!db_is_init(medication_db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return NULL;
+    }
+
+    struct dose_schedule *ds = calloc(1, sizeof(*ds));
+    if (!ds) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    ds->now = now_minute;
+    timer_wheel_init(&ds->wheel, now_minute);
+
+    // The callback stops the query on failure, so fewer schedules are kept than visited
+    int count = medication_db_schedules(medication_db, dose_load_schedule, ds);
+    if (count < 0 || count != ds->entry_count) {
+        fprintf(stderr, "Failed to load dose schedules.\n");
+        dose_schedule_free(ds);
+        return NULL;
+    }
+
+    return ds;
+}
+
+bool dose_schedule_add(struct dose_schedule *ds, const struct medication_schedule *schedule) {
+    if (intmap_get(&ds->entry_pos, schedule->id) >= 0) {
+        return false;
+    }
+
+    if (ds->entry_count == ds->entry_capacity) {
+        int capacity = ds->entry_capacity ? ds->entry_capacity * 2 : 32;
+        struct dose_entry *entries = realloc(ds->entries, sizeof(*entries) * (size_t)capacity);
+        if (!entries) {
+            return false;
+        }
+        ds->entries = entries;
+        ds->entry_capacity = capacity;
+    }
+
+    int pos = ds->entry_count;
+    if (!intmap_put(&ds->entry_pos, schedule->id, pos)) {
+        return false;
+    }
+
+    ds->entries[pos].schedule = *schedule;
+    ds->entries[pos].timer = -1;
+    ds->entries[pos].due = -1;
+    ds->entry_count++;
+    ds->version++;
+
+    if (!dose_refresh(ds, pos)) {
+        dose_schedule_remove(ds, schedule->id);
+        return false;
+    }
+    return true;
+}
+
+void dose_schedule_remove(struct dose_schedule *ds, int schedule_id) {
+    int pos = intmap_get(&ds->entry_pos, schedule_id);
+    if (pos < 0) {
+        return;
+    }
+
+    dose_clear_due(ds, pos);
+    timer_wheel_cancel(&ds->wheel, ds->entries[pos].timer);
+    intmap_remove(&ds->entry_pos, schedule_id);
+
+    ds->entry_count--;
+    if (pos != ds->entry_count) {
+        ds->entries[pos] = ds->entries[ds->entry_count];
+        intmap_put(&ds->entry_pos, ds->entries[pos].schedule.id, pos); // Key exists, no allocation
+    }
+    ds->version++;
+}
+
+void dose_schedule_remove_medication(struct dose_schedule *ds, int medication_id) {
+    for (int pos = ds->entry_count - 1; pos >= 0; pos--) {
+        if (ds->entries[pos].schedule.medication_id == medication_id) {
+            dose_schedule_remove(ds, ds->entries[pos].schedule.id);
+        }
+    }
+}
+
+int dose_schedule_advance(struct dose_schedule *ds, int64_t now_minute) {
+    if (now_minute <= ds->now) {
+        return 0;
+    }
+
+    ds->now = now_minute; // Set first, the timer callback schedules from it
+    return timer_wheel_advance(&ds->wheel, now_minute, dose_on_timer, ds);
+}
+
+int dose_schedule_due_count(const struct dose_schedule *ds) {
+    return ds->due_count;
+}
+
+static int dose_reminder_compare(const void *a, const void *b) {
+    const struct dose_reminder *ra = a;
+    const struct dose_reminder *rb = b;
+    if (ra->due_minute != rb->due_minute) {
+        return ra->due_minute < rb->due_minute ? -1 : 1;
+    }
+    return (ra->schedule_id > rb->schedule_id) - (ra->schedule_id < rb->schedule_id);
+}
+
+int dose_schedule_due(const struct dose_schedule *ds, struct dose_reminder *out, int max) {
+    if (max <= 0 || ds->due_count == 0) {
+        return 0;
+    }
+
+    if (ds->due_count <= max) {
+        memcpy(out, ds->due, sizeof(*out) * (size_t)ds->due_count);
+        qsort(out, (size_t)ds->due_count, sizeof(*out), dose_reminder_compare);
+        return ds->due_count;
+    }
+
+    struct dose_reminder *sorted = malloc(sizeof(*sorted) * (size_t)ds->due_count);
+    if (!sorted) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 0;
+    }
+    memcpy(sorted, ds->due, sizeof(*sorted) * (size_t)ds->due_count);
+    qsort(sorted, (size_t)ds->due_count, sizeof(*sorted), dose_reminder_compare);
+    memcpy(out, sorted, sizeof(*out) * (size_t)max);
+    free(sorted);
+    return max;
+}
+
+int64_t dose_schedule_acknowledge(struct dose_schedule *ds, int schedule_id) {
+    int pos = intmap_get(&ds->entry_pos, schedule_id);
+    if (pos < 0 || ds->entries[pos].due < 0) {
+        return -1;
+    }
+
+    int64_t due_minute = ds->due[ds->entries[pos].due].due_minute;
+    ds->entries[pos].schedule.given_minute = due_minute;
+    dose_clear_due(ds, pos);
+    return due_minute;
+}
+
+int dose_schedule_count(const struct dose_schedule *ds) {
+    return ds->entry_count;
+}
+
+unsigned dose_schedule_version(const struct dose_schedule *ds) {
+    return ds->version;
+}
+
+void dose_schedule_free(struct dose_schedule *ds) {
+    if (!ds) {
+        return;
+    }
+
+    free(ds->entries);
+    free(ds->due);
+    intmap_free(&ds->entry_pos);
+    timer_wheel_free(&ds->wheel);
+    free(ds);
+}
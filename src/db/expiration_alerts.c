@@ -0,0 +1,490 @@
+/**
+ * @file expiration_alerts.c
+ * @brief Expiration alerts implementation
+ */
+#include "db/expiration_alerts.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/db_changes.h"
+#include "db/foodbatch_db.h"
+#include "utils/utils_date.h"
+#include "utils/utils_intmap.h"
+
+// Items live in slots that never move, the heap and the lookup map only hold slot indices,
+// so sifting moves ints instead of whole alerts
+struct expiration_slot {
+    struct expiration_alert alert;
+    int heap_pos; // Position in the heap, -1 when the slot is free
+};
+
+struct expiration_alerts {
+    struct expiration_slot *slots;
+    int slot_count;    // Slots used so far (free ones included)
+    int slot_capacity;
+    int *free_slots;   // Stack of freed slot indices
+    int free_count;
+
+    int *heap; // Slot indices, min-heap by expiration day
+    int heap_count;
+
+    struct intmap lookup; // alerts_key(source, id) -> slot index
+
+    database *foodbatch_db;   // Read again on FoodBatch changes, NULL when food is not loaded
+    int changes_subscription; // FoodBatch subscription (db_changes.h), 0 if none
+
+    unsigned version;
+};
+
+static bool alerts_load_food(struct expiration_alerts *ea);
+
+static bool alerts_load_query(struct expiration_alerts *ea, database *db, enum expiration_source source, const char *sql);
+
+static void alerts_on_foodbatch_change(const struct db_change *change, void *ctx);
+
+static int64_t alerts_key(enum expiration_source source, int id) {
+    return ((int64_t)source << 32) | (uint32_t)id;
+}
+
+static bool alerts_before(const struct expiration_alerts *ea, int a, int b) {
+    const struct expiration_alert *x = &ea->slots[a].alert;
+    const struct expiration_alert *y = &ea->slots[b].alert;
+    if (x->day != y->day) {
+        return x->day < y->day;
+    }
+    if (x->source != y->source) {
+        return x->source < y->source;
+    }
+    return x->id < y->id;
+}
+
+static void alerts_heap_place(struct expiration_alerts *ea, int pos, int slot) {
+    ea->heap[pos] = slot;
+    ea->slots[slot].heap_pos = pos;
+}
+
+static void alerts_sift_up(struct expiration_alerts *ea, int pos) {
+    int slot = ea->heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!alerts_before(ea, slot, ea->heap[parent])) {
+            break;
+        }
+        alerts_heap_place(ea, pos, ea->heap[parent]);
+        pos = parent;
+    }
+    alerts_heap_place(ea, pos, slot);
+}
+
+static void alerts_sift_down(struct expiration_alerts *ea, int pos) {
+    int slot = ea->heap[pos];
+    for (;;) {
+        int child = pos * 2 + 1;
+        if (child >= ea->heap_count) {
+            break;
+        }
+        if (child + 1 < ea->heap_count && alerts_before(ea, ea->heap[child + 1], ea->heap[child])) {
+            child++;
+        }
+        if (!alerts_before(ea, ea->heap[child], slot)) {
+            break;
+        }
+        alerts_heap_place(ea, pos, ea->heap[child]);
+        pos = child;
+    }
+    alerts_heap_place(ea, pos, slot);
+}
+
+static int alerts_new_slot(struct expiration_alerts *ea) {
+    if (ea->free_count > 0) {
+        return ea->free_slots[--ea->free_count];
+    }
+
+    if (ea->slot_count == ea->slot_capacity) {
+        int capacity = ea->slot_capacity ? ea->slot_capacity * 2 : 64;
+
+        struct expiration_slot *slots = realloc(ea->slots, sizeof(*slots) * (size_t)capacity);
+        if (!slots) {
+            return -1;
+        }
+        ea->slots = slots;
+
+        int *heap = realloc(ea->heap, sizeof(int) * (size_t)capacity);
+        if (!heap) {
+            return -1;
+        }
+        ea->heap = heap;
+
+        int *free_slots = realloc(ea->free_slots, sizeof(int) * (size_t)capacity);
+        if (!free_slots) {
+            return -1;
+        }
+        ea->free_slots = free_slots;
+
+        ea->slot_capacity = capacity;
+    }
+
+    return ea->slot_count++;
+}
+
+struct expiration_alerts *expiration_alerts_load(database *foodbatch_db, database *medication_db) {
+    struct expiration_alerts *ea = calloc(1, sizeof(*ea));
+    if (!ea) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    // Both walk the ExpirationDate index in order, so most inserts land at the bottom of the heap
+    // without sifting
+    bool ok = true;
+    if (foodbatch_db) {
+        ea->foodbatch_db = foodbatch_db;
+        ok = alerts_load_food(ea);
+        if (ok) {
+            ea->changes_subscription = db_changes_subscribe("FoodBatch", alerts_on_foodbatch_change, ea);
+        }
+    }
+    if (ok && medication_db) {
+        ok = alerts_load_query(
+            ea,
+            medication_db,
+            EXPIRATION_MEDICATION,
+            "SELECT ID, Name, ExpirationDate FROM Medications "
+            "WHERE ExpirationDate IS NOT NULL AND Stock > 0 ORDER BY ExpirationDate;"
+        );
+    }
+
+    if (!ok) {
+        expiration_alerts_free(ea);
+        return NULL;
+    }
+
+    return ea;
+}
+
+struct alerts_food_load {
+    struct expiration_alerts *ea;
+    bool failed;
+};
+
+/**
+ * @internal
+ * @brief Adds a dated batch following the load rules (foodbatch_db_expiring_between() callback)
+ */
+static int alerts_add_foodbatch(void *ctx, const struct foodbatch *foodbatch) {
+    struct alerts_food_load *load = ctx;
+    if (!expiration_alerts_sync_foodbatch(load->ea, foodbatch)) {
+        load->failed = true;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Adds the perishable batches in stock of ea->foodbatch_db
+ *
+ * Goes through foodbatch_db_expiring_between(), so a database served by another process loads
+ * the same way.
+ */
+static bool alerts_load_food(struct expiration_alerts *ea) {
+    struct alerts_food_load load = { ea, false };
+    int found =
+        foodbatch_db_expiring_between(ea->foodbatch_db, DATE_INVALID + 1, INT32_MAX, alerts_add_foodbatch, &load);
+    if (found < 0 || load.failed) {
+        fprintf(stderr, "Failed to load food expiration dates.\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Removes every food batch and loads them again, after a FoodBatch reset
+ */
+static void alerts_reload_food(struct expiration_alerts *ea) {
+    int *ids = malloc(sizeof(int) * (size_t)(ea->heap_count + 1));
+    if (!ids) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    // Collected first, removing reorders the heap
+    int count = 0;
+    for (int pos = 0; pos < ea->heap_count; pos++) {
+        const struct expiration_alert *alert = &ea->slots[ea->heap[pos]].alert;
+        if (alert->source == EXPIRATION_FOOD) {
+            ids[count++] = alert->id;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        expiration_alerts_remove(ea, EXPIRATION_FOOD, ids[i]);
+    }
+    free(ids);
+
+    alerts_load_food(ea);
+}
+
+/**
+ * @internal
+ * @brief Follows a committed FoodBatch change (db_changes_dispatch() callback)
+ *
+ * A changed batch is read again, O(log n) like the screens reporting it did. A reset reloads
+ * the food batches.
+ */
+static void alerts_on_foodbatch_change(const struct db_change *change, void *ctx) {
+    struct expiration_alerts *ea = ctx;
+    if (change->op == DB_CHANGE_RESET) {
+        alerts_reload_food(ea);
+        return;
+    }
+
+    int batch_id = (int)change->rowid;
+    struct foodbatch foodbatch;
+    if (change->op == DB_CHANGE_DELETE
+        || foodbatch_db_get_by_batchid(ea->foodbatch_db, batch_id, &foodbatch) != SQLITE_OK) {
+        expiration_alerts_remove(ea, EXPIRATION_FOOD, batch_id);
+        return;
+    }
+    if (!expiration_alerts_sync_foodbatch(ea, &foodbatch)) {
+        fprintf(stderr, "Failed to update expiration alerts for batch %d.\n", batch_id);
+    }
+}
+
+/**
+ * @internal
+ * @brief Adds the (id, name, day) rows returned by sql
+ */
+static bool alerts_load_query(struct expiration_alerts *ea, database *db, enum expiration_source source, const char *sql) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return false;
+    }
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *name = (const char *)sqlite3_column_text(stmt, 1);
+        if (!expiration_alerts_set(ea, source, sqlite3_column_int(stmt, 0), name ? name : "", db_column_day(stmt, 2))) {
+            rc = SQLITE_NOMEM;
+            break;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to load expiration dates: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+    return true;
+}
+
+bool expiration_alerts_set(
+    struct expiration_alerts *ea,
+    enum expiration_source source,
+    int id,
+    const char *name,
+    int32_t day
+) {
+    if (day == DATE_INVALID) {
+        expiration_alerts_remove(ea, source, id);
+        return true;
+    }
+
+    int slot = intmap_get(&ea->lookup, alerts_key(source, id));
+
+    if (slot >= 0) {
+        struct expiration_alert *alert = &ea->slots[slot].alert;
+        snprintf(alert->name, sizeof(alert->name), "%s", name ? name : "");
+        int32_t old_day = alert->day;
+        alert->day = day;
+        if (day < old_day) {
+            alerts_sift_up(ea, ea->slots[slot].heap_pos);
+        } else if (day > old_day) {
+            alerts_sift_down(ea, ea->slots[slot].heap_pos);
+        }
+        ea->version++;
+        return true;
+    }
+
+    slot = alerts_new_slot(ea);
+    if (slot < 0) {
+        return false;
+    }
+    if (!intmap_put(&ea->lookup, alerts_key(source, id), slot)) {
+        ea->free_slots[ea->free_count++] = slot;
+        return false;
+    }
+
+    struct expiration_alert *alert = &ea->slots[slot].alert;
+    alert->source = source;
+    alert->id = id;
+    alert->day = day;
+    snprintf(alert->name, sizeof(alert->name), "%s", name ? name : "");
+
+    alerts_heap_place(ea, ea->heap_count++, slot);
+    alerts_sift_up(ea, ea->heap_count - 1);
+    ea->version++;
+    return true;
+}
+
+bool expiration_alerts_sync_foodbatch(struct expiration_alerts *ea, const struct foodbatch *foodbatch) {
+    if (!foodbatch->is_perishable || foodbatch->quantity <= 0) {
+        expiration_alerts_remove(ea, EXPIRATION_FOOD, foodbatch->batch_id);
+        return true;
+    }
+    return expiration_alerts_set(ea, EXPIRATION_FOOD, foodbatch->batch_id, foodbatch->name, foodbatch->expiration_day);
+}
+
+bool expiration_alerts_sync_medication(struct expiration_alerts *ea, const struct medication *medication) {
+    if (medication->stock <= 0) {
+        expiration_alerts_remove(ea, EXPIRATION_MEDICATION, medication->id);
+        return true;
+    }
+    return expiration_alerts_set(ea, EXPIRATION_MEDICATION, medication->id, medication->name, medication->expiration_day);
+}
+
+void expiration_alerts_remove(struct expiration_alerts *ea, enum expiration_source source, int id) {
+    int slot = intmap_remove(&ea->lookup, alerts_key(source, id));
+    if (slot < 0) {
+        return;
+    }
+
+    // Fill the hole with the last heap entry and restore the order in whichever direction it breaks
+    int heap_pos = ea->slots[slot].heap_pos;
+    int last = ea->heap[--ea->heap_count];
+    if (heap_pos < ea->heap_count) {
+        alerts_heap_place(ea, heap_pos, last);
+        alerts_sift_up(ea, heap_pos);
+        alerts_sift_down(ea, ea->slots[last].heap_pos);
+    }
+
+    ea->slots[slot].heap_pos = -1;
+    ea->free_slots[ea->free_count++] = slot;
+    ea->version++;
+}
+
+const struct expiration_alert *expiration_alerts_next(const struct expiration_alerts *ea) {
+    return ea->heap_count > 0 ? &ea->slots[ea->heap[0]].alert : NULL;
+}
+
+/**
+ * @internal
+ * @brief Visits the due entries of the subtree at pos, skipping subtrees whose root is not due
+ *
+ * @return Number of due entries, the first ones are written to out while there is room
+ */
+static int alerts_collect_due(
+    const struct expiration_alerts *ea,
+    int pos,
+    int32_t until_day,
+    struct expiration_alert *out,
+    int max,
+    int found
+) {
+    if (pos >= ea->heap_count || ea->slots[ea->heap[pos]].alert.day > until_day) {
+        return found;
+    }
+
+    if (out && found < max) {
+        out[found] = ea->slots[ea->heap[pos]].alert;
+    }
+    found++;
+
+    found = alerts_collect_due(ea, pos * 2 + 1, until_day, out, max, found);
+    return alerts_collect_due(ea, pos * 2 + 2, until_day, out, max, found);
+}
+
+int expiration_alerts_count_due(const struct expiration_alerts *ea, int32_t until_day) {
+    return alerts_collect_due(ea, 0, until_day, NULL, 0, 0);
+}
+
+static int alerts_compare_day(const void *a, const void *b) {
+    const struct expiration_alert *x = a;
+    const struct expiration_alert *y = b;
+    if (x->day != y->day) {
+        return x->day < y->day ? -1 : 1;
+    }
+    if (x->source != y->source) {
+        return x->source < y->source ? -1 : 1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+int expiration_alerts_due(
+    const struct expiration_alerts *ea,
+    int32_t until_day,
+    struct expiration_alert *out,
+    int max
+) {
+    if (!out || max <= 0) {
+        return 0;
+    }
+
+    int due = expiration_alerts_count_due(ea, until_day);
+    if (due <= max) {
+        alerts_collect_due(ea, 0, until_day, out, max, 0);
+        qsort(out, (size_t)due, sizeof(*out), alerts_compare_day);
+        return due;
+    }
+
+    // More due items than room: partial heap sort on a scratch copy, the set itself is not modified
+    int *heap = malloc(sizeof(int) * (size_t)ea->heap_count);
+    if (!heap) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 0;
+    }
+
+    memcpy(heap, ea->heap, sizeof(int) * (size_t)ea->heap_count);
+    int count = ea->heap_count;
+    int written = 0;
+    while (written < max && count > 0) {
+        out[written++] = ea->slots[heap[0]].alert;
+
+        int slot = heap[--count];
+        int pos = 0;
+        for (;;) {
+            int child = pos * 2 + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && alerts_before(ea, heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!alerts_before(ea, heap[child], slot)) {
+                break;
+            }
+            heap[pos] = heap[child];
+            pos = child;
+        }
+        heap[pos] = slot;
+    }
+
+    free(heap);
+    return written;
+}
+
+unsigned expiration_alerts_version(const struct expiration_alerts *ea) {
+    return ea->version;
+}
+
+void expiration_alerts_free(struct expiration_alerts *ea) {
+    if (!ea) {
+        return;
+    }
+
+    db_changes_unsubscribe(ea->changes_subscription);
+    free(ea->slots);
+    free(ea->heap);
+    free(ea->free_slots);
+    intmap_free(&ea->lookup);
+    free(ea);
+}
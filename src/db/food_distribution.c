@@ -0,0 +1,374 @@
+/**
+ * @file food_distribution.c
+ * @brief FEFO distribution planner implementation
+ */
+#include "db/food_distribution.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/db_client.h"
+#include "db/foodbatch_db.h"
+#include "utils/utils_date.h"
+#include "utils/utils_intmap.h"
+#include "utils/utils_name.h"
+
+// Heap key of batches that do not expire, after every real day
+#define PLAN_NEVER_EXPIRES INT32_MAX
+
+struct plan_batch {
+    int32_t key; // Expiration day, PLAN_NEVER_EXPIRES for batches without one
+    int batch_id;
+    int remaining;
+    int queue; // Index of the first request with the batch name
+};
+
+static bool plan_batch_before(const struct plan_batch *a, const struct plan_batch *b) {
+    if (a->key != b->key) {
+        return a->key < b->key;
+    }
+    return a->batch_id < b->batch_id;
+}
+
+static void plan_sift_down(struct plan_batch *heap, int count, int pos) {
+    struct plan_batch batch = heap[pos];
+    for (;;) {
+        int child = pos * 2 + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && plan_batch_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!plan_batch_before(&heap[child], &batch)) {
+            break;
+        }
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = batch;
+}
+
+/**
+ * @internal
+ * @brief Batches read so far, filled by plan_collect_batch()
+ */
+struct plan_load {
+    const struct intmap *queues;
+    int32_t today;
+    struct plan_batch *batches;
+    int count;
+    int capacity;
+    bool failed; // Allocation failed
+};
+
+/**
+ * @internal
+ * @brief foodbatch_callback, keeps a batch whose name was requested, tagged with the queue it goes to
+ */
+static int plan_collect_batch(void *ctx, const struct foodbatch *foodbatch) {
+    struct plan_load *load = ctx;
+    int queue = intmap_get(load->queues, (int64_t)name_hash(foodbatch->name));
+    if (queue < 0) {
+        return 0; // Not requested
+    }
+
+    int32_t day = foodbatch->expiration_day;
+    bool dated = foodbatch->is_perishable && day != DATE_INVALID;
+    if (dated && load->today != DATE_INVALID && day < load->today) {
+        return 0; // Expired, never handed out
+    }
+
+    if (load->count == load->capacity) {
+        int capacity = load->capacity ? load->capacity * 2 : 64;
+        struct plan_batch *grown = realloc(load->batches, sizeof(*grown) * (size_t)capacity);
+        if (!grown) {
+            load->failed = true;
+            return 1;
+        }
+        load->batches = grown;
+        load->capacity = capacity;
+    }
+
+    struct plan_batch *batch = &load->batches[load->count++];
+    batch->key = dated ? day : PLAN_NEVER_EXPIRES;
+    batch->batch_id = foodbatch->batch_id;
+    batch->remaining = foodbatch->quantity;
+    batch->queue = queue;
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Reads the batches in stock whose name was requested
+ *
+ * Goes through foodbatch_db_in_stock(), so a database served by another process plans the same way.
+ *
+ * @return Number of batches, -1 on failure or -2 out of memory (*out is NULL)
+ */
+static int plan_load_batches(database *db, const struct intmap *queues, int32_t today, struct plan_batch **out) {
+    struct plan_load load = { .queues = queues, .today = today };
+    int rc = foodbatch_db_in_stock(db, plan_collect_batch, &load);
+    if (rc < 0 || load.failed) {
+        free(load.batches);
+        *out = NULL;
+        return load.failed ? -2 : -1;
+    }
+
+    *out = load.batches;
+    return load.count;
+}
+
+int food_plan_build(
+    database *db,
+    const struct food_request *requests,
+    int request_count,
+    int32_t today,
+    struct food_plan *plan
+) {
+    if (!db_is_remote(db) && !db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    food_plan_free(plan);
+    if (request_count <= 0) {
+        return SQLITE_OK;
+    }
+
+    int rc = SQLITE_NOMEM;
+    struct intmap queues = { 0 };
+    int *queue_of = malloc(sizeof(int) * (size_t)request_count);   // Request -> queue (first request of the name)
+    int *queue_start = malloc(sizeof(int) * (size_t)request_count); // Queue -> start of its heap in batches
+    int *queue_count = calloc((size_t)request_count, sizeof(int));  // Queue -> batches in its heap
+    struct plan_batch *batches = NULL;
+    struct plan_batch *heaps = NULL;
+
+    plan->allocated = calloc((size_t)request_count, sizeof(int));
+    plan->request_count = request_count;
+    if (!queue_of || !queue_start || !queue_count || !plan->allocated || !intmap_init(&queues, (size_t)request_count)) {
+        goto cleanup;
+    }
+
+    for (int i = 0; i < request_count; i++) {
+        int64_t key = (int64_t)name_hash(requests[i].name);
+        int queue = intmap_get(&queues, key);
+        if (queue < 0) {
+            queue = i;
+            if (!intmap_put(&queues, key, queue)) {
+                goto cleanup;
+            }
+        }
+        queue_of[i] = queue;
+        plan->requested_total += requests[i].quantity > 0 ? requests[i].quantity : 0;
+    }
+
+    int batch_count = plan_load_batches(db, &queues, today, &batches);
+    if (batch_count < 0) {
+        rc = batch_count == -2 ? SQLITE_NOMEM : SQLITE_ERROR;
+        goto cleanup;
+    }
+
+    // Counting sort by queue so each queue is one contiguous heap, then heapify each in O(n)
+    heaps = malloc(sizeof(*heaps) * (size_t)(batch_count > 0 ? batch_count : 1));
+    plan->picks = malloc(sizeof(*plan->picks) * (size_t)(batch_count + request_count));
+    if (!heaps || !plan->picks) {
+        goto cleanup;
+    }
+
+    for (int i = 0; i < batch_count; i++) {
+        queue_count[batches[i].queue]++;
+    }
+    for (int q = 0, start = 0; q < request_count; q++) {
+        queue_start[q] = start;
+        start += queue_count[q];
+        queue_count[q] = 0;
+    }
+    for (int i = 0; i < batch_count; i++) {
+        int q = batches[i].queue;
+        heaps[queue_start[q] + queue_count[q]++] = batches[i];
+    }
+    for (int q = 0; q < request_count; q++) {
+        for (int pos = queue_count[q] / 2 - 1; pos >= 0; pos--) {
+            plan_sift_down(heaps + queue_start[q], queue_count[q], pos);
+        }
+    }
+
+    // Serve each request from the soonest expiring batches of its name
+    for (int i = 0; i < request_count; i++) {
+        int q = queue_of[i];
+        struct plan_batch *heap = heaps + queue_start[q];
+        int need = requests[i].quantity;
+
+        while (need > 0 && queue_count[q] > 0) {
+            int take = heap[0].remaining < need ? heap[0].remaining : need;
+            heap[0].remaining -= take;
+            need -= take;
+
+            struct food_pick *pick = &plan->picks[plan->pick_count++];
+            pick->batch_id = heap[0].batch_id;
+            pick->request = i;
+            pick->expiration_day = heap[0].key == PLAN_NEVER_EXPIRES ? DATE_INVALID : heap[0].key;
+            pick->quantity = take;
+            pick->remaining = heap[0].remaining;
+
+            plan->allocated[i] += take;
+            plan->allocated_total += take;
+
+            if (heap[0].remaining == 0) {
+                heap[0] = heap[--queue_count[q]];
+                plan_sift_down(heap, queue_count[q], 0);
+            }
+        }
+    }
+
+    rc = SQLITE_OK;
+
+cleanup:
+    if (rc == SQLITE_NOMEM) {
+        fprintf(stderr, "Memory allocation failed.\n");
+    }
+    if (rc != SQLITE_OK) {
+        food_plan_free(plan);
+    }
+    intmap_free(&queues);
+    free(queue_of);
+    free(queue_start);
+    free(queue_count);
+    free(batches);
+    free(heaps);
+    return rc;
+}
+
+int food_plan_apply(database *db, const struct food_plan *plan) {
+    if (db_is_remote(db)) {
+        return db_client_food_plan_apply(db->remote, plan);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (plan->pick_count == 0) {
+        return SQLITE_OK;
+    }
+
+    // IMMEDIATE takes the write lock up front, so no other writer can interleave with the picks.
+    // Inside a transaction already (the group commit of db_server.c), a savepoint does the same.
+    bool nested = !sqlite3_get_autocommit(db->db);
+    int rc = sqlite3_exec(db->db, nested ? "SAVEPOINT plan;" : "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+    const char *rollback = nested ? "ROLLBACK TO plan; RELEASE plan;" : "ROLLBACK;";
+
+    for (int i = 0; i < plan->pick_count; i++) {
+        const struct food_pick *pick = &plan->picks[i];
+        rc = foodbatch_db_take_quantity(db, pick->batch_id, pick->quantity);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Batch %d no longer holds %d, distribution not applied.\n", pick->batch_id, pick->quantity);
+            sqlite3_exec(db->db, rollback, 0, 0, 0);
+            return rc;
+        }
+    }
+
+    rc = sqlite3_exec(db->db, nested ? "RELEASE plan;" : "COMMIT;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to commit distribution: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_exec(db->db, rollback, 0, 0, 0);
+    }
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Appends text to the buffer
+ *
+ * @return false if it does not fit
+ */
+static bool plan_append(char *buffer, size_t buffer_size, size_t *written, const char *text) {
+    size_t len = strlen(text);
+    if (*written + len >= buffer_size) {
+        return false;
+    }
+    memcpy(buffer + *written, text, len + 1);
+    *written += len;
+    return true;
+}
+
+int food_plan_format(const struct food_plan *plan, const struct food_request *requests, char *buffer, size_t buffer_size) {
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    size_t written = 0;
+    char line[512];
+
+    snprintf(
+        line,
+        sizeof(line),
+        "Pick list: %d picks, %ld of %ld requested\n"
+        "+------------------------------------------------------------------------------------+\n"
+        "| BatchId | Name                             | Expiration date | Take     | Left     |\n"
+        "+---------+----------------------------------+-----------------+----------+----------+\n",
+        plan->pick_count,
+        plan->allocated_total,
+        plan->requested_total
+    );
+    if (!plan_append(buffer, buffer_size, &written, line)) {
+        fprintf(stderr, "Header truncated\n");
+        return -1;
+    }
+
+    for (int i = 0; i < plan->pick_count; i++) {
+        const struct food_pick *pick = &plan->picks[i];
+        char expiration_date[DATE_STR_LEN];
+        date_format(pick->expiration_day, expiration_date);
+
+        snprintf(
+            line,
+            sizeof(line),
+            "| %7d | %-32.32s | %-15s | %-8d | %-8d |\n",
+            pick->batch_id,
+            requests[pick->request].name,
+            expiration_date[0] ? expiration_date : "-",
+            pick->quantity,
+            pick->remaining
+        );
+        if (!plan_append(buffer, buffer_size, &written, line)) {
+            fprintf(stderr, "Pick list truncated\n");
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < plan->request_count; i++) {
+        if (requests[i].quantity <= plan->allocated[i]) {
+            continue;
+        }
+        snprintf(
+            line,
+            sizeof(line),
+            "Short: %.64s, %d of %d\n",
+            requests[i].name,
+            plan->allocated[i],
+            requests[i].quantity
+        );
+        if (!plan_append(buffer, buffer_size, &written, line)) {
+            fprintf(stderr, "Pick list truncated\n");
+            return -1;
+        }
+    }
+
+    return (int)written;
+}
+
+void food_plan_free(struct food_plan *plan) {
+    free(plan->picks);
+    free(plan->allocated);
+    memset(plan, 0, sizeof(*plan));
+}
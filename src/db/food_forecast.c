@@ -0,0 +1,461 @@
+/**
+ * @file food_forecast.c
+ * @brief Food run-out forecasting implementation
+ */
+#include "db/food_forecast.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/db_changes.h"
+#include "db/foodbatch_db.h"
+#include "db/resident_db.h"
+#include "utils/utils_date.h"
+#include "utils/utils_intmap.h"
+#include "utils/utils_name.h"
+
+// Projections further away than this are reported as never running out
+#define FORECAST_MAX_DAYS 3650000.0f
+
+struct forecast_name_entry {
+    struct food_forecast_name info; // days is only filled when copied out
+    double rate_quantity;           // Sum of rate * quantity of the name's batches
+};
+
+struct food_forecast {
+    // Batches in stock, packed: position i of each array is the same batch, removal swaps in the last one
+    float *quantity;
+    float *rate;
+    int *batch_id;
+    int *name_of; // Index in names
+    int batch_count;
+    int batch_capacity;
+    struct intmap batch_pos; // BatchId -> position
+
+    struct forecast_name_entry *names;
+    int name_count;
+    int name_capacity;
+    struct intmap name_index; // Hash of the normalized name -> index in names
+
+    double pantry_quantity; // Sum of the quantity of every name
+    double pantry_rate;     // Sum of the daily rate per resident of every name
+    int residents;
+    bool residents_stale; // Residents were added or removed since the last count
+
+    database *foodbatch_db;     // Read again on FoodBatch changes
+    database *resident_db;      // Counted again by food_forecast_refresh(), NULL to keep the count set
+    int foodbatch_subscription; // FoodBatch subscription (db_changes.h), 0 if none
+    int resident_subscription;  // Resident subscription, 0 if none
+
+    unsigned version;
+};
+
+static void forecast_on_foodbatch_change(const struct db_change *change, void *ctx);
+
+static void forecast_on_resident_change(const struct db_change *change, void *ctx);
+
+static double forecast_name_rate(const struct forecast_name_entry *entry) {
+    return entry->info.quantity > 0 ? entry->rate_quantity / entry->info.quantity : 0.0;
+}
+
+static float forecast_days(double quantity, double rate, int residents) {
+    double consumption = rate * residents;
+    if (consumption <= 0.0) {
+        return INFINITY;
+    }
+    double days = quantity / consumption;
+    return days < FORECAST_MAX_DAYS ? (float)days : INFINITY;
+}
+
+static int forecast_find_or_add_name(struct food_forecast *ff, const char *name) {
+    int64_t hash = (int64_t)name_hash(name); // "Arroz" and "arroz" share a group
+    int index = intmap_get(&ff->name_index, hash);
+    if (index >= 0) {
+        return index;
+    }
+
+    if (ff->name_count == ff->name_capacity) {
+        int capacity = ff->name_capacity ? ff->name_capacity * 2 : 32;
+        struct forecast_name_entry *names = realloc(ff->names, sizeof(*names) * (size_t)capacity);
+        if (!names) {
+            return -1;
+        }
+        ff->names = names;
+        ff->name_capacity = capacity;
+    }
+
+    index = ff->name_count;
+    if (!intmap_put(&ff->name_index, hash, index)) {
+        return -1;
+    }
+
+    struct forecast_name_entry *entry = &ff->names[index];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->info.name, sizeof(entry->info.name), "%s", name);
+    ff->name_count++;
+    return index;
+}
+
+/**
+ * @internal
+ * @brief Adds (sign = 1) or takes out (sign = -1) the batch at pos from its name and the pantry totals
+ */
+static void forecast_account(struct food_forecast *ff, int pos, int sign) {
+    struct forecast_name_entry *entry = &ff->names[ff->name_of[pos]];
+    double old_rate = forecast_name_rate(entry);
+
+    entry->info.quantity += sign * (double)ff->quantity[pos];
+    entry->rate_quantity += sign * (double)ff->quantity[pos] * ff->rate[pos];
+    entry->info.batches += sign;
+    if (entry->info.batches == 0) {
+        // Drop the rounding left over by the additions and subtractions
+        entry->info.quantity = 0.0;
+        entry->rate_quantity = 0.0;
+    }
+
+    ff->pantry_quantity += sign * (double)ff->quantity[pos];
+    ff->pantry_rate += forecast_name_rate(entry) - old_rate;
+}
+
+static bool forecast_reserve_batches(struct food_forecast *ff) {
+    if (ff->batch_count < ff->batch_capacity) {
+        return true;
+    }
+
+    int capacity = ff->batch_capacity ? ff->batch_capacity * 2 : 64;
+
+    float *quantity = realloc(ff->quantity, sizeof(float) * (size_t)capacity);
+    if (!quantity) {
+        return false;
+    }
+    ff->quantity = quantity;
+
+    float *rate = realloc(ff->rate, sizeof(float) * (size_t)capacity);
+    if (!rate) {
+        return false;
+    }
+    ff->rate = rate;
+
+    int *batch_id = realloc(ff->batch_id, sizeof(int) * (size_t)capacity);
+    if (!batch_id) {
+        return false;
+    }
+    ff->batch_id = batch_id;
+
+    int *name_of = realloc(ff->name_of, sizeof(int) * (size_t)capacity);
+    if (!name_of) {
+        return false;
+    }
+    ff->name_of = name_of;
+
+    ff->batch_capacity = capacity;
+    return true;
+}
+
+struct forecast_load {
+    struct food_forecast *ff;
+    bool failed;
+};
+
+/**
+ * @internal
+ * @brief Adds a batch in stock to the forecast (foodbatch_db_in_stock() callback)
+ */
+static int forecast_add_foodbatch(void *ctx, const struct foodbatch *foodbatch) {
+    struct forecast_load *load = ctx;
+    if (!food_forecast_set_batch(load->ff, foodbatch)) {
+        load->failed = true;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Adds every batch in stock of ff->foodbatch_db
+ *
+ * Goes through foodbatch_db_in_stock(), so a database served by another process loads the same way.
+ */
+static bool forecast_load_batches(struct food_forecast *ff) {
+    struct forecast_load load = { ff, false };
+    if (foodbatch_db_in_stock(ff->foodbatch_db, forecast_add_foodbatch, &load) < 0 || load.failed) {
+        fprintf(stderr, "Failed to load food forecast batches.\n");
+        return false;
+    }
+    return true;
+}
+
+struct food_forecast *food_forecast_load(database *foodbatch_db, database *resident_db) {
+    struct food_forecast *ff = calloc(1, sizeof(*ff));
+    if (!ff) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    ff->foodbatch_db = foodbatch_db;
+    ff->resident_db = resident_db;
+    ff->residents_stale = resident_db != NULL;
+    food_forecast_refresh(ff);
+
+    if (!forecast_load_batches(ff)) {
+        food_forecast_free(ff);
+        return NULL;
+    }
+
+    ff->foodbatch_subscription = db_changes_subscribe("FoodBatch", forecast_on_foodbatch_change, ff);
+    if (resident_db) {
+        ff->resident_subscription = db_changes_subscribe("Resident", forecast_on_resident_change, ff);
+    }
+    return ff;
+}
+
+/**
+ * @internal
+ * @brief Follows a committed FoodBatch change (db_changes_dispatch() callback)
+ *
+ * The changed batch is read back, a reset drops every batch and loads the ones in stock again.
+ */
+static void forecast_on_foodbatch_change(const struct db_change *change, void *ctx) {
+    struct food_forecast *ff = ctx;
+    if (change->op == DB_CHANGE_RESET) {
+        while (ff->batch_count > 0) {
+            food_forecast_remove_batch(ff, ff->batch_id[ff->batch_count - 1]);
+        }
+        forecast_load_batches(ff);
+        return;
+    }
+
+    int batch_id = (int)change->rowid;
+    struct foodbatch foodbatch;
+    if (change->op == DB_CHANGE_DELETE
+        || foodbatch_db_get_by_batchid(ff->foodbatch_db, batch_id, &foodbatch) != SQLITE_OK) {
+        food_forecast_remove_batch(ff, batch_id);
+        return;
+    }
+    if (!food_forecast_set_batch(ff, &foodbatch)) {
+        fprintf(stderr, "Failed to update food forecast for batch %d.\n", batch_id);
+    }
+}
+
+/**
+ * @internal
+ * @brief Marks the resident count stale after residents were added or removed (db_changes_dispatch() callback)
+ *
+ * Counting is left to food_forecast_refresh(): a bulk import delivers up to DB_CHANGES_MAX_ROWS
+ * rows in one dispatch, and a count per row would be wasted.
+ */
+static void forecast_on_resident_change(const struct db_change *change, void *ctx) {
+    struct food_forecast *ff = ctx;
+    if (change->op != DB_CHANGE_UPDATE) {
+        ff->residents_stale = true;
+    }
+}
+
+void food_forecast_refresh(struct food_forecast *ff) {
+    if (!ff->residents_stale) {
+        return;
+    }
+
+    int residents = resident_db_get_count(ff->resident_db);
+    if (residents >= 0) {
+        food_forecast_set_residents(ff, residents);
+        ff->residents_stale = false;
+    }
+}
+
+bool food_forecast_set_batch(struct food_forecast *ff, const struct foodbatch *foodbatch) {
+    if (foodbatch->quantity <= 0) {
+        food_forecast_remove_batch(ff, foodbatch->batch_id);
+        return true;
+    }
+
+    int name = forecast_find_or_add_name(ff, foodbatch->name);
+    if (name < 0) {
+        return false;
+    }
+
+    int pos = intmap_get(&ff->batch_pos, foodbatch->batch_id);
+    if (pos >= 0) {
+        forecast_account(ff, pos, -1);
+    } else {
+        if (!forecast_reserve_batches(ff) || !intmap_put(&ff->batch_pos, foodbatch->batch_id, ff->batch_count)) {
+            return false;
+        }
+        pos = ff->batch_count++;
+        ff->batch_id[pos] = foodbatch->batch_id;
+    }
+
+    ff->quantity[pos] = (float)foodbatch->quantity;
+    ff->rate[pos] = foodbatch->daily_consumption_rate > 0 ? foodbatch->daily_consumption_rate : 0.0f;
+    ff->name_of[pos] = name;
+    forecast_account(ff, pos, 1);
+
+    ff->version++;
+    return true;
+}
+
+void food_forecast_remove_batch(struct food_forecast *ff, int batch_id) {
+    int pos = intmap_remove(&ff->batch_pos, batch_id);
+    if (pos < 0) {
+        return;
+    }
+
+    forecast_account(ff, pos, -1);
+
+    // Keep the arrays packed: the last batch takes the freed position
+    int last = --ff->batch_count;
+    if (pos != last) {
+        ff->quantity[pos] = ff->quantity[last];
+        ff->rate[pos] = ff->rate[last];
+        ff->batch_id[pos] = ff->batch_id[last];
+        ff->name_of[pos] = ff->name_of[last];
+        intmap_put(&ff->batch_pos, ff->batch_id[pos], pos); // Existing key, never allocates
+    }
+
+    ff->version++;
+}
+
+void food_forecast_set_residents(struct food_forecast *ff, int residents) {
+    residents = residents > 0 ? residents : 0;
+    if (residents != ff->residents) {
+        ff->residents = residents;
+        ff->version++;
+    }
+}
+
+/**
+ * @internal
+ * @brief Highest rate / quantity among the batches, the fraction of a batch eaten per resident per day
+ *
+ * Quantities are > 0 and rates >= 0, so every fraction is a non-negative float (or +inf), and those
+ * order the same as their bit patterns read as integers. Taking the maximum on the integers keeps
+ * the loop free of float compares, which the compiler would not vectorize without -ffast-math.
+ */
+static float forecast_max_fraction(const float *restrict quantity, const float *restrict rate, int count) {
+    int32_t max_bits = 0;
+    for (int i = 0; i < count; i++) {
+        float fraction = rate[i] / quantity[i];
+        int32_t bits;
+        memcpy(&bits, &fraction, sizeof(bits));
+        max_bits = bits > max_bits ? bits : max_bits;
+    }
+
+    float max_fraction;
+    memcpy(&max_fraction, &max_bits, sizeof(max_fraction));
+    return max_fraction;
+}
+
+void food_forecast_summary(const struct food_forecast *ff, int32_t today, struct food_forecast_summary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->residents = ff->residents;
+    summary->batches = ff->batch_count;
+    summary->total_quantity = ff->pantry_quantity;
+    summary->daily_consumption = ff->pantry_rate * ff->residents;
+
+    // The pantry runs short when its first food name runs out, the other names cannot stand in for it
+    summary->first_runout_days = INFINITY;
+    for (int i = 0; i < ff->name_count; i++) {
+        const struct forecast_name_entry *entry = &ff->names[i];
+        if (entry->info.batches <= 0) {
+            continue;
+        }
+        summary->names++;
+
+        float days = forecast_days(entry->info.quantity, forecast_name_rate(entry), ff->residents);
+        if (days < summary->first_runout_days) {
+            summary->first_runout_days = days;
+            snprintf(summary->first_runout_name, sizeof(summary->first_runout_name), "%s", entry->info.name);
+        }
+    }
+    summary->first_runout_day =
+        isinf(summary->first_runout_days) ? DATE_INVALID : today + (int32_t)floorf(summary->first_runout_days);
+
+    float max_fraction = forecast_max_fraction(ff->quantity, ff->rate, ff->batch_count);
+    summary->shortest_batch_days = forecast_days(1.0, max_fraction, ff->residents);
+}
+
+int food_forecast_batch_days(const struct food_forecast *ff, int *batch_ids, float *days, int max) {
+    int count = ff->batch_count < max ? ff->batch_count : max;
+    if (count <= 0 || !days) {
+        return 0;
+    }
+
+    // Branch free, a zero rate or no residents divides by zero and gives +inf (quantities are > 0)
+    const float *restrict quantity = ff->quantity;
+    const float *restrict rate = ff->rate;
+    float residents = (float)ff->residents;
+    for (int i = 0; i < count; i++) {
+        days[i] = quantity[i] / (rate[i] * residents);
+    }
+
+    if (batch_ids) {
+        memcpy(batch_ids, ff->batch_id, sizeof(int) * (size_t)count);
+    }
+    return count;
+}
+
+static int forecast_compare_days(const void *a, const void *b) {
+    const struct food_forecast_name *x = a;
+    const struct food_forecast_name *y = b;
+    if (x->days != y->days) {
+        return x->days < y->days ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+int food_forecast_names(const struct food_forecast *ff, struct food_forecast_name *out, int max) {
+    if (!out || max <= 0 || ff->name_count == 0) {
+        return 0;
+    }
+
+    struct food_forecast_name *all = malloc(sizeof(*all) * (size_t)ff->name_count);
+    if (!all) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < ff->name_count; i++) {
+        const struct forecast_name_entry *entry = &ff->names[i];
+        if (entry->info.batches <= 0) {
+            continue;
+        }
+        all[count] = entry->info;
+        all[count].daily_rate = forecast_name_rate(entry);
+        all[count].days = forecast_days(entry->info.quantity, all[count].daily_rate, ff->residents);
+        count++;
+    }
+
+    qsort(all, (size_t)count, sizeof(*all), forecast_compare_days);
+
+    if (count > max) {
+        count = max;
+    }
+    memcpy(out, all, sizeof(*out) * (size_t)count);
+    free(all);
+    return count;
+}
+
+unsigned food_forecast_version(const struct food_forecast *ff) {
+    return ff->version;
+}
+
+void food_forecast_free(struct food_forecast *ff) {
+    if (!ff) {
+        return;
+    }
+
+    db_changes_unsubscribe(ff->foodbatch_subscription);
+    db_changes_unsubscribe(ff->resident_subscription);
+
+    free(ff->quantity);
+    free(ff->rate);
+    free(ff->batch_id);
+    free(ff->name_of);
+    intmap_free(&ff->batch_pos);
+    free(ff->names);
+    intmap_free(&ff->name_index);
+    free(ff);
+}
@@ -10,20 +10,36 @@
 
 #include <inttypes.h> // For PRIu64 (compatibility for both windows and linux)
 
+#include "db/db_changes.h"
+#include "db/db_client.h"
+#include "utils/utils_date.h"
+
+// Column definitions shared by the table creation and the schema migration
+#define FOODBATCH_COLUMNS                                                                               \
+    "BatchId INTEGER PRIMARY KEY,"                                                                      \
+    "Name TEXT,"                                                                                        \
+    "Quantity INTEGER NOT NULL,"                                                                        \
+    "IsPerishable INTEGER NOT NULL,"                                                                    \
+    "ExpirationDate INTEGER,"                                                                           \
+    "DailyConsumptionRate REAL"
+
+static void foodbatch_db_read_row(sqlite3_stmt *stmt, struct foodbatch *foodbatch);
+
+static int foodbatch_db_list(database *db, sqlite3_stmt *stmt, foodbatch_callback callback, void *ctx);
+
+static void foodbatch_db_format_row(sqlite3_stmt *stmt, char *row, size_t row_size);
+
+// Line under each row of the formatted table
+#define FOODBATCH_TABLE_SEPARATOR \
+    "+---------+----------------------------------+----------+------------+-----------------+------------+\n"
+
 int foodbatch_db_create_table(database *db) {
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    const char *sql =
-        "CREATE TABLE IF NOT EXISTS FoodBatch ("
-        "BatchId INTEGER PRIMARY KEY,"
-        "Name TEXT,"
-        "Quantity INTEGER NOT NULL,"
-        "IsPerishable INTEGER NOT NULL,"
-        "ExpirationDate TEXT,"
-        "DailyConsumptionRate REAL);";
+    const char *sql = "CREATE TABLE IF NOT EXISTS FoodBatch (" FOODBATCH_COLUMNS ");";
 
     char *errMsg = 0;
     int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
@@ -33,7 +49,51 @@ int foodbatch_db_create_table(database *db) {
         return rc;
     }
 
-    return SQLITE_OK;
+    // Tables from older versions stored the date as "YYYY-MM-DD" text
+    if (db_table_has_column(db, "FoodBatch", "ExpirationDate", "TEXT")) {
+        rc = db_rebuild_table(
+            db,
+            "FoodBatch",
+            "CREATE TABLE FoodBatch (" FOODBATCH_COLUMNS ");",
+            "BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate",
+            "BatchId, Name, Quantity, IsPerishable, " DB_TEXT_DATE_TO_DAYS("ExpirationDate") ", DailyConsumptionRate"
+        );
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+
+    rc = sqlite3_exec(
+        db->db,
+        "CREATE INDEX IF NOT EXISTS FoodBatch_ExpirationDate ON FoodBatch(ExpirationDate);",
+        0,
+        0,
+        &errMsg
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init FoodBatch_ExpirationDate index: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    // Earlier builds logged every change in the file, at the cost of a row per write
+    if (db_table_has_column(db, "ChangeLog", "Seq", NULL)) {
+        rc = sqlite3_exec(
+            db->db,
+            "DROP TRIGGER IF EXISTS FoodBatch_log_ai; DROP TRIGGER IF EXISTS FoodBatch_log_ad;"
+            "DROP TRIGGER IF EXISTS FoodBatch_log_au; DROP TABLE ChangeLog;",
+            0,
+            0,
+            &errMsg
+        );
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error on dropping the FoodBatch change log: %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return rc;
+        }
+    }
+
+    return db_changes_stamp(db, "FoodBatch", "BatchId");
 }
 
 int foodbatch_db_insert(
@@ -45,15 +105,37 @@ int foodbatch_db_insert(
     const char *expirationDate,
     float dailyConsumptionRate
 ) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_insert(
+            db->remote,
+            batch_id,
+            name,
+            quantity,
+            isPerishable,
+            expirationDate,
+            dailyConsumptionRate
+        );
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    // An empty date means the batch does not expire
+    int32_t expiration_day = DATE_INVALID;
+    if (expirationDate && expirationDate[0] != '\0') {
+        expiration_day = date_parse(expirationDate);
+        if (expiration_day == DATE_INVALID) {
+            fprintf(stderr, "Invalid expiration date: %s\n", expirationDate);
+            return SQLITE_MISMATCH;
+        }
+    }
+
     // SQL query to insert a new food batch
     const char *sql =
-        "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate) "
-        "VALUES (?, ?, ?, ?, ?, ?);";
+        "INSERT INTO FoodBatch "
+        "(BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate, Changed) "
+        "VALUES (?, ?, ?, ?, ?, ?, " DB_CHANGES_STAMP("FoodBatch") ");";
 
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
@@ -67,7 +149,7 @@ int foodbatch_db_insert(
     sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 3, quantity);
     sqlite3_bind_int(stmt, 4, isPerishable ? 1 : 0);
-    sqlite3_bind_text(stmt, 5, expirationDate, -1, SQLITE_STATIC);
+    db_bind_day(stmt, 5, expiration_day);
     sqlite3_bind_double(stmt, 6, dailyConsumptionRate);
 
     // Execute the SQL statement
@@ -96,13 +178,25 @@ int foodbatch_db_update(
     const char *expiration_date_input,
     float daily_consumption_rate_input
 ) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_update(
+            db->remote,
+            batch_id,
+            name_input,
+            quantity_input,
+            is_perishable_input,
+            expiration_date_input,
+            daily_consumption_rate_input
+        );
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
     struct foodbatch foodbatch;
-    int rc = foodbatch_db_get_by_batchid(db, batch_id, &foodbatch);
+    database writer = db_writer(db);
+    int rc = foodbatch_db_get_by_batchid(&writer, batch_id, &foodbatch);
 
     if (rc != SQLITE_OK) {
         fprintf(
@@ -120,14 +214,19 @@ int foodbatch_db_update(
     const char *name = (name_input[0] != '\0') ? name_input : foodbatch.name;
     int quantity = (quantity_input > 0) ? quantity_input : foodbatch.quantity;
     int is_perishable = (is_perishable_input > 0) ? is_perishable_input : foodbatch.is_perishable;
-    const char *expiration_date =
-        (expiration_date_input[0] != '\0') ? expiration_date_input : foodbatch.expiration_date;
+    int32_t expiration_day =
+        (expiration_date_input[0] != '\0') ? date_parse(expiration_date_input) : foodbatch.expiration_day;
     float daily_consumption_rate =
         (daily_consumption_rate_input >= 0) ? daily_consumption_rate_input : foodbatch.daily_consumption_rate;
 
+    if (expiration_date_input[0] != '\0' && expiration_day == DATE_INVALID) {
+        fprintf(stderr, "Invalid expiration date: %s\n", expiration_date_input);
+        return SQLITE_MISMATCH;
+    }
+
     const char *sql =
         "UPDATE FoodBatch SET Name = ?, Quantity = ?, IsPerishable = ?, ExpirationDate = ?, "
-        "DailyConsumptionRate = ? WHERE BatchId = ?;";
+        "DailyConsumptionRate = ?, " DB_CHANGES_RESTAMP("FoodBatch") " WHERE BatchId = ?;";
 
     sqlite3_stmt *stmt;
     rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
@@ -139,7 +238,7 @@ int foodbatch_db_update(
     sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, quantity);
     sqlite3_bind_int(stmt, 3, is_perishable);
-    sqlite3_bind_text(stmt, 4, expiration_date, -1, SQLITE_STATIC);
+    db_bind_day(stmt, 4, expiration_day);
     sqlite3_bind_double(stmt, 5, daily_consumption_rate);
     sqlite3_bind_int(stmt, 6, batch_id);
 
@@ -158,13 +257,63 @@ int foodbatch_db_update(
     return rc == SQLITE_DONE ? SQLITE_OK : rc;
 }
 
+int foodbatch_db_take_quantity(database *db, int batch_id, int amount) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_take_quantity(db->remote, batch_id, amount);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (amount <= 0) {
+        return SQLITE_MISUSE;
+    }
+
+    const char *sql = "UPDATE FoodBatch SET Quantity = Quantity - ?1, " DB_CHANGES_RESTAMP("FoodBatch")
+                      " WHERE BatchId = ?2 AND Quantity >= ?1;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, amount);
+    sqlite3_bind_int(stmt, 2, batch_id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        return rc;
+    }
+
+    if (sqlite3_changes(db->db) == 0) {
+        // Nothing updated: tell a missing batch from one without enough stock
+        database writer = db_writer(db);
+        return foodbatch_db_check_batchid_exists(&writer, batch_id) ? SQLITE_CONSTRAINT : SQLITE_NOTFOUND;
+    }
+
+    return SQLITE_OK;
+}
+
 int foodbatch_db_delete_by_id(database *db, int batch_id) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_delete_by_id(db->remote, batch_id);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!foodbatch_db_check_batchid_exists(db, batch_id)) {
+    database writer = db_writer(db);
+    if (!foodbatch_db_check_batchid_exists(&writer, batch_id)) {
         fprintf(stderr, "Batch ID not found in the dabatase.\n");
         return SQLITE_NOTFOUND;
     }
@@ -194,11 +343,22 @@ int foodbatch_db_delete_by_id(database *db, int batch_id) {
 }
 
 int foodbatch_db_get_by_batchid(database *db, int batch_id, struct foodbatch *foodbatch) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_get_by_batchid(db->remote, batch_id, foodbatch);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_get_by_batchid(&reader, batch_id, foodbatch);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql =
         "SELECT BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate FROM "
         "FoodBatch WHERE BatchId = ?;";
@@ -218,7 +378,8 @@ int foodbatch_db_get_by_batchid(database *db, int batch_id, struct foodbatch *fo
         strcpy(foodbatch->name, (const char *)sqlite3_column_text(stmt, 1));
         foodbatch->quantity = sqlite3_column_int(stmt, 2);
         foodbatch->is_perishable = sqlite3_column_int(stmt, 3);
-        strcpy(foodbatch->expiration_date, (const char *)sqlite3_column_text(stmt, 4));
+        foodbatch->expiration_day = db_column_day(stmt, 4);
+        date_format(foodbatch->expiration_day, foodbatch->expiration_date);
         foodbatch->daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
         rc = SQLITE_OK; // Found and read successfully
     } else if (rc == SQLITE_DONE) {
@@ -233,11 +394,22 @@ int foodbatch_db_get_by_batchid(database *db, int batch_id, struct foodbatch *fo
 }
 
 bool foodbatch_db_check_batchid_exists(database *db, int batch_id) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_check_batchid_exists(db->remote, batch_id);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return false;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        bool result = foodbatch_db_check_batchid_exists(&reader, batch_id);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT 1 FROM FoodBatch WHERE BatchId = ?;";
 
     sqlite3_stmt *stmt;
@@ -269,11 +441,22 @@ bool foodbatch_db_check_batchid_exists(database *db, int batch_id) {
 }
 
 int foodbatch_db_get_count(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_get_count(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_get_count(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT COUNT(*) FROM FoodBatch;";
 
     sqlite3_stmt *stmt;
@@ -294,12 +477,105 @@ int foodbatch_db_get_count(database *db) {
     return count;
 }
 
+int foodbatch_db_expiring_between(
+    database *db,
+    int32_t from_day,
+    int32_t to_day,
+    foodbatch_callback callback,
+    void *ctx
+) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_expiring_between(db->remote, from_day, to_day, callback, ctx);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_expiring_between(&reader, from_day, to_day, callback, ctx);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!callback) {
+        fprintf(stderr, "Invalid callback provided.\n");
+        return -1;
+    }
+
+    // Range scan on FoodBatch_ExpirationDate, batches without a date (NULL) never match
+    const char *sql =
+        "SELECT BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate FROM FoodBatch "
+        "WHERE ExpirationDate BETWEEN ? AND ? ORDER BY ExpirationDate;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, from_day);
+    sqlite3_bind_int(stmt, 2, to_day);
+
+    return foodbatch_db_list(db, stmt, callback, ctx);
+}
+
+int foodbatch_db_in_stock(database *db, foodbatch_callback callback, void *ctx) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_in_stock(db->remote, callback, ctx);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_in_stock(&reader, callback, ctx);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!callback) {
+        fprintf(stderr, "Invalid callback provided.\n");
+        return -1;
+    }
+
+    const char *sql =
+        "SELECT BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate FROM FoodBatch "
+        "WHERE Quantity > 0 ORDER BY BatchId;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    return foodbatch_db_list(db, stmt, callback, ctx);
+}
+
 int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_get_all_format(db->remote, buffer, buffer_size);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_get_all_format(&reader, buffer, buffer_size);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     if (!buffer || buffer_size == 0) {
         fprintf(stderr, "Invalid buffer provided.\n");
         return -1;
@@ -331,7 +607,7 @@ int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size)
     } else {
         // Truncate but ensure null termination
         if (buffer_size > 0) {
-            strncpy(buffer, header, buffer_size - 1);
+            memcpy(buffer, header, buffer_size - 1); // header_len >= buffer_size here
             buffer[buffer_size - 1] = '\0';
         }
         sqlite3_finalize(stmt);
@@ -341,26 +617,8 @@ int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size)
 
     // Process each row
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        int batch_id = sqlite3_column_int(stmt, 0);
-        const char *name = (const char *)sqlite3_column_text(stmt, 1);
-        int quantity = sqlite3_column_int(stmt, 2);
-        int is_perishable = sqlite3_column_int(stmt, 3);
-        const char *expiration_date = (const char *)sqlite3_column_text(stmt, 4);
-        float daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
-
-        // Format the row
         char row[1024];
-        snprintf(
-            row,
-            sizeof(row),
-            "| %7d | %-32s | %-8d | %-10s | %-15s | %-10.2f |\n",
-            batch_id,
-            name,
-            quantity,
-            (is_perishable == 0 ? "False" : "True"),
-            expiration_date,
-            daily_consumption_rate
-        );
+        foodbatch_db_format_row(stmt, row, sizeof(row));
 
         size_t row_len = strlen(row);
         if (written + row_len < buffer_size) {
@@ -378,8 +636,7 @@ int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size)
         }
 
         // Add separator line
-        const char *separator =
-            "+---------+----------------------------------+----------+------------+-----------------+------------+\n";
+        const char *separator = FOODBATCH_TABLE_SEPARATOR;
 
         size_t separator_len = strlen(separator);
         if (written + separator_len < buffer_size) {
@@ -407,12 +664,74 @@ int foodbatch_db_get_all_format(database *db, char *buffer, size_t buffer_size)
     return written;
 }
 
+int foodbatch_db_get_format_by_batchid(database *db, int batch_id, char *buffer, size_t buffer_size) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_get_format_by_batchid(db->remote, batch_id, buffer, buffer_size);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_get_format_by_batchid(&reader, batch_id, buffer, buffer_size);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, "SELECT * FROM FoodBatch WHERE BatchId = ?;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, batch_id);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        sqlite3_finalize(stmt);
+        return 0;
+    }
+    if (rc != SQLITE_ROW) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    char row[1024];
+    foodbatch_db_format_row(stmt, row, sizeof(row));
+    sqlite3_finalize(stmt);
+
+    int written = snprintf(buffer, buffer_size, "%s%s", row, FOODBATCH_TABLE_SEPARATOR);
+    if (written < 0 || (size_t)written >= buffer_size) {
+        buffer[0] = '\0';
+        return -1;
+    }
+    return written;
+}
+
 char *foodbatch_db_get_all_format_old(database *db) {
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return NULL;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        char *result = foodbatch_db_get_all_format_old(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT * FROM FoodBatch;";
     sqlite3_stmt *stmt;
 
@@ -459,7 +778,8 @@ char *foodbatch_db_get_all_format_old(database *db) {
         const char *name = (const char *)sqlite3_column_text(stmt, 1);
         int quantity = sqlite3_column_int(stmt, 2);
         int is_perishable = sqlite3_column_int(stmt, 3);
-        const char *expiration_date = (const char *)sqlite3_column_text(stmt, 4);
+        char expiration_date[DATE_STR_LEN];
+        date_format(db_column_day(stmt, 4), expiration_date);
         float daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
 
         // Format the row
@@ -531,11 +851,22 @@ char *foodbatch_db_get_all_format_old(database *db) {
 }
 
 int foodbatch_db_get_all(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_foodbatch_get_all(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = foodbatch_db_get_all(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT * FROM FoodBatch;";
 
     sqlite3_stmt *stmt;
@@ -555,7 +886,8 @@ int foodbatch_db_get_all(database *db) {
         const char *name = (const char *)sqlite3_column_text(stmt, 1);
         int quantity = sqlite3_column_int(stmt, 2);
         int is_perishable = sqlite3_column_int(stmt, 3);
-        const char *expiration_date = (const char *)sqlite3_column_text(stmt, 4);
+        char expiration_date[DATE_STR_LEN];
+        date_format(db_column_day(stmt, 4), expiration_date);
         float daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
 
         printf(
@@ -579,3 +911,75 @@ int foodbatch_db_get_all(database *db) {
     sqlite3_finalize(stmt);
     return rc == SQLITE_DONE ? SQLITE_OK : rc; // Return based on step result
 }
+
+/**
+ * @internal
+ * @brief Reads a row of (BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate)
+ */
+static void foodbatch_db_read_row(sqlite3_stmt *stmt, struct foodbatch *foodbatch) {
+    memset(foodbatch, 0, sizeof(*foodbatch));
+    foodbatch->batch_id = sqlite3_column_int(stmt, 0);
+    snprintf(foodbatch->name, sizeof(foodbatch->name), "%s", (const char *)sqlite3_column_text(stmt, 1));
+    foodbatch->quantity = sqlite3_column_int(stmt, 2);
+    foodbatch->is_perishable = sqlite3_column_int(stmt, 3);
+    foodbatch->expiration_day = db_column_day(stmt, 4);
+    date_format(foodbatch->expiration_day, foodbatch->expiration_date);
+    foodbatch->daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
+}
+
+/**
+ * @internal
+ * @brief Passes each row of a foodbatch_db_read_row() query to the callback and finalizes the statement
+ *
+ * @return Number of batches passed to the callback, or -1 on failure
+ */
+static int foodbatch_db_list(database *db, sqlite3_stmt *stmt, foodbatch_callback callback, void *ctx) {
+    int found = 0;
+    struct foodbatch foodbatch;
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        foodbatch_db_read_row(stmt, &foodbatch);
+
+        found++;
+        if (callback(ctx, &foodbatch) != 0) {
+            rc = SQLITE_DONE; // Caller asked to stop early
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+/**
+ * @internal
+ * @brief Formats a row of SELECT * FROM FoodBatch as a line of the foodbatch_db_get_all_format() table
+ */
+static void foodbatch_db_format_row(sqlite3_stmt *stmt, char *row, size_t row_size) {
+    int batch_id = sqlite3_column_int(stmt, 0);
+    const char *name = (const char *)sqlite3_column_text(stmt, 1);
+    int quantity = sqlite3_column_int(stmt, 2);
+    int is_perishable = sqlite3_column_int(stmt, 3);
+    char expiration_date[DATE_STR_LEN];
+    date_format(db_column_day(stmt, 4), expiration_date);
+    float daily_consumption_rate = (float)sqlite3_column_double(stmt, 5);
+
+    snprintf(
+        row,
+        row_size,
+        "| %7d | %-32s | %-8d | %-10s | %-15s | %-10.2f |\n",
+        batch_id,
+        name,
+        quantity,
+        (is_perishable == 0 ? "False" : "True"),
+        expiration_date,
+        daily_consumption_rate
+    );
+}
@@ -6,6 +6,32 @@
 #include "db/medication_db.h"
 
 #include <stdio.h>
+#include <string.h>
+
+#include "db/resident_db.h"
+#include "utils/utils_date.h"
+
+// Column definitions shared by the table creation and the schema migration
+#define MEDICATIONS_COLUMNS                                                                             \
+    "ID INTEGER PRIMARY KEY AUTOINCREMENT,"                                                             \
+    "Name TEXT NOT NULL,"               /* e.g. "Paracetamol 500g" */                                   \
+    "GenericName TEXT,"                 /* e.g. "Paracetamol" */                                        \
+    "Form TEXT,"                        /* e.g. "Tablet", "Syrup", "Injection" */                       \
+    "Strength TEXT,"                    /* e.g. "500mg", "5mg/ml" */                                    \
+    "Unit TEXT,"                        /* e.g. "Tablet", "ml", "vial" */                               \
+    "Stock INTEGER NOT NULL DEFAULT 0," /* Current count in inventory */                                \
+    "ExpirationDate INTEGER,"           /* Soonest expiration date (days since 1970-01-01) */           \
+    "Notes TEXT,"                       /* General notes if needed */                                   \
+    "UNIQUE(Name, Form, Strength)"      /* Prevents accidental duplicate entries of the same medication \
+                                           in the same dosage and form e.g. multiple "Paracetamol 500mg Tablet" */
+
+// Columns read by medication_db_read_row, in order
+#define MEDICATIONS_SELECT \
+    "SELECT ID, Name, GenericName, Form, Strength, Unit, Stock, ExpirationDate, Notes FROM Medications"
+
+static void medication_db_read_row(sqlite3_stmt *stmt, struct medication *medication);
+
+static const char *medication_db_text(sqlite3_stmt *stmt, int col);
 
 int medication_db_create_table(database *db) {
     if (!db_is_init(db)) {
@@ -13,19 +39,7 @@ int medication_db_create_table(database *db) {
         return SQLITE_ERROR;
     }
 
-    const char *sql =
-        "CREATE TABLE IF NOT EXISTS Medications ("
-        "ID INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "Name TEXT NOT NULL,"               // e.g. "Paracetamol 500g"
-        "GenericName TEXT,"                 // e.g. "Paracetamol"
-        "Form TEXT,"                        // e.g. "Tablet", "Syrup", "Injection"
-        "Strength TEXT,"                    // e.g. "500mg", "5mg/ml"
-        "Unit TEXT,"                        // e.g. "Tablet", "ml", "vial"
-        "Stock INTEGER NOT NULL DEFAULT 0," // Current count in inventory
-        "ExpirationDate TEXT,"              // Soonest expiration date
-        "Notes TEXT,"                       // General notes if needed
-        "UNIQUE(Name, Form, Strength));";   // Prevents accidental duplicate entries of the same medication in the same
-                                            // dosage and form e.g. multiple "Paracetamol 500mg Tablet"
+    const char *sql = "CREATE TABLE IF NOT EXISTS Medications (" MEDICATIONS_COLUMNS ");";
 
     char *errMsg = 0;
     int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
@@ -36,5 +50,697 @@ int medication_db_create_table(database *db) {
         return rc;
     }
 
+    // Tables from older versions stored the date as "YYYY-MM-DD" text
+    if (db_table_has_column(db, "Medications", "ExpirationDate", "TEXT")) {
+        rc = db_rebuild_table(
+            db,
+            "Medications",
+            "CREATE TABLE Medications (" MEDICATIONS_COLUMNS ");",
+            "ID, Name, GenericName, Form, Strength, Unit, Stock, ExpirationDate, Notes",
+            "ID, Name, GenericName, Form, Strength, Unit, Stock, " DB_TEXT_DATE_TO_DAYS("ExpirationDate") ", Notes"
+        );
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+
+    rc = sqlite3_exec(
+        db->db,
+        "CREATE INDEX IF NOT EXISTS Medications_ExpirationDate ON Medications(ExpirationDate);",
+        0,
+        0,
+        &errMsg
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init Medications_ExpirationDate index: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    // Dispensing log and dose schedules, both keyed by the resident CPF stored as an integer
+    rc = sqlite3_exec(
+        db->db,
+        "CREATE TABLE IF NOT EXISTS DispenseLog ("
+        "ID INTEGER PRIMARY KEY,"
+        "MedicationID INTEGER NOT NULL,"
+        "CPF INTEGER NOT NULL,"
+        "Quantity INTEGER NOT NULL,"
+        "DispensedAt INTEGER NOT NULL" /* Unix time, seconds */
+        ");"
+        "CREATE INDEX IF NOT EXISTS DispenseLog_CPF ON DispenseLog(CPF, DispensedAt);"
+        "CREATE TABLE IF NOT EXISTS DoseSchedule ("
+        "ID INTEGER PRIMARY KEY,"
+        "CPF INTEGER NOT NULL,"
+        "MedicationID INTEGER NOT NULL,"
+        "Quantity INTEGER NOT NULL,"
+        "FirstMinute INTEGER NOT NULL,"               /* Minutes since 1970-01-01 00:00 UTC */
+        "IntervalMinutes INTEGER NOT NULL DEFAULT 0," /* 0 for a single dose */
+        "GivenMinute INTEGER"                         /* Last dose given, NULL if none yet */
+        ");"
+        "CREATE INDEX IF NOT EXISTS DoseSchedule_MedicationID ON DoseSchedule(MedicationID);",
+        0,
+        0,
+        &errMsg
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init DispenseLog/DoseSchedule tables: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
     return SQLITE_OK;
-}
\ No newline at end of file
+}
+
+int medication_db_insert(
+    database *db,
+    const char *name,
+    const char *generic_name,
+    const char *form,
+    const char *strength,
+    const char *unit,
+    int stock,
+    const char *expiration_date,
+    const char *notes,
+    int *id
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    // An empty date means the medication has none, anything else must be a real date
+    int32_t expiration_day = DATE_INVALID;
+    if (expiration_date[0] != '\0') {
+        expiration_day = date_parse(expiration_date);
+        if (expiration_day == DATE_INVALID) {
+            fprintf(stderr, "Invalid expiration date: %s\n", expiration_date);
+            return SQLITE_MISMATCH;
+        }
+    }
+
+    const char *sql =
+        "INSERT INTO Medications (Name, GenericName, Form, Strength, Unit, Stock, ExpirationDate, Notes) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, generic_name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, form, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, strength, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, stock);
+    db_bind_day(stmt, 7, expiration_day);
+    sqlite3_bind_text(stmt, 8, notes, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (id) {
+        *id = (int)sqlite3_last_insert_rowid(db->db);
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int medication_db_update(
+    database *db,
+    int id,
+    const char *name,
+    const char *generic_name,
+    const char *form,
+    const char *strength,
+    const char *unit,
+    int stock,
+    const char *expiration_date,
+    const char *notes
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct medication current;
+    int rc = medication_db_get_by_id(db, id, &current);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    // Decide which fields to use for update based on inputs
+    int32_t expiration_day =
+        (expiration_date[0] != '\0') ? date_parse(expiration_date) : current.expiration_day;
+    if (expiration_date[0] != '\0' && expiration_day == DATE_INVALID) {
+        fprintf(stderr, "Invalid expiration date: %s\n", expiration_date);
+        return SQLITE_MISMATCH;
+    }
+
+    const char *sql =
+        "UPDATE Medications SET Name = ?, GenericName = ?, Form = ?, Strength = ?, Unit = ?, Stock = ?, "
+        "ExpirationDate = ?, Notes = ? WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_text(stmt, 1, name[0] != '\0' ? name : current.name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, generic_name[0] != '\0' ? generic_name : current.generic_name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, form[0] != '\0' ? form : current.form, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, strength[0] != '\0' ? strength : current.strength, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, unit[0] != '\0' ? unit : current.unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, stock >= 0 ? stock : current.stock);
+    db_bind_day(stmt, 7, expiration_day);
+    sqlite3_bind_text(stmt, 8, notes[0] != '\0' ? notes : current.notes, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 9, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int medication_db_delete_by_id(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (!medication_db_check_id_exists(db, id)) {
+        fprintf(stderr, "Medication ID not found in the database.\n");
+        return SQLITE_NOTFOUND;
+    }
+
+    char *sql = sqlite3_mprintf(
+        "BEGIN;"
+        "DELETE FROM DoseSchedule WHERE MedicationID = %d;"
+        "DELETE FROM Medications WHERE ID = %d;"
+        "COMMIT;",
+        id,
+        id
+    );
+    if (!sql) {
+        return SQLITE_NOMEM;
+    }
+
+    char *errMsg = 0;
+    int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    sqlite3_free(sql);
+
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to delete medication %d: %s\n", id, errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    }
+    return rc;
+}
+
+bool medication_db_check_id_exists(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return false;
+    }
+
+    const char *sql = "SELECT 1 FROM Medications WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+int medication_db_get_by_id(database *db, int id, struct medication *medication) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = MEDICATIONS_SELECT " WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        medication_db_read_row(stmt, medication);
+        rc = SQLITE_OK;
+    } else if (rc == SQLITE_DONE) {
+        fprintf(stderr, "No medication found with ID: %d\n", id);
+        rc = SQLITE_NOTFOUND;
+    } else {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int medication_db_get_count(database *db) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql = "SELECT COUNT(*) FROM Medications;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+int medication_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    const char *sql = MEDICATIONS_SELECT " ORDER BY ID;";
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    size_t written = 0;
+
+    const char *header =
+        "+------------------------------------------------------------------------------------------------------+\n"
+        "| ID    | Name                     | Form       | Strength   | Stock    | Unit       | Expiration date |\n"
+        "+-------+--------------------------+------------+------------+----------+------------+-----------------+\n";
+
+    size_t header_len = strlen(header);
+    if (header_len >= buffer_size) {
+        sqlite3_finalize(stmt);
+        fprintf(stderr, "Header truncated\n");
+        return -1;
+    }
+    memcpy(buffer, header, header_len + 1);
+    written = header_len;
+
+    struct medication medication;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        medication_db_read_row(stmt, &medication);
+
+        char row[512];
+        snprintf(
+            row,
+            sizeof(row),
+            "| %5d | %-24.24s | %-10.10s | %-10.10s | %-8d | %-10.10s | %-15s |\n"
+            "+-------+--------------------------+------------+------------+----------+------------+-----------------+\n",
+            medication.id,
+            medication.name,
+            medication.form,
+            medication.strength,
+            medication.stock,
+            medication.unit,
+            medication.expiration_date
+        );
+
+        size_t row_len = strlen(row);
+        if (written + row_len >= buffer_size) {
+            sqlite3_finalize(stmt);
+            fprintf(stderr, "Buffer too small, output truncated\n");
+            return -1;
+        }
+        memcpy(buffer + written, row, row_len + 1);
+        written += row_len;
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return (int)written;
+}
+
+int medication_db_dispense(database *db, int id, const char *cpf, int quantity, int64_t dispensed_at) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (quantity <= 0) {
+        return SQLITE_MISUSE;
+    }
+
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        fprintf(stderr, "Invalid CPF: %s\n", cpf);
+        return SQLITE_MISMATCH;
+    }
+
+    // IMMEDIATE takes the write lock up front, the stock check and the log entry commit together
+    int rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(
+        db->db,
+        "UPDATE Medications SET Stock = Stock - ?1 WHERE ID = ?2 AND Stock >= ?1;",
+        -1,
+        &stmt,
+        0
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+
+    sqlite3_bind_int(stmt, 1, quantity);
+    sqlite3_bind_int(stmt, 2, id);
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+
+    if (sqlite3_changes(db->db) == 0) {
+        // Nothing updated: tell a missing medication from one without enough stock
+        rc = medication_db_check_id_exists(db, id) ? SQLITE_CONSTRAINT : SQLITE_NOTFOUND;
+        goto rollback;
+    }
+
+    rc = sqlite3_prepare_v2(
+        db->db,
+        "INSERT INTO DispenseLog (MedicationID, CPF, Quantity, DispensedAt) VALUES (?, ?, ?, ?);",
+        -1,
+        &stmt,
+        0
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+    sqlite3_bind_int64(stmt, 2, cpf_key);
+    sqlite3_bind_int(stmt, 3, quantity);
+    sqlite3_bind_int64(stmt, 4, dispensed_at);
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+
+    rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+    if (rc == SQLITE_OK) {
+        return SQLITE_OK;
+    }
+    fprintf(stderr, "Failed to commit dispense: %s\n", sqlite3_errmsg(db->db));
+
+rollback:
+    sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    return rc;
+}
+
+int medication_db_dispensed_to(
+    database *db,
+    const char *cpf,
+    int limit,
+    medication_dispense_callback callback,
+    void *ctx
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        return 0; // Not a CPF, nothing can be stored under it
+    }
+
+    // Walks the (CPF, DispensedAt) index backwards
+    const char *sql =
+        "SELECT l.ID, l.MedicationID, m.Name, l.CPF, l.Quantity, l.DispensedAt FROM DispenseLog l "
+        "LEFT JOIN Medications m ON m.ID = l.MedicationID "
+        "WHERE l.CPF = ? ORDER BY l.DispensedAt DESC, l.ID DESC LIMIT ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    sqlite3_bind_int64(stmt, 1, cpf_key);
+    sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
+
+    int count = 0;
+    struct medication_dispense dispense;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        memset(&dispense, 0, sizeof(dispense));
+        dispense.id = sqlite3_column_int64(stmt, 0);
+        dispense.medication_id = sqlite3_column_int(stmt, 1);
+        snprintf(dispense.medication_name, sizeof(dispense.medication_name), "%s", medication_db_text(stmt, 2));
+        resident_db_cpf_unpack(sqlite3_column_int64(stmt, 3), dispense.cpf);
+        dispense.quantity = sqlite3_column_int(stmt, 4);
+        dispense.dispensed_at = sqlite3_column_int64(stmt, 5);
+
+        count++;
+        if (callback && callback(ctx, &dispense) != 0) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        count = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+int medication_db_schedule_insert(database *db, struct medication_schedule *schedule) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (schedule->quantity <= 0 || schedule->interval_minutes < 0) {
+        return SQLITE_MISUSE;
+    }
+
+    int64_t cpf_key = resident_db_cpf_pack(schedule->cpf);
+    if (cpf_key < 0) {
+        fprintf(stderr, "Invalid CPF: %s\n", schedule->cpf);
+        return SQLITE_MISMATCH;
+    }
+
+    if (!medication_db_check_id_exists(db, schedule->medication_id)) {
+        fprintf(stderr, "Medication ID not found in the database.\n");
+        return SQLITE_NOTFOUND;
+    }
+
+    const char *sql =
+        "INSERT INTO DoseSchedule (CPF, MedicationID, Quantity, FirstMinute, IntervalMinutes) VALUES (?, ?, ?, ?, ?);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int64(stmt, 1, cpf_key);
+    sqlite3_bind_int(stmt, 2, schedule->medication_id);
+    sqlite3_bind_int(stmt, 3, schedule->quantity);
+    sqlite3_bind_int64(stmt, 4, schedule->first_minute);
+    sqlite3_bind_int(stmt, 5, schedule->interval_minutes);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else {
+        schedule->id = (int)sqlite3_last_insert_rowid(db->db);
+        schedule->given_minute = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int medication_db_schedule_set_given(database *db, int id, int64_t given_minute) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "UPDATE DoseSchedule SET GivenMinute = ? WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int64(stmt, 1, given_minute);
+    sqlite3_bind_int(stmt, 2, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (sqlite3_changes(db->db) == 0) {
+        rc = SQLITE_NOTFOUND;
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int medication_db_schedule_delete(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "DELETE FROM DoseSchedule WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare delete statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute delete statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (sqlite3_changes(db->db) == 0) {
+        rc = SQLITE_NOTFOUND;
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int medication_db_schedules(database *db, medication_schedule_callback callback, void *ctx) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql =
+        "SELECT ID, CPF, MedicationID, Quantity, FirstMinute, IntervalMinutes, GivenMinute FROM DoseSchedule;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+    struct medication_schedule schedule;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        memset(&schedule, 0, sizeof(schedule));
+        schedule.id = sqlite3_column_int(stmt, 0);
+        resident_db_cpf_unpack(sqlite3_column_int64(stmt, 1), schedule.cpf);
+        schedule.medication_id = sqlite3_column_int(stmt, 2);
+        schedule.quantity = sqlite3_column_int(stmt, 3);
+        schedule.first_minute = sqlite3_column_int64(stmt, 4);
+        schedule.interval_minutes = sqlite3_column_int(stmt, 5);
+        schedule.given_minute = sqlite3_column_type(stmt, 6) == SQLITE_NULL ? -1 : sqlite3_column_int64(stmt, 6);
+
+        count++;
+        if (callback && callback(ctx, &schedule) != 0) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        count = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+/**
+ * @internal
+ * @brief Text of a column, empty string for NULL
+ */
+static const char *medication_db_text(sqlite3_stmt *stmt, int col) {
+    const char *text = (const char *)sqlite3_column_text(stmt, col);
+    return text ? text : "";
+}
+
+/**
+ * @internal
+ * @brief Fills a medication from a row selected with MEDICATIONS_SELECT
+ */
+static void medication_db_read_row(sqlite3_stmt *stmt, struct medication *medication) {
+    memset(medication, 0, sizeof(*medication));
+    medication->id = sqlite3_column_int(stmt, 0);
+    snprintf(medication->name, sizeof(medication->name), "%s", medication_db_text(stmt, 1));
+    snprintf(medication->generic_name, sizeof(medication->generic_name), "%s", medication_db_text(stmt, 2));
+    snprintf(medication->form, sizeof(medication->form), "%s", medication_db_text(stmt, 3));
+    snprintf(medication->strength, sizeof(medication->strength), "%s", medication_db_text(stmt, 4));
+    snprintf(medication->unit, sizeof(medication->unit), "%s", medication_db_text(stmt, 5));
+    medication->stock = sqlite3_column_int(stmt, 6);
+    medication->expiration_day = db_column_day(stmt, 7);
+    date_format(medication->expiration_day, medication->expiration_date);
+    snprintf(medication->notes, sizeof(medication->notes), "%s", medication_db_text(stmt, 8));
+}
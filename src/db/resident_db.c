@@ -4,29 +4,54 @@
  */
 #include "db/resident_db.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include <inttypes.h> // For PRIu64 (compatibility for both windows and linux)
 
+#include "db/db_changes.h"
+#include "db/db_client.h"
+#include "utils/utils_date.h"
+#include "utils/utils_name.h"
+
+static int resident_db_migrate_name_key(database *db);
+
+static int resident_db_migrate_column_types(database *db);
+
+static int resident_db_create_search_index(database *db);
+
+static size_t resident_db_build_match_query(const char *input, char *out, size_t out_size);
+
+static void resident_db_read_row(sqlite3_stmt *stmt, struct resident *resident);
+
+static void resident_db_format_row(sqlite3_stmt *stmt, char *row, size_t row_size);
+
+// Line under each row of the formatted table
+#define RESIDENT_TABLE_SEPARATOR                                                                              \
+    "+-------------+--------------------------------------------+-----+-------------------------------------" \
+    "-------+--------------------------------------------+--------------------+--------+------------+\n"
+
+// Column definitions shared by the table creation and the schema migrations
+#define RESIDENT_COLUMNS                                                                                \
+    "CPF INTEGER PRIMARY KEY,"                                                                          \
+    "Name TEXT NOT NULL,"                                                                               \
+    "Age INTEGER NOT NULL,"                                                                             \
+    "HealthStatus TEXT,"                                                                                \
+    "Needs TEXT,"                                                                                       \
+    "MedicalAssistance INTEGER NOT NULL,"                                                               \
+    "Gender INTEGER NOT NULL,"                                                                          \
+    "EntryDate INTEGER,"                                                                                \
+    "NameKey TEXT"
+
 int resident_db_create_table(database *db) {
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    const char *sql =
-        "CREATE TABLE IF NOT EXISTS Resident ("
-        "CPF TEXT PRIMARY KEY,"
-        "Name TEXT NOT NULL,"
-        "Age INTEGER NOT NULL,"
-        "HealthStatus TEXT,"
-        "Needs TEXT,"
-        "MedicalAssistance INTEGER NOT NULL,"
-        "Gender INTEGER NOT NULL,"
-        "EntryDate TEXT);";
+    const char *sql = "CREATE TABLE IF NOT EXISTS Resident (" RESIDENT_COLUMNS ") WITHOUT ROWID;";
 
     char *errMsg = 0;
     int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
@@ -35,9 +60,293 @@ int resident_db_create_table(database *db) {
         sqlite3_free(errMsg);
         return rc;
     }
+
+    rc = resident_db_migrate_name_key(db);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    rc = resident_db_migrate_column_types(db);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    rc = sqlite3_exec(
+        db->db,
+        "CREATE INDEX IF NOT EXISTS Resident_NameKey ON Resident(NameKey);"
+        "CREATE INDEX IF NOT EXISTS Resident_EntryDate ON Resident(EntryDate);",
+        0,
+        0,
+        &errMsg
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init Resident indexes: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    rc = resident_db_create_search_index(db);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    // Earlier builds logged every change in the file, at the cost of a row per write
+    if (db_table_has_column(db, "ChangeLog", "Seq", NULL)) {
+        rc = sqlite3_exec(
+            db->db,
+            "DROP TRIGGER IF EXISTS Resident_log_ai; DROP TRIGGER IF EXISTS Resident_log_ad;"
+            "DROP TRIGGER IF EXISTS Resident_log_au; DROP TABLE ChangeLog;",
+            0,
+            0,
+            &errMsg
+        );
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error on dropping the Resident change log: %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return rc;
+        }
+    }
+
+    rc = db_changes_stamp(db, "Resident", "CPF");
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    // WITHOUT ROWID, the update hook does not see it
+    return db_changes_track(db, "Resident", "CPF");
+}
+
+/**
+ * @internal
+ * @brief Adds and fills the NameKey column on databases created before it existed
+ *
+ * The key is computed in C (name_phonetic_key()), so it is filled row by row inside one transaction.
+ */
+static int resident_db_migrate_name_key(database *db) {
+    if (db_table_has_column(db, "Resident", "NameKey", NULL)) {
+        return SQLITE_OK;
+    }
+
+    sqlite3_stmt *stmt;
+    char *errMsg = 0;
+    int rc = sqlite3_exec(db->db, "BEGIN; ALTER TABLE Resident ADD COLUMN NameKey TEXT;", 0, 0, &errMsg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on adding NameKey column: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        return rc;
+    }
+
+    sqlite3_stmt *update;
+    rc = sqlite3_prepare_v2(db->db, "SELECT CPF, Name FROM Resident;", -1, &stmt, 0);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_prepare_v2(db->db, "UPDATE Resident SET NameKey = ? WHERE CPF = ?;", -1, &update, 0);
+        if (rc != SQLITE_OK) {
+            sqlite3_finalize(stmt);
+        }
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        return rc;
+    }
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        char key[NAME_KEY_LEN];
+        const char *name = (const char *)sqlite3_column_text(stmt, 1);
+        name_phonetic_key(name ? name : "", key);
+
+        sqlite3_bind_text(update, 1, key, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_value(update, 2, sqlite3_column_value(stmt, 0));
+        if (sqlite3_step(update) != SQLITE_DONE) {
+            rc = SQLITE_ERROR;
+            break;
+        }
+        sqlite3_reset(update);
+    }
+
+    sqlite3_finalize(update);
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to fill NameKey column: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        return rc;
+    }
+
+    return sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+}
+
+/**
+ * @internal
+ * @brief Rebuilds Resident tables from older versions with TEXT CPF or TEXT EntryDate columns
+ *
+ * The new table is keyed by the INTEGER CPF without a rowid and stores EntryDate as a day number.
+ * The search index referenced the old keys, it is dropped here and recreated (and rebuilt) by
+ * resident_db_create_search_index().
+ */
+static int resident_db_migrate_column_types(database *db) {
+    bool text_cpf = db_table_has_column(db, "Resident", "CPF", "TEXT");
+    bool text_date = db_table_has_column(db, "Resident", "EntryDate", "TEXT");
+
+    if (!text_cpf && !text_date) {
+        return SQLITE_OK;
+    }
+
+    char *errMsg = 0;
+    int rc = sqlite3_exec(db->db, "DROP TABLE IF EXISTS ResidentSearch;", 0, 0, &errMsg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on dropping ResidentSearch index: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    return db_rebuild_table(
+        db,
+        "Resident",
+        "CREATE TABLE Resident (" RESIDENT_COLUMNS ") WITHOUT ROWID;",
+        "CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate, NameKey",
+        "CAST(CPF AS INTEGER), Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, "
+        DB_TEXT_DATE_TO_DAYS("EntryDate") ", NameKey"
+    );
+}
+
+/**
+ * @internal
+ * @brief Creates the FTS5 index over Resident(Name, HealthStatus, Needs) and its sync triggers
+ *
+ * The index is an external-content table, it stores only the inverted index and reads the text
+ * back from Resident through the integer CPF key, the triggers keep both in sync on every insert,
+ * update and delete.
+ * If the index is created on a database that already has residents, it is rebuilt once.
+ */
+static int resident_db_create_search_index(database *db) {
+    bool index_exists = false;
+    sqlite3_stmt *stmt;
+
+    int rc = sqlite3_prepare_v2(
+        db->db,
+        "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'ResidentSearch';",
+        -1,
+        &stmt,
+        0
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+    index_exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+
+    // prefix='2 3' keeps short prefix queries (search-as-you-type) from scanning the whole term list
+    const char *sql =
+        "CREATE VIRTUAL TABLE IF NOT EXISTS ResidentSearch USING fts5("
+        "Name, HealthStatus, Needs,"
+        "content='Resident', content_rowid='CPF',"
+        "tokenize='unicode61 remove_diacritics 2', prefix='2 3');"
+
+        "CREATE TRIGGER IF NOT EXISTS Resident_ai AFTER INSERT ON Resident BEGIN "
+        "INSERT INTO ResidentSearch(rowid, Name, HealthStatus, Needs) "
+        "VALUES (new.CPF, new.Name, new.HealthStatus, new.Needs); "
+        "END;"
+
+        "CREATE TRIGGER IF NOT EXISTS Resident_ad AFTER DELETE ON Resident BEGIN "
+        "INSERT INTO ResidentSearch(ResidentSearch, rowid, Name, HealthStatus, Needs) "
+        "VALUES ('delete', old.CPF, old.Name, old.HealthStatus, old.Needs); "
+        "END;"
+
+        "CREATE TRIGGER IF NOT EXISTS Resident_au AFTER UPDATE OF Name, HealthStatus, Needs ON Resident BEGIN "
+        "INSERT INTO ResidentSearch(ResidentSearch, rowid, Name, HealthStatus, Needs) "
+        "VALUES ('delete', old.CPF, old.Name, old.HealthStatus, old.Needs); "
+        "INSERT INTO ResidentSearch(rowid, Name, HealthStatus, Needs) "
+        "VALUES (new.CPF, new.Name, new.HealthStatus, new.Needs); "
+        "END;";
+
+    char *errMsg = 0;
+    rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init ResidentSearch index: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    if (!index_exists) {
+        rc = sqlite3_exec(db->db, "INSERT INTO ResidentSearch(ResidentSearch) VALUES ('rebuild');", 0, 0, &errMsg);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error on rebuilding ResidentSearch index: %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return rc;
+        }
+    }
+
     return SQLITE_OK;
 }
 
+int64_t resident_db_cpf_pack(const char *cpf) {
+    if (!cpf) {
+        return -1;
+    }
+
+    size_t len = strlen(cpf);
+    if (len == 0 || len > MAX_CPF_LENGTH - 1) {
+        return -1;
+    }
+
+    int64_t packed = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (cpf[i] < '0' || cpf[i] > '9') {
+            return -1;
+        }
+        packed = packed * 10 + (cpf[i] - '0');
+    }
+    return packed;
+}
+
+/**
+ * @internal
+ * @brief Check digit over the first count digits of a CPF, weights count + 1 down to 2
+ */
+static char resident_db_cpf_check_digit(const char *cpf, int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += (cpf[i] - '0') * (count + 1 - i);
+    }
+    int rest = sum % 11;
+    return (char)('0' + (rest < 2 ? 0 : 11 - rest));
+}
+
+bool resident_db_cpf_valid(const char *cpf) {
+    if (!cpf) {
+        return false;
+    }
+    for (int i = 0; i < MAX_CPF_LENGTH - 1; i++) {
+        if (cpf[i] < '0' || cpf[i] > '9') {
+            return false;
+        }
+    }
+    if (cpf[MAX_CPF_LENGTH - 1] != '\0') {
+        return false;
+    }
+
+    bool all_same = true;
+    for (int i = 1; i < MAX_CPF_LENGTH - 1; i++) {
+        all_same = all_same && cpf[i] == cpf[0];
+    }
+
+    return !all_same && resident_db_cpf_check_digit(cpf, 9) == cpf[9] && resident_db_cpf_check_digit(cpf, 10) == cpf[10];
+}
+
+void resident_db_cpf_complete(char cpf[MAX_CPF_LENGTH]) {
+    cpf[9] = resident_db_cpf_check_digit(cpf, 9);
+    cpf[10] = resident_db_cpf_check_digit(cpf, 10);
+    cpf[11] = '\0';
+}
+
+void resident_db_cpf_unpack(int64_t packed, char cpf[MAX_CPF_LENGTH]) {
+    // Leading zeros are part of the CPF ("01234567890"), the integer key drops them
+    snprintf(cpf, MAX_CPF_LENGTH, "%0*" PRId64, MAX_CPF_LENGTH - 1, packed);
+}
+
 int resident_db_insert(
     database *db,
     const char *cpf,
@@ -48,14 +357,24 @@ int resident_db_insert(
     bool medical_assistance,
     int gender
 ) {
+    if (db_is_remote(db)) {
+        return db_client_resident_insert(db->remote, cpf, name, age, health_status, needs, medical_assistance, gender);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        fprintf(stderr, "Invalid CPF: %s\n", cpf);
+        return SQLITE_MISMATCH;
+    }
+
     const char *sql =
-        "INSERT INTO Resident (CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+        "INSERT INTO Resident "
+        "(CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate, NameKey, Changed) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, " DB_CHANGES_STAMP("Resident") ");";
 
     sqlite3_stmt *stmt;
 
@@ -65,36 +384,18 @@ int resident_db_insert(
         return rc;
     }
 
-    // Get current time for EntryDate
-    time_t now;
-    time(&now);
-
-    struct tm curr_time = { 0 };
-
-#ifdef _WIN32
-    localtime_s(&curr_time, &now);
-#else
-    localtime_r(&now, &curr_time);
-#endif
-
-    char date_string[32]; // Increased buffer to supress warning
-    snprintf(
-        date_string,
-        sizeof(date_string),
-        "%04d-%02d-%02d",
-        curr_time.tm_year + 1900,
-        curr_time.tm_mon + 1,
-        curr_time.tm_mday
-    );
-
-    sqlite3_bind_text(stmt, 1, cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 1, cpf_key);
     sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 3, age);
     sqlite3_bind_text(stmt, 4, health_status, -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 5, needs, -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 6, medical_assistance ? 1 : 0);
     sqlite3_bind_int(stmt, 7, gender);
-    sqlite3_bind_text(stmt, 8, date_string, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 8, date_today());
+
+    char name_key[NAME_KEY_LEN];
+    name_phonetic_key(name, name_key);
+    sqlite3_bind_text(stmt, 9, name_key, -1, SQLITE_STATIC);
 
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
@@ -113,6 +414,137 @@ int resident_db_insert(
     return rc == SQLITE_DONE ? SQLITE_OK : rc; // Return based on step result
 }
 
+int resident_db_find_duplicates(
+    database *db,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+) {
+    if (db_is_remote(db)) {
+        return db_client_resident_find_duplicates(db->remote, name, exclude_cpf, threshold, out, max);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_find_duplicates(&reader, name, exclude_cpf, threshold, out, max);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!name || !out || max <= 0) {
+        fprintf(stderr, "Invalid duplicate lookup arguments provided.\n");
+        return -1;
+    }
+
+    char key[NAME_KEY_LEN];
+    uint16_t trigrams[NAME_MAX_TRIGRAMS];
+    int trigram_count = name_trigrams(name, trigrams);
+    if (name_phonetic_key(name, key) == 0 || trigram_count == 0) {
+        return 0; // Nothing to compare
+    }
+    int64_t exclude = exclude_cpf ? resident_db_cpf_pack(exclude_cpf) : -1;
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, "SELECT CPF, Name FROM Resident WHERE NameKey = ?;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+
+    int found = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int64_t cpf = sqlite3_column_int64(stmt, 0);
+        const char *other = (const char *)sqlite3_column_text(stmt, 1);
+        if (cpf == exclude || !other) {
+            continue;
+        }
+
+        uint16_t other_trigrams[NAME_MAX_TRIGRAMS];
+        int other_count = name_trigrams(other, other_trigrams);
+        float similarity = name_trigram_similarity(trigrams, trigram_count, other_trigrams, other_count);
+        similarity = 0.5f + similarity / 2.0f; // Same phonetic key by construction
+        if (similarity < threshold) {
+            continue;
+        }
+
+        // Keep the best max candidates, sorted by score (insertion into a short array)
+        int pos = found < max ? found : max;
+        while (pos > 0 && out[pos - 1].similarity < similarity) {
+            if (pos < max) {
+                out[pos] = out[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max) {
+            resident_db_cpf_unpack(cpf, out[pos].cpf);
+            snprintf(out[pos].name, sizeof(out[pos].name), "%s", other);
+            out[pos].similarity = similarity;
+            if (found < max) {
+                found++;
+            }
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int resident_db_insert_checked(
+    database *db,
+    const char *cpf,
+    const char *name,
+    int age,
+    const char *health_status,
+    const char *needs,
+    bool medical_assistance,
+    int gender,
+    float threshold,
+    struct resident_duplicate *duplicates,
+    int max,
+    int *duplicate_count
+) {
+    *duplicate_count = 0;
+    if (db_is_remote(db)) {
+        return db_client_resident_insert_checked(
+            db->remote,
+            cpf,
+            name,
+            age,
+            health_status,
+            needs,
+            medical_assistance,
+            gender,
+            threshold,
+            duplicates,
+            max,
+            duplicate_count
+        );
+    }
+
+    // Looked up first so the resident does not find itself, a failed lookup does not block the insert
+    database writer = db_writer(db);
+    int found = resident_db_find_duplicates(&writer, name, cpf, threshold, duplicates, max);
+    int rc = resident_db_insert(db, cpf, name, age, health_status, needs, medical_assistance, gender);
+    if (rc == SQLITE_OK && found > 0) {
+        *duplicate_count = found;
+    }
+    return rc;
+}
+
 int resident_db_update(
     database *db,
     const char *cpf,
@@ -123,13 +555,26 @@ int resident_db_update(
     int medical_assistance_input,
     int gender_input
 ) {
+    if (db_is_remote(db)) {
+        return db_client_resident_update(
+            db->remote,
+            cpf,
+            name_input,
+            age_input,
+            health_status_input,
+            needs_input,
+            medical_assistance_input,
+            gender_input
+        );
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
     struct resident currentResident = { 0 };
-    int rc = resident_db_get_by_cpf(db, cpf, &currentResident);
+    database writer = db_writer(db);
+    int rc = resident_db_get_by_cpf(&writer, cpf, &currentResident);
 
     if (rc != SQLITE_OK) {
         fprintf(
@@ -152,9 +597,12 @@ int resident_db_update(
         (medical_assistance_input > 0) ? medical_assistance_input : currentResident.medical_assistance;
     int gender = (gender_input >= 0) ? gender_input : (int)currentResident.gender;
 
+    char name_key[NAME_KEY_LEN];
+    name_phonetic_key(name, name_key);
+
     const char *sql =
         "UPDATE Resident SET Name = ?, Age = ?, HealthStatus = ?, Needs = ?, MedicalAssistance = ?, Gender "
-        "= ? WHERE CPF = ?;";
+        "= ?, NameKey = ?, " DB_CHANGES_RESTAMP("Resident") " WHERE CPF = ?;";
 
     sqlite3_stmt *stmt;
     rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
@@ -169,7 +617,8 @@ int resident_db_update(
     sqlite3_bind_text(stmt, 4, needs, -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 5, medical_assistance ? 1 : 0);
     sqlite3_bind_int(stmt, 6, gender);
-    sqlite3_bind_text(stmt, 7, cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, name_key, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 8, currentResident.cpf_packed);
 
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
@@ -187,16 +636,22 @@ int resident_db_update(
 }
 
 int resident_db_delete_by_cpf(database *db, const char *cpf) {
+    if (db_is_remote(db)) {
+        return db_client_resident_delete_by_cpf(db->remote, cpf);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!resident_db_check_cpf_exists(db, cpf)) {
+    database writer = db_writer(db);
+    if (!resident_db_check_cpf_exists(&writer, cpf)) {
         fprintf(stderr, "CPF not found in the dabatase.\n");
         return SQLITE_NOTFOUND;
     }
 
+    int64_t cpf_key = resident_db_cpf_pack(cpf); // Valid, it was found above
+
     // Prepare the SQL delete statement
     const char *sql = "DELETE FROM Resident WHERE CPF = ?;";
 
@@ -208,7 +663,7 @@ int resident_db_delete_by_cpf(database *db, const char *cpf) {
     }
 
     // Bind the CPF parameter
-    sqlite3_bind_text(stmt, 1, cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 1, cpf_key);
 
     // Execute the DELETE statement
     rc = sqlite3_step(stmt);
@@ -222,11 +677,27 @@ int resident_db_delete_by_cpf(database *db, const char *cpf) {
 }
 
 bool resident_db_check_cpf_exists(database *db, const char *cpf) {
+    if (db_is_remote(db)) {
+        return db_client_resident_check_cpf_exists(db->remote, cpf);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return false;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        bool result = resident_db_check_cpf_exists(&reader, cpf);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        return false; // Not a CPF, cannot be stored
+    }
+
     const char *sql = "SELECT 1 FROM Resident WHERE CPF = ?;";
 
     sqlite3_stmt *stmt;
@@ -236,7 +707,7 @@ bool resident_db_check_cpf_exists(database *db, const char *cpf) {
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 1, cpf_key);
 
     bool exists = false;
     rc = sqlite3_step(stmt);
@@ -257,11 +728,28 @@ bool resident_db_check_cpf_exists(database *db, const char *cpf) {
 }
 
 int resident_db_get_by_cpf(database *db, const char *cpf, struct resident *resident) {
+    if (db_is_remote(db)) {
+        return db_client_resident_get_by_cpf(db->remote, cpf, resident);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_get_by_cpf(&reader, cpf, resident);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        fprintf(stderr, "No resident found with CPF: %s\n", cpf);
+        return SQLITE_NOTFOUND;
+    }
+
     const char *sql =
         "SELECT CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate FROM Resident WHERE CPF = ?;";
 
@@ -272,18 +760,20 @@ int resident_db_get_by_cpf(database *db, const char *cpf, struct resident *resid
         return rc;
     }
 
-    sqlite3_bind_text(stmt, 1, cpf, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 1, cpf_key);
 
     rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
-        strcpy(resident->cpf, (const char *)sqlite3_column_text(stmt, 0));
+        resident->cpf_packed = sqlite3_column_int64(stmt, 0);
+        resident_db_cpf_unpack(resident->cpf_packed, resident->cpf);
         strcpy(resident->name, (const char *)sqlite3_column_text(stmt, 1));
         resident->age = sqlite3_column_int(stmt, 2);
         strcpy(resident->health_status, (const char *)sqlite3_column_text(stmt, 3));
         strcpy(resident->needs, (const char *)sqlite3_column_text(stmt, 4));
         resident->medical_assistance = sqlite3_column_int(stmt, 5);
         resident->gender = sqlite3_column_int(stmt, 6);
-        strcpy(resident->entry_date, (const char *)sqlite3_column_text(stmt, 7));
+        resident->entry_day = db_column_day(stmt, 7);
+        date_format(resident->entry_day, resident->entry_date);
         rc = SQLITE_OK; // Found and read successfully
     } else if (rc == SQLITE_DONE) {
         fprintf(stderr, "No resident found with CPF: %s\n", cpf);
@@ -297,11 +787,22 @@ int resident_db_get_by_cpf(database *db, const char *cpf, struct resident *resid
 }
 
 int resident_db_get_count(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_resident_get_count(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_get_count(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT COUNT(*) FROM Resident;";
 
     sqlite3_stmt *stmt;
@@ -322,12 +823,166 @@ int resident_db_get_count(database *db) {
     return count;
 }
 
+int resident_db_search(
+    database *db,
+    const char *query,
+    int limit,
+    resident_callback callback,
+    void *ctx
+) {
+    if (db_is_remote(db)) {
+        return db_client_resident_search(db->remote, query, limit, callback, ctx);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_search(&reader, query, limit, callback, ctx);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!query || !callback || limit <= 0) {
+        fprintf(stderr, "Invalid search arguments provided.\n");
+        return -1;
+    }
+
+    char match[MAX_INPUT * 2];
+    if (resident_db_build_match_query(query, match, sizeof(match)) == 0) {
+        return 0; // Nothing searchable typed yet
+    }
+
+    // Every match is scored and only the best `limit` are joined back to Resident. The matches stream
+    // in CPF order, ranking only the first ones would drop better hits with a higher CPF.
+    // bm25 weights: a hit in the name is worth more than a hit in the descriptions
+    const char *sql =
+        "SELECT r.CPF, r.Name, r.Age, r.HealthStatus, r.Needs, r.MedicalAssistance, r.Gender, r.EntryDate "
+        "FROM (SELECT rowid AS id, rank "
+        "      FROM ResidentSearch WHERE ResidentSearch MATCH ? AND rank MATCH 'bm25(10.0, 1.0, 1.0)' "
+        "      ORDER BY rank LIMIT ?) s "
+        "JOIN Resident r ON r.CPF = s.id "
+        "ORDER BY s.rank;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    int found = 0;
+    struct resident resident;
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        resident_db_read_row(stmt, &resident);
+
+        found++;
+        if (callback(ctx, &resident) != 0) {
+            rc = SQLITE_DONE; // Caller asked to stop early
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute search: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int resident_db_entered_between(
+    database *db,
+    int32_t from_day,
+    int32_t to_day,
+    resident_callback callback,
+    void *ctx
+) {
+    if (db_is_remote(db)) {
+        return db_client_resident_entered_between(db->remote, from_day, to_day, callback, ctx);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_entered_between(&reader, from_day, to_day, callback, ctx);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!callback) {
+        fprintf(stderr, "Invalid callback provided.\n");
+        return -1;
+    }
+
+    // Range scan on Resident_EntryDate, residents without an entry date (NULL) never match
+    const char *sql =
+        "SELECT CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate FROM Resident "
+        "WHERE EntryDate BETWEEN ? AND ? ORDER BY EntryDate;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, from_day);
+    sqlite3_bind_int(stmt, 2, to_day);
+
+    int found = 0;
+    struct resident resident;
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        resident_db_read_row(stmt, &resident);
+
+        found++;
+        if (callback(ctx, &resident) != 0) {
+            rc = SQLITE_DONE; // Caller asked to stop early
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return found;
+}
+
 int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (db_is_remote(db)) {
+        return db_client_resident_get_all_format(db->remote, buffer, buffer_size);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_get_all_format(&reader, buffer, buffer_size);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     if (!buffer || buffer_size == 0) {
         fprintf(stderr, "Invalid buffer provided.\n");
         return -1;
@@ -363,7 +1018,7 @@ int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
     } else {
         // Truncate but ensure null termination
         if (buffer_size > 0) {
-            strncpy(buffer, header, buffer_size - 1);
+            memcpy(buffer, header, buffer_size - 1); // header_len >= buffer_size here
             buffer[buffer_size - 1] = '\0';
         }
         sqlite3_finalize(stmt);
@@ -372,30 +1027,8 @@ int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
 
     // Process each row
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        const char *cpf = (const char *)sqlite3_column_text(stmt, 0);
-        const char *name = (const char *)sqlite3_column_text(stmt, 1);
-        int age = sqlite3_column_int(stmt, 2);
-        const char *health_status = (const char *)sqlite3_column_text(stmt, 3);
-        const char *needs = (const char *)sqlite3_column_text(stmt, 4);
-        int medical_assistance = sqlite3_column_int(stmt, 5);
-        int gender = sqlite3_column_int(stmt, 6);
-        const char *entry_date = (const char *)sqlite3_column_text(stmt, 7);
-
-        // Format the row
         char row[2048];
-        snprintf(
-            row,
-            sizeof(row),
-            "| %-11s | %-42s | %-3d | %-42s | %-42s | %-18s | %-6s | %-10s |\n",
-            cpf,
-            name,
-            age,
-            health_status,
-            needs,
-            (medical_assistance == 0 ? "False" : "True"),
-            (gender == 0 ? "Other" : (gender == 1 ? "Male" : "Female")),
-            entry_date
-        );
+        resident_db_format_row(stmt, row, sizeof(row));
 
         size_t row_len = strlen(row);
         if (written + row_len < buffer_size) {
@@ -412,10 +1045,7 @@ int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
         }
 
         // Add separator line
-        const char *separator =
-            "+-------------+--------------------------------------------+-----+-------------------------------------"
-            "-----"
-            "--+--------------------------------------------+--------------------+--------+------------+\n";
+        const char *separator = RESIDENT_TABLE_SEPARATOR;
 
         size_t separator_len = strlen(separator);
         if (written + separator_len < buffer_size) {
@@ -442,12 +1072,79 @@ int resident_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
     return written;
 }
 
+int resident_db_get_format_by_cpf(database *db, const char *cpf, char *buffer, size_t buffer_size) {
+    if (db_is_remote(db)) {
+        return db_client_resident_get_format_by_cpf(db->remote, cpf, buffer, buffer_size);
+    }
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_get_format_by_cpf(&reader, cpf, buffer, buffer_size);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        return 0;
+    }
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, "SELECT * FROM Resident WHERE CPF = ?;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, cpf_key);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        sqlite3_finalize(stmt);
+        return 0;
+    }
+    if (rc != SQLITE_ROW) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    char row[2048];
+    resident_db_format_row(stmt, row, sizeof(row));
+    sqlite3_finalize(stmt);
+
+    int written = snprintf(buffer, buffer_size, "%s%s", row, RESIDENT_TABLE_SEPARATOR);
+    if (written < 0 || (size_t)written >= buffer_size) {
+        buffer[0] = '\0';
+        return -1;
+    }
+    return written;
+}
+
 char *resident_db_get_all_format_old(database *db) {
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return NULL;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        char *result = resident_db_get_all_format_old(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT * FROM Resident;";
     sqlite3_stmt *stmt;
 
@@ -495,14 +1192,16 @@ char *resident_db_get_all_format_old(database *db) {
 
     // Process each row
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        const char *cpf = (const char *)sqlite3_column_text(stmt, 0);
+        char cpf[MAX_CPF_LENGTH];
+        resident_db_cpf_unpack(sqlite3_column_int64(stmt, 0), cpf);
         const char *name = (const char *)sqlite3_column_text(stmt, 1);
         int age = sqlite3_column_int(stmt, 2);
         const char *health_status = (const char *)sqlite3_column_text(stmt, 3);
         const char *needs = (const char *)sqlite3_column_text(stmt, 4);
         int medical_assistance = sqlite3_column_int(stmt, 5);
         int gender = sqlite3_column_int(stmt, 6);
-        const char *entry_date = (const char *)sqlite3_column_text(stmt, 7);
+        char entry_date[DATE_STR_LEN];
+        date_format(db_column_day(stmt, 7), entry_date);
 
         // Format the row
         char row[2048];
@@ -575,11 +1274,22 @@ char *resident_db_get_all_format_old(database *db) {
 }
 
 int resident_db_get_all(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_resident_get_all(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = resident_db_get_all(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT * FROM Resident;";
 
     sqlite3_stmt *stmt;
@@ -602,14 +1312,16 @@ int resident_db_get_all(database *db) {
     );
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        const char *cpf = (const char *)sqlite3_column_text(stmt, 0);
+        char cpf[MAX_CPF_LENGTH];
+        resident_db_cpf_unpack(sqlite3_column_int64(stmt, 0), cpf);
         const char *name = (const char *)sqlite3_column_text(stmt, 1);
         int age = sqlite3_column_int(stmt, 2);
         const char *health_status = (const char *)sqlite3_column_text(stmt, 3);
         const char *needs = (const char *)sqlite3_column_text(stmt, 4);
         int medical_assistance = sqlite3_column_int(stmt, 5);
         int gender = sqlite3_column_int(stmt, 6);
-        const char *entry_date = (const char *)sqlite3_column_text(stmt, 7);
+        char entry_date[DATE_STR_LEN];
+        date_format(db_column_day(stmt, 7), entry_date);
 
         printf(
             "| %-11s | %-42s | %-3d | %-42s | %-42s | %-18s | %-6s | %-10s |\n",
@@ -636,3 +1348,104 @@ int resident_db_get_all(database *db) {
     sqlite3_finalize(stmt);
     return rc == SQLITE_DONE ? SQLITE_OK : rc; // Return based on step result
 }
+
+/**
+ * @internal
+ * @brief Turns free text typed by the user into a safe FTS5 prefix query
+ *
+ * Every run of letters/digits becomes a quoted prefix term, e.g. `mar sil` -> `"mar"* "sil"*`,
+ * so punctuation typed by the user can never be parsed as FTS5 syntax. Terms are implicitly ANDed.
+ * Bytes >= 0x80 are kept as part of words so accented (UTF-8) names still match.
+ *
+ * @return Number of terms written, 0 if the input has nothing searchable or does not fit
+ */
+static size_t resident_db_build_match_query(const char *input, char *out, size_t out_size) {
+    size_t terms = 0;
+    size_t written = 0;
+    const unsigned char *p = (const unsigned char *)input;
+
+    out[0] = '\0';
+
+    while (*p) {
+        while (*p && !(isalnum(*p) || *p >= 0x80)) {
+            p++;
+        }
+
+        const unsigned char *start = p;
+        while (*p && (isalnum(*p) || *p >= 0x80)) {
+            p++;
+        }
+
+        size_t len = (size_t)(p - start);
+        if (len == 0) {
+            continue;
+        }
+
+        // separator + quote + term + quote + star + null
+        if (written + len + 5 > out_size) {
+            return 0;
+        }
+
+        if (terms > 0) {
+            out[written++] = ' ';
+        }
+        out[written++] = '"';
+        memcpy(out + written, start, len);
+        written += len;
+        out[written++] = '"';
+        out[written++] = '*';
+        out[written] = '\0';
+        terms++;
+    }
+
+    return terms;
+}
+
+/**
+ * @internal
+ * @brief Reads a row of (CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate)
+ */
+static void resident_db_read_row(sqlite3_stmt *stmt, struct resident *resident) {
+    memset(resident, 0, sizeof(*resident));
+    resident->cpf_packed = sqlite3_column_int64(stmt, 0);
+    resident_db_cpf_unpack(resident->cpf_packed, resident->cpf);
+    snprintf(resident->name, sizeof(resident->name), "%s", (const char *)sqlite3_column_text(stmt, 1));
+    resident->age = sqlite3_column_int(stmt, 2);
+    snprintf(resident->health_status, sizeof(resident->health_status), "%s", (const char *)sqlite3_column_text(stmt, 3));
+    snprintf(resident->needs, sizeof(resident->needs), "%s", (const char *)sqlite3_column_text(stmt, 4));
+    resident->medical_assistance = sqlite3_column_int(stmt, 5);
+    resident->gender = sqlite3_column_int(stmt, 6);
+    resident->entry_day = db_column_day(stmt, 7);
+    date_format(resident->entry_day, resident->entry_date);
+}
+
+/**
+ * @internal
+ * @brief Formats a row of SELECT * FROM Resident as a line of the resident_db_get_all_format() table
+ */
+static void resident_db_format_row(sqlite3_stmt *stmt, char *row, size_t row_size) {
+    char cpf[MAX_CPF_LENGTH];
+    resident_db_cpf_unpack(sqlite3_column_int64(stmt, 0), cpf);
+    const char *name = (const char *)sqlite3_column_text(stmt, 1);
+    int age = sqlite3_column_int(stmt, 2);
+    const char *health_status = (const char *)sqlite3_column_text(stmt, 3);
+    const char *needs = (const char *)sqlite3_column_text(stmt, 4);
+    int medical_assistance = sqlite3_column_int(stmt, 5);
+    int gender = sqlite3_column_int(stmt, 6);
+    char entry_date[DATE_STR_LEN];
+    date_format(db_column_day(stmt, 7), entry_date);
+
+    snprintf(
+        row,
+        row_size,
+        "| %-11s | %-42s | %-3d | %-42s | %-42s | %-18s | %-6s | %-10s |\n",
+        cpf,
+        name,
+        age,
+        health_status,
+        needs,
+        (medical_assistance == 0 ? "False" : "True"),
+        (gender == 0 ? "Other" : (gender == 1 ? "Male" : "Female")),
+        entry_date
+    );
+}
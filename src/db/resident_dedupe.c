@@ -0,0 +1,426 @@
+/**
+ * @file resident_dedupe.c
+ * @brief Duplicate resident detection implementation
+ */
+#include "db/resident_dedupe.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/resident_db.h"
+#include "utils/utils_name.h"
+
+/**
+ * @internal
+ * @brief One resident known to the index
+ */
+struct dedupe_entry {
+    int64_t cpf;            ///< Packed CPF (resident_db_cpf_pack()), -1 once removed
+    char key[NAME_KEY_LEN]; ///< Phonetic key of the name
+    char *name;             ///< Owned copy of the name
+    uint8_t trigram_count;  ///< Distinct trigrams of the name
+};
+
+/**
+ * @internal
+ * @brief Entries containing one trigram (inverted index)
+ */
+struct posting_list {
+    int32_t *ids;
+    int32_t count;
+    int32_t capacity;
+};
+
+struct resident_dedupe {
+    struct dedupe_entry *entries;
+    int32_t count;
+    int32_t capacity;
+
+    struct posting_list postings[NAME_TRIGRAM_SPACE]; ///< Indexed directly by trigram code
+
+    uint8_t *shared;  ///< Per entry scratch: trigrams shared with the query (all zero between queries)
+    int32_t *touched; ///< Scratch: entries with shared > 0 during a query
+};
+
+/**
+ * @internal
+ * @brief Collects the residents of one phonetic key group for resident_dedupe_report()
+ */
+struct dedupe_block_entry {
+    struct resident_duplicate resident;
+    uint16_t trigrams[NAME_MAX_TRIGRAMS];
+    int trigram_count;
+};
+
+static bool resident_dedupe_add_packed(struct resident_dedupe *rd, int64_t cpf, const char *name);
+
+static bool posting_list_push(struct posting_list *list, int32_t id) {
+    if (list->count == list->capacity) {
+        int32_t new_capacity = list->capacity ? list->capacity * 2 : 4;
+        int32_t *ids = realloc(list->ids, sizeof(int32_t) * new_capacity);
+        if (!ids) {
+            return false;
+        }
+        list->ids = ids;
+        list->capacity = new_capacity;
+    }
+    list->ids[list->count++] = id;
+    return true;
+}
+
+static bool resident_dedupe_reserve(struct resident_dedupe *rd) {
+    if (rd->count < rd->capacity) {
+        return true;
+    }
+
+    int32_t new_capacity = rd->capacity ? rd->capacity * 2 : 256;
+    struct dedupe_entry *entries = realloc(rd->entries, sizeof(struct dedupe_entry) * new_capacity);
+    if (!entries) {
+        return false;
+    }
+    rd->entries = entries;
+
+    uint8_t *shared = realloc(rd->shared, sizeof(uint8_t) * new_capacity);
+    if (!shared) {
+        return false;
+    }
+    memset(shared + rd->capacity, 0, sizeof(uint8_t) * (new_capacity - rd->capacity));
+    rd->shared = shared;
+
+    int32_t *touched = realloc(rd->touched, sizeof(int32_t) * new_capacity);
+    if (!touched) {
+        return false;
+    }
+    rd->touched = touched;
+
+    rd->capacity = new_capacity;
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Applies the same-sound boost of name_similarity() to a trigram similarity
+ */
+static float dedupe_score(float trigram_similarity, const char *key_a, const char *key_b) {
+    if (key_a[0] != '\0' && strcmp(key_a, key_b) == 0) {
+        return 0.5f + trigram_similarity / 2.0f;
+    }
+    return trigram_similarity;
+}
+
+struct resident_dedupe *resident_dedupe_load(database *db) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return NULL;
+    }
+
+    struct resident_dedupe *rd = calloc(1, sizeof(struct resident_dedupe));
+    if (!rd) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    // A full scan, kept off the writer when there is a pool
+    database reader;
+    db_pool_acquire(db, &reader);
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(reader.db, "SELECT CPF, Name FROM Resident;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(reader.db));
+        db_pool_release(db, &reader);
+        resident_dedupe_free(rd);
+        return NULL;
+    }
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *name = (const char *)sqlite3_column_text(stmt, 1);
+        if (!resident_dedupe_add_packed(rd, sqlite3_column_int64(stmt, 0), name ? name : "")) {
+            fprintf(stderr, "Memory allocation failed while loading the dedupe index.\n");
+            rc = SQLITE_NOMEM;
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        if (rc != SQLITE_NOMEM) {
+            fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(reader.db));
+        }
+        sqlite3_finalize(stmt);
+        db_pool_release(db, &reader);
+        resident_dedupe_free(rd);
+        return NULL;
+    }
+
+    sqlite3_finalize(stmt);
+    db_pool_release(db, &reader);
+    return rd;
+}
+
+bool resident_dedupe_add(struct resident_dedupe *rd, const char *cpf, const char *name) {
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (cpf_key < 0) {
+        return false;
+    }
+    return resident_dedupe_add_packed(rd, cpf_key, name);
+}
+
+/**
+ * @internal
+ * @brief Adds an entry by its packed CPF, as read straight from the table
+ */
+static bool resident_dedupe_add_packed(struct resident_dedupe *rd, int64_t cpf, const char *name) {
+    if (!rd || !resident_dedupe_reserve(rd)) {
+        return false;
+    }
+
+    uint16_t trigrams[NAME_MAX_TRIGRAMS];
+    int trigram_count = name_trigrams(name, trigrams);
+
+    struct dedupe_entry *entry = &rd->entries[rd->count];
+    entry->name = malloc(strlen(name) + 1);
+    if (!entry->name) {
+        return false;
+    }
+    strcpy(entry->name, name);
+    entry->cpf = cpf;
+    name_phonetic_key(name, entry->key);
+    entry->trigram_count = (uint8_t)trigram_count;
+
+    for (int i = 0; i < trigram_count; i++) {
+        if (!posting_list_push(&rd->postings[trigrams[i]], rd->count)) {
+            // Earlier pushes point at an entry that is never published, mark it removed
+            entry->cpf = -1;
+            rd->count++;
+            return false;
+        }
+    }
+
+    rd->count++;
+    return true;
+}
+
+void resident_dedupe_remove(struct resident_dedupe *rd, const char *cpf) {
+    int64_t cpf_key = resident_db_cpf_pack(cpf);
+    if (!rd || cpf_key < 0) {
+        return;
+    }
+
+    // Removal is rare (delete, rename), a tombstone keeps the posting lists untouched
+    for (int32_t i = 0; i < rd->count; i++) {
+        if (rd->entries[i].cpf == cpf_key) {
+            rd->entries[i].cpf = -1;
+            return;
+        }
+    }
+}
+
+int resident_dedupe_find(
+    struct resident_dedupe *rd,
+    const char *name,
+    const char *exclude_cpf,
+    float threshold,
+    struct resident_duplicate *out,
+    int max
+) {
+    if (!rd || !name || !out || max <= 0) {
+        return 0;
+    }
+
+    uint16_t trigrams[NAME_MAX_TRIGRAMS];
+    int trigram_count = name_trigrams(name, trigrams);
+    if (trigram_count == 0) {
+        return 0;
+    }
+
+    char key[NAME_KEY_LEN];
+    name_phonetic_key(name, key);
+
+    int64_t exclude = exclude_cpf ? resident_db_cpf_pack(exclude_cpf) : -1;
+
+    // Count shared trigrams per entry by walking the posting list of each query trigram
+    int32_t touched_count = 0;
+    for (int i = 0; i < trigram_count; i++) {
+        const struct posting_list *list = &rd->postings[trigrams[i]];
+        for (int32_t j = 0; j < list->count; j++) {
+            int32_t id = list->ids[j];
+            if (rd->shared[id]++ == 0) {
+                rd->touched[touched_count++] = id;
+            }
+        }
+    }
+
+    int found = 0;
+    for (int32_t i = 0; i < touched_count; i++) {
+        int32_t id = rd->touched[i];
+        int shared = rd->shared[id];
+        rd->shared[id] = 0; // Leave the scratch clean for the next query
+
+        const struct dedupe_entry *entry = &rd->entries[id];
+        if (entry->cpf < 0 || entry->cpf == exclude) {
+            continue;
+        }
+
+        float similarity = (float)shared / (float)(trigram_count + entry->trigram_count - shared);
+        similarity = dedupe_score(similarity, key, entry->key);
+        if (similarity < threshold) {
+            continue;
+        }
+
+        // Keep the best max candidates, sorted by score (insertion into a short array)
+        int pos = found < max ? found : max;
+        while (pos > 0 && out[pos - 1].similarity < similarity) {
+            if (pos < max) {
+                out[pos] = out[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max) {
+            resident_db_cpf_unpack(entry->cpf, out[pos].cpf);
+            snprintf(out[pos].name, sizeof(out[pos].name), "%s", entry->name);
+            out[pos].similarity = similarity;
+            if (found < max) {
+                found++;
+            }
+        }
+    }
+
+    return found;
+}
+
+void resident_dedupe_free(struct resident_dedupe *rd) {
+    if (!rd) {
+        return;
+    }
+
+    for (int32_t i = 0; i < rd->count; i++) {
+        free(rd->entries[i].name);
+    }
+    for (int i = 0; i < NAME_TRIGRAM_SPACE; i++) {
+        free(rd->postings[i].ids);
+    }
+    free(rd->entries);
+    free(rd->shared);
+    free(rd->touched);
+    free(rd);
+}
+
+/**
+ * @internal
+ * @brief Compares every pair inside one phonetic key group
+ *
+ * @return false if the callback asked to stop the report
+ */
+static bool dedupe_report_block(
+    const struct dedupe_block_entry *block,
+    int count,
+    float threshold,
+    resident_dedupe_callback callback,
+    void *ctx,
+    int *pairs
+) {
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            float similarity = name_trigram_similarity(
+                block[i].trigrams,
+                block[i].trigram_count,
+                block[j].trigrams,
+                block[j].trigram_count
+            );
+            similarity = 0.5f + similarity / 2.0f; // Same phonetic key by construction
+
+            if (similarity < threshold) {
+                continue;
+            }
+
+            struct resident_duplicate other = block[j].resident;
+            other.similarity = similarity;
+            (*pairs)++;
+            if (callback(ctx, &block[i].resident, &other) != 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int resident_dedupe_report(database *db, float threshold, resident_dedupe_callback callback, void *ctx) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (!callback) {
+        fprintf(stderr, "Invalid dedupe report arguments provided.\n");
+        return -1;
+    }
+
+    // Walks the Resident_NameKey index, so rows arrive grouped by phonetic key
+    const char *sql = "SELECT CPF, Name, NameKey FROM Resident WHERE NameKey > '' ORDER BY NameKey;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    struct dedupe_block_entry *block = NULL;
+    int block_count = 0;
+    int block_capacity = 0;
+    char block_key[NAME_KEY_LEN] = "";
+    int total = 0;
+    bool failed = false;
+
+    for (;;) {
+        rc = sqlite3_step(stmt);
+        const char *key = (rc == SQLITE_ROW) ? (const char *)sqlite3_column_text(stmt, 2) : NULL;
+
+        // Group ended (new key or no more rows): compare its members
+        if (block_count > 0 && (!key || strcmp(key, block_key) != 0)) {
+            if (!dedupe_report_block(block, block_count, threshold, callback, ctx, &total)) {
+                break; // Stopped by the callback
+            }
+            block_count = 0;
+        }
+
+        if (rc != SQLITE_ROW) {
+            failed = rc != SQLITE_DONE;
+            break;
+        }
+
+        if (block_count == 0) {
+            snprintf(block_key, sizeof(block_key), "%s", key);
+        }
+
+        if (block_count == block_capacity) {
+            int new_capacity = block_capacity ? block_capacity * 2 : 16;
+            struct dedupe_block_entry *new_block = realloc(block, sizeof(struct dedupe_block_entry) * new_capacity);
+            if (!new_block) {
+                fprintf(stderr, "Memory allocation failed.\n");
+                failed = true;
+                break;
+            }
+            block = new_block;
+            block_capacity = new_capacity;
+        }
+
+        struct dedupe_block_entry *entry = &block[block_count++];
+        const char *name = (const char *)sqlite3_column_text(stmt, 1);
+        resident_db_cpf_unpack(sqlite3_column_int64(stmt, 0), entry->resident.cpf);
+        snprintf(entry->resident.name, sizeof(entry->resident.name), "%s", name ? name : "");
+        entry->resident.similarity = 1.0f;
+        entry->trigram_count = name_trigrams(entry->resident.name, entry->trigrams);
+    }
+
+    if (failed && rc != SQLITE_ROW) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    free(block);
+    sqlite3_finalize(stmt);
+    return failed ? -1 : total;
+}
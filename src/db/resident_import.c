@@ -0,0 +1,759 @@
+/**
+ * @file resident_import.c
+ * @brief Parallel resident import implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For sysconf, sched_yield and strcasecmp
+
+#include "db/resident_import.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "db/db_changes.h"
+#include "db/resident_db.h"
+#include "db/resident_dedupe.h"
+#include "entities/resident.h"
+#include "global/CONSTANTS.h"
+#include "utils/utils_date.h"
+#include "utils/utils_name.h"
+#include "utils/utils_perf.h"
+#include "utils/utils_queue.h"
+
+#define IMPORT_QUEUE_DEPTH 4            ///< Chunks waiting per parser, batches waiting per parser at the writer
+#define IMPORT_LINE_MAX (8 * MAX_INPUT) ///< Longest line parsed, longer ones are rejected
+#define IMPORT_FIELDS 8                 ///< Fields of a row, entry_date included
+
+/**
+ * @internal
+ * @brief Whole lines read from the file
+ */
+struct import_chunk {
+    long first_line; ///< Line number of the first line
+    size_t len;      ///< Bytes in data
+    char data[];     ///< Lines, the last one may lack its newline at the end of the file
+};
+
+/**
+ * @internal
+ * @brief Validated row, ready to bind
+ */
+struct import_row {
+    long line;
+    int64_t cpf;
+    char name[MAX_INPUT];
+    int age;
+    char health_status[MAX_INPUT];
+    char needs[MAX_INPUT];
+    bool medical_assistance;
+    int gender;
+    int32_t entry_day;
+    char name_key[NAME_KEY_LEN];
+};
+
+struct import_batch {
+    int count;
+    struct import_row rows[RESIDENT_IMPORT_BATCH_ROWS];
+};
+
+struct import_pipeline;
+
+/**
+ * @internal
+ * @brief A parser thread, its input queue and counters
+ */
+struct import_parser {
+    pthread_t thread;
+    struct import_pipeline *pipeline;
+    struct spsc_queue chunks;   ///< Fed by the reader
+    struct import_batch *batch; ///< Being filled
+    uint64_t rows_valid;
+    uint64_t rows_invalid;
+    uint64_t batches;
+    uint64_t idles;
+    uint64_t stalls;
+    uint64_t busy_ns;
+};
+
+/**
+ * @internal
+ * @brief State shared by the stages
+ */
+struct import_pipeline {
+    FILE *in;
+    size_t chunk_size;
+    int32_t today; ///< Entry day of rows without one
+    int workers;
+    struct import_parser *parsers;
+    struct mpsc_queue batches; ///< Parsers to writer
+    atomic_bool reader_done;   ///< Set once the last chunk is queued
+    atomic_int parsers_done;   ///< Parsers that queued their last batch
+    atomic_int rc;             ///< First failure of any stage, SQLITE_OK until then
+    uint64_t bytes;            ///< Reader counters, read after it is joined
+    uint64_t chunks;
+    uint64_t lines;
+    uint64_t reader_stalls;
+    uint64_t reader_ns;
+};
+
+static int online_cores(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) {
+        return cores < RESIDENT_IMPORT_MAX_WORKERS ? (int)cores : RESIDENT_IMPORT_MAX_WORKERS;
+    }
+#endif
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Records the first failure, which makes every stage wind down
+ */
+static void import_fail(struct import_pipeline *p, int rc) {
+    int expected = SQLITE_OK;
+    atomic_compare_exchange_strong(&p->rc, &expected, rc);
+}
+
+static bool import_failed(struct import_pipeline *p) {
+    return atomic_load(&p->rc) != SQLITE_OK;
+}
+
+/* ======================= READER ======================= */
+
+/**
+ * @internal
+ * @brief New chunk holding a copy of len bytes and room to read size more
+ */
+static struct import_chunk *import_chunk_new(const char *data, size_t len, size_t size) {
+    struct import_chunk *chunk = malloc(sizeof(*chunk) + len + size);
+    if (chunk) {
+        if (len > 0) {
+            memcpy(chunk->data, data, len);
+        }
+        chunk->len = len;
+    }
+    return chunk;
+}
+
+/**
+ * @internal
+ * @brief Gives a chunk to the next parser with room, waiting while every queue is full
+ */
+static void import_deal(struct import_pipeline *p, struct import_chunk *chunk, int *next) {
+    for (;;) {
+        for (int i = 0; i < p->workers; i++) {
+            int w = (*next + i) % p->workers;
+            if (spsc_queue_push(&p->parsers[w].chunks, chunk)) {
+                *next = (w + 1) % p->workers;
+                p->chunks++;
+                return;
+            }
+        }
+        if (import_failed(p)) {
+            free(chunk);
+            return;
+        }
+        p->reader_stalls++;
+        sched_yield();
+    }
+}
+
+static void *import_read(void *arg) {
+    struct import_pipeline *p = arg;
+    long line = 1;
+    int next = 0;
+
+    struct import_chunk *chunk = import_chunk_new(NULL, 0, p->chunk_size);
+    if (!chunk) {
+        import_fail(p, SQLITE_NOMEM);
+    }
+    while (chunk && !import_failed(p)) {
+        uint64_t start = perf_now_ns();
+        size_t n = fread(chunk->data + chunk->len, 1, p->chunk_size, p->in);
+        chunk->len += n;
+        p->bytes += n;
+        bool end = n < p->chunk_size;
+        if (end && ferror(p->in)) {
+            import_fail(p, SQLITE_IOERR);
+            break;
+        }
+
+        // Cut after the last newline, the partial line after it starts the next chunk
+        size_t cut = chunk->len;
+        struct import_chunk *rest = NULL;
+        if (!end) {
+            while (cut > 0 && chunk->data[cut - 1] != '\n') {
+                cut--;
+            }
+            if (cut == 0) {
+                // Not one whole line yet, read more into a larger chunk
+                struct import_chunk *grown = realloc(chunk, sizeof(*chunk) + chunk->len + p->chunk_size);
+                if (!grown) {
+                    import_fail(p, SQLITE_NOMEM);
+                    break;
+                }
+                chunk = grown;
+                p->reader_ns += perf_now_ns() - start;
+                continue;
+            }
+            rest = import_chunk_new(chunk->data + cut, chunk->len - cut, p->chunk_size);
+            if (!rest) {
+                import_fail(p, SQLITE_NOMEM);
+                break;
+            }
+            chunk->len = cut;
+        }
+
+        chunk->first_line = line;
+        for (const char *nl = chunk->data; (nl = memchr(nl, '\n', chunk->data + chunk->len - nl)); nl++) {
+            line++;
+        }
+        if (end && chunk->len > 0 && chunk->data[chunk->len - 1] != '\n') {
+            line++; // Last line without its newline
+        }
+        p->reader_ns += perf_now_ns() - start;
+
+        if (chunk->len > 0) {
+            import_deal(p, chunk, &next);
+        } else {
+            free(chunk);
+        }
+        chunk = rest;
+        if (end) {
+            break;
+        }
+    }
+    free(chunk);
+
+    p->lines = (uint64_t)(line - 1);
+    atomic_store(&p->reader_done, true);
+    return NULL;
+}
+
+/* ======================= PARSERS ======================= */
+
+/**
+ * @internal
+ * @brief Splits a line in place, unquoting quoted fields and trimming unquoted ones
+ *
+ * @return Number of fields, -1 on a malformed quote or more than max fields
+ */
+static int import_split(char *line, char **fields, int max) {
+    int count = 0;
+    char *src = line;
+    for (;;) {
+        if (count == max) {
+            return -1;
+        }
+        while (*src == ' ' || *src == '\t') {
+            src++;
+        }
+        char *dst = src;
+        fields[count++] = dst;
+
+        if (*src == '"') {
+            src++;
+            for (;;) {
+                if (*src == '\0') {
+                    return -1;
+                }
+                if (*src == '"') {
+                    if (src[1] != '"') {
+                        src++;
+                        break;
+                    }
+                    src++; // "" is a quote
+                }
+                *dst++ = *src++;
+            }
+            while (*src == ' ' || *src == '\t') {
+                src++;
+            }
+            if (*src != ',' && *src != '\0') {
+                return -1;
+            }
+        } else {
+            while (*src != ',' && *src != '\0') {
+                *dst++ = *src++;
+            }
+            while (dst > fields[count - 1] && (dst[-1] == ' ' || dst[-1] == '\t')) {
+                dst--;
+            }
+        }
+
+        bool more = *src == ',';
+        *dst = '\0';
+        if (!more) {
+            return count;
+        }
+        src++;
+    }
+}
+
+/**
+ * @internal
+ * @brief Parses the medical assistance field
+ *
+ * @return 1 for yes, 0 for no, -1 if it is neither
+ */
+static int import_parse_flag(const char *value) {
+    static const char *const yes[] = { "1", "yes", "true", "y" };
+    static const char *const no[] = { "", "0", "no", "false", "n" };
+    for (size_t i = 0; i < sizeof(yes) / sizeof(yes[0]); i++) {
+        if (strcasecmp(value, yes[i]) == 0) {
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < sizeof(no) / sizeof(no[0]); i++) {
+        if (strcasecmp(value, no[i]) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Parses the gender field
+ *
+ * @return enum gender value, -1 if it is none
+ */
+static int import_parse_gender(const char *value) {
+    static const char *const names[][2] = {
+        [GENDER_OTHER] = { "0", "other" },
+        [GENDER_MALE] = { "1", "male" },
+        [GENDER_FEMALE] = { "2", "female" },
+    };
+    for (int g = 0; g < (int)(sizeof(names) / sizeof(names[0])); g++) {
+        if (strcmp(value, names[g][0]) == 0 || strcasecmp(value, names[g][1]) == 0) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+static bool import_copy_text(char *dst, const char *src) {
+    size_t len = strlen(src);
+    if (len >= MAX_INPUT) {
+        return false;
+    }
+    memcpy(dst, src, len + 1);
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Same rules as the resident screen
+ *
+ * @return Why the row is rejected, NULL if row was filled
+ */
+static const char *import_validate(struct import_pipeline *p, char **fields, int count, struct import_row *row) {
+    if (count < IMPORT_FIELDS - 1) {
+        return "missing fields";
+    }
+    if (!resident_db_cpf_valid(fields[0])) {
+        return "invalid CPF";
+    }
+    row->cpf = resident_db_cpf_pack(fields[0]);
+
+    if (fields[1][0] == '\0') {
+        return "name is empty";
+    }
+    if (!import_copy_text(row->name, fields[1])) {
+        return "name is too long";
+    }
+
+    char *end;
+    long age = strtol(fields[2], &end, 10);
+    if (fields[2][0] == '\0' || *end != '\0' || age < 0 || age > RESIDENT_IMPORT_MAX_AGE) {
+        return "age is not a number in range";
+    }
+    row->age = (int)age;
+
+    if (!import_copy_text(row->health_status, fields[3])) {
+        return "health status is too long";
+    }
+    if (!import_copy_text(row->needs, fields[4])) {
+        return "needs are too long";
+    }
+
+    int flag = import_parse_flag(fields[5]);
+    if (flag < 0) {
+        return "medical assistance must be yes or no";
+    }
+    row->medical_assistance = flag == 1;
+
+    row->gender = import_parse_gender(fields[6]);
+    if (row->gender < 0) {
+        return "gender must be other, male or female";
+    }
+
+    row->entry_day = count == IMPORT_FIELDS && fields[7][0] != '\0' ? date_parse(fields[7]) : p->today;
+    if (row->entry_day == DATE_INVALID) {
+        return "entry date must be a valid YYYY-MM-DD date";
+    }
+
+    name_phonetic_key(row->name, row->name_key);
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Queues the batch being filled for the writer, waiting while its queue is full
+ */
+static void import_hand_off(struct import_parser *parser) {
+    struct import_pipeline *p = parser->pipeline;
+    while (!mpsc_queue_push(&p->batches, parser->batch)) {
+        if (import_failed(p)) {
+            free(parser->batch);
+            parser->batch = NULL;
+            return;
+        }
+        parser->stalls++;
+        sched_yield();
+    }
+    parser->batches++;
+    parser->batch = NULL;
+}
+
+static void import_parse_line(struct import_parser *parser, const char *text, size_t len, long line) {
+    struct import_pipeline *p = parser->pipeline;
+    if (len > 0 && text[len - 1] == '\r') {
+        len--;
+    }
+
+    char buffer[IMPORT_LINE_MAX];
+    if (len >= sizeof(buffer)) {
+        fprintf(stderr, "Line %ld: line is too long.\n", line);
+        parser->rows_invalid++;
+        return;
+    }
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
+
+    char *start = buffer;
+    while (*start == ' ' || *start == '\t') {
+        start++;
+    }
+    if (*start == '\0' || *start == '#') {
+        return;
+    }
+
+    char *fields[IMPORT_FIELDS];
+    int count = import_split(start, fields, IMPORT_FIELDS);
+    if (line == 1 && count > 0 && strcasecmp(fields[0], "cpf") == 0) {
+        return; // Header
+    }
+
+    if (!parser->batch) {
+        parser->batch = malloc(sizeof(*parser->batch));
+        if (!parser->batch) {
+            import_fail(p, SQLITE_NOMEM);
+            return;
+        }
+        parser->batch->count = 0;
+    }
+    struct import_row *row = &parser->batch->rows[parser->batch->count];
+    const char *reason = count < 0 ? "malformed quotes or too many fields" : import_validate(p, fields, count, row);
+    if (reason) {
+        fprintf(stderr, "Line %ld: %s.\n", line, reason);
+        parser->rows_invalid++;
+        return;
+    }
+
+    row->line = line;
+    parser->rows_valid++;
+    if (++parser->batch->count == RESIDENT_IMPORT_BATCH_ROWS) {
+        import_hand_off(parser);
+    }
+}
+
+static void import_parse_chunk(struct import_parser *parser, const struct import_chunk *chunk) {
+    const char *pos = chunk->data;
+    const char *end = chunk->data + chunk->len;
+    long line = chunk->first_line;
+    while (pos < end && !import_failed(parser->pipeline)) {
+        const char *nl = memchr(pos, '\n', (size_t)(end - pos));
+        const char *stop = nl ? nl : end;
+        import_parse_line(parser, pos, (size_t)(stop - pos), line++);
+        pos = nl ? nl + 1 : end;
+    }
+}
+
+static void *import_parse(void *arg) {
+    struct import_parser *parser = arg;
+    struct import_pipeline *p = parser->pipeline;
+
+    for (;;) {
+        struct import_chunk *chunk = spsc_queue_pop(&parser->chunks);
+        if (!chunk) {
+            // Check for the end before popping again, a chunk queued before it is seen then
+            if (atomic_load(&p->reader_done) && !(chunk = spsc_queue_pop(&parser->chunks))) {
+                break;
+            }
+            if (!chunk) {
+                parser->idles++;
+                sched_yield();
+                continue;
+            }
+        }
+        if (!import_failed(p)) {
+            uint64_t start = perf_now_ns();
+            import_parse_chunk(parser, chunk);
+            parser->busy_ns += perf_now_ns() - start;
+        }
+        free(chunk);
+    }
+
+    if (parser->batch && parser->batch->count > 0 && !import_failed(p)) {
+        import_hand_off(parser);
+    }
+    free(parser->batch);
+    parser->batch = NULL;
+
+    atomic_fetch_add(&p->parsers_done, 1);
+    return NULL;
+}
+
+/* ======================= WRITER ======================= */
+
+/**
+ * @internal
+ * @brief Inserts the batches as they come until every parser is done
+ */
+static void import_write(
+    struct import_pipeline *p,
+    database *db,
+    int commit_rows,
+    bool check_duplicates,
+    struct resident_import_stats *stats
+) {
+    const char *sql =
+        "INSERT INTO Resident "
+        "(CPF, Name, Age, HealthStatus, Needs, MedicalAssistance, Gender, EntryDate, NameKey, Changed) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, " DB_CHANGES_STAMP("Resident") ");";
+
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        import_fail(p, rc);
+    }
+
+    bool in_transaction = false;
+    uint64_t pending = 0; // Rows inserted in the open transaction
+    database writer = db_writer(db);
+    for (;;) {
+        struct import_batch *batch = mpsc_queue_pop(&p->batches);
+        if (!batch) {
+            if (atomic_load(&p->parsers_done) == p->workers && !(batch = mpsc_queue_pop(&p->batches))) {
+                break;
+            }
+            if (!batch) {
+                stats->writer_idles++;
+                sched_yield();
+                continue;
+            }
+        }
+        if (import_failed(p)) {
+            free(batch); // Drained so no parser waits on a full queue
+            continue;
+        }
+
+        uint64_t start = perf_now_ns();
+        if (!in_transaction) {
+            rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+            if (rc != SQLITE_OK) {
+                fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+                import_fail(p, rc);
+                free(batch);
+                continue;
+            }
+            in_transaction = true;
+        }
+
+        for (int i = 0; i < batch->count; i++) {
+            const struct import_row *row = &batch->rows[i];
+
+            // Same check as an insert at the screen, the rows written before in this import included
+            struct resident_duplicate duplicate;
+            char cpf[MAX_CPF_LENGTH];
+            resident_db_cpf_unpack(row->cpf, cpf);
+            int candidates = check_duplicates
+                ? resident_db_find_duplicates(&writer, row->name, cpf, RESIDENT_DEDUPE_THRESHOLD, &duplicate, 1)
+                : 0;
+
+            sqlite3_bind_int64(stmt, 1, row->cpf);
+            sqlite3_bind_text(stmt, 2, row->name, -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 3, row->age);
+            sqlite3_bind_text(stmt, 4, row->health_status, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, row->needs, -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 6, row->medical_assistance ? 1 : 0);
+            sqlite3_bind_int(stmt, 7, row->gender);
+            sqlite3_bind_int(stmt, 8, row->entry_day);
+            sqlite3_bind_text(stmt, 9, row->name_key, -1, SQLITE_STATIC);
+
+            rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc == SQLITE_DONE) {
+                pending++;
+                if (candidates > 0) {
+                    fprintf(
+                        stderr,
+                        "Line %ld: %s may be %s, CPF %s (%.0f%% alike).\n",
+                        row->line,
+                        row->name,
+                        duplicate.name,
+                        duplicate.cpf,
+                        duplicate.similarity * 100.0f
+                    );
+                    stats->rows_possible_duplicate++;
+                }
+            } else if (sqlite3_extended_errcode(db->db) == SQLITE_CONSTRAINT_PRIMARYKEY) {
+                fprintf(stderr, "Line %ld: CPF %s is already registered.\n", row->line, cpf);
+                stats->rows_duplicate++;
+            } else if ((rc & 0xff) == SQLITE_CONSTRAINT) {
+                fprintf(stderr, "Line %ld: %s\n", row->line, sqlite3_errmsg(db->db));
+                stats->rows_invalid++;
+            } else {
+                fprintf(stderr, "Line %ld: %s\n", row->line, sqlite3_errmsg(db->db));
+                import_fail(p, rc);
+                break;
+            }
+        }
+        free(batch);
+
+        if (!import_failed(p) && pending >= (uint64_t)commit_rows) {
+            rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+            if (rc != SQLITE_OK) {
+                fprintf(stderr, "Failed to commit: %s\n", sqlite3_errmsg(db->db));
+                import_fail(p, rc);
+            } else {
+                in_transaction = false;
+                stats->rows_inserted += pending;
+                stats->commits++;
+                pending = 0;
+            }
+        }
+        stats->writer_ns += perf_now_ns() - start;
+    }
+
+    if (in_transaction) {
+        uint64_t start = perf_now_ns();
+        if (!import_failed(p) && (rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0)) == SQLITE_OK) {
+            stats->rows_inserted += pending;
+            stats->commits++;
+        } else {
+            if (!import_failed(p)) {
+                fprintf(stderr, "Failed to commit: %s\n", sqlite3_errmsg(db->db));
+                import_fail(p, rc);
+            }
+            sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+        }
+        stats->writer_ns += perf_now_ns() - start;
+    }
+    sqlite3_finalize(stmt);
+}
+
+/* ======================= PIPELINE ======================= */
+
+int resident_import(
+    database *db,
+    FILE *in,
+    const struct resident_import_options *options,
+    struct resident_import_stats *stats
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct resident_import_options defaults = { 0 };
+    if (!options) {
+        options = &defaults;
+    }
+    int workers = options->workers > 0 ? options->workers : online_cores();
+    workers = workers < RESIDENT_IMPORT_MAX_WORKERS ? workers : RESIDENT_IMPORT_MAX_WORKERS;
+    int commit_rows = options->commit_rows > 0 ? options->commit_rows : RESIDENT_IMPORT_COMMIT_ROWS;
+
+    struct resident_import_stats s = { 0 };
+    uint64_t start = perf_now_ns();
+
+    struct import_pipeline p = { 0 };
+    p.in = in;
+    p.chunk_size = options->chunk_size > 0 ? options->chunk_size : RESIDENT_IMPORT_CHUNK_SIZE;
+    p.today = date_today();
+    atomic_init(&p.reader_done, false);
+    atomic_init(&p.parsers_done, 0);
+    atomic_init(&p.rc, SQLITE_OK);
+
+    p.parsers = calloc((size_t)workers, sizeof(*p.parsers));
+    bool ready = p.parsers && mpsc_queue_init(&p.batches, (size_t)workers * IMPORT_QUEUE_DEPTH);
+    for (int i = 0; ready && i < workers; i++) {
+        p.parsers[i].pipeline = &p;
+        ready = spsc_queue_init(&p.parsers[i].chunks, IMPORT_QUEUE_DEPTH);
+    }
+    if (!ready) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        for (int i = 0; p.parsers && i < workers; i++) {
+            spsc_queue_free(&p.parsers[i].chunks);
+        }
+        mpsc_queue_free(&p.batches);
+        free(p.parsers);
+        return SQLITE_NOMEM;
+    }
+
+    // The stages only look at p.workers once every parser that will run is started
+    for (; p.workers < workers; p.workers++) {
+        if (pthread_create(&p.parsers[p.workers].thread, NULL, import_parse, &p.parsers[p.workers]) != 0) {
+            break;
+        }
+    }
+    pthread_t reader;
+    bool reading = p.workers > 0 && pthread_create(&reader, NULL, import_read, &p) == 0;
+    if (!reading) {
+        fprintf(stderr, "Failed to start the import threads.\n");
+        import_fail(&p, SQLITE_ERROR);
+        atomic_store(&p.reader_done, true);
+    }
+
+    import_write(&p, db, commit_rows, options->check_duplicates, &s);
+
+    if (reading) {
+        pthread_join(reader, NULL);
+    }
+    for (int i = 0; i < p.workers; i++) {
+        pthread_join(p.parsers[i].thread, NULL);
+    }
+
+    s.workers = p.workers;
+    s.bytes = p.bytes;
+    s.chunks = p.chunks;
+    s.lines = p.lines;
+    s.reader_stalls = p.reader_stalls;
+    s.reader_ns = p.reader_ns;
+    for (int i = 0; i < workers; i++) {
+        const struct import_parser *parser = &p.parsers[i];
+        s.rows_valid += parser->rows_valid;
+        s.rows_invalid += parser->rows_invalid;
+        s.batches += parser->batches;
+        s.parser_idles += parser->idles;
+        s.parser_stalls += parser->stalls;
+        s.parser_ns += parser->busy_ns;
+        spsc_queue_free(&p.parsers[i].chunks);
+    }
+    s.elapsed_ns = perf_now_ns() - start;
+
+    mpsc_queue_free(&p.batches);
+    free(p.parsers);
+    if (stats) {
+        *stats = s;
+    }
+    return atomic_load(&p.rc);
+}
@@ -0,0 +1,226 @@
+/**
+ * @file resident_search.c
+ * @brief Background resident search worker implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For clock_gettime and pthread_cond_timedwait
+
+#include "db/resident_search.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "db/db_profile.h"
+#include "db/resident_db.h"
+
+struct resident_search {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    database *source; ///< Database searched, through its pool when it has one
+    database conn;    ///< Worker-owned read-only connection when source has no pool
+    bool stop;        ///< Set by resident_search_stop()
+
+    char query[MAX_INPUT];  ///< Latest submitted query
+    unsigned query_gen;     ///< Bumped on every submit
+    unsigned done_gen;      ///< Last query generation the worker finished
+    struct timespec due_at; ///< Debounce deadline for the pending query
+
+    struct resident results[RESIDENT_SEARCH_MAX_RESULTS]; ///< Results of the latest finished query
+    int result_count;
+    unsigned result_gen; ///< Generation the published results belong to
+};
+
+/**
+ * @internal
+ * @brief Collects results into a fixed array
+ */
+struct search_collect {
+    struct resident *results;
+    int count;
+};
+
+static int collect_result(void *ctx, const struct resident *resident) {
+    struct search_collect *collect = ctx;
+    collect->results[collect->count++] = *resident;
+    return collect->count >= RESIDENT_SEARCH_MAX_RESULTS;
+}
+
+static bool timespec_reached(const struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+static void *resident_search_worker(void *arg) {
+    struct resident_search *rs = arg;
+
+    // Kept off the stack of the caller, one batch of results is ~20KB
+    struct resident *found = malloc(sizeof(struct resident) * RESIDENT_SEARCH_MAX_RESULTS);
+    if (!found) {
+        fprintf(stderr, "Memory allocation failed for resident search worker.\n");
+        return NULL;
+    }
+
+    char query[MAX_INPUT];
+
+    pthread_mutex_lock(&rs->lock);
+    while (!rs->stop) {
+        if (rs->done_gen == rs->query_gen) {
+            pthread_cond_wait(&rs->cond, &rs->lock);
+            continue;
+        }
+
+        // Debounce: keep waiting while the user is still typing
+        if (!timespec_reached(&rs->due_at)) {
+            pthread_cond_timedwait(&rs->cond, &rs->lock, &rs->due_at);
+            continue;
+        }
+
+        unsigned gen = rs->query_gen;
+        memcpy(query, rs->query, sizeof(query));
+        pthread_mutex_unlock(&rs->lock);
+
+        struct search_collect collect = { .results = found, .count = 0 };
+        if (query[0] != '\0') {
+            // A pooled reader is only held for the query, other readers may need it in between.
+            // A served database is searched by its server, through the client.
+            database reader = rs->conn;
+            bool remote = db_is_remote(rs->source);
+            bool pooled = !remote && rs->conn.db == NULL;
+            if (pooled && db_pool_acquire(rs->source, &reader) != SQLITE_OK) {
+                reader.db = NULL;
+            }
+            database *searched = remote ? rs->source : reader.db ? &reader : NULL;
+            if (!searched
+                || resident_db_search(searched, query, RESIDENT_SEARCH_MAX_RESULTS, collect_result, &collect) < 0) {
+                collect.count = 0;
+            }
+            if (pooled) {
+                db_pool_release(rs->source, &reader);
+            }
+        }
+
+        pthread_mutex_lock(&rs->lock);
+        rs->done_gen = gen;
+        // Drop results that a newer keystroke already made stale
+        if (gen == rs->query_gen) {
+            memcpy(rs->results, found, sizeof(struct resident) * collect.count);
+            rs->result_count = collect.count;
+            rs->result_gen = gen;
+        }
+    }
+    pthread_mutex_unlock(&rs->lock);
+
+    free(found);
+    return NULL;
+}
+
+struct resident_search *resident_search_start(database *db) {
+    bool remote = db_is_remote(db);
+    if (!remote && !db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return NULL;
+    }
+
+    const char *filename = remote ? NULL : sqlite3_db_filename(db->db, "main");
+    if (!remote && (!filename || filename[0] == '\0')) {
+        fprintf(stderr, "Resident search needs a file backed database.\n");
+        return NULL;
+    }
+
+    struct resident_search *rs = calloc(1, sizeof(struct resident_search));
+    if (!rs) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+    rs->source = db;
+
+    // The connection is only ever touched by the worker thread, so no mutex is needed inside SQLite
+    if (!remote && db_pool_readers(db) == 0) {
+        int rc = sqlite3_open_v2(filename, &rs->conn.db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Can't open database for search: %s\n", sqlite3_errmsg(rs->conn.db));
+            db_deinit(&rs->conn);
+            free(rs);
+            return NULL;
+        }
+        sqlite3_busy_timeout(rs->conn.db, 100);
+        db_profile_attach(rs->conn.db);
+    }
+
+    pthread_mutex_init(&rs->lock, NULL);
+    pthread_cond_init(&rs->cond, NULL);
+
+    if (pthread_create(&rs->thread, NULL, resident_search_worker, rs) != 0) {
+        fprintf(stderr, "Failed to start resident search thread.\n");
+        pthread_cond_destroy(&rs->cond);
+        pthread_mutex_destroy(&rs->lock);
+        db_deinit(&rs->conn);
+        free(rs);
+        return NULL;
+    }
+
+    return rs;
+}
+
+void resident_search_submit(struct resident_search *rs, const char *query) {
+    if (!rs) {
+        return;
+    }
+
+    struct timespec due;
+    clock_gettime(CLOCK_REALTIME, &due);
+    due.tv_nsec += (long)RESIDENT_SEARCH_DEBOUNCE_MS * 1000000L;
+    if (due.tv_nsec >= 1000000000L) {
+        due.tv_sec += due.tv_nsec / 1000000000L;
+        due.tv_nsec %= 1000000000L;
+    }
+
+    pthread_mutex_lock(&rs->lock);
+    snprintf(rs->query, sizeof(rs->query), "%s", query);
+    rs->query_gen++;
+    rs->due_at = due;
+    pthread_cond_signal(&rs->cond);
+    pthread_mutex_unlock(&rs->lock);
+}
+
+bool resident_search_poll(struct resident_search *rs, struct resident *results, int *count, unsigned *generation) {
+    if (!rs) {
+        return false;
+    }
+
+    bool updated = false;
+
+    pthread_mutex_lock(&rs->lock);
+    if (rs->result_gen != *generation) {
+        memcpy(results, rs->results, sizeof(struct resident) * rs->result_count);
+        *count = rs->result_count;
+        *generation = rs->result_gen;
+        updated = true;
+    }
+    pthread_mutex_unlock(&rs->lock);
+
+    return updated;
+}
+
+void resident_search_stop(struct resident_search *rs) {
+    if (!rs) {
+        return;
+    }
+
+    pthread_mutex_lock(&rs->lock);
+    rs->stop = true;
+    pthread_cond_signal(&rs->cond);
+    pthread_mutex_unlock(&rs->lock);
+
+    pthread_join(rs->thread, NULL);
+
+    pthread_cond_destroy(&rs->cond);
+    pthread_mutex_destroy(&rs->lock);
+    db_deinit(&rs->conn);
+    free(rs);
+}
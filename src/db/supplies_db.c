@@ -6,6 +6,25 @@
 #include "db/supplies_db.h"
 
 #include <stdio.h>
+#include <string.h>
+
+// Columns read by supplies_db_read_row, in order
+#define SUPPLIES_SELECT "SELECT ID, Name, Category, Size, Unit, Quantity, Notes FROM Supplies"
+
+// Trigger statements adding a row (new or old) to its category total, or taking it out
+#define SUPPLIES_TOTALS_ADD(row)                                                                            \
+    "INSERT OR IGNORE INTO SuppliesCategoryTotals (Category, Items, Quantity) "                             \
+    "VALUES (COALESCE(" row ".Category, ''), 0, 0); "                                                       \
+    "UPDATE SuppliesCategoryTotals SET Items = Items + 1, Quantity = Quantity + " row ".Quantity "          \
+    "WHERE Category = COALESCE(" row ".Category, ''); "
+#define SUPPLIES_TOTALS_TAKE(row)                                                                           \
+    "UPDATE SuppliesCategoryTotals SET Items = Items - 1, Quantity = Quantity - " row ".Quantity "          \
+    "WHERE Category = COALESCE(" row ".Category, ''); "                                                     \
+    "DELETE FROM SuppliesCategoryTotals WHERE Category = COALESCE(" row ".Category, '') AND Items <= 0; "
+
+static int supplies_db_create_totals(database *db);
+
+static void supplies_db_read_row(sqlite3_stmt *stmt, struct supplies *supplies);
 
 int supplies_db_create_table(database *db) {
     if (!db_is_init(db)) {
@@ -34,5 +53,509 @@ int supplies_db_create_table(database *db) {
         return rc;
     }
 
+    return supplies_db_create_totals(db);
+}
+
+int supplies_db_insert(
+    database *db,
+    const char *name,
+    const char *category,
+    const char *size,
+    const char *unit,
+    int quantity,
+    const char *notes,
+    int *id
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "INSERT INTO Supplies (Name, Category, Size, Unit, Quantity, Notes) VALUES (?, ?, ?, ?, ?, ?);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    // Empty strings rather than NULL, so the UNIQUE constraint also holds for unset fields
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, category, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, quantity);
+    sqlite3_bind_text(stmt, 6, notes, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (id) {
+        *id = (int)sqlite3_last_insert_rowid(db->db);
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int supplies_db_update(
+    database *db,
+    int id,
+    const char *name,
+    const char *category,
+    const char *size,
+    const char *unit,
+    int quantity,
+    const char *notes
+) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    struct supplies current;
+    int rc = supplies_db_get_by_id(db, id, &current);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    const char *sql = "UPDATE Supplies SET Name = ?, Category = ?, Size = ?, Unit = ?, Quantity = ?, Notes = ? "
+                      "WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    // Decide which fields to use for update based on inputs
+    sqlite3_bind_text(stmt, 1, name[0] != '\0' ? name : current.name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, category[0] != '\0' ? category : current.category, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, size[0] != '\0' ? size : current.size, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, unit[0] != '\0' ? unit : current.unit, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, quantity >= 0 ? quantity : current.quantity);
+    sqlite3_bind_text(stmt, 6, notes[0] != '\0' ? notes : current.notes, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 7, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int supplies_db_delete_by_id(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "DELETE FROM Supplies WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    } else if (sqlite3_changes(db->db) == 0) {
+        fprintf(stderr, "Supplies ID not found in the database.\n");
+        rc = SQLITE_NOTFOUND;
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+bool supplies_db_check_id_exists(database *db, int id) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return false;
+    }
+
+    const char *sql = "SELECT 1 FROM Supplies WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+int supplies_db_get_by_id(database *db, int id, struct supplies *supplies) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = SUPPLIES_SELECT " WHERE ID = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_int(stmt, 1, id);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        supplies_db_read_row(stmt, supplies);
+        rc = SQLITE_OK;
+    } else if (rc == SQLITE_DONE) {
+        fprintf(stderr, "No supplies found with ID: %d\n", id);
+        rc = SQLITE_NOTFOUND;
+    } else {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int supplies_db_get_count(database *db) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql = "SELECT COUNT(*) FROM Supplies;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+int supplies_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    if (!buffer || buffer_size == 0) {
+        fprintf(stderr, "Invalid buffer provided.\n");
+        return -1;
+    }
+
+    const char *sql = SUPPLIES_SELECT " ORDER BY ID;";
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    buffer[0] = '\0';
+    size_t written = 0;
+
+    const char *header =
+        "+------------------------------------------------------------------------------------------------+\n"
+        "| ID    | Name                     | Category         | Size       | Unit       | Quantity        |\n"
+        "+-------+--------------------------+------------------+------------+------------+-----------------+\n";
+
+    size_t header_len = strlen(header);
+    if (header_len >= buffer_size) {
+        sqlite3_finalize(stmt);
+        fprintf(stderr, "Header truncated\n");
+        return -1;
+    }
+    memcpy(buffer, header, header_len + 1);
+    written = header_len;
+
+    struct supplies supplies;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        supplies_db_read_row(stmt, &supplies);
+
+        char row[512];
+        snprintf(
+            row,
+            sizeof(row),
+            "| %5d | %-24.24s | %-16.16s | %-10.10s | %-10.10s | %-15d |\n"
+            "+-------+--------------------------+------------------+------------+------------+-----------------+\n",
+            supplies.id,
+            supplies.name,
+            supplies.category,
+            supplies.size,
+            supplies.unit,
+            supplies.quantity
+        );
+
+        size_t row_len = strlen(row);
+        if (written + row_len >= buffer_size) {
+            sqlite3_finalize(stmt);
+            fprintf(stderr, "Buffer too small, output truncated\n");
+            return -1;
+        }
+        memcpy(buffer + written, row, row_len + 1);
+        written += row_len;
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return (int)written;
+}
+
+int supplies_db_receive_shipment(database *db, const struct supplies_line *lines, int count, int *failed_line) {
+    if (failed_line) {
+        *failed_line = -1;
+    }
+
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    if (count <= 0) {
+        return SQLITE_OK;
+    }
+
+    // IMMEDIATE takes the write lock up front, every line commits together with a single sync
+    int rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db->db, "UPDATE Supplies SET Quantity = Quantity + ? WHERE ID = ?;", -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        goto rollback;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (lines[i].quantity <= 0) {
+            rc = SQLITE_MISUSE;
+        } else {
+            sqlite3_bind_int(stmt, 1, lines[i].quantity);
+            sqlite3_bind_int(stmt, 2, lines[i].id);
+            rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+
+            if (rc != SQLITE_DONE) {
+                fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+            } else if (sqlite3_changes(db->db) == 0) {
+                fprintf(stderr, "Supplies ID %d of the shipment not found.\n", lines[i].id);
+                rc = SQLITE_NOTFOUND;
+            } else {
+                rc = SQLITE_OK;
+            }
+        }
+
+        if (rc != SQLITE_OK) {
+            if (failed_line) {
+                *failed_line = i;
+            }
+            sqlite3_finalize(stmt);
+            goto rollback;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+    if (rc == SQLITE_OK) {
+        return SQLITE_OK;
+    }
+    fprintf(stderr, "Failed to commit shipment: %s\n", sqlite3_errmsg(db->db));
+
+rollback:
+    sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    return rc;
+}
+
+int supplies_db_get_category_total(database *db, const char *category, struct supplies_category_total *total) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "SELECT Category, Items, Quantity FROM SuppliesCategoryTotals WHERE Category = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_text(stmt, 1, category, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        snprintf(total->category, sizeof(total->category), "%s", category);
+        total->items = sqlite3_column_int(stmt, 1);
+        total->quantity = sqlite3_column_int64(stmt, 2);
+        rc = SQLITE_OK;
+    } else if (rc == SQLITE_DONE) {
+        rc = SQLITE_NOTFOUND;
+    } else {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int supplies_db_category_totals(database *db, supplies_category_callback callback, void *ctx) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return -1;
+    }
+
+    const char *sql = "SELECT Category, Items, Quantity FROM SuppliesCategoryTotals ORDER BY Category;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return -1;
+    }
+
+    int count = 0;
+    struct supplies_category_total total;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *category = (const char *)sqlite3_column_text(stmt, 0);
+        snprintf(total.category, sizeof(total.category), "%s", category ? category : "");
+        total.items = sqlite3_column_int(stmt, 1);
+        total.quantity = sqlite3_column_int64(stmt, 2);
+        count++;
+        if (callback && callback(ctx, &total) != 0) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        count = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+/**
+ * @internal
+ * @brief Creates the SuppliesCategoryTotals table and the triggers that keep it in sync
+ *
+ * Each trigger takes the old row out of its category and adds the new one, a category row is
+ * dropped when its last item goes. Category NULL is kept as "".
+ * If the table is created on a database that already has supplies, it is filled once.
+ */
+static int supplies_db_create_totals(database *db) {
+    bool totals_exist = false;
+    sqlite3_stmt *stmt;
+
+    int rc = sqlite3_prepare_v2(
+        db->db,
+        "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'SuppliesCategoryTotals';",
+        -1,
+        &stmt,
+        0
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+    totals_exist = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+
+    const char *sql =
+        "CREATE TABLE IF NOT EXISTS SuppliesCategoryTotals ("
+        "Category TEXT PRIMARY KEY,"          // "" for items without a category
+        "Items INTEGER NOT NULL DEFAULT 0,"   // Rows of Supplies in the category
+        "Quantity INTEGER NOT NULL DEFAULT 0" // Sum of their Quantity
+        ") WITHOUT ROWID;"
+
+        "CREATE TRIGGER IF NOT EXISTS Supplies_ai AFTER INSERT ON Supplies BEGIN " SUPPLIES_TOTALS_ADD("new") "END;"
+
+        "CREATE TRIGGER IF NOT EXISTS Supplies_ad AFTER DELETE ON Supplies BEGIN " SUPPLIES_TOTALS_TAKE("old") "END;"
+
+        "CREATE TRIGGER IF NOT EXISTS Supplies_au AFTER UPDATE OF Category, Quantity ON Supplies BEGIN "
+        SUPPLIES_TOTALS_TAKE("old") SUPPLIES_TOTALS_ADD("new") "END;";
+
+    char *errMsg = 0;
+    rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on init SuppliesCategoryTotals table: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return rc;
+    }
+
+    if (!totals_exist) {
+        rc = sqlite3_exec(
+            db->db,
+            "INSERT INTO SuppliesCategoryTotals (Category, Items, Quantity) "
+            "SELECT COALESCE(Category, ''), COUNT(*), SUM(Quantity) FROM Supplies GROUP BY COALESCE(Category, '');",
+            0,
+            0,
+            &errMsg
+        );
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error on filling SuppliesCategoryTotals table: %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return rc;
+        }
+    }
+
     return SQLITE_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * @internal
+ * @brief Fills a supplies record from a row selected with SUPPLIES_SELECT
+ */
+static void supplies_db_read_row(sqlite3_stmt *stmt, struct supplies *supplies) {
+    const char *text;
+    memset(supplies, 0, sizeof(*supplies));
+    supplies->id = sqlite3_column_int(stmt, 0);
+    text = (const char *)sqlite3_column_text(stmt, 1);
+    snprintf(supplies->name, sizeof(supplies->name), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 2);
+    snprintf(supplies->category, sizeof(supplies->category), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 3);
+    snprintf(supplies->size, sizeof(supplies->size), "%s", text ? text : "");
+    text = (const char *)sqlite3_column_text(stmt, 4);
+    snprintf(supplies->unit, sizeof(supplies->unit), "%s", text ? text : "");
+    supplies->quantity = sqlite3_column_int(stmt, 5);
+    text = (const char *)sqlite3_column_text(stmt, 6);
+    snprintf(supplies->notes, sizeof(supplies->notes), "%s", text ? text : "");
+}
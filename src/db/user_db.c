@@ -4,6 +4,8 @@
  */
 #include "db/user_db.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,7 +13,39 @@
 
 #include <inttypes.h> // For PRIu64 (compatibility for both windows and linux)
 
+#include "db/db_client.h"
 #include "utils/utils_hash.h"
+#include "utils/utils_perf.h"
+
+/**
+ * @internal
+ * @brief Adds the Kdf columns on databases created before them
+ *
+ * Existing hashes are single SHA-256 (Kdf 0), they are upgraded on the next successful login.
+ */
+static int user_db_migrate_kdf(database *db) {
+    if (db_table_has_column(db, "Users", "Kdf", NULL)) {
+        return SQLITE_OK;
+    }
+
+    char *errMsg = 0;
+    int rc = sqlite3_exec(
+        db->db,
+        "BEGIN;"
+        "ALTER TABLE Users ADD COLUMN Kdf INTEGER NOT NULL DEFAULT 0;"
+        "ALTER TABLE Users ADD COLUMN KdfIterations INTEGER NOT NULL DEFAULT 0;"
+        "COMMIT;",
+        0,
+        0,
+        &errMsg
+    );
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL error on adding Kdf columns: %s\n", errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    }
+    return rc;
+}
 
 int user_db_create_table(database *db) {
     if (!db_is_init(db)) {
@@ -29,7 +63,9 @@ int user_db_create_table(database *db) {
         "IsAdmin INTEGER NOT NULL DEFAULT 0,"
         "ResetPassword INTEGER NOT NULL DEFAULT 1,"
         "CreatedAt INTEGER NOT NULL,"
-        "LastLogin INTEGER);";
+        "LastLogin INTEGER,"
+        "Kdf INTEGER NOT NULL DEFAULT 0,"
+        "KdfIterations INTEGER NOT NULL DEFAULT 0);";
 
     char *errMsg = 0;
     int rc = sqlite3_exec(db->db, sql, 0, 0, &errMsg);
@@ -39,6 +75,11 @@ int user_db_create_table(database *db) {
         return rc;
     }
 
+    rc = user_db_migrate_kdf(db);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
     if (!user_db_check_exists(db, "admin")) {
         user_db_create_admin(db);
     }
@@ -47,17 +88,21 @@ int user_db_create_table(database *db) {
 }
 
 int user_db_create_user(database *db, const char *username, const char *cpf, const char *phone_number, bool is_admin) {
+    if (db_is_remote(db)) {
+        return db_client_user_create_user(db->remote, username, cpf, phone_number, is_admin);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (user_db_check_exists(&writer, username)) {
         fprintf(stderr, "Username already exists.\n");
         return SQLITE_CONSTRAINT;
     }
 
-    if (user_db_check_cpf_exists(db, cpf)) {
+    if (user_db_check_cpf_exists(&writer, cpf)) {
         fprintf(stderr, "CPF already exists.\n");
         return SQLITE_CONSTRAINT;
     }
@@ -97,7 +142,8 @@ int user_db_create_admin(database *db) {
         return SQLITE_ERROR;
     }
 
-    if (user_db_check_exists(db, "admin")) {
+    database writer = db_writer(db);
+    if (user_db_check_exists(&writer, "admin")) {
         fprintf(stderr, "Admin already exists.\n");
         return SQLITE_CONSTRAINT;
     }
@@ -110,12 +156,14 @@ int user_db_create_admin(database *db) {
     // Generate salt and hash the password
     char salt[SALT_LEN + 1] = { 0 };
     char hash[PASSWORD_HASH_LEN + 1] = { 0 };
+    struct password_kdf_params kdf = password_kdf_current();
     generate_salt(salt, SALT_LEN);
-    hash_password(password, salt, hash);
+    hash_password_kdf(password, salt, kdf, hash);
 
     const char *sql =
-        "INSERT INTO Users (Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+        "INSERT INTO Users "
+        "(Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt, Kdf, KdfIterations) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
@@ -135,6 +183,8 @@ int user_db_create_admin(database *db) {
     sqlite3_bind_int(stmt, 6, is_admin ? 1 : 0);
     sqlite3_bind_int(stmt, 7, reset_password ? 1 : 0);
     sqlite3_bind_int64(stmt, 8, now);
+    sqlite3_bind_int(stmt, 9, (int)kdf.kdf);
+    sqlite3_bind_int(stmt, 10, kdf.iterations);
 
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
@@ -145,60 +195,395 @@ int user_db_create_admin(database *db) {
     return rc == SQLITE_DONE ? SQLITE_OK : rc;
 }
 
-enum auth_result user_db_authenticate(database *db, const char *username, const char *password) {
+/* ======================= LAST LOGIN WRITE-BEHIND ======================= */
+
+/**
+ * @internal
+ * @brief Logins whose LastLogin is not written yet, one entry per user with the latest time
+ *
+ * The entries belong to one connection: when another one queues (the database was closed and
+ * reopened without a flush), the old entries are dropped rather than written to the wrong file.
+ */
+static struct {
+    pthread_mutex_t lock;
+    sqlite3 *conn; // Connection the entries are for
+    struct {
+        char username[MAX_INPUT];
+        time_t at;
+    } entries[USER_DB_LAST_LOGIN_BATCH];
+    int count;
+    uint64_t last_queued_ns; // perf_now_ns() of the latest login queued
+} last_login_queue = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/**
+ * @internal
+ * @brief Writes the queued times in one transaction, the caller holds the lock
+ *
+ * Entries are kept on failure and retried by the next flush.
+ */
+static int last_login_queue_write(database *db) {
+    const char *sql = "UPDATE Users SET LastLogin = ? WHERE Username = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return rc;
+    }
+
+    rc = SQLITE_DONE;
+    for (int i = 0; i < last_login_queue.count && rc == SQLITE_DONE; i++) {
+        sqlite3_bind_int64(stmt, 1, last_login_queue.entries[i].at);
+        sqlite3_bind_text(stmt, 2, last_login_queue.entries[i].username, -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc == SQLITE_DONE && (rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0)) == SQLITE_OK) {
+        last_login_queue.count = 0;
+        return SQLITE_OK;
+    }
+
+    fprintf(stderr, "Failed to update last login time: %s\n", sqlite3_errmsg(db->db));
+    sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Queues a login, writing the batch once it is full
+ */
+static void last_login_queue_add(database *db, const char *username, time_t at) {
+    pthread_mutex_lock(&last_login_queue.lock);
+
+    if (last_login_queue.conn != db->db) {
+        last_login_queue.conn = db->db;
+        last_login_queue.count = 0;
+    }
+
+    int i = 0;
+    while (i < last_login_queue.count && strcmp(last_login_queue.entries[i].username, username) != 0) {
+        i++;
+    }
+    if (i == USER_DB_LAST_LOGIN_BATCH) {
+        // Full and the last write failed, try again before giving this login up
+        if (last_login_queue_write(db) != SQLITE_OK) {
+            pthread_mutex_unlock(&last_login_queue.lock);
+            return;
+        }
+        i = 0;
+    }
+    if (i == last_login_queue.count) {
+        snprintf(last_login_queue.entries[i].username, MAX_INPUT, "%s", username);
+        last_login_queue.count++;
+    }
+    last_login_queue.entries[i].at = at;
+    last_login_queue.last_queued_ns = perf_now_ns();
+
+    if (last_login_queue.count == USER_DB_LAST_LOGIN_BATCH) {
+        last_login_queue_write(db);
+    }
+
+    pthread_mutex_unlock(&last_login_queue.lock);
+}
+
+int user_db_flush_last_login(database *db, bool force) {
+    if (db_is_remote(db)) {
+        return SQLITE_OK; // The server writes the logins of its clients
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
-        return AUTH_FAILURE;
+        return SQLITE_ERROR;
     }
 
-    struct user user = { 0 };
-    if (user_db_get_by_username(db, username, &user) != SQLITE_OK) {
-        printf("User '%s' not found in database\n", username);
-        return AUTH_FAILURE; // user was not found
+    int rc = SQLITE_OK;
+    pthread_mutex_lock(&last_login_queue.lock);
+    if (last_login_queue.count > 0 && last_login_queue.conn == db->db) {
+        uint64_t quiet_ns = perf_now_ns() - last_login_queue.last_queued_ns;
+        if (force || quiet_ns >= (uint64_t)(USER_DB_LAST_LOGIN_IDLE_SECONDS * 1e9)) {
+            rc = last_login_queue_write(db);
+        }
     }
+    pthread_mutex_unlock(&last_login_queue.lock);
+    return rc;
+}
 
-    // Check if password needs to be reset
-    if (user.reset_password) {
-        return AUTH_NEED_PASSWORD_RESET;
+int user_db_last_login_pending(database *db) {
+    if (db_is_remote(db)) {
+        return 0;
     }
+    pthread_mutex_lock(&last_login_queue.lock);
+    int count = last_login_queue.conn == db->db ? last_login_queue.count : 0;
+    pthread_mutex_unlock(&last_login_queue.lock);
+    return count;
+}
 
-    // Verify password
-    char computed_hash[PASSWORD_HASH_LEN + 1] = { 0 };
-    hash_password(password, user.salt, computed_hash);
+/**
+ * @internal
+ * @brief Flushes the queue before reading LastLogin or renaming and deleting users
+ */
+static void last_login_sync(database *db) {
+    user_db_flush_last_login(db, true);
+}
 
-    if (strcmp(computed_hash, user.password_hash) != 0) {
-        return AUTH_FAILURE;
-    }
+/* ======================= AUTHENTICATION ======================= */
+
+struct user_auth {
+    pthread_t thread;
+    bool has_thread;      // Verification runs on thread, else it ran in user_db_authenticate_start()
+    atomic_bool finished; // Worker done, the fields below are final
+    enum auth_result result;
+
+    // Fields read when starting, only what checking the password needs
+    char username[MAX_INPUT];
+    char password_hash[PASSWORD_HASH_LEN + 1];
+    char salt[SALT_LEN + 1];
+    struct password_kdf_params kdf;
+    char *password; // Copy, wiped when the handle is freed
+
+    // Server the worker sends the password to instead (db_client.h), NULL when checking locally
+    struct db_client *remote;
+
+    // Rehash with password_kdf_current() made by the worker when the stored one is weaker
+    bool upgrade;
+    struct password_kdf_params new_kdf;
+    char new_salt[SALT_LEN + 1];
+    char new_hash[PASSWORD_HASH_LEN + 1];
+};
+
+/**
+ * @internal
+ * @brief Writes a new password hash and clears ResetPassword
+ */
+static int user_db_store_password(
+    database *db,
+    const char *username,
+    const char *hash,
+    const char *salt,
+    struct password_kdf_params kdf
+) {
+    const char *sql =
+        "UPDATE Users SET PasswordHash = ?, Salt = ?, Kdf = ?, KdfIterations = ?, ResetPassword = 0 "
+        "WHERE Username = ?;";
 
-    // Update last login time
-    const char *sql = "UPDATE Users SET LastLogin = ? WHERE Username = ?;";
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
-        return AUTH_SUCCESS; // Authentication succeeded even if we can't update last login
+        return rc;
     }
 
-    time_t now = time(NULL);
-    sqlite3_bind_int64(stmt, 1, now);
-    sqlite3_bind_text(stmt, 2, user.username, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 1, hash, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, salt, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, (int)kdf.kdf);
+    sqlite3_bind_int(stmt, 4, kdf.iterations);
+    sqlite3_bind_text(stmt, 5, username, -1, SQLITE_STATIC);
 
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
-        fprintf(stderr, "Failed to update last login time: %s\n", sqlite3_errmsg(db->db));
+        fprintf(stderr, "Failed to update password: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+/**
+ * @internal
+ * @brief Checks the password and prepares the upgraded hash, runs on the worker thread
+ *
+ * Touches no connection: SQLite handles stay on the thread that owns them.
+ */
+static void *user_auth_verify(void *arg) {
+    struct user_auth *auth = arg;
+
+    if (auth->remote) {
+        auth->result = db_client_user_authenticate(auth->remote, auth->username, auth->password);
+    } else if (verify_password(auth->password, auth->salt, auth->kdf, auth->password_hash)) {
+        auth->result = AUTH_SUCCESS;
+        if (password_kdf_needs_upgrade(auth->kdf)) {
+            auth->new_kdf = password_kdf_current();
+            generate_salt(auth->new_salt, SALT_LEN);
+            auth->upgrade = hash_password_kdf(auth->password, auth->new_salt, auth->new_kdf, auth->new_hash);
+        }
+    } else {
+        auth->result = AUTH_FAILURE;
+    }
+
+    atomic_store_explicit(&auth->finished, true, memory_order_release);
+    return NULL;
+}
+
+static void user_auth_free(struct user_auth *auth) {
+    if (auth->password) {
+        volatile char *p = auth->password;
+        while (*p) {
+            *p++ = '\0';
+        }
+        free(auth->password);
+    }
+    free(auth);
+}
+
+/**
+ * @internal
+ * @brief Reads the stored hash of a user in one query
+ *
+ * @return SQLITE_OK, SQLITE_NOTFOUND if the user doesn't exist, or other SQLite error code
+ */
+static int user_auth_read(database *db, const char *username, struct user_auth *auth, bool *reset_password) {
+    const char *sql = "SELECT PasswordHash, Salt, ResetPassword, Kdf, KdfIterations FROM Users WHERE Username = ?;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        const char *hash = (const char *)sqlite3_column_text(stmt, 0);
+        const char *salt = (const char *)sqlite3_column_text(stmt, 1);
+        snprintf(auth->password_hash, sizeof(auth->password_hash), "%s", hash ? hash : "");
+        snprintf(auth->salt, sizeof(auth->salt), "%s", salt ? salt : "");
+        *reset_password = sqlite3_column_int(stmt, 2) != 0;
+        auth->kdf.kdf = (enum password_kdf)sqlite3_column_int(stmt, 3);
+        auth->kdf.iterations = sqlite3_column_int(stmt, 4);
+        snprintf(auth->username, sizeof(auth->username), "%s", username);
+        rc = SQLITE_OK;
+    } else if (rc == SQLITE_DONE) {
+        rc = SQLITE_NOTFOUND;
+    } else {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
     }
 
     sqlite3_finalize(stmt);
-    return AUTH_SUCCESS;
+    return rc;
+}
+
+/**
+ * @internal
+ * @brief Reads the user and copies the password, finished unless the password is left to verify
+ */
+static struct user_auth *user_auth_prepare(database *db, const char *username, const char *password) {
+    struct user_auth *auth = calloc(1, sizeof(*auth));
+    if (!auth) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NULL;
+    }
+
+    // Settled without hashing: not initialized, unknown user or password to be reset
+    auth->result = AUTH_FAILURE;
+    atomic_store(&auth->finished, true);
+    if (db_is_remote(db)) {
+        // The server reads the user, the worker only waits for its answer
+        auth->remote = db->remote;
+        snprintf(auth->username, sizeof(auth->username), "%s", username);
+    } else if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return auth;
+    }
+    bool reset_password = false;
+    if (!auth->remote && user_auth_read(db, username, auth, &reset_password) != SQLITE_OK) {
+        printf("User '%s' not found in database\n", username);
+        return auth;
+    }
+    if (reset_password) {
+        auth->result = AUTH_NEED_PASSWORD_RESET;
+        return auth;
+    }
+
+    size_t len = strlen(password) + 1;
+    auth->password = malloc(len);
+    if (!auth->password) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return auth;
+    }
+    memcpy(auth->password, password, len);
+    atomic_store(&auth->finished, false);
+    return auth;
+}
+
+struct user_auth *user_db_authenticate_start(database *db, const char *username, const char *password) {
+    struct user_auth *auth = user_auth_prepare(db, username, password);
+    if (auth && !atomic_load(&auth->finished)) {
+        auth->has_thread = pthread_create(&auth->thread, NULL, user_auth_verify, auth) == 0;
+        if (!auth->has_thread) {
+            user_auth_verify(auth); // No thread, verify right away
+        }
+    }
+    return auth;
+}
+
+bool user_db_authenticate_poll(struct user_auth *auth, database *db, enum auth_result *result) {
+    if (!atomic_load_explicit(&auth->finished, memory_order_acquire)) {
+        return false;
+    }
+    if (auth->has_thread) {
+        pthread_join(auth->thread, NULL);
+    }
+
+    *result = auth->result;
+    if (auth->result == AUTH_SUCCESS && !auth->remote) {
+        // Failing to upgrade or to update last login does not fail the login
+        if (auth->upgrade) {
+            user_db_store_password(db, auth->username, auth->new_hash, auth->new_salt, auth->new_kdf);
+        }
+        last_login_queue_add(db, auth->username, time(NULL));
+    }
+
+    user_auth_free(auth);
+    return true;
+}
+
+void user_db_authenticate_cancel(struct user_auth *auth) {
+    if (!auth) {
+        return;
+    }
+    if (auth->has_thread) {
+        pthread_join(auth->thread, NULL);
+    }
+    user_auth_free(auth);
+}
+
+enum auth_result user_db_authenticate(database *db, const char *username, const char *password) {
+    struct user_auth *auth = user_auth_prepare(db, username, password);
+    if (!auth) {
+        return AUTH_FAILURE;
+    }
+    if (!atomic_load(&auth->finished)) {
+        user_auth_verify(auth);
+    }
+
+    enum auth_result result = AUTH_FAILURE;
+    user_db_authenticate_poll(auth, db, &result);
+    return result;
 }
 
 int user_db_delete(database *db, const char *username) {
+    if (db_is_remote(db)) {
+        return db_client_user_delete(db->remote, username);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    last_login_sync(db);
+
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "Username not found in the dabatase.\n");
         return SQLITE_NOTFOUND;
     }
@@ -229,12 +614,16 @@ int user_db_delete(database *db, const char *username) {
 }
 
 int user_db_update_phone_number(database *db, const char *username, const char *phone_number) {
+    if (db_is_remote(db)) {
+        return db_client_user_update_phone_number(db->remote, username, phone_number);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "User does not exist.\n");
         return SQLITE_NOTFOUND;
     }
@@ -261,12 +650,16 @@ int user_db_update_phone_number(database *db, const char *username, const char *
 }
 
 int user_db_update_cpf(database *db, const char *username, const char *cpf) {
+    if (db_is_remote(db)) {
+        return db_client_user_update_cpf(db->remote, username, cpf);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "User does not exist.\n");
         return SQLITE_NOTFOUND;
     }
@@ -293,12 +686,16 @@ int user_db_update_cpf(database *db, const char *username, const char *cpf) {
 }
 
 int user_db_update_password(database *db, const char *username, const char *new_password) {
+    if (db_is_remote(db)) {
+        return db_client_user_update_password(db->remote, username, new_password);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "User does not exist.\n");
         return SQLITE_NOTFOUND;
     }
@@ -306,38 +703,24 @@ int user_db_update_password(database *db, const char *username, const char *new_
     // Generate new salt and hash
     char salt[SALT_LEN + 1] = { 0 };
     char hash[PASSWORD_HASH_LEN + 1] = { 0 };
+    struct password_kdf_params kdf = password_kdf_current();
     generate_salt(salt, SALT_LEN);
-    hash_password(new_password, salt, hash);
-
-    const char *sql = "UPDATE Users SET PasswordHash = ?, Salt = ?, ResetPassword = 0 WHERE Username = ?;";
+    hash_password_kdf(new_password, salt, kdf, hash);
 
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
-        return rc;
-    }
-
-    sqlite3_bind_text(stmt, 1, hash, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, salt, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, username, -1, SQLITE_STATIC);
-
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        fprintf(stderr, "Failed to update password: %s\n", sqlite3_errmsg(db->db));
-    }
-
-    sqlite3_finalize(stmt);
-    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+    return user_db_store_password(db, username, hash, salt, kdf);
 }
 
 int user_db_update_admin_status(database *db, const char *username, bool is_admin) {
+    if (db_is_remote(db)) {
+        return db_client_user_update_admin_status(db->remote, username, is_admin);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "User does not exist.\n");
         return SQLITE_NOTFOUND;
     }
@@ -369,11 +752,22 @@ int user_db_update_admin_status(database *db, const char *username, bool is_admi
 }
 
 bool user_db_check_cpf_exists(database *db, const char *cpf) {
+    if (db_is_remote(db)) {
+        return db_client_user_check_cpf_exists(db->remote, cpf);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return false;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        bool result = user_db_check_cpf_exists(&reader, cpf);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT 1 FROM Users WHERE CPF = ?;";
 
     sqlite3_stmt *stmt;
@@ -398,11 +792,22 @@ bool user_db_check_cpf_exists(database *db, const char *cpf) {
 }
 
 bool user_db_check_exists(database *db, const char *username) {
+    if (db_is_remote(db)) {
+        return db_client_user_check_exists(db->remote, username);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return false;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        bool result = user_db_check_exists(&reader, username);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT 1 FROM Users WHERE Username = ?;";
 
     sqlite3_stmt *stmt;
@@ -427,13 +832,27 @@ bool user_db_check_exists(database *db, const char *username) {
 }
 
 int user_db_get_by_username(database *db, const char *username, struct user *user_out) {
+    if (db_is_remote(db)) {
+        return db_client_user_get_by_username(db->remote, username, user_out);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    last_login_sync(db);
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = user_db_get_by_username(&reader, username, user_out);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql =
-        "SELECT Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt, LastLogin "
+        "SELECT Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt, LastLogin, "
+        "Kdf, KdfIterations "
         "FROM Users WHERE Username = ?;";
 
     sqlite3_stmt *stmt;
@@ -485,6 +904,10 @@ int user_db_get_by_username(database *db, const char *username, struct user *use
             user_out->last_login = 0;
         }
 
+        // Kdf (column 9), KdfIterations (column 10)
+        user_out->kdf.kdf = (enum password_kdf)sqlite3_column_int(stmt, 9);
+        user_out->kdf.iterations = sqlite3_column_int(stmt, 10);
+
         rc = SQLITE_OK;
     } else if (rc == SQLITE_DONE) {
         rc = SQLITE_NOTFOUND;
@@ -497,24 +920,30 @@ int user_db_get_by_username(database *db, const char *username, struct user *use
 }
 
 int user_db_update_username(database *db, const char *old_username, const char *new_username) {
+    if (db_is_remote(db)) {
+        return db_client_user_update_username(db->remote, old_username, new_username);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    last_login_sync(db);
+
     if (strcmp(old_username, "admin") == 0) {
         fprintf(stderr, "Can't change default admin username.\n");
         return SQLITE_CONSTRAINT;
     }
 
     // Check if the old username exists
-    if (!user_db_check_exists(db, old_username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, old_username)) {
         fprintf(stderr, "Old username not found in the database.\n");
         return SQLITE_NOTFOUND;
     }
 
     // Check if the new username already exists
-    if (user_db_check_exists(db, new_username)) {
+    if (user_db_check_exists(&writer, new_username)) {
         fprintf(stderr, "New username already exists in the database.\n");
         return SQLITE_CONSTRAINT;
     }
@@ -540,11 +969,22 @@ int user_db_update_username(database *db, const char *old_username, const char *
 }
 
 bool user_db_check_admin_status(database *db, const char *username) {
+    if (db_is_remote(db)) {
+        return db_client_user_check_admin_status(db->remote, username);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return false;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        bool result = user_db_check_admin_status(&reader, username);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     if (!user_db_check_exists(db, username)) {
         fprintf(stderr, "Username does not exists.\n");
         return false;
@@ -574,12 +1014,16 @@ bool user_db_check_admin_status(database *db, const char *username) {
 }
 
 int user_db_set_reset_password(database *db, const char *username) {
+    if (db_is_remote(db)) {
+        return db_client_user_set_reset_password(db->remote, username);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
-    if (!user_db_check_exists(db, username)) {
+    database writer = db_writer(db);
+    if (!user_db_check_exists(&writer, username)) {
         fprintf(stderr, "User does not exist.\n");
         return SQLITE_NOTFOUND;
     }
@@ -605,11 +1049,22 @@ int user_db_set_reset_password(database *db, const char *username) {
 }
 
 int user_db_get_count(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_user_get_count(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = user_db_get_count(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT COUNT(*) FROM Users;";
 
     sqlite3_stmt *stmt;
@@ -631,11 +1086,24 @@ int user_db_get_count(database *db) {
 }
 
 int user_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
+    if (db_is_remote(db)) {
+        return db_client_user_get_all_format(db->remote, buffer, buffer_size);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return -1;
     }
 
+    last_login_sync(db);
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = user_db_get_all_format(&reader, buffer, buffer_size);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     if (!buffer || buffer_size == 0) {
         fprintf(stderr, "Invalid buffer provided.\n");
         return -1;
@@ -667,7 +1135,7 @@ int user_db_get_all_format(database *db, char *buffer, size_t buffer_size) {
     } else {
         // Truncate but ensure null termination
         if (buffer_size > 0) {
-            strncpy(buffer, header, buffer_size - 1);
+            memcpy(buffer, header, buffer_size - 1); // header_len >= buffer_size here
             buffer[buffer_size - 1] = '\0';
         }
         sqlite3_finalize(stmt);
@@ -758,6 +1226,16 @@ char *user_db_get_all_format_old(database *db) {
         return NULL;
     }
 
+    last_login_sync(db);
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        char *result = user_db_get_all_format_old(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT Username, CPF, PhoneNumber, IsAdmin, CreatedAt, LastLogin FROM Users;";
     sqlite3_stmt *stmt;
 
@@ -883,11 +1361,24 @@ char *user_db_get_all_format_old(database *db) {
 }
 
 int user_db_get_all(database *db) {
+    if (db_is_remote(db)) {
+        return db_client_user_get_all(db->remote);
+    }
     if (!db_is_init(db)) {
         fprintf(stderr, "Database connection is not initialized.\n");
         return SQLITE_ERROR;
     }
 
+    last_login_sync(db);
+
+    if (db_pool_readers(db) > 0) {
+        database reader;
+        db_pool_acquire(db, &reader);
+        int result = user_db_get_all(&reader);
+        db_pool_release(db, &reader);
+        return result;
+    }
+
     const char *sql = "SELECT Username, CPF, PhoneNumber, IsAdmin, CreatedAt, LastLogin FROM Users;";
 
     sqlite3_stmt *stmt;
@@ -0,0 +1,605 @@
+/**
+ * @file user_roster.c
+ * @brief Bulk user provisioning implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For sysconf
+
+#include "db/user_roster.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "utils/utils_hash.h"
+
+#define ROSTER_LINE_MAX 1024  ///< Longest roster line
+#define ROSTER_FIELDS 5       ///< username, cpf, phone_number, admin, password
+#define ROSTER_MAX_THREADS 64 ///< Most hashing threads started
+
+/* ======================= ROWS ======================= */
+
+static bool is_digits(const char *s, size_t len) {
+    if (strlen(s) != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isdigit((unsigned char)s[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Same rules as the create user screen
+ *
+ * @return Why the row is rejected, NULL if it is valid
+ */
+static const char *roster_validate(
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    const char *password
+) {
+    if (!username || username[0] == '\0') {
+        return "username is empty";
+    }
+    if (strlen(username) >= MAX_INPUT) {
+        return "username is too long";
+    }
+    if (!cpf || !is_digits(cpf, MAX_CPF_LENGTH - 1)) {
+        return "CPF must be 11 digits";
+    }
+    if (phone_number && phone_number[0] != '\0' && !is_digits(phone_number, MAX_PHONE_NUMBER_LEN - 1)) {
+        return "phone number must be 13 digits or nothing";
+    }
+    if (password && strlen(password) >= MAX_INPUT) {
+        return "password is too long";
+    }
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Appends a row, invalid rows keep their fields empty
+ *
+ * @param[out] reason Why the row is invalid, NULL if it is valid
+ * @return The new row, NULL on allocation failure
+ */
+static struct roster_entry *roster_push(
+    struct user_roster *roster,
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    bool is_admin,
+    const char *password,
+    long line,
+    const char **reason
+) {
+    if (roster->count == roster->capacity) {
+        size_t capacity = roster->capacity ? roster->capacity * 2 : 64;
+        struct roster_entry *entries = realloc(roster->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return NULL;
+        }
+        roster->entries = entries;
+        roster->capacity = capacity;
+    }
+
+    struct roster_entry *entry = &roster->entries[roster->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->line = line;
+
+    *reason = roster_validate(username, cpf, phone_number, password);
+    if (*reason) {
+        entry->status = ROSTER_INVALID;
+        return entry;
+    }
+
+    strcpy(entry->username, username);
+    strcpy(entry->cpf, cpf);
+    strcpy(entry->phone_number, phone_number ? phone_number : "");
+    strcpy(entry->password, password ? password : "");
+    entry->is_admin = is_admin;
+    entry->status = ROSTER_PENDING;
+    return entry;
+}
+
+int user_roster_add(
+    struct user_roster *roster,
+    const char *username,
+    const char *cpf,
+    const char *phone_number,
+    bool is_admin,
+    const char *password
+) {
+    const char *reason = NULL;
+    struct roster_entry *entry = roster_push(roster, username, cpf, phone_number, is_admin, password, 0, &reason);
+    return entry ? (int)entry->status : -1;
+}
+
+/* ======================= FILE ======================= */
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    size_t len = strlen(s);
+    while (len > 0 && isspace((unsigned char)s[len - 1])) {
+        s[--len] = '\0';
+    }
+    return s;
+}
+
+/**
+ * @internal
+ * @brief Parses the admin field
+ *
+ * @return 1 for yes, 0 for no, -1 if it is neither
+ */
+static int parse_admin(const char *value) {
+    static const char *const yes[] = { "1", "yes", "true", "y" };
+    static const char *const no[] = { "", "0", "no", "false", "n" };
+    for (size_t i = 0; i < sizeof(yes) / sizeof(yes[0]); i++) {
+        if (strcmp(value, yes[i]) == 0) {
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < sizeof(no) / sizeof(no[0]); i++) {
+        if (strcmp(value, no[i]) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Splits a line on commas
+ *
+ * @return Number of fields, ROSTER_FIELDS + 1 if there are too many
+ */
+static int split_fields(char *line, char **fields) {
+    int count = 0;
+    char *start = line;
+    for (;;) {
+        char *comma = strchr(start, ',');
+        if (count == ROSTER_FIELDS) {
+            return ROSTER_FIELDS + 1;
+        }
+        if (comma) {
+            *comma = '\0';
+        }
+        fields[count++] = trim(start);
+        if (!comma) {
+            return count;
+        }
+        start = comma + 1;
+    }
+}
+
+int user_roster_read(struct user_roster *roster, FILE *in) {
+    char buffer[ROSTER_LINE_MAX];
+    long line = 0;
+    int rows = 0;
+
+    while (fgets(buffer, sizeof(buffer), in)) {
+        line++;
+
+        // Line longer than the buffer: drop the rest and reject the row
+        bool truncated = strchr(buffer, '\n') == NULL && !feof(in);
+        if (truncated) {
+            int c;
+            while ((c = getc(in)) != EOF && c != '\n') {
+            }
+        }
+
+        char *text = trim(buffer);
+        if (text[0] == '\0' || text[0] == '#') {
+            continue;
+        }
+
+        char *fields[ROSTER_FIELDS] = { 0 };
+        int count = split_fields(text, fields);
+        if (rows == 0 && count > 1 && strcmp(fields[0], "username") == 0 && strcmp(fields[1], "cpf") == 0) {
+            continue; // Header
+        }
+        const char *reason = NULL;
+        int is_admin = count > 3 ? parse_admin(fields[3]) : 0;
+
+        struct roster_entry *entry = roster_push(
+            roster,
+            fields[0],
+            count > 1 ? fields[1] : NULL,
+            count > 2 ? fields[2] : NULL,
+            is_admin == 1,
+            count > 4 ? fields[4] : NULL,
+            line,
+            &reason
+        );
+        if (!entry) {
+            return -1;
+        }
+
+        if (!reason && truncated) {
+            reason = "line is too long";
+        } else if (!reason && count > ROSTER_FIELDS) {
+            reason = "too many fields";
+        } else if (!reason && is_admin < 0) {
+            reason = "admin must be yes or no";
+        }
+        if (reason) {
+            entry->status = ROSTER_INVALID;
+            fprintf(stderr, "Line %ld: %s.\n", line, reason);
+        }
+        rows++;
+    }
+
+    if (ferror(in)) {
+        fprintf(stderr, "Failed to read the roster.\n");
+        return -1;
+    }
+    return rows;
+}
+
+/* ======================= UNIQUENESS ======================= */
+
+/**
+ * @struct roster_set
+ * @brief Open addressing set of strings, keys are copied
+ */
+struct roster_set {
+    char **keys;     ///< Key of each bucket, NULL when empty
+    size_t capacity; ///< Number of buckets (power of two)
+    size_t count;    ///< Keys stored
+};
+
+static uint64_t roster_set_hash(const char *key) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037u;
+    for (const unsigned char *c = (const unsigned char *)key; *c; c++) {
+        hash = (hash ^ *c) * 1099511628211u;
+    }
+    return hash;
+}
+
+static size_t roster_set_find(const struct roster_set *set, const char *key) {
+    size_t mask = set->capacity - 1;
+    size_t i = roster_set_hash(key) & mask;
+    while (set->keys[i] && strcmp(set->keys[i], key) != 0) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool roster_set_contains(const struct roster_set *set, const char *key) {
+    return set->capacity > 0 && set->keys[roster_set_find(set, key)] != NULL;
+}
+
+/**
+ * @internal
+ * @brief Grows the set to keep it at most half full
+ */
+static bool roster_set_reserve(struct roster_set *set, size_t count) {
+    if (count * 2 <= set->capacity) {
+        return true;
+    }
+
+    size_t capacity = set->capacity ? set->capacity : 64;
+    while (count * 2 > capacity) {
+        capacity *= 2;
+    }
+    char **old_keys = set->keys;
+    size_t old_capacity = set->capacity;
+    set->keys = calloc(capacity, sizeof(*set->keys));
+    if (!set->keys) {
+        set->keys = old_keys;
+        fprintf(stderr, "Memory allocation failed.\n");
+        return false;
+    }
+    set->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_keys[i]) {
+            set->keys[roster_set_find(set, old_keys[i])] = old_keys[i];
+        }
+    }
+    free(old_keys);
+    return true;
+}
+
+static bool roster_set_add(struct roster_set *set, const char *key) {
+    if (!roster_set_reserve(set, set->count + 1)) {
+        return false;
+    }
+    size_t i = roster_set_find(set, key);
+    if (set->keys[i]) {
+        return true;
+    }
+    size_t len = strlen(key) + 1;
+    set->keys[i] = malloc(len);
+    if (!set->keys[i]) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return false;
+    }
+    memcpy(set->keys[i], key, len);
+    set->count++;
+    return true;
+}
+
+static void roster_set_free(struct roster_set *set) {
+    for (size_t i = 0; i < set->capacity; i++) {
+        free(set->keys[i]);
+    }
+    free(set->keys);
+    *set = (struct roster_set) { 0 };
+}
+
+int user_roster_check_unique(database *db, struct user_roster *roster) {
+    if (!db_is_init(db)) {
+        fprintf(stderr, "Database connection is not initialized.\n");
+        return SQLITE_ERROR;
+    }
+
+    const char *sql = "SELECT Username, CPF FROM Users;";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    struct roster_set usernames = { 0 };
+    struct roster_set cpfs = { 0 };
+    bool ok = roster_set_reserve(&usernames, roster->count) && roster_set_reserve(&cpfs, roster->count);
+
+    while (ok && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *username = (const char *)sqlite3_column_text(stmt, 0);
+        const char *cpf = (const char *)sqlite3_column_text(stmt, 1);
+        ok = (!username || roster_set_add(&usernames, username)) && (!cpf || roster_set_add(&cpfs, cpf));
+    }
+    sqlite3_finalize(stmt);
+
+    if (ok && rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+        ok = false;
+    }
+
+    // Earlier rows claim their username and CPF before later ones
+    for (size_t i = 0; ok && i < roster->count; i++) {
+        struct roster_entry *entry = &roster->entries[i];
+        if (entry->status != ROSTER_PENDING) {
+            continue;
+        }
+        if (roster_set_contains(&usernames, entry->username)) {
+            entry->status = ROSTER_USERNAME_EXISTS;
+        } else if (roster_set_contains(&cpfs, entry->cpf)) {
+            entry->status = ROSTER_CPF_EXISTS;
+        } else {
+            ok = roster_set_add(&usernames, entry->username) && roster_set_add(&cpfs, entry->cpf);
+        }
+    }
+
+    roster_set_free(&usernames);
+    roster_set_free(&cpfs);
+    if (!ok) {
+        return rc != SQLITE_DONE && rc != SQLITE_ROW ? rc : SQLITE_NOMEM;
+    }
+    return SQLITE_OK;
+}
+
+/* ======================= HASHING ======================= */
+
+/**
+ * @struct roster_hash_pool
+ * @brief Work shared by the hashing threads, each takes the next row until none are left
+ */
+struct roster_hash_pool {
+    struct user_roster *roster;
+    atomic_size_t next;
+};
+
+static void *roster_hash_worker(void *arg) {
+    struct roster_hash_pool *pool = arg;
+    struct user_roster *roster = pool->roster;
+
+    for (;;) {
+        size_t i = atomic_fetch_add(&pool->next, 1);
+        if (i >= roster->count) {
+            return NULL;
+        }
+
+        struct roster_entry *entry = &roster->entries[i];
+        if (entry->status != ROSTER_PENDING) {
+            continue;
+        }
+        if (entry->password[0] == '\0') {
+            generate_salt(entry->password, ROSTER_PASSWORD_LEN);
+            entry->generated_password = true;
+        }
+        generate_salt(entry->salt, SALT_LEN);
+        hash_password_kdf(entry->password, entry->salt, roster->kdf, entry->password_hash);
+    }
+}
+
+static int online_cores(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) {
+        return (int)cores;
+    }
+#endif
+    return 1;
+}
+
+int user_roster_hash_passwords(struct user_roster *roster, int threads) {
+    roster->kdf = password_kdf_current();
+
+    size_t pending = 0;
+    for (size_t i = 0; i < roster->count; i++) {
+        pending += roster->entries[i].status == ROSTER_PENDING;
+    }
+
+    if (threads <= 0) {
+        threads = online_cores();
+    }
+    if ((size_t)threads > pending) {
+        threads = pending > 0 ? (int)pending : 1;
+    }
+    if (threads > ROSTER_MAX_THREADS) {
+        threads = ROSTER_MAX_THREADS;
+    }
+
+    struct roster_hash_pool pool = { .roster = roster };
+    atomic_init(&pool.next, 0);
+
+    // The calling thread is one of the workers
+    pthread_t workers[ROSTER_MAX_THREADS];
+    int started = 0;
+    while (started < threads - 1 && pthread_create(&workers[started], NULL, roster_hash_worker, &pool) == 0) {
+        started++;
+    }
+    roster_hash_worker(&pool);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    return started + 1;
+}
+
+/* ======================= PROVISIONING ======================= */
+
+static void roster_report_fill(const struct user_roster *roster, struct roster_report *report) {
+    *report = (struct roster_report) { 0 };
+    for (size_t i = 0; i < roster->count; i++) {
+        switch (roster->entries[i].status) {
+        case ROSTER_CREATED:
+            report->created++;
+            break;
+        case ROSTER_INVALID:
+            report->invalid++;
+            break;
+        case ROSTER_USERNAME_EXISTS:
+            report->username_exists++;
+            break;
+        case ROSTER_CPF_EXISTS:
+            report->cpf_exists++;
+            break;
+        case ROSTER_PENDING:
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @internal
+ * @brief Inserts the pending rows with one statement in one transaction
+ *
+ * Rows that lost their username or CPF to another connection since the check are skipped,
+ * any other failure rolls everything back.
+ */
+static int roster_insert(database *db, struct user_roster *roster) {
+    const char *sql =
+        "INSERT INTO Users "
+        "(Username, PasswordHash, Salt, CPF, PhoneNumber, IsAdmin, ResetPassword, CreatedAt, Kdf, KdfIterations) "
+        "VALUES (?, ?, ?, ?, ?, ?, 1, ?, ?, ?);";
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db->db));
+        return rc;
+    }
+
+    rc = sqlite3_exec(db->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db->db));
+        sqlite3_finalize(stmt);
+        return rc;
+    }
+
+    time_t now = time(NULL);
+    rc = SQLITE_DONE;
+    sqlite3_bind_int64(stmt, 7, now);
+    sqlite3_bind_int(stmt, 8, (int)roster->kdf.kdf);
+    sqlite3_bind_int(stmt, 9, roster->kdf.iterations);
+
+    for (size_t i = 0; i < roster->count; i++) {
+        struct roster_entry *entry = &roster->entries[i];
+        if (entry->status != ROSTER_PENDING) {
+            continue;
+        }
+
+        sqlite3_bind_text(stmt, 1, entry->username, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, entry->password_hash, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, entry->salt, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, entry->cpf, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 5, entry->phone_number, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 6, entry->is_admin ? 1 : 0);
+
+        rc = sqlite3_step(stmt);
+        int extended = sqlite3_extended_errcode(db->db);
+        sqlite3_reset(stmt);
+
+        if (rc == SQLITE_DONE) {
+            entry->status = ROSTER_CREATED;
+        } else if (extended == SQLITE_CONSTRAINT_PRIMARYKEY) {
+            entry->status = ROSTER_USERNAME_EXISTS;
+        } else if (extended == SQLITE_CONSTRAINT_UNIQUE) {
+            entry->status = ROSTER_CPF_EXISTS;
+        } else {
+            fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db->db));
+            break;
+        }
+        rc = SQLITE_DONE;
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc == SQLITE_DONE) {
+        rc = sqlite3_exec(db->db, "COMMIT;", 0, 0, 0);
+        if (rc == SQLITE_OK) {
+            return SQLITE_OK;
+        }
+        fprintf(stderr, "Failed to commit transaction: %s\n", sqlite3_errmsg(db->db));
+    }
+
+    sqlite3_exec(db->db, "ROLLBACK;", 0, 0, 0);
+    for (size_t i = 0; i < roster->count; i++) {
+        if (roster->entries[i].status == ROSTER_CREATED) {
+            roster->entries[i].status = ROSTER_PENDING;
+        }
+    }
+    return rc;
+}
+
+int user_roster_provision(database *db, struct user_roster *roster, int threads, struct roster_report *report) {
+    int rc = user_roster_check_unique(db, roster);
+    if (rc == SQLITE_OK) {
+        user_roster_hash_passwords(roster, threads);
+        rc = roster_insert(db, roster);
+    }
+
+    if (report) {
+        roster_report_fill(roster, report);
+    }
+    return rc;
+}
+
+void user_roster_free(struct user_roster *roster) {
+    for (size_t i = 0; i < roster->count; i++) {
+        volatile char *p = roster->entries[i].password;
+        for (size_t j = 0; j < sizeof(roster->entries[i].password); j++) {
+            p[j] = '\0';
+        }
+    }
+    free(roster->entries);
+    *roster = (struct user_roster) { 0 };
+}
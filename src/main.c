@@ -17,13 +17,23 @@
 #include <external/raylib/raylib.h>
 #include <external/sqlite3/sqlite3.h>
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "global/CONSTANTS.h"
 #include "global/app_state.h"
 #include "db/clothes_db.h"
+#include "db/clothes_index.h"
+#include "db/db_backup.h"
+#include "db/db_changes.h"
+#include "db/db_client.h"
+#include "db/db_maintenance.h"
 #include "db/db_manager.h"
+#include "db/db_profile.h"
+#include "db/dose_schedule.h"
+#include "db/expiration_alerts.h"
+#include "db/food_forecast.h"
 #include "db/foodbatch_db.h"
 #include "db/medication_db.h"
 #include "db/resident_db.h"
@@ -31,6 +41,7 @@
 #include "db/user_db.h"
 #include "global/error_handling.h"
 #include "global/globals.h"
+#include "ui/components/perf_overlay.h"
 #include "ui/screens/ui_clothes.h"
 #include "ui/screens/ui_create_user.h"
 #include "ui/screens/ui_food.h"
@@ -41,6 +52,31 @@
 #include "ui/screens/ui_settings.h"
 #include "ui/screens/ui_supplies.h"
 #include "entities/user.h"
+#include "utils/utils_hash.h"
+#include "utils/utils_perf.h"
+
+/**
+  * @brief Whether the user did anything this frame
+  *
+  * Polls held keys instead of GetKeyPressed(), which would take the keys from the screens.
+  */
+static bool user_input(void) {
+    Vector2 delta = GetMouseDelta();
+    if (delta.x != 0.0f || delta.y != 0.0f || GetMouseWheelMove() != 0.0f) {
+        return true;
+    }
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++) {
+        if (IsMouseButtonDown(button)) {
+            return true;
+        }
+    }
+    for (int key = KEY_APOSTROPHE; key <= KEY_KB_MENU; key++) {
+        if (IsKeyDown(key)) {
+            return true;
+        }
+    }
+    return IsKeyDown(KEY_SPACE);
+}
 
 /**
   * @brief Application entry point
@@ -64,6 +100,15 @@ int main(void) {
     // Initialization
     //--------------------------------------------------------------------------------------
     int return_code = EXIT_SUCCESS;
+    struct db_client *db_client = NULL; ///< Database server connection, when DB_SERVER is set
+
+    // DB_PROFILE=file profiles every statement of the run and writes the report on exit
+    db_profile_enable_from_env();
+    // Time spent in statements per frame, for the performance overlay
+    db_profile_track_time(true);
+
+    // Cost of new password hashes, measured on this machine
+    password_kdf_set_iterations(password_kdf_calibrate(PASSWORD_KDF_TARGET_MS));
 
     // Configure and create application window
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
@@ -87,20 +132,39 @@ int main(void) {
     database clothes_db = { 0 };    ///< Clothes database
     database supplies_db = { 0 };   ///< Supplies database
 
+    // DB_SERVER=socket shares the resident, food and user databases of a `dbtool serve` with other terminals
+    const char *db_server = getenv("DB_SERVER");
+    if (db_server && db_server[0] != '\0') {
+        db_client = db_client_connect(db_server);
+        if (!db_client) {
+            fprintf(stderr, "Error connecting to the database server.\n");
+            return_code = ERROR_OPENING_DB;
+            goto cleanup;
+        }
+        db_client_attach(db_client, &resident_db);
+        db_client_attach(db_client, &foodbatch_db);
+        db_client_attach(db_client, &user_db);
+    }
+
     // Initialize databases with tables
-    if (db_init_with_tbl(&resident_db, "resident_db.db", resident_db_create_table) != SQLITE_OK) {
+    if (!db_client && db_init_with_tbl(&resident_db, "resident_db.db", resident_db_create_table) != SQLITE_OK) {
         fprintf(stderr, "Error opening resident db.\n");
         return_code = ERROR_OPENING_DB;
         goto cleanup;
     }
 
-    if (db_init_with_tbl(&foodbatch_db, "foodbatch_db.db", foodbatch_db_create_table) != SQLITE_OK) {
+    // Searches read through two pooled readers while the resident screen edits on the writer
+    if (!db_client && db_pool_open(&resident_db, 2) != SQLITE_OK) {
+        fprintf(stderr, "Failed to open resident readers, continuing on the main connection.\n");
+    }
+
+    if (!db_client && db_init_with_tbl(&foodbatch_db, "foodbatch_db.db", foodbatch_db_create_table) != SQLITE_OK) {
         fprintf(stderr, "Error opening foodbatch db.\n");
         return_code = ERROR_OPENING_DB;
         goto cleanup;
     }
 
-    if (db_init_with_tbl(&user_db, "user_db.db", user_db_create_table) != SQLITE_OK) {
+    if (!db_client && db_init_with_tbl(&user_db, "user_db.db", user_db_create_table) != SQLITE_OK) {
         fprintf(stderr, "Error opening user db.\n");
         return_code = ERROR_OPENING_DB;
         goto cleanup;
@@ -124,6 +188,74 @@ int main(void) {
         goto cleanup;
     }
 
+    // Loaded once, follows the FoodBatch changes (also through a server) and the main menu shows it
+    struct expiration_alerts *expiration_alerts = expiration_alerts_load(&foodbatch_db, &medication_db);
+    if (!expiration_alerts) {
+        fprintf(stderr, "Failed to load expiration alerts, continuing without them.\n");
+    }
+
+    // Loaded once, follows the FoodBatch and Resident changes (also through a server) and the food screen shows it
+    struct food_forecast *food_forecast = food_forecast_load(&foodbatch_db, &resident_db);
+    if (!food_forecast) {
+        fprintf(stderr, "Failed to load food forecast, continuing without it.\n");
+    }
+
+    // Loaded once, the medication screen keeps it in sync and shows the doses due
+    struct dose_schedule *dose_schedule = dose_schedule_load(&medication_db, dose_schedule_now());
+    if (!dose_schedule) {
+        fprintf(stderr, "Failed to load dose schedules, continuing without reminders.\n");
+    }
+
+    // Loaded once, the clothes screen keeps it in sync and matches against it
+    struct clothes_index *clothes_index = clothes_index_load(&clothes_db);
+    if (!clothes_index) {
+        fprintf(stderr, "Failed to load clothes index, continuing without matching.\n");
+    }
+
+    // Backs up every database daily on its own thread, the settings screen shows the progress
+    struct db_backup *db_backup = db_backup_create(
+        &(struct db_backup_config) {
+            .dir = DB_BACKUP_DIR,
+            .generations = DB_BACKUP_GENERATIONS,
+            .interval = DB_BACKUP_INTERVAL,
+            .compress = true,
+        }
+    );
+    if (db_backup) {
+        database *const backup_dbs[] = {
+            &resident_db, &foodbatch_db, &user_db, &medication_db, &clothes_db, &supplies_db,
+        };
+        for (size_t i = 0; i < sizeof(backup_dbs) / sizeof(backup_dbs[0]); i++) {
+            // The server's databases are backed up on the server
+            if (!db_is_remote(backup_dbs[i])) {
+                db_backup_add(db_backup, backup_dbs[i]);
+            }
+        }
+    } else {
+        fprintf(stderr, "Failed to set up backups, continuing without them.\n");
+    }
+
+    // Analyzes, vacuums and checkpoints while the user is idle, stops at the first input
+    struct db_maintenance *db_maintenance = db_maintenance_create(NULL);
+    if (db_maintenance) {
+        if (!db_client) {
+            db_maintenance_add(db_maintenance, &resident_db, "resident_db");
+            db_maintenance_add(db_maintenance, &foodbatch_db, "foodbatch_db");
+            db_maintenance_add(db_maintenance, &user_db, "user_db");
+        }
+        db_maintenance_add(db_maintenance, &medication_db, "medication_db");
+        db_maintenance_add(db_maintenance, &clothes_db, "clothes_db");
+        db_maintenance_add(db_maintenance, &supplies_db, "supplies_db");
+    } else {
+        fprintf(stderr, "Failed to set up maintenance, continuing without it.\n");
+    }
+
+    // Writes made by another instance on the same files reach the screens too
+    if (!db_client) {
+        db_changes_watch(&resident_db, "Resident", "CPF");
+        db_changes_watch(&foodbatch_db, "FoodBatch", "BatchId");
+    }
+
     // Application state tracking
     struct user current_user = { 0 };            ///< Currently logged in user
     enum error_code error = NO_ERROR;            ///< Application error state
@@ -134,19 +266,19 @@ int main(void) {
     ui_login_init(&ui_login, &current_user);
 
     struct ui_main_menu ui_main_menu = { 0 }; ///< Main menu interface
-    ui_main_menu_init(&ui_main_menu, &current_user);
+    ui_main_menu_init(&ui_main_menu, &current_user, expiration_alerts);
 
     struct ui_resident ui_resident = { 0 }; ///< Resident management interface
     ui_resident_init(&ui_resident);
 
     struct ui_food ui_food = { 0 }; ///< Food management interface
-    ui_food_init(&ui_food);
+    ui_food_init(&ui_food, food_forecast);
 
     struct ui_medication ui_medication = { 0 }; ///< Medication management interface
-    ui_medication_init(&ui_medication);
+    ui_medication_init(&ui_medication, &resident_db, expiration_alerts, dose_schedule);
 
     struct ui_clothes ui_clothes = { 0 }; ///< Clothes management interface
-    ui_clothes_init(&ui_clothes);
+    ui_clothes_init(&ui_clothes, clothes_index);
 
     struct ui_supplies ui_supplies = { 0 }; ///< Supplies management interface
     ui_supplies_init(&ui_supplies);
@@ -155,15 +287,20 @@ int main(void) {
     ui_create_user_init(&ui_create_user);
 
     struct ui_settings ui_settings = { 0 }; ///< Modify user info/settings interface
-    ui_settings_init(&ui_settings, &current_user);
+    ui_settings_init(&ui_settings, &current_user, db_backup);
 
     // Status bar is a persistent element
     Rectangle statusbar_bounds = (Rectangle) { 0, window_height - 20, window_width, 20 };
 
+    // Performance overlay is a persistent element, toggled with PERF_OVERLAY_KEY
+    struct perf_overlay perf_overlay = perf_overlay_init();
+    database *const perf_dbs[] = { &resident_db, &foodbatch_db, &user_db, &medication_db, &clothes_db, &supplies_db };
+
     // Main application loop
     while (!WindowShouldClose()) {
         // Update
         //----------------------------------------------------------------------------------
+        uint64_t frame_db_ns = db_profile_thread_ns();
 
         // Handle window resize events
         if (IsWindowResized()) {
@@ -183,6 +320,26 @@ int main(void) {
             statusbar_bounds.width = window_width;
         }
 
+        // First, so the maintenance thread has stopped before a screen answers the input
+        db_maintenance_tick(db_maintenance, user_input(), (int64_t)perf_now_ns());
+
+        // Doses coming due, only does work once per minute
+        if (dose_schedule) {
+            dose_schedule_advance(dose_schedule, dose_schedule_now());
+        }
+
+        // Login times are queued, written in one go once logins pause
+        user_db_flush_last_login(&user_db, false);
+
+        // Starts the daily backup when due, the copy itself runs on the backup thread
+        db_backup_tick(db_backup, time(NULL));
+
+        // Rows other processes committed, checked a few times per second
+        db_changes_poll((int64_t)perf_now_ns());
+
+        // Rows committed since the last frame, the screens patch what they show before drawing
+        db_changes_dispatch();
+
         //----------------------------------------------------------------------------------
 
         // Draw
@@ -191,33 +348,34 @@ int main(void) {
         ClearBackground(GetColor(GuiGetStyle(DEFAULT, BACKGROUND_COLOR)));
 
         // State machine for screen rendering
+        uint64_t render_ns = 0;
         switch (app_state) {
         case STATE_LOGIN_MENU:
-            ui_login.base.render(&ui_login.base, &app_state, &error, &user_db);
+            render_ns = ui_base_render(&ui_login.base, &app_state, &error, &user_db);
             break;
         case STATE_MAIN_MENU:
-            ui_main_menu.base.render(&ui_main_menu.base, &app_state, &error, &user_db);
+            render_ns = ui_base_render(&ui_main_menu.base, &app_state, &error, &user_db);
             break;
         case STATE_REGISTER_RESIDENT:
-            ui_resident.base.render(&ui_resident.base, &app_state, &error, &resident_db);
+            render_ns = ui_base_render(&ui_resident.base, &app_state, &error, &resident_db);
             break;
         case STATE_REGISTER_FOOD:
-            ui_food.base.render(&ui_food.base, &app_state, &error, &foodbatch_db);
+            render_ns = ui_base_render(&ui_food.base, &app_state, &error, &foodbatch_db);
             break;
         case STATE_REGISTER_MEDICATION:
-            ui_medication.base.render(&ui_medication.base, &app_state, &error, &foodbatch_db);
+            render_ns = ui_base_render(&ui_medication.base, &app_state, &error, &medication_db);
             break;
         case STATE_REGISTER_CLOTHES:
-            ui_clothes.base.render(&ui_clothes.base, &app_state, &error, &foodbatch_db);
+            render_ns = ui_base_render(&ui_clothes.base, &app_state, &error, &clothes_db);
             break;
         case STATE_REGISTER_SUPPLIES:
-            ui_supplies.base.render(&ui_supplies.base, &app_state, &error, &foodbatch_db);
+            render_ns = ui_base_render(&ui_supplies.base, &app_state, &error, &supplies_db);
             break;
         case STATE_CREATE_USER:
-            ui_create_user.base.render(&ui_create_user.base, &app_state, &error, &user_db);
+            render_ns = ui_base_render(&ui_create_user.base, &app_state, &error, &user_db);
             break;
         case STATE_SETTINGS:
-            ui_settings.base.render(&ui_settings.base, &app_state, &error, &user_db);
+            render_ns = ui_base_render(&ui_settings.base, &app_state, &error, &user_db);
             break;
         default:
             break;
@@ -229,10 +387,36 @@ int main(void) {
             TextFormat("Logged: %s    Current screen: %s", current_user.username, app_state_to_string(&app_state))
         );
 
+        // Persistent element, drawn last to stay on top
+        perf_overlay_record(
+            &perf_overlay,
+            GetFrameTime() * 1000.0f,
+            render_ns,
+            db_profile_thread_ns() - frame_db_ns,
+            perf_dbs,
+            sizeof(perf_dbs) / sizeof(perf_dbs[0])
+        );
+        perf_overlay_draw(&perf_overlay);
+
         EndDrawing();
         //----------------------------------------------------------------------------------
     }
 
+    // Release screen owned resources (buffers, background workers)
+    ui_login.base.cleanup(&ui_login.base);
+    ui_resident.base.cleanup(&ui_resident.base);
+    ui_food.base.cleanup(&ui_food.base);
+    ui_medication.base.cleanup(&ui_medication.base);
+    ui_clothes.base.cleanup(&ui_clothes.base);
+    ui_supplies.base.cleanup(&ui_supplies.base);
+    ui_create_user.base.cleanup(&ui_create_user.base);
+    expiration_alerts_free(expiration_alerts);
+    food_forecast_free(food_forecast);
+    dose_schedule_free(dose_schedule);
+    clothes_index_free(clothes_index);
+    db_backup_free(db_backup); // Before the databases it reads close
+    db_maintenance_free(db_maintenance);
+
     // De-initialization
     //--------------------------------------------------------------------------------------
 cleanup:
@@ -246,9 +430,24 @@ cleanup:
     }
 
     if (db_is_init(&user_db)) {
+        user_db_flush_last_login(&user_db, true);
         db_deinit(&user_db);
     }
 
+    if (db_is_init(&medication_db)) {
+        db_deinit(&medication_db);
+    }
+
+    if (db_is_init(&clothes_db)) {
+        db_deinit(&clothes_db);
+    }
+
+    if (db_is_init(&supplies_db)) {
+        db_deinit(&supplies_db);
+    }
+
+    db_client_close(db_client);
+
     // Close graphics window
     CloseWindow();
     //--------------------------------------------------------------------------------------
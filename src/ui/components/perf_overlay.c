@@ -0,0 +1,203 @@
+/**
+ * @file perf_overlay.c
+ * @brief Performance overlay implementation
+ */
+#include "ui/components/perf_overlay.h"
+
+#include <stdio.h>
+
+#include <external/sqlite3/sqlite3.h>
+
+#include "global/globals.h"
+
+#define PERF_OVERLAY_SAMPLE_INTERVAL 0.5 // Seconds between memory and cache samples
+#define PERF_OVERLAY_BUDGET_MS (1000.0f / 60.0f)
+#define PERF_OVERLAY_TEXT_SIZE 10
+#define PERF_OVERLAY_LINE 14
+#define PERF_OVERLAY_MARGIN 10
+#define PERF_OVERLAY_GRAPH_HEIGHT 80
+
+struct perf_overlay perf_overlay_init(void) {
+    struct perf_overlay po = { 0 };
+    po.cache_hit_ratio = -1.0;
+    return po;
+}
+
+/**
+ * @internal
+ * @brief Reads the memory figures and the page cache counters (reset after reading)
+ */
+static void sample_memory(struct perf_overlay *po, database *const *dbs, int db_count) {
+    sqlite3_int64 current = 0;
+    sqlite3_int64 high = 0;
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &high, 0);
+    po->sqlite_memory = current;
+    po->sqlite_memory_high = high;
+
+    int64_t hits = 0;
+    int64_t misses = 0;
+    for (int i = 0; i < db_count; i++) {
+        if (!dbs[i] || !dbs[i]->db) {
+            continue;
+        }
+        int count = 0;
+        int unused = 0;
+        sqlite3_db_status(dbs[i]->db, SQLITE_DBSTATUS_CACHE_HIT, &count, &unused, 1);
+        hits += count;
+        sqlite3_db_status(dbs[i]->db, SQLITE_DBSTATUS_CACHE_MISS, &count, &unused, 1);
+        misses += count;
+    }
+    // Keep the last ratio when nothing was read since
+    if (hits + misses > 0) {
+        po->cache_hit_ratio = (double)hits / (double)(hits + misses);
+    }
+
+    po->rss = perf_rss_bytes();
+}
+
+void perf_overlay_record(
+    struct perf_overlay *po,
+    float frame_ms,
+    uint64_t render_ns,
+    uint64_t db_ns,
+    database *const *dbs,
+    int db_count
+) {
+    perf_ring_push(&po->frame_ms, frame_ms);
+    perf_ring_push(&po->render_ms, (float)render_ns / 1e6f);
+    perf_ring_push(&po->db_ms, (float)db_ns / 1e6f);
+
+    if (po->visible && GetTime() >= po->next_sample) {
+        sample_memory(po, dbs, db_count);
+        po->next_sample = GetTime() + PERF_OVERLAY_SAMPLE_INTERVAL;
+    }
+}
+
+/**
+ * @internal
+ * @brief Formats a byte count as KiB or MiB
+ */
+static const char *format_bytes(int64_t bytes, char *buffer, size_t size) {
+    if (bytes >= 1024 * 1024) {
+        snprintf(buffer, size, "%.1f MiB", (double)bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(buffer, size, "%.1f KiB", (double)bytes / 1024.0);
+    }
+    return buffer;
+}
+
+/**
+ * @internal
+ * @brief Draws one vertical bar per frame, newest on the right
+ */
+static void draw_graph_series(const struct perf_ring *ring, Rectangle graph, float scale_ms, Color color) {
+    for (int age = 0; age < ring->count && age < (int)graph.width; age++) {
+        float ms = perf_ring_get(ring, age);
+        float height = ms >= scale_ms ? graph.height : graph.height * ms / scale_ms;
+        float x = graph.x + graph.width - 1 - (float)age;
+        DrawLineV((Vector2) { x, graph.y + graph.height }, (Vector2) { x, graph.y + graph.height - height }, color);
+    }
+}
+
+/**
+ * @internal
+ * @brief Draws a line of the form "Name  last  avg  max"
+ */
+static void draw_ring_line(const char *name, const struct perf_ring *ring, int x, int y, Color color) {
+    DrawText(
+        TextFormat(
+            "%-7s %6.2f ms  avg %6.2f  max %6.2f",
+            name,
+            perf_ring_get(ring, 0),
+            perf_ring_avg(ring),
+            perf_ring_max(ring)
+        ),
+        x,
+        y,
+        PERF_OVERLAY_TEXT_SIZE,
+        color
+    );
+}
+
+void perf_overlay_draw(struct perf_overlay *po) {
+    if (IsKeyPressed(PERF_OVERLAY_KEY)) {
+        po->visible = !po->visible;
+        po->next_sample = 0.0;
+    }
+    if (!po->visible) {
+        return;
+    }
+
+    float width = PERF_RING_SIZE + 2 * PERF_OVERLAY_MARGIN;
+    float height = PERF_OVERLAY_GRAPH_HEIGHT + 8 * PERF_OVERLAY_LINE + 3 * PERF_OVERLAY_MARGIN;
+    Rectangle panel = { window_width - width - PERF_OVERLAY_MARGIN, PERF_OVERLAY_MARGIN, width, height };
+    Rectangle graph = {
+        panel.x + PERF_OVERLAY_MARGIN,
+        panel.y + PERF_OVERLAY_MARGIN,
+        PERF_RING_SIZE,
+        PERF_OVERLAY_GRAPH_HEIGHT,
+    };
+
+    DrawRectangleRec(panel, Fade(BLACK, 0.8f));
+    DrawRectangleLinesEx(graph, 1.0f, DARKGRAY);
+
+    // Twice the frame budget fits, taller frames stretch the scale
+    float max_ms = perf_ring_max(&po->frame_ms);
+    float scale_ms = max_ms > 2 * PERF_OVERLAY_BUDGET_MS ? max_ms : 2 * PERF_OVERLAY_BUDGET_MS;
+    draw_graph_series(&po->frame_ms, graph, scale_ms, GRAY);
+    draw_graph_series(&po->render_ms, graph, scale_ms, SKYBLUE);
+    draw_graph_series(&po->db_ms, graph, scale_ms, ORANGE);
+
+    float budget_y = graph.y + graph.height - graph.height * PERF_OVERLAY_BUDGET_MS / scale_ms;
+    DrawLineV((Vector2) { graph.x, budget_y }, (Vector2) { graph.x + graph.width, budget_y }, GREEN);
+    DrawText(
+        TextFormat("%.0f ms", scale_ms),
+        (int)graph.x + 2,
+        (int)graph.y + 2,
+        PERF_OVERLAY_TEXT_SIZE,
+        LIGHTGRAY
+    );
+
+    int x = (int)graph.x;
+    int y = (int)(graph.y + graph.height) + PERF_OVERLAY_MARGIN;
+    draw_ring_line("Frame", &po->frame_ms, x, y, LIGHTGRAY);
+    draw_ring_line("Render", &po->render_ms, x, y += PERF_OVERLAY_LINE, SKYBLUE);
+    draw_ring_line("DB", &po->db_ms, x, y += PERF_OVERLAY_LINE, ORANGE);
+
+    char current[32];
+    char high[32];
+    DrawText(
+        TextFormat(
+            "SQLite memory %s, peak %s",
+            format_bytes(po->sqlite_memory, current, sizeof(current)),
+            format_bytes(po->sqlite_memory_high, high, sizeof(high))
+        ),
+        x,
+        y += PERF_OVERLAY_LINE + PERF_OVERLAY_MARGIN / 2,
+        PERF_OVERLAY_TEXT_SIZE,
+        RAYWHITE
+    );
+    DrawText(
+        po->cache_hit_ratio >= 0.0 ? TextFormat("Page cache hits %.1f%%", po->cache_hit_ratio * 100.0)
+                                   : "Page cache hits -",
+        x,
+        y += PERF_OVERLAY_LINE,
+        PERF_OVERLAY_TEXT_SIZE,
+        RAYWHITE
+    );
+    DrawText(
+        po->rss > 0 ? TextFormat("Process RSS %s", format_bytes((int64_t)po->rss, current, sizeof(current)))
+                    : "Process RSS -",
+        x,
+        y += PERF_OVERLAY_LINE,
+        PERF_OVERLAY_TEXT_SIZE,
+        RAYWHITE
+    );
+    DrawText(
+        TextFormat("%d FPS    F3 hides", GetFPS()),
+        x,
+        y += PERF_OVERLAY_LINE + PERF_OVERLAY_MARGIN / 2,
+        PERF_OVERLAY_TEXT_SIZE,
+        GRAY
+    );
+}
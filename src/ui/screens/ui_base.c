@@ -7,6 +7,8 @@
 
 #include <stdio.h>
 
+#include "utils/utils_perf.h"
+
 static void ui_default_render(struct ui_base *base, enum app_state *state, enum error_code *error, database *db) {
     (void)base;
     (void)state;
@@ -67,3 +69,9 @@ void ui_base_init_defaults(struct ui_base *base, const char *type_name) {
         .type_name = type_name,
     };
 }
+
+uint64_t ui_base_render(struct ui_base *base, enum app_state *state, enum error_code *error, database *db) {
+    uint64_t start = perf_now_ns();
+    base->render(base, state, error, db);
+    return perf_now_ns() - start;
+}
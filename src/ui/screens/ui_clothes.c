@@ -4,12 +4,25 @@
  */
 #include "ui/screens/ui_clothes.h"
 
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <external/raylib/raygui.h>
 
 #include "db/clothes_db.h"
 #include "global/globals.h"
 #include "utils/utilsfn.h"
 
+// Labels of the filter checkboxes and dropdown options, stored lowercase in the database
+static const char *const size_labels[CLOTHES_SIZE_OPTIONS] = { "XS", "S", "M", "L", "XL", "XXL", "Kids" };
+static const char *const gender_labels[CLOTHES_GENDER_OPTIONS] = { "Other", "Male", "Female" };
+static const char *const gender_values[CLOTHES_GENDER_OPTIONS] = { "other", "male", "female" };
+static const char *const condition_labels[CLOTHES_CONDITION_OPTIONS] = { "New", "Good", "Worn", "Needs repair" };
+static const char *const condition_values[CLOTHES_CONDITION_OPTIONS] = { "new", "good", "worn", "needs repair" };
+
 /* Forward declarations */
 
 static void ui_clothes_render(struct ui_base *base, enum app_state *state, enum error_code *error, database *clothes_db);
@@ -21,21 +34,200 @@ static void ui_clothes_handle_buttons(
     database *clothes_db
 );
 
-static void handle_back_button(enum app_state *state);
+static void ui_clothes_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *clothes_db
+);
+
+static void ui_clothes_update_positions(struct ui_base *base);
+
+static void ui_clothes_clear_fields(struct ui_base *base);
+
+static void ui_clothes_cleanup(struct ui_base *base);
+
+// Tagged union for when a warning message needs to perform a database operation
+// Type of the operation
+enum ui_clothes_db_action_type {
+    DB_ACTION_NONE,
+    DB_ACTION_UPDATE,
+    DB_ACTION_DELETE,
+};
+
+// Info for the database operation based on the type
+struct ui_clothes_db_action_info {
+    enum ui_clothes_db_action_type type;
+    union {
+        struct {
+            int id;
+        } update;
+
+        struct {
+            int id;
+        } delete;
+    };
+};
+
+static void process_db_action_in_warning(
+    struct ui_clothes *ui,
+    enum error_code *error,
+    struct ui_clothes_db_action_info *action,
+    database *clothes_db
+);
+
+static void draw_clothes_info_panel(struct ui_clothes *ui);
+
+static void draw_match_filter(struct ui_clothes *ui);
+
+static void update_matches(struct ui_clothes *ui);
+
+static void draw_clothes_table_content(Rectangle bounds, char *data);
+
+static void handle_back_button(struct ui_clothes *ui, enum app_state *state);
+
+static void handle_submit_button(struct ui_clothes *ui, enum error_code *error, database *clothes_db);
+
+static void handle_retrieve_button(struct ui_clothes *ui, database *clothes_db);
+
+static void handle_delete_button(struct ui_clothes *ui, database *clothes_db);
+
+static void handle_retrieve_all_button(struct ui_clothes *ui, database *clothes_db);
+
+static void set_table_content(struct ui_clothes *ui, char *content);
+
+static void sync_stored_clothes(struct ui_clothes *ui, database *clothes_db, int id);
 
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
-void ui_clothes_init(struct ui_clothes *ui) {
+void ui_clothes_init(struct ui_clothes *ui, struct clothes_index *index) {
     // Initialize base
     ui_base_init_defaults(&ui->base, "Clothes");
     // Override methods
     ui->base.render = ui_clothes_render;
     ui->base.handle_buttons = ui_clothes_handle_buttons;
+    ui->base.handle_warning_msg = ui_clothes_handle_warning_msg;
+    ui->base.update_positions = ui_clothes_update_positions;
+    ui->base.clear_fields = ui_clothes_clear_fields;
+    ui->base.cleanup = ui_clothes_cleanup;
 
     // Initialize ui specific fields
 
     ui->butn_back = button_init((Rectangle) { 20, 20, 0, 30 }, "Back");
 
+    ui->ib_id = intbox_init(
+        (Rectangle) { 20, ui->butn_back.bounds.y + (ui->butn_back.bounds.height * 2), 130, 30 },
+        "ID (0 for new):",
+        0,
+        99999999
+    );
+
+    ui->tb_type =
+        textbox_init((Rectangle) { 20, ui->ib_id.bounds.y + (ui->ib_id.bounds.height * 2), 300, 30 }, "Type:");
+
+    ui->tb_size = textbox_init(
+        (Rectangle) { 20, ui->tb_type.bounds.y + (ui->tb_type.bounds.height * 2), 145, 30 },
+        "Size:"
+    );
+
+    ui->tb_color = textbox_init(
+        (Rectangle) { ui->tb_size.bounds.x + ui->tb_size.bounds.width + 10, ui->tb_size.bounds.y, 145, 30 },
+        "Color:"
+    );
+
+    ui->ib_quantity = intbox_init(
+        (Rectangle) { 20, ui->tb_size.bounds.y + (ui->tb_size.bounds.height * 2), 145, 30 },
+        "Quantity:",
+        0,
+        INT_MAX
+    );
+
+    ui->tb_notes = textbox_init(
+        (Rectangle) { 20, ui->ib_quantity.bounds.y + (ui->ib_quantity.bounds.height * 2), 300, 30 },
+        "Notes:"
+    );
+
+    // Dropdowns below everything else, their list opens downwards
+    ui->ddb_gender = dropdownbox_init(
+        (Rectangle) { 20, ui->tb_notes.bounds.y + (ui->tb_notes.bounds.height * 2), 145, 30 },
+        "Other;Male;Female",
+        "Gender:"
+    );
+
+    ui->ddb_condition = dropdownbox_init(
+        (Rectangle) { ui->ddb_gender.bounds.x + ui->ddb_gender.bounds.width + 10, ui->ddb_gender.bounds.y, 145, 30 },
+        "New;Good;Worn;Needs repair",
+        "Condition:"
+    );
+
+    ui->butn_submit = button_init((Rectangle) { 20, window_height - 60, 100, 30 }, "Submit");
+    ui->butn_retrieve = button_init(
+        (Rectangle) { ui->butn_submit.bounds.x + ui->butn_submit.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Retrieve"
+    );
+    ui->butn_delete = button_init(
+        (Rectangle
+        ) { ui->butn_retrieve.bounds.x + ui->butn_retrieve.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Delete"
+    );
+    ui->butn_retrieve_all = button_init(
+        (Rectangle) { ui->butn_delete.bounds.x + ui->butn_delete.bounds.width + 10, ui->butn_submit.bounds.y, 0, 30 },
+        "Retrieve All"
+    );
+
+    memset(&ui->clothes_retrieved, 0, sizeof(struct clothes));
+
+    // Only set the bounds of the panel, draw everything inside based on it on the draw info panel function
+    ui->panel_bounds = (Rectangle) { ui->tb_type.bounds.x + ui->tb_type.bounds.width + 10, 10, 300, 220 };
+
+    // Match filter below the info panel, one row of checkboxes per attribute then the text filters
+    ui->match_bounds = (Rectangle) { ui->panel_bounds.x, ui->panel_bounds.y + ui->panel_bounds.height + 10, 300, 0 };
+
+    float row_y = ui->match_bounds.y + 60;
+    for (int i = 0; i < CLOTHES_SIZE_OPTIONS; i++) {
+        ui->cb_match_sizes[i] =
+            checkbox_init((Rectangle) { ui->match_bounds.x + 10 + (float)i * 40, row_y, 20, 20 }, size_labels[i]);
+    }
+
+    row_y += 50;
+    for (int i = 0; i < CLOTHES_GENDER_OPTIONS; i++) {
+        ui->cb_match_genders[i] =
+            checkbox_init((Rectangle) { ui->match_bounds.x + 10 + (float)i * 70, row_y, 20, 20 }, gender_labels[i]);
+    }
+
+    row_y += 50;
+    for (int i = 0; i < CLOTHES_CONDITION_OPTIONS; i++) {
+        ui->cb_match_conditions[i] =
+            checkbox_init((Rectangle) { ui->match_bounds.x + 10 + (float)i * 60, row_y, 20, 20 }, condition_labels[i]);
+    }
+
+    row_y += 55;
+    ui->tb_match_size = textbox_init((Rectangle) { ui->match_bounds.x + 10, row_y, 135, 30 }, "Other sizes:");
+    ui->tb_match_type = textbox_init((Rectangle) { ui->match_bounds.x + 155, row_y, 135, 30 }, "Types:");
+
+    row_y += 60;
+    ui->tb_match_color = textbox_init((Rectangle) { ui->match_bounds.x + 10, row_y, 135, 30 }, "Colors:");
+
+    ui->match_bounds.height = row_y + 70 - ui->match_bounds.y;
+
+    ui->sp_table_view = scrollpanel_init(
+        (Rectangle) { ui->panel_bounds.x + ui->panel_bounds.width + 10,
+                      10,
+                      window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20),
+                      window_height - 100 },
+        "Database view",
+        (Rectangle) { 0, 0, 0, 0 }
+    );
+
+    ui->str_table_content = NULL;
+
+    ui->index = index;
+    ui->match_version = 0;
+    ui->match_checked = 0;
+    memset(ui->match_text, 0, sizeof(ui->match_text));
+    ui->showing_matches = false;
+    memset(&ui->match_totals, 0, sizeof(ui->match_totals));
+
     ui->flag = 0;
 }
 
@@ -49,7 +241,7 @@ void ui_clothes_init(struct ui_clothes *ui) {
 
 /**
  * @brief Clothes screen rendering and interaction handling.
- * 
+ *
  * @implements ui_base.render
  *
  * Handles rendering and interaction for all menu elements.
@@ -57,8 +249,8 @@ void ui_clothes_init(struct ui_clothes *ui) {
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any other ui*)
  * @param state Pointer to application state
  * @param error Pointer to error code
- * @param clothes_db Pointer to the clothes database 
- * 
+ * @param clothes_db Pointer to the clothes database
+ *
  * @warning Should be called through the base interface
  */
 static void ui_clothes_render(
@@ -69,19 +261,52 @@ static void ui_clothes_render(
 ) {
     struct ui_clothes *ui = (struct ui_clothes *)base;
 
+    // Start draw UI elements
+
+    intbox_draw(&ui->ib_id);
+    textbox_draw(&ui->tb_type);
+    textbox_draw(&ui->tb_size);
+    textbox_draw(&ui->tb_color);
+    intbox_draw(&ui->ib_quantity);
+    textbox_draw(&ui->tb_notes);
+
+    dropdownbox_draw(&ui->ddb_gender);
+    dropdownbox_draw(&ui->ddb_condition);
+
+    // Start Info Panel
+    draw_clothes_info_panel(ui);
+
+    draw_match_filter(ui);
+    update_matches(ui);
+
+    // Draw database content
+    scrollpanel_draw(&ui->sp_table_view, draw_clothes_table_content, ui->str_table_content);
+
+    // End draw UI elements
+
+    // Start button actions
     ui->base.handle_buttons(&ui->base, state, error, clothes_db);
+
+    // Start show warning/error boxes
+    ui->base.handle_warning_msg(&ui->base, state, error, clothes_db);
+
+    // Clear the text buffer only after a successful operation
+    if (IS_FLAG_SET(&ui->flag, FLAG_CLOTHES_OPERATION_DONE)) {
+        ui->base.clear_fields(&ui->base);
+        CLEAR_FLAG(&ui->flag, FLAG_CLOTHES_OPERATION_DONE);
+    }
 }
 
 /**
  * @brief Handle button drawing and logic.
- * 
+ *
  * @implements ui_base.handle_buttons
  *
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any ui*)
  * @param state Pointer to application state
  * @param error Pointer to error tracking variable
  * @param clothes_db Pointer to clothes database connection
- * 
+ *
  * @warning Should be called through the base interface
  */
 static void ui_clothes_handle_buttons(
@@ -90,20 +315,590 @@ static void ui_clothes_handle_buttons(
     enum error_code *error,
     database *clothes_db
 ) {
-    (void)error;
-    (void)clothes_db;
-
     struct ui_clothes *ui = (struct ui_clothes *)base;
 
     if (button_draw_updt(&ui->butn_back)) {
-        handle_back_button(state);
+        handle_back_button(ui, state);
         return;
     }
+
+    if (button_draw_updt(&ui->butn_submit)) {
+        handle_submit_button(ui, error, clothes_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve)) {
+        handle_retrieve_button(ui, clothes_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_delete)) {
+        handle_delete_button(ui, clothes_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve_all)) {
+        handle_retrieve_all_button(ui, clothes_db);
+        return;
+    }
+}
+
+/**
+ * @brief Manages clothes warning/confirmation dialogs
+ *
+ * @implements ui_base.handle_warning_msg
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_clothes*)
+ * @param state Pointer to application state
+ * @param error Pointer to error tracking variable
+ * @param clothes_db Pointer to clothes database connection
+ *
+ * @warning May trigger database operations on confirmation
+ */
+static void ui_clothes_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *clothes_db
+) {
+    (void)state;
+
+    struct ui_clothes *ui = (struct ui_clothes *)base;
+
+    const char *message = NULL;
+    enum clothes_screen_flags flag_to_clear = 0;
+    struct ui_clothes_db_action_info action = { 0 };
+    action.type = DB_ACTION_NONE;
+
+    // Warnings
+    if (IS_FLAG_SET(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND)) {
+        message = "Clothes ID not found.";
+        flag_to_clear = FLAG_CLOTHES_ID_NOT_FOUND;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CLOTHES_TYPE_EMPTY)) {
+        message = "Type cannot be empty.";
+        flag_to_clear = FLAG_CLOTHES_TYPE_EMPTY;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CLOTHES_DUPLICATE)) {
+        message = "Clothes with this type, size, gender,\ncolor and condition already exist.";
+        flag_to_clear = FLAG_CLOTHES_DUPLICATE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CLOTHES_ID_EXISTS)) {
+        message = "Clothes ID already exists. Update?";
+        flag_to_clear = FLAG_CLOTHES_ID_EXISTS;
+        action.type = DB_ACTION_UPDATE;
+        action.update.id = ui->ib_id.input;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CONFIRM_CLOTHES_DELETE)) {
+        message = "Are you sure you want to delete\nthese clothes?";
+        flag_to_clear = FLAG_CONFIRM_CLOTHES_DELETE;
+        action.type = DB_ACTION_DELETE;
+        action.delete.id = ui->ib_id.input;
+    } else if (*error == ERROR_INSERT_DB || *error == ERROR_UPDATE_DB || *error == ERROR_DELETE_DB) {
+        message = "Database error. Try again.";
+        *error = NO_ERROR;
+    }
+
+    if (message) {
+        const char *buttons = (action.type != DB_ACTION_NONE) ? "Yes;No" : "OK";
+
+        int result = GuiMessageBox(
+            (Rectangle) { window_width / 2 - 150, window_height / 2 - 50, 300, 150 },
+            "#191#Warning!",
+            message,
+            buttons
+        );
+
+        if (result == 1 && action.type != DB_ACTION_NONE) {
+            process_db_action_in_warning(ui, error, &action, clothes_db);
+        }
+
+        if (result >= 0 && flag_to_clear) {
+            CLEAR_FLAG(&ui->flag, flag_to_clear);
+        }
+    }
+}
+
+/**
+ * @brief Updates clothes UI element positions for window resizing
+ *
+ * @implements ui_base.update_positions
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_clothes*)
+ *
+ * @note If any ui element is initialized with window_width or window_height
+ *       in their bounds, they must be updated here
+ *
+ * @warning Should be called on window resize events
+ */
+static void ui_clothes_update_positions(struct ui_base *base) {
+    struct ui_clothes *ui = (struct ui_clothes *)base;
+
+    ui->butn_submit.bounds.y = window_height - 60;
+    ui->butn_retrieve.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_delete.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_retrieve_all.bounds.y = ui->butn_submit.bounds.y;
+    ui->sp_table_view.panel_bounds.width = window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20);
+    ui->sp_table_view.panel_bounds.height = window_height - 100;
+}
+
+/**
+ * @brief Clears all clothes input fields
+ *
+ * @implements ui_base.clear_fields
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_clothes*)
+ *
+ * @post All inputs are reset to defaults, the match filter is kept
+ */
+static void ui_clothes_clear_fields(struct ui_base *base) {
+    struct ui_clothes *ui = (struct ui_clothes *)base;
+
+    ui->ib_id.input = 0;
+    ui->tb_type.input[0] = '\0';
+    ui->tb_size.input[0] = '\0';
+    ui->tb_color.input[0] = '\0';
+    ui->ib_quantity.input = 0;
+    ui->tb_notes.input[0] = '\0';
+    ui->ddb_gender.active_option = 0;
+    ui->ddb_condition.active_option = 0;
+}
+
+/**
+ * @brief Cleans up clothes screen resources
+ *
+ * @implements ui_base.cleanup
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_clothes*)
+ *
+ * @warning Frees any allocated buffers/memory
+ */
+static void ui_clothes_cleanup(struct ui_base *base) {
+    struct ui_clothes *ui = (struct ui_clothes *)base;
+
+    set_table_content(ui, NULL);
+    ui->showing_matches = false;
 }
 /** @} */
 
 /* ======================= INTERNAL HELPERS ======================= */
 
-static void handle_back_button(enum app_state *state) {
+static void draw_clothes_info_panel(struct ui_clothes *ui) {
+    const struct clothes *clothes = &ui->clothes_retrieved;
+
+    GuiPanel(ui->panel_bounds, TextFormat("Clothes ID retrieved: %d", clothes->id));
+
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 30, 280, 20 },
+        TextFormat("Type: %s", clothes->type)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 60, 280, 20 },
+        TextFormat("Size: %s  Color: %s", clothes->size, clothes->color)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 90, 280, 20 },
+        TextFormat("Gender: %s", clothes->gender)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 120, 280, 20 },
+        TextFormat("Condition: %s", clothes->condition)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 150, 280, 20 },
+        TextFormat("Quantity: %d", clothes->quantity)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 180, 280, 20 },
+        TextFormat("Notes: %s", clothes->notes)
+    );
+}
+
+static void draw_match_filter(struct ui_clothes *ui) {
+    if (!ui->index) {
+        return;
+    }
+
+    GuiGroupBox(ui->match_bounds, "Match clothes in stock");
+
+    for (int i = 0; i < CLOTHES_SIZE_OPTIONS; i++) {
+        checkbox_draw(&ui->cb_match_sizes[i]);
+    }
+    for (int i = 0; i < CLOTHES_GENDER_OPTIONS; i++) {
+        checkbox_draw(&ui->cb_match_genders[i]);
+    }
+    for (int i = 0; i < CLOTHES_CONDITION_OPTIONS; i++) {
+        checkbox_draw(&ui->cb_match_conditions[i]);
+    }
+
+    textbox_draw(&ui->tb_match_size);
+    textbox_draw(&ui->tb_match_type);
+    textbox_draw(&ui->tb_match_color);
+
+    GuiLabel(
+        (Rectangle) { ui->tb_match_color.bounds.x + ui->tb_match_color.bounds.width + 10,
+                      ui->tb_match_color.bounds.y + 5,
+                      140,
+                      20 },
+        ui->showing_matches ? TextFormat("%d SKUs, %d items", ui->match_totals.rows, ui->match_totals.total_quantity)
+                            : "Nothing to match"
+    );
+}
+
+/**
+ * @internal
+ * @brief Allows each comma-separated value of text on the query
+ */
+static void allow_list(
+    struct clothes_query *q,
+    const struct clothes_index *index,
+    enum clothes_attribute attribute,
+    const char *text
+) {
+    char value[MAX_INPUT];
+    size_t len = 0;
+
+    for (const char *c = text;; c++) {
+        if (*c != ',' && *c != '\0') {
+            if (len + 1 < sizeof(value) && (len > 0 || !isspace((unsigned char)*c))) {
+                value[len++] = *c;
+            }
+            continue;
+        }
+
+        while (len > 0 && isspace((unsigned char)value[len - 1])) {
+            len--;
+        }
+        if (len > 0) {
+            value[len] = '\0';
+            clothes_query_allow(q, index, attribute, value);
+            len = 0;
+        }
+
+        if (*c == '\0') {
+            break;
+        }
+    }
+}
+
+/**
+ * @internal
+ * @brief Lists the clothes matching the filter on the table view
+ *
+ * The filter is compared to the one of the last match every frame, matching again only when it
+ * or the index changed, so toggling a checkbox updates the list on the same frame.
+ */
+static void update_matches(struct ui_clothes *ui) {
+    if (!ui->index) {
+        return;
+    }
+
+    unsigned checked = 0;
+    int bit = 0;
+    for (int i = 0; i < CLOTHES_SIZE_OPTIONS; i++, bit++) {
+        checked |= ui->cb_match_sizes[i].checked ? 1u << bit : 0;
+    }
+    for (int i = 0; i < CLOTHES_GENDER_OPTIONS; i++, bit++) {
+        checked |= ui->cb_match_genders[i].checked ? 1u << bit : 0;
+    }
+    for (int i = 0; i < CLOTHES_CONDITION_OPTIONS; i++, bit++) {
+        checked |= ui->cb_match_conditions[i].checked ? 1u << bit : 0;
+    }
+
+    const char *texts[3] = { ui->tb_match_size.input, ui->tb_match_type.input, ui->tb_match_color.input };
+    bool empty = checked == 0 && texts[0][0] == '\0' && texts[1][0] == '\0' && texts[2][0] == '\0';
+
+    unsigned version = clothes_index_version(ui->index);
+    if (checked == ui->match_checked && version == ui->match_version && strcmp(texts[0], ui->match_text[0]) == 0
+        && strcmp(texts[1], ui->match_text[1]) == 0 && strcmp(texts[2], ui->match_text[2]) == 0)
+    {
+        return;
+    }
+
+    ui->match_checked = checked;
+    ui->match_version = version;
+    for (int i = 0; i < 3; i++) {
+        snprintf(ui->match_text[i], sizeof(ui->match_text[i]), "%s", texts[i]);
+    }
+
+    if (empty) {
+        // Leave whatever Retrieve All put on the table view
+        if (ui->showing_matches) {
+            set_table_content(ui, NULL);
+            ui->showing_matches = false;
+        }
+        return;
+    }
+
+    struct clothes_query q;
+    clothes_query_init(&q);
+    for (int i = 0; i < CLOTHES_SIZE_OPTIONS; i++) {
+        if (ui->cb_match_sizes[i].checked) {
+            clothes_query_allow(&q, ui->index, CLOTHES_ATTR_SIZE, size_labels[i]);
+        }
+    }
+    for (int i = 0; i < CLOTHES_GENDER_OPTIONS; i++) {
+        if (ui->cb_match_genders[i].checked) {
+            clothes_query_allow(&q, ui->index, CLOTHES_ATTR_GENDER, gender_values[i]);
+        }
+    }
+    for (int i = 0; i < CLOTHES_CONDITION_OPTIONS; i++) {
+        if (ui->cb_match_conditions[i].checked) {
+            clothes_query_allow(&q, ui->index, CLOTHES_ATTR_CONDITION, condition_values[i]);
+        }
+    }
+    allow_list(&q, ui->index, CLOTHES_ATTR_SIZE, texts[0]);
+    allow_list(&q, ui->index, CLOTHES_ATTR_TYPE, texts[1]);
+    allow_list(&q, ui->index, CLOTHES_ATTR_COLOR, texts[2]);
+
+    int ids[CLOTHES_MATCH_LIST_MAX];
+    int listed = clothes_index_match(ui->index, &q, ids, CLOTHES_MATCH_LIST_MAX, &ui->match_totals);
+    if (listed < 0) {
+        return;
+    }
+
+    // 512 for header + 128 for each row, rows are under 100 characters
+    size_t size = 512 + 128 * (size_t)listed;
+    char *content = malloc(size);
+    if (!content) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    size_t written = (size_t)snprintf(
+        content,
+        size,
+        "Matching: %d SKUs, %d items (listing %d)\n"
+        "+--------------------------------------------------------------------------------+\n"
+        "| ID    | Type                 | Size     | Gender   | Color      | Qty   | Cond.  |\n"
+        "+-------+----------------------+----------+----------+------------+-------+--------+\n",
+        ui->match_totals.rows,
+        ui->match_totals.total_quantity,
+        listed
+    );
+
+    struct clothes clothes;
+    for (int i = 0; i < listed && written < size; i++) {
+        if (!clothes_index_row(ui->index, ids[i], &clothes)) {
+            continue;
+        }
+        int len = snprintf(
+            content + written,
+            size - written,
+            "| %5d | %-20.20s | %-8.8s | %-8.8s | %-10.10s | %5d | %-6.6s |\n",
+            clothes.id,
+            clothes.type,
+            clothes.size,
+            clothes.gender,
+            clothes.color,
+            clothes.quantity,
+            clothes.condition
+        );
+        if (len < 0) {
+            break;
+        }
+        written += (size_t)len;
+    }
+
+    set_table_content(ui, content);
+    ui->showing_matches = true;
+}
+
+/**
+ * @internal
+ * @brief Draws the table content of the database
+ *
+ * @note This is a callback to be used in the scrollpanel_draw
+ */
+static void draw_clothes_table_content(Rectangle bounds, char *data) {
+    GuiLabel(bounds, data ? data : "No data");
+}
+
+static void handle_back_button(struct ui_clothes *ui, enum app_state *state) {
+    ui->base.cleanup(&ui->base);
+
     *state = STATE_MAIN_MENU;
 }
+
+static void handle_submit_button(struct ui_clothes *ui, enum error_code *error, database *clothes_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_CLOTHES_ID_EXISTS | FLAG_CLOTHES_TYPE_EMPTY);
+
+    // An existing ID updates (after confirmation), 0 inserts with a new ID
+    if (ui->ib_id.input != 0) {
+        if (!clothes_db_check_id_exists(clothes_db, ui->ib_id.input)) {
+            SET_FLAG(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND);
+            return;
+        }
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_ID_EXISTS);
+        return;
+    }
+
+    if (ui->tb_type.input[0] == '\0') {
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_TYPE_EMPTY);
+        return;
+    }
+
+    int id = 0;
+    int rc = clothes_db_insert(
+        clothes_db,
+        ui->tb_type.input,
+        ui->tb_size.input,
+        gender_values[ui->ddb_gender.active_option],
+        ui->tb_color.input,
+        ui->ib_quantity.input,
+        condition_values[ui->ddb_condition.active_option],
+        ui->tb_notes.input,
+        &id
+    );
+    if (rc == SQLITE_CONSTRAINT) {
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_DUPLICATE);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_INSERT_DB;
+        fprintf(stderr, "Error submitting to database.\n");
+        return;
+    }
+
+    printf("Clothes inserted with ID: %d\n", id);
+    sync_stored_clothes(ui, clothes_db, id);
+
+    SET_FLAG(&ui->flag, FLAG_CLOTHES_OPERATION_DONE);
+    *error = NO_ERROR;
+}
+
+static void handle_retrieve_button(struct ui_clothes *ui, database *clothes_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND);
+
+    if (clothes_db_get_by_id(clothes_db, ui->ib_id.input, &ui->clothes_retrieved) != SQLITE_OK) {
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND);
+        return;
+    }
+
+    printf(
+        "Retrieved Clothes - Type: %s, Size: %s, Quantity: %d\n",
+        ui->clothes_retrieved.type,
+        ui->clothes_retrieved.size,
+        ui->clothes_retrieved.quantity
+    );
+
+    SET_FLAG(&ui->flag, FLAG_CLOTHES_OPERATION_DONE);
+}
+
+static void handle_delete_button(struct ui_clothes *ui, database *clothes_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND | FLAG_CONFIRM_CLOTHES_DELETE);
+
+    if (!clothes_db_check_id_exists(clothes_db, ui->ib_id.input)) {
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_ID_NOT_FOUND);
+        return;
+    }
+
+    SET_FLAG(&ui->flag, FLAG_CONFIRM_CLOTHES_DELETE);
+}
+
+static void handle_retrieve_all_button(struct ui_clothes *ui, database *clothes_db) {
+    int total_clothes = clothes_db_get_count(clothes_db);
+    if (total_clothes == -1) {
+        fprintf(stderr, "Failed to get total count.\n");
+        return;
+    }
+
+    // 512 for header + 512 for each row as documented on clothes_db_get_all_format
+    size_t buffer_size = 512 + 512 * (size_t)total_clothes;
+
+    char *content = malloc(buffer_size);
+    if (!content) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    if (clothes_db_get_all_format(clothes_db, content, buffer_size) == -1) {
+        fprintf(stderr, "Failed to get formatted table.\n");
+        free(content);
+        return;
+    }
+
+    set_table_content(ui, content);
+    ui->showing_matches = false;
+}
+
+static void process_db_action_in_warning(
+    struct ui_clothes *ui,
+    enum error_code *error,
+    struct ui_clothes_db_action_info *action,
+    database *clothes_db
+) {
+    int rc;
+
+    switch (action->type) {
+    case DB_ACTION_UPDATE:
+        rc = clothes_db_update(
+            clothes_db,
+            action->update.id,
+            ui->tb_type.input,
+            ui->tb_size.input,
+            gender_values[ui->ddb_gender.active_option],
+            ui->tb_color.input,
+            ui->ib_quantity.input > 0 ? ui->ib_quantity.input : -1, // Like the text fields, 0 keeps the quantity
+            condition_values[ui->ddb_condition.active_option],
+            ui->tb_notes.input
+        );
+        if (rc == SQLITE_CONSTRAINT) {
+            SET_FLAG(&ui->flag, FLAG_CLOTHES_DUPLICATE);
+            break;
+        }
+        if (rc != SQLITE_OK) {
+            *error = ERROR_UPDATE_DB;
+            break;
+        }
+        sync_stored_clothes(ui, clothes_db, action->update.id);
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_DELETE:
+        if (clothes_db_delete_by_id(clothes_db, action->delete.id) != SQLITE_OK) {
+            *error = ERROR_DELETE_DB;
+            break;
+        }
+        if (ui->index) {
+            clothes_index_remove(ui->index, action->delete.id);
+        }
+        SET_FLAG(&ui->flag, FLAG_CLOTHES_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_NONE:
+    default:
+        break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Replaces the table view content (takes ownership, NULL clears it) and sizes the view to it
+ */
+static void set_table_content(struct ui_clothes *ui, char *content) {
+    free(ui->str_table_content);
+    ui->str_table_content = content;
+
+    // Set the panel_content_bounds rectangle based on the width and height of the text
+    if (content) {
+        Vector2 text_size = MeasureTextEx(GuiGetFont(), content, FONT_SIZE, 0);
+        ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
+        ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
+    }
+}
+
+/**
+ * @internal
+ * @brief Updates the clothes in the match index after they were inserted or updated
+ */
+static void sync_stored_clothes(struct ui_clothes *ui, database *clothes_db, int id) {
+    if (!ui->index) {
+        return;
+    }
+
+    struct clothes stored;
+    if (clothes_db_get_by_id(clothes_db, id, &stored) != SQLITE_OK) {
+        return;
+    }
+
+    if (!clothes_index_set(ui->index, &stored)) {
+        fprintf(stderr, "Failed to update the match index for clothes %d.\n", id);
+    }
+}
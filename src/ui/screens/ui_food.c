@@ -5,12 +5,14 @@
 #include "ui/screens/ui_food.h"
 
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <external/raylib/raygui.h>
 
+#include "db/db_changes.h"
 #include "db/foodbatch_db.h"
 #include "global/globals.h"
 #include "utils/utilsfn.h"
@@ -45,6 +47,7 @@ enum ui_food_db_action_type {
     DB_ACTION_NONE,
     DB_ACTION_UPDATE,
     DB_ACTION_DELETE,
+    DB_ACTION_DISTRIBUTE,
 };
 
 // Info for the database operation based on the type
@@ -75,6 +78,8 @@ static void process_db_action_in_warning(
 
 static void draw_foodbatch_info_panel(struct ui_food *ui);
 
+static void draw_food_forecast_panel(struct ui_food *ui);
+
 static void draw_foodbatch_table_content(Rectangle bounds, char *data);
 
 static void handle_back_button(struct ui_food *ui, enum app_state *state);
@@ -87,9 +92,23 @@ static void handle_delete_button(struct ui_food *ui, database *foodbatch_db);
 
 static void handle_retrieve_all_button(struct ui_food *ui, database *foodbatch_db);
 
+static void handle_plan_rations_button(struct ui_food *ui, database *foodbatch_db);
+
+static void apply_food_plan(struct ui_food *ui, enum error_code *error, database *foodbatch_db);
+
+static void discard_food_plan(struct ui_food *ui);
+
+static void load_foodbatch_table(struct ui_food *ui, database *foodbatch_db);
+
+static void fit_table_content(struct ui_food *ui);
+
+static void on_foodbatch_change(const struct db_change *change, void *ctx);
+
+static void apply_foodbatch_changes(struct ui_food *ui, database *foodbatch_db);
+
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
-void ui_food_init(struct ui_food *ui) {
+void ui_food_init(struct ui_food *ui, struct food_forecast *forecast) {
     // Initialize base
     ui_base_init_defaults(&ui->base, "ui_food.c");
 
@@ -180,6 +199,11 @@ void ui_food_init(struct ui_food *ui) {
         (Rectangle) { ui->butn_delete.bounds.x + ui->butn_delete.bounds.width + 10, ui->butn_submit.bounds.y, 0, 30 },
         "Retrieve All"
     );
+    ui->butn_plan_rations = button_init(
+        (Rectangle
+        ) { ui->butn_retrieve_all.bounds.x + ui->butn_retrieve_all.bounds.width + 10, ui->butn_submit.bounds.y, 0, 30 },
+        "Plan Rations"
+    );
 
     memset(&ui->foodbatch_retrieved, 0, sizeof(struct foodbatch));
 
@@ -196,6 +220,25 @@ void ui_food_init(struct ui_food *ui) {
     );
 
     ui->str_table_content = NULL;
+    ui->table_shows_batches = false;
+
+    ui->changed_count = 0;
+    ui->changed_all = false;
+    ui->changes_subscription = db_changes_subscribe("FoodBatch", on_foodbatch_change, ui);
+
+
+    ui->forecast = forecast;
+    ui->forecast_panel_bounds = (Rectangle) { ui->panel_bounds.x,
+                                              ui->panel_bounds.y + ui->panel_bounds.height + 10,
+                                              ui->panel_bounds.width,
+                                              230 };
+    ui->forecast_version = 0;
+    ui->forecast_today = DATE_INVALID; // Forces the first computation
+    memset(&ui->forecast_summary, 0, sizeof(ui->forecast_summary));
+    ui->forecast_name_count = 0;
+
+    ui->plan_requests = NULL;
+    memset(&ui->plan, 0, sizeof(ui->plan));
 
     ui->flag = 0;
 }
@@ -275,9 +318,14 @@ static void ui_food_render(
 
     floatbox_draw(&ui->fb_daily_consumption_rate);
 
+    // Batches committed since the last frame, by this screen or anything else
+    apply_foodbatch_changes(ui, foodbatch_db);
+
     // Start Info Panel
     draw_foodbatch_info_panel(ui);
 
+    draw_food_forecast_panel(ui);
+
     // Draw database content
     scrollpanel_draw(&ui->sp_table_view, draw_foodbatch_table_content, ui->str_table_content);
 
@@ -342,6 +390,11 @@ static void ui_food_handle_buttons(
         return;
     }
 
+    if (button_draw_updt(&ui->butn_plan_rations)) {
+        handle_plan_rations_button(ui, foodbatch_db);
+        return;
+    }
+
     return;
 }
 
@@ -408,6 +461,18 @@ static void ui_food_handle_warning_msg(
         flag_to_clear = FLAG_CONFIRM_FOOD_DELETE;
         action.type = DB_ACTION_DELETE;
         action.delete.batch_id = ui->ib_batch_id.input;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_NOTHING_TO_PLAN)) {
+        message = "Nothing to distribute: no residents,\nno daily consumption or no stock.";
+        flag_to_clear = FLAG_NOTHING_TO_PLAN;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CONFIRM_FOOD_PLAN)) {
+        message = TextFormat(
+            "Take the %d picks on the list\nout of stock? (%ld of %ld needed)",
+            ui->plan.pick_count,
+            ui->plan.allocated_total,
+            ui->plan.requested_total
+        );
+        flag_to_clear = FLAG_CONFIRM_FOOD_PLAN;
+        action.type = DB_ACTION_DISTRIBUTE;
     } else if (*error == ERROR_INSERT_DB || *error == ERROR_UPDATE_DB) {
         message = "Database error. Try again.";
         *error = NO_ERROR;
@@ -453,6 +518,7 @@ static void ui_food_update_positions(struct ui_base *base) {
     ui->butn_retrieve.bounds.y = ui->butn_submit.bounds.y;
     ui->butn_delete.bounds.y = ui->butn_submit.bounds.y;
     ui->butn_retrieve_all.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_plan_rations.bounds.y = ui->butn_submit.bounds.y;
     ui->sp_table_view.panel_bounds.width =
         window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20);
     ui->sp_table_view.panel_bounds.height = window_height - 100;
@@ -499,6 +565,11 @@ static void ui_food_cleanup(struct ui_base *base) {
         free(ui->str_table_content);
         ui->str_table_content = NULL; // Prevent double-free
     }
+
+    db_changes_unsubscribe(ui->changes_subscription);
+    ui->changes_subscription = 0;
+
+    discard_food_plan(ui);
 }
 /** @} */
 
@@ -532,6 +603,73 @@ static void draw_foodbatch_info_panel(struct ui_food *ui) {
     );
 }
 
+/**
+ * @internal
+ * @brief Formats a number of days of supply, "never" when nothing is consumed
+ */
+static const char *format_forecast_days(float days) {
+    return isinf(days) ? "never" : TextFormat("%.1f days", days);
+}
+
+/**
+ * @internal
+ * @brief Draws the run-out forecast, recomputed only when the forecast or the day changes
+ */
+static void draw_food_forecast_panel(struct ui_food *ui) {
+    if (!ui->forecast) {
+        return;
+    }
+
+    food_forecast_refresh(ui->forecast);
+    int32_t today = date_today();
+    unsigned version = food_forecast_version(ui->forecast);
+    if (version != ui->forecast_version || today != ui->forecast_today) {
+        food_forecast_summary(ui->forecast, today, &ui->forecast_summary);
+        ui->forecast_name_count = food_forecast_names(ui->forecast, ui->forecast_names, FOOD_FORECAST_PANEL_NAMES);
+        ui->forecast_version = version;
+        ui->forecast_today = today;
+    }
+
+    const struct food_forecast_summary *summary = &ui->forecast_summary;
+    Rectangle bounds = ui->forecast_panel_bounds;
+
+    GuiPanel(bounds, TextFormat("Food forecast (%d residents)", summary->residents));
+
+    char runout[DATE_STR_LEN];
+    date_format(summary->first_runout_day, runout);
+
+    GuiLabel(
+        (Rectangle) { bounds.x + 10, bounds.y + 30, 280, 20 },
+        TextFormat("Stock: %.0f in %d batches", summary->total_quantity, summary->batches)
+    );
+    GuiLabel(
+        (Rectangle) { bounds.x + 10, bounds.y + 50, 280, 20 },
+        TextFormat("Consumption: %.2f per day", summary->daily_consumption)
+    );
+    GuiLabel(
+        (Rectangle) { bounds.x + 10, bounds.y + 70, 280, 20 },
+        TextFormat(
+            "First run-out: %s%s%s",
+            format_forecast_days(summary->first_runout_days),
+            runout[0] ? ", until " : "",
+            runout
+        )
+    );
+    GuiLabel(
+        (Rectangle) { bounds.x + 10, bounds.y + 90, 280, 20 },
+        TextFormat("Shortest batch: %s", format_forecast_days(summary->shortest_batch_days))
+    );
+
+    GuiLabel((Rectangle) { bounds.x + 10, bounds.y + 115, 280, 20 }, "Running out first:");
+    for (int i = 0; i < ui->forecast_name_count; i++) {
+        const struct food_forecast_name *name = &ui->forecast_names[i];
+        GuiLabel(
+            (Rectangle) { bounds.x + 20, bounds.y + 135 + i * 18, 270, 18 },
+            TextFormat("%.24s: %s", name->name, format_forecast_days(name->days))
+        );
+    }
+}
+
 /**
  * @internal
  * @brief Draws the table content of the database
@@ -636,6 +774,17 @@ static void handle_delete_button(struct ui_food *ui, database *foodbatch_db) {
 }
 
 static void handle_retrieve_all_button(struct ui_food *ui, database *foodbatch_db) {
+    load_foodbatch_table(ui, foodbatch_db);
+
+    foodbatch_db_get_all(foodbatch_db); // also prints to stdout
+}
+
+/**
+ * @internal
+ * @brief Formats every batch into str_table_content and sizes the table view to it
+ */
+static void load_foodbatch_table(struct ui_food *ui, database *foodbatch_db) {
+    ui->table_shows_batches = false;
     if (ui->str_table_content) {
         free(ui->str_table_content); // Free old data before getting new data
         ui->str_table_content = NULL;
@@ -661,15 +810,8 @@ static void handle_retrieve_all_button(struct ui_food *ui, database *foodbatch_d
         return;
     }
 
-    // Set the panel_content_bounds rectangle based on the width and height of the retrieved text
-    if (ui->str_table_content) {
-        Vector2 text_size = MeasureTextEx(GuiGetFont(), ui->str_table_content, FONT_SIZE, 0);
-        ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
-        ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
-    }
-
-    foodbatch_db_get_all(foodbatch_db); // also prints to stdout
-    return;
+    ui->table_shows_batches = true;
+    fit_table_content(ui);
 }
 
 static void process_db_action_in_warning(
@@ -705,8 +847,207 @@ static void process_db_action_in_warning(
         SET_FLAG(&ui->flag, FLAG_FOOD_OPERATION_DONE);
         break;
 
+    case DB_ACTION_DISTRIBUTE:
+        apply_food_plan(ui, error, foodbatch_db);
+        break;
+
     case DB_ACTION_NONE:
     default:
         break;
     }
 }
+
+/**
+ * @internal
+ * @brief Sizes the table view content to the text in str_table_content
+ */
+static void fit_table_content(struct ui_food *ui) {
+    // Set the panel_content_bounds rectangle based on the width and height of the retrieved text
+    if (ui->str_table_content) {
+        Vector2 text_size = MeasureTextEx(GuiGetFont(), ui->str_table_content, FONT_SIZE, 0);
+        ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
+        ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
+    }
+}
+
+/**
+ * @internal
+ * @brief Notes a committed FoodBatch change, applied by the next render (db_changes_dispatch() callback)
+ */
+static void on_foodbatch_change(const struct db_change *change, void *ctx) {
+    struct ui_food *ui = ctx;
+    if (ui->changed_all) {
+        return;
+    }
+    if (change->op == DB_CHANGE_RESET) {
+        ui->changed_all = true;
+        return;
+    }
+
+    // Changes pile up while another screen is shown
+    for (int i = 0; i < ui->changed_count; i++) {
+        if (ui->changed_batches[i] == change->rowid) {
+            return;
+        }
+    }
+    if (ui->changed_count == UI_FOOD_CHANGED_ROWS) {
+        ui->changed_all = true;
+        return;
+    }
+    ui->changed_batches[ui->changed_count++] = (int)change->rowid;
+}
+
+/**
+ * @internal
+ * @brief Brings the retrieved batch and the batch table up to date with the noted changes
+ *
+ * Only the rows of the changed batches are formatted again and patched into the table, the
+ * whole table is reloaded after a reset or when a patch fails. A pick list on the table view
+ * is left as it is.
+ */
+static void apply_foodbatch_changes(struct ui_food *ui, database *foodbatch_db) {
+    if (ui->changed_count == 0 && !ui->changed_all) {
+        return;
+    }
+
+    bool patch = ui->str_table_content && ui->table_shows_batches;
+    bool reload = ui->changed_all;
+    bool refetch = ui->changed_all && ui->foodbatch_retrieved.name[0] != '\0';
+    for (int i = 0; i < ui->changed_count && !reload; i++) {
+        int batch_id = ui->changed_batches[i];
+        if (batch_id == ui->foodbatch_retrieved.batch_id) {
+            refetch = true;
+        }
+        if (!patch) {
+            continue;
+        }
+
+        char key[16];
+        snprintf(key, sizeof(key), "%d", batch_id);
+        char block[1024];
+        int len = foodbatch_db_get_format_by_batchid(foodbatch_db, batch_id, block, sizeof(block));
+        if (len < 0 || table_text_patch(&ui->str_table_content, key, len > 0 ? block : NULL) != 0) {
+            reload = true;
+        }
+    }
+
+    if (refetch) {
+        int batch_id = ui->foodbatch_retrieved.batch_id;
+        if (foodbatch_db_get_by_batchid(foodbatch_db, batch_id, &ui->foodbatch_retrieved) != SQLITE_OK) {
+            memset(&ui->foodbatch_retrieved, 0, sizeof(struct foodbatch)); // Deleted
+        }
+    }
+
+    if (patch) {
+        if (reload) {
+            load_foodbatch_table(ui, foodbatch_db);
+        } else {
+            fit_table_content(ui);
+        }
+    }
+
+    ui->changed_count = 0;
+    ui->changed_all = false;
+}
+
+/**
+ * @internal
+ * @brief Plans one day of rations for every resident and shows the pick list for confirmation
+ *
+ * The daily need of each food name is its forecast rate per resident times the resident count,
+ * rounded up.
+ */
+static void handle_plan_rations_button(struct ui_food *ui, database *foodbatch_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_CONFIRM_FOOD_PLAN | FLAG_NOTHING_TO_PLAN);
+    discard_food_plan(ui);
+
+    if (!ui->forecast) {
+        SET_FLAG(&ui->flag, FLAG_NOTHING_TO_PLAN);
+        return;
+    }
+
+    food_forecast_refresh(ui->forecast);
+    struct food_forecast_summary summary;
+    food_forecast_summary(ui->forecast, date_today(), &summary);
+    if (summary.names == 0 || summary.residents == 0) {
+        SET_FLAG(&ui->flag, FLAG_NOTHING_TO_PLAN);
+        return;
+    }
+
+    struct food_forecast_name *names = malloc(sizeof(*names) * (size_t)summary.names);
+    ui->plan_requests = malloc(sizeof(*ui->plan_requests) * (size_t)summary.names);
+    if (!names || !ui->plan_requests) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(names);
+        discard_food_plan(ui);
+        return;
+    }
+
+    int name_count = food_forecast_names(ui->forecast, names, summary.names);
+    int request_count = 0;
+    for (int i = 0; i < name_count; i++) {
+        double need = ceil(names[i].daily_rate * summary.residents);
+        if (need <= 0) {
+            continue;
+        }
+        struct food_request *request = &ui->plan_requests[request_count++];
+        snprintf(request->name, sizeof(request->name), "%s", names[i].name);
+        request->quantity = need < INT_MAX ? (int)need : INT_MAX;
+    }
+    free(names);
+
+    if (request_count == 0
+        || food_plan_build(foodbatch_db, ui->plan_requests, request_count, date_today(), &ui->plan) != SQLITE_OK
+        || ui->plan.pick_count == 0)
+    {
+        discard_food_plan(ui);
+        SET_FLAG(&ui->flag, FLAG_NOTHING_TO_PLAN);
+        return;
+    }
+
+    // Show the pick list on the table view
+    ui->table_shows_batches = false;
+    if (ui->str_table_content) {
+        free(ui->str_table_content);
+        ui->str_table_content = NULL;
+    }
+
+    // 512 for header + 512 for each pick and request as documented on food_plan_format
+    size_t buffer_size = 512 + 512 * (size_t)(ui->plan.pick_count + request_count);
+
+    ui->str_table_content = malloc(buffer_size);
+    if (!ui->str_table_content) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        discard_food_plan(ui);
+        return;
+    }
+
+    if (food_plan_format(&ui->plan, ui->plan_requests, ui->str_table_content, buffer_size) == -1) {
+        fprintf(stderr, "Failed to format pick list.\n");
+    }
+    fit_table_content(ui);
+
+    SET_FLAG(&ui->flag, FLAG_CONFIRM_FOOD_PLAN);
+}
+
+/**
+ * @internal
+ * @brief Takes the confirmed plan out of stock
+ */
+static void apply_food_plan(struct ui_food *ui, enum error_code *error, database *foodbatch_db) {
+    if (food_plan_apply(foodbatch_db, &ui->plan) != SQLITE_OK) {
+        // Stock changed since the plan was built, nothing was taken
+        *error = ERROR_UPDATE_DB;
+        discard_food_plan(ui);
+        return;
+    }
+
+    discard_food_plan(ui);
+    SET_FLAG(&ui->flag, FLAG_FOOD_OPERATION_DONE);
+}
+
+static void discard_food_plan(struct ui_food *ui) {
+    food_plan_free(&ui->plan);
+    free(ui->plan_requests);
+    ui->plan_requests = NULL;
+}
@@ -35,6 +35,8 @@ static void ui_login_updt_pos(struct ui_base *base);
 
 static void ui_login_clear_fields(struct ui_base *base);
 
+static void ui_login_cleanup(struct ui_base *base);
+
 // Tagged union for when a warning message needs to perform a database operation
 // Type of the operation
 enum ui_login_db_action_type {
@@ -62,12 +64,15 @@ static void process_db_action_in_warning(
     struct ui_login_db_action_info *action
 );
 
-static void handle_login_button(
+static void handle_login_button(struct ui_login *ui, enum error_code *error, database *user_db);
+
+static void handle_auth_result(
     struct ui_login *ui,
     enum app_state *state,
     enum error_code *error,
     database *user_db,
-    struct user *current_user
+    struct user *current_user,
+    enum auth_result result
 );
 
 /* ======================= PUBLIC FUNCTIONS ======================= */
@@ -81,6 +86,7 @@ void ui_login_init(struct ui_login *ui, struct user *current_user) {
     ui->base.handle_warning_msg = ui_login_handle_warning_msg;
     ui->base.update_positions = ui_login_updt_pos;
     ui->base.clear_fields = ui_login_clear_fields;
+    ui->base.cleanup = ui_login_cleanup;
 
     // Initialize screen specific fields
     ui->current_user = current_user;
@@ -103,6 +109,7 @@ void ui_login_init(struct ui_login *ui, struct user *current_user) {
     );
 
     ui->flag = 0;
+    ui->auth = NULL;
 }
 
 /* ======================= BASE INTERFACE OVERRIDES ======================= */
@@ -139,6 +146,24 @@ static void ui_login_render(struct ui_base *base, enum app_state *state, enum er
     textbox_draw(&ui->tb_username);
     textboxsecret_draw(&ui->tbs_password);
 
+    // Password being checked on the worker, the screen keeps drawing meanwhile
+    if (ui->auth) {
+        enum auth_result result;
+        if (user_db_authenticate_poll(ui->auth, user_db, &result)) {
+            ui->auth = NULL;
+            handle_auth_result(ui, state, error, user_db, ui->current_user, result);
+        } else {
+            int dots = (int)(GetTime() * 3) % 4;
+            GuiLabel(
+                (Rectangle) { ui->butn_login.bounds.x,
+                              ui->butn_login.bounds.y + ui->butn_login.bounds.height + 10,
+                              200,
+                              20 },
+                TextFormat("Checking password%.*s", dots, "...")
+            );
+        }
+    }
+
     // Handle and draw buttons
     ui->base.handle_buttons(&ui->base, state, error, user_db);
 
@@ -170,8 +195,18 @@ static void ui_login_handle_buttons(
     database *user_db
 ) {
     struct ui_login *ui = (struct ui_login *)base;
+    (void)state;
+
+    // One check at a time
+    if (ui->auth) {
+        GuiDisable();
+        button_draw_updt(&ui->butn_login);
+        GuiEnable();
+        return;
+    }
+
     if (button_draw_updt(&ui->butn_login) || IsKeyPressed(KEY_ENTER)) {
-        handle_login_button(ui, state, error, user_db, ui->current_user);
+        handle_login_button(ui, error, user_db);
         return;
     }
 }
@@ -299,6 +334,24 @@ static void ui_login_clear_fields(struct ui_base *base) {
     ui->tb_username.input[0] = '\0';
     memset(ui->tbs_password.input, 0, sizeof(ui->tbs_password.input)); // More secure
 }
+
+/**
+ * @brief Cleanup function of the ui_login
+ * 
+ * @implements ui_base.cleanup
+ *
+ * Waits for a password check still running and drops its result.
+ *
+ * @param base Pointer to base UI (interface) structure (can be safely cast to ui_login*)
+ * 
+ * @warning Should be called through the base interface
+ * 
+ */
+static void ui_login_cleanup(struct ui_base *base) {
+    struct ui_login *ui = (struct ui_login *)base;
+    user_db_authenticate_cancel(ui->auth);
+    ui->auth = NULL;
+}
 /** @} */
 
 /* ======================= INTERNAL HELPERS ======================= */
@@ -345,42 +398,21 @@ static void process_db_action_in_warning(
 
 /**
  * @brief Handles the login button press and authentication flow.
- * @details Validates input fields, checks user credentials, and manages state transitions.
+ * @details Validates input fields and starts checking the credentials, handle_auth_result()
+ *          manages the state transitions once the check is done.
  * 
  * @param[in]  ui           Login screen UI context
- * @param[out] state        Application state (modified on successful login)
  * @param[out] error        Error code (set on database failures)
  * @param[in]  user_db      Database connection for user authentication
- * @param[out] current_user Populated with user data on successful login
  *
  * @note The function handles these cases:
  *       1. Empty username/password
  *       2. Non-existent user
- *       3. Wrong password
- *       4. Password reset requirement
- *       5. Successful authentication
+ *       3. Anything else starts ui->auth
  *
- * @warning
- * This function modifies multiple state variables:
- * 
- * - Sets ui->flag for validation/authentication status
- * 
- * - Sets error on database failures
- * 
- * - May modify ui->flag with status flags
- * 
- * - May change application state to STATE_MAIN_MENU
- * 
- * - May populate current_user data
- * 
+ * @warning Sets ui->flag for validation status
  */
-static void handle_login_button(
-    struct ui_login *ui,
-    enum app_state *state,
-    enum error_code *error,
-    database *user_db,
-    struct user *current_user
-) {
+static void handle_login_button(struct ui_login *ui, enum error_code *error, database *user_db) {
     // Clear previous flags
     CLEAR_FLAG(
         &ui->flag,
@@ -403,9 +435,48 @@ static void handle_login_button(
         return;
     }
 
-    // Perform authentication
-    enum auth_result result = user_db_authenticate(user_db, ui->tb_username.input, ui->tbs_password.input);
+    // Perform authentication, the password is checked on a worker and the result handled once it is done
+    ui->auth = user_db_authenticate_start(user_db, ui->tb_username.input, ui->tbs_password.input);
+    if (!ui->auth) {
+        *error = ERROR_DB_STMT;
+    }
+}
 
+/**
+ * @brief Acts on the outcome of an authentication
+ * 
+ * @param[in]  ui           Login screen UI context
+ * @param[out] state        Application state (modified on successful login)
+ * @param[out] error        Error code (set on database failures)
+ * @param[in]  user_db      Database connection for user authentication
+ * @param[out] current_user Populated with user data on successful login
+ * @param[in]  result       Result of user_db_authenticate_poll()
+ *
+ * @note The function handles these cases:
+ *       1. Wrong password
+ *       2. Password reset requirement
+ *       3. Successful authentication
+ *
+ * @warning
+ * This function modifies multiple state variables:
+ * 
+ * - Sets error on database failures
+ * 
+ * - May modify ui->flag with status flags
+ * 
+ * - May change application state to STATE_MAIN_MENU
+ * 
+ * - May populate current_user data
+ * 
+ */
+static void handle_auth_result(
+    struct ui_login *ui,
+    enum app_state *state,
+    enum error_code *error,
+    database *user_db,
+    struct user *current_user,
+    enum auth_result result
+) {
     switch (result) {
     case AUTH_NEED_PASSWORD_RESET:
         SET_FLAG(&ui->flag, FLAG_PASSWD_RESET);
@@ -4,12 +4,14 @@
  */
 #include "ui/screens/ui_main_menu.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include <external/raylib/raygui.h>
 
 #include "db/user_db.h"
 #include "global/globals.h"
+#include "utils/utils_date.h"
 #include "utils/utilsfn.h"
 
 /* Forward declarations */
@@ -54,9 +56,13 @@ static void handle_settings_button(enum app_state *state);
 
 static void handle_logout_button(struct ui_main_menu *ui, enum app_state *state);
 
+static void refresh_expiration_alerts(struct ui_main_menu *ui);
+
+static void draw_expiration_alerts(struct ui_main_menu *ui);
+
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
-void ui_main_menu_init(struct ui_main_menu *ui, struct user *current_user) {
+void ui_main_menu_init(struct ui_main_menu *ui, struct user *current_user, struct expiration_alerts *alerts) {
     // Initialize base
     ui_base_init_defaults(&ui->base, "Main Menu");
     // Override methods
@@ -104,6 +110,23 @@ void ui_main_menu_init(struct ui_main_menu *ui, struct user *current_user) {
 
     ui->logout_butn = button_init((Rectangle) { window_width - 100, window_height - 60, 0, 30 }, "Log Out");
 
+    ui->alerts_butn = button_init(
+        (Rectangle) { ui->create_user_butn.bounds.x, ui->create_user_butn.bounds.y + 100, 200, 50 },
+        "Expiration Alerts"
+    );
+
+    ui->alerts = alerts;
+    ui->show_alerts = false;
+    ui->alerts_version = 0;
+    ui->alerts_today = DATE_INVALID; // Forces the first refresh
+    ui->alerts_due_count = 0;
+    ui->alerts_list_count = 0;
+    ui->alerts_scroll_index = 0;
+    ui->alerts_panel_bounds = (Rectangle) { ui->alerts_butn.bounds.x + ui->alerts_butn.bounds.width + 20,
+                                            50,
+                                            window_width - (ui->alerts_butn.bounds.x + ui->alerts_butn.bounds.width + 290),
+                                            window_height - 150 };
+
     ui->flag = 0;
 }
 
@@ -137,8 +160,13 @@ static void ui_main_menu_render(
 ) {
     struct ui_main_menu *ui = (struct ui_main_menu *)base;
 
+    refresh_expiration_alerts(ui);
+
     ui->base.handle_buttons(&ui->base, state, error, user_db);
 
+    // After the buttons so the badge is drawn over the alerts button
+    draw_expiration_alerts(ui);
+
     ui->base.handle_warning_msg(&ui->base, state, error, user_db);
 }
 
@@ -197,6 +225,11 @@ static void ui_main_menu_handle_buttons(
         return;
     }
 
+    if (ui->alerts && button_draw_updt(&ui->alerts_butn)) {
+        ui->show_alerts = !ui->show_alerts;
+        return;
+    }
+
     if (button_draw_updt(&ui->logout_butn)) {
         handle_logout_button(ui, state);
     }
@@ -260,6 +293,9 @@ static void ui_main_menu_update_positions(struct ui_base *base) {
     ui->settings_butn.bounds.x = window_width - 250;
     ui->logout_butn.bounds.x = window_width - 100;
     ui->logout_butn.bounds.y = window_height - 60;
+    ui->alerts_panel_bounds.width =
+        window_width - (ui->alerts_butn.bounds.x + ui->alerts_butn.bounds.width + 290);
+    ui->alerts_panel_bounds.height = window_height - 150;
 }
 /** @} */
 
@@ -314,3 +350,95 @@ static void handle_logout_button(struct ui_main_menu *ui, enum app_state *state)
     memset(ui->current_user, 0, sizeof(struct user));
     *state = STATE_LOGIN_MENU;
 }
+
+/**
+ * @internal
+ * @brief Rebuilds the badge count and the alerts list when the alert set or the day changed
+ *
+ * Called every frame, but the set is only walked after a change, otherwise it is two comparisons.
+ */
+static void refresh_expiration_alerts(struct ui_main_menu *ui) {
+    if (!ui->alerts) {
+        return;
+    }
+
+    int32_t today = date_today();
+    unsigned version = expiration_alerts_version(ui->alerts);
+    if (version == ui->alerts_version && today == ui->alerts_today) {
+        return;
+    }
+    ui->alerts_version = version;
+    ui->alerts_today = today;
+
+    int32_t until_day = today + EXPIRATION_ALERT_WINDOW_DAYS;
+    ui->alerts_due_count = expiration_alerts_count_due(ui->alerts, until_day);
+
+    struct expiration_alert due[MAIN_MENU_ALERTS_MAX];
+    ui->alerts_list_count = expiration_alerts_due(ui->alerts, until_day, due, MAIN_MENU_ALERTS_MAX);
+
+    for (int i = 0; i < ui->alerts_list_count; i++) {
+        char date[DATE_STR_LEN];
+        date_format(due[i].day, date);
+
+        char when[32];
+        int days_left = due[i].day - today;
+        if (days_left < 0) {
+            snprintf(when, sizeof(when), "expired");
+        } else if (days_left == 0) {
+            snprintf(when, sizeof(when), "today");
+        } else {
+            snprintf(when, sizeof(when), "in %d day%s", days_left, days_left == 1 ? "" : "s");
+        }
+
+        snprintf(
+            ui->alerts_labels[i],
+            sizeof(ui->alerts_labels[i]),
+            "%s %s: %.64s (%s)",
+            date,
+            due[i].source == EXPIRATION_FOOD ? "Food" : "Medication",
+            due[i].name,
+            when
+        );
+        ui->alerts_label_ptrs[i] = ui->alerts_labels[i];
+    }
+}
+
+/**
+ * @internal
+ * @brief Draws the badge with the number of due items and, when open, the list of them
+ */
+static void draw_expiration_alerts(struct ui_main_menu *ui) {
+    if (!ui->alerts) {
+        return;
+    }
+
+    if (ui->alerts_due_count > 0) {
+        const char *count = TextFormat("%d", ui->alerts_due_count);
+        int text_width = MeasureText(count, 10);
+        Vector2 center = { ui->alerts_butn.bounds.x + ui->alerts_butn.bounds.width, ui->alerts_butn.bounds.y };
+        float radius = (text_width / 2.0f) + 6 > 10 ? (text_width / 2.0f) + 6 : 10;
+
+        DrawCircleV(center, radius, RED);
+        DrawText(count, (int)(center.x - text_width / 2.0f), (int)(center.y - 5), 10, RAYWHITE);
+    }
+
+    if (!ui->show_alerts) {
+        return;
+    }
+
+    if (ui->alerts_list_count == 0) {
+        GuiPanel(ui->alerts_panel_bounds, "Nothing expiring soon");
+        return;
+    }
+
+    int active = -1;
+    int focus = -1;
+    GuiListViewEx(
+        ui->alerts_panel_bounds,
+        ui->alerts_label_ptrs,
+        ui->alerts_list_count,
+        &ui->alerts_scroll_index,
+        &active,
+        &focus
+    );
+}
@@ -4,9 +4,16 @@
  */
 #include "ui/screens/ui_medication.h"
 
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include <external/raylib/raygui.h>
 
 #include "db/medication_db.h"
+#include "db/resident_db.h"
 #include "global/globals.h"
 #include "utils/utilsfn.h"
 
@@ -21,21 +28,267 @@ static void ui_medication_handle_buttons(
     database *medication_db
 );
 
-static void handle_back_button(enum app_state *state);
+static void ui_medication_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *medication_db
+);
+
+static void ui_medication_update_positions(struct ui_base *base);
+
+static void ui_medication_clear_fields(struct ui_base *base);
+
+static void ui_medication_cleanup(struct ui_base *base);
+
+// Tagged union for when a warning message needs to perform a database operation
+// Type of the operation
+enum ui_medication_db_action_type {
+    DB_ACTION_NONE,
+    DB_ACTION_UPDATE,
+    DB_ACTION_DELETE,
+};
+
+// Info for the database operation based on the type
+struct ui_medication_db_action_info {
+    enum ui_medication_db_action_type type;
+    union {
+        struct {
+            int id;
+        } update;
+
+        struct {
+            int id;
+        } delete;
+    };
+};
+
+static void process_db_action_in_warning(
+    struct ui_medication *ui,
+    enum error_code *error,
+    struct ui_medication_db_action_info *action,
+    database *medication_db
+);
+
+static void draw_medication_info_panel(struct ui_medication *ui);
+
+static void draw_dose_list(struct ui_medication *ui, database *medication_db);
+
+static void draw_medication_table_content(Rectangle bounds, char *data);
+
+static void handle_back_button(struct ui_medication *ui, enum app_state *state);
+
+static void handle_submit_button(struct ui_medication *ui, enum error_code *error, database *medication_db);
+
+static void handle_retrieve_button(struct ui_medication *ui, database *medication_db);
+
+static void handle_delete_button(struct ui_medication *ui, database *medication_db);
+
+static void handle_retrieve_all_button(struct ui_medication *ui, database *medication_db);
+
+static void handle_dispense_button(struct ui_medication *ui, enum error_code *error, database *medication_db);
+
+static void handle_schedule_button(struct ui_medication *ui, enum error_code *error, database *medication_db);
+
+static void handle_history_button(struct ui_medication *ui, database *medication_db);
+
+static void handle_give_button(struct ui_medication *ui, enum error_code *error, database *medication_db);
+
+static void handle_skip_button(struct ui_medication *ui, database *medication_db);
+
+static bool read_date_fields(struct ui_medication *ui, char date_string[11]);
+
+static bool check_resident(struct ui_medication *ui);
+
+static void set_table_content(struct ui_medication *ui, char *content);
+
+static void sync_stored_medication(struct ui_medication *ui, database *medication_db, int id);
 
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
-void ui_medication_init(struct ui_medication *ui) {
+void ui_medication_init(
+    struct ui_medication *ui,
+    database *resident_db,
+    struct expiration_alerts *alerts,
+    struct dose_schedule *doses
+) {
     // Initialize base
     ui_base_init_defaults(&ui->base, "Medication");
     // Override methods
     ui->base.render = ui_medication_render;
     ui->base.handle_buttons = ui_medication_handle_buttons;
+    ui->base.handle_warning_msg = ui_medication_handle_warning_msg;
+    ui->base.update_positions = ui_medication_update_positions;
+    ui->base.clear_fields = ui_medication_clear_fields;
+    ui->base.cleanup = ui_medication_cleanup;
 
     // Initialize ui specific fields
 
     ui->butn_back = button_init((Rectangle) { 20, 20, 0, 30 }, "Back");
 
+    ui->ib_id = intbox_init(
+        (Rectangle) { 20, ui->butn_back.bounds.y + (ui->butn_back.bounds.height * 2), 130, 30 },
+        "ID (0 for new):",
+        0,
+        99999999
+    );
+
+    ui->tb_name =
+        textbox_init((Rectangle) { 20, ui->ib_id.bounds.y + (ui->ib_id.bounds.height * 2), 300, 30 }, "Name:");
+
+    ui->tb_generic = textbox_init(
+        (Rectangle) { 20, ui->tb_name.bounds.y + (ui->tb_name.bounds.height * 2), 300, 30 },
+        "Generic name:"
+    );
+
+    ui->tb_form = textbox_init(
+        (Rectangle) { 20, ui->tb_generic.bounds.y + (ui->tb_generic.bounds.height * 2), 145, 30 },
+        "Form:"
+    );
+
+    ui->tb_strength = textbox_init(
+        (Rectangle) { ui->tb_form.bounds.x + ui->tb_form.bounds.width + 10, ui->tb_form.bounds.y, 145, 30 },
+        "Strength:"
+    );
+
+    ui->tb_unit = textbox_init(
+        (Rectangle) { 20, ui->tb_form.bounds.y + (ui->tb_form.bounds.height * 2), 145, 30 },
+        "Unit:"
+    );
+
+    ui->ib_stock = intbox_init(
+        (Rectangle) { ui->tb_unit.bounds.x + ui->tb_unit.bounds.width + 10, ui->tb_unit.bounds.y, 145, 30 },
+        "Stock:",
+        0,
+        INT_MAX
+    );
+
+    ui->expirationDateText = (Rectangle) { 20,
+                                           ui->tb_unit.bounds.y + (ui->tb_unit.bounds.height * 2) - 10,
+                                           MeasureText("Expiration date (optional):", FONT_SIZE),
+                                           20 };
+
+    ui->ib_year = intbox_init(
+        (Rectangle) { 20, ui->expirationDateText.y + (ui->expirationDateText.height * 2), 40, 30 },
+        "Year",
+        0,
+        9999
+    );
+
+    ui->ib_month = intbox_init(
+        (Rectangle) { ui->ib_year.bounds.x + ui->ib_year.bounds.width + 5, ui->ib_year.bounds.y, 35, 30 },
+        "Month",
+        0,
+        12
+    );
+
+    ui->ib_day = intbox_init(
+        (Rectangle) { ui->ib_month.bounds.x + ui->ib_month.bounds.width + 5, ui->ib_year.bounds.y, 35, 30 },
+        "Day",
+        0,
+        31
+    );
+
+    ui->tb_notes = textbox_init(
+        (Rectangle) { 20, ui->ib_year.bounds.y + (ui->ib_year.bounds.height * 2), 300, 30 },
+        "Notes:"
+    );
+
+    ui->butn_submit = button_init((Rectangle) { 20, window_height - 60, 100, 30 }, "Submit");
+    ui->butn_retrieve = button_init(
+        (Rectangle) { ui->butn_submit.bounds.x + ui->butn_submit.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Retrieve"
+    );
+    ui->butn_delete = button_init(
+        (Rectangle
+        ) { ui->butn_retrieve.bounds.x + ui->butn_retrieve.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Delete"
+    );
+    ui->butn_retrieve_all = button_init(
+        (Rectangle) { ui->butn_delete.bounds.x + ui->butn_delete.bounds.width + 10, ui->butn_submit.bounds.y, 0, 30 },
+        "Retrieve All"
+    );
+
+    memset(&ui->medication_retrieved, 0, sizeof(struct medication));
+
+    // Only set the bounds of the panel, draw everything inside based on it on the draw info panel function
+    ui->panel_bounds = (Rectangle) { ui->tb_name.bounds.x + ui->tb_name.bounds.width + 10, 10, 300, 250 };
+
+    // Dispensing and schedules, below the info panel
+    ui->tbi_cpf = textboxint_init(
+        (Rectangle) { ui->panel_bounds.x, ui->panel_bounds.y + ui->panel_bounds.height + 35, 200, 30 },
+        "Resident CPF:"
+    );
+
+    ui->ib_dose_quantity = intbox_init(
+        (Rectangle) { ui->panel_bounds.x, ui->tbi_cpf.bounds.y + (ui->tbi_cpf.bounds.height * 2), 80, 30 },
+        "Units:",
+        0,
+        INT_MAX
+    );
+
+    ui->ib_interval_hours = intbox_init(
+        (Rectangle) { ui->ib_dose_quantity.bounds.x + ui->ib_dose_quantity.bounds.width + 20,
+                      ui->ib_dose_quantity.bounds.y,
+                      80,
+                      30 },
+        "Every (hours):",
+        0,
+        24 * 365
+    );
+
+    ui->butn_dispense = button_init(
+        (Rectangle) { ui->panel_bounds.x, ui->ib_dose_quantity.bounds.y + ui->ib_dose_quantity.bounds.height + 10, 0, 30 },
+        "Dispense"
+    );
+    ui->butn_schedule = button_init(
+        (Rectangle) { ui->butn_dispense.bounds.x + ui->butn_dispense.bounds.width + 10,
+                      ui->butn_dispense.bounds.y,
+                      0,
+                      30 },
+        "Schedule"
+    );
+    ui->butn_history = button_init(
+        (Rectangle) { ui->butn_schedule.bounds.x + ui->butn_schedule.bounds.width + 10,
+                      ui->butn_dispense.bounds.y,
+                      0,
+                      30 },
+        "History"
+    );
+
+    // Doses due fill the rest of the column, give/skip above the bottom buttons
+    ui->dose_list_bounds = (Rectangle) { ui->panel_bounds.x,
+                                         ui->butn_dispense.bounds.y + ui->butn_dispense.bounds.height + 35,
+                                         ui->panel_bounds.width,
+                                         0 };
+    ui->butn_give = button_init((Rectangle) { ui->panel_bounds.x, window_height - 100, 0, 30 }, "Give Dose");
+    ui->butn_skip = button_init(
+        (Rectangle) { ui->butn_give.bounds.x + ui->butn_give.bounds.width + 10, ui->butn_give.bounds.y, 0, 30 },
+        "Skip Dose"
+    );
+    ui->dose_list_bounds.height = ui->butn_give.bounds.y - 10 - ui->dose_list_bounds.y;
+
+    ui->sp_table_view = scrollpanel_init(
+        (Rectangle) { ui->panel_bounds.x + ui->panel_bounds.width + 10,
+                      10,
+                      window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20),
+                      window_height - 100 },
+        "Database view",
+        (Rectangle) { 0, 0, 0, 0 }
+    );
+
+    ui->str_table_content = NULL;
+
+    ui->resident_db = resident_db;
+    ui->alerts = alerts;
+    ui->doses = doses;
+
+    ui->dose_version = 0; // Nothing is due before the first change
+    ui->dose_count = 0;
+    ui->dose_scroll = 0;
+    ui->dose_active = -1;
+    ui->dose_focus = -1;
+
     ui->flag = 0;
 }
 
@@ -49,7 +302,7 @@ void ui_medication_init(struct ui_medication *ui) {
 
 /**
  * @brief Medication screen rendering and interaction handling.
- * 
+ *
  * @implements ui_base.render
  *
  * Handles rendering and interaction for all menu elements.
@@ -57,8 +310,8 @@ void ui_medication_init(struct ui_medication *ui) {
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any other ui*)
  * @param state Pointer to application state
  * @param error Pointer to error code
- * @param medication_db Pointer to the medication database 
- * 
+ * @param medication_db Pointer to the medication database
+ *
  * @warning Should be called through the base interface
  */
 static void ui_medication_render(
@@ -69,19 +322,75 @@ static void ui_medication_render(
 ) {
     struct ui_medication *ui = (struct ui_medication *)base;
 
+    // Start draw UI elements
+
+    intbox_draw(&ui->ib_id);
+    textbox_draw(&ui->tb_name);
+    textbox_draw(&ui->tb_generic);
+    textbox_draw(&ui->tb_form);
+    textbox_draw(&ui->tb_strength);
+    textbox_draw(&ui->tb_unit);
+    intbox_draw(&ui->ib_stock);
+
+    GuiLabel(ui->expirationDateText, "Expiration date (optional):");
+
+    intbox_draw(&ui->ib_year);
+    GuiLabel(
+        (Rectangle) { ui->ib_year.bounds.x + ui->ib_year.bounds.width - 1,
+                      ui->ib_year.bounds.y + (ui->ib_year.bounds.height / 2) - 5,
+                      10,
+                      10 },
+        "-"
+    );
+    intbox_draw(&ui->ib_month);
+    GuiLabel(
+        (Rectangle) { ui->ib_month.bounds.x + ui->ib_month.bounds.width - 1,
+                      ui->ib_month.bounds.y + (ui->ib_month.bounds.height / 2) - 5,
+                      10,
+                      10 },
+        "-"
+    );
+    intbox_draw(&ui->ib_day);
+
+    textbox_draw(&ui->tb_notes);
+
+    // Start Info Panel
+    draw_medication_info_panel(ui);
+
+    textboxint_draw(&ui->tbi_cpf);
+    intbox_draw(&ui->ib_dose_quantity);
+    intbox_draw(&ui->ib_interval_hours);
+
+    draw_dose_list(ui, medication_db);
+
+    // Draw database content
+    scrollpanel_draw(&ui->sp_table_view, draw_medication_table_content, ui->str_table_content);
+
+    // End draw UI elements
+
+    // Start button actions
     ui->base.handle_buttons(&ui->base, state, error, medication_db);
+
+    // Start show warning/error boxes
+    ui->base.handle_warning_msg(&ui->base, state, error, medication_db);
+
+    // Clear the text buffer only after a successful operation
+    if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_OPERATION_DONE)) {
+        ui->base.clear_fields(&ui->base);
+        CLEAR_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+    }
 }
 
 /**
  * @brief Handle button drawing and logic.
- * 
+ *
  * @implements ui_base.handle_buttons
  *
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any ui*)
  * @param state Pointer to application state
  * @param error Pointer to error tracking variable
  * @param medication_db Pointer to medication database connection
- * 
+ *
  * @warning Should be called through the base interface
  */
 static void ui_medication_handle_buttons(
@@ -90,20 +399,779 @@ static void ui_medication_handle_buttons(
     enum error_code *error,
     database *medication_db
 ) {
-    (void)error;
-    (void)medication_db;
-
     struct ui_medication *ui = (struct ui_medication *)base;
 
     if (button_draw_updt(&ui->butn_back)) {
-        handle_back_button(state);
+        handle_back_button(ui, state);
         return;
     }
+
+    if (button_draw_updt(&ui->butn_submit)) {
+        handle_submit_button(ui, error, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve)) {
+        handle_retrieve_button(ui, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_delete)) {
+        handle_delete_button(ui, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve_all)) {
+        handle_retrieve_all_button(ui, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_dispense)) {
+        handle_dispense_button(ui, error, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_schedule)) {
+        handle_schedule_button(ui, error, medication_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_history)) {
+        handle_history_button(ui, medication_db);
+        return;
+    }
+
+    if (ui->doses && button_draw_updt(&ui->butn_give)) {
+        handle_give_button(ui, error, medication_db);
+        return;
+    }
+
+    if (ui->doses && button_draw_updt(&ui->butn_skip)) {
+        handle_skip_button(ui, medication_db);
+        return;
+    }
+}
+
+/**
+ * @brief Manages medication warning/confirmation dialogs
+ *
+ * @implements ui_base.handle_warning_msg
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_medication*)
+ * @param state Pointer to application state
+ * @param error Pointer to error tracking variable
+ * @param medication_db Pointer to medication database connection
+ *
+ * @warning May trigger database operations on confirmation
+ */
+static void ui_medication_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *medication_db
+) {
+    (void)state;
+
+    struct ui_medication *ui = (struct ui_medication *)base;
+
+    const char *message = NULL;
+    enum medication_screen_flags flag_to_clear = 0;
+    struct ui_medication_db_action_info action = { 0 };
+    action.type = DB_ACTION_NONE;
+
+    // Warnings
+    if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND)) {
+        message = "Medication ID not found.";
+        flag_to_clear = FLAG_MEDICATION_ID_NOT_FOUND;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_INVALID_MEDICATION_DATE)) {
+        message = "Date inserted is not valid.";
+        flag_to_clear = FLAG_INVALID_MEDICATION_DATE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_NAME_EMPTY)) {
+        message = "Name cannot be empty.";
+        flag_to_clear = FLAG_MEDICATION_NAME_EMPTY;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_DUPLICATE)) {
+        message = "A medication with this name, form\nand strength already exists.";
+        flag_to_clear = FLAG_MEDICATION_DUPLICATE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_RESIDENT_NOT_FOUND)) {
+        message = "CPF not valid or resident not registered.";
+        flag_to_clear = FLAG_MEDICATION_RESIDENT_NOT_FOUND;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_NO_STOCK)) {
+        message = "Not enough stock to dispense.";
+        flag_to_clear = FLAG_MEDICATION_NO_STOCK;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_INVALID_DOSE)) {
+        message = "Units must be greater than 0.";
+        flag_to_clear = FLAG_MEDICATION_INVALID_DOSE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_NO_DOSE_SELECTED)) {
+        message = "Select a dose on the list first.";
+        flag_to_clear = FLAG_NO_DOSE_SELECTED;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_MEDICATION_ID_EXISTS)) {
+        message = "Medication ID already exists. Update?";
+        flag_to_clear = FLAG_MEDICATION_ID_EXISTS;
+        action.type = DB_ACTION_UPDATE;
+        action.update.id = ui->ib_id.input;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CONFIRM_MEDICATION_DELETE)) {
+        message = "Are you sure you want to delete\nthis medication and its schedules?";
+        flag_to_clear = FLAG_CONFIRM_MEDICATION_DELETE;
+        action.type = DB_ACTION_DELETE;
+        action.delete.id = ui->ib_id.input;
+    } else if (*error == ERROR_INSERT_DB || *error == ERROR_UPDATE_DB || *error == ERROR_DELETE_DB) {
+        message = "Database error. Try again.";
+        *error = NO_ERROR;
+    }
+
+    if (message) {
+        const char *buttons = (action.type != DB_ACTION_NONE) ? "Yes;No" : "OK";
+
+        int result = GuiMessageBox(
+            (Rectangle) { window_width / 2 - 150, window_height / 2 - 50, 300, 150 },
+            "#191#Warning!",
+            message,
+            buttons
+        );
+
+        if (result == 1 && action.type != DB_ACTION_NONE) {
+            process_db_action_in_warning(ui, error, &action, medication_db);
+        }
+
+        if (result >= 0 && flag_to_clear) {
+            CLEAR_FLAG(&ui->flag, flag_to_clear);
+        }
+    }
+}
+
+/**
+ * @brief Updates medication UI element positions for window resizing
+ *
+ * @implements ui_base.update_positions
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_medication*)
+ *
+ * @note If any ui element is initialized with window_width or window_height
+ *       in their bounds, they must be updated here
+ *
+ * @warning Should be called on window resize events
+ */
+static void ui_medication_update_positions(struct ui_base *base) {
+    struct ui_medication *ui = (struct ui_medication *)base;
+
+    ui->butn_submit.bounds.y = window_height - 60;
+    ui->butn_retrieve.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_delete.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_retrieve_all.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_give.bounds.y = window_height - 100;
+    ui->butn_skip.bounds.y = ui->butn_give.bounds.y;
+    ui->dose_list_bounds.height = ui->butn_give.bounds.y - 10 - ui->dose_list_bounds.y;
+    ui->sp_table_view.panel_bounds.width = window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20);
+    ui->sp_table_view.panel_bounds.height = window_height - 100;
+}
+
+/**
+ * @brief Clears all medication input fields
+ *
+ * @implements ui_base.clear_fields
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_medication*)
+ *
+ * @post All inputs are reset to defaults, the resident CPF is kept for the next dose
+ */
+static void ui_medication_clear_fields(struct ui_base *base) {
+    struct ui_medication *ui = (struct ui_medication *)base;
+
+    ui->ib_id.input = 0;
+    ui->tb_name.input[0] = '\0';
+    ui->tb_generic.input[0] = '\0';
+    ui->tb_form.input[0] = '\0';
+    ui->tb_strength.input[0] = '\0';
+    ui->tb_unit.input[0] = '\0';
+    ui->ib_stock.input = 0;
+    ui->ib_year.input = 0;
+    ui->ib_month.input = 0;
+    ui->ib_day.input = 0;
+    ui->tb_notes.input[0] = '\0';
+    ui->ib_dose_quantity.input = 0;
+    ui->ib_interval_hours.input = 0;
+}
+
+/**
+ * @brief Cleans up medication screen resources
+ *
+ * @implements ui_base.cleanup
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_medication*)
+ *
+ * @warning Frees any allocated buffers/memory
+ */
+static void ui_medication_cleanup(struct ui_base *base) {
+    struct ui_medication *ui = (struct ui_medication *)base;
+
+    set_table_content(ui, NULL);
 }
 /** @} */
 
 /* ======================= INTERNAL HELPERS ======================= */
 
-static void handle_back_button(enum app_state *state) {
+static void draw_medication_info_panel(struct ui_medication *ui) {
+    const struct medication *medication = &ui->medication_retrieved;
+
+    GuiPanel(ui->panel_bounds, TextFormat("Medication ID retrieved: %d", medication->id));
+
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 30, 280, 20 },
+        TextFormat("Name: %s", medication->name)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 60, 280, 20 },
+        TextFormat("Generic name: %s", medication->generic_name)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 90, 280, 20 },
+        TextFormat("Form: %s  Strength: %s", medication->form, medication->strength)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 120, 280, 20 },
+        TextFormat("Stock: %d %s", medication->stock, medication->unit)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 150, 280, 20 },
+        TextFormat("Expiration date: %s", medication->expiration_date)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 180, 280, 20 },
+        TextFormat("Notes: %s", medication->notes)
+    );
+}
+
+/**
+ * @internal
+ * @brief Formats minutes since the epoch as local "MM-DD HH:MM"
+ */
+static void format_dose_minute(int64_t minute, char out[16]) {
+    time_t seconds = (time_t)(minute * 60);
+    struct tm *local = localtime(&seconds);
+    if (!local || strftime(out, 16, "%m-%d %H:%M", local) == 0) {
+        snprintf(out, 16, "?");
+    }
+}
+
+/**
+ * @internal
+ * @brief Draws the doses due, the lines are rebuilt only when the reminders change
+ */
+static void draw_dose_list(struct ui_medication *ui, database *medication_db) {
+    if (!ui->doses) {
+        return;
+    }
+
+    unsigned version = dose_schedule_version(ui->doses);
+    if (version != ui->dose_version) {
+        ui->dose_count = dose_schedule_due(ui->doses, ui->dose_due, MEDICATION_DOSE_LIST_MAX);
+        for (int i = 0; i < ui->dose_count; i++) {
+            const struct dose_reminder *dose = &ui->dose_due[i];
+
+            struct medication medication;
+            if (medication_db_get_by_id(medication_db, dose->medication_id, &medication) != SQLITE_OK) {
+                snprintf(medication.name, sizeof(medication.name), "#%d", dose->medication_id);
+                medication.unit[0] = '\0';
+            }
+
+            char due[16];
+            format_dose_minute(dose->due_minute, due);
+            snprintf(
+                ui->dose_lines[i],
+                sizeof(ui->dose_lines[i]),
+                "%s %s: %.24s x%d %.12s",
+                due,
+                dose->cpf,
+                medication.name,
+                dose->quantity,
+                medication.unit
+            );
+            ui->dose_line_ptrs[i] = ui->dose_lines[i];
+        }
+        if (ui->dose_active >= ui->dose_count) {
+            ui->dose_active = -1;
+        }
+        ui->dose_version = version;
+    }
+
+    int total = dose_schedule_due_count(ui->doses);
+    GuiLabel(
+        (Rectangle) { ui->dose_list_bounds.x, ui->dose_list_bounds.y - 25, ui->dose_list_bounds.width, 20 },
+        TextFormat("Doses due: %d", total)
+    );
+    GuiListViewEx(
+        ui->dose_list_bounds,
+        ui->dose_line_ptrs,
+        ui->dose_count,
+        &ui->dose_scroll,
+        &ui->dose_active,
+        &ui->dose_focus
+    );
+}
+
+/**
+ * @internal
+ * @brief Draws the table content of the database
+ *
+ * @note This is a callback to be used in the scrollpanel_draw
+ */
+static void draw_medication_table_content(Rectangle bounds, char *data) {
+    GuiLabel(bounds, data ? data : "No data");
+}
+
+static void handle_back_button(struct ui_medication *ui, enum app_state *state) {
+    ui->base.cleanup(&ui->base);
+
     *state = STATE_MAIN_MENU;
 }
+
+static void handle_submit_button(struct ui_medication *ui, enum error_code *error, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_MEDICATION_ID_EXISTS | FLAG_INVALID_MEDICATION_DATE | FLAG_MEDICATION_NAME_EMPTY);
+
+    char date_string[11];
+    if (!read_date_fields(ui, date_string)) {
+        SET_FLAG(&ui->flag, FLAG_INVALID_MEDICATION_DATE);
+        return;
+    }
+
+    // An existing ID updates (after confirmation), 0 inserts with a new ID
+    if (ui->ib_id.input != 0) {
+        if (!medication_db_check_id_exists(medication_db, ui->ib_id.input)) {
+            SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+            return;
+        }
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_EXISTS);
+        return;
+    }
+
+    if (ui->tb_name.input[0] == '\0') {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_NAME_EMPTY);
+        return;
+    }
+
+    int id = 0;
+    int rc = medication_db_insert(
+        medication_db,
+        ui->tb_name.input,
+        ui->tb_generic.input,
+        ui->tb_form.input,
+        ui->tb_strength.input,
+        ui->tb_unit.input,
+        ui->ib_stock.input,
+        date_string,
+        ui->tb_notes.input,
+        &id
+    );
+    if (rc == SQLITE_CONSTRAINT) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_DUPLICATE);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_INSERT_DB;
+        fprintf(stderr, "Error submitting to database.\n");
+        return;
+    }
+
+    printf("Medication inserted with ID: %d\n", id);
+    sync_stored_medication(ui, medication_db, id);
+
+    SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+    *error = NO_ERROR;
+}
+
+static void handle_retrieve_button(struct ui_medication *ui, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+
+    if (medication_db_get_by_id(medication_db, ui->ib_id.input, &ui->medication_retrieved) != SQLITE_OK) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+        return;
+    }
+
+    printf(
+        "Retrieved Medication - Name: %s, Stock: %d, Expiration Date: %s\n",
+        ui->medication_retrieved.name,
+        ui->medication_retrieved.stock,
+        ui->medication_retrieved.expiration_date
+    );
+
+    SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+}
+
+static void handle_delete_button(struct ui_medication *ui, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND | FLAG_CONFIRM_MEDICATION_DELETE);
+
+    if (!medication_db_check_id_exists(medication_db, ui->ib_id.input)) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+        return;
+    }
+
+    SET_FLAG(&ui->flag, FLAG_CONFIRM_MEDICATION_DELETE);
+}
+
+static void handle_retrieve_all_button(struct ui_medication *ui, database *medication_db) {
+    int total_medication = medication_db_get_count(medication_db);
+    if (total_medication == -1) {
+        fprintf(stderr, "Failed to get total count.\n");
+        return;
+    }
+
+    // 512 for header + 512 for each row as documented on medication_db_get_all_format
+    size_t buffer_size = 512 + 512 * (size_t)total_medication;
+
+    char *content = malloc(buffer_size);
+    if (!content) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    if (medication_db_get_all_format(medication_db, content, buffer_size) == -1) {
+        fprintf(stderr, "Failed to get formatted table.\n");
+        free(content);
+        return;
+    }
+
+    set_table_content(ui, content);
+}
+
+static void handle_dispense_button(struct ui_medication *ui, enum error_code *error, database *medication_db) {
+    CLEAR_FLAG(
+        &ui->flag,
+        FLAG_MEDICATION_ID_NOT_FOUND | FLAG_MEDICATION_RESIDENT_NOT_FOUND | FLAG_MEDICATION_NO_STOCK
+            | FLAG_MEDICATION_INVALID_DOSE
+    );
+
+    if (!check_resident(ui)) {
+        return;
+    }
+
+    if (ui->ib_dose_quantity.input <= 0) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_INVALID_DOSE);
+        return;
+    }
+
+    int rc = medication_db_dispense(
+        medication_db,
+        ui->ib_id.input,
+        ui->tbi_cpf.input,
+        ui->ib_dose_quantity.input,
+        (int64_t)time(NULL)
+    );
+    if (rc == SQLITE_NOTFOUND) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+        return;
+    }
+    if (rc == SQLITE_CONSTRAINT) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_NO_STOCK);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_UPDATE_DB;
+        return;
+    }
+
+    sync_stored_medication(ui, medication_db, ui->ib_id.input);
+    medication_db_get_by_id(medication_db, ui->ib_id.input, &ui->medication_retrieved);
+
+    SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+}
+
+static void handle_schedule_button(struct ui_medication *ui, enum error_code *error, database *medication_db) {
+    CLEAR_FLAG(
+        &ui->flag,
+        FLAG_MEDICATION_ID_NOT_FOUND | FLAG_MEDICATION_RESIDENT_NOT_FOUND | FLAG_MEDICATION_INVALID_DOSE
+    );
+
+    if (!check_resident(ui)) {
+        return;
+    }
+
+    if (ui->ib_dose_quantity.input <= 0) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_INVALID_DOSE);
+        return;
+    }
+
+    // The first dose is now, the next ones every interval
+    struct medication_schedule schedule = { 0 };
+    snprintf(schedule.cpf, sizeof(schedule.cpf), "%.11s", ui->tbi_cpf.input); // Checked to be 11 digits
+    schedule.medication_id = ui->ib_id.input;
+    schedule.quantity = ui->ib_dose_quantity.input;
+    schedule.first_minute = dose_schedule_now();
+    schedule.interval_minutes = ui->ib_interval_hours.input * 60;
+
+    int rc = medication_db_schedule_insert(medication_db, &schedule);
+    if (rc == SQLITE_NOTFOUND) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_INSERT_DB;
+        return;
+    }
+
+    if (ui->doses && !dose_schedule_add(ui->doses, &schedule)) {
+        fprintf(stderr, "Failed to add dose schedule %d to the reminders.\n", schedule.id);
+    }
+
+    SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+}
+
+// Appends the dispensing log entries to a buffer, see handle_history_button
+struct history_buffer {
+    char *buffer;
+    size_t size;
+    size_t written;
+};
+
+static int append_dispense_line(void *ctx, const struct medication_dispense *dispense) {
+    struct history_buffer *history = ctx;
+
+    char when[20];
+    time_t seconds = (time_t)dispense->dispensed_at;
+    struct tm *local = localtime(&seconds);
+    if (!local || strftime(when, sizeof(when), "%Y-%m-%d %H:%M", local) == 0) {
+        snprintf(when, sizeof(when), "?");
+    }
+
+    int len = snprintf(
+        history->buffer + history->written,
+        history->size - history->written,
+        "| %-16s | %7d | %-32.32s | %-8d |\n",
+        when,
+        dispense->medication_id,
+        dispense->medication_name[0] ? dispense->medication_name : "(deleted)",
+        dispense->quantity
+    );
+    if (len < 0 || (size_t)len >= history->size - history->written) {
+        return 1; // Full, stop
+    }
+    history->written += (size_t)len;
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Shows the last dispenses to the resident on the table view
+ */
+static void handle_history_button(struct ui_medication *ui, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_MEDICATION_RESIDENT_NOT_FOUND);
+
+    if (!check_resident(ui)) {
+        return;
+    }
+
+    // 512 for header + 128 for each row, rows are under 90 characters
+    struct history_buffer history = { 0 };
+    history.size = 512 + 128 * MEDICATION_HISTORY_MAX;
+    history.buffer = malloc(history.size);
+    if (!history.buffer) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    history.written = (size_t)snprintf(
+        history.buffer,
+        history.size,
+        "Dispensed to %s (last %d)\n"
+        "+--------------------------------------------------------------------------+\n"
+        "| When             | MedId   | Medication                       | Units    |\n"
+        "+------------------+---------+----------------------------------+----------+\n",
+        ui->tbi_cpf.input,
+        MEDICATION_HISTORY_MAX
+    );
+
+    if (medication_db_dispensed_to(
+            medication_db,
+            ui->tbi_cpf.input,
+            MEDICATION_HISTORY_MAX,
+            append_dispense_line,
+            &history
+        )
+        < 0)
+    {
+        fprintf(stderr, "Failed to read the dispensing log.\n");
+        free(history.buffer);
+        return;
+    }
+
+    set_table_content(ui, history.buffer);
+}
+
+/**
+ * @internal
+ * @brief Dispenses the selected dose due and acknowledges it
+ */
+static void handle_give_button(struct ui_medication *ui, enum error_code *error, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_NO_DOSE_SELECTED | FLAG_MEDICATION_NO_STOCK | FLAG_MEDICATION_ID_NOT_FOUND);
+
+    if (ui->dose_active < 0 || ui->dose_active >= ui->dose_count) {
+        SET_FLAG(&ui->flag, FLAG_NO_DOSE_SELECTED);
+        return;
+    }
+
+    const struct dose_reminder *dose = &ui->dose_due[ui->dose_active];
+    int rc = medication_db_dispense(medication_db, dose->medication_id, dose->cpf, dose->quantity, (int64_t)time(NULL));
+    if (rc == SQLITE_NOTFOUND) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_ID_NOT_FOUND);
+        return;
+    }
+    if (rc == SQLITE_CONSTRAINT) {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_NO_STOCK);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_UPDATE_DB;
+        return;
+    }
+
+    sync_stored_medication(ui, medication_db, dose->medication_id);
+    handle_skip_button(ui, medication_db); // Acknowledge it the same way
+}
+
+/**
+ * @internal
+ * @brief Acknowledges the selected dose due without dispensing it
+ */
+static void handle_skip_button(struct ui_medication *ui, database *medication_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_NO_DOSE_SELECTED);
+
+    if (ui->dose_active < 0 || ui->dose_active >= ui->dose_count) {
+        SET_FLAG(&ui->flag, FLAG_NO_DOSE_SELECTED);
+        return;
+    }
+
+    int schedule_id = ui->dose_due[ui->dose_active].schedule_id;
+    int64_t given_minute = dose_schedule_acknowledge(ui->doses, schedule_id);
+    if (given_minute >= 0 && medication_db_schedule_set_given(medication_db, schedule_id, given_minute) != SQLITE_OK) {
+        fprintf(stderr, "Failed to save the dose of schedule %d, it shows again on restart.\n", schedule_id);
+    }
+
+    ui->dose_active = -1;
+}
+
+static void process_db_action_in_warning(
+    struct ui_medication *ui,
+    enum error_code *error,
+    struct ui_medication_db_action_info *action,
+    database *medication_db
+) {
+    char date_string[11];
+
+    switch (action->type) {
+    case DB_ACTION_UPDATE:
+        // Already validated on submit
+        read_date_fields(ui, date_string);
+        if (medication_db_update(
+                medication_db,
+                action->update.id,
+                ui->tb_name.input,
+                ui->tb_generic.input,
+                ui->tb_form.input,
+                ui->tb_strength.input,
+                ui->tb_unit.input,
+                ui->ib_stock.input > 0 ? ui->ib_stock.input : -1, // Like the text fields, 0 keeps the stock
+                date_string,
+                ui->tb_notes.input
+            )
+            != SQLITE_OK)
+        {
+            *error = ERROR_UPDATE_DB;
+            break;
+        }
+        sync_stored_medication(ui, medication_db, action->update.id);
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_DELETE:
+        if (medication_db_delete_by_id(medication_db, action->delete.id) != SQLITE_OK) {
+            *error = ERROR_DELETE_DB;
+            break;
+        }
+        if (ui->alerts) {
+            expiration_alerts_remove(ui->alerts, EXPIRATION_MEDICATION, action->delete.id);
+        }
+        if (ui->doses) {
+            dose_schedule_remove_medication(ui->doses, action->delete.id);
+        }
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_NONE:
+    default:
+        break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Builds the date string from the date fields, empty if all of them are 0
+ *
+ * @return false if the date is set but not valid
+ */
+static bool read_date_fields(struct ui_medication *ui, char date_string[11]) {
+    date_string[0] = '\0';
+    if (ui->ib_year.input == 0 && ui->ib_month.input == 0 && ui->ib_day.input == 0) {
+        return true;
+    }
+
+    if (!validate_date(ui->ib_year.input, ui->ib_month.input, ui->ib_day.input)) {
+        printf(
+            "Date not valid, year: %d, month: %d, day: %d\n",
+            ui->ib_year.input,
+            ui->ib_month.input,
+            ui->ib_day.input
+        );
+        return false;
+    }
+
+    snprintf(date_string, 11, "%04d-%02d-%02d", ui->ib_year.input, ui->ib_month.input, ui->ib_day.input);
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Checks the CPF typed is valid and registered, sets the flag otherwise
+ */
+static bool check_resident(struct ui_medication *ui) {
+    if (!is_int_between_min_max(ui->tbi_cpf.input, 11, 11)
+        || (ui->resident_db && !resident_db_check_cpf_exists(ui->resident_db, ui->tbi_cpf.input)))
+    {
+        SET_FLAG(&ui->flag, FLAG_MEDICATION_RESIDENT_NOT_FOUND);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Replaces the table view content (takes ownership, NULL clears it) and sizes the view to it
+ */
+static void set_table_content(struct ui_medication *ui, char *content) {
+    free(ui->str_table_content);
+    ui->str_table_content = content;
+
+    // Set the panel_content_bounds rectangle based on the width and height of the text
+    if (content) {
+        Vector2 text_size = MeasureTextEx(GuiGetFont(), content, FONT_SIZE, 0);
+        ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
+        ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
+    }
+}
+
+/**
+ * @internal
+ * @brief Updates the medication in the expiration alerts after its stock or date changed
+ */
+static void sync_stored_medication(struct ui_medication *ui, database *medication_db, int id) {
+    if (!ui->alerts) {
+        return;
+    }
+
+    struct medication stored;
+    if (medication_db_get_by_id(medication_db, id, &stored) != SQLITE_OK) {
+        return;
+    }
+
+    if (!expiration_alerts_sync_medication(ui->alerts, &stored)) {
+        fprintf(stderr, "Failed to update expiration alerts for medication %d.\n", id);
+    }
+}
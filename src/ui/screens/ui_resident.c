@@ -10,6 +10,7 @@
 
 #include <external/raylib/raygui.h>
 
+#include "db/db_changes.h"
 #include "db/resident_db.h"
 #include "global/globals.h"
 #include "utils/utilsfn.h"
@@ -47,6 +48,7 @@ static void ui_resident_cleanup(struct ui_base *base);
 // Type of the operation
 enum ui_resident_db_action_type {
     DB_ACTION_NONE,
+    DB_ACTION_INSERT,
     DB_ACTION_UPDATE,
     DB_ACTION_DELETE,
 };
@@ -92,6 +94,22 @@ static void handle_delete_button(struct ui_resident *ui, database *resident_db);
 
 static void handle_retrieve_all_button(struct ui_resident *ui, database *resident_db);
 
+static void load_resident_table(struct ui_resident *ui, database *resident_db);
+
+static void fit_table_content(struct ui_resident *ui);
+
+static void on_resident_change(const struct db_change *change, void *ctx);
+
+static void apply_resident_changes(struct ui_resident *ui, database *resident_db);
+
+static bool find_possible_duplicates(struct ui_resident *ui, database *resident_db);
+
+static void insert_resident(struct ui_resident *ui, enum error_code *error, database *resident_db);
+
+static void update_resident_search(struct ui_resident *ui, database *resident_db);
+
+static void draw_resident_search_results(struct ui_resident *ui);
+
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
 void ui_resident_init(struct ui_resident *ui) {
@@ -169,6 +187,30 @@ void ui_resident_init(struct ui_resident *ui) {
 
     ui->str_table_content = NULL;
 
+    ui->tb_search = textbox_init(
+        (Rectangle) { ui->panel_bounds.x, ui->panel_bounds.y + ui->panel_bounds.height + 40, 300, 30 },
+        "Search (name, health, needs):"
+    );
+    ui->search_results_bounds = (Rectangle) { ui->tb_search.bounds.x,
+                                              ui->tb_search.bounds.y + ui->tb_search.bounds.height + 10,
+                                              ui->tb_search.bounds.width,
+                                              window_height - (ui->tb_search.bounds.y + ui->tb_search.bounds.height + 90) };
+    ui->search_submitted[0] = '\0';
+    ui->search = NULL;
+    ui->search_failed = false;
+    ui->search_result_count = 0;
+    ui->search_generation = 0;
+    ui->search_scroll_index = 0;
+    ui->search_active = -1;
+
+    ui->dedupe = NULL;
+    ui->duplicate_count = 0;
+    ui->duplicate_msg[0] = '\0';
+
+    ui->changed_count = 0;
+    ui->changed_all = false;
+    ui->changes_subscription = db_changes_subscribe("Resident", on_resident_change, ui);
+
     ui->flag = 0;
 }
 
@@ -216,12 +258,20 @@ static void ui_resident_render(
 
     // End draw UI elements
 
+    // Residents committed since the last frame, by this screen or anything else
+    apply_resident_changes(ui, resident_db);
+
     // Draw info panel
     draw_resident_info_panel(ui);
 
     // Draw database content
     scrollpanel_draw(&ui->sp_table_view, draw_resident_table_content, ui->str_table_content);
 
+    // Search box, queries run on the search worker so typing never blocks the frame
+    textbox_draw(&ui->tb_search);
+    update_resident_search(ui, resident_db);
+    draw_resident_search_results(ui);
+
     // Handle button actions
     ui->base.handle_buttons(&ui->base, state, error, resident_db);
 
@@ -319,11 +369,15 @@ static void ui_resident_handle_warning_msg(
         message = "CPF must not be empty.";
         flag_to_clear = FLAG_INPUT_CPF_EMPTY;
     } else if (IS_FLAG_SET(&ui->flag, FLAG_CPF_NOT_VALID)) {
-        message = "CPF must be 11 digits.";
+        message = "CPF is not valid.";
         flag_to_clear = FLAG_CPF_NOT_VALID;
     } else if (IS_FLAG_SET(&ui->flag, FLAG_CPF_NOT_FOUND)) {
         message = "CPF not found.";
         flag_to_clear = FLAG_CPF_NOT_FOUND;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_POSSIBLE_DUPLICATE)) {
+        message = ui->duplicate_msg;
+        flag_to_clear = FLAG_POSSIBLE_DUPLICATE;
+        action.type = DB_ACTION_INSERT;
     } else if (IS_FLAG_SET(&ui->flag, FLAG_CPF_EXISTS)) {
         message = "CPF already exists. Update?";
         flag_to_clear = FLAG_CPF_EXISTS;
@@ -347,8 +401,10 @@ static void ui_resident_handle_warning_msg(
 
     if (message) {
         const char *buttons = (action.type != DB_ACTION_NONE) ? "Yes;No" : "OK";
+        // The duplicate warning lists one candidate per line
+        float box_height = (action.type == DB_ACTION_INSERT) ? 150 + 20 * ui->duplicate_count : 150;
         int result = GuiMessageBox(
-            (Rectangle) { window_width / 2 - 150, window_height / 2 - 50, 300, 150 },
+            (Rectangle) { window_width / 2 - 150, window_height / 2 - 50, 300, box_height },
             "#191#Warning!",
             message,
             buttons
@@ -390,6 +446,8 @@ static void ui_resident_update_positions(struct ui_base *base) {
     ui->sp_table_view.panel_bounds.width =
         window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20);
     ui->sp_table_view.panel_bounds.height = window_height - 100;
+    ui->search_results_bounds.height =
+        window_height - (ui->tb_search.bounds.y + ui->tb_search.bounds.height + 90);
 }
 
 /**
@@ -431,6 +489,26 @@ static void ui_resident_cleanup(struct ui_base *base) {
         free(ui->str_table_content);
         ui->str_table_content = NULL; // Prevent double-free
     }
+
+    db_changes_unsubscribe(ui->changes_subscription);
+    ui->changes_subscription = 0;
+
+    if (ui->search) {
+        resident_search_stop(ui->search);
+        ui->search = NULL; // Restarted on the next render
+    }
+    ui->search_failed = false;
+    ui->tb_search.input[0] = '\0';
+    ui->search_submitted[0] = '\0';
+    ui->search_result_count = 0;
+    ui->search_generation = 0;
+    ui->search_active = -1;
+
+    if (ui->dedupe) {
+        resident_dedupe_free(ui->dedupe);
+        ui->dedupe = NULL; // Reloaded on the next submit
+    }
+    ui->duplicate_count = 0;
 }
 /** @} */
 
@@ -456,6 +534,10 @@ static void process_db_action_in_warning(
     database *resident_db
 ) {
     switch (action->type) {
+    case DB_ACTION_INSERT:
+        insert_resident(ui, error, resident_db);
+        break;
+
     case DB_ACTION_UPDATE:
         if (resident_db_update(
                 resident_db,
@@ -472,6 +554,11 @@ static void process_db_action_in_warning(
             *error = ERROR_UPDATE_DB;
             break;
         }
+        // Keep the duplicate index in step with a rename
+        if (ui->dedupe && action->update.name[0] != '\0') {
+            resident_dedupe_remove(ui->dedupe, action->update.cpf);
+            resident_dedupe_add(ui->dedupe, action->update.cpf, action->update.name);
+        }
         SET_FLAG(&ui->flag, FLAG_RESIDENT_OPERATION_DONE);
         break;
 
@@ -480,6 +567,7 @@ static void process_db_action_in_warning(
             *error = ERROR_DELETE_DB;
             break;
         }
+        resident_dedupe_remove(ui->dedupe, action->delete.cpf);
         SET_FLAG(&ui->flag, FLAG_RESIDENT_OPERATION_DONE);
         break;
 
@@ -628,7 +716,7 @@ static void handle_submit_button(struct ui_resident *ui, enum error_code *error,
         return;
     }
 
-    if (!is_int_between_min_max(ui->tbi_cpf.input, 11, 11)) {
+    if (!resident_db_cpf_valid(ui->tbi_cpf.input)) {
         SET_FLAG(&ui->flag, FLAG_CPF_NOT_VALID);
         return;
     }
@@ -639,7 +727,88 @@ static void handle_submit_button(struct ui_resident *ui, enum error_code *error,
         return;
     }
 
-    // Insert new resident
+    // Same person registered under another spelling? Ask before creating a second record
+    if (find_possible_duplicates(ui, resident_db)) {
+        SET_FLAG(&ui->flag, FLAG_POSSIBLE_DUPLICATE);
+        return;
+    }
+
+    insert_resident(ui, error, resident_db);
+}
+
+/**
+ * @internal
+ * @brief Looks up residents with a name similar to the one typed, filling the confirmation message
+ *
+ * The trigram index is loaded on first use and then kept up to date by this screen. A database
+ * served by another process has no index here, its server looks up the same phonetic key instead.
+ *
+ * @param ui Pointer to ui_resident struct with the name input
+ * @param resident_db Pointer to the resident database
+ * @return true if at least one possible duplicate was found
+ *
+ */
+static bool find_possible_duplicates(struct ui_resident *ui, database *resident_db) {
+    ui->duplicate_count = 0;
+
+    if (db_is_remote(resident_db)) {
+        int found = resident_db_find_duplicates(
+            resident_db,
+            ui->tb_name.input,
+            NULL,
+            RESIDENT_DEDUPE_THRESHOLD,
+            ui->duplicates,
+            RESIDENT_DEDUPE_MAX_CANDIDATES
+        );
+        ui->duplicate_count = found > 0 ? found : 0;
+    } else {
+        if (!ui->dedupe) {
+            ui->dedupe = resident_dedupe_load(resident_db);
+            if (!ui->dedupe) {
+                return false; // Not fatal, the resident can still be registered
+            }
+        }
+
+        ui->duplicate_count = resident_dedupe_find(
+            ui->dedupe,
+            ui->tb_name.input,
+            NULL,
+            RESIDENT_DEDUPE_THRESHOLD,
+            ui->duplicates,
+            RESIDENT_DEDUPE_MAX_CANDIDATES
+        );
+    }
+    if (ui->duplicate_count == 0) {
+        return false;
+    }
+
+    int written = snprintf(ui->duplicate_msg, sizeof(ui->duplicate_msg), "Possible duplicate of:\n");
+    for (int i = 0; i < ui->duplicate_count && written < (int)sizeof(ui->duplicate_msg); i++) {
+        written += snprintf(
+            ui->duplicate_msg + written,
+            sizeof(ui->duplicate_msg) - written,
+            "%.24s (%s)\n",
+            ui->duplicates[i].name,
+            ui->duplicates[i].cpf
+        );
+    }
+    if (written < (int)sizeof(ui->duplicate_msg)) {
+        snprintf(ui->duplicate_msg + written, sizeof(ui->duplicate_msg) - written, "Insert anyway?");
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Inserts the resident in the form fields and adds it to the duplicate index
+ *
+ * @param ui Pointer to ui_resident struct with the form inputs
+ * @param error Pointer to the error code
+ * @param resident_db Pointer to the resident database
+ *
+ */
+static void insert_resident(struct ui_resident *ui, enum error_code *error, database *resident_db) {
     if (resident_db_insert(
             resident_db,
             ui->tbi_cpf.input,
@@ -656,6 +825,10 @@ static void handle_submit_button(struct ui_resident *ui, enum error_code *error,
         return;
     }
 
+    if (ui->dedupe) {
+        resident_dedupe_add(ui->dedupe, ui->tbi_cpf.input, ui->tb_name.input);
+    }
+
     SET_FLAG(&ui->flag, FLAG_RESIDENT_OPERATION_DONE);
     *error = NO_ERROR;
 }
@@ -713,6 +886,20 @@ static void handle_delete_button(struct ui_resident *ui, database *resident_db)
  *
  */
 static void handle_retrieve_all_button(struct ui_resident *ui, database *resident_db) {
+    load_resident_table(ui, resident_db);
+
+    resident_db_get_all(resident_db); // also prints to stdout
+}
+
+/**
+ * @internal
+ * @brief Formats every resident into str_table_content and sizes the database view to it
+ *
+ * @param ui Pointer to ui_resident struct
+ * @param resident_db Pointer to the resident database
+ *
+ */
+static void load_resident_table(struct ui_resident *ui, database *resident_db) {
     if (ui->str_table_content) {
         free(ui->str_table_content); // Free old data before getting new data
         ui->str_table_content = NULL;
@@ -738,13 +925,171 @@ static void handle_retrieve_all_button(struct ui_resident *ui, database *residen
         return;
     }
 
+    fit_table_content(ui);
+}
+
+/**
+ * @internal
+ * @brief Sizes the database view content to the text in str_table_content
+ */
+static void fit_table_content(struct ui_resident *ui) {
     // Set the panel_content_bounds rectangle based on the width and height of the retrieved text
     if (ui->str_table_content) {
         Vector2 text_size = MeasureTextEx(GuiGetFont(), ui->str_table_content, FONT_SIZE, 0);
         ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
         ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
     }
+}
 
-    resident_db_get_all(resident_db); // also prints to stdout
-    return;
+/**
+ * @internal
+ * @brief Notes a committed Resident change, applied by the next render (db_changes_dispatch() callback)
+ */
+static void on_resident_change(const struct db_change *change, void *ctx) {
+    struct ui_resident *ui = ctx;
+    if (ui->changed_all) {
+        return;
+    }
+    if (change->op == DB_CHANGE_RESET) {
+        ui->changed_all = true;
+        return;
+    }
+
+    // Changes pile up while another screen is shown
+    for (int i = 0; i < ui->changed_count; i++) {
+        if (ui->changed_cpfs[i] == change->rowid) {
+            return;
+        }
+    }
+    if (ui->changed_count == UI_RESIDENT_CHANGED_ROWS) {
+        ui->changed_all = true;
+        return;
+    }
+    ui->changed_cpfs[ui->changed_count++] = change->rowid;
+}
+
+/**
+ * @internal
+ * @brief Brings the retrieved resident and the database view up to date with the noted changes
+ *
+ * Only the rows of the changed residents are formatted again and patched into the view, the
+ * whole table is reloaded after a reset or when a patch fails.
+ *
+ * @param ui Pointer to ui_resident struct
+ * @param resident_db Pointer to the resident database
+ *
+ */
+static void apply_resident_changes(struct ui_resident *ui, database *resident_db) {
+    if (ui->changed_count == 0 && !ui->changed_all) {
+        return;
+    }
+
+    bool reload = ui->changed_all;
+    bool refetch = ui->changed_all && ui->resident_retrieved.cpf[0] != '\0';
+    for (int i = 0; i < ui->changed_count && !reload; i++) {
+        char cpf[MAX_CPF_LENGTH];
+        resident_db_cpf_unpack(ui->changed_cpfs[i], cpf);
+        if (strcmp(cpf, ui->resident_retrieved.cpf) == 0) {
+            refetch = true;
+        }
+        if (!ui->str_table_content) {
+            continue;
+        }
+
+        char block[2048];
+        int len = resident_db_get_format_by_cpf(resident_db, cpf, block, sizeof(block));
+        if (len < 0 || table_text_patch(&ui->str_table_content, cpf, len > 0 ? block : NULL) != 0) {
+            reload = true;
+        }
+    }
+
+    if (refetch) {
+        char cpf[MAX_CPF_LENGTH];
+        strcpy(cpf, ui->resident_retrieved.cpf);
+        if (resident_db_get_by_cpf(resident_db, cpf, &ui->resident_retrieved) != SQLITE_OK) {
+            memset(&ui->resident_retrieved, 0, sizeof(struct resident)); // Deleted
+        }
+    }
+
+    if (ui->str_table_content) {
+        if (reload) {
+            load_resident_table(ui, resident_db);
+        } else {
+            fit_table_content(ui);
+        }
+    }
+
+    ui->changed_count = 0;
+    ui->changed_all = false;
+}
+
+/**
+ * @internal
+ * @brief Feeds the search worker and picks up its results, called once per frame
+ *
+ * The worker is started on first use because the database is only known at render time. A
+ * worker that failed to start is not tried again every frame, only once the screen is left.
+ * Only a changed query is submitted, and polling is a counter compare when nothing is new.
+ *
+ * @param ui Pointer to ui_resident struct
+ * @param resident_db Pointer to the resident database
+ *
+ */
+static void update_resident_search(struct ui_resident *ui, database *resident_db) {
+    if (!ui->search) {
+        if (ui->tb_search.input[0] == '\0' || ui->search_failed) {
+            return; // Don't spawn a thread until someone actually searches
+        }
+        ui->search = resident_search_start(resident_db);
+        if (!ui->search) {
+            ui->search_failed = true;
+            return;
+        }
+    }
+
+    if (strcmp(ui->tb_search.input, ui->search_submitted) != 0) {
+        resident_search_submit(ui->search, ui->tb_search.input);
+        strcpy(ui->search_submitted, ui->tb_search.input);
+    }
+
+    if (resident_search_poll(ui->search, ui->search_results, &ui->search_result_count, &ui->search_generation)) {
+        for (int i = 0; i < ui->search_result_count; i++) {
+            snprintf(
+                ui->search_labels[i],
+                sizeof(ui->search_labels[i]),
+                "%.40s (%s)",
+                ui->search_results[i].name,
+                ui->search_results[i].cpf
+            );
+            ui->search_label_ptrs[i] = ui->search_labels[i];
+        }
+        ui->search_scroll_index = 0;
+        ui->search_active = -1;
+    }
+}
+
+/**
+ * @internal
+ * @brief Draws the search results list, selecting a result shows it in the info panel
+ *
+ */
+static void draw_resident_search_results(struct ui_resident *ui) {
+    int previous_active = ui->search_active;
+    int focus = -1;
+
+    GuiListViewEx(
+        ui->search_results_bounds,
+        ui->search_label_ptrs,
+        ui->search_result_count,
+        &ui->search_scroll_index,
+        &ui->search_active,
+        &focus
+    );
+
+    if (ui->search_active != previous_active && ui->search_active >= 0
+        && ui->search_active < ui->search_result_count)
+    {
+        ui->resident_retrieved = ui->search_results[ui->search_active];
+        strcpy(ui->tbi_cpf.input, ui->resident_retrieved.cpf);
+    }
 }
@@ -28,6 +28,8 @@
 #include "styles/sunny.h"           // raygui style: sunny
 #include "styles/terminal.h"        // raygui style: terminal
 
+#include <time.h>
+
 #include "db/user_db.h"
 #include "global/globals.h"
 #include "utils/utilsfn.h"
@@ -58,6 +60,8 @@ static void detect_styler_changes(struct ui_settings *ui);
 
 static void draw_current_user_info_panel(struct ui_settings *ui);
 
+static void draw_backup_panel(struct ui_settings *ui);
+
 static void handle_back_button(enum app_state *state);
 
 static void handle_submit_button(struct ui_settings *ui, enum error_code *error, database *user_db);
@@ -66,7 +70,7 @@ static void handle_reset_password_button(struct ui_settings *ui, enum error_code
 
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
-void ui_settings_init(struct ui_settings *ui, struct user *current_user) {
+void ui_settings_init(struct ui_settings *ui, struct user *current_user, struct db_backup *backup) {
     // Initialize base
     ui_base_init_defaults(&ui->base, "ui_settings.c");
 
@@ -80,6 +84,7 @@ void ui_settings_init(struct ui_settings *ui, struct user *current_user) {
     // UI user specific fields
 
     ui->current_user = current_user;
+    ui->backup = backup;
 
     ui->butn_back = button_init((Rectangle) { 20, 20, 0, 30 }, "Back");
 
@@ -118,6 +123,15 @@ void ui_settings_init(struct ui_settings *ui, struct user *current_user) {
     ui->panel_bounds =
         (Rectangle) { ui->tb_new_username.bounds.x + ui->tb_new_username.bounds.width + 10, 10, 300, 250 };
 
+    ui->backup_panel_bounds = (Rectangle) {
+        ui->panel_bounds.x, ui->panel_bounds.y + ui->panel_bounds.height + 10, ui->panel_bounds.width, 160
+    };
+
+    ui->butn_backup = button_init(
+        (Rectangle) { ui->backup_panel_bounds.x + 10, ui->backup_panel_bounds.y + 120, 120, 30 },
+        "Back Up Now"
+    );
+
     ui->flag = 0;
 
     // Set a default theme in init
@@ -165,6 +179,7 @@ static void ui_settings_render(struct ui_base *base, enum app_state *state, enum
 
     // Panel info
     draw_current_user_info_panel(ui);
+    draw_backup_panel(ui);
 
     // Handle button actions
     ui->base.handle_buttons(&ui->base, state, error, user_db);
@@ -215,6 +230,19 @@ static void ui_settings_handle_buttons(
         return;
     }
 
+    // One backup at a time
+    if (!ui->backup || db_backup_running(ui->backup)) {
+        GuiDisable();
+        button_draw_updt(&ui->butn_backup);
+        GuiEnable();
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_backup)) {
+        db_backup_start(ui->backup);
+        return;
+    }
+
     return;
 }
 
@@ -430,6 +458,51 @@ static void draw_current_user_info_panel(struct ui_settings *ui) {
     );
 }
 
+/**
+ * @internal
+ * @brief Draws the backup panel: what the backup thread does, how far it is, the last backup
+ *
+ */
+static void draw_backup_panel(struct ui_settings *ui) {
+    GuiPanel(ui->backup_panel_bounds, "Backups:");
+
+    Rectangle line = { ui->backup_panel_bounds.x + 10, ui->backup_panel_bounds.y + 30, 280, 20 };
+
+    if (!ui->backup) {
+        GuiLabel(line, "Backups unavailable.");
+        return;
+    }
+
+    struct db_backup_status status;
+    db_backup_get_status(ui->backup, &status);
+
+    switch (status.state) {
+    case DB_BACKUP_COPYING:
+        GuiLabel(line, TextFormat("Copying %s (%d/%d)", status.name, status.database + 1, status.databases));
+        break;
+    case DB_BACKUP_COMPRESSING:
+        GuiLabel(line, TextFormat("Compressing %s (%d/%d)", status.name, status.database + 1, status.databases));
+        break;
+    case DB_BACKUP_FAILED:
+        GuiLabel(line, TextFormat("Failed: %s", status.message));
+        break;
+    default:
+        GuiLabel(line, "Idle");
+        break;
+    }
+
+    line.y += 30;
+    Rectangle bar = { line.x, line.y, line.width - 40, line.height };
+    GuiProgressBar(bar, NULL, TextFormat("%d%%", (int)(status.progress * 100.0f)), &status.progress, 0.0f, 1.0f);
+
+    char when[32] = "Never";
+    if (status.last_success > 0) {
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&status.last_success));
+    }
+    line.y += 30;
+    GuiLabel(line, TextFormat("Last backup: %s", when));
+}
+
 static void handle_back_button(enum app_state *state) {
     *state = STATE_MAIN_MENU;
     return;
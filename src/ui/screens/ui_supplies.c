@@ -4,6 +4,11 @@
  */
 #include "ui/screens/ui_supplies.h"
 
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <external/raylib/raygui.h>
 
 #include "db/supplies_db.h"
@@ -21,7 +26,73 @@ static void ui_supplies_handle_buttons(
     database *supplies_db
 );
 
-static void handle_back_button(enum app_state *state);
+static void ui_supplies_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *supplies_db
+);
+
+static void ui_supplies_update_positions(struct ui_base *base);
+
+static void ui_supplies_clear_fields(struct ui_base *base);
+
+static void ui_supplies_cleanup(struct ui_base *base);
+
+// Tagged union for when a warning message needs to perform a database operation
+// Type of the operation
+enum ui_supplies_db_action_type {
+    DB_ACTION_NONE,
+    DB_ACTION_UPDATE,
+    DB_ACTION_DELETE,
+};
+
+// Info for the database operation based on the type
+struct ui_supplies_db_action_info {
+    enum ui_supplies_db_action_type type;
+    union {
+        struct {
+            int id;
+        } update;
+
+        struct {
+            int id;
+        } delete;
+    };
+};
+
+static void process_db_action_in_warning(
+    struct ui_supplies *ui,
+    enum error_code *error,
+    struct ui_supplies_db_action_info *action,
+    database *supplies_db
+);
+
+static void draw_supplies_info_panel(struct ui_supplies *ui);
+
+static void draw_shipment(struct ui_supplies *ui);
+
+static void draw_category_totals(struct ui_supplies *ui, database *supplies_db);
+
+static void draw_supplies_table_content(Rectangle bounds, char *data);
+
+static void handle_back_button(struct ui_supplies *ui, enum app_state *state);
+
+static void handle_submit_button(struct ui_supplies *ui, enum error_code *error, database *supplies_db);
+
+static void handle_retrieve_button(struct ui_supplies *ui, database *supplies_db);
+
+static void handle_delete_button(struct ui_supplies *ui, database *supplies_db);
+
+static void handle_retrieve_all_button(struct ui_supplies *ui, database *supplies_db);
+
+static void handle_add_line_button(struct ui_supplies *ui, database *supplies_db);
+
+static void handle_clear_shipment_button(struct ui_supplies *ui);
+
+static void handle_receive_button(struct ui_supplies *ui, enum error_code *error, database *supplies_db);
+
+static void set_table_content(struct ui_supplies *ui, char *content);
 
 /* ======================= PUBLIC FUNCTIONS ======================= */
 
@@ -31,11 +102,139 @@ void ui_supplies_init(struct ui_supplies *ui) {
     // Override methods
     ui->base.render = ui_supplies_render;
     ui->base.handle_buttons = ui_supplies_handle_buttons;
+    ui->base.handle_warning_msg = ui_supplies_handle_warning_msg;
+    ui->base.update_positions = ui_supplies_update_positions;
+    ui->base.clear_fields = ui_supplies_clear_fields;
+    ui->base.cleanup = ui_supplies_cleanup;
 
     // Initialize ui specific fields
 
     ui->butn_back = button_init((Rectangle) { 20, 20, 0, 30 }, "Back");
 
+    ui->ib_id = intbox_init(
+        (Rectangle) { 20, ui->butn_back.bounds.y + (ui->butn_back.bounds.height * 2), 130, 30 },
+        "ID (0 for new):",
+        0,
+        99999999
+    );
+
+    ui->tb_name =
+        textbox_init((Rectangle) { 20, ui->ib_id.bounds.y + (ui->ib_id.bounds.height * 2), 300, 30 }, "Name:");
+
+    ui->tb_category = textbox_init(
+        (Rectangle) { 20, ui->tb_name.bounds.y + (ui->tb_name.bounds.height * 2), 300, 30 },
+        "Category:"
+    );
+
+    ui->tb_size = textbox_init(
+        (Rectangle) { 20, ui->tb_category.bounds.y + (ui->tb_category.bounds.height * 2), 145, 30 },
+        "Size:"
+    );
+
+    ui->tb_unit = textbox_init(
+        (Rectangle) { ui->tb_size.bounds.x + ui->tb_size.bounds.width + 10, ui->tb_size.bounds.y, 145, 30 },
+        "Unit:"
+    );
+
+    ui->ib_quantity = intbox_init(
+        (Rectangle) { 20, ui->tb_size.bounds.y + (ui->tb_size.bounds.height * 2), 145, 30 },
+        "Quantity:",
+        0,
+        INT_MAX
+    );
+
+    ui->tb_notes = textbox_init(
+        (Rectangle) { 20, ui->ib_quantity.bounds.y + (ui->ib_quantity.bounds.height * 2), 300, 30 },
+        "Notes:"
+    );
+
+    ui->butn_submit = button_init((Rectangle) { 20, window_height - 60, 100, 30 }, "Submit");
+    ui->butn_retrieve = button_init(
+        (Rectangle) { ui->butn_submit.bounds.x + ui->butn_submit.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Retrieve"
+    );
+    ui->butn_delete = button_init(
+        (Rectangle
+        ) { ui->butn_retrieve.bounds.x + ui->butn_retrieve.bounds.width + 10, ui->butn_submit.bounds.y, 100, 30 },
+        "Delete"
+    );
+    ui->butn_retrieve_all = button_init(
+        (Rectangle) { ui->butn_delete.bounds.x + ui->butn_delete.bounds.width + 10, ui->butn_submit.bounds.y, 0, 30 },
+        "Retrieve All"
+    );
+
+    memset(&ui->supplies_retrieved, 0, sizeof(struct supplies));
+
+    // Only set the bounds of the panel, draw everything inside based on it on the draw info panel function
+    ui->panel_bounds = (Rectangle) { ui->tb_name.bounds.x + ui->tb_name.bounds.width + 10, 10, 300, 220 };
+
+    // Shipment below the info panel: the next line, the lines added so far and receive
+    ui->ib_line_id = intbox_init(
+        (Rectangle) { ui->panel_bounds.x, ui->panel_bounds.y + ui->panel_bounds.height + 35, 100, 30 },
+        "Item ID:",
+        0,
+        99999999
+    );
+
+    ui->ib_line_quantity = intbox_init(
+        (Rectangle) { ui->ib_line_id.bounds.x + ui->ib_line_id.bounds.width + 10, ui->ib_line_id.bounds.y, 100, 30 },
+        "Units:",
+        0,
+        INT_MAX
+    );
+
+    ui->butn_add_line = button_init(
+        (Rectangle) { ui->ib_line_quantity.bounds.x + ui->ib_line_quantity.bounds.width + 10,
+                      ui->ib_line_id.bounds.y,
+                      80,
+                      30 },
+        "Add Line"
+    );
+
+    ui->shipment_bounds = (Rectangle) { ui->panel_bounds.x,
+                                        ui->ib_line_id.bounds.y + ui->ib_line_id.bounds.height + 35,
+                                        ui->panel_bounds.width,
+                                        150 };
+
+    ui->butn_receive = button_init(
+        (Rectangle) { ui->panel_bounds.x, ui->shipment_bounds.y + ui->shipment_bounds.height + 10, 0, 30 },
+        "Receive Shipment"
+    );
+    ui->butn_clear_shipment = button_init(
+        (Rectangle) { ui->butn_receive.bounds.x + ui->butn_receive.bounds.width + 10, ui->butn_receive.bounds.y, 0, 30 },
+        "Clear Shipment"
+    );
+
+    // Category totals fill the rest of the column
+    ui->totals_bounds = (Rectangle) { ui->panel_bounds.x,
+                                      ui->butn_receive.bounds.y + ui->butn_receive.bounds.height + 35,
+                                      ui->panel_bounds.width,
+                                      0 };
+    ui->totals_bounds.height = window_height - 60 - ui->totals_bounds.y;
+
+    ui->shipment_count = 0;
+    ui->shipment_scroll = 0;
+    ui->shipment_active = -1;
+    ui->shipment_focus = -1;
+    ui->received_lines = 0;
+    ui->received_units = 0;
+
+    ui->total_count = 0;
+    ui->total_scroll = 0;
+    ui->total_active = -1;
+    ui->totals_stale = true;
+
+    ui->sp_table_view = scrollpanel_init(
+        (Rectangle) { ui->panel_bounds.x + ui->panel_bounds.width + 10,
+                      10,
+                      window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20),
+                      window_height - 100 },
+        "Database view",
+        (Rectangle) { 0, 0, 0, 0 }
+    );
+
+    ui->str_table_content = NULL;
+
     ui->flag = 0;
 }
 
@@ -49,7 +248,7 @@ void ui_supplies_init(struct ui_supplies *ui) {
 
 /**
  * @brief Supplies screen rendering and interaction handling.
- * 
+ *
  * @implements ui_base.render
  *
  * Handles rendering and interaction for all menu elements.
@@ -57,8 +256,8 @@ void ui_supplies_init(struct ui_supplies *ui) {
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any other ui*)
  * @param state Pointer to application state
  * @param error Pointer to error code
- * @param supplies_db Pointer to the supplies database 
- * 
+ * @param supplies_db Pointer to the supplies database
+ *
  * @warning Should be called through the base interface
  */
 static void ui_supplies_render(
@@ -69,19 +268,53 @@ static void ui_supplies_render(
 ) {
     struct ui_supplies *ui = (struct ui_supplies *)base;
 
+    // Start draw UI elements
+
+    intbox_draw(&ui->ib_id);
+    textbox_draw(&ui->tb_name);
+    textbox_draw(&ui->tb_category);
+    textbox_draw(&ui->tb_size);
+    textbox_draw(&ui->tb_unit);
+    intbox_draw(&ui->ib_quantity);
+    textbox_draw(&ui->tb_notes);
+
+    // Start Info Panel
+    draw_supplies_info_panel(ui);
+
+    intbox_draw(&ui->ib_line_id);
+    intbox_draw(&ui->ib_line_quantity);
+    draw_shipment(ui);
+
+    draw_category_totals(ui, supplies_db);
+
+    // Draw database content
+    scrollpanel_draw(&ui->sp_table_view, draw_supplies_table_content, ui->str_table_content);
+
+    // End draw UI elements
+
+    // Start button actions
     ui->base.handle_buttons(&ui->base, state, error, supplies_db);
+
+    // Start show warning/error boxes
+    ui->base.handle_warning_msg(&ui->base, state, error, supplies_db);
+
+    // Clear the text buffer only after a successful operation
+    if (IS_FLAG_SET(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE)) {
+        ui->base.clear_fields(&ui->base);
+        CLEAR_FLAG(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE);
+    }
 }
 
 /**
  * @brief Handle button drawing and logic.
- * 
+ *
  * @implements ui_base.handle_buttons
  *
  * @param base Pointer to base UI (implements interface) structure (can be safely cast to any ui*)
  * @param state Pointer to application state
  * @param error Pointer to error tracking variable
  * @param supplies_db Pointer to supplies database connection
- * 
+ *
  * @warning Should be called through the base interface
  */
 static void ui_supplies_handle_buttons(
@@ -90,20 +323,545 @@ static void ui_supplies_handle_buttons(
     enum error_code *error,
     database *supplies_db
 ) {
-    (void)error;
-    (void)supplies_db;
-
     struct ui_supplies *ui = (struct ui_supplies *)base;
 
     if (button_draw_updt(&ui->butn_back)) {
-        handle_back_button(state);
+        handle_back_button(ui, state);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_submit)) {
+        handle_submit_button(ui, error, supplies_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve)) {
+        handle_retrieve_button(ui, supplies_db);
         return;
     }
+
+    if (button_draw_updt(&ui->butn_delete)) {
+        handle_delete_button(ui, supplies_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_retrieve_all)) {
+        handle_retrieve_all_button(ui, supplies_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_add_line)) {
+        handle_add_line_button(ui, supplies_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_receive)) {
+        handle_receive_button(ui, error, supplies_db);
+        return;
+    }
+
+    if (button_draw_updt(&ui->butn_clear_shipment)) {
+        handle_clear_shipment_button(ui);
+        return;
+    }
+}
+
+/**
+ * @brief Manages supplies warning/confirmation dialogs
+ *
+ * @implements ui_base.handle_warning_msg
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_supplies*)
+ * @param state Pointer to application state
+ * @param error Pointer to error tracking variable
+ * @param supplies_db Pointer to supplies database connection
+ *
+ * @warning May trigger database operations on confirmation
+ */
+static void ui_supplies_handle_warning_msg(
+    struct ui_base *base,
+    enum app_state *state,
+    enum error_code *error,
+    database *supplies_db
+) {
+    (void)state;
+
+    struct ui_supplies *ui = (struct ui_supplies *)base;
+
+    const char *message = NULL;
+    enum supplies_screen_flags flag_to_clear = 0;
+    struct ui_supplies_db_action_info action = { 0 };
+    action.type = DB_ACTION_NONE;
+
+    // Warnings
+    if (IS_FLAG_SET(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND)) {
+        message = "Supplies ID not found.";
+        flag_to_clear = FLAG_SUPPLIES_ID_NOT_FOUND;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SUPPLIES_NAME_EMPTY)) {
+        message = "Name cannot be empty.";
+        flag_to_clear = FLAG_SUPPLIES_NAME_EMPTY;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SUPPLIES_DUPLICATE)) {
+        message = "Supplies with this name, category\nand size already exist.";
+        flag_to_clear = FLAG_SUPPLIES_DUPLICATE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SHIPMENT_INVALID_LINE)) {
+        message = "Item ID not found or units not set.";
+        flag_to_clear = FLAG_SHIPMENT_INVALID_LINE;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SHIPMENT_FULL)) {
+        message = TextFormat("A shipment has at most %d lines.\nReceive this one first.", SUPPLIES_SHIPMENT_MAX);
+        flag_to_clear = FLAG_SHIPMENT_FULL;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SHIPMENT_EMPTY)) {
+        message = "Add lines to the shipment first.";
+        flag_to_clear = FLAG_SHIPMENT_EMPTY;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SHIPMENT_RECEIVED)) {
+        message = TextFormat("Shipment received:\n%d lines, %lld units.", ui->received_lines, ui->received_units);
+        flag_to_clear = FLAG_SHIPMENT_RECEIVED;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_SUPPLIES_ID_EXISTS)) {
+        message = "Supplies ID already exists. Update?";
+        flag_to_clear = FLAG_SUPPLIES_ID_EXISTS;
+        action.type = DB_ACTION_UPDATE;
+        action.update.id = ui->ib_id.input;
+    } else if (IS_FLAG_SET(&ui->flag, FLAG_CONFIRM_SUPPLIES_DELETE)) {
+        message = "Are you sure you want to delete\nthese supplies?";
+        flag_to_clear = FLAG_CONFIRM_SUPPLIES_DELETE;
+        action.type = DB_ACTION_DELETE;
+        action.delete.id = ui->ib_id.input;
+    } else if (*error == ERROR_INSERT_DB || *error == ERROR_UPDATE_DB || *error == ERROR_DELETE_DB) {
+        message = "Database error. Try again.";
+        *error = NO_ERROR;
+    }
+
+    if (message) {
+        const char *buttons = (action.type != DB_ACTION_NONE) ? "Yes;No" : "OK";
+
+        int result = GuiMessageBox(
+            (Rectangle) { window_width / 2 - 150, window_height / 2 - 50, 300, 150 },
+            "#191#Warning!",
+            message,
+            buttons
+        );
+
+        if (result == 1 && action.type != DB_ACTION_NONE) {
+            process_db_action_in_warning(ui, error, &action, supplies_db);
+        }
+
+        if (result >= 0 && flag_to_clear) {
+            CLEAR_FLAG(&ui->flag, flag_to_clear);
+        }
+    }
+}
+
+/**
+ * @brief Updates supplies UI element positions for window resizing
+ *
+ * @implements ui_base.update_positions
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_supplies*)
+ *
+ * @note If any ui element is initialized with window_width or window_height
+ *       in their bounds, they must be updated here
+ *
+ * @warning Should be called on window resize events
+ */
+static void ui_supplies_update_positions(struct ui_base *base) {
+    struct ui_supplies *ui = (struct ui_supplies *)base;
+
+    ui->butn_submit.bounds.y = window_height - 60;
+    ui->butn_retrieve.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_delete.bounds.y = ui->butn_submit.bounds.y;
+    ui->butn_retrieve_all.bounds.y = ui->butn_submit.bounds.y;
+    ui->totals_bounds.height = window_height - 60 - ui->totals_bounds.y;
+    ui->sp_table_view.panel_bounds.width = window_width - (ui->panel_bounds.x + ui->panel_bounds.width + 20);
+    ui->sp_table_view.panel_bounds.height = window_height - 100;
+}
+
+/**
+ * @brief Clears all supplies input fields
+ *
+ * @implements ui_base.clear_fields
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_supplies*)
+ *
+ * @post All inputs are reset to defaults, the shipment lines are kept
+ */
+static void ui_supplies_clear_fields(struct ui_base *base) {
+    struct ui_supplies *ui = (struct ui_supplies *)base;
+
+    ui->ib_id.input = 0;
+    ui->tb_name.input[0] = '\0';
+    ui->tb_category.input[0] = '\0';
+    ui->tb_size.input[0] = '\0';
+    ui->tb_unit.input[0] = '\0';
+    ui->ib_quantity.input = 0;
+    ui->tb_notes.input[0] = '\0';
+    ui->ib_line_id.input = 0;
+    ui->ib_line_quantity.input = 0;
+}
+
+/**
+ * @brief Cleans up supplies screen resources
+ *
+ * @implements ui_base.cleanup
+ *
+ * @param base Pointer to base UI structure (can be safely cast to ui_supplies*)
+ *
+ * @warning Frees any allocated buffers/memory
+ */
+static void ui_supplies_cleanup(struct ui_base *base) {
+    struct ui_supplies *ui = (struct ui_supplies *)base;
+
+    set_table_content(ui, NULL);
 }
 /** @} */
 
 /* ======================= INTERNAL HELPERS ======================= */
 
-static void handle_back_button(enum app_state *state) {
+static void draw_supplies_info_panel(struct ui_supplies *ui) {
+    const struct supplies *supplies = &ui->supplies_retrieved;
+
+    GuiPanel(ui->panel_bounds, TextFormat("Supplies ID retrieved: %d", supplies->id));
+
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 30, 280, 20 },
+        TextFormat("Name: %s", supplies->name)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 60, 280, 20 },
+        TextFormat("Category: %s", supplies->category)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 90, 280, 20 },
+        TextFormat("Size: %s", supplies->size)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 120, 280, 20 },
+        TextFormat("Quantity: %d %s", supplies->quantity, supplies->unit)
+    );
+    GuiLabel(
+        (Rectangle) { ui->panel_bounds.x + 10, ui->panel_bounds.y + 150, 280, 20 },
+        TextFormat("Notes: %s", supplies->notes)
+    );
+}
+
+static void draw_shipment(struct ui_supplies *ui) {
+    GuiLabel(
+        (Rectangle) { ui->shipment_bounds.x, ui->shipment_bounds.y - 25, ui->shipment_bounds.width, 20 },
+        TextFormat("Shipment: %d lines", ui->shipment_count)
+    );
+    GuiListViewEx(
+        ui->shipment_bounds,
+        ui->shipment_line_ptrs,
+        ui->shipment_count,
+        &ui->shipment_scroll,
+        &ui->shipment_active,
+        &ui->shipment_focus
+    );
+}
+
+static int append_category_total(void *ctx, const struct supplies_category_total *total) {
+    struct ui_supplies *ui = ctx;
+
+    snprintf(
+        ui->total_lines[ui->total_count],
+        sizeof(ui->total_lines[ui->total_count]),
+        "%.24s: %lld units, %d items",
+        total->category[0] ? total->category : "(none)",
+        (long long)total->quantity,
+        total->items
+    );
+    ui->total_line_ptrs[ui->total_count] = ui->total_lines[ui->total_count];
+    ui->total_count++;
+    return ui->total_count == SUPPLIES_CATEGORY_LIST_MAX; // Full, stop
+}
+
+/**
+ * @internal
+ * @brief Draws the category totals, read again from the summary table only after a change
+ */
+static void draw_category_totals(struct ui_supplies *ui, database *supplies_db) {
+    if (ui->totals_stale) {
+        ui->total_count = 0;
+        if (supplies_db_category_totals(supplies_db, append_category_total, ui) < 0) {
+            fprintf(stderr, "Failed to read the category totals.\n");
+        }
+        ui->totals_stale = false;
+    }
+
+    GuiLabel(
+        (Rectangle) { ui->totals_bounds.x, ui->totals_bounds.y - 25, ui->totals_bounds.width, 20 },
+        "Stock per category:"
+    );
+    GuiListViewEx(ui->totals_bounds, ui->total_line_ptrs, ui->total_count, &ui->total_scroll, &ui->total_active, NULL);
+}
+
+/**
+ * @internal
+ * @brief Draws the table content of the database
+ *
+ * @note This is a callback to be used in the scrollpanel_draw
+ */
+static void draw_supplies_table_content(Rectangle bounds, char *data) {
+    GuiLabel(bounds, data ? data : "No data");
+}
+
+static void handle_back_button(struct ui_supplies *ui, enum app_state *state) {
+    ui->base.cleanup(&ui->base);
+
     *state = STATE_MAIN_MENU;
 }
+
+static void handle_submit_button(struct ui_supplies *ui, enum error_code *error, database *supplies_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_SUPPLIES_ID_EXISTS | FLAG_SUPPLIES_NAME_EMPTY);
+
+    // An existing ID updates (after confirmation), 0 inserts with a new ID
+    if (ui->ib_id.input != 0) {
+        if (!supplies_db_check_id_exists(supplies_db, ui->ib_id.input)) {
+            SET_FLAG(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND);
+            return;
+        }
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_ID_EXISTS);
+        return;
+    }
+
+    if (ui->tb_name.input[0] == '\0') {
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_NAME_EMPTY);
+        return;
+    }
+
+    int id = 0;
+    int rc = supplies_db_insert(
+        supplies_db,
+        ui->tb_name.input,
+        ui->tb_category.input,
+        ui->tb_size.input,
+        ui->tb_unit.input,
+        ui->ib_quantity.input,
+        ui->tb_notes.input,
+        &id
+    );
+    if (rc == SQLITE_CONSTRAINT) {
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_DUPLICATE);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_INSERT_DB;
+        fprintf(stderr, "Error submitting to database.\n");
+        return;
+    }
+
+    printf("Supplies inserted with ID: %d\n", id);
+    ui->totals_stale = true;
+
+    SET_FLAG(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE);
+    *error = NO_ERROR;
+}
+
+static void handle_retrieve_button(struct ui_supplies *ui, database *supplies_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND);
+
+    if (supplies_db_get_by_id(supplies_db, ui->ib_id.input, &ui->supplies_retrieved) != SQLITE_OK) {
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND);
+        return;
+    }
+
+    printf(
+        "Retrieved Supplies - Name: %s, Category: %s, Quantity: %d\n",
+        ui->supplies_retrieved.name,
+        ui->supplies_retrieved.category,
+        ui->supplies_retrieved.quantity
+    );
+
+    SET_FLAG(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE);
+}
+
+static void handle_delete_button(struct ui_supplies *ui, database *supplies_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND | FLAG_CONFIRM_SUPPLIES_DELETE);
+
+    if (!supplies_db_check_id_exists(supplies_db, ui->ib_id.input)) {
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_ID_NOT_FOUND);
+        return;
+    }
+
+    SET_FLAG(&ui->flag, FLAG_CONFIRM_SUPPLIES_DELETE);
+}
+
+static void handle_retrieve_all_button(struct ui_supplies *ui, database *supplies_db) {
+    int total_supplies = supplies_db_get_count(supplies_db);
+    if (total_supplies == -1) {
+        fprintf(stderr, "Failed to get total count.\n");
+        return;
+    }
+
+    // 512 for header + 512 for each row as documented on supplies_db_get_all_format
+    size_t buffer_size = 512 + 512 * (size_t)total_supplies;
+
+    char *content = malloc(buffer_size);
+    if (!content) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return;
+    }
+
+    if (supplies_db_get_all_format(supplies_db, content, buffer_size) == -1) {
+        fprintf(stderr, "Failed to get formatted table.\n");
+        free(content);
+        return;
+    }
+
+    set_table_content(ui, content);
+}
+
+/**
+ * @internal
+ * @brief Adds the units typed to the shipment, on the line of the item if it already has one
+ */
+static void handle_add_line_button(struct ui_supplies *ui, database *supplies_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_SHIPMENT_INVALID_LINE | FLAG_SHIPMENT_FULL);
+
+    int id = ui->ib_line_id.input;
+    int quantity = ui->ib_line_quantity.input;
+
+    struct supplies supplies;
+    if (quantity <= 0 || supplies_db_get_by_id(supplies_db, id, &supplies) != SQLITE_OK) {
+        SET_FLAG(&ui->flag, FLAG_SHIPMENT_INVALID_LINE);
+        return;
+    }
+
+    int line = 0;
+    while (line < ui->shipment_count && ui->shipment[line].id != id) {
+        line++;
+    }
+
+    if (line == ui->shipment_count) {
+        if (ui->shipment_count == SUPPLIES_SHIPMENT_MAX) {
+            SET_FLAG(&ui->flag, FLAG_SHIPMENT_FULL);
+            return;
+        }
+        ui->shipment[line].id = id;
+        ui->shipment[line].quantity = 0;
+        ui->shipment_count++;
+    }
+
+    if (ui->shipment[line].quantity > INT_MAX - quantity) {
+        SET_FLAG(&ui->flag, FLAG_SHIPMENT_INVALID_LINE);
+        return;
+    }
+    ui->shipment[line].quantity += quantity;
+
+    snprintf(
+        ui->shipment_lines[line],
+        sizeof(ui->shipment_lines[line]),
+        "#%d %.24s: +%d %.12s",
+        id,
+        supplies.name,
+        ui->shipment[line].quantity,
+        supplies.unit
+    );
+    ui->shipment_line_ptrs[line] = ui->shipment_lines[line];
+
+    ui->ib_line_id.input = 0;
+    ui->ib_line_quantity.input = 0;
+}
+
+static void handle_clear_shipment_button(struct ui_supplies *ui) {
+    ui->shipment_count = 0;
+    ui->shipment_scroll = 0;
+    ui->shipment_active = -1;
+}
+
+/**
+ * @internal
+ * @brief Receives every line of the shipment in one transaction, the lines stay if it fails
+ */
+static void handle_receive_button(struct ui_supplies *ui, enum error_code *error, database *supplies_db) {
+    CLEAR_FLAG(&ui->flag, FLAG_SHIPMENT_EMPTY | FLAG_SHIPMENT_INVALID_LINE);
+
+    if (ui->shipment_count == 0) {
+        SET_FLAG(&ui->flag, FLAG_SHIPMENT_EMPTY);
+        return;
+    }
+
+    int failed_line = -1;
+    int rc = supplies_db_receive_shipment(supplies_db, ui->shipment, ui->shipment_count, &failed_line);
+    if (rc == SQLITE_NOTFOUND || rc == SQLITE_MISUSE) {
+        // Deleted after it was added to the shipment, select it so it can be seen
+        ui->shipment_active = failed_line;
+        SET_FLAG(&ui->flag, FLAG_SHIPMENT_INVALID_LINE);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        *error = ERROR_UPDATE_DB;
+        return;
+    }
+
+    ui->received_lines = ui->shipment_count;
+    ui->received_units = 0;
+    for (int i = 0; i < ui->shipment_count; i++) {
+        ui->received_units += ui->shipment[i].quantity;
+    }
+
+    handle_clear_shipment_button(ui);
+    ui->totals_stale = true;
+    SET_FLAG(&ui->flag, FLAG_SHIPMENT_RECEIVED);
+}
+
+static void process_db_action_in_warning(
+    struct ui_supplies *ui,
+    enum error_code *error,
+    struct ui_supplies_db_action_info *action,
+    database *supplies_db
+) {
+    int rc;
+
+    switch (action->type) {
+    case DB_ACTION_UPDATE:
+        rc = supplies_db_update(
+            supplies_db,
+            action->update.id,
+            ui->tb_name.input,
+            ui->tb_category.input,
+            ui->tb_size.input,
+            ui->tb_unit.input,
+            ui->ib_quantity.input > 0 ? ui->ib_quantity.input : -1, // Like the text fields, 0 keeps the quantity
+            ui->tb_notes.input
+        );
+        if (rc == SQLITE_CONSTRAINT) {
+            SET_FLAG(&ui->flag, FLAG_SUPPLIES_DUPLICATE);
+            break;
+        }
+        if (rc != SQLITE_OK) {
+            *error = ERROR_UPDATE_DB;
+            break;
+        }
+        ui->totals_stale = true;
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_DELETE:
+        if (supplies_db_delete_by_id(supplies_db, action->delete.id) != SQLITE_OK) {
+            *error = ERROR_DELETE_DB;
+            break;
+        }
+        ui->totals_stale = true;
+        SET_FLAG(&ui->flag, FLAG_SUPPLIES_OPERATION_DONE);
+        break;
+
+    case DB_ACTION_NONE:
+    default:
+        break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Replaces the table view content (takes ownership, NULL clears it) and sizes the view to it
+ */
+static void set_table_content(struct ui_supplies *ui, char *content) {
+    free(ui->str_table_content);
+    ui->str_table_content = content;
+
+    // Set the panel_content_bounds rectangle based on the width and height of the text
+    if (content) {
+        Vector2 text_size = MeasureTextEx(GuiGetFont(), content, FONT_SIZE, 0);
+        ui->sp_table_view.panel_content_bounds.width = text_size.x * 0.9;
+        ui->sp_table_view.panel_content_bounds.height = text_size.y / 0.7;
+    }
+}
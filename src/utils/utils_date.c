@@ -0,0 +1,144 @@
+/**
+ * @file utils_date.c
+ * @brief Calendar date utilities implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For localtime_r
+
+#include "utils/utils_date.h"
+
+#include <stdio.h>
+#include <time.h>
+
+bool validate_date(int year, int month, int day) {
+    if (year < 1) {
+        return false;
+    }
+
+    // Check month
+    switch (month) {
+    // Jan, Mar, May, Jul, Aug, Oct, Dec:
+    case 1:
+    case 3:
+    case 5:
+    case 7:
+    case 8:
+    case 10:
+    case 12:
+        if (day < 1 || day > 31) {
+            return false;
+        }
+        break;
+    // Apr, Jun, Sept, Nov:
+    case 4:
+    case 6:
+    case 9:
+    case 11:
+        if (day < 1 || day > 30) {
+            return false;
+        }
+        break;
+    //Feb:
+    case 2:
+        if ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0)) {
+            if (day < 1 || day > 29) {
+                return false; // Leap year
+            }
+        } else {
+            if (day < 1 || day > 28) {
+                return false; // Non-leap year
+            }
+        }
+        break;
+    // Will never happen in this app
+    default:
+        return false; // Invalid month
+    }
+
+    return true;
+}
+
+int32_t date_to_days(int year, int month, int day) {
+    if (!validate_date(year, month, day)) {
+        return DATE_INVALID;
+    }
+
+    // Days from civil (proleptic Gregorian), years start in March so the leap day is the last one
+    int y = (month <= 2) ? year - 1 : year;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int year_of_era = y - era * 400;
+    int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+    return era * 146097 + day_of_era - 719468;
+}
+
+void date_from_days(int32_t days, int *year, int *month, int *day) {
+    int32_t z = days + 719468;
+    int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int32_t day_of_era = z - era * 146097;
+    int32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int32_t month_index = (5 * day_of_year + 2) / 153;
+
+    *day = day_of_year - (153 * month_index + 2) / 5 + 1;
+    *month = month_index < 10 ? month_index + 3 : month_index - 9;
+    *year = year_of_era + era * 400 + (*month <= 2);
+}
+
+int32_t date_parse(const char *text) {
+    if (!text) {
+        return DATE_INVALID;
+    }
+
+    int parts[3] = { 0 };
+    const int widths[3] = { 4, 2, 2 };
+    const char *p = text;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < widths[i]; j++, p++) {
+            if (*p < '0' || *p > '9') {
+                return DATE_INVALID;
+            }
+            parts[i] = parts[i] * 10 + (*p - '0');
+        }
+        if (i < 2 && *p++ != '-') {
+            return DATE_INVALID;
+        }
+    }
+
+    if (*p != '\0') {
+        return DATE_INVALID;
+    }
+
+    return date_to_days(parts[0], parts[1], parts[2]);
+}
+
+void date_format(int32_t days, char out[DATE_STR_LEN]) {
+    if (days == DATE_INVALID) {
+        out[0] = '\0';
+        return;
+    }
+
+    int year;
+    int month;
+    int day;
+    date_from_days(days, &year, &month, &day);
+    char date_string[32]; // Increased buffer to supress warning
+    snprintf(date_string, sizeof(date_string), "%04d-%02d-%02d", year, month, day);
+    snprintf(out, DATE_STR_LEN, "%.10s", date_string);
+}
+
+int32_t date_today(void) {
+    time_t now;
+    time(&now);
+
+    struct tm curr_time = { 0 };
+
+#ifdef _WIN32
+    localtime_s(&curr_time, &now);
+#else
+    localtime_r(&now, &curr_time);
+#endif
+
+    return date_to_days(curr_time.tm_year + 1900, curr_time.tm_mon + 1, curr_time.tm_mday);
+}
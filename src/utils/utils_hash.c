@@ -11,19 +11,47 @@
     #include <windows.h>
 #endif
 
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <external/openssl/rand.h>
 #include <external/openssl/sha.h>
 
+#include "utils/utils_perf.h"
+
+static atomic_int kdf_iterations = PASSWORD_KDF_DEFAULT_ITERATIONS;
+
+// Not optimized away like a memset of a buffer about to go out of scope
+static void secure_zero(void *buffer, size_t len) {
+    volatile unsigned char *p = buffer;
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+static void to_hex(const unsigned char *digest, char *hash_out) {
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        sprintf(hash_out + (i * 2), "%02x", digest[i]);
+    }
+    hash_out[SHA256_DIGEST_LENGTH * 2] = '\0';
+}
+
 void generate_salt(char *salt, size_t len) {
+    static const char alphabet[] = "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
     if (RAND_bytes((unsigned char *)salt, len) != 1) {
         // Fallback to less secure method if RAND_bytes fails
         for (size_t i = 0; i < len; i++) {
             salt[i] = (char)(rand() % 256);
         }
     }
+    // 256 is a multiple of 64, every character stays equally likely
+    for (size_t i = 0; i < len; i++) {
+        salt[i] = alphabet[(unsigned char)salt[i] & 63];
+    }
     salt[len] = '\0';
 }
 
@@ -38,8 +66,168 @@ void hash_password(const char *password, const char *salt, char *hash_out) {
     SHA256((unsigned char *)salted_password, strlen(salted_password), hash);
 
     // Convert binary hash to hex string
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(hash_out + (i * 2), "%02x", hash[i]);
+    to_hex(hash, hash_out);
+}
+
+/* ======================= KDF ======================= */
+
+/**
+ * @internal
+ * @brief HMAC-SHA256 with the key already absorbed
+ *
+ * PBKDF2 runs HMAC thousands of times with the same key (the password), so the hashes of the
+ * padded key are computed once and copied for each run: two SHA-256 blocks per HMAC instead of four.
+ */
+struct hmac_sha256 {
+    SHA256_CTX inner; ///< After key ^ ipad
+    SHA256_CTX outer; ///< After key ^ opad
+};
+
+static void hmac_sha256_init(struct hmac_sha256 *hmac, const unsigned char *key, size_t key_len) {
+    unsigned char block[SHA256_CBLOCK] = { 0 };
+    if (key_len > sizeof(block)) {
+        SHA256(key, key_len, block);
+    } else {
+        memcpy(block, key, key_len);
     }
-    hash_out[SHA256_DIGEST_LENGTH * 2] = '\0';
+
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] ^= 0x36;
+    }
+    SHA256_Init(&hmac->inner);
+    SHA256_Update(&hmac->inner, block, sizeof(block));
+
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] ^= 0x36 ^ 0x5c;
+    }
+    SHA256_Init(&hmac->outer);
+    SHA256_Update(&hmac->outer, block, sizeof(block));
+
+    secure_zero(block, sizeof(block));
+}
+
+// Outer hash of an inner context that has absorbed the message
+static void hmac_sha256_finish(const struct hmac_sha256 *hmac, SHA256_CTX *inner, unsigned char *out) {
+    SHA256_Final(out, inner);
+    SHA256_CTX outer = hmac->outer;
+    SHA256_Update(&outer, out, SHA256_DIGEST_LENGTH);
+    SHA256_Final(out, &outer);
+}
+
+// First (and only) 32-byte block of PBKDF2-HMAC-SHA256
+static void pbkdf2_sha256(const char *password, const char *salt, int iterations, unsigned char *out) {
+    struct hmac_sha256 hmac;
+    hmac_sha256_init(&hmac, (const unsigned char *)password, strlen(password));
+
+    // U1 = HMAC(password, salt || INT_32_BE(1))
+    static const unsigned char block_index[4] = { 0, 0, 0, 1 };
+    unsigned char u[SHA256_DIGEST_LENGTH];
+    SHA256_CTX inner = hmac.inner;
+    SHA256_Update(&inner, salt, strlen(salt));
+    SHA256_Update(&inner, block_index, sizeof(block_index));
+    hmac_sha256_finish(&hmac, &inner, u);
+    memcpy(out, u, sizeof(u));
+
+    // Ui = HMAC(password, Ui-1), the key is the xor of all of them
+    for (int i = 1; i < iterations; i++) {
+        inner = hmac.inner;
+        SHA256_Update(&inner, u, sizeof(u));
+        hmac_sha256_finish(&hmac, &inner, u);
+        for (size_t j = 0; j < sizeof(u); j++) {
+            out[j] ^= u[j];
+        }
+    }
+
+    secure_zero(&hmac, sizeof(hmac));
+    secure_zero(&inner, sizeof(inner));
+    secure_zero(u, sizeof(u));
+}
+
+bool hash_password_kdf(const char *password, const char *salt, struct password_kdf_params params, char *hash_out) {
+    switch (params.kdf) {
+    case PASSWORD_KDF_SHA256:
+        hash_password(password, salt, hash_out);
+        return true;
+
+    case PASSWORD_KDF_PBKDF2_SHA256: {
+        if (params.iterations <= 0) {
+            return false;
+        }
+        unsigned char key[SHA256_DIGEST_LENGTH];
+        pbkdf2_sha256(password, salt, params.iterations, key);
+        to_hex(key, hash_out);
+        secure_zero(key, sizeof(key));
+        return true;
+    }
+
+    case PASSWORD_KDF_COUNT:
+    default:
+        return false;
+    }
+}
+
+bool verify_password(
+    const char *password,
+    const char *salt,
+    struct password_kdf_params params,
+    const char *expected_hash
+) {
+    char computed[SHA256_DIGEST_LENGTH * 2 + 1];
+    if (strlen(expected_hash) != SHA256_DIGEST_LENGTH * 2 || !hash_password_kdf(password, salt, params, computed)) {
+        return false;
+    }
+
+    // Every character is compared, the time does not tell how much of the hash matched
+    unsigned char diff = 0;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH * 2; i++) {
+        diff |= (unsigned char)(computed[i] ^ expected_hash[i]);
+    }
+    secure_zero(computed, sizeof(computed));
+    return diff == 0;
+}
+
+struct password_kdf_params password_kdf_current(void) {
+    return (struct password_kdf_params) {
+        .kdf = PASSWORD_KDF_PBKDF2_SHA256,
+        .iterations = atomic_load(&kdf_iterations),
+    };
+}
+
+void password_kdf_set_iterations(int iterations) {
+    if (iterations < PASSWORD_KDF_MIN_ITERATIONS) {
+        iterations = PASSWORD_KDF_MIN_ITERATIONS;
+    } else if (iterations > PASSWORD_KDF_MAX_ITERATIONS) {
+        iterations = PASSWORD_KDF_MAX_ITERATIONS;
+    }
+    atomic_store(&kdf_iterations, iterations);
+}
+
+bool password_kdf_needs_upgrade(struct password_kdf_params stored) {
+    struct password_kdf_params current = password_kdf_current();
+    return stored.kdf != current.kdf
+        || (int64_t)stored.iterations * 100 < (int64_t)current.iterations * PASSWORD_KDF_UPGRADE_PERCENT;
+}
+
+int password_kdf_calibrate(double target_ms) {
+    // Short runs are dominated by timer noise, grow the count until a run is long enough
+    uint64_t min_ns = (uint64_t)(target_ms * 1e6 / 8);
+    int iterations = 1000;
+    uint64_t elapsed = 0;
+    for (;;) {
+        unsigned char key[SHA256_DIGEST_LENGTH];
+        uint64_t start = perf_now_ns();
+        pbkdf2_sha256("calibration", "calibration salt", iterations, key);
+        elapsed = perf_now_ns() - start;
+        if (elapsed >= min_ns || iterations >= PASSWORD_KDF_MAX_ITERATIONS) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double scaled = (double)iterations * target_ms * 1e6 / (double)(elapsed > 0 ? elapsed : 1);
+    int step = 1;
+    while (step <= PASSWORD_KDF_MAX_ITERATIONS / 2 && step * 2 <= scaled) {
+        step *= 2;
+    }
+    return step < PASSWORD_KDF_MIN_ITERATIONS ? PASSWORD_KDF_MIN_ITERATIONS : step;
 }
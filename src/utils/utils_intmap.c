@@ -0,0 +1,138 @@
+/**
+ * @file utils_intmap.c
+ * @brief Integer hash map implementation
+ */
+#include "utils/utils_intmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INTMAP_MIN_CAPACITY 16
+
+static size_t intmap_hash(int64_t key, size_t mask) {
+    // 64-bit mix (splitmix64 finalizer), consecutive ids end up far apart
+    uint64_t x = (uint64_t)key;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return (size_t)x & mask;
+}
+
+/**
+ * @internal
+ * @brief Bucket holding key, or the empty bucket where it would go
+ */
+static size_t intmap_find(const struct intmap *map, int64_t key) {
+    size_t mask = map->capacity - 1;
+    size_t pos = intmap_hash(key, mask);
+
+    while (map->values[pos] >= 0 && map->keys[pos] != key) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+static bool intmap_resize(struct intmap *map, size_t capacity) {
+    int64_t *keys = malloc(sizeof(int64_t) * capacity);
+    int *values = malloc(sizeof(int) * capacity);
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return false;
+    }
+    memset(values, -1, sizeof(int) * capacity);
+
+    struct intmap old = *map;
+    map->keys = keys;
+    map->values = values;
+    map->capacity = capacity;
+
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.values[i] >= 0) {
+            size_t pos = intmap_find(map, old.keys[i]);
+            map->keys[pos] = old.keys[i];
+            map->values[pos] = old.values[i];
+        }
+    }
+
+    free(old.keys);
+    free(old.values);
+    return true;
+}
+
+bool intmap_init(struct intmap *map, size_t expected) {
+    memset(map, 0, sizeof(*map));
+    if (expected == 0) {
+        return true;
+    }
+
+    // Kept at most half full
+    size_t capacity = INTMAP_MIN_CAPACITY;
+    while (capacity < expected * 2) {
+        capacity *= 2;
+    }
+    return intmap_resize(map, capacity);
+}
+
+void intmap_free(struct intmap *map) {
+    free(map->keys);
+    free(map->values);
+    memset(map, 0, sizeof(*map));
+}
+
+bool intmap_put(struct intmap *map, int64_t key, int value) {
+    if (value < 0) {
+        return false;
+    }
+
+    if ((map->count + 1) * 2 > map->capacity) {
+        if (!intmap_resize(map, map->capacity ? map->capacity * 2 : INTMAP_MIN_CAPACITY)) {
+            return false;
+        }
+    }
+
+    size_t pos = intmap_find(map, key);
+    if (map->values[pos] < 0) {
+        map->keys[pos] = key;
+        map->count++;
+    }
+    map->values[pos] = value;
+    return true;
+}
+
+int intmap_get(const struct intmap *map, int64_t key) {
+    if (map->count == 0) {
+        return -1;
+    }
+    return map->values[intmap_find(map, key)];
+}
+
+int intmap_remove(struct intmap *map, int64_t key) {
+    if (map->count == 0) {
+        return -1;
+    }
+
+    size_t mask = map->capacity - 1;
+    size_t hole = intmap_find(map, key);
+    int value = map->values[hole];
+    if (value < 0) {
+        return -1;
+    }
+
+    // Shift back the following entries of the probe run that may move into the hole
+    size_t next = (hole + 1) & mask;
+    while (map->values[next] >= 0) {
+        size_t home = intmap_hash(map->keys[next], mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            map->keys[hole] = map->keys[next];
+            map->values[hole] = map->values[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    map->values[hole] = -1;
+    map->count--;
+    return value;
+}
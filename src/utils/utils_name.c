@@ -0,0 +1,376 @@
+/**
+ * @file utils_name.c
+ * @brief Person name matching utilities implementation
+ */
+#include "utils/utils_name.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Names are at most MAX_INPUT bytes, normalizing never makes them longer
+#define NAME_NORMALIZED_LEN 512
+
+// Base letter of U+00C0..U+00FF (second byte of a 0xC3 UTF-8 sequence minus 0x80), ' ' for symbols
+static const char latin1_fold[64] = "aaaaaaaceeeeiiiidnooooo ouuuuy s"
+                                    "aaaaaaaceeeeiiiidnooooo ouuuuy y";
+
+// Words ignored for keys and trigrams, they are often omitted or swapped when a name is typed
+static const char *const name_particles[] = { "da", "de", "do", "das", "dos", "e", "di", "du", NULL };
+
+/**
+ * @internal
+ * @brief Whether a word of a normalized name counts for matching (not a particle, initial or number)
+ */
+static bool name_is_significant_word(const char *word, size_t len) {
+    if (len < 2) {
+        return false;
+    }
+
+    for (int i = 0; name_particles[i]; i++) {
+        if (strlen(name_particles[i]) == len && strncmp(name_particles[i], word, len) == 0) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (word[i] >= 'a' && word[i] <= 'z') {
+            return true;
+        }
+    }
+    return false; // Only digits
+}
+
+static bool is_vowel(char c) {
+    return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u' || c == 'y';
+}
+
+static bool is_front_vowel(char c) {
+    return c == 'e' || c == 'i' || c == 'y';
+}
+
+/**
+ * @internal
+ * @brief Encodes one normalized word with Portuguese spelling rules
+ *
+ * @return Number of characters written to out (never more than out_size - 1, always null-terminated)
+ */
+static size_t name_encode_word(const char *w, size_t len, char *out, size_t out_size) {
+    size_t n = 0;
+    char last = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = w[i];
+        char next = (i + 1 < len) ? w[i + 1] : '\0';
+        char prev = (i > 0) ? w[i - 1] : '\0';
+        char code = 0;
+
+        switch (c) {
+        case 'a':
+        case 'e':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'y':
+            // Only the leading vowel is kept, inner vowels are the least reliable part of a spelling
+            if (i == 0) {
+                code = (c == 'y') ? 'I' : (char)(c - 'a' + 'A');
+            }
+            last = 0; // A vowel separates repeated consonant sounds ("Nana" keeps both n)
+            break;
+        case 'b':
+            code = 'B';
+            break;
+        case 'd':
+            code = 'D';
+            break;
+        case 'f':
+            code = 'F';
+            break;
+        case 'j':
+            code = 'J';
+            break;
+        case 'k':
+            code = 'K';
+            break;
+        case 't':
+            code = 'T';
+            break;
+        case 'v':
+        case 'w':
+            code = 'V';
+            break;
+        case 'x':
+            code = 'X';
+            break;
+        case 'r':
+            code = 'R';
+            break;
+        case 'p':
+            code = (next == 'h') ? 'F' : 'P';
+            break;
+        case 'c':
+            if (next == 'h') {
+                code = 'X';
+            } else if (is_front_vowel(next)) {
+                code = 'S';
+            } else {
+                code = 'K';
+            }
+            break;
+        case 'q':
+            code = 'K';
+            if (next == 'u') {
+                i++; // "qu" is a single k sound
+            }
+            break;
+        case 'g':
+            if (is_front_vowel(next)) {
+                code = 'J';
+            } else {
+                code = 'G';
+                if (next == 'u' && i + 2 < len && is_front_vowel(w[i + 2])) {
+                    i++; // "gue", "gui": the u is silent
+                }
+            }
+            break;
+        case 'h':
+            break; // Silent on its own, digraphs are handled by the letter before it
+        case 'l':
+            code = 'L'; // "lh" falls through the silent h
+            break;
+        case 'n':
+            code = 'N'; // "nh" falls through the silent h
+            break;
+        case 'm':
+            // Nasal m before a consonant or at the end of a word sounds like n ("Adam", "Adan")
+            code = (next == '\0' || !is_vowel(next)) ? 'N' : 'M';
+            break;
+        case 's':
+            if (next == 'h') {
+                code = 'X';
+            } else if (next == 'c' && i + 2 < len && is_front_vowel(w[i + 2])) {
+                code = 'S';
+                i++; // "sce", "sci" sound like a single s
+            } else if (is_vowel(prev) && is_vowel(next)) {
+                code = 'Z';
+            } else {
+                code = 'S';
+            }
+            break;
+        case 'z':
+            code = (next == '\0') ? 'S' : 'Z';
+            break;
+        default:
+            break; // Digits
+        }
+
+        if (code && code != last && n + 1 < out_size) {
+            out[n++] = code;
+        }
+        if (code) {
+            last = code;
+        }
+    }
+
+    out[n] = '\0';
+    return n;
+}
+
+static int name_trigram_code(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 1;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 27;
+    }
+    return 0; // Padding space
+}
+
+size_t name_normalize(const char *name, char *out, size_t out_size) {
+    if (!out || out_size == 0) {
+        return 0;
+    }
+
+    size_t n = 0;
+    bool pending_space = false;
+
+    for (const unsigned char *p = (const unsigned char *)name; p && *p; p++) {
+        char c = ' ';
+
+        if (*p >= 'A' && *p <= 'Z') {
+            c = (char)(*p - 'A' + 'a');
+        } else if ((*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9')) {
+            c = (char)*p;
+        } else if (*p == 0xC3 && p[1] >= 0x80 && p[1] <= 0xBF) {
+            c = latin1_fold[p[1] - 0x80];
+            p++;
+        } else if ((*p == 0xCC && p[1] >= 0x80 && p[1] <= 0xBF) || (*p == 0xCD && p[1] >= 0x80 && p[1] <= 0xAF)) {
+            p++;
+            continue; // Combining accent (U+0300..U+036F) typed after the base letter, drop it
+        } else if (*p >= 0xC0) {
+            // Any other multi-byte character is a separator, skip its continuation bytes
+            while ((p[1] & 0xC0) == 0x80) {
+                p++;
+            }
+        }
+
+        if (c == ' ') {
+            pending_space = n > 0;
+            continue;
+        }
+
+        if (pending_space) {
+            if (n + 2 >= out_size) {
+                break;
+            }
+            out[n++] = ' ';
+            pending_space = false;
+        }
+        if (n + 1 >= out_size) {
+            break;
+        }
+        out[n++] = c;
+    }
+
+    out[n] = '\0';
+    return n;
+}
+
+uint64_t name_hash(const char *name) {
+    char normalized[NAME_NORMALIZED_LEN];
+    name_normalize(name, normalized, sizeof(normalized));
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)normalized; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t name_phonetic_key(const char *name, char key[NAME_KEY_LEN]) {
+    char normalized[NAME_NORMALIZED_LEN];
+    size_t len = name_normalize(name, normalized, sizeof(normalized));
+
+    const char *first = NULL;
+    size_t first_len = 0;
+    const char *final = NULL;
+    size_t final_len = 0;
+
+    for (size_t start = 0; start < len;) {
+        size_t end = start;
+        while (end < len && normalized[end] != ' ') {
+            end++;
+        }
+
+        if (name_is_significant_word(normalized + start, end - start)) {
+            if (!first) {
+                first = normalized + start;
+                first_len = end - start;
+            } else {
+                final = normalized + start;
+                final_len = end - start;
+            }
+        }
+        start = end + 1;
+    }
+
+    key[0] = '\0';
+    if (!first) {
+        return 0;
+    }
+
+    // Half of the key for each word, so a long first name never pushes the surname out
+    size_t n = name_encode_word(first, first_len, key, NAME_KEY_LEN / 2);
+    if (final) {
+        key[n++] = ' ';
+        n += name_encode_word(final, final_len, key + n, NAME_KEY_LEN - n);
+    }
+    return n;
+}
+
+int name_trigrams(const char *name, uint16_t trigrams[NAME_MAX_TRIGRAMS]) {
+    char normalized[NAME_NORMALIZED_LEN];
+    size_t len = name_normalize(name, normalized, sizeof(normalized));
+    int count = 0;
+
+    for (size_t start = 0; start < len && count < NAME_MAX_TRIGRAMS;) {
+        size_t end = start;
+        while (end < len && normalized[end] != ' ') {
+            end++;
+        }
+
+        if (name_is_significant_word(normalized + start, end - start)) {
+            // Padded word: ' ' + word + ' ', one trigram per starting position
+            int prev2 = 0;
+            int prev1 = 0;
+            for (size_t i = start; i <= end && count < NAME_MAX_TRIGRAMS; i++) {
+                int c = (i < end) ? name_trigram_code(normalized[i]) : 0;
+                if (i > start) {
+                    trigrams[count++] = (uint16_t)(prev2 * 37 * 37 + prev1 * 37 + c);
+                }
+                prev2 = prev1;
+                prev1 = c;
+            }
+        }
+        start = end + 1;
+    }
+
+    // Sort (insertion sort, names have a few dozen trigrams at most) and drop repeats
+    for (int i = 1; i < count; i++) {
+        uint16_t value = trigrams[i];
+        int j = i - 1;
+        while (j >= 0 && trigrams[j] > value) {
+            trigrams[j + 1] = trigrams[j];
+            j--;
+        }
+        trigrams[j + 1] = value;
+    }
+
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || trigrams[unique - 1] != trigrams[i]) {
+            trigrams[unique++] = trigrams[i];
+        }
+    }
+    return unique;
+}
+
+float name_trigram_similarity(const uint16_t *a, int a_count, const uint16_t *b, int b_count) {
+    if (a_count == 0 || b_count == 0) {
+        return 0.0f;
+    }
+
+    int shared = 0;
+    int i = 0;
+    int j = 0;
+    while (i < a_count && j < b_count) {
+        if (a[i] == b[j]) {
+            shared++;
+            i++;
+            j++;
+        } else if (a[i] < b[j]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+
+    return (float)shared / (float)(a_count + b_count - shared);
+}
+
+float name_similarity(const char *a, const char *b) {
+    uint16_t a_trigrams[NAME_MAX_TRIGRAMS];
+    uint16_t b_trigrams[NAME_MAX_TRIGRAMS];
+    int a_count = name_trigrams(a, a_trigrams);
+    int b_count = name_trigrams(b, b_trigrams);
+
+    float similarity = name_trigram_similarity(a_trigrams, a_count, b_trigrams, b_count);
+
+    char a_key[NAME_KEY_LEN];
+    char b_key[NAME_KEY_LEN];
+    if (name_phonetic_key(a, a_key) > 0 && name_phonetic_key(b, b_key) > 0 && strcmp(a_key, b_key) == 0) {
+        similarity = 0.5f + similarity / 2.0f;
+    }
+    return similarity;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file utils_perf.c
+ * @brief Performance probes implementation
+ */
+#define _POSIX_C_SOURCE 200809L // For clock_gettime and sysconf
+
+#include "utils/utils_perf.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t perf_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+size_t perf_rss_bytes(void) {
+#ifdef __linux__
+    // Second field of statm is the resident size in pages
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int read = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    long page_size = sysconf(_SC_PAGESIZE);
+    return read == 2 && page_size > 0 ? (size_t)resident * (size_t)page_size : 0;
+#else
+    return 0;
+#endif
+}
+
+void perf_ring_push(struct perf_ring *ring, float sample) {
+    ring->samples[ring->head] = sample;
+    ring->head = (ring->head + 1) % PERF_RING_SIZE;
+    if (ring->count < PERF_RING_SIZE) {
+        ring->count++;
+    }
+}
+
+float perf_ring_get(const struct perf_ring *ring, int age) {
+    if (age < 0 || age >= ring->count) {
+        return 0.0f;
+    }
+    return ring->samples[(ring->head - 1 - age + PERF_RING_SIZE) % PERF_RING_SIZE];
+}
+
+// Until the ring is full the samples are the first count ones, after that all of them
+float perf_ring_max(const struct perf_ring *ring) {
+    float max = ring->count > 0 ? ring->samples[0] : 0.0f;
+    for (int i = 1; i < ring->count; i++) {
+        max = ring->samples[i] > max ? ring->samples[i] : max;
+    }
+    return max;
+}
+
+float perf_ring_avg(const struct perf_ring *ring) {
+    if (ring->count == 0) {
+        return 0.0f;
+    }
+    double sum = 0.0;
+    for (int i = 0; i < ring->count; i++) {
+        sum += ring->samples[i];
+    }
+    return (float)(sum / ring->count);
+}
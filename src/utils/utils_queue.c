@@ -0,0 +1,123 @@
+/**
+ * @file utils_queue.c
+ * @brief Bounded lock-free queues implementation
+ */
+#include "utils/utils_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static size_t queue_capacity(size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+/* ======================= SPSC ======================= */
+
+bool spsc_queue_init(struct spsc_queue *queue, size_t capacity) {
+    *queue = (struct spsc_queue) { 0 };
+    capacity = queue_capacity(capacity);
+    queue->slots = malloc(sizeof(void *) * capacity);
+    if (!queue->slots) {
+        return false;
+    }
+    queue->mask = capacity - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return true;
+}
+
+void spsc_queue_free(struct spsc_queue *queue) {
+    free(queue->slots);
+    *queue = (struct spsc_queue) { 0 };
+}
+
+bool spsc_queue_push(struct spsc_queue *queue, void *item) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - queue->cached_head > queue->mask) {
+        // Looks full, see how far the consumer really got
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail - queue->cached_head > queue->mask) {
+            return false;
+        }
+    }
+    queue->slots[tail & queue->mask] = item;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+void *spsc_queue_pop(struct spsc_queue *queue) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == queue->cached_tail) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cached_tail) {
+            return NULL;
+        }
+    }
+    void *item = queue->slots[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return item;
+}
+
+/* ======================= MPSC ======================= */
+
+bool mpsc_queue_init(struct mpsc_queue *queue, size_t capacity) {
+    *queue = (struct mpsc_queue) { 0 };
+    capacity = queue_capacity(capacity);
+    queue->slots = malloc(sizeof(struct mpsc_slot) * capacity);
+    if (!queue->slots) {
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+        queue->slots[i].item = NULL;
+    }
+    queue->mask = capacity - 1;
+    atomic_init(&queue->tail, 0);
+    return true;
+}
+
+void mpsc_queue_free(struct mpsc_queue *queue) {
+    free(queue->slots);
+    *queue = (struct mpsc_queue) { 0 };
+}
+
+bool mpsc_queue_push(struct mpsc_queue *queue, void *item) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    struct mpsc_slot *slot;
+    for (;;) {
+        slot = &queue->slots[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            // Slot free at this position, claim it (on failure pos holds the new tail)
+            if (atomic_compare_exchange_weak_explicit(
+                    &queue->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed
+                )) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // The consumer has not freed it yet: full
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed); // Another producer took it
+        }
+    }
+    slot->item = item;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+void *mpsc_queue_pop(struct mpsc_queue *queue) {
+    struct mpsc_slot *slot = &queue->slots[queue->head & queue->mask];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != queue->head + 1) {
+        return NULL;
+    }
+    void *item = slot->item;
+    // Ready for the push one lap later
+    atomic_store_explicit(&slot->sequence, queue->head + queue->mask + 1, memory_order_release);
+    queue->head++;
+    return item;
+}
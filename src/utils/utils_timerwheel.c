@@ -0,0 +1,186 @@
+/**
+ * @file utils_timerwheel.c
+ * @brief Hierarchical timing wheel implementation
+ */
+#include "utils/utils_timerwheel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// Extra list holding the timers of the tick being fired, so callbacks can still cancel them
+#define TIMER_WHEEL_FIRING (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+// Farthest a timer can be placed from the next tick, later ones wait in the top level and are re-placed on cascade
+#define TIMER_WHEEL_SPAN ((int64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static void timer_wheel_link(struct timer_wheel *tw, int id, int slot) {
+    struct timer_wheel_node *node = &tw->nodes[id];
+    node->slot = slot;
+    node->prev = -1;
+    node->next = tw->heads[slot];
+    if (node->next >= 0) {
+        tw->nodes[node->next].prev = id;
+    }
+    tw->heads[slot] = id;
+}
+
+static void timer_wheel_unlink(struct timer_wheel *tw, int id) {
+    struct timer_wheel_node *node = &tw->nodes[id];
+    if (node->prev >= 0) {
+        tw->nodes[node->prev].next = node->next;
+    } else {
+        tw->heads[node->slot] = node->next;
+    }
+    if (node->next >= 0) {
+        tw->nodes[node->next].prev = node->prev;
+    }
+}
+
+static void timer_wheel_release(struct timer_wheel *tw, int id) {
+    tw->nodes[id].slot = -1;
+    tw->nodes[id].next = tw->free_head;
+    tw->free_head = id;
+    tw->count--;
+}
+
+/**
+ * @internal
+ * @brief Puts a timer in the slot for its distance from the next tick to process
+ */
+static void timer_wheel_place(struct timer_wheel *tw, int id) {
+    int64_t base = tw->current + 1;
+    int64_t expires = tw->nodes[id].expires;
+    if (expires < base) {
+        expires = base; // Overdue, fires on the next tick
+    }
+
+    int64_t delta = expires - base;
+    if (delta >= TIMER_WHEEL_SPAN) {
+        expires = base + TIMER_WHEEL_SPAN - 1;
+        delta = TIMER_WHEEL_SPAN - 1;
+    }
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= ((int64_t)1 << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    int slot = (int)((expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    timer_wheel_link(tw, id, level * TIMER_WHEEL_SLOTS + slot);
+}
+
+/**
+ * @internal
+ * @brief Moves the timers of one slot down to the levels below
+ */
+static void timer_wheel_cascade(struct timer_wheel *tw, int level, int index) {
+    int slot = level * TIMER_WHEEL_SLOTS + index;
+    int id = tw->heads[slot];
+    tw->heads[slot] = -1;
+
+    while (id >= 0) {
+        int next = tw->nodes[id].next;
+        timer_wheel_place(tw, id);
+        id = next;
+    }
+}
+
+void timer_wheel_init(struct timer_wheel *tw, int64_t now) {
+    memset(tw, 0, sizeof(*tw));
+    tw->current = now;
+    tw->free_head = -1;
+    memset(tw->heads, -1, sizeof(tw->heads));
+}
+
+void timer_wheel_free(struct timer_wheel *tw) {
+    free(tw->nodes);
+    timer_wheel_init(tw, tw->current);
+}
+
+int timer_wheel_add(struct timer_wheel *tw, int64_t expires, int payload) {
+    int id;
+    if (tw->free_head >= 0) {
+        id = tw->free_head;
+        tw->free_head = tw->nodes[id].next;
+    } else {
+        if (tw->node_used == tw->node_capacity) {
+            int capacity = tw->node_capacity ? tw->node_capacity * 2 : 64;
+            struct timer_wheel_node *nodes = realloc(tw->nodes, sizeof(*nodes) * (size_t)capacity);
+            if (!nodes) {
+                return -1;
+            }
+            tw->nodes = nodes;
+            tw->node_capacity = capacity;
+        }
+        id = tw->node_used++;
+    }
+
+    tw->nodes[id].expires = expires;
+    tw->nodes[id].payload = payload;
+    timer_wheel_place(tw, id);
+    tw->count++;
+    return id;
+}
+
+bool timer_wheel_cancel(struct timer_wheel *tw, int id) {
+    if (id < 0 || id >= tw->node_used || tw->nodes[id].slot < 0) {
+        return false;
+    }
+
+    timer_wheel_unlink(tw, id);
+    timer_wheel_release(tw, id);
+    return true;
+}
+
+int timer_wheel_advance(struct timer_wheel *tw, int64_t now, timer_wheel_callback callback, void *ctx) {
+    if (tw->count == 0) {
+        // Nothing to cascade or fire, skip the idle ticks at once
+        if (now > tw->current) {
+            tw->current = now;
+        }
+        return 0;
+    }
+
+    int fired = 0;
+    while (tw->current < now) {
+        int64_t base = tw->current + 1;
+        int index = (int)(base & TIMER_WHEEL_MASK);
+
+        // Level 0 wrapped: bring down the next slot of level 1, and of level 2 if level 1 wrapped too...
+        if (index == 0) {
+            for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                int level_index = (int)((base >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+                timer_wheel_cascade(tw, level, level_index);
+                if (level_index != 0) {
+                    break;
+                }
+            }
+        }
+
+        tw->current = base;
+
+        // Move the slot to the firing list first: a timer added by a callback 64 ticks ahead lands
+        // in this same slot and must wait for the next turn of the wheel
+        tw->heads[TIMER_WHEEL_FIRING] = tw->heads[index];
+        tw->heads[index] = -1;
+        for (int id = tw->heads[TIMER_WHEEL_FIRING]; id >= 0; id = tw->nodes[id].next) {
+            tw->nodes[id].slot = TIMER_WHEEL_FIRING;
+        }
+
+        int id;
+        while ((id = tw->heads[TIMER_WHEEL_FIRING]) >= 0) {
+            int payload = tw->nodes[id].payload;
+            int64_t expires = tw->nodes[id].expires;
+            timer_wheel_unlink(tw, id);
+            timer_wheel_release(tw, id);
+            fired++;
+            if (callback) {
+                callback(ctx, id, payload, expires);
+            }
+        }
+    }
+
+    return fired;
+}
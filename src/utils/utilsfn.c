@@ -6,6 +6,7 @@
 
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -64,50 +65,57 @@ void filter_integer_input(char *input, const int max_len) {
     strcpy(input, filtered);
 }
 
-bool validate_date(int year, int month, int day) {
-    if (year < 1) {
-        return false;
-    }
-
-    // Check month
-    switch (month) {
-    // Jan, Mar, May, Jul, Aug, Oct, Dec:
-    case 1:
-    case 3:
-    case 5:
-    case 7:
-    case 8:
-    case 10:
-    case 12:
-        if (day < 1 || day > 31) {
-            return false;
-        }
-        break;
-    // Apr, Jun, Sept, Nov:
-    case 4:
-    case 6:
-    case 9:
-    case 11:
-        if (day < 1 || day > 30) {
-            return false;
-        }
-        break;
-    //Feb:
-    case 2:
-        if ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0)) {
-            if (day < 1 || day > 29) {
-                return false; // Leap year
+int table_text_patch(char **text, const char *key, const char *block) {
+    size_t key_len = strlen(key);
+    size_t text_len = strlen(*text);
+    size_t block_len = block ? strlen(block) : 0;
+
+    // Span of the matching row and its separator, an empty span at the end when none matches
+    size_t start = text_len;
+    size_t end = text_len;
+    for (const char *line = *text; *line;) {
+        const char *next = strchr(line, '\n');
+        next = next ? next + 1 : line + strlen(line);
+
+        if (line[0] == '|') {
+            const char *cell = line + 1;
+            while (*cell == ' ') {
+                cell++;
             }
-        } else {
-            if (day < 1 || day > 28) {
-                return false; // Non-leap year
+            const char *cell_end = cell;
+            while (cell_end < next && *cell_end != '|') {
+                cell_end++;
+            }
+            while (cell_end > cell && cell_end[-1] == ' ') {
+                cell_end--;
+            }
+
+            if ((size_t)(cell_end - cell) == key_len && memcmp(cell, key, key_len) == 0) {
+                start = (size_t)(line - *text);
+                const char *separator_end = *next ? strchr(next, '\n') : NULL;
+                end = separator_end ? (size_t)(separator_end + 1 - *text) : (size_t)(next - *text);
+                break;
             }
         }
-        break;
-    // Will never happen in this app
-    default:
-        return false; // Invalid month
+        line = next;
+    }
+
+    if (!block && start == end) {
+        return 0; // Nothing to remove
     }
 
-    return true;
+    size_t new_len = text_len - (end - start) + block_len;
+    if (new_len > text_len) {
+        char *grown = realloc(*text, new_len + 1);
+        if (!grown) {
+            return -1;
+        }
+        *text = grown;
+    }
+
+    memmove(*text + start + block_len, *text + end, text_len - end + 1);
+    if (block_len > 0) {
+        memcpy(*text + start, block, block_len);
+    }
+    return 0;
 }
@@ -2,21 +2,56 @@
  * @file tests.c
  * @brief Unit testing for everything that can be unit tested
  */
+#define _POSIX_C_SOURCE 200809L // For nanosleep
+
 #include <assert.h>
 #include <ctype.h>
+#include <dirent.h>
 #include <inttypes.h> // For PRIu64 (compatibility for both windows and linux)
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
+#include <time.h>
+#include <zlib.h>
+#undef MAX_INPUT // Terminal limit from <limits.h> through zlib, the app defines its own in CONSTANTS.h
+
+#include "db/clothes_db.h"
+#include "db/clothes_index.h"
+#include "db/datagen.h"
+#include "db/db_backup.h"
+#include "db/db_changes.h"
+#include "db/db_client.h"
+#include "db/db_maintenance.h"
 #include "db/db_manager.h"
+#include "db/db_profile.h"
+#include "db/db_protocol.h"
+#include "db/db_server.h"
+#include "db/dose_schedule.h"
+#include "db/expiration_alerts.h"
+#include "db/food_distribution.h"
+#include "db/food_forecast.h"
 #include "db/foodbatch_db.h"
+#include "db/medication_db.h"
 #include "db/resident_db.h"
+#include "db/resident_dedupe.h"
+#include "db/resident_import.h"
+#include "db/resident_search.h"
+#include "db/supplies_db.h"
 #include "db/user_db.h"
+#include "db/user_roster.h"
 #include "entities/user.h"
+#include "utils/utils_date.h"
 #include "utils/utils_hash.h"
+#include "utils/utils_intmap.h"
+#include "utils/utils_perf.h"
+#include "utils/utils_name.h"
+#include "utils/utils_queue.h"
+#include "utils/utils_timerwheel.h"
 #include "utils/utilsfn.h"
 
 // Global context structure
@@ -633,6 +668,610 @@ void test_resident_db_get_all(void) {
     printf("resident_db_get_all test passed successfully.\n");
 }
 
+// Collects the names of the residents found by resident_db_search
+struct test_search_names {
+    char names[8][MAX_INPUT];
+    int count;
+};
+
+static int test_collect_search_names(void *ctx, const struct resident *resident) {
+    struct test_search_names *found = ctx;
+    if (found->count < 8) {
+        strcpy(found->names[found->count++], resident->name);
+    }
+    return 0;
+}
+
+void test_resident_db_search(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    printf("Adding test residents...\n");
+    resident_db_insert(&test_resident_db, "12345678909", "Maria da Silva", 30, "Healthy", "None", false, 2);
+    resident_db_insert(&test_resident_db, "23456789092", "João Souza", 45, "Diabetes", "Insulin daily", true, 1);
+    resident_db_insert(&test_resident_db, "34567890175", "Marcos Silveira", 28, "Asthma", "Inhaler", false, 1);
+
+    struct test_search_names found = { 0 };
+
+    printf("Searching by name prefix...\n");
+    int rc = resident_db_search(&test_resident_db, "mar", 10, test_collect_search_names, &found);
+    assert(rc == 2);
+    assert(found.count == 2);
+    printf("Prefix search found both residents.\n");
+
+    printf("Searching by two prefixes (all words must match)...\n");
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "mar silv", 10, test_collect_search_names, &found);
+    assert(rc == 2);
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "maria silv", 10, test_collect_search_names, &found);
+    assert(rc == 1);
+    assert(strcmp(found.names[0], "Maria da Silva") == 0);
+    printf("Multi word search narrowed correctly.\n");
+
+    printf("Searching inside health status and needs, ignoring accents...\n");
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "insulin", 10, test_collect_search_names, &found);
+    assert(rc == 1);
+    assert(strcmp(found.names[0], "João Souza") == 0);
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "joao", 10, test_collect_search_names, &found);
+    assert(rc == 1);
+    printf("Health status, needs and accent-insensitive search work.\n");
+
+    printf("Searching with FTS syntax characters typed by the user...\n");
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "\"asthma* OR (", 10, test_collect_search_names, &found);
+    assert(rc == 0); // "or" is a plain term here and no resident has it
+    rc = resident_db_search(&test_resident_db, "  ,.;  ", 10, test_collect_search_names, &found);
+    assert(rc == 0);
+    printf("User input is never parsed as FTS syntax.\n");
+
+    printf("Checking the limit...\n");
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "mar", 1, test_collect_search_names, &found);
+    assert(rc == 1);
+    printf("Limit respected.\n");
+
+    printf("Checking the index follows updates and deletes...\n");
+    rc = resident_db_update(&test_resident_db, "34567890175", "Pedro Alves", 0, "", "", -1, -1);
+    assert(rc == SQLITE_OK);
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "marcos", 10, test_collect_search_names, &found);
+    assert(rc == 0);
+    rc = resident_db_search(&test_resident_db, "pedro", 10, test_collect_search_names, &found);
+    assert(rc == 1);
+    resident_db_delete_by_cpf(&test_resident_db, "34567890175");
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "pedro", 10, test_collect_search_names, &found);
+    assert(rc == 0);
+    printf("Index kept in sync by triggers.\n");
+
+    printf("Checking every match is ranked, not only the first ones in CPF order...\n");
+    assert(sqlite3_exec(test_resident_db.db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i < 300; i++) {
+        char cpf[MAX_CPF_LENGTH];
+        snprintf(cpf, sizeof(cpf), "%09d", 1000 + i);
+        resident_db_cpf_complete(cpf);
+        rc = resident_db_insert(&test_resident_db, cpf, "Ana Costa", 40, "Healthy", "Rosa garden work", false, 2);
+        assert(rc == SQLITE_OK);
+    }
+    assert(sqlite3_exec(test_resident_db.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+    resident_db_insert(&test_resident_db, "99999999808", "Rosa Lima", 50, "Healthy", "None", false, 2);
+    found = (struct test_search_names) { 0 };
+    rc = resident_db_search(&test_resident_db, "rosa", 5, test_collect_search_names, &found);
+    assert(rc == 5);
+    assert(strcmp(found.names[0], "Rosa Lima") == 0);
+    printf("Name hit with the highest CPF ranked first among 301 matches.\n");
+
+    teardown_cleanup();
+
+    printf("resident_db_search test passed successfully.\n");
+}
+
+void test_resident_search_worker(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    resident_db_insert(&test_resident_db, "12345678909", "Maria da Silva", 30, "Healthy", "None", false, 2);
+    resident_db_insert(&test_resident_db, "23456789092", "Mariana Costa", 45, "Healthy", "None", false, 2);
+
+    printf("Starting the background search worker...\n");
+    struct resident_search *search = resident_search_start(&test_resident_db);
+    assert(search != NULL);
+
+    struct resident results[RESIDENT_SEARCH_MAX_RESULTS];
+    int count = 0;
+    unsigned generation = 0;
+
+    // Only the last query of a burst should run
+    resident_search_submit(search, "m");
+    resident_search_submit(search, "mar");
+    resident_search_submit(search, "mariana");
+
+    printf("Polling for debounced results...\n");
+    bool updated = false;
+    for (int i = 0; i < 200 && !updated; i++) {
+        updated = resident_search_poll(search, results, &count, &generation);
+        if (!updated) {
+            struct timespec ts = { 0, 10 * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    assert(updated);
+    assert(count == 1);
+    assert(strcmp(results[0].name, "Mariana Costa") == 0);
+    assert(!resident_search_poll(search, results, &count, &generation));
+    printf("Worker returned only the results of the latest query.\n");
+
+    resident_search_stop(search);
+
+    // Through a pool, every query checks a reader out and gives it back
+    assert(db_pool_open(&test_resident_db, 1) == SQLITE_OK);
+    search = resident_search_start(&test_resident_db);
+    assert(search != NULL);
+    resident_search_submit(search, "silva");
+    generation = 0;
+    updated = false;
+    for (int i = 0; i < 200 && !updated; i++) {
+        updated = resident_search_poll(search, results, &count, &generation);
+        if (!updated) {
+            struct timespec ts = { 0, 10 * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    assert(updated);
+    assert(count == 1);
+    assert(strcmp(results[0].name, "Maria da Silva") == 0);
+    database reader;
+    assert(db_pool_acquire(&test_resident_db, &reader) == SQLITE_OK && reader.db != test_resident_db.db);
+    db_pool_release(&test_resident_db, &reader);
+    printf("Worker searched through the pool.\n");
+
+    resident_search_stop(search);
+
+    teardown_cleanup();
+
+    printf("resident_search worker test passed successfully.\n");
+}
+
+void test_resident_db_integer_cpf(void) {
+    printf("Testing CPF packing...\n");
+    char cpf[MAX_CPF_LENGTH];
+    assert(resident_db_cpf_pack("01234567890") == 1234567890);
+    assert(resident_db_cpf_pack("99999999999") == 99999999999LL);
+    assert(resident_db_cpf_pack("") == -1);
+    assert(resident_db_cpf_pack("123.456.789-01") == -1);
+    assert(resident_db_cpf_pack("123456789012") == -1);
+    resident_db_cpf_unpack(1234567890, cpf);
+    assert(strcmp(cpf, "01234567890") == 0);
+    resident_db_cpf_unpack(0, cpf);
+    assert(strcmp(cpf, "00000000000") == 0);
+    printf("CPF packs and unpacks with leading zeros.\n");
+
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+
+    printf("Creating a Resident table keyed by TEXT CPF...\n");
+    db_init(&test_resident_db, test_resident_filename);
+    setup_cleanup(test_resident_filename, &test_resident_db);
+    int rc = sqlite3_exec(
+        test_resident_db.db,
+        "CREATE TABLE Resident (CPF TEXT PRIMARY KEY, Name TEXT NOT NULL, Age INTEGER NOT NULL, HealthStatus TEXT,"
+        "Needs TEXT, MedicalAssistance INTEGER NOT NULL, Gender INTEGER NOT NULL, EntryDate TEXT);"
+        "INSERT INTO Resident VALUES ('01234567890', 'Maria da Silva', 30, 'Healthy', 'None', 0, 2, '2024-01-01');",
+        0,
+        0,
+        0
+    );
+    assert(rc == SQLITE_OK);
+    db_deinit(&test_resident_db);
+
+    printf("Migrating...\n");
+    rc = db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+    assert(rc == SQLITE_OK);
+
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(test_resident_db.db, "SELECT typeof(CPF) FROM Resident;", -1, &stmt, 0);
+    assert(rc == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    assert(strcmp((const char *)sqlite3_column_text(stmt, 0), "integer") == 0);
+    sqlite3_finalize(stmt);
+    // WITHOUT ROWID: the table has no rowid to select
+    rc = sqlite3_prepare_v2(test_resident_db.db, "SELECT rowid FROM Resident;", -1, &stmt, 0);
+    assert(rc != SQLITE_OK);
+    sqlite3_finalize(stmt);
+    printf("Table rebuilt as WITHOUT ROWID with an integer CPF.\n");
+
+    printf("Reading through the string API...\n");
+    struct resident resident = { 0 };
+    assert(resident_db_get_by_cpf(&test_resident_db, "01234567890", &resident) == SQLITE_OK);
+    assert(strcmp(resident.cpf, "01234567890") == 0);
+    assert(resident.cpf_packed == 1234567890);
+    assert(strcmp(resident.name, "Maria da Silva") == 0);
+    assert(resident.entry_day == 19723);
+    assert(strcmp(resident.entry_date, "2024-01-01") == 0);
+    assert(resident_db_get_by_cpf(&test_resident_db, "abc", &resident) == SQLITE_NOTFOUND);
+    assert(!resident_db_check_cpf_exists(&test_resident_db, "abc"));
+    assert(resident_db_insert(&test_resident_db, "abc", "Nobody", 1, "", "", false, 0) == SQLITE_MISMATCH);
+    printf("String API converts at the boundary.\n");
+
+    // Check digits are the screen's and the import's to check, the database takes any 11 digits
+    assert(!resident_db_cpf_valid("52998224724"));
+    assert(resident_db_insert(&test_resident_db, "52998224724", "Nobody", 1, "", "", false, 0) == SQLITE_OK);
+    assert(resident_db_check_cpf_exists(&test_resident_db, "52998224724"));
+    assert(resident_db_update(&test_resident_db, "52998224724", "", 31, "", "", -1, -1) == SQLITE_OK);
+    assert(resident_db_delete_by_cpf(&test_resident_db, "52998224724") == SQLITE_OK);
+    char completed[MAX_CPF_LENGTH] = "529982247";
+    resident_db_cpf_complete(completed);
+    assert(strcmp(completed, "52998224725") == 0 && resident_db_cpf_valid(completed));
+    printf("CPF check digits checked apart from the inserts.\n");
+
+    printf("Checking the search index was rebuilt on the new key...\n");
+    struct test_search_names found = { 0 };
+    assert(resident_db_search(&test_resident_db, "maria", 10, test_collect_search_names, &found) == 1);
+    assert(resident_db_delete_by_cpf(&test_resident_db, "01234567890") == SQLITE_OK);
+    found = (struct test_search_names) { 0 };
+    assert(resident_db_search(&test_resident_db, "maria", 10, test_collect_search_names, &found) == 0);
+    printf("Search index follows the integer key.\n");
+
+    teardown_cleanup();
+
+    printf("resident_db integer CPF test passed successfully.\n");
+}
+
+void test_resident_db_entered_between(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    printf("Testing resident_db_entered_between...\n");
+    assert(resident_db_insert(&test_resident_db, "11111111200", "Ana Souza", 30, "", "", false, 2) == SQLITE_OK);
+    assert(resident_db_insert(&test_resident_db, "22222222303", "Bruno Lima", 40, "", "", false, 1) == SQLITE_OK);
+    assert(resident_db_insert(&test_resident_db, "33333333414", "Carla Dias", 50, "", "", false, 2) == SQLITE_OK);
+
+    struct resident resident = { 0 };
+    assert(resident_db_get_by_cpf(&test_resident_db, "11111111200", &resident) == SQLITE_OK);
+    assert(resident.entry_day == date_today());
+    printf("Insert stores today as a day number.\n");
+
+    int rc = sqlite3_exec(
+        test_resident_db.db,
+        "UPDATE Resident SET EntryDate = 19723 WHERE CPF = 11111111200;" // 2024-01-01
+        "UPDATE Resident SET EntryDate = 19753 WHERE CPF = 22222222303;" // 2024-01-31
+        "UPDATE Resident SET EntryDate = 19754 WHERE CPF = 33333333414;", // 2024-02-01
+        0,
+        0,
+        0
+    );
+    assert(rc == SQLITE_OK);
+
+    struct test_search_names found = { 0 };
+    int count = resident_db_entered_between(
+        &test_resident_db,
+        date_parse("2024-01-01"),
+        date_parse("2024-01-31"),
+        test_collect_search_names,
+        &found
+    );
+    assert(count == 2);
+    assert(strcmp(found.names[0], "Ana Souza") == 0);
+    assert(strcmp(found.names[1], "Bruno Lima") == 0);
+    printf("Range is inclusive and ordered by entry date.\n");
+
+    found = (struct test_search_names) { 0 };
+    assert(resident_db_entered_between(&test_resident_db, 19755, 20000, test_collect_search_names, &found) == 0);
+    printf("Empty range returns nothing.\n");
+
+    teardown_cleanup();
+
+    printf("resident_db_entered_between test passed successfully.\n");
+}
+
+void test_resident_dedupe_find(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    resident_db_insert(&test_resident_db, "12345678909", "Luiz Souza", 30, "Healthy", "None", false, 1);
+    resident_db_insert(&test_resident_db, "23456789092", "Maria Aparecida da Silva", 45, "Healthy", "None", false, 2);
+    resident_db_insert(&test_resident_db, "34567890175", "Pedro Alves", 28, "Healthy", "None", false, 1);
+
+    printf("Loading the trigram index...\n");
+    struct resident_dedupe *dedupe = resident_dedupe_load(&test_resident_db);
+    assert(dedupe != NULL);
+
+    struct resident_duplicate found[RESIDENT_DEDUPE_MAX_CANDIDATES];
+
+    printf("Finding a resident spelled differently...\n");
+    int count = resident_dedupe_find(dedupe, "Luis Sousa", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5);
+    assert(count == 1);
+    assert(strcmp(found[0].cpf, "12345678909") == 0);
+    count = resident_dedupe_find(dedupe, "Maria Silva", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5);
+    assert(count == 1);
+    assert(strcmp(found[0].name, "Maria Aparecida da Silva") == 0);
+    printf("Different spellings found.\n");
+
+    printf("Checking unrelated names and the excluded CPF...\n");
+    assert(resident_dedupe_find(dedupe, "Ana Costa", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5) == 0);
+    assert(resident_dedupe_find(dedupe, "Luiz Souza", "12345678909", RESIDENT_DEDUPE_THRESHOLD, found, 5) == 0);
+    printf("No false candidates.\n");
+
+    printf("Checking add and remove...\n");
+    assert(resident_dedupe_add(dedupe, "45678901249", "Luís de Souza"));
+    count = resident_dedupe_find(dedupe, "Luiz Souza", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5);
+    assert(count == 2);
+    assert(strcmp(found[0].cpf, "12345678909") == 0); // Exact name ranks first
+    assert(found[0].similarity >= found[1].similarity);
+    resident_dedupe_remove(dedupe, "12345678909");
+    count = resident_dedupe_find(dedupe, "Luiz Souza", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5);
+    assert(count == 1);
+    assert(strcmp(found[0].cpf, "45678901249") == 0);
+    printf("Index follows add and remove.\n");
+
+    resident_dedupe_free(dedupe);
+
+    teardown_cleanup();
+
+    printf("resident_dedupe_find test passed successfully.\n");
+}
+
+void test_resident_db_insert_checked(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    resident_db_insert(&test_resident_db, "12345678909", "Luiz Souza", 30, "Healthy", "None", false, 1);
+    resident_db_insert(&test_resident_db, "34567890175", "Pedro Alves", 28, "Healthy", "None", false, 1);
+
+    struct resident_duplicate found[RESIDENT_DEDUPE_MAX_CANDIDATES];
+
+    printf("Looking up similar names through the NameKey index...\n");
+    int count = resident_db_find_duplicates(&test_resident_db, "Luis Sousa", NULL, RESIDENT_DEDUPE_THRESHOLD, found, 5);
+    assert(count == 1);
+    assert(strcmp(found[0].cpf, "12345678909") == 0 && found[0].similarity >= RESIDENT_DEDUPE_THRESHOLD);
+    count = resident_db_find_duplicates(&test_resident_db, "Luiz Souza", "12345678909", 0.0f, found, 5);
+    assert(count == 0);
+    assert(resident_db_find_duplicates(&test_resident_db, "Ana Costa", NULL, 0.0f, found, 5) == 0);
+    assert(resident_db_find_duplicates(&test_resident_db, " ,. ", NULL, 0.0f, found, 5) == 0);
+    assert(resident_db_find_duplicates(&test_resident_db, "Luis Sousa", NULL, 0.0f, found, 0) == -1);
+    printf("Same-sounding names found, the excluded CPF and unrelated names are not.\n");
+
+    printf("Inserting with the check...\n");
+    count = -1;
+    int rc = resident_db_insert_checked(
+        &test_resident_db,
+        "45678901249",
+        "Luís de Souza",
+        40,
+        "",
+        "",
+        false,
+        1,
+        RESIDENT_DEDUPE_THRESHOLD,
+        found,
+        RESIDENT_DEDUPE_MAX_CANDIDATES,
+        &count
+    );
+    assert(rc == SQLITE_OK && count == 1);
+    assert(strcmp(found[0].cpf, "12345678909") == 0); // Not itself
+    assert(resident_db_check_cpf_exists(&test_resident_db, "45678901249")); // Inserted all the same
+    rc = resident_db_insert_checked(
+        &test_resident_db,
+        "56789012303",
+        "Ana Costa",
+        22,
+        "",
+        "",
+        false,
+        2,
+        RESIDENT_DEDUPE_THRESHOLD,
+        found,
+        RESIDENT_DEDUPE_MAX_CANDIDATES,
+        &count
+    );
+    assert(rc == SQLITE_OK && count == 0);
+    rc = resident_db_insert_checked(
+        &test_resident_db,
+        "45678901249",
+        "Luiz Souza",
+        40,
+        "",
+        "",
+        false,
+        1,
+        RESIDENT_DEDUPE_THRESHOLD,
+        found,
+        RESIDENT_DEDUPE_MAX_CANDIDATES,
+        &count
+    );
+    assert(rc != SQLITE_OK && count == 0); // CPF taken, nothing inserted and nothing reported
+    printf("Candidates returned with the insert, the new resident left out.\n");
+
+    teardown_cleanup();
+
+    printf("resident_db_insert_checked test passed successfully.\n");
+}
+
+static int test_count_dedupe_pairs(void *ctx, const struct resident_duplicate *a, const struct resident_duplicate *b) {
+    int *pairs = ctx;
+    (*pairs)++;
+    // Pairs come from the same phonetic group, both residents must be one of the Souza spellings
+    assert(strstr(a->name, "ou") != NULL && strstr(b->name, "ou") != NULL);
+    assert(b->similarity >= RESIDENT_DEDUPE_THRESHOLD);
+    return 0;
+}
+
+void test_resident_dedupe_report(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+
+    // A table from before the NameKey column existed
+    printf("Creating a Resident table without NameKey...\n");
+    db_init(&test_resident_db, test_resident_filename);
+    setup_cleanup(test_resident_filename, &test_resident_db);
+    int rc = sqlite3_exec(
+        test_resident_db.db,
+        "CREATE TABLE Resident (CPF TEXT PRIMARY KEY, Name TEXT NOT NULL, Age INTEGER NOT NULL, HealthStatus TEXT,"
+        "Needs TEXT, MedicalAssistance INTEGER NOT NULL, Gender INTEGER NOT NULL, EntryDate TEXT);"
+        "INSERT INTO Resident VALUES ('12345678909', 'Luiz Souza', 30, '', '', 0, 1, '2024-01-01');"
+        "INSERT INTO Resident VALUES ('23456789092', 'Luis Sousa', 31, '', '', 0, 1, '2024-01-02');",
+        0,
+        0,
+        0
+    );
+    assert(rc == SQLITE_OK);
+    db_deinit(&test_resident_db);
+
+    printf("Opening it with resident_db_create_table to migrate...\n");
+    rc = db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+    assert(rc == SQLITE_OK);
+
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(test_resident_db.db, "SELECT COUNT(*) FROM Resident WHERE NameKey = 'LS SZ';", -1, &stmt, 0);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    assert(sqlite3_column_int(stmt, 0) == 2);
+    sqlite3_finalize(stmt);
+    printf("NameKey added and filled for existing residents.\n");
+
+    resident_db_insert(&test_resident_db, "34567890175", "Luiz de Souza", 40, "", "", false, 1);
+    resident_db_insert(&test_resident_db, "45678901249", "Pedro Alves", 28, "", "", false, 1);
+    resident_db_insert(&test_resident_db, "56789012303", "Pedro Santos", 28, "", "", false, 1);
+
+    printf("Running the dedupe report...\n");
+    int pairs = 0;
+    rc = resident_dedupe_report(&test_resident_db, RESIDENT_DEDUPE_THRESHOLD, test_count_dedupe_pairs, &pairs);
+    assert(rc == 3); // The three Souza spellings pair with each other, the Pedros have different keys
+    assert(pairs == 3);
+    printf("Report found every pair within the phonetic groups.\n");
+
+    teardown_cleanup();
+
+    printf("resident_dedupe_report test passed successfully.\n");
+}
+
+void test_resident_import(void) {
+    const char *test_resident_filename = "test_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+    setup_cleanup(test_resident_filename, &test_resident_db);
+
+    printf("Testing resident_import...\n");
+    struct datagen gen;
+    datagen_init(&gen, 45);
+    char cpf[MAX_CPF_LENGTH];
+    datagen_resident_cpf(&gen, 1, cpf);
+    assert(resident_db_insert(&test_resident_db, cpf, "Already Here", 30, "", "", false, 1) == SQLITE_OK);
+
+    // Row 1 is registered already, the others are new
+    const int generated = 3000;
+    FILE *file = tmpfile();
+    assert(file);
+    fputs("cpf,name,age,health_status,needs,medical_assistance,gender,entry_date\n", file);
+    for (int row = 1; row <= generated; row++) {
+        struct resident r;
+        datagen_resident(&gen, row, &r);
+        fprintf(
+            file,
+            "%s,%s,%d,%s,%s,%s,%d,%s\n",
+            r.cpf,
+            r.name,
+            r.age,
+            r.health_status,
+            r.needs,
+            r.medical_assistance ? "yes" : "no",
+            (int)r.gender,
+            r.entry_date
+        );
+    }
+    datagen_resident_cpf(&gen, generated + 1, cpf);
+    fprintf(file, "  %s , \"Silva, Maria \"\"Mia\"\"\" ,41,,Wheelchair,Y,female\r\n", cpf);
+    fputs("# Rows below are rejected\n\n", file);
+    datagen_resident_cpf(&gen, generated + 2, cpf);
+    cpf[10] = cpf[10] == '9' ? '0' : (char)(cpf[10] + 1);
+    fprintf(file, "%s,Wrong Digit,30,,,no,1\n", cpf);
+    datagen_resident_cpf(&gen, generated + 3, cpf);
+    fprintf(file, "%s,Too Old,121,,,no,1\n", cpf);
+    fprintf(file, "%s,Bad Date,30,,,no,1,2024-02-30\n", cpf);
+    fprintf(file, "%s,Bad Gender,30,,,no,7\n", cpf);
+    fprintf(file, "%s,\"Unterminated,30,,,no,1\n", cpf);
+    fprintf(file, "%s,Missing Fields,30\n", cpf);
+    fprintf(file, "%s,Last Line,30,,,no,1,2024-03-01", cpf); // No newline at the end
+    rewind(file);
+
+    // Small chunks so lines straddle them and some chunks hold no whole line
+    struct resident_import_options options = { .workers = 3, .chunk_size = 48, .commit_rows = 500 };
+    struct resident_import_stats stats;
+    assert(resident_import(&test_resident_db, file, &options, &stats) == SQLITE_OK);
+    assert(stats.workers == 3);
+    assert(stats.lines == (uint64_t)generated + 11);
+    assert(stats.rows_valid == (uint64_t)generated + 2);
+    assert(stats.rows_invalid == 6);
+    assert(stats.rows_duplicate == 1);
+    assert(stats.rows_inserted == (uint64_t)generated + 1);
+    assert(stats.rows_possible_duplicate <= stats.rows_inserted);
+    assert(stats.commits >= (uint64_t)generated / 500);
+    assert(stats.chunks > 0 && stats.batches > 0);
+    assert(resident_db_get_count(&test_resident_db) == generated + 2);
+    printf("Valid rows imported, invalid and registered ones skipped.\n");
+
+    struct resident resident;
+    datagen_resident_cpf(&gen, generated + 1, cpf);
+    assert(resident_db_get_by_cpf(&test_resident_db, cpf, &resident) == SQLITE_OK);
+    assert(strcmp(resident.name, "Silva, Maria \"Mia\"") == 0);
+    assert(resident.age == 41 && resident.medical_assistance && resident.gender == GENDER_FEMALE);
+    assert(strcmp(resident.needs, "Wheelchair") == 0 && resident.entry_day == date_today());
+    datagen_resident_cpf(&gen, generated + 3, cpf);
+    assert(resident_db_get_by_cpf(&test_resident_db, cpf, &resident) == SQLITE_OK);
+    assert(strcmp(resident.name, "Last Line") == 0 && strcmp(resident.entry_date, "2024-03-01") == 0);
+
+    struct resident expected;
+    datagen_resident(&gen, generated / 2, &expected);
+    assert(resident_db_get_by_cpf(&test_resident_db, expected.cpf, &resident) == SQLITE_OK);
+    assert(strcmp(resident.name, expected.name) == 0 && resident.age == expected.age);
+    assert(resident.entry_day == expected.entry_day && resident.gender == expected.gender);
+    printf("Fields, quotes and dates imported as written.\n");
+
+    // The same file again on one parser: every valid row is a duplicate now
+    rewind(file);
+    assert(resident_import(&test_resident_db, file, &(struct resident_import_options) { .workers = 1 }, &stats)
+           == SQLITE_OK);
+    assert(stats.workers == 1);
+    assert(stats.rows_inserted == 0 && stats.rows_duplicate == (uint64_t)generated + 2);
+    assert(resident_db_get_count(&test_resident_db) == generated + 2);
+    fclose(file);
+    printf("Reimport inserted nothing.\n");
+
+    // A new CPF under a registered name is imported, and reported when asked to
+    for (int check = 0; check <= 1; check++) {
+        file = tmpfile();
+        assert(file);
+        datagen_resident_cpf(&gen, generated + 10 + check, cpf);
+        fprintf(file, "%s,Already Here,30,,,no,1\n", cpf);
+        rewind(file);
+        options = (struct resident_import_options) { .workers = 1, .check_duplicates = check == 1 };
+        assert(resident_import(&test_resident_db, file, &options, &stats) == SQLITE_OK);
+        assert(stats.rows_inserted == 1 && stats.rows_possible_duplicate == (check ? 1 : 0));
+        fclose(file);
+    }
+    printf("Possible duplicates imported and reported.\n");
+
+    teardown_cleanup();
+
+    printf("resident_import test passed successfully.\n");
+}
+
 // TEST DB RESIDENT END
 
 // TEST DB FOODBATCH START
@@ -1157,87 +1796,3002 @@ void test_foodbatch_db_get_all_format_old(void) {
     printf("foodbatch_db_get_all_format_old test passed successfully.\n");
 }
 
-// TEST DB FOODBATCH END
-
-// TEST DB USER START
-
-void test_user_db_create_table(void) {
-    const char *test_userdb_filename = "test_user_db.db";
-    database test_user_db;
-    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
-
-    setup_cleanup(test_userdb_filename, &test_user_db);
+// Collects the batch ids found by foodbatch_db_expiring_between
+struct test_batch_ids {
+    int ids[8];
+    int count;
+};
 
-    printf("Testing user_db_create_table...\n");
+static int test_collect_batch_ids(void *ctx, const struct foodbatch *foodbatch) {
+    struct test_batch_ids *found = ctx;
+    if (found->count < 8) {
+        found->ids[found->count++] = foodbatch->batch_id;
+    }
+    return 0;
+}
 
-    // Verify admin user was created
-    bool admin_exists = user_db_check_exists(&test_user_db, "admin");
-    assert(admin_exists);
-    printf("Admin user created successfully.\n");
+void test_foodbatch_db_expiring_between(void) {
+    const char *test_foodbatch_filename = "test_foodbatch_db.db";
+    database test_foodbatch_db;
 
-    // Verify table structure by trying to insert a user
-    int rc = user_db_create_user(
-        &test_user_db,
-        "testuser",      // username
-        "12345678901",   // cpf (sample)
-        "5551900100200", // phone number
-        false            // is_admin
+    printf("Creating a FoodBatch table with TEXT dates...\n");
+    db_init(&test_foodbatch_db, test_foodbatch_filename);
+    setup_cleanup(test_foodbatch_filename, &test_foodbatch_db);
+    int rc = sqlite3_exec(
+        test_foodbatch_db.db,
+        "CREATE TABLE FoodBatch (BatchId INTEGER PRIMARY KEY, Name TEXT, Quantity INTEGER NOT NULL,"
+        "IsPerishable INTEGER NOT NULL, ExpirationDate TEXT, DailyConsumptionRate REAL);"
+        "INSERT INTO FoodBatch VALUES (1, 'Milk', 10, 1, '2024-03-10', 2.0);"
+        "INSERT INTO FoodBatch VALUES (2, 'Rice', 5, 0, '2025-01-01', 1.0);",
+        0,
+        0,
+        0
     );
     assert(rc == SQLITE_OK);
-    printf("Table structure is correct.\n");
+    db_deinit(&test_foodbatch_db);
+
+    printf("Migrating...\n");
+    rc = db_init_with_tbl(&test_foodbatch_db, test_foodbatch_filename, foodbatch_db_create_table);
+    assert(rc == SQLITE_OK);
+    assert(!db_table_has_column(&test_foodbatch_db, "FoodBatch", "ExpirationDate", "TEXT"));
+
+    struct foodbatch foodbatch = { 0 };
+    assert(foodbatch_db_get_by_batchid(&test_foodbatch_db, 1, &foodbatch) == SQLITE_OK);
+    assert(foodbatch.expiration_day == date_to_days(2024, 3, 10));
+    assert(strcmp(foodbatch.expiration_date, "2024-03-10") == 0);
+    printf("Text dates converted to day numbers.\n");
+
+    printf("Testing the API boundary...\n");
+    assert(foodbatch_db_insert(&test_foodbatch_db, 3, "Beans", 8, false, "2024-02-30", 1) == SQLITE_MISMATCH);
+    assert(foodbatch_db_insert(&test_foodbatch_db, 3, "Beans", 8, false, "", 1) == SQLITE_OK);
+    assert(foodbatch_db_get_by_batchid(&test_foodbatch_db, 3, &foodbatch) == SQLITE_OK);
+    assert(foodbatch.expiration_day == DATE_INVALID);
+    assert(foodbatch.expiration_date[0] == '\0');
+    assert(foodbatch_db_insert(&test_foodbatch_db, 4, "Bread", 3, true, "2024-03-01", 3) == SQLITE_OK);
+    assert(foodbatch_db_update(&test_foodbatch_db, 4, "", 0, true, "03/01/2024", -1) == SQLITE_MISMATCH);
+    assert(foodbatch_db_update(&test_foodbatch_db, 4, "", 5, true, "", -1) == SQLITE_OK);
+    assert(foodbatch_db_get_by_batchid(&test_foodbatch_db, 4, &foodbatch) == SQLITE_OK);
+    assert(strcmp(foodbatch.expiration_date, "2024-03-01") == 0);
+    printf("Invalid dates rejected, empty date stored as none and preserved on update.\n");
+
+    printf("Testing foodbatch_db_expiring_between...\n");
+    struct test_batch_ids found = { 0 };
+    int count = foodbatch_db_expiring_between(
+        &test_foodbatch_db,
+        date_parse("2024-03-01"),
+        date_parse("2024-03-10"),
+        test_collect_batch_ids,
+        &found
+    );
+    assert(count == 2);
+    assert(found.ids[0] == 4);
+    assert(found.ids[1] == 1);
+    printf("Range is inclusive, ordered by expiration and skips batches without a date.\n");
 
     teardown_cleanup();
 
-    printf("user_db_create_table test passed successfully.\n");
+    printf("foodbatch_db_expiring_between test passed successfully.\n");
 }
 
-void test_user_db_create_user(void) {
-    const char *test_userdb_filename = "test_user_db.db";
-    database test_user_db;
-    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+void test_expiration_alerts(void) {
+    const char *test_foodbatch_filename = "test_foodbatch_db.db";
+    database test_foodbatch_db;
+    db_init_with_tbl(&test_foodbatch_db, test_foodbatch_filename, foodbatch_db_create_table);
+    setup_cleanup(test_foodbatch_filename, &test_foodbatch_db);
 
-    setup_cleanup(test_userdb_filename, &test_user_db);
+    printf("Testing expiration_alerts_load...\n");
+    foodbatch_db_insert(&test_foodbatch_db, 1, "Milk", 10, true, "2024-03-10", 2);
+    foodbatch_db_insert(&test_foodbatch_db, 2, "Rice", 5, false, "0001-01-01", 3); // Not perishable
+    foodbatch_db_insert(&test_foodbatch_db, 3, "Tomatoes", 20, true, "2024-03-05", 1);
+    foodbatch_db_insert(&test_foodbatch_db, 4, "Yogurt", 0, true, "2024-03-01", 1); // Out of stock
+
+    struct expiration_alerts *ea = expiration_alerts_load(&test_foodbatch_db, NULL);
+    assert(ea);
+    const struct expiration_alert *next = expiration_alerts_next(ea);
+    assert(next && next->id == 3 && next->source == EXPIRATION_FOOD);
+    assert(strcmp(next->name, "Tomatoes") == 0);
+    assert(expiration_alerts_count_due(ea, date_parse("2024-12-31")) == 2);
+    printf("Only perishable batches in stock are loaded.\n");
+
+    printf("Testing incremental changes...\n");
+    unsigned version = expiration_alerts_version(ea);
+    assert(expiration_alerts_set(ea, EXPIRATION_MEDICATION, 3, "Paracetamol", date_parse("2024-03-07")));
+    assert(expiration_alerts_version(ea) != version);
+    assert(expiration_alerts_count_due(ea, date_parse("2024-03-07")) == 2);
+
+    // Committed batch changes reach the set on dispatch, nothing else to call
+    foodbatch_db_update(&test_foodbatch_db, 1, "", 0, true, "2024-03-02", -1);
+    assert(expiration_alerts_next(ea)->id == 3);
+    assert(db_changes_dispatch() == 1);
+    next = expiration_alerts_next(ea);
+    assert(next && next->id == 1 && next->day == date_parse("2024-03-02"));
+
+    struct expiration_alert due[2];
+    assert(expiration_alerts_due(ea, date_parse("2024-12-31"), due, 2) == 2);
+    assert(due[0].id == 1 && due[1].id == 3 && due[1].source == EXPIRATION_FOOD);
+
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 10) == SQLITE_OK); // Out of stock
+    foodbatch_db_delete_by_id(&test_foodbatch_db, 3);
+    assert(db_changes_dispatch() == 2);
+    expiration_alerts_remove(ea, EXPIRATION_FOOD, 99); // Unknown, ignored
+    next = expiration_alerts_next(ea);
+    assert(next && next->source == EXPIRATION_MEDICATION && next->id == 3);
+    printf("Set, batch changes and remove keep the soonest item on top.\n");
+
+    // A reset reloads the batches, whatever wrote them
+    sqlite3 *other;
+    assert(sqlite3_open(test_foodbatch_filename, &other) == SQLITE_OK);
+    assert(
+        sqlite3_exec(
+            other,
+            "UPDATE FoodBatch SET Quantity = 3 WHERE BatchId = 4;"
+            "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable, ExpirationDate) "
+            "VALUES (5, 'Eggs', 6, 1, 0);",
+            0,
+            0,
+            0
+        )
+        == SQLITE_OK
+    );
+    sqlite3_close(other);
+    db_changes_publish("FoodBatch", DB_CHANGE_RESET, 0);
+    assert(db_changes_dispatch() == 1);
+    next = expiration_alerts_next(ea);
+    assert(next && next->source == EXPIRATION_FOOD && next->id == 5 && next->day == 0);
+    assert(expiration_alerts_count_due(ea, date_parse("2024-12-31")) == 3); // Eggs, Yogurt, Paracetamol
+    printf("Resets reload the food batches.\n");
+
+    // The model starts from an empty set
+    expiration_alerts_remove(ea, EXPIRATION_FOOD, 4);
+    expiration_alerts_remove(ea, EXPIRATION_FOOD, 5);
+
+    printf("Testing against a brute force model...\n");
+    int32_t model[500];
+    for (int i = 0; i < 500; i++) {
+        model[i] = DATE_INVALID;
+    }
+    expiration_alerts_remove(ea, EXPIRATION_MEDICATION, 3);
+    srand(42);
+    for (int step = 0; step < 20000; step++) {
+        int id = rand() % 500;
+        if (rand() % 4 == 0) {
+            expiration_alerts_remove(ea, EXPIRATION_FOOD, id);
+            model[id] = DATE_INVALID;
+        } else {
+            model[id] = 19000 + rand() % 1000;
+            assert(expiration_alerts_set(ea, EXPIRATION_FOOD, id, "Item", model[id]));
+        }
 
-    printf("Testing user_db_create_user...\n");
+        if (step % 500 == 0) {
+            int32_t until_day = 19000 + rand() % 1000;
+            int32_t soonest = DATE_INVALID;
+            int expected_due = 0;
+            for (int i = 0; i < 500; i++) {
+                if (model[i] == DATE_INVALID) {
+                    continue;
+                }
+                if (soonest == DATE_INVALID || model[i] < soonest) {
+                    soonest = model[i];
+                }
+                expected_due += model[i] <= until_day;
+            }
+            next = expiration_alerts_next(ea);
+            assert(soonest == DATE_INVALID ? next == NULL : (next && next->day == soonest));
+            assert(expiration_alerts_count_due(ea, until_day) == expected_due);
+
+            struct expiration_alert listed[16];
+            int written = expiration_alerts_due(ea, until_day, listed, 16);
+            assert(written == (expected_due < 16 ? expected_due : 16));
+            for (int i = 1; i < written; i++) {
+                assert(listed[i - 1].day <= listed[i].day);
+            }
+        }
+    }
+    printf("Heap matches the model.\n");
 
-    // Test creating a regular user
-    printf("Creating regular user 'user1'...\n");
-    int rc = user_db_create_user(&test_user_db, "user1", "00000000000", "1234567890123", false);
-    assert(rc == SQLITE_OK);
-    printf("Regular user created successfully.\n");
+    expiration_alerts_free(ea);
+    teardown_cleanup();
 
-    // Test creating an admin user
-    printf("Creating admin user 'admin2'...\n");
-    rc = user_db_create_user(&test_user_db, "admin2", "11111111111", "1234567890123", true);
-    assert(rc == SQLITE_OK);
-    printf("Admin user created successfully.\n");
+    printf("expiration_alerts test passed successfully.\n");
+}
 
-    // Test creating duplicate user
-    printf("Attempting to create duplicate user 'user1' by username...\n");
-    rc = user_db_create_user(&test_user_db, "user1", "87655366273", "", false);
-    assert(rc == SQLITE_CONSTRAINT);
-    printf("Duplicate user creation failed as expected.\n");
+static bool close_to(double a, double b) {
+    return fabs(a - b) <= 1e-3 * (fabs(b) > 1.0 ? fabs(b) : 1.0);
+}
 
-    printf("Attempting to create duplicate user by CPF...\n");
-    rc = user_db_create_user(&test_user_db, "user2", "00000000000", "", false);
-    assert(rc == SQLITE_CONSTRAINT);
-    printf("Duplicate user creation failed as expected.\n");
+void test_food_forecast(void) {
+    const char *test_foodbatch_filename = "test_foodbatch_db.db";
+    database test_foodbatch_db;
+    db_init_with_tbl(&test_foodbatch_db, test_foodbatch_filename, foodbatch_db_create_table);
+    setup_cleanup(test_foodbatch_filename, &test_foodbatch_db);
+
+    const char *test_resident_filename = "test_forecast_resident_db.db";
+    database test_resident_db;
+    db_init_with_tbl(&test_resident_db, test_resident_filename, resident_db_create_table);
+    resident_db_insert(&test_resident_db, "11111111200", "Ana Souza", 30, "", "", false, 2);
+    resident_db_insert(&test_resident_db, "22222222303", "Bruno Lima", 40, "", "", false, 1);
+
+    printf("Testing food_forecast_load...\n");
+    foodbatch_db_insert(&test_foodbatch_db, 1, "Arroz", 100, false, "", 0.5f);
+    foodbatch_db_insert(&test_foodbatch_db, 2, "arroz", 50, false, "", 0.2f); // Same name
+    foodbatch_db_insert(&test_foodbatch_db, 3, "Feijao", 30, false, "", 0.3f);
+    foodbatch_db_insert(&test_foodbatch_db, 4, "Sal", 10, false, "", 0.0f);  // Not consumed
+    foodbatch_db_insert(&test_foodbatch_db, 5, "Leite", 0, true, "", 1.0f);  // Out of stock
+
+    struct food_forecast *ff = food_forecast_load(&test_foodbatch_db, &test_resident_db);
+    assert(ff);
+
+    int32_t today = date_parse("2024-03-01");
+    struct food_forecast_summary summary;
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.residents == 2 && summary.batches == 4 && summary.names == 3);
+    assert(close_to(summary.total_quantity, 190.0));
+    assert(close_to(summary.daily_consumption, 1.4)); // (0.4 weighted Arroz + 0.3 Feijao) * 2
+    assert(close_to(summary.first_runout_days, 50.0)); // Feijao, Arroz alone would last 187.5
+    assert(summary.first_runout_day == today + (int32_t)floorf(summary.first_runout_days)); // 0.3f is just over 0.3
+    assert(strcmp(summary.first_runout_name, "Feijao") == 0);
+    assert(close_to(summary.shortest_batch_days, 50.0)); // Feijao: 30 / (0.3 * 2)
+
+    struct food_forecast_name names[4];
+    assert(food_forecast_names(ff, names, 4) == 3);
+    assert(strcmp(names[0].name, "Feijao") == 0 && close_to(names[0].days, 50.0));
+    assert(strcmp(names[1].name, "Arroz") == 0 && names[1].batches == 2);
+    assert(close_to(names[1].daily_rate, 0.4) && close_to(names[1].days, 187.5));
+    assert(strcmp(names[2].name, "Sal") == 0 && isinf(names[2].days));
+    printf("Batches in stock are grouped by name, the shortest supply first.\n");
+
+    printf("Testing incremental changes...\n");
+    unsigned version = food_forecast_version(ff);
+    food_forecast_set_residents(ff, 4);
+    assert(food_forecast_version(ff) != version);
+    assert(food_forecast_names(ff, names, 1) == 1 && close_to(names[0].days, 25.0));
+
+    struct foodbatch feijao = { .batch_id = 3, .name = "Feijao", .quantity = 60, .daily_consumption_rate = 0.3f };
+    assert(food_forecast_set_batch(ff, &feijao));
+    food_forecast_remove_batch(ff, 1);
+    food_forecast_remove_batch(ff, 99); // Unknown, ignored
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.batches == 3 && close_to(summary.total_quantity, 120.0));
+    assert(close_to(summary.daily_consumption, 2.0)); // (0.2 Arroz + 0.3 Feijao) * 4
+
+    struct foodbatch arroz = { .batch_id = 2, .name = "arroz", .quantity = 0, .daily_consumption_rate = 0.2f };
+    assert(food_forecast_set_batch(ff, &arroz)); // Emptied, removed
+    assert(food_forecast_names(ff, names, 4) == 2);
+    assert(strcmp(names[0].name, "Feijao") == 0 && close_to(names[0].days, 50.0));
+
+    int ids[4];
+    float days[4];
+    assert(food_forecast_batch_days(ff, ids, days, 4) == 2);
+    for (int i = 0; i < 2; i++) {
+        assert(ids[i] == 3 ? close_to(days[i], 50.0) : (ids[i] == 4 && isinf(days[i])));
+    }
+
+    food_forecast_set_residents(ff, 0);
+    food_forecast_summary(ff, today, &summary);
+    assert(isinf(summary.first_runout_days) && summary.first_runout_day == DATE_INVALID);
+    assert(summary.first_runout_name[0] == '\0');
+    printf("Batch and resident changes update the figures.\n");
+
+    printf("Testing against a brute force model...\n");
+    static float model_quantity[300];
+    static float model_rate[300];
+    for (int i = 0; i < 300; i++) {
+        food_forecast_remove_batch(ff, i);
+        model_quantity[i] = 0;
+    }
+    food_forecast_set_residents(ff, 7);
+    srand(31);
+    for (int step = 0; step < 5000; step++) {
+        struct foodbatch batch = { .batch_id = rand() % 300 };
+        snprintf(batch.name, sizeof(batch.name), "Food %d", batch.batch_id % 10);
+        batch.quantity = rand() % 4 == 0 ? 0 : 1 + rand() % 500;
+        batch.daily_consumption_rate = (float)(rand() % 100) / 50.0f;
+        assert(food_forecast_set_batch(ff, &batch));
+        model_quantity[batch.batch_id] = (float)batch.quantity;
+        model_rate[batch.batch_id] = batch.daily_consumption_rate;
+
+        if (step % 250 == 0) {
+            double name_quantity[10] = { 0 };
+            double name_rate_quantity[10] = { 0 };
+            double max_fraction = 0;
+            for (int i = 0; i < 300; i++) {
+                if (model_quantity[i] > 0) {
+                    name_quantity[i % 10] += model_quantity[i];
+                    name_rate_quantity[i % 10] += model_quantity[i] * model_rate[i];
+                    double fraction = model_rate[i] / model_quantity[i];
+                    max_fraction = fraction > max_fraction ? fraction : max_fraction;
+                }
+            }
+            double total = 0;
+            double rate = 0;
+            double first_runout = INFINITY;
+            for (int i = 0; i < 10; i++) {
+                total += name_quantity[i];
+                rate += name_quantity[i] > 0 ? name_rate_quantity[i] / name_quantity[i] : 0;
+                if (name_rate_quantity[i] > 0) {
+                    double days = name_quantity[i] * name_quantity[i] / (name_rate_quantity[i] * 7);
+                    first_runout = days < first_runout ? days : first_runout;
+                }
+            }
+
+            food_forecast_summary(ff, today, &summary);
+            assert(close_to(summary.total_quantity, total));
+            assert(close_to(summary.daily_consumption, rate * 7));
+            assert(
+                isinf(first_runout) ? isinf(summary.first_runout_days)
+                                    : close_to(summary.first_runout_days, first_runout)
+            );
+            assert(close_to(summary.shortest_batch_days, 1.0 / (max_fraction * 7)));
+        }
+    }
+    printf("Running totals match the model.\n");
+    food_forecast_free(ff);
+
+    printf("Testing the change subscriptions...\n");
+    ff = food_forecast_load(&test_foodbatch_db, &test_resident_db);
+    assert(ff);
+    db_changes_dispatch(); // The inserts above, already loaded
+    foodbatch_db_insert(&test_foodbatch_db, 6, "Feijao", 30, false, "", 0.3f);
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 100) == SQLITE_OK); // Emptied
+    assert(db_changes_dispatch() == 2);
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.batches == 4 && close_to(summary.total_quantity, 120.0));
+    assert(close_to(summary.first_runout_days, 100.0)); // Feijao, 60 / (0.3 * 2)
+
+    resident_db_insert(&test_resident_db, "33333333414", "Carla Dias", 50, "", "", false, 1);
+    assert(db_changes_dispatch() == 1);
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.residents == 2); // Counted by the refresh only
+    version = food_forecast_version(ff);
+    food_forecast_refresh(ff);
+    assert(food_forecast_version(ff) != version);
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.residents == 3 && close_to(summary.first_runout_days, 200.0 / 3));
+
+    assert(foodbatch_db_delete_by_id(&test_foodbatch_db, 6) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.batches == 3 && close_to(summary.first_runout_days, 100.0 / 3));
+
+    db_changes_publish("FoodBatch", DB_CHANGE_RESET, 0);
+    assert(db_changes_dispatch() == 1);
+    food_forecast_summary(ff, today, &summary);
+    assert(summary.batches == 3 && close_to(summary.total_quantity, 90.0));
+    food_forecast_free(ff);
+    printf("Batch and resident commits reach the forecast.\n");
+
+    printf("Timing 100000 batches...\n");
+    ff = food_forecast_load(&test_foodbatch_db, NULL);
+    assert(ff);
+    food_forecast_set_residents(ff, 150);
+    for (int i = 0; i < 100000; i++) {
+        struct foodbatch batch = { .batch_id = 1000 + i, .quantity = 1 + i % 1000 };
+        snprintf(batch.name, sizeof(batch.name), "Food %d", i % 500);
+        batch.daily_consumption_rate = (float)(i % 7) / 10.0f;
+        assert(food_forecast_set_batch(ff, &batch));
+    }
+    static float batch_days[100000];
+    clock_t start = clock();
+    for (int i = 0; i < 100; i++) {
+        food_forecast_summary(ff, today, &summary);
+        assert(food_forecast_batch_days(ff, NULL, batch_days, 100000) == 100000);
+    }
+    printf(
+        "Summary and per-batch days of 100000 batches: %.3f ms\n",
+        (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC / 100
+    );
+    food_forecast_free(ff);
 
+    db_deinit(&test_resident_db);
+    remove(test_resident_filename);
     teardown_cleanup();
 
-    printf("user_db_create_user test passed successfully.\n");
+    printf("food_forecast test passed successfully.\n");
 }
 
-void test_user_db_authenticate(void) {
-    const char *test_userdb_filename = "test_user_db.db";
-    database test_user_db;
-    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+void test_foodbatch_db_take_quantity(void) {
+    const char *test_foodbatch_filename = "test_foodbatch_db.db";
+    database test_foodbatch_db;
+    db_init_with_tbl(&test_foodbatch_db, test_foodbatch_filename, foodbatch_db_create_table);
+    setup_cleanup(test_foodbatch_filename, &test_foodbatch_db);
 
-    setup_cleanup(test_userdb_filename, &test_user_db);
+    printf("Testing foodbatch_db_take_quantity...\n");
+    foodbatch_db_insert(&test_foodbatch_db, 1, "Arroz", 10, false, "", 0.5f);
 
-    printf("Testing user_db_authenticate...\n");
+    struct foodbatch foodbatch = { 0 };
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 4) == SQLITE_OK);
+    foodbatch_db_get_by_batchid(&test_foodbatch_db, 1, &foodbatch);
+    assert(foodbatch.quantity == 6);
 
-    // Create a test user with known password
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 7) == SQLITE_CONSTRAINT);
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 2, 1) == SQLITE_NOTFOUND);
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 0) == SQLITE_MISUSE);
+    assert(foodbatch_db_take_quantity(&test_foodbatch_db, 1, 6) == SQLITE_OK);
+    foodbatch_db_get_by_batchid(&test_foodbatch_db, 1, &foodbatch);
+    assert(foodbatch.quantity == 0);
+    printf("Quantity is taken only when there is enough stock.\n");
+
+    teardown_cleanup();
+
+    printf("foodbatch_db_take_quantity test passed successfully.\n");
+}
+
+void test_food_plan(void) {
+    const char *test_foodbatch_filename = "test_foodbatch_db.db";
+    database test_foodbatch_db;
+    db_init_with_tbl(&test_foodbatch_db, test_foodbatch_filename, foodbatch_db_create_table);
+    setup_cleanup(test_foodbatch_filename, &test_foodbatch_db);
+
+    printf("Testing food_plan_build...\n");
+    foodbatch_db_insert(&test_foodbatch_db, 1, "Leite", 10, true, "2024-03-20", 1);
+    foodbatch_db_insert(&test_foodbatch_db, 2, "leite", 8, true, "2024-03-05", 1);
+    foodbatch_db_insert(&test_foodbatch_db, 3, "Leite", 50, true, "2024-02-20", 1); // Expired
+    foodbatch_db_insert(&test_foodbatch_db, 4, "Leite", 30, false, "0001-01-01", 1); // Does not expire
+    foodbatch_db_insert(&test_foodbatch_db, 5, "Feijão", 5, true, "2024-03-10", 1);
+    foodbatch_db_insert(&test_foodbatch_db, 6, "Arroz", 100, false, "", 1); // Not requested
+
+    struct food_request requests[3] = {
+        { .name = "LEITE", .quantity = 20 },
+        { .name = "Feijao", .quantity = 9 },
+        { .name = "leite", .quantity = 5 }, // Same queue as the first request
+    };
+    int32_t today = date_parse("2024-03-01");
+
+    struct food_plan plan = { 0 };
+    assert(food_plan_build(&test_foodbatch_db, requests, 3, today, &plan) == SQLITE_OK);
+    assert(plan.pick_count == 5);
+    assert(plan.picks[0].batch_id == 2 && plan.picks[0].quantity == 8 && plan.picks[0].remaining == 0);
+    assert(plan.picks[1].batch_id == 1 && plan.picks[1].quantity == 10 && plan.picks[1].remaining == 0);
+    assert(plan.picks[2].batch_id == 4 && plan.picks[2].quantity == 2 && plan.picks[2].remaining == 28);
+    assert(plan.picks[2].expiration_day == DATE_INVALID);
+    assert(plan.picks[3].batch_id == 5 && plan.picks[3].request == 1 && plan.picks[3].quantity == 5);
+    assert(plan.picks[4].batch_id == 4 && plan.picks[4].request == 2 && plan.picks[4].remaining == 23);
+    assert(plan.allocated[0] == 20 && plan.allocated[1] == 5 && plan.allocated[2] == 5);
+    assert(plan.requested_total == 34 && plan.allocated_total == 30);
+    printf("Batches are picked first-expire-first-out, skipping expired ones.\n");
+
+    char pick_list[512 + 512 * 8];
+    assert(food_plan_format(&plan, requests, pick_list, sizeof(pick_list)) > 0);
+    assert(strstr(pick_list, "Short: Feijao, 5 of 9"));
+    assert(food_plan_format(&plan, requests, pick_list, 64) == -1);
+
+    printf("Testing food_plan_apply...\n");
+    assert(food_plan_apply(&test_foodbatch_db, &plan) == SQLITE_OK);
+    struct foodbatch foodbatch = { 0 };
+    foodbatch_db_get_by_batchid(&test_foodbatch_db, 4, &foodbatch);
+    assert(foodbatch.quantity == 23);
+    foodbatch_db_get_by_batchid(&test_foodbatch_db, 3, &foodbatch);
+    assert(foodbatch.quantity == 50); // Expired, untouched
+
+    // Applying the same plan again finds batch 2 empty and changes nothing
+    assert(food_plan_apply(&test_foodbatch_db, &plan) == SQLITE_CONSTRAINT);
+    foodbatch_db_get_by_batchid(&test_foodbatch_db, 4, &foodbatch);
+    assert(foodbatch.quantity == 23);
+    printf("Picks are applied in one transaction, a stale plan is rolled back.\n");
+
+    printf("Timing a shelter-wide plan...\n");
+    for (int i = 0; i < 500; i++) {
+        char name[32];
+        char date[DATE_STR_LEN];
+        snprintf(name, sizeof(name), "Food %d", i % 50);
+        date_format(today + (i * 37) % 90, date);
+        foodbatch_db_insert(&test_foodbatch_db, 100 + i, name, 20 + i % 80, true, date, 0.5f);
+    }
+    struct food_request daily[50];
+    for (int i = 0; i < 50; i++) {
+        snprintf(daily[i].name, sizeof(daily[i].name), "Food %d", i);
+        daily[i].quantity = 1500; // 3000 residents at 0.5 per day
+    }
+    clock_t start = clock();
+    assert(food_plan_build(&test_foodbatch_db, daily, 50, today, &plan) == SQLITE_OK);
+    printf("Plan of 50 names over 500 batches: %.3f ms\n", (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+    for (int i = 1; i < plan.pick_count; i++) {
+        if (plan.picks[i].request == plan.picks[i - 1].request) {
+            assert(plan.picks[i - 1].expiration_day <= plan.picks[i].expiration_day);
+        }
+    }
+
+    food_plan_free(&plan);
+    teardown_cleanup();
+
+    printf("food_plan test passed successfully.\n");
+}
+
+// TEST DB FOODBATCH END
+
+// TEST DB MEDICATION START
+
+struct test_dispense_log {
+    struct medication_dispense *entries;
+    int count;
+    int max;
+};
+
+static int test_collect_dispenses(void *ctx, const struct medication_dispense *dispense) {
+    struct test_dispense_log *log = ctx;
+    if (log->count < log->max) {
+        log->entries[log->count++] = *dispense;
+    }
+    return 0;
+}
+
+void test_medication_db(void) {
+    const char *test_medication_filename = "test_medication_db.db";
+    database test_medication_db;
+    db_init_with_tbl(&test_medication_db, test_medication_filename, medication_db_create_table);
+    setup_cleanup(test_medication_filename, &test_medication_db);
+
+    printf("Testing medication_db_insert...\n");
+    int id = 0;
+    assert(
+        medication_db_insert(&test_medication_db, "Tylenol", "Paracetamol", "Tablet", "500mg", "Tablet", 20, "2030-01-31", "", &id)
+        == SQLITE_OK
+    );
+    assert(id > 0);
+    assert(
+        medication_db_insert(&test_medication_db, "Tylenol", "", "Tablet", "500mg", "", 5, "", "", NULL)
+        == SQLITE_CONSTRAINT
+    );
+    assert(
+        medication_db_insert(&test_medication_db, "Tylenol", "", "Syrup", "5mg/ml", "ml", 5, "2030-02-30", "", NULL)
+        == SQLITE_MISMATCH
+    );
+    int syrup_id = 0;
+    assert(
+        medication_db_insert(&test_medication_db, "Tylenol", "", "Syrup", "5mg/ml", "ml", 100, "", "", &syrup_id)
+        == SQLITE_OK
+    );
+    assert(medication_db_get_count(&test_medication_db) == 2);
+
+    struct medication medication = { 0 };
+    assert(medication_db_get_by_id(&test_medication_db, id, &medication) == SQLITE_OK);
+    assert(strcmp(medication.generic_name, "Paracetamol") == 0 && medication.stock == 20);
+    assert(strcmp(medication.expiration_date, "2030-01-31") == 0);
+    assert(medication_db_get_by_id(&test_medication_db, syrup_id, &medication) == SQLITE_OK);
+    assert(medication.expiration_date[0] == '\0' && medication.expiration_day == DATE_INVALID);
+    assert(medication_db_get_by_id(&test_medication_db, 999, &medication) == SQLITE_NOTFOUND);
+
+    printf("Testing medication_db_update...\n");
+    assert(medication_db_update(&test_medication_db, id, "", "", "", "", "", 30, "", "Take with water") == SQLITE_OK);
+    assert(medication_db_get_by_id(&test_medication_db, id, &medication) == SQLITE_OK);
+    assert(strcmp(medication.name, "Tylenol") == 0 && medication.stock == 30);
+    assert(strcmp(medication.expiration_date, "2030-01-31") == 0 && strcmp(medication.notes, "Take with water") == 0);
+    assert(medication_db_update(&test_medication_db, 999, "X", "", "", "", "", -1, "", "") == SQLITE_NOTFOUND);
+    assert(medication_db_update(&test_medication_db, id, "", "", "", "", "", -1, "2030-13-01", "") == SQLITE_MISMATCH);
+
+    char table[512 + 512 * 2];
+    assert(medication_db_get_all_format(&test_medication_db, table, sizeof(table)) > 0);
+    assert(strstr(table, "Tylenol") && strstr(table, "5mg/ml") && strstr(table, "2030-01-31"));
+    assert(medication_db_get_all_format(&test_medication_db, table, 64) == -1);
+
+    printf("Testing medication_db_dispense...\n");
+    const char *cpf = "12345678909";
+    assert(medication_db_dispense(&test_medication_db, id, cpf, 10, 1000) == SQLITE_OK);
+    assert(medication_db_dispense(&test_medication_db, id, cpf, 21, 1001) == SQLITE_CONSTRAINT);
+    assert(medication_db_dispense(&test_medication_db, 999, cpf, 1, 1002) == SQLITE_NOTFOUND);
+    assert(medication_db_dispense(&test_medication_db, id, cpf, 0, 1003) == SQLITE_MISUSE);
+    assert(medication_db_dispense(&test_medication_db, id, "abc", 1, 1004) == SQLITE_MISMATCH);
+    assert(medication_db_dispense(&test_medication_db, syrup_id, cpf, 15, 2000) == SQLITE_OK);
+    assert(medication_db_dispense(&test_medication_db, id, "10987654357", 20, 3000) == SQLITE_OK);
+    assert(medication_db_get_by_id(&test_medication_db, id, &medication) == SQLITE_OK);
+    assert(medication.stock == 0); // 30 - 10 - 20, the failed ones took nothing
+    assert(medication_db_dispense(&test_medication_db, id, cpf, 1, 3001) == SQLITE_CONSTRAINT);
+    printf("Stock is decremented only when there is enough, together with the log entry.\n");
+
+    struct medication_dispense log[4];
+    struct test_dispense_log collected = { log, 0, 4 };
+    assert(medication_db_dispensed_to(&test_medication_db, cpf, 0, test_collect_dispenses, &collected) == 2);
+    assert(collected.count == 2);
+    assert(log[0].medication_id == syrup_id && log[0].quantity == 15 && log[0].dispensed_at == 2000);
+    assert(log[1].medication_id == id && log[1].quantity == 10 && strcmp(log[1].medication_name, "Tylenol") == 0);
+    assert(strcmp(log[1].cpf, cpf) == 0);
+    collected.count = 0;
+    assert(medication_db_dispensed_to(&test_medication_db, cpf, 1, test_collect_dispenses, &collected) == 1);
+    assert(log[0].dispensed_at == 2000);
+    assert(medication_db_dispensed_to(&test_medication_db, "00000000000", 0, NULL, NULL) == 0);
+
+    printf("Testing medication_db schedules...\n");
+    struct medication_schedule schedule = { 0 };
+    snprintf(schedule.cpf, sizeof(schedule.cpf), "%s", cpf);
+    schedule.medication_id = id;
+    schedule.quantity = 1;
+    schedule.first_minute = 100;
+    schedule.interval_minutes = 480;
+    assert(medication_db_schedule_insert(&test_medication_db, &schedule) == SQLITE_OK);
+    assert(schedule.id > 0 && schedule.given_minute == -1);
+    int first_schedule = schedule.id;
+    schedule.medication_id = syrup_id;
+    assert(medication_db_schedule_insert(&test_medication_db, &schedule) == SQLITE_OK);
+    schedule.medication_id = 999;
+    assert(medication_db_schedule_insert(&test_medication_db, &schedule) == SQLITE_NOTFOUND);
+    schedule.medication_id = id;
+    schedule.quantity = 0;
+    assert(medication_db_schedule_insert(&test_medication_db, &schedule) == SQLITE_MISUSE);
+    assert(medication_db_schedule_set_given(&test_medication_db, first_schedule, 580) == SQLITE_OK);
+    assert(medication_db_schedule_set_given(&test_medication_db, 999, 580) == SQLITE_NOTFOUND);
+    assert(medication_db_schedules(&test_medication_db, NULL, NULL) == 2);
+
+    printf("Testing medication_db_delete_by_id...\n");
+    assert(medication_db_delete_by_id(&test_medication_db, id) == SQLITE_OK);
+    assert(medication_db_delete_by_id(&test_medication_db, id) == SQLITE_NOTFOUND);
+    assert(!medication_db_check_id_exists(&test_medication_db, id));
+    assert(medication_db_schedules(&test_medication_db, NULL, NULL) == 1); // Its schedule went with it
+    collected.count = 0;
+    assert(medication_db_dispensed_to(&test_medication_db, cpf, 0, test_collect_dispenses, &collected) == 2);
+    assert(log[1].medication_id == id && log[1].medication_name[0] == '\0'); // The log is kept
+
+    teardown_cleanup();
+
+    printf("medication_db test passed successfully.\n");
+}
+
+void test_dose_schedule(void) {
+    const char *test_medication_filename = "test_medication_db.db";
+    database test_medication_db;
+    db_init_with_tbl(&test_medication_db, test_medication_filename, medication_db_create_table);
+    setup_cleanup(test_medication_filename, &test_medication_db);
+
+    printf("Testing dose_schedule_load...\n");
+    int id = 0;
+    medication_db_insert(&test_medication_db, "Amoxil", "Amoxicillin", "Capsule", "500mg", "", 50, "", "", &id);
+
+    struct medication_schedule every_hour = { .cpf = "12345678909", .medication_id = id, .quantity = 1 };
+    every_hour.first_minute = 1000;
+    every_hour.interval_minutes = 60;
+    medication_db_schedule_insert(&test_medication_db, &every_hour);
+
+    struct medication_schedule once = { .cpf = "10987654357", .medication_id = id, .quantity = 2 };
+    once.first_minute = 2000;
+    medication_db_schedule_insert(&test_medication_db, &once);
+
+    struct medication_schedule half_hour = { .cpf = "11111111111", .medication_id = id, .quantity = 1 };
+    half_hour.first_minute = 900;
+    half_hour.interval_minutes = 30;
+    medication_db_schedule_insert(&test_medication_db, &half_hour);
+    medication_db_schedule_set_given(&test_medication_db, half_hour.id, 960);
+
+    struct dose_schedule *ds = dose_schedule_load(&test_medication_db, 1010);
+    assert(ds);
+    assert(dose_schedule_count(ds) == 3);
+
+    struct dose_reminder due[4];
+    assert(dose_schedule_due_count(ds) == 2);
+    assert(dose_schedule_due(ds, due, 4) == 2);
+    assert(due[0].schedule_id == half_hour.id && due[0].due_minute == 990); // Doses up to 960 were given
+    assert(due[1].schedule_id == every_hour.id && due[1].due_minute == 1000);
+    assert(strcmp(due[1].cpf, "12345678909") == 0 && due[1].medication_id == id);
+    assert(dose_schedule_due(ds, due, 1) == 1 && due[0].schedule_id == half_hour.id);
+    printf("Doses due while the app was closed are reminded once, after the last one given.\n");
+
+    printf("Testing dose_schedule_advance...\n");
+    unsigned version = dose_schedule_version(ds);
+    assert(dose_schedule_advance(ds, 1010) == 0 && dose_schedule_version(ds) == version);
+    assert(dose_schedule_advance(ds, 1059) == 1); // Half hour at 1020, collapsed into 1050
+    assert(dose_schedule_due(ds, due, 4) == 2);
+    assert(due[0].schedule_id == every_hour.id && due[1].schedule_id == half_hour.id && due[1].due_minute == 1050);
+
+    assert(dose_schedule_acknowledge(ds, every_hour.id) == 1000);
+    assert(dose_schedule_acknowledge(ds, every_hour.id) == -1);
+    assert(dose_schedule_due_count(ds) == 1);
+    assert(dose_schedule_advance(ds, 1060) == 1);
+    assert(dose_schedule_due(ds, due, 4) == 2 && due[1].schedule_id == every_hour.id && due[1].due_minute == 1060);
+
+    assert(dose_schedule_advance(ds, 1999) > 0);
+    assert(dose_schedule_due_count(ds) == 2);
+    assert(dose_schedule_advance(ds, 2000) > 0);
+    assert(dose_schedule_due(ds, due, 4) == 3);
+    assert(due[2].schedule_id == once.id && due[2].due_minute == 2000 && due[2].quantity == 2);
+    assert(dose_schedule_acknowledge(ds, once.id) == 2000);
+    assert(dose_schedule_advance(ds, 100000) > 0);
+    assert(dose_schedule_due(ds, due, 4) == 2); // A single dose is reminded once
+    assert(due[0].schedule_id == half_hour.id && due[0].due_minute == 99990);
+    assert(due[1].schedule_id == every_hour.id && due[1].due_minute == 100000);
+
+    printf("Testing dose_schedule_add and dose_schedule_remove...\n");
+    struct medication_schedule later = { .cpf = "12345678909", .medication_id = id, .quantity = 1 };
+    later.first_minute = 100030;
+    later.interval_minutes = 1440;
+    medication_db_schedule_insert(&test_medication_db, &later);
+    assert(dose_schedule_add(ds, &later));
+    assert(!dose_schedule_add(ds, &later));
+    assert(dose_schedule_due_count(ds) == 2);
+    assert(dose_schedule_advance(ds, 100030) == 2); // Half hour and the new one
+    assert(dose_schedule_due_count(ds) == 3);
+    dose_schedule_remove(ds, half_hour.id);
+    dose_schedule_remove(ds, half_hour.id);
+    assert(dose_schedule_count(ds) == 3 && dose_schedule_due_count(ds) == 2);
+    assert(dose_schedule_advance(ds, 100060) == 1); // Every hour only
+    dose_schedule_remove_medication(ds, id);
+    assert(dose_schedule_count(ds) == 0 && dose_schedule_due_count(ds) == 0);
+    assert(dose_schedule_advance(ds, 200000) == 0);
+    dose_schedule_free(ds);
+
+    // A reload only reminds of doses after the ones acknowledged and saved
+    medication_db_schedule_set_given(&test_medication_db, every_hour.id, 199980);
+    ds = dose_schedule_load(&test_medication_db, 200000);
+    assert(ds);
+    assert(dose_schedule_due(ds, due, 4) == 3);
+    assert(due[0].schedule_id == once.id && due[0].due_minute == 2000);
+    assert(due[1].schedule_id == later.id && due[1].due_minute == 100030 + 69 * 1440);
+    assert(due[2].schedule_id == half_hour.id && due[2].due_minute == 199980); // Only removed from memory
+    dose_schedule_free(ds);
+
+    printf("Timing reminders for many schedules...\n");
+    ds = dose_schedule_load(&test_medication_db, 0);
+    assert(ds);
+    for (int i = 0; i < 10000; i++) {
+        struct medication_schedule schedule = { .id = 1000 + i, .cpf = "12345678909", .medication_id = id, .quantity = 1 };
+        schedule.first_minute = 60 + i % 1440;
+        schedule.interval_minutes = 240 + (i % 4) * 240;
+        schedule.given_minute = -1;
+        assert(dose_schedule_add(ds, &schedule));
+    }
+    clock_t start = clock();
+    int fired = 0;
+    for (int64_t minute = 1; minute <= 7 * 1440; minute++) {
+        fired += dose_schedule_advance(ds, minute);
+        for (int frame = 0; frame < 60; frame++) {
+            fired += dose_schedule_advance(ds, minute); // Same minute, every frame
+        }
+    }
+    printf(
+        "A week of frames over 10000 schedules: %.3f ms, %d doses came due\n",
+        (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC,
+        fired
+    );
+    assert(fired > 10000);
+    dose_schedule_free(ds);
+
+    teardown_cleanup();
+
+    printf("dose_schedule test passed successfully.\n");
+}
+
+// TEST DB MEDICATION END
+
+// TEST DB CLOTHES START
+
+void test_clothes_db(void) {
+    const char *test_clothes_filename = "test_clothes_db.db";
+    database test_clothes_db;
+    db_init_with_tbl(&test_clothes_db, test_clothes_filename, clothes_db_create_table);
+    setup_cleanup(test_clothes_filename, &test_clothes_db);
+
+    printf("Testing clothes_db_insert...\n");
+    int id = 0;
+    assert(clothes_db_insert(&test_clothes_db, "T-shirt", "M", "male", "blue", 10, "new", "Donated", &id) == SQLITE_OK);
+    assert(id > 0);
+    assert(clothes_db_insert(&test_clothes_db, "T-shirt", "M", "male", "blue", 3, "new", "", NULL) == SQLITE_CONSTRAINT);
+    int pants_id = 0;
+    assert(clothes_db_insert(&test_clothes_db, "Pants", "", "other", "", 4, "worn", "", &pants_id) == SQLITE_OK);
+    assert(clothes_db_insert(&test_clothes_db, "Pants", "", "other", "", 1, "worn", "", NULL) == SQLITE_CONSTRAINT);
+    assert(clothes_db_get_count(&test_clothes_db) == 2);
+    assert(clothes_db_check_id_exists(&test_clothes_db, id));
+    assert(!clothes_db_check_id_exists(&test_clothes_db, 999));
+
+    struct clothes clothes = { 0 };
+    assert(clothes_db_get_by_id(&test_clothes_db, id, &clothes) == SQLITE_OK);
+    assert(strcmp(clothes.type, "T-shirt") == 0 && strcmp(clothes.size, "M") == 0 && clothes.quantity == 10);
+    assert(strcmp(clothes.condition, "new") == 0 && strcmp(clothes.notes, "Donated") == 0);
+    assert(clothes_db_get_by_id(&test_clothes_db, 999, &clothes) == SQLITE_NOTFOUND);
+
+    printf("Testing clothes_db_update...\n");
+    assert(clothes_db_update(&test_clothes_db, id, "", "L", "", "", -1, "good", "") == SQLITE_OK);
+    assert(clothes_db_get_by_id(&test_clothes_db, id, &clothes) == SQLITE_OK);
+    assert(strcmp(clothes.type, "T-shirt") == 0 && strcmp(clothes.size, "L") == 0 && clothes.quantity == 10);
+    assert(strcmp(clothes.condition, "good") == 0 && strcmp(clothes.notes, "Donated") == 0);
+    assert(clothes_db_update(&test_clothes_db, pants_id, "T-shirt", "L", "male", "blue", 0, "good", "") == SQLITE_CONSTRAINT);
+    assert(clothes_db_update(&test_clothes_db, 999, "X", "", "", "", -1, "", "") == SQLITE_NOTFOUND);
+
+    char table[512 + 512 * 2];
+    assert(clothes_db_get_all_format(&test_clothes_db, table, sizeof(table)) > 0);
+    assert(strstr(table, "T-shirt") && strstr(table, "Pants") && strstr(table, "worn"));
+    assert(clothes_db_get_all_format(&test_clothes_db, table, 64) == -1);
+
+    printf("Testing clothes_db_delete_by_id...\n");
+    assert(clothes_db_delete_by_id(&test_clothes_db, pants_id) == SQLITE_OK);
+    assert(clothes_db_delete_by_id(&test_clothes_db, pants_id) == SQLITE_NOTFOUND);
+    assert(clothes_db_for_each(&test_clothes_db, NULL, NULL) == 1);
+
+    teardown_cleanup();
+
+    printf("clothes_db test passed successfully.\n");
+}
+
+static const char *const test_clothes_types[] = { "t-shirt", "pants", "coat", "dress", "socks" };
+static const char *const test_clothes_sizes[] = { "XS", "S", "M", "L", "XL", "XXL", "kids", "42" };
+static const char *const test_clothes_genders[] = { "other", "male", "female" };
+static const char *const test_clothes_colors[] = { "blue", "black", "red", "white", "green", "gray" };
+static const char *const test_clothes_conditions[] = { "new", "good", "worn", "needs repair" };
+
+#define TEST_CLOTHES_COUNT(values) ((int)(sizeof(values) / sizeof((values)[0])))
+
+// Attribute values of a SKU as indexes in the arrays above, quantity 0 if not in stock
+struct test_clothes_sku {
+    int type, size, gender, color, condition, quantity;
+};
+
+static void test_clothes_fill(struct clothes *clothes, int id, const struct test_clothes_sku *sku) {
+    memset(clothes, 0, sizeof(*clothes));
+    clothes->id = id;
+    snprintf(clothes->type, sizeof(clothes->type), "%s", test_clothes_types[sku->type]);
+    snprintf(clothes->size, sizeof(clothes->size), "%s", test_clothes_sizes[sku->size]);
+    snprintf(clothes->gender, sizeof(clothes->gender), "%s", test_clothes_genders[sku->gender]);
+    snprintf(clothes->color, sizeof(clothes->color), "%s", test_clothes_colors[sku->color]);
+    snprintf(clothes->condition, sizeof(clothes->condition), "%s", test_clothes_conditions[sku->condition]);
+    clothes->quantity = sku->quantity;
+}
+
+static int test_compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+void test_clothes_index(void) {
+    const char *test_clothes_filename = "test_clothes_index.db";
+    database test_clothes_db;
+    db_init_with_tbl(&test_clothes_db, test_clothes_filename, clothes_db_create_table);
+    setup_cleanup(test_clothes_filename, &test_clothes_db);
+
+    printf("Testing clothes_index_load...\n");
+    int shirt = 0, coat = 0;
+    assert(clothes_db_insert(&test_clothes_db, "T-shirt", "M", "male", "blue", 10, "new", "", &shirt) == SQLITE_OK);
+    assert(clothes_db_insert(&test_clothes_db, "Coat", "m", "other", "black", 2, "good", "", &coat) == SQLITE_OK);
+    assert(clothes_db_insert(&test_clothes_db, "Coat", "L", "male", "black", 0, "good", "", NULL) == SQLITE_OK);
+    assert(clothes_db_insert(&test_clothes_db, "Dress", "M", "female", "red", 1, "worn", "", NULL) == SQLITE_OK);
+
+    struct clothes_index *ci = clothes_index_load(&test_clothes_db);
+    assert(ci);
+    assert(clothes_index_count(ci) == 3); // Out of stock coat not kept
+
+    // "Size M, male or other, condition good or better"
+    struct clothes_query q;
+    clothes_query_init(&q);
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_SIZE, "M"));
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_GENDER, "male"));
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_GENDER, "Other"));
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_CONDITION, "new"));
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_CONDITION, "good"));
+
+    int ids[8];
+    struct clothes_match match;
+    assert(clothes_index_match(ci, &q, ids, 8, &match) == 2);
+    assert(match.rows == 2 && match.total_quantity == 12);
+    qsort(ids, 2, sizeof(int), test_compare_ints);
+    assert(ids[0] == shirt && ids[1] == coat);
+    assert(clothes_index_match(ci, &q, ids, 1, &match) == 1 && match.rows == 2); // Totals count all
+
+    struct clothes clothes;
+    assert(clothes_index_row(ci, coat, &clothes));
+    assert(strcmp(clothes.type, "Coat") == 0 && strcmp(clothes.size, "M") == 0 && clothes.quantity == 2);
+    assert(!clothes_index_row(ci, 999, &clothes)); // "m" is read back as the "M" seen first
+
+    printf("Testing clothes_query_allow with unknown values...\n");
+    clothes_query_init(&q);
+    assert(clothes_index_match(ci, &q, NULL, 0, &match) == 0 && match.rows == 3); // No restriction
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_COLOR, "purple"));
+    assert(clothes_index_match(ci, &q, ids, 8, &match) == 0 && match.rows == 0);
+
+    printf("Testing clothes_index_set and remove...\n");
+    unsigned version = clothes_index_version(ci);
+    assert(clothes_db_get_by_id(&test_clothes_db, shirt, &clothes) == SQLITE_OK);
+    clothes.quantity = 0;
+    assert(clothes_index_set(ci, &clothes));
+    assert(clothes_index_count(ci) == 2 && clothes_index_version(ci) != version);
+    clothes.quantity = 5;
+    snprintf(clothes.color, sizeof(clothes.color), "purple");
+    assert(clothes_index_set(ci, &clothes));
+    assert(clothes_index_match(ci, &q, ids, 8, &match) == 0); // Query built before purple existed
+    clothes_query_init(&q);
+    assert(clothes_query_allow(&q, ci, CLOTHES_ATTR_COLOR, "Purple"));
+    assert(clothes_index_match(ci, &q, ids, 8, &match) == 1 && ids[0] == shirt && match.total_quantity == 5);
+    clothes_index_remove(ci, shirt);
+    clothes_index_remove(ci, shirt);
+    assert(clothes_index_match(ci, &q, ids, 8, &match) == 0);
+    assert(clothes_index_count(ci) == 2);
+    clothes_index_free(ci);
+
+    printf("Testing clothes_index_match against a brute force model...\n");
+    ci = clothes_index_load(&test_clothes_db);
+    assert(ci);
+    for (int id = 1; id <= 4; id++) {
+        clothes_index_remove(ci, id); // Only the random SKUs below
+    }
+
+    enum { SKUS = 30000 };
+    struct test_clothes_sku *model = calloc(SKUS + 1, sizeof(*model));
+    int *found = malloc(sizeof(int) * (SKUS + 1));
+    assert(model && found);
+
+    srand(34);
+    for (int step = 0; step < SKUS * 3; step++) {
+        int id = 1 + rand() % SKUS;
+        struct test_clothes_sku *sku = &model[id];
+        if (rand() % 5 == 0) {
+            sku->quantity = 0;
+            clothes_index_remove(ci, id);
+            continue;
+        }
+        sku->type = rand() % TEST_CLOTHES_COUNT(test_clothes_types);
+        sku->size = rand() % TEST_CLOTHES_COUNT(test_clothes_sizes);
+        sku->gender = rand() % TEST_CLOTHES_COUNT(test_clothes_genders);
+        sku->color = rand() % TEST_CLOTHES_COUNT(test_clothes_colors);
+        sku->condition = rand() % TEST_CLOTHES_COUNT(test_clothes_conditions);
+        sku->quantity = rand() % 4; // Some set to 0, which removes them
+        test_clothes_fill(&clothes, id, sku);
+        assert(clothes_index_set(ci, &clothes));
+    }
+
+    int in_stock = 0;
+    for (int id = 1; id <= SKUS; id++) {
+        in_stock += model[id].quantity > 0;
+    }
+    assert(clothes_index_count(ci) == in_stock);
+
+    clock_t matching = 0;
+    int queries = 0;
+    for (int round = 0; round < 300; round++) {
+        // Each attribute is left open or allows a random subset of its values
+        bool allowed[5][8] = { { false } };
+        bool restricted[5] = { false };
+        int counts[5] = {
+            TEST_CLOTHES_COUNT(test_clothes_types), TEST_CLOTHES_COUNT(test_clothes_sizes),
+            TEST_CLOTHES_COUNT(test_clothes_genders), TEST_CLOTHES_COUNT(test_clothes_colors),
+            TEST_CLOTHES_COUNT(test_clothes_conditions)
+        };
+        const char *const *values[5] = {
+            test_clothes_types, test_clothes_sizes, test_clothes_genders, test_clothes_colors, test_clothes_conditions
+        };
+        enum clothes_attribute attributes[5] = {
+            CLOTHES_ATTR_TYPE, CLOTHES_ATTR_SIZE, CLOTHES_ATTR_GENDER, CLOTHES_ATTR_COLOR, CLOTHES_ATTR_CONDITION
+        };
+
+        clothes_query_init(&q);
+        for (int a = 0; a < 5; a++) {
+            if (rand() % 2) {
+                continue;
+            }
+            for (int v = 0; v < counts[a]; v++) {
+                if (rand() % 3 == 0) {
+                    restricted[a] = true;
+                    allowed[a][v] = true;
+                    assert(clothes_query_allow(&q, ci, attributes[a], values[a][v]));
+                }
+            }
+        }
+
+        clock_t start = clock();
+        int written = clothes_index_match(ci, &q, found, SKUS + 1, &match);
+        matching += clock() - start;
+        queries++;
+
+        int expected_rows = 0, expected_quantity = 0;
+        for (int id = 1; id <= SKUS; id++) {
+            const struct test_clothes_sku *sku = &model[id];
+            int of[5] = { sku->type, sku->size, sku->gender, sku->color, sku->condition };
+            bool matches = sku->quantity > 0;
+            for (int a = 0; a < 5 && matches; a++) {
+                matches = !restricted[a] || allowed[a][of[a]];
+            }
+            if (matches) {
+                expected_rows++;
+                expected_quantity += sku->quantity;
+            }
+        }
+        assert(written == expected_rows && match.rows == expected_rows);
+        assert(match.total_quantity == expected_quantity);
+
+        for (int i = 0; i < written; i++) {
+            assert(clothes_index_row(ci, found[i], &clothes));
+            assert(model[found[i]].quantity == clothes.quantity);
+        }
+    }
+    printf(
+        "%d queries over %d SKUs: %.3f ms each\n",
+        queries,
+        in_stock,
+        (double)matching * 1000.0 / CLOCKS_PER_SEC / queries
+    );
+
+    free(model);
+    free(found);
+    clothes_index_free(ci);
+
+    teardown_cleanup();
+
+    printf("clothes_index test passed successfully.\n");
+}
+
+// TEST DB CLOTHES END
+
+// TEST DB SUPPLIES START
+
+// Checks the rollup of a category against a GROUP BY over the Supplies table
+static void test_supplies_check_total(database *db, const char *category, int items, long long quantity) {
+    struct supplies_category_total total;
+    int rc = supplies_db_get_category_total(db, category, &total);
+    if (items == 0) {
+        assert(rc == SQLITE_NOTFOUND);
+    } else {
+        assert(rc == SQLITE_OK);
+        assert(total.items == items && total.quantity == quantity);
+    }
+
+    sqlite3_stmt *stmt;
+    assert(
+        sqlite3_prepare_v2(
+            db->db,
+            "SELECT COUNT(*), COALESCE(SUM(Quantity), 0) FROM Supplies WHERE COALESCE(Category, '') = ?;",
+            -1,
+            &stmt,
+            0
+        )
+        == SQLITE_OK
+    );
+    sqlite3_bind_text(stmt, 1, category, -1, SQLITE_STATIC);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    assert(sqlite3_column_int(stmt, 0) == items && sqlite3_column_int64(stmt, 1) == quantity);
+    sqlite3_finalize(stmt);
+}
+
+static int test_supplies_count_categories(void *ctx, const struct supplies_category_total *total) {
+    (void)total;
+    (*(int *)ctx)++;
+    return 0;
+}
+
+void test_supplies_db(void) {
+    const char *test_supplies_filename = "test_supplies_db.db";
+    database test_supplies_db;
+    db_init_with_tbl(&test_supplies_db, test_supplies_filename, supplies_db_create_table);
+    setup_cleanup(test_supplies_filename, &test_supplies_db);
+
+    printf("Testing supplies_db_insert...\n");
+    int soap_id = 0;
+    assert(supplies_db_insert(&test_supplies_db, "Soap", "hygiene", "bar", "units", 20, "Donated", &soap_id) == SQLITE_OK);
+    assert(soap_id > 0);
+    assert(supplies_db_insert(&test_supplies_db, "Soap", "hygiene", "bar", "units", 5, "", NULL) == SQLITE_CONSTRAINT);
+    int towel_id = 0;
+    assert(supplies_db_insert(&test_supplies_db, "Towel", "hygiene", "", "units", 8, "", &towel_id) == SQLITE_OK);
+    int blanket_id = 0;
+    assert(supplies_db_insert(&test_supplies_db, "Blanket", "bedding", "double", "units", 3, "", &blanket_id) == SQLITE_OK);
+    assert(supplies_db_insert(&test_supplies_db, "Batteries", "", "AA", "packs", 0, "", NULL) == SQLITE_OK);
+    assert(supplies_db_get_count(&test_supplies_db) == 4);
+    assert(supplies_db_check_id_exists(&test_supplies_db, soap_id));
+    assert(!supplies_db_check_id_exists(&test_supplies_db, 999));
+    test_supplies_check_total(&test_supplies_db, "hygiene", 2, 28);
+    test_supplies_check_total(&test_supplies_db, "bedding", 1, 3);
+    test_supplies_check_total(&test_supplies_db, "", 1, 0);
+
+    struct supplies supplies = { 0 };
+    assert(supplies_db_get_by_id(&test_supplies_db, soap_id, &supplies) == SQLITE_OK);
+    assert(strcmp(supplies.name, "Soap") == 0 && strcmp(supplies.category, "hygiene") == 0);
+    assert(strcmp(supplies.unit, "units") == 0 && supplies.quantity == 20 && strcmp(supplies.notes, "Donated") == 0);
+    assert(supplies_db_get_by_id(&test_supplies_db, 999, &supplies) == SQLITE_NOTFOUND);
+
+    printf("Testing supplies_db_update...\n");
+    assert(supplies_db_update(&test_supplies_db, towel_id, "", "bedding", "", "", -1, "") == SQLITE_OK);
+    test_supplies_check_total(&test_supplies_db, "hygiene", 1, 20);
+    test_supplies_check_total(&test_supplies_db, "bedding", 2, 11);
+    assert(supplies_db_update(&test_supplies_db, blanket_id, "", "", "", "", 10, "") == SQLITE_OK);
+    assert(supplies_db_get_by_id(&test_supplies_db, blanket_id, &supplies) == SQLITE_OK);
+    assert(strcmp(supplies.name, "Blanket") == 0 && strcmp(supplies.size, "double") == 0 && supplies.quantity == 10);
+    test_supplies_check_total(&test_supplies_db, "bedding", 2, 18);
+    assert(supplies_db_update(&test_supplies_db, towel_id, "Soap", "hygiene", "bar", "", -1, "") == SQLITE_CONSTRAINT);
+    test_supplies_check_total(&test_supplies_db, "bedding", 2, 18);
+    assert(supplies_db_update(&test_supplies_db, 999, "X", "", "", "", -1, "") == SQLITE_NOTFOUND);
+
+    char table[512 + 512 * 4];
+    assert(supplies_db_get_all_format(&test_supplies_db, table, sizeof(table)) > 0);
+    assert(strstr(table, "Soap") && strstr(table, "Blanket") && strstr(table, "packs"));
+    assert(supplies_db_get_all_format(&test_supplies_db, table, 64) == -1);
+
+    printf("Testing supplies_db_delete_by_id...\n");
+    assert(supplies_db_delete_by_id(&test_supplies_db, soap_id) == SQLITE_OK);
+    assert(supplies_db_delete_by_id(&test_supplies_db, soap_id) == SQLITE_NOTFOUND);
+    test_supplies_check_total(&test_supplies_db, "hygiene", 0, 0);
+
+    int categories = 0;
+    assert(supplies_db_category_totals(&test_supplies_db, test_supplies_count_categories, &categories) == 2);
+    assert(categories == 2);
+
+    // A table created before the rollups gets its totals filled once on open
+    db_deinit(&test_supplies_db);
+    sqlite3 *raw;
+    assert(sqlite3_open(test_supplies_filename, &raw) == SQLITE_OK);
+    assert(sqlite3_exec(raw, "DROP TABLE SuppliesCategoryTotals;", 0, 0, 0) == SQLITE_OK);
+    sqlite3_close(raw);
+    assert(db_init_with_tbl(&test_supplies_db, test_supplies_filename, supplies_db_create_table) == SQLITE_OK);
+    test_supplies_check_total(&test_supplies_db, "bedding", 2, 18);
+    test_supplies_check_total(&test_supplies_db, "", 1, 0);
+
+    teardown_cleanup();
+
+    printf("supplies_db test passed successfully.\n");
+}
+
+void test_supplies_db_receive_shipment(void) {
+    const char *test_supplies_filename = "test_supplies_shipment.db";
+    database test_supplies_db;
+    db_init_with_tbl(&test_supplies_db, test_supplies_filename, supplies_db_create_table);
+    setup_cleanup(test_supplies_filename, &test_supplies_db);
+
+    printf("Testing supplies_db_receive_shipment...\n");
+
+    enum { ITEMS = 200, LINES = 400 };
+    int ids[ITEMS];
+    for (int i = 0; i < ITEMS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "Item %d", i);
+        assert(
+            supplies_db_insert(&test_supplies_db, name, i % 2 ? "odd" : "even", "", "units", 1, "", &ids[i])
+            == SQLITE_OK
+        );
+    }
+
+    // Every item twice, the lines of the same item add up
+    static struct supplies_line lines[LINES];
+    long long received = 0;
+    for (int i = 0; i < LINES; i++) {
+        lines[i].id = ids[i % ITEMS];
+        lines[i].quantity = i + 1;
+        received += i + 1;
+    }
+
+    clock_t start = clock();
+    int failed_line = 0;
+    assert(supplies_db_receive_shipment(&test_supplies_db, lines, LINES, &failed_line) == SQLITE_OK);
+    printf(
+        "Received %d lines in %.3f ms\n",
+        LINES,
+        (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC
+    );
+    assert(failed_line == -1);
+
+    struct supplies supplies;
+    assert(supplies_db_get_by_id(&test_supplies_db, ids[3], &supplies) == SQLITE_OK);
+    assert(supplies.quantity == 1 + 4 + (ITEMS + 4));
+    struct supplies_category_total even, odd;
+    assert(supplies_db_get_category_total(&test_supplies_db, "even", &even) == SQLITE_OK);
+    assert(supplies_db_get_category_total(&test_supplies_db, "odd", &odd) == SQLITE_OK);
+    assert(even.items == ITEMS / 2 && odd.items == ITEMS / 2);
+    assert(even.quantity + odd.quantity == ITEMS + received);
+
+    // A bad line leaves the stock as it was
+    lines[LINES / 2].id = 999999;
+    assert(supplies_db_receive_shipment(&test_supplies_db, lines, LINES, &failed_line) == SQLITE_NOTFOUND);
+    assert(failed_line == LINES / 2);
+    lines[LINES / 2].id = ids[0];
+    lines[LINES - 1].quantity = 0;
+    assert(supplies_db_receive_shipment(&test_supplies_db, lines, LINES, &failed_line) == SQLITE_MISUSE);
+    assert(failed_line == LINES - 1);
+
+    assert(supplies_db_get_by_id(&test_supplies_db, ids[3], &supplies) == SQLITE_OK);
+    assert(supplies.quantity == 1 + 4 + (ITEMS + 4));
+    assert(supplies_db_get_category_total(&test_supplies_db, "even", &even) == SQLITE_OK);
+    assert(supplies_db_get_category_total(&test_supplies_db, "odd", &odd) == SQLITE_OK);
+    assert(even.quantity + odd.quantity == ITEMS + received);
+
+    assert(supplies_db_receive_shipment(&test_supplies_db, lines, 0, &failed_line) == SQLITE_OK);
+
+    teardown_cleanup();
+
+    printf("supplies_db_receive_shipment test passed successfully.\n");
+}
+
+// TEST DB SUPPLIES END
+
+// TEST DATAGEN START
+
+// Whether a query returns the same rows on both databases
+static bool test_datagen_same_rows(database *a, database *b, const char *sql) {
+    sqlite3_stmt *sa;
+    sqlite3_stmt *sb;
+    assert(sqlite3_prepare_v2(a->db, sql, -1, &sa, 0) == SQLITE_OK);
+    assert(sqlite3_prepare_v2(b->db, sql, -1, &sb, 0) == SQLITE_OK);
+
+    bool same = true;
+    int rows = 0;
+    while (same) {
+        int ra = sqlite3_step(sa);
+        int rb = sqlite3_step(sb);
+        same = ra == rb;
+        if (!same || ra != SQLITE_ROW) {
+            break;
+        }
+        rows++;
+        for (int i = 0; same && i < sqlite3_column_count(sa); i++) {
+            const unsigned char *ta = sqlite3_column_text(sa, i);
+            const unsigned char *tb = sqlite3_column_text(sb, i);
+            same = (ta == NULL) == (tb == NULL) && (ta == NULL || strcmp((const char *)ta, (const char *)tb) == 0);
+        }
+    }
+
+    sqlite3_finalize(sa);
+    sqlite3_finalize(sb);
+    return same && rows > 0;
+}
+
+static int test_datagen_query_int(database *db, const char *sql) {
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0) == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    int value = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+static int test_compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int test_datagen_progress_calls = 0;
+
+static void test_datagen_progress(void *ctx, int done, int total) {
+    (void)ctx;
+    assert(done > 0 && done <= total);
+    test_datagen_progress_calls++;
+}
+
+void test_datagen_cpf(void) {
+    assert(resident_db_cpf_valid("52998224725"));
+    assert(!resident_db_cpf_valid("52998224724"));
+    assert(!resident_db_cpf_valid("11111111111"));
+    assert(!resident_db_cpf_valid("5299822472"));
+    assert(!resident_db_cpf_valid("529982247250"));
+    assert(!resident_db_cpf_valid("5299822472a"));
+
+    struct datagen gen;
+    datagen_init(&gen, 7);
+
+    // Valid and never repeated, for residents and users alike
+    enum { ROWS = 20000 };
+    int64_t *packed = malloc(sizeof(*packed) * ROWS * 2);
+    assert(packed);
+    for (int row = 1; row <= ROWS; row++) {
+        char cpf[MAX_CPF_LENGTH];
+        struct user user;
+        datagen_resident_cpf(&gen, row, cpf);
+        assert(resident_db_cpf_valid(cpf));
+        packed[row - 1] = resident_db_cpf_pack(cpf);
+
+        datagen_user(&gen, row, &user);
+        assert(resident_db_cpf_valid(user.cpf));
+        packed[ROWS + row - 1] = resident_db_cpf_pack(user.cpf);
+    }
+    qsort(packed, ROWS, sizeof(*packed), test_compare_int64);
+    qsort(packed + ROWS, ROWS, sizeof(*packed), test_compare_int64);
+    for (int i = 1; i < ROWS; i++) {
+        assert(packed[i] != packed[i - 1]);
+        assert(packed[ROWS + i] != packed[ROWS + i - 1]);
+    }
+    free(packed);
+
+    // The CPF alone is the CPF of the whole row
+    struct resident resident;
+    char cpf[MAX_CPF_LENGTH];
+    datagen_resident(&gen, 1234, &resident);
+    datagen_resident_cpf(&gen, 1234, cpf);
+    assert(strcmp(resident.cpf, cpf) == 0);
+    assert(resident.name[0] != '\0' && resident.age >= 0 && resident.age <= 95);
+    assert(resident.entry_day <= gen.base_day && resident.entry_day > gen.base_day - 365);
+
+    printf("datagen_cpf test passed successfully.\n");
+}
+
+void test_datagen_residents(void) {
+    const char *test_filename_a = "test_datagen_a.db";
+    const char *test_filename_b = "test_datagen_b.db";
+    const char *test_filename_c = "test_datagen_c.db";
+    database a;
+    database b = { 0 };
+    database c = { 0 };
+    remove(test_filename_b);
+    remove(test_filename_c);
+    assert(db_init_with_tbl(&a, test_filename_a, resident_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_filename_a, &a);
+    assert(db_init_with_tbl(&b, test_filename_b, resident_db_create_table) == SQLITE_OK);
+    assert(db_init_with_tbl(&c, test_filename_c, resident_db_create_table) == SQLITE_OK);
+
+    enum { ROWS = 3000 };
+    struct datagen gen;
+    datagen_init(&gen, 42);
+    gen.batch_rows = 1000;
+    gen.progress = test_datagen_progress;
+    test_datagen_progress_calls = 0;
+    assert(datagen_fill_residents(&a, &gen, 1, ROWS) == SQLITE_OK);
+    assert(test_datagen_progress_calls == 3);
+    assert(resident_db_get_count(&a) == ROWS);
+
+    // Same seed in other batch sizes and several calls, same database
+    struct datagen same;
+    datagen_init(&same, 42);
+    same.batch_rows = 7;
+    assert(datagen_fill_residents(&b, &same, 1, 1000) == SQLITE_OK);
+    assert(datagen_fill_residents(&b, &same, 1001, 1500) == SQLITE_OK);
+    assert(datagen_fill_residents(&b, &same, 2501, ROWS - 2500) == SQLITE_OK);
+    const char *all_rows = "SELECT * FROM Resident ORDER BY CPF;";
+    assert(test_datagen_same_rows(&a, &b, all_rows));
+
+    struct datagen other;
+    datagen_init(&other, 43);
+    assert(datagen_fill_residents(&c, &other, 1, ROWS) == SQLITE_OK);
+    assert(!test_datagen_same_rows(&a, &c, all_rows));
+
+    // The rows read back through the resident functions, search included
+    struct resident expected;
+    struct resident resident;
+    datagen_resident(&gen, 777, &expected);
+    assert(resident_db_get_by_cpf(&a, expected.cpf, &resident) == SQLITE_OK);
+    assert(strcmp(resident.name, expected.name) == 0);
+    assert(resident.age == expected.age && resident.gender == expected.gender);
+    assert(resident.entry_day == expected.entry_day);
+    assert(strcmp(resident.needs, expected.needs) == 0);
+
+    // Some variety, frequent names first
+    assert(test_datagen_query_int(&a, "SELECT COUNT(DISTINCT Name) FROM Resident;") > ROWS / 2);
+    assert(test_datagen_query_int(&a, "SELECT COUNT(*) FROM Resident WHERE Name LIKE '% Silva%';") > ROWS / 20);
+    assert(test_datagen_query_int(&a, "SELECT COUNT(*) FROM Resident WHERE Age < 18;") > 0);
+    assert(test_datagen_query_int(&a, "SELECT COUNT(DISTINCT Gender) FROM Resident;") == 3);
+
+    // A batch with an existing row is rolled back whole, the rows are checked for range
+    gen.batch_rows = 100;
+    gen.progress = NULL;
+    assert(datagen_fill_residents(&a, &gen, ROWS - 50, 100) == SQLITE_CONSTRAINT);
+    assert(resident_db_get_count(&a) == ROWS);
+    assert(datagen_fill_residents(&a, &gen, 0, 10) == SQLITE_RANGE);
+    assert(datagen_fill_residents(&a, &gen, DATAGEN_MAX_ROWS, 2) == SQLITE_RANGE);
+    assert(datagen_fill_residents(&a, &gen, 1, 0) == SQLITE_OK);
+
+    // The search index was rebuilt and its trigger is back
+    assert(
+        sqlite3_exec(a.db, "INSERT INTO ResidentSearch(ResidentSearch) VALUES ('integrity-check');", 0, 0, 0)
+        == SQLITE_OK
+    );
+    const char *trigger_count = "SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name = 'Resident_ai';";
+    assert(test_datagen_query_int(&a, trigger_count) == 1);
+    struct resident added;
+    datagen_resident(&gen, ROWS + 1, &added);
+    assert(
+        resident_db_insert(&a, added.cpf, "Zuleica Quitéria", 30, "Stable", "None", false, GENDER_FEMALE)
+        == SQLITE_OK
+    );
+    assert(
+        test_datagen_query_int(&a, "SELECT COUNT(*) FROM ResidentSearch WHERE ResidentSearch MATCH 'quiteria';") == 1
+    );
+    assert(
+        sqlite3_exec(a.db, "INSERT INTO ResidentSearch(ResidentSearch) VALUES ('integrity-check');", 0, 0, 0)
+        == SQLITE_OK
+    );
+
+    db_deinit(&b);
+    db_deinit(&c);
+    remove(test_filename_b);
+    remove(test_filename_c);
+    teardown_cleanup();
+
+    printf("datagen_residents test passed successfully.\n");
+}
+
+void test_datagen_tables(void) {
+    struct datagen gen;
+    datagen_init(&gen, 99);
+    gen.batch_rows = 500;
+
+    const char *test_food_filename = "test_datagen_food.db";
+    database food;
+    assert(db_init_with_tbl(&food, test_food_filename, foodbatch_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_food_filename, &food);
+    assert(datagen_fill_foodbatches(&food, &gen, 1, 2000) == SQLITE_OK);
+    assert(foodbatch_db_get_count(&food) == 2000);
+
+    // Expired, not yet expired and non-expiring batches, all of them consumed
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT COUNT(*) FROM FoodBatch WHERE ExpirationDate < %d;", (int)gen.base_day);
+    assert(test_datagen_query_int(&food, sql) > 0);
+    snprintf(sql, sizeof(sql), "SELECT COUNT(*) FROM FoodBatch WHERE ExpirationDate >= %d;", (int)gen.base_day);
+    assert(test_datagen_query_int(&food, sql) > 1000);
+    assert(test_datagen_query_int(&food, "SELECT COUNT(*) FROM FoodBatch WHERE ExpirationDate IS NULL;") > 0);
+    assert(test_datagen_query_int(&food, "SELECT COUNT(*) FROM FoodBatch WHERE DailyConsumptionRate <= 0;") == 0);
+    assert(test_datagen_query_int(&food, "SELECT COUNT(DISTINCT IsPerishable) FROM FoodBatch;") == 2);
+
+    struct foodbatch expected;
+    struct foodbatch batch;
+    datagen_foodbatch(&gen, 1500, &expected);
+    assert(foodbatch_db_get_by_batchid(&food, 1500, &batch) == SQLITE_OK);
+    assert(strcmp(batch.name, expected.name) == 0 && batch.quantity == expected.quantity);
+    assert(strcmp(batch.expiration_date, expected.expiration_date) == 0);
+    teardown_cleanup();
+
+    const char *test_user_filename = "test_datagen_user.db";
+    database users;
+    assert(db_init_with_tbl(&users, test_user_filename, user_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_user_filename, &users);
+    assert(datagen_fill_users(&users, &gen, 1, 1000) == SQLITE_OK);
+    assert(user_db_get_count(&users) == 1001); // And the admin
+
+    char username[MAX_INPUT];
+    struct user user;
+    datagen_user_username(&gen, 321, username);
+    assert(user_db_get_by_username(&users, username, &user) == SQLITE_OK);
+    assert(user.reset_password && resident_db_cpf_valid(user.cpf));
+    assert(user.created_at <= (time_t)gen.base_day * 86400 + 86400);
+    assert(user.last_login == 0 || user.last_login >= user.created_at);
+    teardown_cleanup();
+
+    // More rows than the catalogs have combinations, the UNIQUE constraints still hold
+    const char *test_medication_filename = "test_datagen_medication.db";
+    database medication;
+    assert(db_init_with_tbl(&medication, test_medication_filename, medication_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_medication_filename, &medication);
+    assert(datagen_fill_medications(&medication, &gen, 1, 1000) == SQLITE_OK);
+    assert(medication_db_get_count(&medication) == 1000);
+    struct medication med;
+    assert(medication_db_get_by_id(&medication, 1000, &med) == SQLITE_OK && med.generic_name[0] != '\0');
+    teardown_cleanup();
+
+    const char *test_clothes_filename = "test_datagen_clothes.db";
+    database clothes;
+    assert(db_init_with_tbl(&clothes, test_clothes_filename, clothes_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_clothes_filename, &clothes);
+    assert(datagen_fill_clothes(&clothes, &gen, 1, 12000) == SQLITE_OK);
+    assert(clothes_db_get_count(&clothes) == 12000);
+    teardown_cleanup();
+
+    const char *test_supplies_filename = "test_datagen_supplies.db";
+    database supplies;
+    assert(db_init_with_tbl(&supplies, test_supplies_filename, supplies_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_supplies_filename, &supplies);
+    assert(datagen_fill_supplies(&supplies, &gen, 1, 1000) == SQLITE_OK);
+    assert(supplies_db_get_count(&supplies) == 1000);
+    assert(
+        test_datagen_query_int(&supplies, "SELECT SUM(Quantity) FROM Supplies;")
+        == test_datagen_query_int(&supplies, "SELECT SUM(Quantity) FROM SuppliesCategoryTotals;")
+    );
+    teardown_cleanup();
+
+    printf("datagen_tables test passed successfully.\n");
+}
+
+// TEST DATAGEN END
+
+// TEST DB PROFILE START
+
+static const struct db_profile_stat *
+test_profile_find(const struct db_profile_stat *stats, int count, const char *sql) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(stats[i].sql, sql) == 0) {
+            return &stats[i];
+        }
+    }
+    return NULL;
+}
+
+void test_db_profile_normalize(void) {
+    char out[DB_PROFILE_SQL_LEN];
+    uint64_t hash = db_profile_normalize(
+        "SELECT  *\n  FROM T WHERE a = 'x''y' AND b=42 AND c = -1.5e-3 AND t1 = ?1 AND \"col 2\" = 0x1F;",
+        out,
+        sizeof(out)
+    );
+    assert(strcmp(out, "SELECT * FROM T WHERE a = ? AND b=? AND c = -? AND t1 = ?1 AND \"col 2\" = ?;") == 0);
+    const char *other_literals = "SELECT * FROM T WHERE a = 'z' AND b=7 AND c = -2 AND t1 = ?1 AND \"col 2\" = 3;";
+    const char *other_parameter = "SELECT * FROM T WHERE a = ? AND b=? AND c = -? AND t1 = ?2 AND \"col 2\" = ?;";
+    assert(hash == db_profile_normalize(other_literals, NULL, 0));
+    assert(hash != db_profile_normalize(other_parameter, NULL, 0));
+
+    // Cut to the buffer, hashed in full
+    char small[8];
+    hash = db_profile_normalize("SELECT 1 FROM Resident;", small, sizeof(small));
+    assert(hash == db_profile_normalize("SELECT 2 FROM Resident;", NULL, 0));
+    assert(hash != db_profile_normalize("SELECT 1 FROM Residents;", NULL, 0));
+    assert(strcmp(small, "SELECT ") == 0);
+    assert(db_profile_normalize("", out, sizeof(out)) != 0 && out[0] == '\0');
+
+    // Buckets are ordered, four per power of two
+    for (int b = 1; b < DB_PROFILE_BUCKETS; b++) {
+        assert(db_profile_bucket_upper_ns(b) > db_profile_bucket_upper_ns(b - 1));
+    }
+    assert(db_profile_bucket_upper_ns(8) == 9 && db_profile_bucket_upper_ns(11) == 15);
+    assert(db_profile_bucket_upper_ns(DB_PROFILE_BUCKETS - 1) == UINT64_MAX);
+
+    printf("db_profile_normalize test passed successfully.\n");
+}
+
+void test_db_profile(void) {
+    const char *test_filename = "test_db_profile.db";
+    const char *test_report = "test_db_profile.txt";
+    database db;
+    db_profile_reset();
+    db_profile_enable(true);
+    assert(db_profile_is_enabled());
+    assert(db_init(&db, test_filename) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+    assert(sqlite3_exec(db.db, "DROP TABLE IF EXISTS T; CREATE TABLE T (a INTEGER, b TEXT);", 0, 0, 0) == SQLITE_OK);
+
+    enum { RUNS = 50 };
+    for (int i = 0; i < RUNS; i++) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "INSERT INTO T VALUES (%d, 'row %d');", i, i);
+        assert(sqlite3_exec(db.db, sql, 0, 0, 0) == SQLITE_OK);
+    }
+
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(db.db, "SELECT COUNT(*) FROM T WHERE a >= ?;", -1, &stmt, 0) == SQLITE_OK);
+    for (int i = 0; i < 10; i++) {
+        sqlite3_bind_int(stmt, 1, i);
+        assert(sqlite3_step(stmt) == SQLITE_ROW);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    struct db_profile_stat *stats = malloc(sizeof(*stats) * DB_PROFILE_MAX_STATEMENTS);
+    assert(stats);
+    int count = db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS);
+    const struct db_profile_stat *insert = test_profile_find(stats, count, "INSERT INTO T VALUES (?, ?);");
+    assert(insert && insert->calls == RUNS);
+    uint64_t in_buckets = 0;
+    for (int b = 0; b < DB_PROFILE_BUCKETS; b++) {
+        in_buckets += insert->histogram[b];
+    }
+    assert(in_buckets == RUNS);
+    assert(insert->max_ns > 0 && insert->total_ns >= insert->max_ns);
+    assert(insert->p50_ns <= insert->p95_ns && insert->p95_ns <= insert->p99_ns);
+
+    const struct db_profile_stat *select = test_profile_find(stats, count, "SELECT COUNT(*) FROM T WHERE a >= ?;");
+    assert(select && select->calls == 10);
+
+    // Slowest total first
+    for (int i = 1; i < count; i++) {
+        assert(stats[i - 1].total_ns >= stats[i].total_ns);
+    }
+
+    // The report has every statement
+    assert(db_profile_dump(test_report) == 0);
+    FILE *report = fopen(test_report, "r");
+    assert(report);
+    char line[512];
+    bool found = false;
+    while (fgets(line, sizeof(line), report)) {
+        found = found || (strstr(line, "INSERT INTO T VALUES (?, ?);") && strstr(line, "        50 "));
+    }
+    fclose(report);
+    remove(test_report);
+    assert(found);
+
+    // Connections opened while disabled are not traced
+    db_profile_enable(false);
+    database untraced;
+    assert(db_init(&untraced, test_filename) == SQLITE_OK);
+    assert(sqlite3_exec(untraced.db, "INSERT INTO T VALUES (1, 'x');", 0, 0, 0) == SQLITE_OK);
+    db_deinit(&untraced);
+    count = db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS);
+    insert = test_profile_find(stats, count, "INSERT INTO T VALUES (?, ?);");
+    assert(insert && insert->calls == RUNS);
+
+    db_profile_reset();
+    assert(db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS) == 0);
+    assert(db_profile_dropped() == 0);
+
+    free(stats);
+    teardown_cleanup();
+
+    printf("db_profile test passed successfully.\n");
+}
+
+void test_db_profile_track_time(void) {
+    const char *test_filename = "test_db_profile_time.db";
+    database db;
+    db_profile_reset();
+    db_profile_track_time(true);
+    assert(db_init(&db, test_filename) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+    db_profile_track_time(false);
+
+    uint64_t before = db_profile_thread_ns();
+    assert(sqlite3_exec(db.db, "DROP TABLE IF EXISTS T; CREATE TABLE T (a INTEGER);", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i < 20; i++) {
+        assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (1);", 0, 0, 0) == SQLITE_OK);
+    }
+    assert(db_profile_thread_ns() > before);
+
+    // Nothing is recorded per statement while profiling is off
+    struct db_profile_stat *stats = malloc(sizeof(*stats) * DB_PROFILE_MAX_STATEMENTS);
+    assert(stats);
+    assert(db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS) == 0);
+
+    db_profile_enable(true);
+    assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (2);", 0, 0, 0) == SQLITE_OK);
+    db_profile_enable(false);
+    assert(db_profile_snapshot(stats, DB_PROFILE_MAX_STATEMENTS) == 1);
+    assert(strcmp(stats[0].sql, "INSERT INTO T VALUES (?);") == 0 && stats[0].calls == 1);
+
+    db_profile_reset();
+    free(stats);
+    teardown_cleanup();
+
+    printf("db_profile_track_time test passed successfully.\n");
+}
+
+// TEST DB PROFILE END
+
+// TEST DB POOL START
+
+static int test_pool_count_rows(database *db) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->db, "SELECT count(*) FROM T;", -1, &stmt, 0) != SQLITE_OK) {
+        return -1;
+    }
+    int count = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+struct test_pool_worker {
+    pthread_t thread;
+    database *db;
+    int failures;
+};
+
+static void *test_pool_read_loop(void *arg) {
+    struct test_pool_worker *worker = arg;
+    for (int i = 0; i < 200; i++) {
+        database reader;
+        if (db_pool_acquire(worker->db, &reader) != SQLITE_OK || test_pool_count_rows(&reader) < 100) {
+            worker->failures++;
+        }
+        db_pool_release(worker->db, &reader);
+    }
+    return NULL;
+}
+
+void test_db_pool(void) {
+    const char *test_filename = "test_db_pool.db";
+    database db;
+    assert(db_init(&db, test_filename) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+
+    printf("Testing db_pool...\n");
+    assert(sqlite3_exec(db.db, "DROP TABLE IF EXISTS T; CREATE TABLE T (a INTEGER);", 0, 0, 0) == SQLITE_OK);
+    assert(sqlite3_exec(db.db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i < 100; i++) {
+        assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (1);", 0, 0, 0) == SQLITE_OK);
+    }
+    assert(sqlite3_exec(db.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+
+    // Without a pool the writer is handed out
+    database reader;
+    assert(db_pool_readers(&db) == 0);
+    assert(db_pool_acquire(&db, &reader) == SQLITE_OK && reader.db == db.db);
+    db_pool_release(&db, &reader);
+    assert(reader.db == NULL);
+
+    assert(db_pool_open(&db, 0) == SQLITE_MISUSE);
+    assert(db_pool_open(&db, DB_POOL_MAX_READERS + 1) == SQLITE_MISUSE);
+    assert(db_pool_open(&db, 3) == SQLITE_OK);
+    assert(db_pool_open(&db, 3) == SQLITE_MISUSE);
+    assert(db_pool_readers(&db) == 3);
+
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(db.db, "PRAGMA journal_mode;", -1, &stmt, 0) == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW && strcmp((const char *)sqlite3_column_text(stmt, 0), "wal") == 0);
+    sqlite3_finalize(stmt);
+
+    // Distinct read-only connections
+    database readers[3];
+    for (int i = 0; i < 3; i++) {
+        assert(db_pool_acquire(&db, &readers[i]) == SQLITE_OK);
+        assert(readers[i].db && readers[i].db != db.db);
+        for (int j = 0; j < i; j++) {
+            assert(readers[i].db != readers[j].db);
+        }
+    }
+    assert(sqlite3_exec(readers[0].db, "INSERT INTO T VALUES (1);", 0, 0, 0) == SQLITE_READONLY);
+
+    // An open read transaction does not hold the writer back, and sees its snapshot until done
+    assert(sqlite3_prepare_v2(readers[2].db, "SELECT a FROM T;", -1, &stmt, 0) == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (2);", 0, 0, 0) == SQLITE_OK);
+    assert(test_pool_count_rows(&readers[1]) == 101);
+    sqlite3_finalize(stmt);
+
+    for (int i = 0; i < 3; i++) {
+        db_pool_release(&db, &readers[i]);
+    }
+
+    // The thread gets back the reader it used last
+    assert(db_pool_acquire(&db, &readers[0]) == SQLITE_OK);
+    sqlite3 *last = readers[0].db;
+    db_pool_release(&db, &readers[0]);
+    assert(db_pool_acquire(&db, &readers[0]) == SQLITE_OK && readers[0].db == last);
+    db_pool_release(&db, &readers[0]);
+
+    // A thread holding every reader gets the writer instead of waiting on itself
+    for (int i = 0; i < 3; i++) {
+        assert(db_pool_acquire(&db, &readers[i]) == SQLITE_OK && readers[i].db != db.db);
+    }
+    assert(db_pool_acquire(&db, &reader) == SQLITE_OK && reader.db == db.db);
+    db_pool_release(&db, &reader);
+    for (int i = 0; i < 3; i++) {
+        db_pool_release(&db, &readers[i]);
+    }
+
+    // More threads than readers, reading while the writer commits
+    struct test_pool_worker workers[5] = { 0 };
+    for (int i = 0; i < 5; i++) {
+        workers[i].db = &db;
+        assert(pthread_create(&workers[i].thread, NULL, test_pool_read_loop, &workers[i]) == 0);
+    }
+    for (int i = 0; i < 50; i++) {
+        assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (3);", 0, 0, 0) == SQLITE_OK);
+    }
+    for (int i = 0; i < 5; i++) {
+        pthread_join(workers[i].thread, NULL);
+        assert(workers[i].failures == 0);
+    }
+    assert(test_pool_count_rows(&db) == 151);
+
+    teardown_cleanup();
+    assert(db.pool == NULL);
+
+    printf("db_pool test passed successfully.\n");
+}
+
+struct test_pool_export {
+    pthread_t thread;
+    database *db;
+    char buffer[4096];
+    int written;
+    int count;
+};
+
+static void *test_pool_export_table(void *arg) {
+    struct test_pool_export *export = arg;
+    export->written = resident_db_get_all_format(export->db, export->buffer, sizeof(export->buffer));
+    export->count = resident_db_get_count(export->db);
+    return NULL;
+}
+
+void test_db_pool_reads(void) {
+    const char *test_filename = "test_db_pool_reads.db";
+    database db;
+    assert(db_init_with_tbl(&db, test_filename, resident_db_create_table) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+
+    printf("Testing reads through the pool...\n");
+    assert(resident_db_insert(&db, "12345678909", "John Doe", 30, "Healthy", "None", false, 0) == SQLITE_OK);
+    assert(db_pool_open(&db, 2) == SQLITE_OK);
+
+    // A write transaction stays open on the writer while another thread exports
+    assert(sqlite3_exec(db.db, "BEGIN IMMEDIATE;", 0, 0, 0) == SQLITE_OK);
+    assert(resident_db_insert(&db, "23456789092", "Jane Smith", 45, "Healthy", "None", false, 1) == SQLITE_OK);
+    struct test_pool_export export = { .db = &db };
+    assert(pthread_create(&export.thread, NULL, test_pool_export_table, &export) == 0);
+    pthread_join(export.thread, NULL);
+    assert(export.written > 0 && strstr(export.buffer, "John Doe") && !strstr(export.buffer, "Jane Smith"));
+    assert(export.count == 1);
+    assert(!resident_db_check_cpf_exists(&db, "23456789092"));
+    printf("Export read the last commit while a write transaction was open.\n");
+
+    // Writes and db_writer() see the rows of the open transaction
+    assert(resident_db_update(&db, "23456789092", "", 46, "", "", -1, -1) == SQLITE_OK);
+    database writer = db_writer(&db);
+    struct resident resident;
+    assert(resident_db_get_by_cpf(&writer, "23456789092", &resident) == SQLITE_OK && resident.age == 46);
+    struct resident_duplicate duplicates[4];
+    int duplicate_count = 0;
+    int rc = resident_db_insert_checked(
+        &db,
+        "34567890175",
+        "Jane Smith",
+        50,
+        "",
+        "",
+        false,
+        1,
+        0.5f,
+        duplicates,
+        4,
+        &duplicate_count
+    );
+    assert(rc == SQLITE_OK && duplicate_count == 1 && strcmp(duplicates[0].cpf, "23456789092") == 0);
+    assert(sqlite3_exec(db.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+
+    assert(resident_db_get_count(&db) == 3);
+    char buffer[4096];
+    assert(resident_db_get_all_format(&db, buffer, sizeof(buffer)) > 0 && strstr(buffer, "Jane Smith"));
+    printf("Writes checked the uncommitted rows, reads see them once committed.\n");
+
+    teardown_cleanup();
+
+    printf("db_pool reads test passed successfully.\n");
+}
+
+// TEST DB POOL END
+
+// TEST DB BACKUP START
+
+#define TEST_BACKUP_DIR "test_backups"
+
+// Counts the entries of the backup directory named prefix...suffix, copies the last in name order
+static int test_backup_find(const char *prefix, const char *suffix, char *found, size_t size) {
+    DIR *d = opendir(TEST_BACKUP_DIR);
+    assert(d);
+    int count = 0;
+    if (found) {
+        found[0] = '\0';
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0 || len < strlen(suffix)
+            || strcmp(entry->d_name + len - strlen(suffix), suffix) != 0)
+        {
+            continue;
+        }
+        count++;
+        if (found && strcmp(entry->d_name, found) > 0) {
+            snprintf(found, size, "%s", entry->d_name);
+        }
+    }
+    closedir(d);
+    return count;
+}
+
+static void test_backup_clear_dir(void) {
+    DIR *d = opendir(TEST_BACKUP_DIR);
+    if (!d) {
+        return;
+    }
+    struct dirent *entry;
+    char path[DB_BACKUP_PATH_LEN];
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%.200s", TEST_BACKUP_DIR, entry->d_name);
+            remove(path);
+        }
+    }
+    closedir(d);
+    remove(TEST_BACKUP_DIR);
+}
+
+static void test_backup_touch(const char *name) {
+    char path[DB_BACKUP_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", TEST_BACKUP_DIR, name);
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    fputs("not a database", f);
+    fclose(f);
+}
+
+static int test_backup_count_rows(const char *path) {
+    database copy;
+    assert(db_init(&copy, path) == SQLITE_OK);
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(copy.db, "PRAGMA integrity_check;", -1, &stmt, 0) == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW && strcmp((const char *)sqlite3_column_text(stmt, 0), "ok") == 0);
+    sqlite3_finalize(stmt);
+    int count = test_pool_count_rows(&copy);
+    db_deinit(&copy);
+    return count;
+}
+
+void test_db_backup(void) {
+    const char *test_filename = "test_db_backup.db";
+    database db;
+    remove(test_filename);
+    assert(db_init(&db, test_filename) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+    test_backup_clear_dir();
+
+    printf("Testing db_backup...\n");
+    assert(sqlite3_exec(db.db, "CREATE TABLE T (a INTEGER, b BLOB);", 0, 0, 0) == SQLITE_OK);
+    assert(sqlite3_exec(db.db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i < 3000; i++) {
+        assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (1, randomblob(200));", 0, 0, 0) == SQLITE_OK);
+    }
+    assert(sqlite3_exec(db.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+
+    struct db_backup_config config = { .dir = TEST_BACKUP_DIR, .generations = 2, .interval = 0, .compress = false };
+    struct db_backup *backup = db_backup_create(&config);
+    assert(backup);
+
+    // Older backups to rotate out, and files that are not backups of this database
+    test_backup_touch("test_db_backup-20200101-000000.db");
+    test_backup_touch("test_db_backup-20210101-000000.db.gz");
+    test_backup_touch("test_db_backup-notes.txt");
+    test_backup_touch("test_db_backup2-20200101-000000.db");
+
+    database memory;
+    assert(db_init(&memory, ":memory:") == SQLITE_OK);
+    assert(db_backup_add(backup, &memory) == SQLITE_MISUSE);
+    db_deinit(&memory);
+    assert(db_backup_add(backup, &db) == SQLITE_OK);
+
+    struct db_backup_status status;
+    db_backup_get_status(backup, &status);
+    assert(status.state == DB_BACKUP_IDLE && status.databases == 1 && status.next_due == 0);
+
+    // Writes through the same connection while the copy runs
+    assert(db_backup_start(backup));
+    assert(!db_backup_start(backup) || !db_backup_running(backup));
+    for (int i = 0; i < 500; i++) {
+        assert(sqlite3_exec(db.db, "INSERT INTO T VALUES (2, randomblob(200));", 0, 0, 0) == SQLITE_OK);
+    }
+    assert(db_backup_wait(backup) == SQLITE_OK);
+    assert(!db_backup_running(backup));
+
+    db_backup_get_status(backup, &status);
+    assert(status.state == DB_BACKUP_DONE && status.progress == 1.0f && status.last_success > 0);
+    assert(status.pages_total > DB_BACKUP_PAGES_PER_STEP && status.pages_done == status.pages_total);
+    assert(strcmp(status.name, "test_db_backup") == 0);
+
+    // Two generations kept, the oldest gone, the rest untouched
+    char found[DB_BACKUP_PATH_LEN];
+    char path[DB_BACKUP_PATH_LEN * 2];
+    assert(test_backup_find("test_db_backup-", ".db", found, sizeof(found)) == 1);
+    assert(test_backup_find("test_db_backup-2020", "", NULL, 0) == 0);
+    assert(test_backup_find("test_db_backup-20210101-000000.db.gz", "", NULL, 0) == 1);
+    assert(test_backup_find("test_db_backup-notes.txt", "", NULL, 0) == 1);
+    assert(test_backup_find("test_db_backup2-", "", NULL, 0) == 1);
+    assert(test_backup_find("", ".partial", NULL, 0) == 0);
+
+    snprintf(path, sizeof(path), "%s/%s", TEST_BACKUP_DIR, found);
+    int rows = test_backup_count_rows(path);
+    assert(rows >= 3000 && rows <= 3500);
+    db_backup_free(backup);
+
+    // Compressed, all generations kept
+    config.generations = 0;
+    config.compress = true;
+    backup = db_backup_create(&config);
+    assert(backup && db_backup_add(backup, &db) == SQLITE_OK);
+    assert(db_backup_start(backup));
+    assert(db_backup_wait(backup) == SQLITE_OK);
+    assert(test_backup_find("test_db_backup-", ".db", NULL, 0) == 1);
+    assert(test_backup_find("test_db_backup-", ".db.gz", found, sizeof(found)) == 2);
+    assert(strcmp(found, "test_db_backup-20210101-000000.db.gz") > 0);
+
+    snprintf(path, sizeof(path), "%s/%s", TEST_BACKUP_DIR, found);
+    gzFile in = gzopen(path, "rb");
+    assert(in);
+    const char *restored_filename = "test_db_backup_restored.db";
+    FILE *out = fopen(restored_filename, "wb");
+    assert(out);
+    char buffer[4096];
+    int read;
+    while ((read = gzread(in, buffer, sizeof(buffer))) > 0) {
+        assert(fwrite(buffer, 1, (size_t)read, out) == (size_t)read);
+    }
+    assert(read == 0);
+    gzclose(in);
+    fclose(out);
+    assert(test_backup_count_rows(restored_filename) == 3500);
+    remove(restored_filename);
+
+    // Canceled by free, nothing partial left behind
+    assert(db_backup_start(backup));
+    db_backup_free(backup);
+    assert(test_backup_find("", ".partial", NULL, 0) == 0);
+
+    // Scheduled one interval after the backups in the directory
+    config.interval = 3600;
+    backup = db_backup_create(&config);
+    assert(backup && db_backup_add(backup, &db) == SQLITE_OK);
+    db_backup_get_status(backup, &status);
+    time_t now = time(NULL);
+    assert(status.last_success > 0 && status.next_due == status.last_success + 3600);
+    db_backup_tick(backup, now);
+    assert(!db_backup_running(backup) && db_backup_wait(backup) == SQLITE_OK);
+    db_backup_get_status(backup, &status);
+    assert(status.state == DB_BACKUP_IDLE);
+    db_backup_tick(backup, status.next_due);
+    db_backup_get_status(backup, &status);
+    assert(status.state != DB_BACKUP_IDLE);
+    assert(db_backup_wait(backup) == SQLITE_OK);
+    db_backup_get_status(backup, &status);
+    assert(status.state == DB_BACKUP_DONE && status.next_due >= now + 3600);
+    db_backup_free(backup);
+
+    test_backup_clear_dir();
+    teardown_cleanup();
+
+    printf("db_backup test passed successfully.\n");
+}
+
+// TEST DB BACKUP END
+
+// TEST DB MAINTENANCE START
+
+static int test_maintenance_create_table(database *db) {
+    return sqlite3_exec(db->db, "CREATE TABLE T (a INTEGER, b BLOB); CREATE INDEX T_a ON T (a);", 0, 0, 0);
+}
+
+static int64_t test_maintenance_pragma(database *db, const char *sql) {
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(db->db, sql, -1, &stmt, 0) == SQLITE_OK);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    int64_t value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+static void test_maintenance_fill(database *db, int rows) {
+    assert(sqlite3_exec(db->db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i < rows; i++) {
+        char sql[128];
+        snprintf(sql, sizeof(sql), "INSERT INTO T VALUES (%d, randomblob(300));", i % 50);
+        assert(sqlite3_exec(db->db, sql, 0, 0, 0) == SQLITE_OK);
+    }
+    assert(sqlite3_exec(db->db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+}
+
+void test_db_maintenance(void) {
+    const char *test_filename = "test_db_maintenance.db";
+    const char *wal_filename = "test_db_maintenance_wal.db";
+    database db;
+    database wal;
+    remove(test_filename);
+    remove(wal_filename);
+    assert(db_init_with_tbl(&db, test_filename, test_maintenance_create_table) == SQLITE_OK);
+    assert(db_init(&wal, wal_filename) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+
+    printf("Testing db_maintenance...\n");
+
+    // New files are created incremental, the WAL one was not made by db_init_with_tbl()
+    assert(test_maintenance_pragma(&db, "PRAGMA auto_vacuum;") == 2);
+    assert(test_maintenance_pragma(&wal, "PRAGMA auto_vacuum;") == 0);
+    assert(sqlite3_exec(wal.db, "PRAGMA journal_mode = WAL;", 0, 0, 0) == SQLITE_OK);
+    assert(test_maintenance_create_table(&wal) == SQLITE_OK);
+    test_maintenance_fill(&wal, 200);
+
+    test_maintenance_fill(&db, 5000);
+    assert(sqlite3_exec(db.db, "DELETE FROM T WHERE a < 40;", 0, 0, 0) == SQLITE_OK);
+    int64_t free_pages = test_maintenance_pragma(&db, "PRAGMA freelist_count;");
+    assert(free_pages > 100);
+
+    struct db_maintenance_config config = { .idle_ns = 1000, .interval_ns = 1000000 };
+    struct db_maintenance *maintenance = db_maintenance_create(&config);
+    assert(maintenance);
+    database closed = { 0 };
+    assert(db_maintenance_add(maintenance, &closed, "closed") == SQLITE_MISUSE);
+    assert(db_maintenance_add(maintenance, &db, "test_db") == SQLITE_OK);
+    assert(db_maintenance_add(maintenance, &wal, "test_wal") == SQLITE_OK);
+
+    // Idle counted from the first tick
+    db_maintenance_tick(maintenance, false, 0);
+    db_maintenance_tick(maintenance, false, 999);
+    assert(!db_maintenance_running(maintenance));
+    db_maintenance_tick(maintenance, true, 1500);
+    db_maintenance_tick(maintenance, false, 2499);
+    assert(!db_maintenance_running(maintenance));
+    db_maintenance_tick(maintenance, false, 2500);
+    assert(db_maintenance_wait(maintenance) == SQLITE_OK);
+
+    struct db_maintenance_stats stats;
+    db_maintenance_get_stats(maintenance, &stats);
+    assert(stats.passes == 1 && stats.aborts == 0);
+    assert(stats.tables_analyzed >= 1);
+    assert(stats.pages_reclaimed > free_pages / 2 && stats.pages_reclaimed <= free_pages); // ANALYZE reuses a few
+    assert(stats.frames_checkpointed > 0);
+    assert(stats.databases_converted == 1 && test_maintenance_pragma(&wal, "PRAGMA auto_vacuum;") == 2);
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") == 0);
+    assert(test_maintenance_pragma(&db, "SELECT count(*) FROM sqlite_stat1 WHERE tbl = 'T';") > 0);
+    assert(test_maintenance_pragma(&db, "PRAGMA analysis_limit;") == 0);
+
+    // Not again before the interval
+    db_maintenance_tick(maintenance, false, 4000);
+    assert(!db_maintenance_running(maintenance));
+    db_maintenance_free(maintenance);
+
+    // Input aborts a long vacuum, the pass resumes at the next idle period
+    test_maintenance_fill(&db, 5000);
+    assert(sqlite3_exec(db.db, "DELETE FROM T;", 0, 0, 0) == SQLITE_OK);
+    config.vacuum_pages = 1;
+    maintenance = db_maintenance_create(&config);
+    assert(maintenance && db_maintenance_add(maintenance, &db, "test_db") == SQLITE_OK);
+    db_maintenance_tick(maintenance, false, 0);
+    db_maintenance_tick(maintenance, false, 1000);
+    db_maintenance_tick(maintenance, true, 1001);
+    assert(!db_maintenance_running(maintenance));
+    int rc = db_maintenance_wait(maintenance);
+    assert(rc == SQLITE_OK || rc == SQLITE_INTERRUPT);
+
+    // The connection works as usual right after
+    assert(test_maintenance_pragma(&db, "SELECT count(*) FROM T;") == 0);
+
+    db_maintenance_tick(maintenance, false, 1500);
+    assert(!db_maintenance_running(maintenance));
+    db_maintenance_tick(maintenance, false, 2001);
+    assert(db_maintenance_wait(maintenance) == SQLITE_OK);
+    db_maintenance_get_stats(maintenance, &stats);
+    assert(stats.passes == 1);
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") == 0);
+    db_maintenance_free(maintenance);
+
+    db_deinit(&wal);
+    remove(wal_filename);
+    teardown_cleanup();
+
+    printf("db_maintenance test passed successfully.\n");
+}
+
+static int test_maintenance_keep_table(database *db) {
+    return sqlite3_exec(db->db, "CREATE TABLE IF NOT EXISTS T (a INTEGER, b BLOB);", 0, 0, 0);
+}
+
+void test_db_maintenance_upgrade(void) {
+    const char *test_filename = "test_db_maintenance_upgrade.db";
+    remove(test_filename);
+
+    printf("Testing db_maintenance on a database created without auto_vacuum...\n");
+    sqlite3 *old;
+    assert(sqlite3_open(test_filename, &old) == SQLITE_OK);
+    assert(sqlite3_exec(old, "CREATE TABLE T (a INTEGER, b BLOB); CREATE INDEX T_a ON T (a);", 0, 0, 0) == SQLITE_OK);
+    sqlite3_close(old);
+
+    // The pragma of db_init_with_tbl() does not apply to a file that has tables
+    database db;
+    assert(db_init_with_tbl(&db, test_filename, test_maintenance_keep_table) == SQLITE_OK);
+    setup_cleanup(test_filename, &db);
+    assert(test_maintenance_pragma(&db, "PRAGMA auto_vacuum;") == 0);
+    test_maintenance_fill(&db, 3000);
+    assert(sqlite3_exec(db.db, "DELETE FROM T WHERE a < 40;", 0, 0, 0) == SQLITE_OK);
+    int64_t pages = test_maintenance_pragma(&db, "PRAGMA page_count;");
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") > 100);
+
+    struct db_maintenance_config config = { .idle_ns = 1000, .interval_ns = 1000000 };
+    struct db_maintenance *maintenance = db_maintenance_create(&config);
+    assert(maintenance && db_maintenance_add(maintenance, &db, "test_upgrade") == SQLITE_OK);
+    db_maintenance_tick(maintenance, false, 0);
+    db_maintenance_tick(maintenance, false, 1000);
+    assert(db_maintenance_wait(maintenance) == SQLITE_OK);
+
+    struct db_maintenance_stats stats;
+    db_maintenance_get_stats(maintenance, &stats);
+    assert(stats.databases_converted == 1 && stats.pages_reclaimed > 100);
+    assert(test_maintenance_pragma(&db, "PRAGMA auto_vacuum;") == 2);
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") == 0);
+    assert(test_maintenance_pragma(&db, "PRAGMA page_count;") < pages);
+    assert(test_maintenance_pragma(&db, "SELECT count(*) FROM T;") == 3000 / 5);
+    printf("Converted to incremental auto_vacuum, the rows kept.\n");
+
+    // Converted once, the next passes only run incremental vacuums
+    assert(sqlite3_exec(db.db, "DELETE FROM T;", 0, 0, 0) == SQLITE_OK);
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") > 0);
+    db_maintenance_tick(maintenance, false, 2000); // Pass done at 2000, the next is due an interval later
+    db_maintenance_tick(maintenance, false, 1002000);
+    assert(db_maintenance_wait(maintenance) == SQLITE_OK);
+    db_maintenance_get_stats(maintenance, &stats);
+    assert(stats.passes == 2 && stats.databases_converted == 1);
+    assert(test_maintenance_pragma(&db, "PRAGMA freelist_count;") == 0);
+    db_maintenance_free(maintenance);
+
+    teardown_cleanup();
+
+    printf("db_maintenance upgrade test passed successfully.\n");
+}
+
+// TEST DB MAINTENANCE END
+
+// TEST DB CHANGES START
+
+#define TEST_CHANGES_MAX 16
+
+struct test_changes {
+    enum db_change_op ops[TEST_CHANGES_MAX];
+    int64_t rowids[TEST_CHANGES_MAX];
+    int count;
+    int resets;
+};
+
+static void test_changes_record(const struct db_change *change, void *ctx) {
+    struct test_changes *changes = ctx;
+    if (change->op == DB_CHANGE_RESET) {
+        changes->resets++;
+        return;
+    }
+    assert(changes->count < TEST_CHANGES_MAX);
+    changes->ops[changes->count] = change->op;
+    changes->rowids[changes->count] = change->rowid;
+    changes->count++;
+}
+
+static bool test_changes_has(const struct test_changes *changes, enum db_change_op op, int64_t rowid) {
+    for (int i = 0; i < changes->count; i++) {
+        if (changes->ops[i] == op && changes->rowids[i] == rowid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *test_changes_writer(void *arg) {
+    database *db = arg;
+    assert(foodbatch_db_insert(db, 5000, "Rice", 10, false, "", 1.0f) == SQLITE_OK);
+    return NULL;
+}
+
+// A table patched row by row reads the same as one formatted again
+static void test_changes_patch_matches(database *db, char **table, int batch_id) {
+    char key[16];
+    snprintf(key, sizeof(key), "%d", batch_id);
+    char block[1024];
+    int len = foodbatch_db_get_format_by_batchid(db, batch_id, block, sizeof(block));
+    assert(len >= 0);
+    assert(table_text_patch(table, key, len > 0 ? block : NULL) == 0);
+
+    char fresh[8192];
+    assert(foodbatch_db_get_all_format(db, fresh, sizeof(fresh)) > 0);
+    assert(strcmp(*table, fresh) == 0);
+}
+
+void test_db_changes(void) {
+    const char *food_filename = "test_db_changes_food.db";
+    const char *resident_filename = "test_db_changes_resident.db";
+    database food;
+    database residents;
+    remove(food_filename);
+    remove(resident_filename);
+    assert(db_init_with_tbl(&food, food_filename, foodbatch_db_create_table) == SQLITE_OK);
+    assert(db_init_with_tbl(&residents, resident_filename, resident_db_create_table) == SQLITE_OK);
+    setup_cleanup(food_filename, &food);
+
+    printf("Testing db_changes...\n");
+
+    struct test_changes batches = { 0 };
+    struct test_changes people = { 0 };
+    int batch_sub = db_changes_subscribe("FoodBatch", test_changes_record, &batches);
+    int people_sub = db_changes_subscribe("resident", test_changes_record, &people); // Any case
+    assert(batch_sub > 0 && people_sub > 0 && batch_sub != people_sub);
+    assert(db_changes_dispatch() == 0);
+
+    // Delivered once committed, each row once
+    assert(sqlite3_exec(food.db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    assert(foodbatch_db_insert(&food, 1, "Milk", 10, true, "2030-01-01", 2.0f) == SQLITE_OK);
+    assert(foodbatch_db_insert(&food, 2, "Beans", 20, false, "", 1.0f) == SQLITE_OK);
+    assert(foodbatch_db_update(&food, 1, "", 5, true, "", -1) == SQLITE_OK);
+    assert(db_changes_dispatch() == 0);
+    assert(sqlite3_exec(food.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 2);
+    assert(batches.count == 2 && people.count == 0);
+    assert(test_changes_has(&batches, DB_CHANGE_INSERT, 1) && test_changes_has(&batches, DB_CHANGE_INSERT, 2));
+    printf("Committed rows delivered once, an insert updated later stays an insert.\n");
+
+    // Rolled back, nothing
+    batches = (struct test_changes) { 0 };
+    assert(sqlite3_exec(food.db, "BEGIN; DELETE FROM FoodBatch WHERE BatchId = 2; ROLLBACK;", 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 0);
+
+    // Autocommit writes, each statement is its own transaction
+    assert(foodbatch_db_update(&food, 2, "", 15, false, "", -1) == SQLITE_OK);
+    assert(foodbatch_db_delete_by_id(&food, 1) == SQLITE_OK);
+    assert(db_changes_dispatch() == 2);
+    assert(test_changes_has(&batches, DB_CHANGE_UPDATE, 2) && test_changes_has(&batches, DB_CHANGE_DELETE, 1));
+    printf("Rolled back rows dropped, autocommit writes delivered.\n");
+
+    // WITHOUT ROWID table, published by its key through the triggers
+    int64_t cpf = resident_db_cpf_pack("12345678909");
+    int64_t new_cpf = resident_db_cpf_pack("12345679034");
+    assert(resident_db_insert(&residents, "12345678909", "John Doe", 30, "Healthy", "None", false, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&people, DB_CHANGE_INSERT, cpf));
+    people = (struct test_changes) { 0 };
+    assert(resident_db_update(&residents, "12345678909", "John Smith", 0, "", "", -1, -1) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&people, DB_CHANGE_UPDATE, cpf));
+    people = (struct test_changes) { 0 };
+    char sql[128];
+    snprintf(sql, sizeof(sql), "UPDATE Resident SET CPF = %" PRId64 " WHERE CPF = %" PRId64 ";", new_cpf, cpf);
+    assert(sqlite3_exec(residents.db, sql, 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 2);
+    assert(test_changes_has(&people, DB_CHANGE_DELETE, cpf) && test_changes_has(&people, DB_CHANGE_INSERT, new_cpf));
+    people = (struct test_changes) { 0 };
+    assert(resident_db_delete_by_cpf(&residents, "12345679034") == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&people, DB_CHANGE_DELETE, new_cpf));
+    printf("WITHOUT ROWID changes published by key, a key change as delete and insert.\n");
+
+    // Too many rows for one dispatch, a single reset
+    batches = (struct test_changes) { 0 };
+    assert(sqlite3_exec(food.db, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i <= DB_CHANGES_MAX_ROWS; i++) {
+        assert(foodbatch_db_insert(&food, 100 + i, "Bulk", 1, false, "", 0.5f) == SQLITE_OK);
+    }
+    assert(sqlite3_exec(food.db, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(batches.resets == 1 && batches.count == 0);
+    assert(sqlite3_exec(food.db, "DELETE FROM FoodBatch WHERE Name = 'Bulk';", 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(batches.resets == 2);
+    printf("Bulk changes delivered as one reset.\n");
+
+    // Committed on another thread, delivered by the next dispatch on this one
+    batches = (struct test_changes) { 0 };
+    pthread_t writer;
+    assert(pthread_create(&writer, NULL, test_changes_writer, &food) == 0);
+    pthread_join(writer, NULL);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&batches, DB_CHANGE_INSERT, 5000));
+    printf("Changes from another thread delivered on dispatch.\n");
+
+    // Patched table reads as a reloaded one
+    char *table = malloc(8192);
+    assert(table && foodbatch_db_get_all_format(&food, table, 8192) > 0);
+    assert(foodbatch_db_update(&food, 2, "Black beans", 12, false, "", -1) == SQLITE_OK);
+    test_changes_patch_matches(&food, &table, 2);
+    assert(foodbatch_db_insert(&food, 6000, "Pasta", 40, false, "", 3.0f) == SQLITE_OK);
+    test_changes_patch_matches(&food, &table, 6000);
+    assert(foodbatch_db_delete_by_id(&food, 5000) == SQLITE_OK);
+    test_changes_patch_matches(&food, &table, 5000);
+    test_changes_patch_matches(&food, &table, 5000); // Already gone
+    free(table);
+
+    char block[2048];
+    assert(resident_db_get_format_by_cpf(&residents, "12345679034", block, sizeof(block)) == 0);
+    assert(resident_db_insert(&residents, "98765432100", "Ana Lima", 40, "Healthy", "None", true, 2) == SQLITE_OK);
+    int len = resident_db_get_format_by_cpf(&residents, "98765432100", block, sizeof(block));
+    assert(len > 0 && (size_t)len == strlen(block));
+    assert(strncmp(block, "| 98765432100 | Ana Lima ", 24) == 0 && block[len - 1] == '\n');
+    assert(resident_db_get_format_by_cpf(&residents, "98765432100", block, 16) == -1);
+    assert(db_changes_dispatch() == 4);
+    printf("Single rows formatted like the whole table.\n");
+
+    // Unsubscribed, nothing delivered nor kept
+    db_changes_unsubscribe(batch_sub);
+    db_changes_unsubscribe(people_sub);
+    db_changes_unsubscribe(0);
+    assert(foodbatch_db_insert(&food, 7000, "Oil", 3, false, "", 0.1f) == SQLITE_OK);
+    batch_sub = db_changes_subscribe("FoodBatch", test_changes_record, &batches);
+    assert(db_changes_dispatch() == 0);
+    db_changes_unsubscribe(batch_sub);
+
+    db_deinit(&residents);
+    remove(resident_filename);
+    teardown_cleanup();
+
+    printf("db_changes test passed successfully.\n");
+}
+
+// Another process is a plain connection, without the hooks of db_init()
+void test_db_changes_other_process(void) {
+    const char *food_filename = "test_db_changes_other_food.db";
+    const char *resident_filename = "test_db_changes_other_resident.db";
+    const char *plain_filename = "test_db_changes_other_plain.db";
+    database food;
+    database residents;
+    database plain;
+    remove(food_filename);
+    remove(resident_filename);
+    remove(plain_filename);
+    assert(db_init_with_tbl(&food, food_filename, foodbatch_db_create_table) == SQLITE_OK);
+    assert(db_init_with_tbl(&residents, resident_filename, resident_db_create_table) == SQLITE_OK);
+    assert(db_init(&plain, plain_filename) == SQLITE_OK);
+    setup_cleanup(food_filename, &food);
+
+    printf("Testing db_changes across processes...\n");
+
+    // Files of the builds keeping a ChangeLog lose it and its triggers
+    assert(
+        sqlite3_exec(
+            food.db,
+            "CREATE TABLE ChangeLog (Seq INTEGER PRIMARY KEY, Tbl TEXT);"
+            "CREATE TRIGGER FoodBatch_log_ai AFTER INSERT ON FoodBatch "
+            "BEGIN INSERT INTO ChangeLog (Tbl) VALUES ('x'); END;",
+            0,
+            0,
+            0
+        )
+        == SQLITE_OK
+    );
+    assert(foodbatch_db_create_table(&food) == SQLITE_OK);
+    assert(!db_table_has_column(&food, "ChangeLog", "Seq", NULL));
+    assert(foodbatch_db_insert(&food, 900, "Salt", 1, false, "", 0.1f) == SQLITE_OK); // The trigger would fail
+    assert(foodbatch_db_delete_by_id(&food, 900) == SQLITE_OK);
+
+    sqlite3 *other_food;
+    sqlite3 *other_residents;
+    assert(sqlite3_open(food_filename, &other_food) == SQLITE_OK);
+    assert(sqlite3_open(resident_filename, &other_residents) == SQLITE_OK);
+    assert(sqlite3_exec(plain.db, "CREATE TABLE Plain (Id INTEGER PRIMARY KEY);", 0, 0, 0) == SQLITE_OK);
+
+    struct test_changes batches = { 0 };
+    struct test_changes people = { 0 };
+    int batch_sub = db_changes_subscribe("FoodBatch", test_changes_record, &batches);
+    int people_sub = db_changes_subscribe("Resident", test_changes_record, &people);
+    assert(db_changes_watch(&food, "FoodBatch", "BatchId") == SQLITE_OK);
+    assert(db_changes_watch(&food, "foodbatch", "BatchId") == SQLITE_OK); // Once
+    assert(db_changes_watch(&residents, "Resident", "CPF") == SQLITE_OK);
+    assert(db_changes_watch(&plain, "Plain", "Id") != SQLITE_OK); // Without a stamp
+    assert(db_changes_stamp(&plain, "Plain", "Id") == SQLITE_OK);
+    assert(db_changes_watch(&plain, "Plain", "Id") == SQLITE_OK); // Nobody subscribed, never published
+    assert(db_changes_watch(&food, NULL, "BatchId") == SQLITE_MISUSE);
+
+    int64_t now = (int64_t)perf_now_ns();
+    assert(db_changes_poll(now) == 0);
+
+    // Found once data_version moved, only the rows written
+    const char *insert_sql = "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable, Changed) "
+                             "VALUES (1, 'Milk', 10, 1, " DB_CHANGES_STAMP("FoodBatch") ");";
+    assert(sqlite3_exec(other_food, insert_sql, 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_dispatch() == 0);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&batches, DB_CHANGE_INSERT, 1) && batches.resets == 0 && people.count == 0);
+    printf("Rows committed by another process published as they were written.\n");
+
+    // At most one poll per DB_CHANGES_POLL_NS
+    batches = (struct test_changes) { 0 };
+    const char *update_sql = "UPDATE FoodBatch SET Quantity = 9, " DB_CHANGES_RESTAMP("FoodBatch")
+                             " WHERE BatchId = 1;";
+    assert(sqlite3_exec(other_food, update_sql, 0, 0, 0) == SQLITE_OK);
+    assert(db_changes_poll(now + DB_CHANGES_POLL_NS / 2) == 0);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&batches, DB_CHANGE_UPDATE, 1) && batches.resets == 0);
+
+    // Own writes come from the hooks, the poll skips them until another process commits
+    batches = (struct test_changes) { 0 };
+    assert(foodbatch_db_insert(&food, 2, "Beans", 20, false, "", 1.0f) == SQLITE_OK);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&batches, DB_CHANGE_INSERT, 2));
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 0);
+    printf("Polls rate limited, own writes not published twice.\n");
+
+    // Deleted rows leave a tombstone
+    batches = (struct test_changes) { 0 };
+    assert(sqlite3_exec(other_food, "DELETE FROM FoodBatch WHERE BatchId = 1;", 0, 0, 0) == SQLITE_OK);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    db_changes_dispatch();
+    assert(test_changes_has(&batches, DB_CHANGE_DELETE, 1) && batches.resets == 0);
+
+    // Several commits between two polls, every row
+    people = (struct test_changes) { 0 };
+    for (int i = 0; i < 3; i++) {
+        char sql[512];
+        snprintf(
+            sql,
+            sizeof(sql),
+            "INSERT INTO Resident (CPF, Name, Age, MedicalAssistance, Gender, Changed) "
+            "VALUES (%lld, 'John Doe', 30, 0, 0, " DB_CHANGES_STAMP("Resident") ");",
+            12345678909LL + i * 100000000LL
+        );
+        assert(sqlite3_exec(other_residents, sql, 0, 0, 0) == SQLITE_OK);
+    }
+    const char *rename_sql = "UPDATE Resident SET Name = 'John Roe', " DB_CHANGES_RESTAMP("Resident")
+                             " WHERE CPF = 12345678909;";
+    assert(sqlite3_exec(other_residents, rename_sql, 0, 0, 0) == SQLITE_OK);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 3);
+    assert(people.resets == 0 && test_changes_has(&people, DB_CHANGE_INSERT, 12345678909LL));
+    assert(test_changes_has(&people, DB_CHANGE_INSERT, 12545678909LL));
+    printf("Several commits of another process published row by row.\n");
+
+    // Rows without a stamp (an older build), the watermark cannot tell them
+    batches = (struct test_changes) { 0 };
+    const char *unstamped_sql = "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable) "
+                                "VALUES (3, 'Rice', 5, 0);";
+    assert(sqlite3_exec(other_food, unstamped_sql, 0, 0, 0) == SQLITE_OK);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 1);
+    assert(batches.resets == 1 && batches.count == 0);
+    batches = (struct test_changes) { 0 };
+    assert(sqlite3_exec(other_food, update_sql, 0, 0, 0) == SQLITE_OK); // No row, no stamp
+    assert(sqlite3_exec(other_food, insert_sql, 0, 0, 0) == SQLITE_OK);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 1);
+    assert(test_changes_has(&batches, DB_CHANGE_INSERT, 1) && batches.resets == 0);
+
+    // More rows than DB_CHANGES_MAX_ROWS behind, a single reset
+    batches = (struct test_changes) { 0 };
+    assert(sqlite3_exec(other_food, "BEGIN;", 0, 0, 0) == SQLITE_OK);
+    for (int i = 0; i <= DB_CHANGES_MAX_ROWS; i++) {
+        char sql[512];
+        snprintf(
+            sql,
+            sizeof(sql),
+            "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable, Changed) "
+            "VALUES (%d, 'Bulk', 1, 0, " DB_CHANGES_STAMP("FoodBatch") ");",
+            100 + i
+        );
+        assert(sqlite3_exec(other_food, sql, 0, 0, 0) == SQLITE_OK);
+    }
+    assert(sqlite3_exec(other_food, "COMMIT;", 0, 0, 0) == SQLITE_OK);
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 1);
+    assert(db_changes_dispatch() == 1);
+    assert(batches.resets == 1 && batches.count == 0);
+    printf("Untrusted watermarks reset the table.\n");
+
+    // Nothing changed, what every frame pays
+    const int polls = 1000;
+    uint64_t start = perf_now_ns();
+    for (int i = 0; i < polls; i++) {
+        now += DB_CHANGES_POLL_NS;
+        assert(db_changes_poll(now) == 0);
+    }
+    printf("Unchanged poll of 3 connections: %.2f us.\n", (double)(perf_now_ns() - start) / polls / 1000.0);
+
+    // Closed connections are no longer polled
+    db_changes_unsubscribe(batch_sub);
+    db_changes_unsubscribe(people_sub);
+    sqlite3_close(other_food);
+    sqlite3_close(other_residents);
+    db_deinit(&residents);
+    db_deinit(&plain);
+    remove(resident_filename);
+    remove(plain_filename);
+    teardown_cleanup();
+    now += DB_CHANGES_POLL_NS;
+    assert(db_changes_poll(now) == 0);
+
+    printf("db_changes across processes test passed successfully.\n");
+}
+
+// TEST DB CHANGES END
+
+// TEST DB SERVER START
+
+void test_db_protocol(void) {
+    printf("Testing db_protocol...\n");
+
+    struct db_wire wire = { 0 };
+    db_wire_begin(&wire);
+    db_wire_put_u8(&wire, 7);
+    db_wire_put_u32(&wire, 0xDEADBEEF);
+    size_t result_at = wire.len;
+    db_wire_put_i32(&wire, -5);
+    db_wire_put_i64(&wire, -1234567890123LL);
+    db_wire_put_f64(&wire, 3.25);
+    db_wire_put_str(&wire, "hello");
+    db_wire_put_str(&wire, NULL);
+    db_wire_put_bytes(&wire, "abcdef", 3);
+    db_wire_set_i32(&wire, result_at, -6);
+    assert(db_wire_end(&wire));
+    assert(wire.len == 4 + 1 + 4 + 4 + 8 + 8 + (4 + 5) + 4 + (4 + 3));
+    assert(wire.data[0] == wire.len - 4 && wire.data[1] == 0 && wire.data[2] == 0 && wire.data[3] == 0);
+
+    struct db_wire_reader reader = { wire.data + 4, wire.len - 4, 0, false };
+    assert(db_wire_get_u8(&reader) == 7);
+    assert(db_wire_get_u32(&reader) == 0xDEADBEEF);
+    assert(db_wire_get_i32(&reader) == -6);
+    assert(db_wire_get_i64(&reader) == -1234567890123LL);
+    assert(db_wire_get_f64(&reader) == 3.25);
+    char small[4];
+    assert(db_wire_get_str(&reader, small, sizeof(small)) && strcmp(small, "hel") == 0);
+    assert(!db_wire_get_str(&reader, small, sizeof(small)) && small[0] == '\0');
+    size_t len;
+    const char *bytes = db_wire_get_bytes(&reader, &len);
+    assert(bytes && len == 3 && memcmp(bytes, "abc", 3) == 0);
+    assert(!reader.failed && reader.pos == reader.len);
+    assert(db_wire_get_u32(&reader) == 0 && reader.failed);
+    printf("Values round trip, reading past the end fails.\n");
+
+    // A length past the end of the frame is a failure, not an overread
+    const uint8_t truncated[] = { 0xff, 0, 0, 0, 'a', 'b' };
+    struct db_wire_reader bad = { truncated, sizeof(truncated), 0, false };
+    assert(!db_wire_get_bytes(&bad, &len) && bad.failed);
+
+    // No frame outgrows DB_PROTOCOL_MAX_FRAME
+    char *big = calloc(1, DB_PROTOCOL_MAX_FRAME);
+    assert(big);
+    db_wire_begin(&wire);
+    db_wire_put_bytes(&wire, big, DB_PROTOCOL_MAX_FRAME);
+    assert(wire.failed && !db_wire_end(&wire));
+    free(big);
+    db_wire_free(&wire);
+    printf("Truncated and oversized frames rejected.\n");
+
+    printf("db_protocol test passed successfully.\n");
+}
+
+struct test_server_writer {
+    pthread_t thread;
+    database db; // Food batches, attached to a connection of its own
+    int first;   // First batch id inserted
+    int count;   // Batches inserted
+    bool failed; // An insert failed
+};
+
+static void *test_server_write_batches(void *arg) {
+    struct test_server_writer *writer = arg;
+    for (int i = 0; i < writer->count; i++) {
+        if (foodbatch_db_insert(&writer->db, writer->first + i, "Rice", 10, false, "", 1.0f) != SQLITE_OK) {
+            writer->failed = true;
+        }
+    }
+    return NULL;
+}
+
+// Checks the pages of a remote range query: every batch once, and the server free for the callback
+struct test_server_pages {
+    database *remote; // Connection the callback calls the server through
+    long long id_sum; // Sum of the batch ids received
+    int count;        // Batches received
+    int stop_at;      // Batches after which to stop, 0 for all
+    bool failed;      // A call from the callback failed
+};
+
+static int test_server_collect_batches(void *ctx, const struct foodbatch *foodbatch) {
+    struct test_server_pages *pages = ctx;
+    if (pages->count == 0 && !foodbatch_db_check_batchid_exists(pages->remote, foodbatch->batch_id)) {
+        pages->failed = true;
+    }
+    pages->id_sum += foodbatch->batch_id;
+    pages->count++;
+    return pages->count == pages->stop_at;
+}
+
+void test_db_server(void) {
+    const char *resident_filename = "test_db_server_resident.db";
+    const char *food_filename = "test_db_server_food.db";
+    const char *user_filename = "test_db_server_user.db";
+    const char *socket_path = "test_db_server.sock";
+    database residents;
+    database food;
+    database users;
+    remove(resident_filename);
+    remove(food_filename);
+    remove(user_filename);
+    assert(db_init_with_tbl(&residents, resident_filename, resident_db_create_table) == SQLITE_OK);
+    assert(db_init_with_tbl(&food, food_filename, foodbatch_db_create_table) == SQLITE_OK);
+    assert(db_init_with_tbl(&users, user_filename, user_db_create_table) == SQLITE_OK);
+    setup_cleanup(food_filename, &food);
+
+    printf("Testing db_server...\n");
+
+    int users_before = user_db_get_count(&users);
+    struct db_server *server = db_server_start(socket_path, &residents, &food, &users, NULL);
+    assert(server);
+    assert(!db_server_start(socket_path, &residents, &food, &users, NULL)); // Already served
+
+    struct db_client *client = db_client_connect(socket_path);
+    assert(client && db_client_connected(client));
+    database remote_residents;
+    database remote_food;
+    database remote_users;
+    db_client_attach(client, &remote_residents);
+    db_client_attach(client, &remote_food);
+    db_client_attach(client, &remote_users);
+    assert(db_is_remote(&remote_residents) && !db_is_init(&remote_residents) && !db_is_remote(&residents));
+
+    // Residents, same results as on the file
+    int rc = resident_db_insert(&remote_residents, "12345678909", "John Doe", 30, "Healthy", "None", false, 1);
+    assert(rc == SQLITE_OK);
+    rc = resident_db_insert(&remote_residents, "12345678909", "John Doe", 30, "Healthy", "None", false, 1);
+    assert(rc != SQLITE_OK);
+    assert(resident_db_check_cpf_exists(&remote_residents, "12345678909"));
+    assert(!resident_db_check_cpf_exists(&remote_residents, "23456789092"));
+    assert(resident_db_update(&remote_residents, "12345678909", "", 31, "", "", -1, -1) == SQLITE_OK);
+    struct resident resident;
+    assert(resident_db_get_by_cpf(&remote_residents, "12345678909", &resident) == SQLITE_OK);
+    assert(strcmp(resident.name, "John Doe") == 0 && resident.age == 31 && resident.gender == 1);
+    assert(resident.cpf_packed == 12345678909 && strcmp(resident.cpf, "12345678909") == 0);
+    assert(resident_db_get_by_cpf(&remote_residents, "23456789092", &resident) != SQLITE_OK);
+    assert(resident_db_get_count(&remote_residents) == 1);
+    char buffer[4096];
+    assert(resident_db_get_all_format(&remote_residents, buffer, sizeof(buffer)) > 0 && strstr(buffer, "John Doe"));
+    assert(resident_db_get_format_by_cpf(&remote_residents, "12345678909", buffer, sizeof(buffer)) > 0);
+    assert(strstr(buffer, "John Doe"));
+    assert(resident_db_delete_by_cpf(&remote_residents, "23456789092") == SQLITE_NOTFOUND);
+    struct resident_duplicate duplicates[RESIDENT_DEDUPE_MAX_CANDIDATES];
+    assert(resident_db_find_duplicates(&remote_residents, "Jon Doe", NULL, 0.5f, duplicates, 5) == 1);
+    assert(strcmp(duplicates[0].cpf, "12345678909") == 0 && duplicates[0].similarity >= 0.5f);
+    int duplicate_count = -1;
+    rc = resident_db_insert_checked(
+        &remote_residents,
+        "23456789092",
+        "John Doe",
+        50,
+        "",
+        "",
+        false,
+        1,
+        0.5f,
+        duplicates,
+        RESIDENT_DEDUPE_MAX_CANDIDATES,
+        &duplicate_count
+    );
+    assert(rc == SQLITE_OK && duplicate_count == 1 && strcmp(duplicates[0].name, "John Doe") == 0);
+    assert(resident_db_delete_by_cpf(&remote_residents, "23456789092") == SQLITE_OK);
+    struct test_search_names entered = { 0 };
+    int32_t today = date_today();
+    assert(resident_db_entered_between(&remote_residents, today - 1, today, test_collect_search_names, &entered) == 1);
+    assert(strcmp(entered.names[0], "John Doe") == 0);
+    rc = resident_db_entered_between(&remote_residents, today + 1, today + 9, test_collect_search_names, &entered);
+    assert(rc == 0);
+    struct test_search_names found = { 0 };
+    assert(resident_db_search(&remote_residents, "joh", 5, test_collect_search_names, &found) == 1);
+    assert(strcmp(found.names[0], "John Doe") == 0);
+    assert(resident_db_search(&remote_residents, "nobody", 5, test_collect_search_names, &found) == 0);
+    struct resident_search *search = resident_search_start(&remote_residents);
+    assert(search);
+    resident_search_submit(search, "doe");
+    struct resident results[RESIDENT_SEARCH_MAX_RESULTS];
+    int result_count = 0;
+    unsigned generation = 0;
+    bool updated = false;
+    for (int i = 0; i < 200 && !updated; i++) {
+        updated = resident_search_poll(search, results, &result_count, &generation);
+        if (!updated) {
+            nanosleep(&(struct timespec) { 0, 10 * 1000000L }, NULL);
+        }
+    }
+    assert(updated && result_count == 1 && strcmp(results[0].cpf, "12345678909") == 0);
+    resident_search_stop(search);
+    printf("Resident calls forwarded, searches included.\n");
+
+    // Food batches, a failing write changes nothing
+    assert(foodbatch_db_insert(&remote_food, 1, "Milk", 10, true, "2030-01-01", 1.5f) == SQLITE_OK);
+    assert(foodbatch_db_take_quantity(&remote_food, 1, 4) == SQLITE_OK);
+    assert(foodbatch_db_take_quantity(&remote_food, 1, 100) != SQLITE_OK);
+    struct foodbatch batch;
+    assert(foodbatch_db_get_by_batchid(&remote_food, 1, &batch) == SQLITE_OK);
+    assert(batch.quantity == 6 && batch.is_perishable && strcmp(batch.expiration_date, "2030-01-01") == 0);
+    assert(batch.daily_consumption_rate == 1.5f && strcmp(batch.name, "Milk") == 0);
+    assert(foodbatch_db_check_batchid_exists(&remote_food, 1) && !foodbatch_db_check_batchid_exists(&remote_food, 2));
+    assert(foodbatch_db_get_count(&remote_food) == 1);
+    assert(foodbatch_db_get_format_by_batchid(&remote_food, 1, buffer, sizeof(buffer)) > 0 && strstr(buffer, "Milk"));
+    struct test_batch_ids expiring = { 0 };
+    int32_t milk_day = date_parse("2030-01-01");
+    assert(foodbatch_db_expiring_between(&remote_food, milk_day, milk_day, test_collect_batch_ids, &expiring) == 1);
+    assert(expiring.ids[0] == 1);
+    printf("Food batch calls forwarded.\n");
+
+    // Expiration alerts load through the server and follow the writes of this client (the
+    // server runs in this process here, its own commits are published too)
+    struct expiration_alerts *alerts = expiration_alerts_load(&remote_food, NULL);
+    assert(alerts && expiration_alerts_next(alerts) && expiration_alerts_next(alerts)->id == 1);
+    assert(foodbatch_db_insert(&remote_food, 2, "Yogurt", 3, true, "2029-12-01", 1.0f) == SQLITE_OK);
+    assert(db_changes_dispatch() >= 1);
+    assert(expiration_alerts_next(alerts)->id == 2);
+    assert(foodbatch_db_delete_by_id(&remote_food, 2) == SQLITE_OK);
+    assert(db_changes_dispatch() >= 1);
+    assert(expiration_alerts_next(alerts)->id == 1);
+    expiration_alerts_free(alerts);
+    printf("Expiration alerts kept up to date through the server.\n");
+
+    // So does the food forecast, undated batches included
+    struct food_forecast *forecast = food_forecast_load(&remote_food, &remote_residents);
+    assert(forecast);
+    struct food_forecast_summary forecast_summary;
+    food_forecast_summary(forecast, today, &forecast_summary);
+    assert(forecast_summary.batches == 1 && forecast_summary.residents == 1);
+    assert(forecast_summary.first_runout_days == 4.0f && strcmp(forecast_summary.first_runout_name, "Milk") == 0);
+    assert(foodbatch_db_insert(&remote_food, 3, "Rice", 20, false, "", 0.5f) == SQLITE_OK);
+    assert(resident_db_insert(&remote_residents, "23456789092", "Mary Doe", 40, "", "", false, 1) == SQLITE_OK);
+    assert(db_changes_dispatch() >= 2);
+    food_forecast_refresh(forecast);
+    food_forecast_summary(forecast, today, &forecast_summary);
+    assert(forecast_summary.batches == 2 && forecast_summary.residents == 2);
+    assert(forecast_summary.first_runout_days == 2.0f); // Milk, 6 / (1.5 * 2)
+    assert(foodbatch_db_delete_by_id(&remote_food, 3) == SQLITE_OK);
+    assert(resident_db_delete_by_cpf(&remote_residents, "23456789092") == SQLITE_OK);
+    assert(db_changes_dispatch() >= 2);
+    food_forecast_refresh(forecast);
+    food_forecast_summary(forecast, today, &forecast_summary);
+    assert(forecast_summary.batches == 1 && forecast_summary.residents == 1);
+    food_forecast_free(forecast);
+    printf("Food forecast kept up to date through the server.\n");
+
+    // Distribution planned from the batches in stock, applied by the server in one transaction
+    struct food_request milk_request = { .name = "MILK", .quantity = 4 };
+    struct food_plan plan = { 0 };
+    assert(food_plan_build(&remote_food, &milk_request, 1, today, &plan) == SQLITE_OK);
+    assert(plan.pick_count == 1 && plan.picks[0].batch_id == 1 && plan.allocated_total == 4);
+    assert(food_plan_apply(&remote_food, &plan) == SQLITE_OK);
+    assert(foodbatch_db_get_by_batchid(&remote_food, 1, &batch) == SQLITE_OK && batch.quantity == 2);
+    assert(food_plan_apply(&remote_food, &plan) != SQLITE_OK); // Only 2 left
+    struct food_pick picks[2] = { { .batch_id = 1, .quantity = 1 }, { .batch_id = 999, .quantity = 1 } };
+    struct food_plan partial = { .picks = picks, .pick_count = 2 };
+    assert(food_plan_apply(&remote_food, &partial) != SQLITE_OK);
+    assert(foodbatch_db_get_by_batchid(&remote_food, 1, &batch) == SQLITE_OK && batch.quantity == 2);
+    food_plan_free(&plan);
+    printf("Distribution plans built and applied through the server.\n");
+
+    // Range queries larger than a reply arrive in pages
+    enum { paged = 10000 };
+    database food_writer;
+    assert(db_init(&food_writer, food_filename) == SQLITE_OK);
+    sqlite3_busy_timeout(food_writer.db, 5000);
+    char sql[512];
+    snprintf(
+        sql,
+        sizeof(sql),
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < %d) "
+        "INSERT INTO FoodBatch (BatchId, Name, Quantity, IsPerishable, ExpirationDate, DailyConsumptionRate) "
+        "SELECT 100000 + i, 'Canned beans', 1, 0, %d + i %% 7, 1.0 FROM n;",
+        (int)paged,
+        (int)(milk_day + 1)
+    );
+    assert(sqlite3_exec(food_writer.db, sql, 0, 0, 0) == SQLITE_OK);
+    struct test_server_pages pages = { .remote = &remote_food };
+    rc = foodbatch_db_expiring_between(&remote_food, milk_day + 1, milk_day + 7, test_server_collect_batches, &pages);
+    assert(rc == paged && pages.count == paged && !pages.failed);
+    assert(pages.id_sum == 100000LL * paged + (long long)paged * (paged + 1) / 2);
+    pages = (struct test_server_pages) { .remote = &remote_food, .stop_at = paged - 10 };
+    rc = foodbatch_db_expiring_between(&remote_food, milk_day + 1, milk_day + 7, test_server_collect_batches, &pages);
+    assert(rc == paged - 10 && pages.count == paged - 10);
+    pages = (struct test_server_pages) { .remote = &remote_food };
+    rc = foodbatch_db_in_stock(&remote_food, test_server_collect_batches, &pages);
+    assert(rc == paged + 1 && pages.count == paged + 1 && !pages.failed); // And the milk
+    assert(pages.id_sum == 1 + 100000LL * paged + (long long)paged * (paged + 1) / 2);
+    assert(sqlite3_exec(food_writer.db, "DELETE FROM FoodBatch WHERE BatchId > 100000;", 0, 0, 0) == SQLITE_OK);
+    db_deinit(&food_writer);
+    printf("%d batches received in pages, stopping early works.\n", (int)paged);
+
+    // Users, the password is checked on the server and its hash never leaves it
+    assert(user_db_create_user(&remote_users, "clerk", "00000000000", "", false) == SQLITE_OK);
+    assert(user_db_create_user(&remote_users, "clerk", "11111111111", "", false) != SQLITE_OK);
+    assert(user_db_authenticate(&remote_users, "clerk", "secret1") == AUTH_NEED_PASSWORD_RESET);
+    assert(user_db_update_password(&remote_users, "clerk", "secret1") == SQLITE_OK);
+    assert(user_db_authenticate(&remote_users, "clerk", "wrong") == AUTH_FAILURE);
+    struct user_auth *auth = user_db_authenticate_start(&remote_users, "clerk", "secret1");
+    enum auth_result result;
+    while (!user_db_authenticate_poll(auth, &remote_users, &result)) {
+        sched_yield();
+    }
+    assert(result == AUTH_SUCCESS);
+    assert(user_db_update_admin_status(&remote_users, "clerk", true) == SQLITE_OK);
+    assert(user_db_check_exists(&remote_users, "clerk") && user_db_check_admin_status(&remote_users, "clerk"));
+    assert(user_db_check_cpf_exists(&remote_users, "00000000000"));
+    struct user user;
+    assert(user_db_get_by_username(&remote_users, "clerk", &user) == SQLITE_OK);
+    assert(strcmp(user.cpf, "00000000000") == 0 && user.is_admin && user.last_login > 0);
+    assert(user.password_hash[0] == '\0' && user.salt[0] == '\0');
+    assert(user_db_get_count(&remote_users) == users_before + 1);
+    assert(user_db_get_all_format(&remote_users, buffer, sizeof(buffer)) > 0 && strstr(buffer, "clerk"));
+    printf("User calls forwarded, password hashes stay on the server.\n");
+
+    // Clients writing at once share commits
+    struct db_server_stats before;
+    struct db_server_stats after;
+    db_server_get_stats(server, &before);
+    enum { writers = 8, per_writer = 50 };
+    struct test_server_writer threads[writers];
+    struct db_client *clients[writers];
+    for (int i = 0; i < writers; i++) {
+        clients[i] = db_client_connect(socket_path);
+        assert(clients[i]);
+        threads[i] = (struct test_server_writer) { .first = 100 + i * per_writer, .count = per_writer };
+        db_client_attach(clients[i], &threads[i].db);
+    }
+    for (int i = 0; i < writers; i++) {
+        assert(pthread_create(&threads[i].thread, NULL, test_server_write_batches, &threads[i]) == 0);
+    }
+    for (int i = 0; i < writers; i++) {
+        pthread_join(threads[i].thread, NULL);
+        assert(!threads[i].failed);
+        db_deinit(&threads[i].db);
+        db_client_close(clients[i]);
+    }
+    db_server_get_stats(server, &after);
+    uint64_t writes = after.writes - before.writes;
+    uint64_t commits = after.commits - before.commits;
+    assert(writes == writers * per_writer && commits < writes);
+    assert(foodbatch_db_get_count(&remote_food) == 1 + writers * per_writer);
+    printf(
+        "%llu writes from %d clients in %llu commits.\n",
+        (unsigned long long)writes,
+        writers,
+        (unsigned long long)commits
+    );
+
+    // Server gone, every call fails and the data is in the files
+    db_server_stop(server);
+    assert(resident_db_get_count(&remote_residents) == -1);
+    assert(!db_client_connected(client));
+    assert(foodbatch_db_insert(&remote_food, 2, "Beans", 1, false, "", 1.0f) == SQLITE_IOERR);
+    assert(user_db_authenticate(&remote_users, "clerk", "secret1") == AUTH_FAILURE);
+    assert(resident_db_get_count(&residents) == 1 && foodbatch_db_get_count(&food) == 1 + writers * per_writer);
+    assert(user_db_get_by_username(&users, "clerk", &user) == SQLITE_OK && user.last_login > 0);
+    printf("Calls fail with SQLITE_IOERR once the server stopped.\n");
+
+    db_deinit(&remote_residents);
+    db_deinit(&remote_food);
+    db_deinit(&remote_users);
+    db_client_close(client);
+    db_deinit(&residents);
+    db_deinit(&users);
+    remove(resident_filename);
+    remove(user_filename);
+    teardown_cleanup();
+
+    printf("db_server test passed successfully.\n");
+}
+
+// TEST DB SERVER END
+
+// TEST DB USER START
+
+void test_user_db_create_table(void) {
+    const char *test_userdb_filename = "test_user_db.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing user_db_create_table...\n");
+
+    // Verify admin user was created
+    bool admin_exists = user_db_check_exists(&test_user_db, "admin");
+    assert(admin_exists);
+    printf("Admin user created successfully.\n");
+
+    // Verify table structure by trying to insert a user
+    int rc = user_db_create_user(
+        &test_user_db,
+        "testuser",      // username
+        "12345678901",   // cpf (sample)
+        "5551900100200", // phone number
+        false            // is_admin
+    );
+    assert(rc == SQLITE_OK);
+    printf("Table structure is correct.\n");
+
+    teardown_cleanup();
+
+    printf("user_db_create_table test passed successfully.\n");
+}
+
+void test_user_db_create_user(void) {
+    const char *test_userdb_filename = "test_user_db.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing user_db_create_user...\n");
+
+    // Test creating a regular user
+    printf("Creating regular user 'user1'...\n");
+    int rc = user_db_create_user(&test_user_db, "user1", "00000000000", "1234567890123", false);
+    assert(rc == SQLITE_OK);
+    printf("Regular user created successfully.\n");
+
+    // Test creating an admin user
+    printf("Creating admin user 'admin2'...\n");
+    rc = user_db_create_user(&test_user_db, "admin2", "11111111111", "1234567890123", true);
+    assert(rc == SQLITE_OK);
+    printf("Admin user created successfully.\n");
+
+    // Test creating duplicate user
+    printf("Attempting to create duplicate user 'user1' by username...\n");
+    rc = user_db_create_user(&test_user_db, "user1", "87655366273", "", false);
+    assert(rc == SQLITE_CONSTRAINT);
+    printf("Duplicate user creation failed as expected.\n");
+
+    printf("Attempting to create duplicate user by CPF...\n");
+    rc = user_db_create_user(&test_user_db, "user2", "00000000000", "", false);
+    assert(rc == SQLITE_CONSTRAINT);
+    printf("Duplicate user creation failed as expected.\n");
+
+    teardown_cleanup();
+
+    printf("user_db_create_user test passed successfully.\n");
+}
+
+void test_user_db_authenticate(void) {
+    const char *test_userdb_filename = "test_user_db.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing user_db_authenticate...\n");
+
+    // Create a test user with known password
     const char *username = "testuser";
     const char *password = "password123";
 
@@ -1280,6 +4834,296 @@ void test_user_db_authenticate(void) {
     printf("user_db_authenticate test passed successfully.\n");
 }
 
+// Kdf and KdfIterations of a user, straight from the table
+static struct password_kdf_params test_user_stored_kdf(database *db, const char *username) {
+    struct user user = { 0 };
+    assert(user_db_get_by_username(db, username, &user) == SQLITE_OK);
+    return user.kdf;
+}
+
+void test_user_db_authenticate_kdf(void) {
+    const char *test_userdb_filename = "test_user_db_kdf.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing user_db_authenticate hash upgrades...\n");
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+
+    // Default admin is hashed with the current KDF
+    struct password_kdf_params kdf = test_user_stored_kdf(&test_user_db, "admin");
+    assert(kdf.kdf == PASSWORD_KDF_PBKDF2_SHA256 && kdf.iterations == PASSWORD_KDF_MIN_ITERATIONS);
+    assert(user_db_authenticate(&test_user_db, "admin", "admin") == AUTH_SUCCESS);
+
+    // Account from before the KDF: single SHA-256, upgraded on the next successful login
+    char salt[SALT_LEN + 1];
+    char hash[PASSWORD_HASH_LEN + 1];
+    generate_salt(salt, SALT_LEN);
+    hash_password("legacy pass", salt, hash);
+    char *sql = sqlite3_mprintf(
+        "UPDATE Users SET PasswordHash = %Q, Salt = %Q, Kdf = 0, KdfIterations = 0 WHERE Username = 'admin';",
+        hash,
+        salt
+    );
+    assert(sqlite3_exec(test_user_db.db, sql, 0, 0, 0) == SQLITE_OK);
+    sqlite3_free(sql);
+
+    assert(user_db_authenticate(&test_user_db, "admin", "wrong") == AUTH_FAILURE);
+    assert(test_user_stored_kdf(&test_user_db, "admin").kdf == PASSWORD_KDF_SHA256); // Not on a failure
+    assert(user_db_authenticate(&test_user_db, "admin", "legacy pass") == AUTH_SUCCESS);
+    kdf = test_user_stored_kdf(&test_user_db, "admin");
+    assert(kdf.kdf == PASSWORD_KDF_PBKDF2_SHA256 && kdf.iterations == PASSWORD_KDF_MIN_ITERATIONS);
+    assert(user_db_authenticate(&test_user_db, "admin", "legacy pass") == AUTH_SUCCESS);
+    assert(user_db_authenticate(&test_user_db, "admin", "wrong") == AUTH_FAILURE);
+
+    // Higher cost: upgraded again, a lower one does not downgrade
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS * 2);
+    assert(user_db_authenticate(&test_user_db, "admin", "legacy pass") == AUTH_SUCCESS);
+    assert(test_user_stored_kdf(&test_user_db, "admin").iterations == PASSWORD_KDF_MIN_ITERATIONS * 2);
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+    assert(user_db_authenticate(&test_user_db, "admin", "legacy pass") == AUTH_SUCCESS);
+    assert(test_user_stored_kdf(&test_user_db, "admin").iterations == PASSWORD_KDF_MIN_ITERATIONS * 2);
+
+    // On the worker thread
+    struct user_auth *auth = user_db_authenticate_start(&test_user_db, "admin", "legacy pass");
+    assert(auth);
+    enum auth_result result = AUTH_FAILURE;
+    while (!user_db_authenticate_poll(auth, &test_user_db, &result)) {
+        continue;
+    }
+    assert(result == AUTH_SUCCESS);
+
+    auth = user_db_authenticate_start(&test_user_db, "admin", "wrong");
+    assert(auth);
+    while (!user_db_authenticate_poll(auth, &test_user_db, &result)) {
+        continue;
+    }
+    assert(result == AUTH_FAILURE);
+
+    // Settled without the worker
+    auth = user_db_authenticate_start(&test_user_db, "nobody", "x");
+    assert(auth && user_db_authenticate_poll(auth, &test_user_db, &result) && result == AUTH_FAILURE);
+    assert(user_db_create_user(&test_user_db, "newuser", "00000000000", "", false) == SQLITE_OK);
+    auth = user_db_authenticate_start(&test_user_db, "newuser", "x");
+    assert(auth && user_db_authenticate_poll(auth, &test_user_db, &result) && result == AUTH_NEED_PASSWORD_RESET);
+
+    // Dropped while running, nothing written
+    sqlite3_int64 before = 0;
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(test_user_db.db, "SELECT LastLogin FROM Users WHERE Username = 'admin';", -1, &stmt, 0);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    before = sqlite3_column_int64(stmt, 0);
+    sqlite3_reset(stmt);
+    assert(sqlite3_exec(test_user_db.db, "UPDATE Users SET LastLogin = 1 WHERE Username = 'admin';", 0, 0, 0)
+           == SQLITE_OK);
+    user_db_authenticate_cancel(user_db_authenticate_start(&test_user_db, "admin", "legacy pass"));
+    user_db_authenticate_cancel(NULL);
+    assert(sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int64(stmt, 0) == 1);
+    sqlite3_finalize(stmt);
+    assert(before > 1);
+
+    teardown_cleanup();
+
+    printf("user_db_authenticate hash upgrades test passed successfully.\n");
+}
+
+void test_user_db_migrate_kdf(void) {
+    const char *test_userdb_filename = "test_user_db_migrate.db";
+    database test_user_db;
+    assert(db_init(&test_user_db, test_userdb_filename) == SQLITE_OK);
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing Users table migration to the KDF columns...\n");
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+
+    // Table as created before the KDF columns existed
+    char hash[PASSWORD_HASH_LEN + 1];
+    hash_password("old password", "oldsalt", hash);
+    char *sql = sqlite3_mprintf(
+        "DROP TABLE IF EXISTS Users;"
+        "CREATE TABLE Users (Username TEXT PRIMARY KEY NOT NULL, PasswordHash TEXT, Salt TEXT, PhoneNumber TEXT,"
+        "CPF TEXT UNIQUE NOT NULL, IsAdmin INTEGER NOT NULL DEFAULT 0, ResetPassword INTEGER NOT NULL DEFAULT 1,"
+        "CreatedAt INTEGER NOT NULL, LastLogin INTEGER);"
+        "INSERT INTO Users (Username, PasswordHash, Salt, CPF, IsAdmin, ResetPassword, CreatedAt) "
+        "VALUES ('admin', %Q, 'oldsalt', '99999999999', 1, 0, 0);",
+        hash
+    );
+    assert(sqlite3_exec(test_user_db.db, sql, 0, 0, 0) == SQLITE_OK);
+    sqlite3_free(sql);
+
+    assert(user_db_create_table(&test_user_db) == SQLITE_OK);
+    assert(db_table_has_column(&test_user_db, "Users", "Kdf", NULL));
+    assert(db_table_has_column(&test_user_db, "Users", "KdfIterations", NULL));
+    assert(test_user_stored_kdf(&test_user_db, "admin").kdf == PASSWORD_KDF_SHA256);
+    assert(user_db_create_table(&test_user_db) == SQLITE_OK); // Already migrated
+
+    assert(user_db_authenticate(&test_user_db, "admin", "old password") == AUTH_SUCCESS);
+    assert(test_user_stored_kdf(&test_user_db, "admin").kdf == PASSWORD_KDF_PBKDF2_SHA256);
+    assert(user_db_authenticate(&test_user_db, "admin", "old password") == AUTH_SUCCESS);
+
+    teardown_cleanup();
+
+    printf("Users table migration test passed successfully.\n");
+}
+
+// LastLogin straight from the table, 0 if NULL
+static int64_t test_user_stored_last_login(database *db, const char *username) {
+    sqlite3_stmt *stmt;
+    assert(sqlite3_prepare_v2(db->db, "SELECT LastLogin FROM Users WHERE Username = ?;", -1, &stmt, 0) == SQLITE_OK);
+    sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
+    assert(sqlite3_step(stmt) == SQLITE_ROW);
+    int64_t last_login = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return last_login;
+}
+
+void test_user_db_last_login_queue(void) {
+    const char *test_userdb_filename = "test_user_db_last_login.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing the LastLogin write-behind queue...\n");
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+
+    // Queued, not written, one entry per user
+    assert(user_db_authenticate(&test_user_db, "admin", "admin") == AUTH_SUCCESS);
+    assert(user_db_authenticate(&test_user_db, "admin", "admin") == AUTH_SUCCESS);
+    assert(user_db_last_login_pending(&test_user_db) == 1);
+    assert(test_user_stored_last_login(&test_user_db, "admin") == 0);
+    assert(user_db_authenticate(&test_user_db, "admin", "wrong") == AUTH_FAILURE);
+    assert(user_db_last_login_pending(&test_user_db) == 1);
+
+    // Logins just happened, not idle yet
+    assert(user_db_flush_last_login(&test_user_db, false) == SQLITE_OK);
+    assert(user_db_last_login_pending(&test_user_db) == 1);
+    assert(user_db_flush_last_login(&test_user_db, true) == SQLITE_OK);
+    assert(user_db_last_login_pending(&test_user_db) == 0);
+    assert(test_user_stored_last_login(&test_user_db, "admin") > 0);
+
+    // Readers of LastLogin see the queued times
+    assert(sqlite3_exec(test_user_db.db, "UPDATE Users SET LastLogin = NULL;", 0, 0, 0) == SQLITE_OK);
+    assert(user_db_authenticate(&test_user_db, "admin", "admin") == AUTH_SUCCESS);
+    struct user user = { 0 };
+    assert(user_db_get_by_username(&test_user_db, "admin", &user) == SQLITE_OK);
+    assert(user.last_login > 0 && user_db_last_login_pending(&test_user_db) == 0);
+
+    // A full batch is written without waiting
+    char username[32];
+    for (int i = 0; i < USER_DB_LAST_LOGIN_BATCH; i++) {
+        snprintf(username, sizeof(username), "volunteer%d", i);
+        char cpf[MAX_CPF_LENGTH];
+        snprintf(cpf, sizeof(cpf), "%011d", i);
+        assert(user_db_create_user(&test_user_db, username, cpf, "", false) == SQLITE_OK);
+        assert(user_db_update_password(&test_user_db, username, "pass") == SQLITE_OK);
+    }
+    for (int i = 0; i < USER_DB_LAST_LOGIN_BATCH - 1; i++) {
+        snprintf(username, sizeof(username), "volunteer%d", i);
+        assert(user_db_authenticate(&test_user_db, username, "pass") == AUTH_SUCCESS);
+    }
+    assert(user_db_last_login_pending(&test_user_db) == USER_DB_LAST_LOGIN_BATCH - 1);
+    assert(test_user_stored_last_login(&test_user_db, "volunteer0") == 0);
+    snprintf(username, sizeof(username), "volunteer%d", USER_DB_LAST_LOGIN_BATCH - 1);
+    assert(user_db_authenticate(&test_user_db, username, "pass") == AUTH_SUCCESS);
+    assert(user_db_last_login_pending(&test_user_db) == 0);
+    assert(test_user_stored_last_login(&test_user_db, "volunteer0") > 0);
+    assert(test_user_stored_last_login(&test_user_db, username) > 0);
+
+    // Queued logins of a closed connection are dropped, not written to the next one
+    assert(user_db_authenticate(&test_user_db, "volunteer0", "pass") == AUTH_SUCCESS);
+    database other_db;
+    assert(db_init_with_tbl(&other_db, "test_user_db_last_login_other.db", user_db_create_table) == SQLITE_OK);
+    assert(user_db_last_login_pending(&other_db) == 0);
+    assert(user_db_authenticate(&other_db, "admin", "admin") == AUTH_SUCCESS);
+    assert(user_db_last_login_pending(&test_user_db) == 0);
+    assert(user_db_flush_last_login(&other_db, true) == SQLITE_OK);
+    db_deinit(&other_db);
+    remove("test_user_db_last_login_other.db");
+
+    teardown_cleanup();
+
+    printf("LastLogin write-behind queue test passed successfully.\n");
+}
+
+void test_user_roster_provision(void) {
+    const char *test_userdb_filename = "test_user_db_roster.db";
+    database test_user_db;
+    db_init_with_tbl(&test_user_db, test_userdb_filename, user_db_create_table);
+    setup_cleanup(test_userdb_filename, &test_user_db);
+
+    printf("Testing user_roster_provision...\n");
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+    assert(user_db_create_user(&test_user_db, "existing", "11111111111", "", false) == SQLITE_OK);
+
+    FILE *file = tmpfile();
+    assert(file);
+    fputs(
+        "# Volunteers\n"
+        "username,cpf,phone_number,admin,password\n"
+        "ana, 22222222222 ,5551999999999,yes,temp pass\n"
+        "\n"
+        "bruno,33333333333\r\n"
+        "carla,3333333333\n"             // CPF too short
+        "existing,44444444444\n"          // Username of an existing user
+        "davi,11111111111\n"              // CPF of an existing user
+        "ana,55555555555\n"               // Username of an earlier row
+        "edu,22222222222\n"               // CPF of an earlier row
+        "fabi,66666666666,123\n"          // Phone number too short
+        "gil,77777777777,,maybe\n"        // Admin neither yes nor no
+        "hugo,88888888888,,0,,extra\n",   // Too many fields
+        file
+    );
+    rewind(file);
+
+    struct user_roster roster = { 0 };
+    assert(user_roster_read(&roster, file) == 10);
+    fclose(file);
+    assert(roster.entries[0].line == 3 && roster.entries[0].status == ROSTER_PENDING);
+    assert(strcmp(roster.entries[0].cpf, "22222222222") == 0 && roster.entries[0].is_admin);
+    assert(roster.entries[2].status == ROSTER_INVALID);
+    assert(user_roster_add(&roster, "ivo", "99999999990", NULL, false, NULL) == ROSTER_PENDING);
+    assert(user_roster_add(&roster, "", "99999999991", NULL, false, NULL) == ROSTER_INVALID);
+
+    struct roster_report report;
+    assert(user_roster_provision(&test_user_db, &roster, 4, &report) == SQLITE_OK);
+    assert(report.created == 3);
+    assert(report.invalid == 5);
+    assert(report.username_exists == 2);
+    assert(report.cpf_exists == 2);
+    assert(user_db_get_count(&test_user_db) == 5); // admin, existing, ana, bruno, ivo
+
+    // Given password kept, missing ones generated, all hashed and to be changed on first login
+    struct user user = { 0 };
+    assert(user_db_get_by_username(&test_user_db, "ana", &user) == SQLITE_OK);
+    assert(user.is_admin && user.reset_password && strcmp(user.phone_number, "5551999999999") == 0);
+    assert(user.kdf.kdf == PASSWORD_KDF_PBKDF2_SHA256 && user.kdf.iterations == PASSWORD_KDF_MIN_ITERATIONS);
+    assert(verify_password("temp pass", user.salt, user.kdf, user.password_hash));
+    assert(!roster.entries[0].generated_password);
+
+    assert(user_db_get_by_username(&test_user_db, "bruno", &user) == SQLITE_OK);
+    assert(!user.is_admin && user.reset_password);
+    assert(roster.entries[1].generated_password && strlen(roster.entries[1].password) == ROSTER_PASSWORD_LEN);
+    assert(verify_password(roster.entries[1].password, user.salt, user.kdf, user.password_hash));
+    assert(user_db_authenticate(&test_user_db, "bruno", roster.entries[1].password) == AUTH_NEED_PASSWORD_RESET);
+
+    // Provisioning the same roster again creates nobody
+    for (size_t i = 0; i < roster.count; i++) {
+        if (roster.entries[i].status == ROSTER_CREATED) {
+            roster.entries[i].status = ROSTER_PENDING;
+        }
+    }
+    assert(user_roster_provision(&test_user_db, &roster, 0, &report) == SQLITE_OK);
+    assert(report.created == 0 && report.username_exists == 5);
+    assert(user_db_get_count(&test_user_db) == 5);
+
+    user_roster_free(&roster);
+    assert(roster.count == 0 && roster.entries == NULL);
+
+    teardown_cleanup();
+
+    printf("user_roster_provision test passed successfully.\n");
+}
+
 void test_user_db_delete(void) {
     const char *test_userdb_filename = "test_user_db.db";
     database test_user_db;
@@ -2064,6 +5908,36 @@ void test_wrap_text(void) {
     printf("wrap_text test passed successfully.\n");
 }
 
+void test_table_text_patch(void) {
+    printf("Testing table_text_patch...\n");
+
+    const char *start = "+---+\n| K | V |\n+---+\n|  1 | a |\n+---+\n| 20 | b |\n+---+\n";
+    char *text = malloc(strlen(start) + 1);
+    assert(text);
+    strcpy(text, start);
+
+    // Replaced in place, the header is not a row
+    assert(table_text_patch(&text, "1", "| 1 | longer |\n+-------+\n") == 0);
+    assert(strcmp(text, "+---+\n| K | V |\n+---+\n| 1 | longer |\n+-------+\n| 20 | b |\n+---+\n") == 0);
+    printf("Row replaced.\n");
+
+    // Appended when missing, a key that only prefixes another does not match
+    assert(table_text_patch(&text, "2", "| 2 | c |\n+---+\n") == 0);
+    assert(
+        strcmp(text, "+---+\n| K | V |\n+---+\n| 1 | longer |\n+-------+\n| 20 | b |\n+---+\n| 2 | c |\n+---+\n") == 0
+    );
+    printf("Row appended.\n");
+
+    // Removed with its separator, removing a missing row does nothing
+    assert(table_text_patch(&text, "20", NULL) == 0);
+    assert(table_text_patch(&text, "3", NULL) == 0);
+    assert(strcmp(text, "+---+\n| K | V |\n+---+\n| 1 | longer |\n+-------+\n| 2 | c |\n+---+\n") == 0);
+    printf("Row removed.\n");
+
+    free(text);
+    printf("table_text_patch test passed successfully.\n");
+}
+
 void test_filter_integer_input(void) {
     printf("Testing filter_integer_input...\n");
 
@@ -2131,6 +6005,395 @@ void test_validate_date(void) {
     printf("validate_date test passed successfully.\n");
 }
 
+void test_date_days(void) {
+    printf("Testing date day numbers...\n");
+    assert(date_to_days(1970, 1, 1) == 0);
+    assert(date_to_days(1969, 12, 31) == -1);
+    assert(date_to_days(2024, 1, 1) == 19723);
+    assert(date_to_days(2024, 3, 1) - date_to_days(2024, 2, 28) == 2); // Leap year
+    assert(date_to_days(2023, 2, 29) == DATE_INVALID);
+    printf("Calendar dates convert to day numbers.\n");
+
+    printf("Testing round trips...\n");
+    int year;
+    int month;
+    int day;
+    for (int32_t days = date_to_days(1, 1, 1); days <= date_to_days(9999, 12, 31); days += 97) {
+        date_from_days(days, &year, &month, &day);
+        assert(validate_date(year, month, day));
+        assert(date_to_days(year, month, day) == days);
+    }
+    printf("Day numbers round trip.\n");
+
+    printf("Testing parse and format...\n");
+    char text[DATE_STR_LEN];
+    assert(date_parse("2024-01-01") == 19723);
+    assert(date_parse("0001-01-01") == date_to_days(1, 1, 1));
+    assert(date_parse("2024-1-01") == DATE_INVALID);
+    assert(date_parse("2024-02-30") == DATE_INVALID);
+    assert(date_parse("2024-01-01x") == DATE_INVALID);
+    assert(date_parse("") == DATE_INVALID);
+    assert(date_parse(NULL) == DATE_INVALID);
+    date_format(19723, text);
+    assert(strcmp(text, "2024-01-01") == 0);
+    date_format(DATE_INVALID, text);
+    assert(text[0] == '\0');
+    printf("Parse and format handled correctly.\n");
+
+    printf("date day numbers test passed successfully.\n");
+}
+
+void test_name_phonetic_key(void) {
+    printf("Testing name_phonetic_key...\n");
+
+    char a[NAME_KEY_LEN];
+    char b[NAME_KEY_LEN];
+
+    printf("Testing spellings that sound the same...\n");
+    const char *same[][2] = {
+        { "Luiz Souza", "Luis Sousa" },
+        { "Thiago Lima", "Tiago Lima" },
+        { "Rafaela Costa", "Raphaela Kosta" },
+        { "Cíntia Gonçalves", "Sintia Goncalves" },
+        { "Guilherme Queiroz", "Guilerme Keiroz" },
+        { "João da Conceição", "JOAO CONCEICAO" },
+        { "Maria Silva", "Maria Aparecida da Silva" },
+        { "Ana Sousa", "Anna Souza" },
+    };
+    for (size_t i = 0; i < sizeof(same) / sizeof(same[0]); i++) {
+        assert(name_phonetic_key(same[i][0], a) > 0);
+        assert(name_phonetic_key(same[i][1], b) > 0);
+        assert(strcmp(a, b) == 0);
+    }
+    printf("Same sounding names share a key.\n");
+
+    printf("Testing names that sound different...\n");
+    name_phonetic_key("Maria Silva", a);
+    name_phonetic_key("Mario Salvador", b);
+    assert(strcmp(a, b) != 0);
+    name_phonetic_key("Pedro Alves", a);
+    name_phonetic_key("Pedro Santos", b);
+    assert(strcmp(a, b) != 0);
+    printf("Different names have different keys.\n");
+
+    printf("Testing edge cases...\n");
+    assert(name_phonetic_key("", a) == 0);
+    assert(a[0] == '\0');
+    assert(name_phonetic_key("  .,-  ", a) == 0);
+    assert(name_phonetic_key("Bartolomeu Aparecido Pereira dos Santos Albuquerque Cavalcanti", a) < NAME_KEY_LEN);
+    printf("Edge cases handled correctly.\n");
+
+    printf("name_phonetic_key test passed successfully.\n");
+}
+
+void test_intmap(void) {
+    printf("Testing intmap...\n");
+    struct intmap map = { 0 };
+    assert(intmap_get(&map, 1) == -1);
+    assert(intmap_remove(&map, 1) == -1);
+    assert(!intmap_put(&map, 1, -1));
+
+    // Checked against a plain array as the model, with enough removals to exercise the back shift
+    static int model[4096];
+    for (int i = 0; i < 4096; i++) {
+        model[i] = -1;
+    }
+    srand(7);
+    for (int step = 0; step < 100000; step++) {
+        int key = rand() % 4096;
+        if (rand() % 3 == 0) {
+            assert(intmap_remove(&map, key) == model[key]);
+            model[key] = -1;
+        } else {
+            model[key] = rand() % 1000;
+            assert(intmap_put(&map, key, model[key]));
+        }
+        int probe = rand() % 4096;
+        assert(intmap_get(&map, probe) == model[probe]);
+    }
+    size_t count = 0;
+    for (int i = 0; i < 4096; i++) {
+        assert(intmap_get(&map, i) == model[i]);
+        count += model[i] >= 0;
+    }
+    assert(map.count == count);
+
+    // Keys far apart in 64 bits
+    assert(intmap_put(&map, INT64_MIN, 1) && intmap_put(&map, INT64_MAX, 2));
+    assert(intmap_get(&map, INT64_MIN) == 1 && intmap_get(&map, INT64_MAX) == 2);
+
+    intmap_free(&map);
+    assert(intmap_init(&map, 1000) && map.capacity >= 2000);
+    intmap_free(&map);
+    printf("intmap test passed successfully.\n");
+}
+
+// Reference model for test_timer_wheel: when each pending timer id must fire
+#define TEST_WHEEL_IDS 4096
+
+struct test_wheel_model {
+    struct timer_wheel *tw;
+    int64_t due[TEST_WHEEL_IDS]; // Tick the timer must fire at, -1 if the id is not pending
+    int payload[TEST_WHEEL_IDS];
+    int pending;
+    int fired;
+    int next_payload;
+};
+
+static void test_wheel_add(struct test_wheel_model *model, int64_t expires) {
+    int id = timer_wheel_add(model->tw, expires, model->next_payload);
+    assert(id >= 0 && id < TEST_WHEEL_IDS && model->due[id] == -1);
+    model->due[id] = expires > model->tw->current ? expires : model->tw->current + 1; // Overdue fires next tick
+    model->payload[id] = model->next_payload++;
+    model->pending++;
+}
+
+static void test_wheel_cancel_any(struct test_wheel_model *model) {
+    int start = rand() % TEST_WHEEL_IDS;
+    for (int i = 0; i < TEST_WHEEL_IDS; i++) {
+        int id = (start + i) % TEST_WHEEL_IDS;
+        if (model->due[id] >= 0) {
+            assert(timer_wheel_cancel(model->tw, id));
+            assert(!timer_wheel_cancel(model->tw, id));
+            model->due[id] = -1;
+            model->pending--;
+            return;
+        }
+    }
+}
+
+static void test_wheel_fired(void *ctx, int id, int payload, int64_t expires) {
+    struct test_wheel_model *model = ctx;
+    assert(model->due[id] == model->tw->current); // Exactly on its tick, never late or early
+    assert(model->payload[id] == payload && expires <= model->tw->current);
+    model->due[id] = -1;
+    model->pending--;
+    model->fired++;
+
+    // Callbacks may cancel pending timers (even ones firing on this tick) and add new ones
+    if (payload % 7 == 0) {
+        test_wheel_cancel_any(model);
+    }
+    if (payload % 5 == 0 && model->pending < TEST_WHEEL_IDS / 2) {
+        test_wheel_add(model, model->tw->current + rand() % 130);
+    }
+}
+
+void test_timer_wheel(void) {
+    printf("Testing timer_wheel...\n");
+    struct timer_wheel tw;
+    timer_wheel_init(&tw, 1000003);
+    assert(timer_wheel_advance(&tw, 1000010, NULL, NULL) == 0 && tw.current == 1000010);
+    assert(!timer_wheel_cancel(&tw, 0) && !timer_wheel_cancel(&tw, -1));
+
+    static struct test_wheel_model model;
+    memset(&model, 0, sizeof(model));
+    model.tw = &tw;
+    for (int i = 0; i < TEST_WHEEL_IDS; i++) {
+        model.due[i] = -1;
+    }
+
+    // Checked against the model with near, far, cascading, overdue and beyond-the-span timers
+    const int64_t span = (int64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+    srand(11);
+    for (int step = 0; step < 20000; step++) {
+        int op = rand() % 10;
+        if (op < 5 && model.pending < TEST_WHEEL_IDS / 2) {
+            int64_t delta;
+            switch (rand() % 5) {
+            case 0: delta = rand() % 70; break;
+            case 1: delta = rand() % 5000; break;
+            case 2: delta = rand() % 300000; break;
+            case 3: delta = span + rand() % 100000; break;
+            default: delta = -(rand() % 10); break;
+            }
+            test_wheel_add(&model, tw.current + delta);
+        } else if (op < 7) {
+            test_wheel_cancel_any(&model);
+        } else {
+            int64_t now = tw.current + (rand() % 50 == 0 ? rand() % 300000 : rand() % 100);
+            timer_wheel_advance(&tw, now, test_wheel_fired, &model);
+            assert(tw.current == now);
+            for (int id = 0; id < TEST_WHEEL_IDS; id++) {
+                assert(model.due[id] == -1 || model.due[id] > now);
+            }
+        }
+        assert(tw.count == model.pending);
+    }
+
+    // Drain: everything left fires on its tick
+    int64_t last = tw.current;
+    for (int id = 0; id < TEST_WHEEL_IDS; id++) {
+        last = model.due[id] > last ? model.due[id] : last;
+    }
+    int fired_before = model.fired;
+    int pending_before = model.pending;
+    timer_wheel_advance(&tw, last, test_wheel_fired, &model);
+    assert(model.pending == 0 && tw.count == 0);
+    assert(model.fired - fired_before >= pending_before);
+    printf("%d timers fired on their exact tick.\n", model.fired);
+
+    timer_wheel_free(&tw);
+    printf("timer_wheel test passed successfully.\n");
+}
+
+void test_name_similarity(void) {
+    printf("Testing name_similarity...\n");
+
+    char normalized[64];
+    assert(name_normalize("  João  da Conceição!", normalized, sizeof(normalized)) == 17);
+    assert(strcmp(normalized, "joao da conceicao") == 0);
+
+    assert(name_similarity("Maria da Silva", "Maria da Silva") == 1.0f);
+    assert(name_similarity("Maria da Silva", "MARIA SILVA") == 1.0f); // Case, accents and particles ignored
+    assert(name_similarity("Luiz Souza", "Luis Sousa") >= RESIDENT_DEDUPE_THRESHOLD);
+    assert(name_similarity("Fernanda Oliveira", "Fernada Oliveira") >= RESIDENT_DEDUPE_THRESHOLD); // Typo
+    assert(name_similarity("Maria da Silva", "Pedro Alves") < 0.1f);
+    assert(name_similarity("", "Pedro Alves") == 0.0f);
+
+    assert(name_hash("Feijão Preto") == name_hash("  feijao   preto "));
+    assert(name_hash("Arroz") != name_hash("Feijao"));
+
+    printf("name_similarity test passed successfully.\n");
+}
+
+void test_perf_ring(void) {
+    printf("Testing perf_ring...\n");
+    struct perf_ring ring = { 0 };
+    assert(perf_ring_get(&ring, 0) == 0.0f);
+    assert(perf_ring_max(&ring) == 0.0f && perf_ring_avg(&ring) == 0.0f);
+
+    perf_ring_push(&ring, 2.0f);
+    perf_ring_push(&ring, 4.0f);
+    assert(ring.count == 2);
+    assert(perf_ring_get(&ring, 0) == 4.0f && perf_ring_get(&ring, 1) == 2.0f);
+    assert(perf_ring_get(&ring, 2) == 0.0f && perf_ring_get(&ring, -1) == 0.0f);
+    assert(perf_ring_max(&ring) == 4.0f && perf_ring_avg(&ring) == 3.0f);
+
+    // Wraps around, the oldest samples go first
+    for (int i = 0; i < PERF_RING_SIZE + 10; i++) {
+        perf_ring_push(&ring, (float)i);
+    }
+    assert(ring.count == PERF_RING_SIZE);
+    assert(perf_ring_get(&ring, 0) == (float)(PERF_RING_SIZE + 9));
+    assert(perf_ring_get(&ring, PERF_RING_SIZE - 1) == 10.0f);
+    assert(perf_ring_max(&ring) == (float)(PERF_RING_SIZE + 9));
+    assert(perf_ring_avg(&ring) == (float)(10 + PERF_RING_SIZE + 9) / 2.0f);
+
+    uint64_t start = perf_now_ns();
+    assert(perf_now_ns() >= start);
+#ifdef __linux__
+    assert(perf_rss_bytes() > 0);
+#endif
+
+    printf("perf_ring test passed successfully.\n");
+}
+
+#define TEST_QUEUE_ITEMS 100000
+#define TEST_QUEUE_PRODUCERS 4
+
+struct test_queue_producer {
+    pthread_t thread;
+    void *queue;
+    uintptr_t first; ///< Items pushed are first, first + 1, ... first + TEST_QUEUE_ITEMS - 1
+};
+
+static void *test_spsc_produce(void *arg) {
+    struct test_queue_producer *producer = arg;
+    for (uintptr_t i = 0; i < TEST_QUEUE_ITEMS; i++) {
+        while (!spsc_queue_push(producer->queue, (void *)(producer->first + i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *test_mpsc_produce(void *arg) {
+    struct test_queue_producer *producer = arg;
+    for (uintptr_t i = 0; i < TEST_QUEUE_ITEMS; i++) {
+        while (!mpsc_queue_push(producer->queue, (void *)(producer->first + i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_queues(void) {
+    printf("Testing spsc_queue and mpsc_queue...\n");
+    struct spsc_queue spsc;
+    assert(spsc_queue_init(&spsc, 3));
+    assert(spsc.mask == 3); // Rounded up to 4
+    assert(spsc_queue_pop(&spsc) == NULL);
+    for (uintptr_t i = 1; i <= 4; i++) {
+        assert(spsc_queue_push(&spsc, (void *)i));
+    }
+    assert(!spsc_queue_push(&spsc, (void *)5));
+    assert(spsc_queue_pop(&spsc) == (void *)1);
+    assert(spsc_queue_push(&spsc, (void *)5));
+    for (uintptr_t i = 2; i <= 5; i++) {
+        assert(spsc_queue_pop(&spsc) == (void *)i);
+    }
+    assert(spsc_queue_pop(&spsc) == NULL);
+
+    struct mpsc_queue mpsc;
+    assert(mpsc_queue_init(&mpsc, 4));
+    assert(mpsc_queue_pop(&mpsc) == NULL);
+    for (uintptr_t i = 1; i <= 4; i++) {
+        assert(mpsc_queue_push(&mpsc, (void *)i));
+    }
+    assert(!mpsc_queue_push(&mpsc, (void *)5));
+    for (uintptr_t i = 1; i <= 4; i++) {
+        assert(mpsc_queue_pop(&mpsc) == (void *)i);
+    }
+    assert(mpsc_queue_pop(&mpsc) == NULL);
+    printf("Full and empty queues refuse pushes and pops.\n");
+
+    // A small queue between two threads: every item arrives once, in order
+    struct test_queue_producer producer = { .queue = &spsc, .first = 1 };
+    assert(pthread_create(&producer.thread, NULL, test_spsc_produce, &producer) == 0);
+    for (uintptr_t expected = 1; expected <= TEST_QUEUE_ITEMS;) {
+        void *item = spsc_queue_pop(&spsc);
+        if (item) {
+            assert(item == (void *)expected);
+            expected++;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(producer.thread, NULL);
+    assert(spsc_queue_pop(&spsc) == NULL);
+    spsc_queue_free(&spsc);
+
+    // Producers racing for the slots: nothing lost or repeated, each producer's items in order
+    struct test_queue_producer producers[TEST_QUEUE_PRODUCERS];
+    uintptr_t next[TEST_QUEUE_PRODUCERS];
+    for (int p = 0; p < TEST_QUEUE_PRODUCERS; p++) {
+        producers[p] = (struct test_queue_producer) { .queue = &mpsc, .first = (uintptr_t)(p + 1) * 1000000 };
+        next[p] = producers[p].first;
+        assert(pthread_create(&producers[p].thread, NULL, test_mpsc_produce, &producers[p]) == 0);
+    }
+    for (int received = 0; received < TEST_QUEUE_PRODUCERS * TEST_QUEUE_ITEMS;) {
+        uintptr_t item = (uintptr_t)mpsc_queue_pop(&mpsc);
+        if (item) {
+            int p = (int)(item / 1000000) - 1;
+            assert(p >= 0 && p < TEST_QUEUE_PRODUCERS);
+            assert(item == next[p]);
+            next[p]++;
+            received++;
+        } else {
+            sched_yield();
+        }
+    }
+    for (int p = 0; p < TEST_QUEUE_PRODUCERS; p++) {
+        pthread_join(producers[p].thread, NULL);
+    }
+    assert(mpsc_queue_pop(&mpsc) == NULL);
+    mpsc_queue_free(&mpsc);
+    printf("Items crossed threads once and in order.\n");
+
+    printf("spsc_queue and mpsc_queue test passed successfully.\n");
+}
+
 // UTILSFN TESTS END
 
 void test_resident_db_fn(void) {
@@ -2143,6 +6406,14 @@ void test_resident_db_fn(void) {
     test_resident_db_get_all_format();
     test_resident_db_get_all_format_old();
     test_resident_db_get_all();
+    test_resident_db_search();
+    test_resident_search_worker();
+    test_resident_db_integer_cpf();
+    test_resident_db_entered_between();
+    test_resident_dedupe_find();
+    test_resident_db_insert_checked();
+    test_resident_dedupe_report();
+    test_resident_import();
 }
 
 void test_foodbatch_db_fn(void) {
@@ -2155,12 +6426,75 @@ void test_foodbatch_db_fn(void) {
     test_foodbatch_db_get_all_format();
     test_foodbatch_db_get_all_format_old();
     test_foodbatch_db_get_all();
+    test_foodbatch_db_expiring_between();
+    test_expiration_alerts();
+    test_food_forecast();
+    test_foodbatch_db_take_quantity();
+    test_food_plan();
+}
+
+void test_medication_db_fn(void) {
+    test_medication_db();
+    test_dose_schedule();
+}
+
+void test_clothes_db_fn(void) {
+    test_clothes_db();
+    test_clothes_index();
+}
+
+void test_supplies_db_fn(void) {
+    test_supplies_db();
+    test_supplies_db_receive_shipment();
+}
+
+void test_datagen_fn(void) {
+    test_datagen_cpf();
+    test_datagen_residents();
+    test_datagen_tables();
+}
+
+void test_db_profile_fn(void) {
+    test_db_profile_normalize();
+    test_db_profile();
+    test_db_profile_track_time();
+}
+
+void test_db_pool_fn(void) {
+    test_db_pool();
+    test_db_pool_reads();
+}
+
+void test_db_backup_fn(void) {
+    test_db_backup();
+}
+
+void test_db_maintenance_fn(void) {
+    test_db_maintenance();
+    test_db_maintenance_upgrade();
+}
+
+void test_db_changes_fn(void) {
+    test_db_changes();
+    test_db_changes_other_process();
+}
+
+void test_db_server_fn(void) {
+    test_db_protocol();
+    test_db_server();
 }
 
 void test_user_db_fn(void) {
+    // Cheapest cost allowed, every test user is hashed with it
+    password_kdf_set_iterations(PASSWORD_KDF_MIN_ITERATIONS);
+
     test_user_db_create_table();
     test_user_db_create_user();
     test_user_db_authenticate();
+    test_user_db_authenticate_kdf();
+    test_user_db_migrate_kdf();
+    test_user_db_last_login_queue();
+    test_user_roster_provision();
     test_user_db_delete();
     test_user_db_update_password();
     test_user_db_update_admin_status();
@@ -2174,20 +6508,83 @@ void test_user_db_fn(void) {
     test_user_db_get_all();
 }
 
+void test_password_kdf(void) {
+    printf("Testing password KDF...\n");
+    char hash[PASSWORD_HASH_LEN + 1];
+
+    // RFC 7914 section 11 PBKDF2-HMAC-SHA256 vectors (first 32 bytes)
+    struct password_kdf_params pbkdf2 = { PASSWORD_KDF_PBKDF2_SHA256, 1 };
+    assert(hash_password_kdf("password", "salt", pbkdf2, hash));
+    assert(strcmp(hash, "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b") == 0);
+    pbkdf2.iterations = 4096;
+    assert(hash_password_kdf("password", "salt", pbkdf2, hash));
+    assert(strcmp(hash, "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a") == 0);
+    assert(verify_password("password", "salt", pbkdf2, hash));
+    assert(!verify_password("Password", "salt", pbkdf2, hash));
+    assert(!verify_password("password", "salt", pbkdf2, "c5e4"));
+
+    // Legacy hashes verify as before
+    struct password_kdf_params legacy = { PASSWORD_KDF_SHA256, 0 };
+    char legacy_hash[PASSWORD_HASH_LEN + 1];
+    hash_password("testpassword", "testsalt", legacy_hash);
+    assert(hash_password_kdf("testpassword", "testsalt", legacy, hash) && strcmp(hash, legacy_hash) == 0);
+    assert(verify_password("testpassword", "testsalt", legacy, legacy_hash));
+
+    struct password_kdf_params unknown = { PASSWORD_KDF_COUNT, 1000 };
+    assert(!hash_password_kdf("x", "y", unknown, hash));
+    pbkdf2.iterations = 0;
+    assert(!hash_password_kdf("x", "y", pbkdf2, hash));
+
+    // Current cost, clamped, and what needs an upgrade
+    password_kdf_set_iterations(1);
+    assert(password_kdf_current().kdf == PASSWORD_KDF_PBKDF2_SHA256);
+    assert(password_kdf_current().iterations == PASSWORD_KDF_MIN_ITERATIONS);
+    password_kdf_set_iterations(PASSWORD_KDF_MAX_ITERATIONS + 1);
+    assert(password_kdf_current().iterations == PASSWORD_KDF_MAX_ITERATIONS);
+    password_kdf_set_iterations(50000);
+    assert(password_kdf_needs_upgrade(legacy));
+    assert(password_kdf_needs_upgrade((struct password_kdf_params) { PASSWORD_KDF_PBKDF2_SHA256, 37499 }));
+    assert(!password_kdf_needs_upgrade((struct password_kdf_params) { PASSWORD_KDF_PBKDF2_SHA256, 37500 }));
+    assert(!password_kdf_needs_upgrade((struct password_kdf_params) { PASSWORD_KDF_PBKDF2_SHA256, 49999 })); // Noise
+    assert(!password_kdf_needs_upgrade((struct password_kdf_params) { PASSWORD_KDF_PBKDF2_SHA256, 80000 }));
+
+    int iterations = password_kdf_calibrate(20.0);
+    assert(iterations >= PASSWORD_KDF_MIN_ITERATIONS && iterations <= PASSWORD_KDF_MAX_ITERATIONS);
+    assert(iterations == PASSWORD_KDF_MIN_ITERATIONS || (iterations & (iterations - 1)) == 0);
+    assert(password_kdf_current().iterations == 50000); // Calibrating does not change it
+    password_kdf_set_iterations(PASSWORD_KDF_DEFAULT_ITERATIONS);
+
+    // Salts only use the 64 printable characters
+    char salt[SALT_LEN + 1];
+    generate_salt(salt, SALT_LEN);
+    assert(strspn(salt, "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz") == SALT_LEN);
+
+    printf("password KDF test passed successfully.\n");
+}
+
 void test_hash_fn(void) {
     test_generate_salt();
     test_hash_password();
     test_hash_consistency();
     test_hash_collision_resistance();
     test_edge_cases();
+    test_password_kdf();
 }
 
 void test_utils_fn(void) {
     test_flag_macros();
     test_is_int_between_min_max();
     test_wrap_text();
+    test_table_text_patch();
     test_filter_integer_input();
     test_validate_date();
+    test_date_days();
+    test_intmap();
+    test_timer_wheel();
+    test_name_phonetic_key();
+    test_name_similarity();
+    test_perf_ring();
+    test_queues();
 }
 
 int main(void) {
@@ -2195,8 +6592,28 @@ int main(void) {
 
     test_foodbatch_db_fn();
 
+    test_medication_db_fn();
+
+    test_clothes_db_fn();
+
+    test_supplies_db_fn();
+
     test_user_db_fn();
 
+    test_datagen_fn();
+
+    test_db_profile_fn();
+
+    test_db_pool_fn();
+
+    test_db_backup_fn();
+
+    test_db_maintenance_fn();
+
+    test_db_changes_fn();
+
+    test_db_server_fn();
+
     test_hash_fn();
 
     test_utils_fn();
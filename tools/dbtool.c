@@ -0,0 +1,1083 @@
+/**
+ * @file dbtool.c
+ * @brief Shelter Management System - Headless Database Tool
+ *
+ * Command line companion to the application for batch work on the databases without opening
+ * a window: CSV import and export, partner resident lists, statistics, maintenance, integrity
+ * checks, backups, password resets, bulk user provisioning and the database server shared by
+ * several terminals. Built from the db layer only, so it links without raylib or X11.
+ *
+ * Every command streams its output as it goes (rows, progress, results) and the exit code
+ * tells scripts how it went (see enum dbtool_exit).
+ *
+ * @note Uses SQLite3 for database operations
+ * @note Uses OpenSSL for crypto (password hashing)
+ */
+
+#include <external/sqlite3/sqlite3.h>
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db/clothes_db.h"
+#include "db/db_manager.h"
+#include "db/db_profile.h"
+#include "db/db_server.h"
+#include "db/foodbatch_db.h"
+#include "db/medication_db.h"
+#include "db/resident_db.h"
+#include "db/resident_import.h"
+#include "db/supplies_db.h"
+#include "db/user_db.h"
+#include "db/user_roster.h"
+
+/**
+ * @enum dbtool_exit
+ * @brief Exit codes of the tool
+ */
+enum dbtool_exit {
+    DBTOOL_OK = 0,       ///< Command completed
+    DBTOOL_FAILED = 1,   ///< Database or I/O error, check stderr
+    DBTOOL_USAGE = 2,    ///< Unknown command or bad arguments
+    DBTOOL_CORRUPT = 3,  ///< Integrity check found problems
+    DBTOOL_NOTFOUND = 4, ///< Named user not found
+};
+
+#define DBTOOL_PATH_MAX 1024                  ///< Longest database or backup path
+#define DBTOOL_BACKUP_PAGES_PER_STEP 64       ///< Pages copied per backup step, progress is printed between steps
+#define DBTOOL_IMPORT_PROGRESS 10000          ///< Rows imported between progress lines
+#define DBTOOL_SERVER_SOCKET "db_server.sock" ///< Socket serve creates in the database directory by default
+#define DBTOOL_SERVER_POLL_MS 200             ///< Time between two checks for the stop signal
+
+/**
+ * @struct dbtool_database
+ * @brief One of the application's database files
+ */
+struct dbtool_database {
+    const char *name;                  ///< Name used on the command line
+    const char *filename;              ///< File name as opened by the application
+    int (*create_table)(database *db); ///< Creates or migrates the schema, as on application start
+    const char *table;                 ///< Table used by import and export when none is given
+};
+
+// Same files and schemas as main.c
+static const struct dbtool_database dbtool_databases[] = {
+    { "resident", "resident_db.db", resident_db_create_table, "Resident" },
+    { "food", "foodbatch_db.db", foodbatch_db_create_table, "FoodBatch" },
+    { "user", "user_db.db", user_db_create_table, "Users" },
+    { "medication", "medication_db.db", medication_db_create_table, "Medications" },
+    { "clothes", "clothes_db.db", clothes_db_create_table, "Clothes" },
+    { "supplies", "supplies_db.db", supplies_db_create_table, "Supplies" },
+};
+
+#define DBTOOL_DATABASE_COUNT ((int)(sizeof(dbtool_databases) / sizeof(dbtool_databases[0])))
+
+static const char *dbtool_dir = "."; ///< Directory holding the database files (-C)
+
+/* ======================= DATABASES ======================= */
+
+static const struct dbtool_database *find_database(const char *name) {
+    for (int i = 0; i < DBTOOL_DATABASE_COUNT; i++) {
+        if (strcmp(dbtool_databases[i].name, name) == 0) {
+            return &dbtool_databases[i];
+        }
+    }
+
+    fprintf(stderr, "Unknown database '%s'.\n", name);
+    return NULL;
+}
+
+static bool join_path(char *out, const char *dir, const char *filename) {
+    int len = snprintf(out, DBTOOL_PATH_MAX, "%s/%s", dir, filename);
+    if (len < 0 || len >= DBTOOL_PATH_MAX) {
+        fprintf(stderr, "Path too long: %s/%s\n", dir, filename);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Opens a database the way the application does, creating or migrating its schema
+ */
+static bool open_database(const struct dbtool_database *dbdef, database *db) {
+    char path[DBTOOL_PATH_MAX];
+    if (!join_path(path, dbtool_dir, dbdef->filename)) {
+        return false;
+    }
+
+    db->db = NULL;
+    return db_init_with_tbl(db, path, dbdef->create_table) == SQLITE_OK;
+}
+
+/**
+ * @brief Resolves the database names given on the command line, all databases if none
+ *
+ * @return Number of databases written to out, or -1 if a name is unknown
+ */
+static int select_databases(int argc, char **argv, const struct dbtool_database **out) {
+    if (argc == 0) {
+        for (int i = 0; i < DBTOOL_DATABASE_COUNT; i++) {
+            out[i] = &dbtool_databases[i];
+        }
+        return DBTOOL_DATABASE_COUNT;
+    }
+
+    if (argc > DBTOOL_DATABASE_COUNT) {
+        fprintf(stderr, "Too many databases.\n");
+        return -1;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        out[i] = find_database(argv[i]);
+        if (!out[i]) {
+            return -1;
+        }
+    }
+    return argc;
+}
+
+/* ======================= CSV ======================= */
+
+/**
+ * @brief Writes one CSV field, quoted only when needed
+ *
+ * NULL is written as an unquoted \\N (as PostgreSQL's COPY does), so an empty field stays an
+ * empty string, which is how the application stores unset text fields.
+ */
+static void csv_write_field(FILE *out, const char *value) {
+    if (!value) {
+        fputs("\\N", out);
+        return;
+    }
+
+    if (strcmp(value, "\\N") != 0 && strpbrk(value, ",\"\r\n") == NULL) {
+        fputs(value, out);
+        return;
+    }
+
+    fputc('"', out);
+    for (const char *c = value; *c; c++) {
+        if (*c == '"') {
+            fputc('"', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * @struct csv_record
+ * @brief Fields of one CSV record, reused from record to record
+ */
+struct csv_record {
+    char *text;      ///< Field text, each field NUL terminated
+    size_t text_len; ///< Bytes used in text
+    size_t text_cap; ///< Bytes allocated for text
+    size_t *offsets; ///< Start of each field in text
+    bool *is_null;   ///< Whether each field was an unquoted \\N
+    int count;       ///< Fields in the record
+    int cap;         ///< Fields allocated
+};
+
+static bool csv_push_char(struct csv_record *rec, char c) {
+    if (rec->text_len == rec->text_cap) {
+        size_t cap = rec->text_cap ? rec->text_cap * 2 : 256;
+        char *text = realloc(rec->text, cap);
+        if (!text) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return false;
+        }
+        rec->text = text;
+        rec->text_cap = cap;
+    }
+    rec->text[rec->text_len++] = c;
+    return true;
+}
+
+static bool csv_start_field(struct csv_record *rec) {
+    if (rec->count == rec->cap) {
+        int cap = rec->cap ? rec->cap * 2 : 16;
+        size_t *offsets = realloc(rec->offsets, (size_t)cap * sizeof(*offsets));
+        if (!offsets) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return false;
+        }
+        rec->offsets = offsets;
+        bool *is_null = realloc(rec->is_null, (size_t)cap * sizeof(*is_null));
+        if (!is_null) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return false;
+        }
+        rec->is_null = is_null;
+        rec->cap = cap;
+    }
+    rec->offsets[rec->count] = rec->text_len;
+    rec->count++;
+    return true;
+}
+
+static bool csv_end_field(struct csv_record *rec, bool was_quoted) {
+    if (!csv_push_char(rec, '\0')) {
+        return false;
+    }
+    int i = rec->count - 1;
+    rec->is_null[i] = !was_quoted && strcmp(rec->text + rec->offsets[i], "\\N") == 0;
+    return true;
+}
+
+/**
+ * @brief Reads the next record (RFC 4180: quoted fields may hold commas, quotes and newlines)
+ *
+ * @param in Input stream
+ * @param rec Record to fill
+ * @param[in,out] line Line number, advanced past the record
+ * @return 1 if a record was read, 0 at end of input, -1 on malformed input or allocation failure
+ */
+static int csv_read_record(FILE *in, struct csv_record *rec, long *line) {
+    rec->text_len = 0;
+    rec->count = 0;
+
+    int c = getc(in);
+    if (c == EOF) {
+        return 0;
+    }
+    (*line)++;
+
+    if (!csv_start_field(rec)) {
+        return -1;
+    }
+
+    bool quoted = false;
+    bool was_quoted = false;
+    for (;; c = getc(in)) {
+        if (quoted) {
+            if (c == EOF) {
+                fprintf(stderr, "Line %ld: unterminated quoted field.\n", *line);
+                return -1;
+            }
+            if (c == '"') {
+                c = getc(in);
+                if (c != '"') {
+                    quoted = false;
+                    ungetc(c, in);
+                    continue;
+                }
+            } else if (c == '\n') {
+                (*line)++;
+            }
+            if (!csv_push_char(rec, (char)c)) {
+                return -1;
+            }
+            continue;
+        }
+
+        if (c == EOF || c == '\n') {
+            break;
+        }
+        if (c == '\r') {
+            continue;
+        }
+        if (c == ',') {
+            if (!csv_end_field(rec, was_quoted) || !csv_start_field(rec)) {
+                return -1;
+            }
+            was_quoted = false;
+            continue;
+        }
+        if (c == '"') {
+            quoted = true;
+            was_quoted = true;
+        } else if (!csv_push_char(rec, (char)c)) {
+            return -1;
+        }
+    }
+
+    return csv_end_field(rec, was_quoted) ? 1 : -1;
+}
+
+static const char *csv_field(const struct csv_record *rec, int i) {
+    return rec->text + rec->offsets[i];
+}
+
+static void csv_record_free(struct csv_record *rec) {
+    free(rec->text);
+    free(rec->offsets);
+    free(rec->is_null);
+}
+
+/* ======================= COMMANDS ======================= */
+
+/**
+ * @brief stats [db...]: file size and row count of every table
+ */
+static int cmd_stats(int argc, char **argv) {
+    const struct dbtool_database *selected[DBTOOL_DATABASE_COUNT];
+    int count = select_databases(argc, argv, selected);
+    if (count < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    int result = DBTOOL_OK;
+    for (int i = 0; i < count; i++) {
+        database db;
+        if (!open_database(selected[i], &db)) {
+            result = DBTOOL_FAILED;
+            continue;
+        }
+
+        sqlite3_stmt *stmt;
+        const char *sql =
+            "SELECT page_count, page_size, freelist_count "
+            "FROM pragma_page_count, pragma_page_size, pragma_freelist_count;";
+        if (sqlite3_prepare_v2(db.db, sql, -1, &stmt, 0) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db.db));
+            result = DBTOOL_FAILED;
+            db_deinit(&db);
+            continue;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            long long pages = sqlite3_column_int64(stmt, 0);
+            long long page_size = sqlite3_column_int64(stmt, 1);
+            printf(
+                "%s (%s): %lld bytes, %lld pages, %lld free\n",
+                selected[i]->name,
+                selected[i]->filename,
+                pages * page_size,
+                pages,
+                sqlite3_column_int64(stmt, 2)
+            );
+        }
+        sqlite3_finalize(stmt);
+
+        sql = "SELECT name FROM sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%' ORDER BY name;";
+        if (sqlite3_prepare_v2(db.db, sql, -1, &stmt, 0) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db.db));
+            result = DBTOOL_FAILED;
+            db_deinit(&db);
+            continue;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *table = (const char *)sqlite3_column_text(stmt, 0);
+            char *count_sql = sqlite3_mprintf("SELECT COUNT(*) FROM \"%w\";", table);
+            sqlite3_stmt *count_stmt;
+            if (count_sql && sqlite3_prepare_v2(db.db, count_sql, -1, &count_stmt, 0) == SQLITE_OK) {
+                if (sqlite3_step(count_stmt) == SQLITE_ROW) {
+                    printf("  %s: %lld rows\n", table, sqlite3_column_int64(count_stmt, 0));
+                }
+                sqlite3_finalize(count_stmt);
+            } else {
+                fprintf(stderr, "Failed to count %s: %s\n", table, sqlite3_errmsg(db.db));
+                result = DBTOOL_FAILED;
+            }
+            sqlite3_free(count_sql);
+        }
+        sqlite3_finalize(stmt);
+        fflush(stdout);
+
+        db_deinit(&db);
+    }
+
+    return result;
+}
+
+/**
+ * @brief export <db> [table]: writes the table to stdout as CSV with a header, row by row
+ *
+ * Values are written as stored (CPFs of residents are packed integers, dates are day numbers),
+ * so an export can be imported back unchanged.
+ */
+static int cmd_export(int argc, char **argv) {
+    if (argc < 1 || argc > 2) {
+        return DBTOOL_USAGE;
+    }
+
+    const struct dbtool_database *dbdef = find_database(argv[0]);
+    if (!dbdef) {
+        return DBTOOL_USAGE;
+    }
+    const char *table = argc == 2 ? argv[1] : dbdef->table;
+
+    database db;
+    if (!open_database(dbdef, &db)) {
+        return DBTOOL_FAILED;
+    }
+
+    char *sql = sqlite3_mprintf("SELECT * FROM \"%w\";", table);
+    sqlite3_stmt *stmt;
+    if (!sql || sqlite3_prepare_v2(db.db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db.db));
+        sqlite3_free(sql);
+        db_deinit(&db);
+        return DBTOOL_FAILED;
+    }
+    sqlite3_free(sql);
+
+    int columns = sqlite3_column_count(stmt);
+    for (int i = 0; i < columns; i++) {
+        if (i > 0) {
+            putchar(',');
+        }
+        csv_write_field(stdout, sqlite3_column_name(stmt, i));
+    }
+    putchar('\n');
+
+    long long rows = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < columns; i++) {
+            if (i > 0) {
+                putchar(',');
+            }
+            csv_write_field(stdout, (const char *)sqlite3_column_text(stmt, i));
+        }
+        putchar('\n');
+        rows++;
+    }
+
+    int result = DBTOOL_OK;
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db.db));
+        result = DBTOOL_FAILED;
+    }
+    if (fflush(stdout) != 0) {
+        perror("Failed to write export");
+        result = DBTOOL_FAILED;
+    }
+    fprintf(stderr, "Exported %lld rows from %s.\n", rows, table);
+
+    sqlite3_finalize(stmt);
+    db_deinit(&db);
+    return result;
+}
+
+/**
+ * @brief import <db> <file|-> [table]: inserts the rows of a CSV file in one transaction
+ *
+ * The header names the columns, other columns take their defaults. An unquoted \\N is NULL.
+ * The schema's triggers run as for the application, so search indexes and rollups stay in
+ * sync. Nothing is imported if any row fails.
+ */
+static int cmd_import(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        return DBTOOL_USAGE;
+    }
+
+    const struct dbtool_database *dbdef = find_database(argv[0]);
+    if (!dbdef) {
+        return DBTOOL_USAGE;
+    }
+    const char *table = argc == 3 ? argv[2] : dbdef->table;
+
+    FILE *in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return DBTOOL_FAILED;
+    }
+
+    database db = { 0 };
+    struct csv_record rec = { 0 };
+    sqlite3_stmt *stmt = NULL;
+    char *sql = NULL;
+    int result = DBTOOL_FAILED;
+    long line = 0;
+    long long rows = 0;
+
+    if (!open_database(dbdef, &db)) {
+        goto cleanup;
+    }
+
+    if (csv_read_record(in, &rec, &line) != 1) {
+        fprintf(stderr, "Missing header line.\n");
+        goto cleanup;
+    }
+
+    // INSERT INTO "table" ("a","b") VALUES (?,?)
+    int columns = rec.count;
+    sql = sqlite3_mprintf("INSERT INTO \"%w\" (", table);
+    for (int i = 0; sql && i < columns; i++) {
+        char *next = sqlite3_mprintf("%s%s\"%w\"", sql, i ? "," : "", csv_field(&rec, i));
+        sqlite3_free(sql);
+        sql = next;
+    }
+    for (int i = 0; sql && i < columns; i++) {
+        char *next = sqlite3_mprintf("%s%s", sql, i ? ",?" : ") VALUES (?");
+        sqlite3_free(sql);
+        sql = next;
+    }
+    if (!sql) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        goto cleanup;
+    }
+    char *next = sqlite3_mprintf("%s);", sql);
+    sqlite3_free(sql);
+    sql = next;
+
+    if (!sql || sqlite3_prepare_v2(db.db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db.db));
+        goto cleanup;
+    }
+
+    if (sqlite3_exec(db.db, "BEGIN IMMEDIATE;", 0, 0, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to begin transaction: %s\n", sqlite3_errmsg(db.db));
+        goto cleanup;
+    }
+
+    int rc;
+    while ((rc = csv_read_record(in, &rec, &line)) == 1) {
+        if (rec.count == 1 && csv_field(&rec, 0)[0] == '\0') {
+            continue; // Blank line
+        }
+        if (rec.count != columns) {
+            fprintf(stderr, "Line %ld: %d fields, header has %d.\n", line, rec.count, columns);
+            break;
+        }
+
+        for (int i = 0; i < columns; i++) {
+            if (rec.is_null[i]) {
+                sqlite3_bind_null(stmt, i + 1);
+            } else {
+                sqlite3_bind_text(stmt, i + 1, csv_field(&rec, i), -1, SQLITE_STATIC);
+            }
+        }
+        int step = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (step != SQLITE_DONE) {
+            fprintf(stderr, "Line %ld: %s\n", line, sqlite3_errmsg(db.db));
+            break;
+        }
+
+        rows++;
+        if (rows % DBTOOL_IMPORT_PROGRESS == 0) {
+            fprintf(stderr, "Imported %lld rows...\n", rows);
+        }
+    }
+
+    if (rc == 0 && sqlite3_exec(db.db, "COMMIT;", 0, 0, 0) == SQLITE_OK) {
+        fprintf(stderr, "Imported %lld rows into %s.\n", rows, table);
+        result = DBTOOL_OK;
+    } else {
+        sqlite3_exec(db.db, "ROLLBACK;", 0, 0, 0);
+        fprintf(stderr, "Import rolled back, nothing was imported.\n");
+    }
+
+cleanup:
+    sqlite3_finalize(stmt);
+    sqlite3_free(sql);
+    csv_record_free(&rec);
+    db_deinit(&db);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return result;
+}
+
+/**
+ * @brief maintain [db...]: refreshes the planner statistics and rebuilds the files compactly, with
+ *        incremental auto_vacuum so the app's idle-time maintenance can keep them compact
+ */
+static int cmd_maintain(int argc, char **argv) {
+    const struct dbtool_database *selected[DBTOOL_DATABASE_COUNT];
+    int count = select_databases(argc, argv, selected);
+    if (count < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    int result = DBTOOL_OK;
+    for (int i = 0; i < count; i++) {
+        database db;
+        if (!open_database(selected[i], &db)) {
+            result = DBTOOL_FAILED;
+            continue;
+        }
+
+        char *errMsg = 0;
+        // The VACUUM also turns files created before incremental auto_vacuum over to it
+        const char *sql = "PRAGMA auto_vacuum = INCREMENTAL; ANALYZE; VACUUM; PRAGMA optimize;";
+        if (sqlite3_exec(db.db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+            fprintf(stderr, "%s: maintenance failed: %s\n", selected[i]->name, errMsg);
+            sqlite3_free(errMsg);
+            result = DBTOOL_FAILED;
+        } else {
+            printf("%s: analyzed and vacuumed\n", selected[i]->name);
+            fflush(stdout);
+        }
+
+        db_deinit(&db);
+    }
+
+    return result;
+}
+
+/**
+ * @brief check [db...]: runs PRAGMA integrity_check, printing every problem found
+ */
+static int cmd_check(int argc, char **argv) {
+    const struct dbtool_database *selected[DBTOOL_DATABASE_COUNT];
+    int count = select_databases(argc, argv, selected);
+    if (count < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    int result = DBTOOL_OK;
+    for (int i = 0; i < count; i++) {
+        char path[DBTOOL_PATH_MAX];
+        database db = { 0 };
+        // Opened without create_table, a damaged file must not be migrated before it is checked
+        if (!join_path(path, dbtool_dir, selected[i]->filename) || db_init(&db, path) != SQLITE_OK) {
+            db_deinit(&db);
+            result = DBTOOL_FAILED;
+            continue;
+        }
+
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(db.db, "PRAGMA integrity_check;", -1, &stmt, 0) != SQLITE_OK) {
+            fprintf(stderr, "%s: %s\n", selected[i]->name, sqlite3_errmsg(db.db));
+            result = result == DBTOOL_OK ? DBTOOL_CORRUPT : result; // Not even readable as a database
+            db_deinit(&db);
+            continue;
+        }
+
+        bool ok = true;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char *message = (const char *)sqlite3_column_text(stmt, 0);
+            if (strcmp(message, "ok") != 0) {
+                printf("%s: %s\n", selected[i]->name, message);
+                ok = false;
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            printf("%s: %s\n", selected[i]->name, sqlite3_errmsg(db.db));
+            ok = false;
+        }
+        if (ok) {
+            printf("%s: ok\n", selected[i]->name);
+        } else if (result == DBTOOL_OK) {
+            result = DBTOOL_CORRUPT;
+        }
+        fflush(stdout);
+
+        sqlite3_finalize(stmt);
+        db_deinit(&db);
+    }
+
+    return result;
+}
+
+/**
+ * @brief backup <dir> [db...]: copies the databases into dir with the SQLite online backup
+ *
+ * Copies a few pages per step, so the application can keep writing while it runs.
+ */
+static int cmd_backup(int argc, char **argv) {
+    if (argc < 1) {
+        return DBTOOL_USAGE;
+    }
+
+    const char *dest_dir = argv[0];
+    const struct dbtool_database *selected[DBTOOL_DATABASE_COUNT];
+    int count = select_databases(argc - 1, argv + 1, selected);
+    if (count < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    int result = DBTOOL_OK;
+    for (int i = 0; i < count; i++) {
+        char dest_path[DBTOOL_PATH_MAX];
+        database db;
+        database dest = { 0 };
+        if (!join_path(dest_path, dest_dir, selected[i]->filename) || !open_database(selected[i], &db)) {
+            result = DBTOOL_FAILED;
+            continue;
+        }
+        if (db_init(&dest, dest_path) != SQLITE_OK) {
+            db_deinit(&dest);
+            db_deinit(&db);
+            result = DBTOOL_FAILED;
+            continue;
+        }
+
+        sqlite3_backup *backup = sqlite3_backup_init(dest.db, "main", db.db, "main");
+        if (!backup) {
+            fprintf(stderr, "%s: backup failed: %s\n", selected[i]->name, sqlite3_errmsg(dest.db));
+            db_deinit(&dest);
+            db_deinit(&db);
+            result = DBTOOL_FAILED;
+            continue;
+        }
+
+        int rc;
+        do {
+            rc = sqlite3_backup_step(backup, DBTOOL_BACKUP_PAGES_PER_STEP);
+            int total = sqlite3_backup_pagecount(backup);
+            int done = total - sqlite3_backup_remaining(backup);
+            fprintf(stderr, "\r%s: %d/%d pages", selected[i]->name, done, total);
+            if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                sqlite3_sleep(50); // The application holds the lock, retry shortly
+            }
+        } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+        fputc('\n', stderr);
+
+        rc = sqlite3_backup_finish(backup);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "%s: backup failed: %s\n", selected[i]->name, sqlite3_errstr(rc));
+            result = DBTOOL_FAILED;
+        } else {
+            printf("%s: %s\n", selected[i]->name, dest_path);
+            fflush(stdout);
+        }
+
+        db_deinit(&dest);
+        db_deinit(&db);
+    }
+
+    return result;
+}
+
+/**
+ * @brief reset-password <username> [--stdin]: makes the user choose a new password on next login,
+ *        or sets the one read from the first line of stdin
+ */
+static int cmd_reset_password(int argc, char **argv) {
+    bool from_stdin = argc == 2 && strcmp(argv[1], "--stdin") == 0;
+    if (argc != 1 && !from_stdin) {
+        return DBTOOL_USAGE;
+    }
+
+    char password[MAX_INPUT + 2];
+    if (from_stdin) {
+        if (!fgets(password, sizeof(password), stdin)) {
+            fprintf(stderr, "No password given on stdin.\n");
+            return DBTOOL_USAGE;
+        }
+        password[strcspn(password, "\r\n")] = '\0';
+        if (password[0] == '\0' || strlen(password) >= MAX_INPUT) {
+            fprintf(stderr, "Password must have 1 to %d characters.\n", MAX_INPUT - 1);
+            return DBTOOL_USAGE;
+        }
+    }
+
+    database db;
+    if (!open_database(find_database("user"), &db)) {
+        return DBTOOL_FAILED;
+    }
+
+    int rc = from_stdin ? user_db_update_password(&db, argv[0], password)
+                        : user_db_set_reset_password(&db, argv[0]);
+    memset(password, 0, sizeof(password));
+    db_deinit(&db);
+
+    if (rc == SQLITE_NOTFOUND) {
+        fprintf(stderr, "User '%s' not found.\n", argv[0]);
+        return DBTOOL_NOTFOUND;
+    }
+    if (rc != SQLITE_OK) {
+        return DBTOOL_FAILED;
+    }
+
+    printf(from_stdin ? "%s: password set\n" : "%s: must choose a new password on next login\n", argv[0]);
+    return DBTOOL_OK;
+}
+
+/**
+ * @brief provision <file|-> [threads]: creates the users of a roster file (see user_roster.h)
+ *
+ * Prints "username,password" for every user given a generated temporary password, so they
+ * can be handed out. Rows that are invalid or whose username or CPF is taken are reported on
+ * stderr and skipped.
+ */
+static int cmd_provision(int argc, char **argv) {
+    if (argc < 1 || argc > 2) {
+        return DBTOOL_USAGE;
+    }
+    int threads = argc == 2 ? atoi(argv[1]) : 0;
+    if (threads < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    FILE *in = strcmp(argv[0], "-") == 0 ? stdin : fopen(argv[0], "rb");
+    if (!in) {
+        perror(argv[0]);
+        return DBTOOL_FAILED;
+    }
+    struct user_roster roster = { 0 };
+    int rows = user_roster_read(&roster, in);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (rows < 0) {
+        user_roster_free(&roster);
+        return DBTOOL_FAILED;
+    }
+
+    database db;
+    if (!open_database(find_database("user"), &db)) {
+        user_roster_free(&roster);
+        return DBTOOL_FAILED;
+    }
+
+    struct roster_report report;
+    int rc = user_roster_provision(&db, &roster, threads, &report);
+    db_deinit(&db);
+
+    for (size_t i = 0; i < roster.count; i++) {
+        const struct roster_entry *entry = &roster.entries[i];
+        if (entry->status == ROSTER_CREATED && entry->generated_password) {
+            printf("%s,%s\n", entry->username, entry->password);
+        } else if (entry->status == ROSTER_USERNAME_EXISTS) {
+            fprintf(stderr, "Line %ld: username '%s' already exists.\n", entry->line, entry->username);
+        } else if (entry->status == ROSTER_CPF_EXISTS) {
+            fprintf(stderr, "Line %ld: CPF %s already exists.\n", entry->line, entry->cpf);
+        }
+    }
+    user_roster_free(&roster);
+
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Provisioning rolled back, no user was created.\n");
+        return DBTOOL_FAILED;
+    }
+    fprintf(
+        stderr,
+        "Created %d users, skipped %d invalid, %d existing usernames, %d existing CPFs.\n",
+        report.created,
+        report.invalid,
+        report.username_exists,
+        report.cpf_exists
+    );
+    return DBTOOL_OK;
+}
+
+/**
+ * @brief import-residents <file|-> [workers] [--check-duplicates]: imports a partner's resident list
+ *
+ * Invalid rows and CPFs already registered are reported on stderr and skipped. With
+ * --check-duplicates, rows that may be a registered resident under another CPF are imported and
+ * reported (see resident_import.h), at a fraction of the rows per second.
+ * The counters of every stage are printed at the end, to tell which one held the others back.
+ */
+static int cmd_import_residents(int argc, char **argv) {
+    struct resident_import_options options = { 0 };
+    if (argc > 1 && strcmp(argv[argc - 1], "--check-duplicates") == 0) {
+        options.check_duplicates = true;
+        argc--;
+    }
+    if (argc < 1 || argc > 2) {
+        return DBTOOL_USAGE;
+    }
+    options.workers = argc == 2 ? atoi(argv[1]) : 0;
+    if (options.workers < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    FILE *in = strcmp(argv[0], "-") == 0 ? stdin : fopen(argv[0], "rb");
+    if (!in) {
+        perror(argv[0]);
+        return DBTOOL_FAILED;
+    }
+    database db;
+    if (!open_database(find_database("resident"), &db)) {
+        if (in != stdin) {
+            fclose(in);
+        }
+        return DBTOOL_FAILED;
+    }
+
+    struct resident_import_stats stats;
+    int rc = resident_import(&db, in, &options, &stats);
+    db_deinit(&db);
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    double seconds = (double)stats.elapsed_ns / 1e9;
+    fprintf(
+        stderr,
+        "Imported %llu residents in %.2f s (%.0f rows/s), skipped %llu invalid and %llu already registered.\n"
+        "%llu imported residents may be registered already under another CPF.\n",
+        (unsigned long long)stats.rows_inserted,
+        seconds,
+        seconds > 0 ? (double)stats.rows_inserted / seconds : 0.0,
+        (unsigned long long)stats.rows_invalid,
+        (unsigned long long)stats.rows_duplicate,
+        (unsigned long long)stats.rows_possible_duplicate
+    );
+    fprintf(
+        stderr,
+        "reader: %llu bytes, %llu lines, %llu chunks, %.2f s busy, %llu stalls\n"
+        "parsers: %d threads, %.2f s busy, %llu batches, %llu idles, %llu stalls\n"
+        "writer: %.2f s busy, %llu commits, %llu idles\n",
+        (unsigned long long)stats.bytes,
+        (unsigned long long)stats.lines,
+        (unsigned long long)stats.chunks,
+        (double)stats.reader_ns / 1e9,
+        (unsigned long long)stats.reader_stalls,
+        stats.workers,
+        (double)stats.parser_ns / 1e9,
+        (unsigned long long)stats.batches,
+        (unsigned long long)stats.parser_idles,
+        (unsigned long long)stats.parser_stalls,
+        (double)stats.writer_ns / 1e9,
+        (unsigned long long)stats.commits,
+        (unsigned long long)stats.writer_idles
+    );
+
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Import stopped, the rows committed before the failure stay.\n");
+        return DBTOOL_FAILED;
+    }
+    return DBTOOL_OK;
+}
+
+static volatile sig_atomic_t dbtool_stop = 0; ///< Set by SIGINT and SIGTERM while serving
+
+static void dbtool_on_signal(int signal) {
+    (void)signal;
+    dbtool_stop = 1;
+}
+
+/**
+ * @brief serve [socket] [max-batch]: serves the resident, food and user databases to the
+ *        applications started with DB_SERVER=socket (see db_server.h)
+ *
+ * Runs until interrupted, then prints how many writes each commit carried.
+ */
+static int cmd_serve(int argc, char **argv) {
+    if (argc > 2) {
+        return DBTOOL_USAGE;
+    }
+    char socket_path[DBTOOL_PATH_MAX];
+    if (argc >= 1) {
+        snprintf(socket_path, sizeof(socket_path), "%s", argv[0]);
+    } else if (!join_path(socket_path, dbtool_dir, DBTOOL_SERVER_SOCKET)) {
+        return DBTOOL_FAILED;
+    }
+    struct db_server_config config = { 0 };
+    config.max_batch = argc == 2 ? atoi(argv[1]) : 0;
+    if (config.max_batch < 0) {
+        return DBTOOL_USAGE;
+    }
+
+    database resident_db, foodbatch_db, user_db;
+    bool resident_open = open_database(find_database("resident"), &resident_db);
+    bool foodbatch_open = resident_open && open_database(find_database("food"), &foodbatch_db);
+    bool user_open = foodbatch_open && open_database(find_database("user"), &user_db);
+
+    struct db_server *server = NULL;
+    if (user_open) {
+        server = db_server_start(socket_path, &resident_db, &foodbatch_db, &user_db, &config);
+    }
+    if (server) {
+        signal(SIGINT, dbtool_on_signal);
+        signal(SIGTERM, dbtool_on_signal);
+        printf("Serving on %s, DB_SERVER=%s starts the application on it. Ctrl+C stops.\n", socket_path, socket_path);
+        fflush(stdout);
+        while (!dbtool_stop) {
+            sqlite3_sleep(DBTOOL_SERVER_POLL_MS);
+        }
+
+        struct db_server_stats stats;
+        db_server_get_stats(server, &stats);
+        db_server_stop(server);
+        printf(
+            "%llu clients, %llu requests, %llu writes in %llu commits (%.1f per commit, at most %llu)\n",
+            (unsigned long long)stats.clients,
+            (unsigned long long)stats.requests,
+            (unsigned long long)stats.writes,
+            (unsigned long long)stats.commits,
+            stats.commits ? (double)stats.writes / (double)stats.commits : 0.0,
+            (unsigned long long)stats.largest_batch
+        );
+    }
+
+    if (user_open) {
+        db_deinit(&user_db);
+    }
+    if (foodbatch_open) {
+        db_deinit(&foodbatch_db);
+    }
+    if (resident_open) {
+        db_deinit(&resident_db);
+    }
+    return server ? DBTOOL_OK : DBTOOL_FAILED;
+}
+
+/* ======================= ENTRY ======================= */
+
+/**
+ * @struct dbtool_command
+ * @brief Command line command
+ */
+struct dbtool_command {
+    const char *name;                  ///< Command name
+    int (*run)(int argc, char **argv); ///< Runs the command on the arguments after its name
+    const char *usage;                 ///< Arguments, for the usage text
+};
+
+static const struct dbtool_command dbtool_commands[] = {
+    { "stats", cmd_stats, "[db...]" },
+    { "export", cmd_export, "<db> [table]" },
+    { "import", cmd_import, "<db> <file|-> [table]" },
+    { "import-residents", cmd_import_residents, "<file|-> [workers] [--check-duplicates]" },
+    { "maintain", cmd_maintain, "[db...]" },
+    { "check", cmd_check, "[db...]" },
+    { "backup", cmd_backup, "<dir> [db...]" },
+    { "reset-password", cmd_reset_password, "<username> [--stdin]" },
+    { "provision", cmd_provision, "<file|-> [threads]" },
+    { "serve", cmd_serve, "[socket] [max-batch]" },
+};
+
+#define DBTOOL_COMMAND_COUNT ((int)(sizeof(dbtool_commands) / sizeof(dbtool_commands[0])))
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-C dir] <command> [args]\n\nCommands:\n", program);
+    for (int i = 0; i < DBTOOL_COMMAND_COUNT; i++) {
+        fprintf(stderr, "  %s %s\n", dbtool_commands[i].name, dbtool_commands[i].usage);
+    }
+    fprintf(stderr, "\nDatabases:");
+    for (int i = 0; i < DBTOOL_DATABASE_COUNT; i++) {
+        fprintf(stderr, " %s", dbtool_databases[i].name);
+    }
+    fprintf(stderr, "\n\n-C dir: directory holding the database files (default: current directory)\n");
+    fprintf(stderr, "DB_PROFILE=file: write the time spent per SQL statement to file on exit\n");
+}
+
+/**
+ * @brief Tool entry point
+ *
+ * @return int Exit code from enum dbtool_exit
+ */
+int main(int argc, char **argv) {
+    const char *program = argv[0];
+    argc--;
+    argv++;
+
+    db_profile_enable_from_env();
+
+    if (argc >= 2 && strcmp(argv[0], "-C") == 0) {
+        dbtool_dir = argv[1];
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc < 1) {
+        print_usage(program);
+        return DBTOOL_USAGE;
+    }
+
+    for (int i = 0; i < DBTOOL_COMMAND_COUNT; i++) {
+        if (strcmp(argv[0], dbtool_commands[i].name) == 0) {
+            int result = dbtool_commands[i].run(argc - 1, argv + 1);
+            if (result == DBTOOL_USAGE) {
+                fprintf(stderr, "Usage: %s %s %s\n", program, dbtool_commands[i].name, dbtool_commands[i].usage);
+            }
+            return result;
+        }
+    }
+
+    fprintf(stderr, "Unknown command '%s'.\n", argv[0]);
+    print_usage(program);
+    return DBTOOL_USAGE;
+}